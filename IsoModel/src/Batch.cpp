@@ -0,0 +1,511 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Batch.hpp"
+#include "CsvWriter.hpp"
+#include "ResultFile.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char* PARTIAL_MAGIC = "# isomodel batch partial";
+const char* RESULTS_MAGIC = "# isomodel batch results";
+
+std::string resolve(const std::string& file, const std::string& baseDirectory)
+{
+  if (file.empty() || baseDirectory.empty()) {
+    return file;
+  }
+  boost::filesystem::path path(file);
+  return path.is_absolute() ? file : (boost::filesystem::path(baseDirectory) / path).string();
+}
+
+// 64 bit FNV-1a.
+void hash(uint64_t& state, const char* data, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    state = (state ^ (unsigned char) data[i]) * 1099511628211ULL;
+  }
+}
+
+void hashFile(uint64_t& state, const std::string& file)
+{
+  if (file.empty()) {
+    hash(state, "", 1);
+    return;
+  }
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if (!in) {
+    throw std::invalid_argument("Cannot open " + file + ".");
+  }
+  char buffer[65536];
+  while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+    hash(state, buffer, (size_t) in.gcount());
+  }
+  hash(state, "", 1);
+}
+
+const char* engineName(SimulationEngine engine)
+{
+  return engine == HOURLY_ENGINE ? "hourly" : "monthly";
+}
+
+std::string csvField(const std::string& text)
+{
+  if (text.find_first_of(",\"\n") == std::string::npos) {
+    return text;
+  }
+  return "\"" + boost::replace_all_copy(text, "\"", "\"\"") + "\"";
+}
+
+std::vector<std::string> splitCsv(const std::string& line)
+{
+  std::vector<std::string> fields(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        i++;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.push_back(std::string());
+    } else {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+double parseNumber(const std::string& text, const std::string& file)
+{
+  char* end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0') {
+    throw std::invalid_argument("\"" + text + "\" in " + file + " is not a number.");
+  }
+  return value;
+}
+
+// A group of buildings of one job and station, or a piece of one.
+struct Unit
+{
+  std::vector<BatchItem> items;
+  double simulationCost;
+  double cost;
+};
+
+}
+
+const double Batch::MONTHLY_COST = 1;
+const double Batch::HOURLY_COST = 250;
+const double Batch::STATION_COST = 400;
+
+BatchManifest BatchManifest::load(const std::string& manifestFile)
+{
+  std::ifstream in(manifestFile.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open batch manifest " + manifestFile + ".");
+  }
+  return parse(in, boost::filesystem::path(manifestFile).parent_path().string());
+}
+
+BatchManifest BatchManifest::parse(std::istream& in, const std::string& baseDirectory)
+{
+  BatchManifest manifest;
+  BatchJob job;
+  job.engine = MONTHLY_ENGINE;
+  int lineNumber = 0;
+  for (std::string line; std::getline(in, line);) {
+    lineNumber++;
+    line = line.substr(0, line.find('#'));
+    boost::trim(line);
+    if (line.empty()) {
+      continue;
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the batch manifest is not a \"key = value\" setting.");
+    }
+    std::string key = boost::to_lower_copy(boost::trim_copy(line.substr(0, equals)));
+    std::string value = boost::trim_copy(line.substr(equals + 1));
+    try {
+      if (key == "output") {
+        manifest.outputFile = resolve(value, baseDirectory);
+      } else if (key == "defaults") {
+        job.defaultsFile = resolve(value, baseDirectory);
+      } else if (key == "engine") {
+        job.engine = parseSimulationEngine(boost::to_lower_copy(value));
+      } else if (key == "portfolio") {
+        job.portfolioFile = resolve(value, baseDirectory);
+        manifest.jobs.push_back(job);
+      } else {
+        throw std::invalid_argument("Unknown setting \"" + key + "\".");
+      }
+    } catch (std::invalid_argument& e) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the batch manifest: " + e.what());
+    }
+  }
+  if (manifest.jobs.empty()) {
+    throw std::invalid_argument("The batch manifest has no portfolio.");
+  }
+  return manifest;
+}
+
+std::string BatchManifest::fingerprint() const
+{
+  uint64_t state = 14695981039346656037ULL;
+  for (const auto& job : jobs) {
+    hash(state, engineName(job.engine), std::strlen(engineName(job.engine)) + 1);
+    hashFile(state, job.portfolioFile);
+    hashFile(state, job.defaultsFile);
+  }
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << state;
+  return out.str();
+}
+
+ShardId ShardId::parse(const std::string& text)
+{
+  size_t slash = text.find('/');
+  char* indexEnd = nullptr;
+  char* countEnd = nullptr;
+  std::string index = text.substr(0, slash);
+  std::string count = slash == std::string::npos ? std::string() : text.substr(slash + 1);
+  unsigned long i = std::strtoul(index.c_str(), &indexEnd, 10);
+  unsigned long n = std::strtoul(count.c_str(), &countEnd, 10);
+  if (index.empty() || count.empty() || *indexEnd != '\0' || *countEnd != '\0' || i < 1 || i > n) {
+    throw std::invalid_argument("\"" + text + "\" is not a shard i/N with 1 <= i <= N.");
+  }
+  return ShardId((unsigned) i, (unsigned) n);
+}
+
+std::string ShardId::toString() const
+{
+  return std::to_string(index) + "/" + std::to_string(count);
+}
+
+Batch::Batch(const BatchManifest& manifest, unsigned threadCount) : m_manifest(manifest), m_fingerprint(manifest.fingerprint())
+{
+  for (const auto& job : manifest.jobs) {
+    std::unique_ptr<Portfolio> portfolio(new Portfolio());
+    portfolio->setThreadCount(threadCount);
+    portfolio->setLazyWeather(true);
+    portfolio->loadCsv(job.portfolioFile, job.defaultsFile);
+    m_portfolios.push_back(std::move(portfolio));
+  }
+}
+
+Batch::~Batch()
+{
+}
+
+size_t Batch::size() const
+{
+  size_t buildings = 0;
+  for (const auto& portfolio : m_portfolios) {
+    buildings += portfolio->size();
+  }
+  return buildings;
+}
+
+std::vector<std::vector<BatchItem> > Batch::plan(unsigned shardCount) const
+{
+  if (shardCount < 1) {
+    throw std::invalid_argument("A batch needs at least one shard.");
+  }
+
+  // Group the buildings by job and station.
+  std::vector<Unit> groups;
+  double totalCost = 0;
+  for (size_t job = 0; job < m_portfolios.size(); job++) {
+    const Portfolio& portfolio = *m_portfolios[job];
+    std::vector<Unit> stations(portfolio.stationCount());
+    double simulationCost = m_manifest.jobs[job].engine == HOURLY_ENGINE ? HOURLY_COST : MONTHLY_COST;
+    for (size_t building = 0; building < portfolio.size(); building++) {
+      BatchItem item = { job, building };
+      stations[portfolio.station(building)].items.push_back(item);
+    }
+    for (auto& station : stations) {
+      if (!station.items.empty()) {
+        station.simulationCost = simulationCost;
+        station.cost = STATION_COST + simulationCost * station.items.size();
+        totalCost += station.cost;
+        groups.push_back(station);
+      }
+    }
+  }
+
+  // Split the groups that cost more than a shard's share, each piece reading the weather
+  // again.
+  double share = totalCost / shardCount;
+  std::vector<Unit> units;
+  for (const auto& group : groups) {
+    size_t count = group.items.size();
+    size_t pieces = 1;
+    if (shardCount > 1) {
+      pieces = (size_t) std::ceil(group.cost / share - 1e-9);
+      pieces = std::max<size_t>(1, std::min(pieces, count));
+    }
+    for (size_t piece = 0; piece < pieces; piece++) {
+      Unit unit;
+      unit.items.assign(group.items.begin() + count * piece / pieces, group.items.begin() + count * (piece + 1) / pieces);
+      unit.simulationCost = group.simulationCost;
+      unit.cost = STATION_COST + group.simulationCost * unit.items.size();
+      units.push_back(unit);
+    }
+  }
+
+  // Longest processing time first; ties keep the job and station order.
+  std::stable_sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) { return a.cost > b.cost; });
+  std::vector<std::vector<BatchItem> > shards(shardCount);
+  std::vector<double> loads(shardCount, 0);
+  for (const auto& unit : units) {
+    size_t lightest = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    loads[lightest] += unit.cost;
+    shards[lightest].insert(shards[lightest].end(), unit.items.begin(), unit.items.end());
+  }
+  for (auto& items : shards) {
+    std::sort(items.begin(), items.end(), [](const BatchItem& a, const BatchItem& b) {
+      return a.job != b.job ? a.job < b.job : a.building < b.building;
+    });
+  }
+  return shards;
+}
+
+std::vector<BatchItem> Batch::shard(const ShardId& shard) const
+{
+  return plan(shard.count)[shard.index - 1];
+}
+
+double Batch::cost(const std::vector<BatchItem>& items) const
+{
+  std::map<std::pair<size_t, size_t>, bool> stations;
+  double cost = 0;
+  for (const auto& item : items) {
+    cost += m_manifest.jobs[item.job].engine == HOURLY_ENGINE ? HOURLY_COST : MONTHLY_COST;
+    stations[std::make_pair(item.job, m_portfolios[item.job]->station(item.building))] = true;
+  }
+  return cost + STATION_COST * stations.size();
+}
+
+size_t Batch::run(ThreadPool& pool, const ShardId& shard, std::ostream& out) const
+{
+  auto start = std::chrono::steady_clock::now();
+  std::vector<BatchItem> items = this->shard(shard);
+  std::vector<std::vector<EndUses> > results(items.size());
+  std::vector<double> floorAreas(items.size());
+  pool.parallelFor(items.size(), [&](size_t i) {
+    UserModel model = m_portfolios[items[i].job]->model(items[i].building);
+    floorAreas[i] = model.floorArea();
+    results[i] = simulateByMonth(model, m_manifest.jobs[items[i].job].engine);
+  });
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  out << PARTIAL_MAGIC << "\n";
+  out << "# fingerprint = " << m_fingerprint << "\n";
+  out << "# shard = " << shard.toString() << "\n";
+  out << "# buildings = " << items.size() << "\n";
+  out << "# cost = " << cost(items) << "\n";
+  out << "# seconds = " << seconds << "\n";
+  out << "job,row,id,engine,floorArea,month";
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    out << "," << endUseName(endUse);
+  }
+  out << "\n" << std::setprecision(10);
+  for (size_t i = 0; i < items.size(); i++) {
+    const BatchItem& item = items[i];
+    std::string prefix = std::to_string(item.job + 1) + "," + std::to_string(item.building + 1) + "," +
+                         csvField(m_portfolios[item.job]->id(item.building)) + "," + engineName(m_manifest.jobs[item.job].engine);
+    for (size_t month = 0; month < results[i].size(); month++) {
+      out << prefix << "," << floorAreas[i] << "," << month + 1;
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        out << "," << endUseValue(results[i][month], endUse);
+      }
+      out << "\n";
+    }
+  }
+  return items.size();
+}
+
+size_t Batch::run(ThreadPool& pool, const ShardId& shard, ResultFileWriter& out) const
+{
+  if (out.periods() != 8760) {
+    throw std::invalid_argument("Hourly batch results need a result file of 8760 periods.");
+  }
+  std::vector<BatchItem> items = this->shard(shard);
+  pool.parallelFor(items.size(), [&](size_t i) {
+    UserModel model = m_portfolios[items[i].job]->model(items[i].building);
+    char floorArea[CsvWriter::MAX_DOUBLE_LENGTH];
+    ResultFileBuilding building;
+    building.id = m_portfolios[items[i].job]->id(items[i].building);
+    building.metadata["job"] = std::to_string(items[i].job + 1);
+    building.metadata["row"] = std::to_string(items[i].building + 1);
+    building.metadata["floorArea"] = std::string(floorArea, CsvWriter::formatDouble(model.floorArea(), CsvWriter::SHORTEST, floorArea));
+    out.append(building, model.toHourlyModel().simulate(false));
+  });
+  return items.size();
+}
+
+BatchSummary mergeBatchPartials(const std::vector<std::string>& partialFiles, std::ostream& out)
+{
+  struct Row
+  {
+    long job;
+    long building;
+    long month;
+    std::string text;
+  };
+
+  std::string fingerprint;
+  std::string header;
+  unsigned shardCount = 0;
+  std::map<unsigned, std::string> shardLines;
+  std::vector<Row> rows;
+  BatchSummary summary;
+  summary.buildings = 0;
+  summary.maxShardSeconds = 0;
+  summary.totalSeconds = 0;
+  summary.totals.assign(END_USE_COUNT, 0);
+  std::map<std::pair<long, long>, double> annual;
+
+  for (const auto& file : partialFiles) {
+    std::ifstream in(file.c_str());
+    if (!in) {
+      throw std::invalid_argument("Cannot open partial result file " + file + ".");
+    }
+    std::string line;
+    if (!std::getline(in, line) || boost::trim_copy(line) != PARTIAL_MAGIC) {
+      throw std::invalid_argument(file + " is not a partial batch result file.");
+    }
+    std::map<std::string, std::string> settings;
+    while (std::getline(in, line) && boost::starts_with(line, "#")) {
+      size_t equals = line.find('=');
+      if (equals != std::string::npos) {
+        settings[boost::trim_copy(line.substr(1, equals - 1))] = boost::trim_copy(line.substr(equals + 1));
+      }
+    }
+    ShardId shard = ShardId::parse(settings["shard"]);
+    if (fingerprint.empty()) {
+      fingerprint = settings["fingerprint"];
+      shardCount = shard.count;
+      header = line;
+    } else if (settings["fingerprint"] != fingerprint) {
+      throw std::invalid_argument(file + " comes from a different batch (fingerprint " + settings["fingerprint"] + ", expected " +
+                                  fingerprint + ").");
+    } else if (shard.count != shardCount) {
+      throw std::invalid_argument(file + " is shard " + shard.toString() + " of a batch of " + std::to_string(shardCount) + " shards.");
+    } else if (line != header) {
+      throw std::invalid_argument(file + " has different columns.");
+    }
+    if (shardLines.count(shard.index)) {
+      throw std::invalid_argument("Shard " + shard.toString() + " is in " + file + " and another file.");
+    }
+    double seconds = parseNumber(settings["seconds"], file);
+    shardLines[shard.index] = "# shard " + shard.toString() + " = " + settings["buildings"] + " buildings, cost " + settings["cost"] +
+                              ", " + settings["seconds"] + " s";
+    summary.buildings += (size_t) parseNumber(settings["buildings"], file);
+    summary.maxShardSeconds = std::max(summary.maxShardSeconds, seconds);
+    summary.totalSeconds += seconds;
+
+    while (std::getline(in, line)) {
+      if (line.empty()) {
+        continue;
+      }
+      std::vector<std::string> fields = splitCsv(line);
+      if (fields.size() != 6 + END_USE_COUNT) {
+        throw std::invalid_argument("Bad row in " + file + ": " + line);
+      }
+      Row row = { (long) parseNumber(fields[0], file), (long) parseNumber(fields[1], file), (long) parseNumber(fields[5], file), line };
+      double floorArea = parseNumber(fields[4], file);
+      double& buildingAnnual = annual[std::make_pair(row.job, row.building)];
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        double value = parseNumber(fields[6 + endUse], file);
+        summary.totals[endUse] += value * floorArea;
+        buildingAnnual += value;
+      }
+      rows.push_back(row);
+    }
+  }
+
+  if (partialFiles.empty()) {
+    throw std::invalid_argument("There are no partial result files to merge.");
+  }
+  std::string missing;
+  for (unsigned index = 1; index <= shardCount; index++) {
+    if (!shardLines.count(index)) {
+      missing += (missing.empty() ? "" : ", ") + std::to_string(index);
+    }
+  }
+  if (!missing.empty()) {
+    throw std::invalid_argument("Shards " + missing + " of " + std::to_string(shardCount) + " are missing.");
+  }
+  summary.shards = shardCount;
+  for (const auto& building : annual) {
+    summary.eui.add(building.second);
+  }
+  std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+    return a.job != b.job ? a.job < b.job : a.building != b.building ? a.building < b.building : a.month < b.month;
+  });
+
+  out << RESULTS_MAGIC << "\n";
+  out << "# fingerprint = " << fingerprint << "\n";
+  out << "# shards = " << shardCount << "\n";
+  for (const auto& shardLine : shardLines) {
+    out << shardLine.second << "\n";
+  }
+  out << "# buildings = " << summary.buildings << "\n" << std::setprecision(10);
+  out << "# seconds = " << summary.maxShardSeconds << " (longest shard), " << summary.totalSeconds << " (total)\n";
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    out << "# total " << endUseName(endUse) << " = " << summary.totals[endUse] << " kWh\n";
+  }
+  out << "# eui = " << summary.eui.mean() << " mean, " << summary.eui.standardDeviation() << " standard deviation, "
+      << summary.eui.min() << " min, " << summary.eui.max() << " max kWh/m2\n";
+  out << header << "\n";
+  for (const auto& row : rows) {
+    out << row.text << "\n";
+  }
+  return summary;
+}
+
+}
+}
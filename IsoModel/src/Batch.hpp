@@ -0,0 +1,216 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_BATCH_HPP
+#define ISOMODEL_BATCH_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Portfolio.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class ResultFileWriter;
+
+/**
+ * One portfolio of a batch: a portfolio CSV file, its defaults .ism file and the
+ * simulation method of its buildings.
+ */
+struct ISOMODEL_API BatchJob
+{
+  std::string portfolioFile;
+  std::string defaultsFile;
+  SimulationEngine engine;
+};
+
+/**
+ * Description of a batch run over one or more portfolios (see Portfolio). A manifest
+ * file holds one "key = value" setting per line; # starts a comment. For example
+ *
+ * output = nightly.csv<br>
+ * defaults = office_defaults.ism<br>
+ * engine = hourly<br>
+ * portfolio = offices.csv<br>
+ * engine = monthly<br>
+ * portfolio = schools.csv
+ *
+ * Each portfolio line adds a job that uses the defaults and engine (monthly, the
+ * default, or hourly) set above it. output is the result file of the whole batch; shards
+ * write to it with a ".shard-i-of-N" suffix. All paths are relative to the manifest.
+ */
+struct ISOMODEL_API BatchManifest
+{
+  std::string outputFile;
+  std::vector<BatchJob> jobs;
+
+  /**
+   * Reads a manifest file. Throws std::invalid_argument naming the line of a bad setting.
+   */
+  static BatchManifest load(const std::string& manifestFile);
+
+  /**
+   * Reads a manifest from in. Relative paths are resolved against baseDirectory.
+   */
+  static BatchManifest parse(std::istream& in, const std::string& baseDirectory = std::string());
+
+  /**
+   * A hash of the engines and of the contents of the portfolio and defaults files, which
+   * identifies the inputs of the batch: partial results with different fingerprints
+   * cannot be merged.
+   */
+  std::string fingerprint() const;
+};
+
+/**
+ * Shard index of count (from 1), as written "i/N".
+ */
+struct ISOMODEL_API ShardId
+{
+  unsigned index;
+  unsigned count;
+
+  ShardId(unsigned index = 1, unsigned count = 1) : index(index), count(count)
+  {
+  }
+
+  /**
+   * Parses "i/N" with 1 <= i <= N. Throws std::invalid_argument otherwise.
+   */
+  static ShardId parse(const std::string& text);
+
+  std::string toString() const;
+};
+
+/**
+ * A building of a batch: its job and its row in the job's portfolio.
+ */
+struct ISOMODEL_API BatchItem
+{
+  size_t job;
+  size_t building;
+};
+
+/**
+ * The portfolios of a manifest, divided into shards that separate processes or machines
+ * can run independently.
+ *
+ * The division only depends on the inputs, so that every process computes the same one.
+ * The buildings of a job that share a weather station are kept together, so that each
+ * weather file is read by as few shards as possible, and are balanced by their estimated
+ * cost: the cost of reading the weather plus that of each simulation, an hourly
+ * simulation costing HOURLY_COST monthly ones. Groups costing more than a shard's share
+ * are split into even pieces. The pieces are then assigned, most costly first, to the
+ * shard with the least cost so far (longest processing time first scheduling).
+ *
+ * Weather files are only read by the shards that simulate their buildings.
+ */
+class ISOMODEL_API Batch
+{
+public:
+  // Estimated costs, in monthly simulations.
+  static const double MONTHLY_COST;
+  static const double HOURLY_COST;
+  static const double STATION_COST;
+
+  /**
+   * Loads the portfolios of manifest, parsing each with threadCount threads (0 for one per
+   * hardware thread). Throws std::invalid_argument if a portfolio cannot be loaded.
+   */
+  explicit Batch(const BatchManifest& manifest, unsigned threadCount = 0);
+  ~Batch();
+
+  /**
+   * Number of buildings over every job.
+   */
+  size_t size() const;
+
+  /**
+   * The buildings of each of shardCount shards, by job then row.
+   */
+  std::vector<std::vector<BatchItem> > plan(unsigned shardCount) const;
+
+  /**
+   * The buildings of one shard, by job then row.
+   */
+  std::vector<BatchItem> shard(const ShardId& shard) const;
+
+  /**
+   * The estimated cost of simulating items, in monthly simulations.
+   */
+  double cost(const std::vector<BatchItem>& items) const;
+
+  /**
+   * Simulates the buildings of shard on pool and writes them as a partial result file: a
+   * CSV file with a row per building and month, preceded by # comment lines naming the
+   * manifest fingerprint, the shard and its cost, building count and run time. Returns
+   * the number of buildings simulated.
+   */
+  size_t run(ThreadPool& pool, const ShardId& shard, std::ostream& out) const;
+
+  /**
+   * Simulates the buildings of shard on pool with the hourly method and appends their
+   * hour by hour results to out (of 8760 periods) as they finish, with the job, row and
+   * floor area of each building as its metadata. Returns the number of buildings
+   * simulated.
+   */
+  size_t run(ThreadPool& pool, const ShardId& shard, ResultFileWriter& out) const;
+
+private:
+  Batch(const Batch&);
+  Batch& operator=(const Batch&);
+
+  BatchManifest m_manifest;
+  std::string m_fingerprint;
+  std::vector<std::unique_ptr<Portfolio> > m_portfolios;
+};
+
+/**
+ * Statistics of a merged batch.
+ */
+struct ISOMODEL_API BatchSummary
+{
+  size_t shards;
+  size_t buildings;
+  // Longest and total run time of the shards.
+  double maxShardSeconds;
+  double totalSeconds;
+  // Energy of every building per end use (EndUses order), in kWh.
+  std::vector<double> totals;
+  // Annual energy use intensity of the buildings, in kWh/m2.
+  RunningStats eui;
+};
+
+/**
+ * Combines the partial result files of every shard of a batch into one result file on
+ * out, with rows by job, building and month, preceded by # comment lines with the
+ * statistics of the batch. Throws std::invalid_argument if the files come from different
+ * batches or a shard is missing or repeated.
+ */
+ISOMODEL_API BatchSummary mergeBatchPartials(const std::vector<std::string>& partialFiles, std::ostream& out);
+
+}
+}
+#endif
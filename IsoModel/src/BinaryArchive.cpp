@@ -0,0 +1,388 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+
+#include "BinaryArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// On little endian hosts arrays of doubles are copied as a block rather than value by value.
+bool hostIsLittleEndian()
+{
+  const uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+const bool LITTLE_ENDIAN_HOST = hostIsLittleEndian();
+
+uint64_t rotateLeft(uint64_t x, int bits)
+{
+  return (x << bits) | (x >> (64 - bits));
+}
+
+uint64_t littleEndian64(const unsigned char* bytes, size_t count)
+{
+  uint64_t value = 0;
+  if (LITTLE_ENDIAN_HOST) {
+    std::memcpy(&value, bytes, count);
+    return value;
+  }
+  for (size_t i = 0; i < count; i++) {
+    value |= (uint64_t) bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+uint64_t finalMix(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+}
+
+ContentHash ContentHash::of(const char* data, size_t size)
+{
+  const uint64_t c1 = 0x87c37b91114253d5ULL;
+  const uint64_t c2 = 0x4cf5ad432745937fULL;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  size_t blocks = size / 16;
+  for (size_t i = 0; i < blocks; i++) {
+    uint64_t k1 = littleEndian64(bytes + 16 * i, 8);
+    uint64_t k2 = littleEndian64(bytes + 16 * i + 8, 8);
+    k1 *= c1;
+    k1 = rotateLeft(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = rotateLeft(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+    k2 *= c2;
+    k2 = rotateLeft(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = rotateLeft(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+  const unsigned char* tail = bytes + 16 * blocks;
+  size_t remaining = size & 15;
+  if (remaining > 8) {
+    uint64_t k2 = littleEndian64(tail + 8, remaining - 8);
+    k2 *= c2;
+    k2 = rotateLeft(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+  }
+  if (remaining > 0) {
+    uint64_t k1 = littleEndian64(tail, std::min<size_t>(remaining, 8));
+    k1 *= c1;
+    k1 = rotateLeft(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = finalMix(h1);
+  h2 = finalMix(h2);
+  h1 += h2;
+  h2 += h1;
+  ContentHash hash = { h1, h2 };
+  return hash;
+}
+
+std::string ContentHash::toString() const
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string text(32, '0');
+  for (int i = 0; i < 16; i++) {
+    text[15 - i] = digits[(high >> (4 * i)) & 15];
+    text[31 - i] = digits[(low >> (4 * i)) & 15];
+  }
+  return text;
+}
+
+void BinaryWriter::u8(uint8_t value)
+{
+  m_data += static_cast<char>(value);
+}
+
+void BinaryWriter::u32(uint32_t value)
+{
+  char encoded[4];
+  for (int i = 0; i < 4; i++) {
+    encoded[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+  m_data.append(encoded, 4);
+}
+
+void BinaryWriter::u64(uint64_t value)
+{
+  char encoded[8];
+  for (int i = 0; i < 8; i++) {
+    encoded[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+  m_data.append(encoded, 8);
+}
+
+void BinaryWriter::number(double value)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  u64(bits);
+}
+
+void BinaryWriter::numbers(const double* values, size_t count)
+{
+  if (LITTLE_ENDIAN_HOST) {
+    bytes(reinterpret_cast<const char*>(values), count * sizeof(double));
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    number(values[i]);
+  }
+}
+
+void BinaryWriter::bytes(const char* data, size_t count)
+{
+  m_data.append(data, count);
+}
+
+void BinaryWriter::text(const std::string& value)
+{
+  u32(static_cast<uint32_t>(value.size()));
+  m_data += value;
+}
+
+BinaryWriter& BinaryWriter::operator&(const uint16_t& value)
+{
+  m_data += static_cast<char>(value & 0xff);
+  m_data += static_cast<char>(value >> 8);
+  return *this;
+}
+
+BinaryWriter& BinaryWriter::operator&(const Vector& value)
+{
+  u64(value.size());
+  for (size_t i = 0; i < value.size(); i++) {
+    number(value[i]);
+  }
+  return *this;
+}
+
+BinaryWriter& BinaryWriter::operator&(const Matrix& value)
+{
+  u64(value.size1());
+  u64(value.size2());
+  for (size_t r = 0; r < value.size1(); r++) {
+    for (size_t c = 0; c < value.size2(); c++) {
+      number(value(r, c));
+    }
+  }
+  return *this;
+}
+
+BinaryWriter& BinaryWriter::operator&(const std::vector<double>& value)
+{
+  u64(value.size());
+  numbers(value.data(), value.size());
+  return *this;
+}
+
+BinaryWriter& BinaryWriter::operator&(const std::vector<uint16_t>& value)
+{
+  u64(value.size());
+  if (LITTLE_ENDIAN_HOST) {
+    bytes(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(uint16_t));
+    return *this;
+  }
+  for (uint16_t item : value) {
+    *this & item;
+  }
+  return *this;
+}
+
+void BinaryWriter::save(const std::string& file, const std::string& description) const
+{
+  std::ofstream out(file.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!out.is_open()) {
+    throw std::invalid_argument("Error opening " + description + " file '" + file + "' for writing.");
+  }
+  out.write(m_data.data(), m_data.size());
+}
+
+BinaryReader::BinaryReader(const std::string& data, const std::string& description) :
+    m_data(data), m_description(description), m_pos(0)
+{
+}
+
+const char* BinaryReader::take(size_t count)
+{
+  if (count > m_data.size() - m_pos) {
+    throw std::invalid_argument(m_description + " is truncated.");
+  }
+  const char* p = m_data.data() + m_pos;
+  m_pos += count;
+  return p;
+}
+
+uint8_t BinaryReader::u8()
+{
+  return static_cast<uint8_t>(*take(1));
+}
+
+uint32_t BinaryReader::u32()
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(take(4));
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value |= static_cast<uint32_t>(p[i]) << (8 * i);
+  }
+  return value;
+}
+
+uint64_t BinaryReader::u64()
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(take(8));
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value |= static_cast<uint64_t>(p[i]) << (8 * i);
+  }
+  return value;
+}
+
+double BinaryReader::number()
+{
+  uint64_t bits = u64();
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void BinaryReader::numbers(double* values, size_t count)
+{
+  if (LITTLE_ENDIAN_HOST) {
+    std::memcpy(values, take(count * sizeof(double)), count * sizeof(double));
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    values[i] = number();
+  }
+}
+
+std::string BinaryReader::text()
+{
+  uint32_t length = u32();
+  return std::string(take(length), length);
+}
+
+size_t BinaryReader::count(size_t elementSize)
+{
+  uint64_t n = u64();
+  if (n > (m_data.size() - m_pos) / elementSize) {
+    throw std::invalid_argument(m_description + " is truncated.");
+  }
+  return static_cast<size_t>(n);
+}
+
+BinaryReader& BinaryReader::operator&(uint16_t& value)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(take(2));
+  value = static_cast<uint16_t>(p[0] | (p[1] << 8));
+  return *this;
+}
+
+BinaryReader& BinaryReader::operator&(Vector& value)
+{
+  size_t n = count(8);
+  value.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    value[i] = number();
+  }
+  return *this;
+}
+
+BinaryReader& BinaryReader::operator&(Matrix& value)
+{
+  size_t rows = static_cast<size_t>(u64());
+  size_t cols = count(1);
+  if (cols > 0 && rows > (m_data.size() - m_pos) / 8 / cols) {
+    throw std::invalid_argument(m_description + " is truncated.");
+  }
+  value.resize(rows, cols, false);
+  for (size_t r = 0; r < rows; r++) {
+    for (size_t c = 0; c < cols; c++) {
+      value(r, c) = number();
+    }
+  }
+  return *this;
+}
+
+BinaryReader& BinaryReader::operator&(std::vector<double>& value)
+{
+  value.resize(count(sizeof(double)));
+  numbers(value.data(), value.size());
+  return *this;
+}
+
+BinaryReader& BinaryReader::operator&(std::vector<uint16_t>& value)
+{
+  value.resize(count(sizeof(uint16_t)));
+  if (LITTLE_ENDIAN_HOST) {
+    std::memcpy(value.data(), take(value.size() * sizeof(uint16_t)), value.size() * sizeof(uint16_t));
+    return *this;
+  }
+  for (auto& item : value) {
+    *this & item;
+  }
+  return *this;
+}
+
+std::string BinaryReader::load(const std::string& file, const std::string& description)
+{
+  std::ifstream in(file.c_str(), std::ios_base::in | std::ios_base::binary);
+  if (!in.is_open()) {
+    throw std::invalid_argument("Error opening " + description + " file '" + file + "'");
+  }
+  in.seekg(0, std::ios_base::end);
+  std::string data(static_cast<size_t>(in.tellg()), '\0');
+  in.seekg(0, std::ios_base::beg);
+  in.read(&data[0], data.size());
+  return data;
+}
+
+}
+}
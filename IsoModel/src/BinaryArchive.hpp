@@ -0,0 +1,231 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_BINARY_ARCHIVE_HPP
+#define ISOMODEL_BINARY_ARCHIVE_HPP
+
+#include "ISOModelAPI.hpp"
+
+#ifdef ISOMODEL_STANDALONE
+#include "Vector.hpp"
+#include "Matrix.hpp"
+#else
+#include "../utilities/data/Vector.hpp"
+#include "../utilities/data/Matrix.hpp"
+#endif
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A 128 bit hash of a byte string (MurmurHash3 x64 128 with the bytes read little endian,
+ * so the same bytes hash the same on any host). Used to address content, such as cached
+ * results, by the serialized inputs that determine it. It is not a cryptographic hash:
+ * collisions are only unlikely between inputs that differ by accident.
+ */
+struct ISOMODEL_API ContentHash
+{
+  uint64_t high;
+  uint64_t low;
+
+  static ContentHash of(const char* data, size_t size);
+
+  /**
+   * 32 lower case hex digits.
+   */
+  std::string toString() const;
+
+  bool operator==(const ContentHash& other) const {
+    return high == other.high && low == other.low;
+  }
+
+  bool operator!=(const ContentHash& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const ContentHash& other) const {
+    return high < other.high || (high == other.high && low < other.low);
+  }
+};
+
+/**
+ * Writes values into a byte buffer in a host independent little endian encoding.
+ * Integers are written with a fixed width and doubles as their IEEE 754 bit pattern,
+ * so a buffer written on one machine reads back identically on any other.
+ *
+ * Classes written to an archive provide a member template
+ *   template<class Archive> void serialize(Archive& ar) { ar & m_a & m_b; }
+ * that is used with both BinaryWriter and BinaryReader, so the read and write order
+ * cannot drift apart.
+ */
+class ISOMODEL_API BinaryWriter
+{
+public:
+  void u8(uint8_t value);
+  void u32(uint32_t value);
+  void u64(uint64_t value);
+  void number(double value);
+  void numbers(const double* values, size_t count);
+  void bytes(const char* data, size_t count);
+
+  /**
+   * A u32 length followed by the bytes of the string.
+   */
+  void text(const std::string& value);
+
+  BinaryWriter& operator&(const double& value) {
+    number(value);
+    return *this;
+  }
+
+  BinaryWriter& operator&(const int& value) {
+    u32(static_cast<uint32_t>(value));
+    return *this;
+  }
+
+  BinaryWriter& operator&(const bool& value) {
+    u8(value ? 1 : 0);
+    return *this;
+  }
+
+  BinaryWriter& operator&(const uint16_t& value);
+
+  BinaryWriter& operator&(const std::string& value) {
+    text(value);
+    return *this;
+  }
+
+  BinaryWriter& operator&(const Vector& value);
+  BinaryWriter& operator&(const Matrix& value);
+  BinaryWriter& operator&(const std::vector<double>& value);
+  BinaryWriter& operator&(const std::vector<uint16_t>& value);
+
+  template<class T>
+  BinaryWriter& operator&(const std::vector<std::vector<T> >& value) {
+    u64(value.size());
+    for (auto& item : value) {
+      *this & item;
+    }
+    return *this;
+  }
+
+  const std::string& data() const {
+    return m_data;
+  }
+
+  ContentHash hash() const {
+    return ContentHash::of(m_data.data(), m_data.size());
+  }
+
+  /**
+   * Writes the buffer to file. description names the file in error messages,
+   * e.g. "snapshot".
+   */
+  void save(const std::string& file, const std::string& description) const;
+
+private:
+  std::string m_data;
+};
+
+/**
+ * Reads values written by a BinaryWriter. Every read is bounds checked and throws
+ * std::invalid_argument if the data is truncated.
+ */
+class ISOMODEL_API BinaryReader
+{
+public:
+  /**
+   * data must outlive the reader. description names the data in error messages,
+   * e.g. "Snapshot file 'model.snap'".
+   */
+  BinaryReader(const std::string& data, const std::string& description);
+
+  const char* take(size_t count);
+  uint8_t u8();
+  uint32_t u32();
+  uint64_t u64();
+  double number();
+  void numbers(double* values, size_t count);
+  std::string text();
+
+  size_t position() const {
+    return m_pos;
+  }
+
+  void seek(size_t pos) {
+    m_pos = pos;
+  }
+
+  BinaryReader& operator&(double& value) {
+    value = number();
+    return *this;
+  }
+
+  BinaryReader& operator&(int& value) {
+    value = static_cast<int>(u32());
+    return *this;
+  }
+
+  BinaryReader& operator&(bool& value) {
+    value = u8() != 0;
+    return *this;
+  }
+
+  BinaryReader& operator&(uint16_t& value);
+
+  BinaryReader& operator&(std::string& value) {
+    value = text();
+    return *this;
+  }
+
+  BinaryReader& operator&(Vector& value);
+  BinaryReader& operator&(Matrix& value);
+  BinaryReader& operator&(std::vector<double>& value);
+  BinaryReader& operator&(std::vector<uint16_t>& value);
+
+  template<class T>
+  BinaryReader& operator&(std::vector<std::vector<T> >& value) {
+    value.resize(count(8));
+    for (auto& item : value) {
+      *this & item;
+    }
+    return *this;
+  }
+
+  /**
+   * Reads the whole of file into a string. description names the file in error
+   * messages, e.g. "snapshot".
+   */
+  static std::string load(const std::string& file, const std::string& description);
+
+private:
+  // Reads an element count and checks that at least count * elementSize bytes remain.
+  size_t count(size_t elementSize);
+
+  const std::string& m_data;
+  std::string m_description;
+  size_t m_pos;
+};
+
+}
+}
+#endif
@@ -4,6 +4,11 @@ namespace openstudio {
 namespace isomodel {
 
 Building::Building(void)
+    : m_lightingOccupancySensor(0), m_constantIllumination(0), m_electricApplianceHeatGainOccupied(0),
+      m_electricApplianceHeatGainUnoccupied(0), m_gasApplianceHeatGainOccupied(0), m_gasApplianceHeatGainUnoccupied(0),
+      m_buildingEnergyManagement(0), m_electricAppliancePowerFixedOccupied(0),
+      m_electricAppliancePowerFixedUnoccupied(0), m_gasAppliancePowerFixedOccupied(0),
+      m_gasAppliancePowerFixedUnoccupied(0)
 {
 }
 
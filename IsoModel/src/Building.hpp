@@ -174,6 +174,16 @@ public:
     m_gasAppliancePowerFixedUnoccupied = gasAppliancePowerFixedUnoccupied;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_lightingOccupancySensor & m_constantIllumination & m_electricApplianceHeatGainOccupied
+        & m_electricApplianceHeatGainUnoccupied & m_gasApplianceHeatGainOccupied
+        & m_gasApplianceHeatGainUnoccupied & m_buildingEnergyManagement & m_externalEquipment
+        & m_electricAppliancePowerFixedOccupied & m_electricAppliancePowerFixedUnoccupied
+        & m_gasAppliancePowerFixedOccupied & m_gasAppliancePowerFixedUnoccupied;
+  }
+
 private:
   double m_lightingOccupancySensor;
   double m_constantIllumination;
@@ -0,0 +1,281 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Calibration.hpp"
+#include "Optimizer.hpp"
+#include "SimulationPlan.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// End uses 0 to 8 are electricity, the others gas.
+const int FIRST_GAS_END_USE = 9;
+
+}
+
+MeteredData MeteredData::load(const std::string& file)
+{
+  std::ifstream in(file.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open metered data " + file + ".");
+  }
+  return parse(in);
+}
+
+MeteredData MeteredData::parse(std::istream& in)
+{
+  std::string line;
+  if (!std::getline(in, line)) {
+    throw std::invalid_argument("The metered data is empty.");
+  }
+  std::vector<std::string> header;
+  boost::split(header, line, boost::is_any_of(","));
+  int electricityColumn = -1;
+  int gasColumn = -1;
+  for (size_t c = 0; c < header.size(); c++) {
+    std::string name = boost::to_lower_copy(boost::trim_copy(header[c]));
+    if (name == "electricity") {
+      electricityColumn = (int) c;
+    } else if (name == "gas") {
+      gasColumn = (int) c;
+    }
+  }
+  if (electricityColumn < 0 && gasColumn < 0) {
+    throw std::invalid_argument("The metered data has neither an electricity nor a gas column.");
+  }
+
+  MeteredData data;
+  int lineNumber = 1;
+  std::vector<std::string> cells;
+  while (std::getline(in, line)) {
+    lineNumber++;
+    if (boost::trim_copy(line).empty()) {
+      continue;
+    }
+    boost::split(cells, line, boost::is_any_of(","));
+    int columns[] = { electricityColumn, gasColumn };
+    std::vector<double>* series[] = { &data.electricity, &data.gas };
+    for (int fuel = 0; fuel < 2; fuel++) {
+      if (columns[fuel] < 0) {
+        continue;
+      }
+      std::string cell = (size_t) columns[fuel] < cells.size() ? boost::trim_copy(cells[columns[fuel]]) : std::string();
+      double value = std::numeric_limits<double>::quiet_NaN();
+      if (!cell.empty()) {
+        char* end = nullptr;
+        value = std::strtod(cell.c_str(), &end);
+        if (*end != '\0') {
+          throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the metered data: \"" + cell + "\" is not a number.");
+        }
+      }
+      series[fuel]->push_back(value);
+    }
+  }
+  if (data.periods() != 12 && data.periods() != 8760) {
+    throw std::invalid_argument("The metered data has " + std::to_string(data.periods()) + " rows, expected 12 months or 8760 hours.");
+  }
+  return data;
+}
+
+bool FitStatistics::compliant(bool hourly) const
+{
+  return cvrmse <= (hourly ? 30 : 15) && std::abs(nmbe) <= (hourly ? 10 : 5);
+}
+
+FitStatistics fitStatistics(const std::vector<double>& measured, const std::vector<double>& simulated, size_t parameterCount)
+{
+  if (measured.size() != simulated.size()) {
+    throw std::invalid_argument("The measured and simulated series differ in length.");
+  }
+  size_t count = 0;
+  double measuredSum = 0;
+  double errorSum = 0;
+  double squaredErrorSum = 0;
+  for (size_t i = 0; i < measured.size(); i++) {
+    if (std::isnan(measured[i])) {
+      continue;
+    }
+    double error = measured[i] - simulated[i];
+    count++;
+    measuredSum += measured[i];
+    errorSum += error;
+    squaredErrorSum += error * error;
+  }
+  if (count <= parameterCount || measuredSum == 0) {
+    throw std::invalid_argument("There are too few measurements, or their mean is 0.");
+  }
+  double mean = measuredSum / count;
+  double degreesOfFreedom = (double) (count - parameterCount);
+  FitStatistics statistics;
+  statistics.cvrmse = 100 * std::sqrt(squaredErrorSum / degreesOfFreedom) / mean;
+  statistics.nmbe = 100 * errorSum / (degreesOfFreedom * mean);
+  statistics.points = count;
+  return statistics;
+}
+
+Calibration::Calibration(const UserModel& base, const SweepSpec& spec, const MeteredData& metered)
+  : m_base(base), m_engine(spec.engine), m_population(spec.population), m_generations(spec.generations), m_seed(spec.seed),
+    m_metered(metered)
+{
+  if (metered.hourly() && m_engine != HOURLY_ENGINE) {
+    throw std::invalid_argument("Hourly metered data needs the hourly engine.");
+  }
+  std::vector<std::string> names;
+  for (const auto& parameter : spec.parameters) {
+    const Distribution& distribution = parameter.distribution;
+    if (distribution.type != Distribution::UNIFORM && distribution.type != Distribution::TRIANGULAR) {
+      throw std::invalid_argument("Calibration parameter " + parameter.name + " needs a range (a uniform or triangular distribution).");
+    }
+    names.push_back(parameter.name);
+    m_low.push_back(distribution.quantile(0));
+    m_high.push_back(distribution.quantile(1));
+  }
+  if (names.empty()) {
+    throw std::invalid_argument("A calibration needs at least one parameter.");
+  }
+  m_binding = ParameterBinding(names);
+  // Rejects unusable metered series before any optimization.
+  std::vector<double> zeros(metered.periods(), 0.0);
+  if (!metered.electricity.empty()) {
+    fitStatistics(metered.electricity, zeros);
+  }
+  if (!metered.gas.empty()) {
+    fitStatistics(metered.gas, zeros);
+  }
+}
+
+void Calibration::simulate(const double* parameters, bool hourly, std::vector<double>& electricity, std::vector<double>& gas) const
+{
+  if (hourly && m_engine != HOURLY_ENGINE) {
+    throw std::invalid_argument("Hourly results need the hourly engine.");
+  }
+  UserModel model = m_binding.bind(m_base, parameters);
+  auto plan = model.compile();
+  std::vector<EndUses> results;
+  if (m_engine == HOURLY_ENGINE) {
+    results = plan->simulateHourly(!hourly);
+  } else {
+    results = plan->simulateMonthly();
+  }
+  double area = model.floorArea();
+  electricity.assign(results.size(), 0.0);
+  gas.assign(results.size(), 0.0);
+  for (size_t period = 0; period < results.size(); period++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      (endUse < FIRST_GAS_END_USE ? electricity : gas)[period] += area * endUseValue(results[period], endUse);
+    }
+  }
+}
+
+CalibrationResult Calibration::evaluate(const double* parameters) const
+{
+  std::vector<double> electricity;
+  std::vector<double> gas;
+  simulate(parameters, m_metered.hourly(), electricity, gas);
+  CalibrationResult result;
+  result.parameters.assign(parameters, parameters + m_binding.size());
+  result.electricity = FitStatistics();
+  result.gas = FitStatistics();
+  result.compliant = true;
+  if (!m_metered.electricity.empty()) {
+    result.electricity = fitStatistics(m_metered.electricity, electricity);
+    result.compliant = result.compliant && result.electricity.compliant(m_metered.hourly());
+  }
+  if (!m_metered.gas.empty()) {
+    result.gas = fitStatistics(m_metered.gas, gas);
+    result.compliant = result.compliant && result.gas.compliant(m_metered.hourly());
+  }
+  result.evaluations = 1;
+  result.seconds = 0;
+  return result;
+}
+
+double Calibration::objective(const double* parameters) const
+{
+  CalibrationResult result = evaluate(parameters);
+  double value = 0;
+  if (result.electricity.points > 0) {
+    value += result.electricity.cvrmse * result.electricity.cvrmse + result.electricity.nmbe * result.electricity.nmbe;
+  }
+  if (result.gas.points > 0) {
+    value += result.gas.cvrmse * result.gas.cvrmse + result.gas.nmbe * result.gas.nmbe;
+  }
+  return value;
+}
+
+CalibrationResult Calibration::run(ThreadPool& pool) const
+{
+  auto start = std::chrono::steady_clock::now();
+  size_t dimensions = m_binding.size();
+  size_t evaluations = 0;
+  auto toValues = [&](const std::vector<double>& point) {
+    std::vector<double> values(dimensions);
+    for (size_t i = 0; i < dimensions; i++) {
+      values[i] = m_low[i] + point[i] * (m_high[i] - m_low[i]);
+    }
+    return values;
+  };
+
+  std::vector<double> best = minimizeCmaes(dimensions, m_population, m_generations, m_seed,
+                                           [&](const std::vector<std::vector<double> >& points) {
+    std::vector<double> fitness(points.size());
+    pool.parallelFor(points.size(), [&](size_t k) { fitness[k] = objective(toValues(points[k]).data()); });
+    evaluations += points.size();
+    return fitness;
+  });
+
+  CalibrationResult result = evaluate(toValues(best).data());
+  result.evaluations = evaluations;
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+void Calibration::writeReport(const CalibrationResult& result, std::ostream& out) const
+{
+  out << std::setprecision(10);
+  out << "Parameter,Value\n";
+  for (size_t i = 0; i < result.parameters.size(); i++) {
+    out << m_binding.names()[i] << "," << result.parameters[i] << "\n";
+  }
+  out << "\nFuel,CVRMSE,NMBE,Points,Guideline14\n";
+  const char* fuels[] = { "Electricity", "Gas" };
+  const FitStatistics* statistics[] = { &result.electricity, &result.gas };
+  for (int fuel = 0; fuel < 2; fuel++) {
+    if (statistics[fuel]->points == 0) {
+      continue;
+    }
+    out << fuels[fuel] << "," << statistics[fuel]->cvrmse << "," << statistics[fuel]->nmbe << "," << statistics[fuel]->points << ","
+        << (statistics[fuel]->compliant(m_metered.hourly()) ? "pass" : "fail") << "\n";
+  }
+}
+
+}
+}
@@ -0,0 +1,154 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_CALIBRATION_HPP
+#define ISOMODEL_CALIBRATION_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <algorithm>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Metered electricity and gas use in kWh, either 12 monthly bills or 8760 hourly
+ * readings. A fuel that is not metered is empty; missing readings are NaN.
+ */
+struct ISOMODEL_API MeteredData
+{
+  std::vector<double> electricity;
+  std::vector<double> gas;
+
+  size_t periods() const {
+    return std::max(electricity.size(), gas.size());
+  }
+
+  bool hourly() const {
+    return periods() == 8760;
+  }
+
+  /**
+   * Reads a CSV file with a header row. The columns named electricity and gas (case
+   * insensitive) are read and any others, such as a month or hour column, are ignored.
+   * Empty cells are missing readings. Throws std::invalid_argument if the file cannot
+   * be read, has neither column, a value is not a number or there are not 12 or 8760
+   * rows.
+   */
+  static MeteredData load(const std::string& file);
+  static MeteredData parse(std::istream& in);
+};
+
+/**
+ * Goodness of fit of simulated to measured values as defined by ASHRAE Guideline 14,
+ * in percent of the mean measured value. Missing measurements are skipped.
+ */
+struct ISOMODEL_API FitStatistics
+{
+  double cvrmse;
+  double nmbe;
+  size_t points;
+
+  /**
+   * Whether the fit meets the Guideline 14 criteria for calibrated models: CV(RMSE) of
+   * at most 15% and NMBE within 5% for monthly data, and 30% and 10% for hourly data.
+   */
+  bool compliant(bool hourly) const;
+};
+
+/**
+ * Computes CV(RMSE) and NMBE with n - parameterCount degrees of freedom (Guideline 14
+ * uses 1). Throws std::invalid_argument if the series differ in length or there are
+ * too few measurements or their mean is 0.
+ */
+ISOMODEL_API FitStatistics fitStatistics(const std::vector<double>& measured, const std::vector<double>& simulated,
+                                         size_t parameterCount = 1);
+
+struct ISOMODEL_API CalibrationResult
+{
+  std::vector<double> parameters;
+  FitStatistics electricity; // No points if electricity is not metered.
+  FitStatistics gas;
+  bool compliant;
+  size_t evaluations;
+  double seconds;
+};
+
+/**
+ * Calibrates the parameters of a SweepSpec within their ranges to metered data by
+ * minimizing the sum of the squared CV(RMSE) and NMBE of the metered fuels with CMA-ES.
+ * Every generation is evaluated on the thread pool. Each run compiles the model to a
+ * SimulationPlan, which shares the hourly weather derived from the base model's weather
+ * file, so only the model dependent stages are recomputed.
+ */
+class ISOMODEL_API Calibration
+{
+public:
+  /**
+   * Throws std::invalid_argument if a parameter is unknown or has no range (a uniform or
+   * triangular distribution), or hourly data is given for the monthly engine. metered
+   * may be empty to only simulate the metered quantities.
+   */
+  Calibration(const UserModel& base, const SweepSpec& spec, const MeteredData& metered);
+
+  const ParameterBinding& binding() const {
+    return m_binding;
+  }
+
+  /**
+   * Simulated electricity and gas use in kWh by hour (which needs the hourly engine) or
+   * by month.
+   */
+  void simulate(const double* parameters, bool hourly, std::vector<double>& electricity, std::vector<double>& gas) const;
+
+  /**
+   * The fit of the model with parameters to the metered data.
+   */
+  CalibrationResult evaluate(const double* parameters) const;
+
+  CalibrationResult run(ThreadPool& pool) const;
+
+  /**
+   * Writes the calibrated parameters and the fit of each metered fuel as CSV.
+   */
+  void writeReport(const CalibrationResult& result, std::ostream& out) const;
+
+private:
+  double objective(const double* parameters) const;
+
+  UserModel m_base;
+  SimulationEngine m_engine;
+  size_t m_population;
+  size_t m_generations;
+  uint64_t m_seed;
+  MeteredData m_metered;
+  ParameterBinding m_binding;
+  std::vector<double> m_low;
+  std::vector<double> m_high;
+};
+
+}
+}
+#endif
@@ -0,0 +1,48 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Cancellation.hpp"
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+thread_local const std::atomic<bool>* currentToken = nullptr;
+
+}
+
+CancellationScope::CancellationScope(const CancellationToken& token) : m_token(token), m_previous(currentToken)
+{
+  currentToken = m_token.m_cancelled.get();
+}
+
+CancellationScope::~CancellationScope()
+{
+  currentToken = m_previous;
+}
+
+void checkCancellation()
+{
+  if (currentToken != nullptr && *currentToken) {
+    throw SimulationCancelled();
+  }
+}
+
+}
+}
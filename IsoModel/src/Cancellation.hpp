@@ -0,0 +1,94 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_CANCELLATION_HPP
+#define ISOMODEL_CANCELLATION_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Thrown by a simulation that was cancelled.
+ */
+class ISOMODEL_API SimulationCancelled : public std::runtime_error
+{
+public:
+  SimulationCancelled() : std::runtime_error("The simulation was cancelled.")
+  {
+  }
+};
+
+/**
+ * A cancellation flag shared by its copies.
+ */
+class ISOMODEL_API CancellationToken
+{
+public:
+  CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool> >(false))
+  {
+  }
+
+  void cancel() {
+    *m_cancelled = true;
+  }
+
+  bool cancelled() const {
+    return *m_cancelled;
+  }
+
+private:
+  friend class CancellationScope;
+
+  std::shared_ptr<std::atomic<bool> > m_cancelled;
+};
+
+/**
+ * Makes token the cancellation token of the calling thread for the lifetime of the
+ * scope. MonthlyModel::simulate() and HourlyModel::simulate() check the token between
+ * their steps and blocks of hours and throw SimulationCancelled once it is cancelled.
+ * Scopes nest; the previous token is restored on destruction.
+ */
+class ISOMODEL_API CancellationScope
+{
+public:
+  explicit CancellationScope(const CancellationToken& token);
+  ~CancellationScope();
+
+private:
+  CancellationScope(const CancellationScope&);
+  CancellationScope& operator=(const CancellationScope&);
+
+  CancellationToken m_token;
+  const std::atomic<bool>* m_previous;
+};
+
+/**
+ * Throws SimulationCancelled if the calling thread's token (see CancellationScope) is
+ * cancelled.
+ */
+ISOMODEL_API void checkCancellation();
+
+}
+}
+#endif
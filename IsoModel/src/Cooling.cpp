@@ -4,6 +4,8 @@ namespace openstudio {
 namespace isomodel {
 
 Cooling::Cooling(void)
+    : m_temperatureSetPointOccupied(0), m_temperatureSetPointUnoccupied(0), m_cop(0), m_partialLoadValue(0),
+      m_hvacLossFactor(0), m_pumpControlReduction(0)
 {
 }
 
@@ -208,6 +208,15 @@ public:
     m_E_pumps = E_pumps;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_temperatureSetPointOccupied & m_temperatureSetPointUnoccupied & m_cop
+        & m_partialLoadValue & m_hvacLossFactor & m_pumpControlReduction & m_forcedAirCooling
+        & m_T_cl_ctrl_flag & m_dT_supp_cl & m_DC_YesNo & m_eta_DC_network & m_eta_DC_COP
+        & m_eta_DC_frac_abs & m_eta_DC_COP_abs & m_frac_DC_free & m_E_pumps;
+  }
+
 private:
   double m_temperatureSetPointOccupied;
   double m_temperatureSetPointUnoccupied;
@@ -0,0 +1,84 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_COPY_ON_WRITE_HPP
+#define ISOMODEL_COPY_ON_WRITE_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Holds a value that is shared between copies until one of them is modified. Copying a
+ * CopyOnWrite copies a pointer; write() gives the caller its own copy of the value first
+ * if any other CopyOnWrite still refers to it.
+ *
+ * A shared value is never modified, so copies may be read and modified from different
+ * threads without locking, as long as each CopyOnWrite object is used by one thread.
+ * write() modifies the value in place only once every other copy has been released or
+ * modified, and orders that after the other threads' last reads of it.
+ */
+template<class T>
+class CopyOnWrite
+{
+public:
+  CopyOnWrite() : m_value(std::make_shared<T>()) {
+  }
+
+  CopyOnWrite(const T& value) : m_value(std::make_shared<T>(value)) {
+  }
+
+  const T& operator*() const {
+    return *m_value;
+  }
+
+  const T* operator->() const {
+    return m_value.get();
+  }
+
+  /**
+   * The value for modification, copied first if it is shared.
+   */
+  T& write() {
+    if (m_value.use_count() > 1) {
+      m_value = std::make_shared<T>(*m_value);
+    } else {
+      // use_count() is a relaxed load. Pair it with the release of the last other copy,
+      // so that its owner's reads happen before the modification.
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *m_value;
+  }
+
+  /**
+   * True if both refer to the same value, i.e. neither has been modified since one was
+   * copied from the other.
+   */
+  bool shares(const CopyOnWrite& other) const {
+    return m_value == other.m_value;
+  }
+
+private:
+  std::shared_ptr<T> m_value;
+};
+
+}
+}
+#endif
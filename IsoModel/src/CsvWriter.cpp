@@ -0,0 +1,505 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "CsvWriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// Shortest round trip digits by the Grisu2 algorithm of F. Loitsch, "Printing
+// floating-point numbers quickly and accurately with integers" (PLDI 2010). The digits
+// always read back to the same double and are the shortest such digits for all but a few
+// doubles in ten thousand, which get a few digits more than necessary.
+
+struct DiyFp
+{
+  uint64_t f;
+  int e;
+
+  DiyFp(uint64_t f, int e) : f(f), e(e)
+  {
+  }
+};
+
+DiyFp minus(const DiyFp& x, const DiyFp& y)
+{
+  return DiyFp(x.f - y.f, x.e);
+}
+
+// The upper 64 bits of the 128 bit product, rounded.
+DiyFp times(const DiyFp& x, const DiyFp& y)
+{
+  uint64_t xLow = x.f & 0xFFFFFFFFu;
+  uint64_t xHigh = x.f >> 32;
+  uint64_t yLow = y.f & 0xFFFFFFFFu;
+  uint64_t yHigh = y.f >> 32;
+  uint64_t lowLow = xLow * yLow;
+  uint64_t lowHigh = xLow * yHigh;
+  uint64_t highLow = xHigh * yLow;
+  uint64_t highHigh = xHigh * yHigh;
+  uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFu) + (highLow & 0xFFFFFFFFu) + (1u << 31);
+  return DiyFp(highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32), x.e + y.e + 64);
+}
+
+DiyFp normalize(DiyFp x)
+{
+  // Normal doubles have 53 or 54 significant bits here, subnormals fewer.
+  if ((x.f >> 52) != 0 && (x.f >> 54) == 0) {
+    int shift = (x.f >> 53) != 0 ? 10 : 11;
+    return DiyFp(x.f << shift, x.e - shift);
+  }
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+// The binary exponents between which the scaled value is split into its digits.
+const int ALPHA = -60;
+const int GAMMA = -32;
+
+struct CachedPower
+{
+  uint64_t f;
+  int e;
+  int k;
+};
+
+// 10^k = f * 2^e for every eighth k from -300 to 324, f normalized and rounded.
+const CachedPower CACHED_POWERS[] = {
+  { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+  { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+  { 0xBE5691EF416BD60CULL, -1007, -284 },
+  { 0x8DD01FAD907FFC3CULL, -980, -276 },
+  { 0xD3515C2831559A83ULL, -954, -268 },
+  { 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+  { 0xEA9C227723EE8BCBULL, -901, -252 },
+  { 0xAECC49914078536DULL, -874, -244 },
+  { 0x823C12795DB6CE57ULL, -847, -236 },
+  { 0xC21094364DFB5637ULL, -821, -228 },
+  { 0x9096EA6F3848984FULL, -794, -220 },
+  { 0xD77485CB25823AC7ULL, -768, -212 },
+  { 0xA086CFCD97BF97F4ULL, -741, -204 },
+  { 0xEF340A98172AACE5ULL, -715, -196 },
+  { 0xB23867FB2A35B28EULL, -688, -188 },
+  { 0x84C8D4DFD2C63F3BULL, -661, -180 },
+  { 0xC5DD44271AD3CDBAULL, -635, -172 },
+  { 0x936B9FCEBB25C996ULL, -608, -164 },
+  { 0xDBAC6C247D62A584ULL, -582, -156 },
+  { 0xA3AB66580D5FDAF6ULL, -555, -148 },
+  { 0xF3E2F893DEC3F126ULL, -529, -140 },
+  { 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+  { 0x87625F056C7C4A8BULL, -475, -124 },
+  { 0xC9BCFF6034C13053ULL, -449, -116 },
+  { 0x964E858C91BA2655ULL, -422, -108 },
+  { 0xDFF9772470297EBDULL, -396, -100 },
+  { 0xA6DFBD9FB8E5B88FULL, -369, -92 },
+  { 0xF8A95FCF88747D94ULL, -343, -84 },
+  { 0xB94470938FA89BCFULL, -316, -76 },
+  { 0x8A08F0F8BF0F156BULL, -289, -68 },
+  { 0xCDB02555653131B6ULL, -263, -60 },
+  { 0x993FE2C6D07B7FACULL, -236, -52 },
+  { 0xE45C10C42A2B3B06ULL, -210, -44 },
+  { 0xAA242499697392D3ULL, -183, -36 },
+  { 0xFD87B5F28300CA0EULL, -157, -28 },
+  { 0xBCE5086492111AEBULL, -130, -20 },
+  { 0x8CBCCC096F5088CCULL, -103, -12 },
+  { 0xD1B71758E219652CULL, -77, -4 },
+  { 0x9C40000000000000ULL, -50, 4 },
+  { 0xE8D4A51000000000ULL, -24, 12 },
+  { 0xAD78EBC5AC620000ULL, 3, 20 },
+  { 0x813F3978F8940984ULL, 30, 28 },
+  { 0xC097CE7BC90715B3ULL, 56, 36 },
+  { 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+  { 0xD5D238A4ABE98068ULL, 109, 52 },
+  { 0x9F4F2726179A2245ULL, 136, 60 },
+  { 0xED63A231D4C4FB27ULL, 162, 68 },
+  { 0xB0DE65388CC8ADA8ULL, 189, 76 },
+  { 0x83C7088E1AAB65DBULL, 216, 84 },
+  { 0xC45D1DF942711D9AULL, 242, 92 },
+  { 0x924D692CA61BE758ULL, 269, 100 },
+  { 0xDA01EE641A708DEAULL, 295, 108 },
+  { 0xA26DA3999AEF774AULL, 322, 116 },
+  { 0xF209787BB47D6B85ULL, 348, 124 },
+  { 0xB454E4A179DD1877ULL, 375, 132 },
+  { 0x865B86925B9BC5C2ULL, 402, 140 },
+  { 0xC83553C5C8965D3DULL, 428, 148 },
+  { 0x952AB45CFA97A0B3ULL, 455, 156 },
+  { 0xDE469FBD99A05FE3ULL, 481, 164 },
+  { 0xA59BC234DB398C25ULL, 508, 172 },
+  { 0xF6C69A72A3989F5CULL, 534, 180 },
+  { 0xB7DCBF5354E9BECEULL, 561, 188 },
+  { 0x88FCF317F22241E2ULL, 588, 196 },
+  { 0xCC20CE9BD35C78A5ULL, 614, 204 },
+  { 0x98165AF37B2153DFULL, 641, 212 },
+  { 0xE2A0B5DC971F303AULL, 667, 220 },
+  { 0xA8D9D1535CE3B396ULL, 694, 228 },
+  { 0xFB9B7CD9A4A7443CULL, 720, 236 },
+  { 0xBB764C4CA7A44410ULL, 747, 244 },
+  { 0x8BAB8EEFB6409C1AULL, 774, 252 },
+  { 0xD01FEF10A657842CULL, 800, 260 },
+  { 0x9B10A4E5E9913129ULL, 827, 268 },
+  { 0xE7109BFBA19C0C9DULL, 853, 276 },
+  { 0xAC2820D9623BF429ULL, 880, 284 },
+  { 0x80444B5E7AA7CF85ULL, 907, 292 },
+  { 0xBF21E44003ACDD2DULL, 933, 300 },
+  { 0x8E679C2F5E44FF8FULL, 960, 308 },
+  { 0xD433179D9C8CB841ULL, 986, 316 },
+  { 0x9E19DB92B4E31BA9ULL, 1013, 324 }
+};
+
+// The cached power c such that the exponent of a value of binary exponent e times c is
+// between ALPHA and GAMMA.
+const CachedPower& cachedPower(int e)
+{
+  int f = ALPHA - e - 1;
+  // ceil(f * log10(2))
+  int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+  return CACHED_POWERS[(300 + k + 7) / 8];
+}
+
+const uint32_t POWERS_OF_TEN[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Moves the last digit towards the value while the digits stay within the boundaries.
+void roundWeed(char* digits, int length, uint64_t distance, uint64_t delta, uint64_t rest, uint64_t tenK)
+{
+  while (rest < distance && delta - rest >= tenK && (rest + tenK < distance || distance - rest > rest + tenK - distance)) {
+    digits[length - 1]--;
+    rest += tenK;
+  }
+}
+
+// Generates the digits of a value between low and high, as close to w as can be.
+void generateDigits(char* digits, int& length, int& exponent, const DiyFp& low, const DiyFp& w, const DiyFp& high)
+{
+  uint64_t delta = minus(high, low).f;
+  uint64_t distance = minus(high, w).f;
+  DiyFp one(uint64_t(1) << -high.e, high.e);
+  uint32_t integral = (uint32_t) (high.f >> -one.e);
+  uint64_t fraction = high.f & (one.f - 1);
+
+  int remaining = 10;
+  while (remaining > 1 && integral < POWERS_OF_TEN[remaining - 1]) {
+    remaining--;
+  }
+  uint32_t divisor = POWERS_OF_TEN[remaining - 1];
+  while (remaining > 0) {
+    digits[length++] = (char) ('0' + integral / divisor);
+    integral %= divisor;
+    remaining--;
+    uint64_t rest = ((uint64_t) integral << -one.e) + fraction;
+    if (rest <= delta) {
+      exponent += remaining;
+      roundWeed(digits, length, distance, delta, rest, (uint64_t) divisor << -one.e);
+      return;
+    }
+    divisor /= 10;
+  }
+
+  int fractionDigits = 0;
+  for (;;) {
+    fraction *= 10;
+    delta *= 10;
+    distance *= 10;
+    digits[length++] = (char) ('0' + (fraction >> -one.e));
+    fraction &= one.f - 1;
+    fractionDigits++;
+    if (fraction <= delta) {
+      break;
+    }
+  }
+  exponent -= fractionDigits;
+  roundWeed(digits, length, distance, delta, fraction, one.f);
+}
+
+// The shortest digits of a positive finite value: value = digits * 10^exponent.
+int shortestDigits(double value, char* digits, int& exponent)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint64_t hiddenBit = uint64_t(1) << 52;
+  uint64_t fraction = bits & (hiddenBit - 1);
+  int biased = (int) (bits >> 52);
+  DiyFp v = biased == 0 ? DiyFp(fraction, 1 - 1075) : DiyFp(fraction + hiddenBit, biased - 1075);
+
+  // The boundaries halfway to the neighbouring doubles, closer below a power of two.
+  DiyFp high = normalize(DiyFp(2 * v.f + 1, v.e - 1));
+  DiyFp low = fraction == 0 && biased > 1 ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+  low.f <<= low.e - high.e;
+  low.e = high.e;
+  DiyFp w = normalize(v);
+
+  const CachedPower& cached = cachedPower(high.e);
+  DiyFp c(cached.f, cached.e);
+  DiyFp scaledLow = times(low, c);
+  DiyFp scaledHigh = times(high, c);
+  // Narrowed by the rounding error of the products, so that the digits round trip.
+  scaledLow.f++;
+  scaledHigh.f--;
+  exponent = -cached.k;
+  int length = 0;
+  generateDigits(digits, length, exponent, scaledLow, times(w, c), scaledHigh);
+  return length;
+}
+
+char* writeExponent(char* out, int exponent)
+{
+  *out++ = 'e';
+  *out++ = exponent < 0 ? '-' : '+';
+  unsigned magnitude = (unsigned) (exponent < 0 ? -exponent : exponent);
+  if (magnitude >= 100) {
+    *out++ = (char) ('0' + magnitude / 100);
+    magnitude %= 100;
+  }
+  *out++ = (char) ('0' + magnitude / 10);
+  *out++ = (char) ('0' + magnitude % 10);
+  return out;
+}
+
+}
+
+size_t CsvWriter::formatDouble(double value, int precision, char* out)
+{
+  char* start = out;
+  if (std::isnan(value)) {
+    std::memcpy(out, "nan", 3);
+    return 3;
+  }
+  if (std::signbit(value)) {
+    *out++ = '-';
+    value = -value;
+  }
+  if (std::isinf(value)) {
+    std::memcpy(out, "inf", 3);
+    return out + 3 - start;
+  }
+  if (value == 0) {
+    *out++ = '0';
+    return out - start;
+  }
+
+  char digits[24];
+  int exponent;
+  int length = shortestDigits(value, digits, exponent);
+  // The exponent of the first digit, as in d.ddd * 10^scientific.
+  int scientific = exponent + length - 1;
+  if (precision != SHORTEST && length > precision) {
+    if (length == precision + 1 && digits[precision] == '5') {
+      // A tie of the shortest digits may not be one of the exact value, which only printf
+      // rounds right.
+      int written = std::snprintf(out, MAX_DOUBLE_LENGTH - (out - start), "%.*g", precision, value);
+      return out + written - start;
+    }
+    bool up = digits[precision] >= '5';
+    length = precision;
+    if (up) {
+      int i = length - 1;
+      while (i >= 0 && digits[i] == '9') {
+        i--;
+      }
+      if (i < 0) {
+        digits[0] = '1';
+        length = 1;
+        scientific++;
+      } else {
+        digits[i]++;
+        length = i + 1;
+      }
+    }
+  }
+  while (length > 1 && digits[length - 1] == '0') {
+    length--;
+  }
+
+  int limit = precision == SHORTEST ? 17 : precision;
+  if (scientific < -4 || scientific >= limit) {
+    *out++ = digits[0];
+    if (length > 1) {
+      *out++ = '.';
+      std::memcpy(out, digits + 1, length - 1);
+      out += length - 1;
+    }
+    out = writeExponent(out, scientific);
+  } else if (scientific < 0) {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = -1; i > scientific; i--) {
+      *out++ = '0';
+    }
+    std::memcpy(out, digits, length);
+    out += length;
+  } else if (length <= scientific + 1) {
+    std::memcpy(out, digits, length);
+    out += length;
+    for (int i = length; i <= scientific; i++) {
+      *out++ = '0';
+    }
+  } else {
+    std::memcpy(out, digits, scientific + 1);
+    out += scientific + 1;
+    *out++ = '.';
+    std::memcpy(out, digits + scientific + 1, length - scientific - 1);
+    out += length - scientific - 1;
+  }
+  return out - start;
+}
+
+CsvWriter::CsvWriter(std::ostream& out, int precision, size_t bufferSize)
+  : m_out(&out), m_buffer(std::max(bufferSize, (size_t) 4 * MAX_DOUBLE_LENGTH)), m_size(0), m_precision(SHORTEST),
+    m_separator(","), m_rowStarted(false)
+{
+  setPrecision(precision);
+}
+
+CsvWriter::CsvWriter(const std::string& path, int precision, size_t bufferSize)
+  : m_file(new std::ofstream(path.c_str(), std::ios::binary)), m_out(m_file.get()), m_path(path),
+    m_buffer(std::max(bufferSize, (size_t) 4 * MAX_DOUBLE_LENGTH)), m_size(0), m_precision(SHORTEST), m_separator(","),
+    m_rowStarted(false)
+{
+  if (!*m_file) {
+    throw std::invalid_argument("Cannot write " + path + ".");
+  }
+  setPrecision(precision);
+}
+
+CsvWriter::~CsvWriter()
+{
+  m_out->write(m_buffer.data(), m_size);
+  m_out->flush();
+}
+
+void CsvWriter::setPrecision(int precision)
+{
+  if (precision != SHORTEST && (precision < 1 || precision > 17)) {
+    throw std::invalid_argument("The precision must be 1 to 17 significant digits, or 0 for the shortest round trip digits.");
+  }
+  m_precision = precision;
+}
+
+void CsvWriter::setSeparator(const std::string& separator)
+{
+  if (separator.size() > MAX_DOUBLE_LENGTH) {
+    throw std::invalid_argument("The separator is too long.");
+  }
+  m_separator = separator;
+}
+
+CsvWriter& CsvWriter::write(const std::string& text)
+{
+  if (m_size + text.size() > m_buffer.size()) {
+    drain();
+    if (text.size() > m_buffer.size()) {
+      m_out->write(text.data(), text.size());
+      m_rowStarted = m_rowStarted && text[text.size() - 1] != '\n';
+      return *this;
+    }
+  }
+  std::memcpy(&m_buffer[m_size], text.data(), text.size());
+  m_size += text.size();
+  if (!text.empty() && text[text.size() - 1] == '\n') {
+    m_rowStarted = false;
+  }
+  return *this;
+}
+
+char* CsvWriter::separate(size_t size)
+{
+  char* out = reserve(m_separator.size() + size);
+  if (m_rowStarted) {
+    std::memcpy(out, m_separator.data(), m_separator.size());
+    out += m_separator.size();
+    m_size += m_separator.size();
+  }
+  m_rowStarted = true;
+  return out;
+}
+
+CsvWriter& CsvWriter::field(double value)
+{
+  char* out = separate(MAX_DOUBLE_LENGTH);
+  m_size += formatDouble(value, m_precision, out);
+  return *this;
+}
+
+CsvWriter& CsvWriter::field(int value)
+{
+  char* out = separate(11);
+  unsigned magnitude = value < 0 ? 0u - (unsigned) value : (unsigned) value;
+  if (value < 0) {
+    *out++ = '-';
+    m_size++;
+  }
+  char digits[10];
+  int length = 0;
+  do {
+    digits[length++] = (char) ('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  for (int i = 0; i < length; i++) {
+    out[i] = digits[length - 1 - i];
+  }
+  m_size += length;
+  return *this;
+}
+
+CsvWriter& CsvWriter::field(const std::string& value)
+{
+  separate(0);
+  write(value);
+  m_rowStarted = true;
+  return *this;
+}
+
+CsvWriter& CsvWriter::endRow()
+{
+  *reserve(1) = '\n';
+  m_size++;
+  m_rowStarted = false;
+  return *this;
+}
+
+void CsvWriter::drain()
+{
+  m_out->write(m_buffer.data(), m_size);
+  m_size = 0;
+  if (!*m_out) {
+    throw std::invalid_argument(m_path.empty() ? std::string("Cannot write the output.") : "Cannot write " + m_path + ".");
+  }
+}
+
+void CsvWriter::flush()
+{
+  drain();
+  m_out->flush();
+  if (!*m_out) {
+    throw std::invalid_argument(m_path.empty() ? std::string("Cannot write the output.") : "Cannot write " + m_path + ".");
+  }
+}
+
+}
+}
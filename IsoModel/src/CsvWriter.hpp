@@ -0,0 +1,151 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_CSV_WRITER_HPP
+#define ISOMODEL_CSV_WRITER_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Writes delimited text, such as CSV rows of results, through a large buffer that is
+ * handed to the stream only when full, on flush and on destruction, instead of a stream
+ * operation per value and a flush per row.
+ *
+ * Values are separated by the separator (default ","). Doubles are written with the
+ * shortest digits that read back to the same double, or rounded to a given number of
+ * significant digits, and in the notation printf's %g would choose for that many digits.
+ */
+class ISOMODEL_API CsvWriter
+{
+public:
+  static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+  /**
+   * The precision that writes the shortest round trip digits.
+   */
+  static const int SHORTEST = 0;
+
+  /**
+   * The longest text formatDouble writes.
+   */
+  static const size_t MAX_DOUBLE_LENGTH = 32;
+
+  /**
+   * Writes to out, which must outlive the writer.
+   */
+  explicit CsvWriter(std::ostream& out, int precision = SHORTEST, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * Writes to the file at path, replacing it. Throws std::invalid_argument if the file
+   * cannot be opened.
+   */
+  explicit CsvWriter(const std::string& path, int precision = SHORTEST, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * Flushes the buffer. Errors are only reported by flush.
+   */
+  ~CsvWriter();
+
+  int precision() const {
+    return m_precision;
+  }
+
+  /**
+   * SHORTEST, or 1 to 17 significant digits. Throws std::invalid_argument otherwise.
+   */
+  void setPrecision(int precision);
+
+  const std::string& separator() const {
+    return m_separator;
+  }
+
+  /**
+   * Throws std::invalid_argument if separator is longer than MAX_DOUBLE_LENGTH.
+   */
+  void setSeparator(const std::string& separator);
+
+  /**
+   * Writes text as is, such as a title or a header row with its line break. Text that
+   * ends with a line break ends the row.
+   */
+  CsvWriter& write(const std::string& text);
+
+  /**
+   * Writes a value, preceded by the separator unless it is the first of its row.
+   */
+  CsvWriter& field(double value);
+  CsvWriter& field(int value);
+  CsvWriter& field(const std::string& value);
+
+  /**
+   * Ends the row with a line break.
+   */
+  CsvWriter& endRow();
+
+  /**
+   * Hands the buffer to the stream and flushes it. Throws std::invalid_argument if the
+   * stream fails.
+   */
+  void flush();
+
+  /**
+   * Formats value into out, which must hold MAX_DOUBLE_LENGTH characters, and returns the
+   * length written (no terminating null). NaN and infinities are written as nan, inf
+   * and -inf. With a precision, the shortest digits are rounded to that many if they are
+   * longer, which up to 15 digits is the same text as printf's %g.
+   */
+  static size_t formatDouble(double value, int precision, char* out);
+
+private:
+  CsvWriter(const CsvWriter&);
+  CsvWriter& operator=(const CsvWriter&);
+
+  // Makes room for size more characters.
+  char* reserve(size_t size) {
+    if (m_size + size > m_buffer.size()) {
+      drain();
+    }
+    return &m_buffer[m_size];
+  }
+
+  // Writes the separator unless the row is empty, and makes room for size more characters.
+  char* separate(size_t size);
+  void drain();
+
+  std::unique_ptr<std::ofstream> m_file;
+  std::ostream* m_out;
+  std::string m_path;
+  std::vector<char> m_buffer;
+  size_t m_size;
+  int m_precision;
+  std::string m_separator;
+  bool m_rowStarted;
+};
+
+}
+}
+#endif
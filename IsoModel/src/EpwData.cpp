@@ -1,9 +1,48 @@
 #include "EpwData.hpp"
+#include "SimulationPlan.hpp"
 
 namespace openstudio {
 namespace isomodel {
 
-EpwData::EpwData(void)
+namespace {
+/**
+ * Compact storage encoding of each column: value = offset + q / scale, where q is an
+ * unsigned 16 bit integer, so the maximum error is 0.5 / scale. The ranges leave room
+ * for the EPW missing value markers (99.9, 999, 9999). Values outside the range are
+ * clamped.
+ */
+struct ColumnEncoding
+{
+  double offset;
+  double scale;
+};
+
+const ColumnEncoding columnEncodings[7] = {
+  { -100.0, 100.0 }, // DBT: -100 to 555 C, error 0.005 C (EPW resolution 0.1 C).
+  { -100.0, 100.0 }, // DPT: as DBT.
+  { 0.0, 50.0 },     // RH: 0 to 1310 %, error 0.01 % (EPW resolution 1 %).
+  { 0.0, 5.0 },      // EGH: 0 to 13107 W/m2, error 0.1 W/m2 (EPW resolution 1 Wh/m2).
+  { 0.0, 5.0 },      // EB: as EGH.
+  { 0.0, 5.0 },      // ED: as EGH.
+  { 0.0, 50.0 }      // WSPD: 0 to 1310 m/s, error 0.01 m/s (EPW resolution 0.1 m/s).
+};
+
+uint16_t encode(int column, double value)
+{
+  const ColumnEncoding& enc = columnEncodings[column];
+  double q = std::floor((value - enc.offset) * enc.scale + 0.5);
+  return (uint16_t) std::min(std::max(q, 0.0), 65535.0);
+}
+
+double decode(int column, uint16_t q)
+{
+  const ColumnEncoding& enc = columnEncodings[column];
+  return enc.offset + q / enc.scale;
+}
+}
+
+EpwData::EpwData(void) :
+    m_compact(false), m_rows(0), m_deferred(false), m_revision(1), m_hourlyWeatherRevision(0), m_fingerprintRevision(0)
 {
   m_data.resize(7);
 }
@@ -44,14 +83,23 @@ void EpwData::parseHeader(std::string line)
       break;
     }
   }
+  m_revision++;
 }
 void EpwData::parseData(std::string line, int row)
 {
-  std::stringstream linestream(line);
-  std::string s;
+  double values[7];
+  parseRow(line, values);
+  for (int c = 0; c < 7; c++) {
+    m_data[c][row] = values[c];
+  }
+}
+
+void EpwData::parseRow(const std::string& line, double* values)
+{
+  // Columns 6, 7, 8, 13, 14, 15 and 21 of the line hold DBT, DPT, RH, EGH, EB, ED and WSPD.
+  const char* p = line.c_str();
   int col = 0;
-  for (int i = 0; i < 22; i++) {
-    std::getline(linestream, s, ',');
+  for (int i = 0; i < 22 && *p != '\0'; i++) {
     switch (i) {
     case 6:
     case 7:
@@ -60,13 +108,76 @@ void EpwData::parseData(std::string line, int row)
     case 14:
     case 15:
     case 21:
-      m_data[col++][row] = (double) ::atof(s.c_str());
+      values[col++] = ::atof(p);
       break;
     default:
       break;
     }
+    while (*p != '\0' && *p != ',') {
+      p++;
+    }
+    if (*p == ',') {
+      p++;
+    }
+  }
+  for (; col < 7; col++) {
+    values[col] = 0.0;
   }
 }
+
+void EpwData::setDeferredFile(std::string fn)
+{
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  m_sourceFile = fn;
+  m_deferred = true;
+  m_revision++;
+}
+
+void EpwData::ensureLoaded()
+{
+  if (!m_deferred.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  if (m_deferred.load(std::memory_order_relaxed)) {
+    loadData(m_sourceFile);
+  }
+}
+
+std::shared_ptr<const HourlyWeather> EpwData::hourlyWeather()
+{
+  std::lock_guard<std::mutex> lock(m_hourlyWeatherMutex);
+  // Keeps the data from changing while it is read. Loading happens here rather than
+  // through ensureLoaded, which would take the lock again.
+  std::lock_guard<std::mutex> dataLock(m_loadMutex);
+  if (m_deferred) {
+    loadData(m_sourceFile);
+  }
+  uint64_t revision = m_revision.load();
+  if (m_hourlyWeatherRevision != revision) {
+    m_hourlyWeather = HourlyWeather::compute(*this);
+    m_hourlyWeatherRevision = revision;
+  }
+  return m_hourlyWeather;
+}
+
+ContentHash EpwData::fingerprint()
+{
+  std::lock_guard<std::mutex> lock(m_fingerprintMutex);
+  std::lock_guard<std::mutex> dataLock(m_loadMutex);
+  if (m_deferred) {
+    loadData(m_sourceFile);
+  }
+  uint64_t revision = m_revision.load();
+  if (m_fingerprintRevision != revision) {
+    BinaryWriter out;
+    serialize(out, true);
+    m_fingerprint = out.hash();
+    m_fingerprintRevision = revision;
+  }
+  return m_fingerprint;
+}
+
 std::string EpwData::toISOData()
 {
   std::string results;
@@ -114,6 +225,99 @@ std::string EpwData::toISOData()
   return sstream.str();
 }
 
+std::vector<std::vector<double> > EpwData::data()
+{
+  ensureLoaded();
+  if (!m_compact) {
+    return m_data;
+  }
+  std::vector<std::vector<double> > decoded(7);
+  for (int c = 0; c < 7; c++) {
+    column(c, decoded[c]);
+  }
+  return decoded;
+}
+
+void EpwData::column(int column, std::vector<double>& out)
+{
+  ensureLoaded();
+  if (!m_compact) {
+    out = m_data[column];
+    return;
+  }
+  out.resize(m_rows);
+  const uint16_t* q = &m_packed[0] + column * m_rows;
+  for (int r = 0; r < m_rows; r++) {
+    out[r] = decode(column, q[r]);
+  }
+}
+
+double EpwData::value(int column, int row)
+{
+  ensureLoaded();
+  if (m_compact) {
+    return decode(column, m_packed[column * m_rows + row]);
+  }
+  return m_data[column][row];
+}
+
+double EpwData::quantizationError(int column)
+{
+  return 0.5 / columnEncodings[column].scale;
+}
+
+size_t EpwData::memoryUsage() const
+{
+  size_t bytes = m_packed.capacity() * sizeof(uint16_t);
+  for (size_t c = 0; c < m_data.size(); c++) {
+    bytes += m_data[c].capacity() * sizeof(double);
+  }
+  return bytes;
+}
+
+void EpwData::setCompactStorage(bool compact)
+{
+  // Serialized with a deferred load, which packs the data according to m_compact.
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  if (compact == m_compact) {
+    return;
+  }
+  m_compact = compact;
+  m_revision++;
+  if (m_rows > 0 && !m_deferred) {
+    if (compact) {
+      pack();
+    } else {
+      unpack();
+    }
+  }
+}
+
+void EpwData::pack()
+{
+  m_packed.resize(7 * m_rows);
+  for (int c = 0; c < 7; c++) {
+    uint16_t* q = &m_packed[0] + c * m_rows;
+    for (int r = 0; r < m_rows; r++) {
+      q[r] = encode(c, m_data[c][r]);
+    }
+    // Release the double column rather than just clearing it.
+    std::vector<double>().swap(m_data[c]);
+  }
+}
+
+void EpwData::unpack()
+{
+  for (int c = 0; c < 7; c++) {
+    m_data[c].resize(m_rows);
+    const uint16_t* q = &m_packed[0] + c * m_rows;
+    for (int r = 0; r < m_rows; r++) {
+      m_data[c][r] = decode(c, q[r]);
+    }
+  }
+  std::vector<uint16_t>().swap(m_packed);
+}
+
 void EpwData::loadData(int block_size, double* data)
 {
   // first 3 doubles are latitude, longitude, tz
@@ -130,6 +334,15 @@ void EpwData::loadData(int block_size, double* data)
       ++ptr;
     }
   }
+  m_rows = 8760;
+  if (m_compact) {
+    pack();
+  } else {
+    std::vector<uint16_t>().swap(m_packed);
+  }
+  m_sourceFile.clear();
+  m_revision++;
+  m_deferred.store(false, std::memory_order_release);
 }
 
 void EpwData::loadData(std::string fn)
@@ -142,6 +355,7 @@ void EpwData::loadData(std::string fn)
   for (int c = 0; c < 7; c++) {
     m_data[c].resize(8760);
   }
+  m_rows = 8760;
   if (myfile.is_open()) {
     while (myfile.good() && row < 8760) {
       i++;
@@ -154,6 +368,14 @@ void EpwData::loadData(std::string fn)
     }
     myfile.close();
   }
+  m_sourceFile = fn;
+  if (m_compact) {
+    pack();
+  } else {
+    std::vector<uint16_t>().swap(m_packed);
+  }
+  m_revision++;
+  m_deferred.store(false, std::memory_order_release);
 }
 }
 }
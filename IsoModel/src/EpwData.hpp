@@ -26,7 +26,12 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
+#include "BinaryArchive.hpp"
 #include "SolarRadiation.hpp"
 #include "TimeFrame.hpp"
 
@@ -42,17 +47,46 @@ const int ED = 5;
 const int WSPD = 6;
 
 class SolarRadiation;
+struct HourlyWeather;
 
 class ISOMODEL_API EpwData
 {
 protected:
-  void parseHeader(std::string line);
   void parseData(std::string line, int row);
+  void ensureLoaded();
   std::string m_location, m_stationid;
   int m_timezone;
   double m_latitude, m_longitude;
   std::vector<std::vector<double> > m_data;
 
+  // Compact storage: all columns quantized to 16 bit integers in one
+  // contiguous column-major block (column c, row r at c * m_rows + r).
+  void pack();
+  void unpack();
+  bool m_compact;
+  int m_rows;
+  std::vector<uint16_t> m_packed;
+
+  // File the hourly rows were (or, while m_deferred is set, will be) loaded from.
+  std::string m_sourceFile;
+  std::atomic<bool> m_deferred;
+  std::mutex m_loadMutex;
+
+  // Incremented by every change of the header or hourly data. The values derived from the
+  // data below are current while their revision matches it, so a change does not need to
+  // take their mutexes. They are computed while holding m_loadMutex, after their own mutex.
+  std::atomic<uint64_t> m_revision;
+
+  // Hourly weather inputs of the hourly method, computed on first use.
+  std::shared_ptr<const HourlyWeather> m_hourlyWeather;
+  uint64_t m_hourlyWeatherRevision;
+  std::mutex m_hourlyWeatherMutex;
+
+  // Hash of the header and hourly data, computed on first use.
+  ContentHash m_fingerprint;
+  uint64_t m_fingerprintRevision;
+  std::mutex m_fingerprintMutex;
+
 public:
   EpwData(void);
   ~EpwData(void);
@@ -64,6 +98,52 @@ public:
   void loadData(std::string);
   std::string toISOData();
 
+  /**
+   * Parses the EPW location header line (location, station, latitude, longitude and time zone).
+   */
+  void parseHeader(std::string line);
+
+  /**
+   * Parses the hourly columns of an EPW data line into values, in column order (DBT ... WSPD).
+   */
+  static void parseRow(const std::string& line, double* values);
+
+  /**
+   * Defers loading of the hourly data until it is first accessed through data(), column()
+   * or value(). The header must already be parsed. Loading is thread safe, so a deferred
+   * EpwData may be shared between simulations. Used when only monthly averages are needed
+   * up front (see MonthlyWeatherReducer).
+   */
+  void setDeferredFile(std::string fn);
+
+  /**
+   * The weather file the hourly data was loaded from, or will be loaded from if loading
+   * is deferred. Empty if the data was loaded from an array.
+   */
+  std::string sourceFile() const {
+    return m_sourceFile;
+  }
+
+  /**
+   * Snapshot serialization, see BinaryArchive.hpp. The hourly data is only included if
+   * hourly is true; otherwise a reader is expected to follow up with setDeferredFile.
+   */
+  template<class Archive>
+  void serialize(Archive& ar, bool hourly) {
+    ar & m_location & m_stationid & m_timezone & m_latitude & m_longitude & m_compact;
+    if (hourly) {
+      ensureLoaded();
+      ar & m_rows & m_data & m_packed;
+    }
+  }
+
+  /**
+   * True if hourly data is held (or will be loaded on access).
+   */
+  bool hasData() const {
+    return m_rows > 0 || m_deferred;
+  }
+
   // Getters.
   std::string location() {
     return m_location;
@@ -85,10 +165,65 @@ public:
     return m_longitude;
   }
 
-  std::vector<std::vector<double> > data() {
-    return m_data;
+  std::vector<std::vector<double> > data();
+
+  /**
+   * Enables or disables compact storage of the hourly columns. In compact mode each
+   * value is held as a scaled 16 bit integer and decoded on access, which uses a quarter
+   * of the memory of the double columns. The maximum error of each column is given by
+   * quantizationError() and is well below the resolution of the EPW source data.
+   * May be called before loading (the data is packed as it is loaded) or after, also
+   * while another thread triggers a deferred load.
+   */
+  void setCompactStorage(bool compact);
+
+  bool compactStorage() const {
+    return m_compact;
   }
 
+  /**
+   * Maximum absolute error of a column held in compact storage, in the units of the column.
+   */
+  static double quantizationError(int column);
+
+  /**
+   * Decodes a single column into out, which is resized to the number of rows.
+   * Cheaper than data() when only some columns are needed.
+   */
+  void column(int column, std::vector<double>& out);
+
+  /**
+   * The solar radiation on each surface and the other hourly inputs of the hourly method.
+   * Computed on first use and shared by every simulation using this weather, and computed
+   * again after the data changes. Thread safe.
+   */
+  std::shared_ptr<const HourlyWeather> hourlyWeather();
+
+  /**
+   * A hash of the header and the hourly data as held (so compact storage hashes
+   * differently), identifying the weather in result cache keys. Loads deferred data.
+   * Computed on first use and again after the data changes. Thread safe, also while
+   * another thread changes the data.
+   */
+  ContentHash fingerprint();
+
+  /**
+   * Returns a single hourly value.
+   */
+  double value(int column, int row);
+
+  /**
+   * Number of hourly rows held. Zero while loading is deferred.
+   */
+  int rows() const {
+    return m_rows;
+  }
+
+  /**
+   * Resident memory of the hourly data in bytes.
+   */
+  size_t memoryUsage() const;
+
 };
 
 }
@@ -4,6 +4,9 @@ namespace openstudio {
 namespace isomodel {
 
 Heating::Heating(void)
+    : m_temperatureSetPointOccupied(0), m_temperatureSetPointUnoccupied(0), m_hvacLossFactor(0), m_efficiency(0),
+      m_energyType(0), m_pumpControlReduction(0), m_hotWaterDemand(0), m_hotWaterDistributionEfficiency(0),
+      m_hotWaterSystemEfficiency(0), m_hotWaterEnergyType(0), m_hotcoldWasteFactor(0)
 {
 }
 
@@ -288,6 +288,17 @@ public:
     m_dhw_tsupply = dhw_tsupply;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_temperatureSetPointOccupied & m_temperatureSetPointUnoccupied & m_hvacLossFactor
+        & m_efficiency & m_energyType & m_pumpControlReduction & m_hotWaterDemand
+        & m_hotWaterDistributionEfficiency & m_hotWaterSystemEfficiency & m_hotWaterEnergyType
+        & m_hotcoldWasteFactor & m_forcedAirHeating & m_dT_supp_ht & m_E_pumps & m_T_ht_ctrl_flag
+        & m_a_H0 & m_tau_H0 & m_DH_YesNo & m_eta_DH_network & m_eta_DH_sys & m_frac_DH_free
+        & m_dhw_tset & m_dhw_tsupply;
+  }
+
 private:
   double m_temperatureSetPointOccupied;
   double m_temperatureSetPointUnoccupied;
@@ -0,0 +1,306 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "HourlyAggregator.hpp"
+#include "SimulationPlan.hpp"
+#include "TimeFrame.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const TimeFrame& calendar()
+{
+  static const TimeFrame frame;
+  return frame;
+}
+
+const char* const PERIOD_NAMES[] = { "daily", "weekly", "monthly", "seasonal" };
+
+// The electric end uses come first in EndUses order.
+const int ELECTRIC_END_USES = 9;
+
+const CalendarPeak NO_PEAK = { 0, -1, 0, 0, 0 };
+
+}
+
+AggregationOptions::AggregationOptions() : occupancy(true), peaks(true), durationBins(256)
+{
+  std::fill(periods, periods + CALENDAR_PERIODS, true);
+}
+
+LoadHistogram::LoadHistogram(int bins)
+{
+  if (bins <= 0 || bins % 2 != 0) {
+    throw std::invalid_argument("A load histogram needs an even, positive number of bins, not " + std::to_string(bins) + ".");
+  }
+  m_counts.resize(bins);
+  clear();
+}
+
+void LoadHistogram::clear()
+{
+  std::fill(m_counts.begin(), m_counts.end(), 0);
+  m_width = 0;
+  m_scale = 0;
+  m_limit = 0;
+  m_max = 0;
+  m_count = 0;
+}
+
+void LoadHistogram::grow(double value)
+{
+  size_t bins = m_counts.size();
+  if (m_width == 0) {
+    // The smallest power of two that is wider than value / bins.
+    int exponent;
+    std::frexp(value / bins, &exponent);
+    m_width = std::ldexp(1.0, exponent);
+  } else {
+    while (value >= m_width * bins) {
+      for (size_t i = 0; i < bins / 2; i++) {
+        m_counts[i] = m_counts[2 * i] + m_counts[2 * i + 1];
+      }
+      std::fill(m_counts.begin() + bins / 2, m_counts.end(), 0);
+      m_width *= 2;
+    }
+  }
+  m_scale = 1 / m_width;
+  m_limit = m_width * bins;
+}
+
+size_t LoadHistogram::hoursAtOrAbove(double load) const
+{
+  if (load <= 0 || m_width == 0) {
+    return load <= 0 ? m_count : 0;
+  }
+  size_t hours = 0;
+  for (size_t i = std::min(m_counts.size(), (size_t) (load * m_scale)); i < m_counts.size(); i++) {
+    hours += m_counts[i];
+  }
+  return hours;
+}
+
+double LoadHistogram::loadExceeded(size_t hours) const
+{
+  size_t seen = 0;
+  for (size_t i = m_counts.size(); i-- > 0;) {
+    seen += m_counts[i];
+    if (seen >= hours && seen > 0) {
+      return i * m_width;
+    }
+  }
+  return 0;
+}
+
+std::vector<LoadDurationPoint> LoadHistogram::durationCurve() const
+{
+  std::vector<LoadDurationPoint> curve;
+  size_t last = m_counts.size();
+  while (last > 0 && m_counts[last - 1] == 0) {
+    last--;
+  }
+  size_t hours = 0;
+  for (size_t i = last; i-- > 0;) {
+    hours += m_counts[i];
+    LoadDurationPoint point = { i * m_width, hours };
+    curve.push_back(point);
+  }
+  return curve;
+}
+
+HourlyAggregator::HourlyAggregator(const AggregationOptions& options) : m_options(options), m_hours(0)
+{
+  for (int period = 0; period < CALENDAR_PERIODS; period++) {
+    if (m_options.periods[period]) {
+      m_sums[period].resize(periodCount((CalendarPeriod) period) * AGGREGATE_SERIES);
+      if (m_options.occupancy) {
+        m_occupiedSums[period].resize(m_sums[period].size());
+      }
+    }
+  }
+  if (m_options.durationBins != 0) {
+    m_histograms.assign(AGGREGATE_SERIES, LoadHistogram(m_options.durationBins));
+  }
+  std::fill(&m_occupied[0][0], &m_occupied[0][0] + 24 * 7, false);
+  std::fill(&m_peaks[0][0], &m_peaks[0][0] + 12 * AGGREGATE_SERIES, NO_PEAK);
+}
+
+void HourlyAggregator::begin(const HourlyPlan& plan)
+{
+  std::copy(&plan.occupied[0][0], &plan.occupied[0][0] + 24 * 7, &m_occupied[0][0]);
+  for (int period = 0; period < CALENDAR_PERIODS; period++) {
+    std::fill(m_sums[period].begin(), m_sums[period].end(), 0.0);
+    std::fill(m_occupiedSums[period].begin(), m_occupiedSums[period].end(), 0.0);
+  }
+  std::fill(&m_peaks[0][0], &m_peaks[0][0] + 12 * AGGREGATE_SERIES, NO_PEAK);
+  for (auto& histogram : m_histograms) {
+    histogram.clear();
+  }
+  m_hours = 0;
+}
+
+void HourlyAggregator::add(int hourOfYear, const double* endUses)
+{
+  const TimeFrame& frame = calendar();
+  double values[AGGREGATE_SERIES];
+  double electricity = 0;
+  double gas = 0;
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    values[endUse] = endUses[endUse];
+    (endUse < ELECTRIC_END_USES ? electricity : gas) += endUses[endUse];
+  }
+  values[ELECTRICITY_SERIES] = electricity;
+  values[GAS_SERIES] = gas;
+
+  bool occupied = m_options.occupancy && m_occupied[frame.Hour[hourOfYear]][frame.DayOfWeek[hourOfYear]];
+  for (int period = 0; period < CALENDAR_PERIODS; period++) {
+    if (m_sums[period].empty()) {
+      continue;
+    }
+    size_t first = (size_t) periodOf((CalendarPeriod) period, hourOfYear) * AGGREGATE_SERIES;
+    double* sums = &m_sums[period][first];
+    for (int series = 0; series < AGGREGATE_SERIES; series++) {
+      sums[series] += values[series];
+    }
+    if (occupied) {
+      double* occupiedSums = &m_occupiedSums[period][first];
+      for (int series = 0; series < AGGREGATE_SERIES; series++) {
+        occupiedSums[series] += values[series];
+      }
+    }
+  }
+
+  if (m_options.peaks) {
+    CalendarPeak* peaks = m_peaks[frame.Month[hourOfYear] - 1];
+    for (int series = 0; series < AGGREGATE_SERIES; series++) {
+      CalendarPeak& peak = peaks[series];
+      if (values[series] > peak.value || peak.hourOfYear < 0) {
+        peak.value = values[series];
+        peak.hourOfYear = hourOfYear;
+        peak.month = frame.Month[hourOfYear];
+        peak.dayOfMonth = frame.DayOfMonth[hourOfYear];
+        peak.hour = frame.Hour[hourOfYear];
+      }
+    }
+  }
+
+  for (size_t series = 0; series < m_histograms.size(); series++) {
+    m_histograms[series].add(values[series]);
+  }
+  m_hours++;
+}
+
+int HourlyAggregator::periodCount(CalendarPeriod period)
+{
+  static const int counts[] = { 365, 53, 12, 4 };
+  return counts[period];
+}
+
+int HourlyAggregator::periodOf(CalendarPeriod period, int hourOfYear)
+{
+  const TimeFrame& frame = calendar();
+  switch (period) {
+  case CALENDAR_DAY:
+    return frame.YTD[hourOfYear];
+  case CALENDAR_WEEK:
+    return frame.YTD[hourOfYear] / 7;
+  case CALENDAR_MONTH:
+    return frame.Month[hourOfYear] - 1;
+  default:
+    // December, January and February are 0.
+    return frame.Month[hourOfYear] % 12 / 3;
+  }
+}
+
+size_t HourlyAggregator::offset(CalendarPeriod period, int index, int series) const
+{
+  if (period < 0 || period >= CALENDAR_PERIODS || m_sums[period].empty()) {
+    throw std::invalid_argument("The periods were not aggregated.");
+  }
+  if (index < 0 || index >= periodCount(period)) {
+    throw std::invalid_argument("There is no " + std::string(PERIOD_NAMES[period]) + " period " + std::to_string(index) + ".");
+  }
+  if (series < 0 || series >= AGGREGATE_SERIES) {
+    throw std::invalid_argument("There is no series " + std::to_string(series) + ".");
+  }
+  return (size_t) index * AGGREGATE_SERIES + series;
+}
+
+double HourlyAggregator::sum(CalendarPeriod period, int index, int series) const
+{
+  size_t i = offset(period, index, series);
+  return m_sums[period][i];
+}
+
+double HourlyAggregator::occupiedSum(CalendarPeriod period, int index, int series) const
+{
+  size_t i = offset(period, index, series);
+  if (!m_options.occupancy) {
+    throw std::invalid_argument("The occupied hours were not aggregated.");
+  }
+  return m_occupiedSums[period][i];
+}
+
+double HourlyAggregator::unoccupiedSum(CalendarPeriod period, int index, int series) const
+{
+  return sum(period, index, series) - occupiedSum(period, index, series);
+}
+
+const CalendarPeak& HourlyAggregator::peak(int month, int series) const
+{
+  if (!m_options.peaks) {
+    throw std::invalid_argument("The peaks were not aggregated.");
+  }
+  if (month < 0 || month >= 12 || series < 0 || series >= AGGREGATE_SERIES) {
+    throw std::invalid_argument("There is no peak of series " + std::to_string(series) + " in month " + std::to_string(month) + ".");
+  }
+  return m_peaks[month][series];
+}
+
+CalendarPeak HourlyAggregator::annualPeak(int series) const
+{
+  CalendarPeak annual = peak(0, series);
+  for (int month = 1; month < 12; month++) {
+    const CalendarPeak& candidate = m_peaks[month][series];
+    if (candidate.hourOfYear >= 0 && (annual.hourOfYear < 0 || candidate.value > annual.value)) {
+      annual = candidate;
+    }
+  }
+  return annual;
+}
+
+const LoadHistogram& HourlyAggregator::loadDuration(int series) const
+{
+  if (m_histograms.empty()) {
+    throw std::invalid_argument("The load duration histograms were not aggregated.");
+  }
+  if (series < 0 || series >= AGGREGATE_SERIES) {
+    throw std::invalid_argument("There is no series " + std::to_string(series) + ".");
+  }
+  return m_histograms[series];
+}
+
+}
+}
@@ -0,0 +1,256 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_HOURLY_AGGREGATOR_HPP
+#define ISOMODEL_HOURLY_AGGREGATOR_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+struct HourlyPlan;
+
+/**
+ * Calendar periods of the reducers of HourlyAggregator. Weeks are counted from the first
+ * day of the year, so the 53rd week holds only December 31. Seasons are meteorological,
+ * starting with winter: December, January and February of the simulated year.
+ */
+enum CalendarPeriod
+{
+  CALENDAR_DAY,
+  CALENDAR_WEEK,
+  CALENDAR_MONTH,
+  CALENDAR_SEASON,
+  CALENDAR_PERIODS
+};
+
+/**
+ * The series aggregated by HourlyAggregator: the end uses in EndUses order followed by
+ * the total electricity and the total gas of each hour.
+ */
+const int ELECTRICITY_SERIES = END_USE_COUNT;
+const int GAS_SERIES = END_USE_COUNT + 1;
+const int AGGREGATE_SERIES = END_USE_COUNT + 2;
+
+struct ISOMODEL_API AggregationOptions
+{
+  // The calendar reducers to run, by CalendarPeriod. All of them by default.
+  bool periods[CALENDAR_PERIODS];
+  // Also sums the occupied hours of every period separately (the default).
+  bool occupancy;
+  // Tracks the peak hour of every month (the default).
+  bool peaks;
+  // Bins of the load duration histograms, an even number, or 0 for none. 256 by default.
+  int durationBins;
+
+  AggregationOptions();
+};
+
+/**
+ * The highest hourly value of a series in a month or the year, kWh/m2, and when it
+ * occurred. hourOfYear is -1 if no hour was aggregated.
+ */
+struct ISOMODEL_API CalendarPeak
+{
+  double value;
+  int hourOfYear; // 0-8759.
+  int month; // 1-12.
+  int dayOfMonth; // 1-31.
+  int hour; // 0-23, the hour ending at hour + 1.
+};
+
+/**
+ * One point of a load duration curve: the number of hours with a load at or above load.
+ */
+struct ISOMODEL_API LoadDurationPoint
+{
+  double load;
+  size_t hours;
+};
+
+/**
+ * A histogram of hourly loads from which the load duration curve is read, built without
+ * storing the loads. The bins are equally wide, starting at zero, and their width is a
+ * power of two: when a load does not fit, the width is doubled by merging neighbouring
+ * bins, so at least half of the bins span the loads seen so far. Negative loads are
+ * counted in the first bin.
+ */
+class ISOMODEL_API LoadHistogram
+{
+public:
+  /**
+   * Throws std::invalid_argument unless bins is even and positive.
+   */
+  explicit LoadHistogram(int bins = 256);
+
+  void clear();
+
+  void add(double value)
+  {
+    if (value <= 0) {
+      ++m_counts[0];
+    } else if (value < m_limit) {
+      // Exact, since the width is a power of two.
+      ++m_counts[(size_t) (value * m_scale)];
+    } else {
+      grow(value);
+      ++m_counts[(size_t) (value * m_scale)];
+    }
+    if (value > m_max || m_count == 0) {
+      m_max = value;
+    }
+    ++m_count;
+  }
+
+  size_t count() const {
+    return m_count;
+  }
+
+  double max() const {
+    return m_max;
+  }
+
+  /**
+   * Width of the bins, 0 until a positive load is added.
+   */
+  double binWidth() const {
+    return m_width;
+  }
+
+  const std::vector<size_t>& counts() const {
+    return m_counts;
+  }
+
+  /**
+   * Number of loads at or above load. Exact when load is a multiple of the bin width,
+   * otherwise it includes the loads of the bin holding load.
+   */
+  size_t hoursAtOrAbove(double load) const;
+
+  /**
+   * The load reached or exceeded in at least hours hours, rounded down to a multiple
+   * of the bin width. The exact value is less than a bin width higher.
+   */
+  double loadExceeded(size_t hours) const;
+
+  /**
+   * The load duration curve at the lower edge of every bin up to the highest load, in
+   * decreasing order of load.
+   */
+  std::vector<LoadDurationPoint> durationCurve() const;
+
+private:
+  void grow(double value);
+
+  std::vector<size_t> m_counts;
+  double m_width;
+  double m_scale; // 1 / m_width.
+  double m_limit; // Upper edge of the last bin.
+  double m_max;
+  size_t m_count;
+};
+
+/**
+ * Reduces the hourly end uses of a simulation to calendar sums, peaks and load duration
+ * curves as they are computed, one hour at a time, so the hourly results are never
+ * stored. Pass it to HourlyModel::aggregate or SimulationPlan::aggregateHourly.
+ *
+ * The calendar is that of TimeFrame. With occupancy, the hours in the occupied hours
+ * and days of the plan are also summed separately.
+ */
+class ISOMODEL_API HourlyAggregator
+{
+public:
+  explicit HourlyAggregator(const AggregationOptions& options = AggregationOptions());
+
+  const AggregationOptions& options() const {
+    return m_options;
+  }
+
+  /**
+   * Clears the results and takes the occupancy schedule of plan.
+   */
+  void begin(const HourlyPlan& plan);
+
+  /**
+   * Adds the END_USE_COUNT end uses, in EndUses order, of hourOfYear (0-8759).
+   */
+  void add(int hourOfYear, const double* endUses);
+
+  /**
+   * Number of hours added since begin.
+   */
+  size_t hours() const {
+    return m_hours;
+  }
+
+  /**
+   * Number of periods in a year: 365 days, 53 weeks, 12 months or 4 seasons.
+   */
+  static int periodCount(CalendarPeriod period);
+
+  /**
+   * The period (counted from 0) holding hourOfYear.
+   */
+  static int periodOf(CalendarPeriod period, int hourOfYear);
+
+  /**
+   * Sum of series over a period, kWh/m2. Throws std::invalid_argument if the period was
+   * not aggregated or is out of range.
+   */
+  double sum(CalendarPeriod period, int index, int series) const;
+
+  /**
+   * Sum of series over the occupied or unoccupied hours of a period, kWh/m2. Throws
+   * std::invalid_argument if occupancy or the period was not aggregated.
+   */
+  double occupiedSum(CalendarPeriod period, int index, int series) const;
+  double unoccupiedSum(CalendarPeriod period, int index, int series) const;
+
+  /**
+   * Peak hour of series in a month (0-11) or the year. Ties go to the earliest hour.
+   */
+  const CalendarPeak& peak(int month, int series) const;
+  CalendarPeak annualPeak(int series) const;
+
+  /**
+   * Histogram of the hourly values of series over the year.
+   */
+  const LoadHistogram& loadDuration(int series) const;
+
+private:
+  size_t offset(CalendarPeriod period, int index, int series) const;
+
+  AggregationOptions m_options;
+  bool m_occupied[24][7];
+  // Sums by period, AGGREGATE_SERIES values per period.
+  std::vector<double> m_sums[CALENDAR_PERIODS];
+  std::vector<double> m_occupiedSums[CALENDAR_PERIODS];
+  CalendarPeak m_peaks[12][AGGREGATE_SERIES];
+  std::vector<LoadHistogram> m_histograms;
+  size_t m_hours;
+};
+
+}
+}
+#endif
@@ -14,185 +14,243 @@
 // SingleBldg.L50).
 
 #include "HourlyModel.hpp"
+#include "Cancellation.hpp"
+#include "HourlyAggregator.hpp"
 
 namespace openstudio {
 namespace isomodel {
 
-//TODO This initializer list should be removed and these attributes included in the ism file. -BAA@2014-12-14
-// There are a bunch more similar constants that are initialized in HourlyModel::initialize().
-HourlyModel::HourlyModel() {}
-HourlyModel::~HourlyModel() {}
+namespace {
 
-std::vector<EndUses> HourlyModel::simulate(bool aggregateByMonth)
+// Converts the raw needs of each hour to end uses. The heating and cooling needs are
+// factored by the distribution efficiencies, which depend on the yearly needs, so the
+// raw needs of the whole year must be known first.
+class EndUseConversion
 {
-  populateSchedules();
-
-  printMatrix("Cooling Setpoint", (double*) fixedActualCoolingSetpoint, 24, 7);
-  printMatrix("Heating Setpoint", (double*) fixedActualHeatingSetpoint, 24, 7);
-  printMatrix("Exterior Equipment", (double*) fixedExteriorEquipmentSchedule, 24, 7);
-  printMatrix("Exterior Lighting", (double*) fixedExteriorLightingSchedule, 24, 7);
-  printMatrix("Interior Equipment", (double*) fixedInteriorEquipmentSchedule, 24, 7);
-  printMatrix("Interior Lighting", (double*) fixedInteriorLightingSchedule, 24, 7);
-  printMatrix("Ventilation", (double*) fixedVentilationSchedule, 24, 7);
-
-  initialize();
-  TimeFrame frame;
-  auto TMT1 = 20.0;
-  auto tiHeatCool = 20.0;
-  std::vector<double> wind = epwData->data()[WSPD];
-  std::vector<double> temp = epwData->data()[DBT];
-
-  SolarRadiation pos(&frame, epwData.get());
-  pos.Calculate();
-  std::vector<std::vector<double> > radiation = pos.eglobe(); // Radiation for 8 directions (N, NE, E, etc.).
-  // Add the roof radiation (9th direction). EGH is global horizontal radiation.
-  // TODO BAA@2015-02-25: There ought to be a more efficient way of setting up the radiation.
-  for (auto i = 0; i != radiation.size(); ++i) {
-    radiation[i].push_back(epwData->data()[EGH][i]);
+public:
+  EndUseConversion(const HourlyPlan& plan, const HourResults<std::vector<double>>& rawResults) : rawResults(rawResults)
+  {
+    // Factor the raw need results by the distribution efficiencies.
+    auto a_ht_loss = plan.heatingLossFactor;
+    auto a_cl_loss = plan.coolingLossFactor;
+    auto f_waste = plan.hotcoldWasteFactor;
+    cop = plan.coolingCop;
+    efficiency_ht = plan.heatingEfficiency;
+
+    // Calculate the yearly totals.
+    auto Qneed_ht_yr = std::accumulate(rawResults.Qneed_ht.begin(), rawResults.Qneed_ht.end(), 0.0);
+    auto Qneed_cl_yr = std::accumulate(rawResults.Qneed_cl.begin(), rawResults.Qneed_cl.end(), 0.0);
+
+    auto f_dem_ht = std::max(Qneed_ht_yr / (Qneed_cl_yr + Qneed_ht_yr), 0.1);
+    auto f_dem_cl = std::max((1.0 - f_dem_ht), 0.1);
+
+    eta_dist_ht = 1.0 / (1.0 + a_ht_loss + f_waste / f_dem_ht);
+    eta_dist_cl = 1.0 / (1.0 + a_cl_loss + f_waste / f_dem_cl);
+    electricHeating = plan.heatingEnergyType == 1;
   }
 
-  HourResults<double> tempHourResults;
-  HourResults<std::vector<double>> rawResults;
-
-  for (auto i = 0; i < TIMESLICES; ++i) {
-    auto month = frame.Month[i];
-    auto hourOfDay = frame.Hour[i];
-    auto dayOfWeek = frame.DayOfWeek[i];
-    
-    calculateHour(i + 1, //hourOfYear
-                  month, //month
-                  dayOfWeek, //dayOfWeek
-                  hourOfDay, //hourOfDay
-                  wind[i], //windMps
-                  temp[i], //temperature
-                  radiation[i],
-                  TMT1, //TMT1
-                  tiHeatCool, //tiHeatCool
-                  tempHourResults);
-    // Store each result type in its own vector.
-    rawResults.Qneed_ht.push_back(tempHourResults.Qneed_ht);
-    rawResults.Qneed_cl.push_back(tempHourResults.Qneed_cl);
-    rawResults.Q_illum_tot.push_back(tempHourResults.Q_illum_tot);
-    rawResults.Q_illum_ext_tot.push_back(tempHourResults.Q_illum_ext_tot);
-    rawResults.Qfan_tot.push_back(tempHourResults.Qfan_tot);
-    rawResults.Qpump_tot.push_back(tempHourResults.Qpump_tot);
-    rawResults.phi_plug.push_back(tempHourResults.phi_plug);
-    rawResults.externalEquipmentEnergyWperm2.push_back(tempHourResults.externalEquipmentEnergyWperm2);
-    rawResults.Q_dhw.push_back(tempHourResults.Q_dhw);
+  // Factors the heating and cooling values of hour i, renames the results to match the
+  // monthly result names and converts them to EUI in kWh/m^2.
+  void operator()(int i, double* results) const
+  {
+    auto Qht_sys = rawResults.Qneed_ht[i] / eta_dist_ht / efficiency_ht;
+    auto Qcl_sys = rawResults.Qneed_cl[i] / eta_dist_cl / cop;
+    // TODO Fix this! Hardcoded values of '0' for things not being calculated is not ideal.
+    results[HourlyWorkspace::Eelec_ht] = electricHeating ? Qht_sys / 1000.0 : 0.0;
+    results[HourlyWorkspace::Eelec_cl] = Qcl_sys / 1000.0;
+    results[HourlyWorkspace::Eelec_int_lt] = rawResults.Q_illum_tot[i] / 1000.0;
+    results[HourlyWorkspace::Eelec_ext_lt] = rawResults.Q_illum_ext_tot[i] / 1000.0;
+    results[HourlyWorkspace::Eelec_fan] = rawResults.Qfan_tot[i] / 1000.0;
+    results[HourlyWorkspace::Eelec_pump] = rawResults.Qpump_tot[i] / 1000.0;
+    results[HourlyWorkspace::Eelec_int_plug] = rawResults.phi_plug[i] / 1000.0;
+    // TODO BAA@2015-01-28. This is currently hardcoded and shouldn't be.
+    results[HourlyWorkspace::Eelec_ext_plug] = rawResults.externalEquipmentEnergyWperm2[i] / 1000.0;
+    results[HourlyWorkspace::Eelec_dhw] = rawResults.Q_dhw[i] / 1000.0;
+    results[HourlyWorkspace::Egas_ht] = electricHeating ? 0.0 : Qht_sys / 1000.0;
+    results[HourlyWorkspace::Egas_cl] = 0.0;
+    results[HourlyWorkspace::Egas_plug] = 0.0;
+    results[HourlyWorkspace::Egas_dhw] = 0.0;
   }
 
-  // Factor the raw need results by the distribution efficiencies.
-  auto a_ht_loss = heating.hvacLossFactor();
-  auto a_cl_loss = cooling.hvacLossFactor();
-  auto f_waste = heating.hotcoldWasteFactor();
-  auto cop = cooling.cop();
-  auto efficiency_ht = heating.efficiency();
+private:
+  const HourResults<std::vector<double>>& rawResults;
+  double cop;
+  double efficiency_ht;
+  double eta_dist_ht;
+  double eta_dist_cl;
+  bool electricHeating;
+};
 
-  // Calculate the yearly totals.
-  auto Qneed_ht_yr = std::accumulate(rawResults.Qneed_ht.begin(), rawResults.Qneed_ht.end(), 0.0);
-  auto Qneed_cl_yr = std::accumulate(rawResults.Qneed_cl.begin(), rawResults.Qneed_cl.end(), 0.0);
+}
 
-  auto f_dem_ht = std::max(Qneed_ht_yr / (Qneed_cl_yr + Qneed_ht_yr), 0.1);
-  auto f_dem_cl = std::max((1.0 - f_dem_ht), 0.1);
+//TODO This initializer list should be removed and these attributes included in the ism file. -BAA@2014-12-14
+// There are a bunch more similar constants that are initialized in HourlyModel::initialize().
+HourlyModel::HourlyModel() {}
+HourlyModel::~HourlyModel() {}
 
-  auto eta_dist_ht = 1.0 / (1.0 + a_ht_loss + f_waste / f_dem_ht);
-  auto eta_dist_cl = 1.0 / (1.0 + a_cl_loss + f_waste / f_dem_cl);
+std::vector<EndUses> HourlyModel::simulate(bool aggregateByMonth) const
+{
+  HourlyWorkspace workspace;
+  return simulate(workspace, aggregateByMonth);
+}
 
-  // Create unary functions to factor the heating and cooling values for use
-  // with transform().
-  auto factorHeating = [=](double need) {return need / eta_dist_ht / efficiency_ht;};
-  auto factorCooling = [=](double need) {return need / eta_dist_cl / cop;};
+std::vector<EndUses> HourlyModel::simulate(HourlyWorkspace& workspace, bool aggregateByMonth) const
+{
+  if (cache) {
+    return cache->getOrCompute(resultKey(aggregateByMonth ? HOURLY_BY_MONTH_RESULTS : HOURLY_RESULTS),
+                               [&]() { return simulate(plan(), *epwData->hourlyWeather(), workspace, aggregateByMonth); });
+  }
+  return simulate(plan(), *epwData->hourlyWeather(), workspace, aggregateByMonth);
+}
 
-  // Create containers for factored heating and cooling values.
-  std::vector<double> v_Qht_sys(rawResults.Qneed_ht.size());
-  std::vector<double> v_Qcl_sys(rawResults.Qneed_cl.size());
+std::vector<EndUses> HourlyModel::simulate(const HourlyPlan& plan, const HourlyWeather& weather, bool aggregateByMonth)
+{
+  HourlyWorkspace workspace;
+  return simulate(plan, weather, workspace, aggregateByMonth);
+}
 
-  // Factor the heating and cooling values.
-  std::transform(rawResults.Qneed_ht.begin(), rawResults.Qneed_ht.end(), v_Qht_sys.begin(), factorHeating);
-  std::transform(rawResults.Qneed_cl.begin(), rawResults.Qneed_cl.end(), v_Qcl_sys.begin(), factorCooling);
+std::vector<EndUses> HourlyModel::simulate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyWorkspace& workspace,
+                                           bool aggregateByMonth)
+{
+  calculateNeeds(plan, weather, workspace.raw);
+  EndUseConversion convert(plan, workspace.raw);
 
-  // Store the factored results and rename them to match the monthly result names.
-  std::map<std::string, std::vector<double>> results;
-  
-  // TODO Fix this! Hardcoded values of '0' for things not being calculated is not ideal.
-  std::vector<double> zeroes(rawResults.Qneed_ht.size(), 0.0);
-
-  results["Eelec_ht"] = (heating.energyType() == 1) ? v_Qht_sys : zeroes; // If electric.
-  results["Eelec_cl"] = v_Qcl_sys;
-  results["Eelec_int_lt"] = rawResults.Q_illum_tot;
-  results["Eelec_ext_lt"] = rawResults.Q_illum_ext_tot;
-  results["Eelec_fan"] = rawResults.Qfan_tot;
-  results["Eelec_pump"] = rawResults.Qpump_tot;
-  results["Eelec_int_plug"] = rawResults.phi_plug;
-  results["Eelec_ext_plug"] = rawResults.externalEquipmentEnergyWperm2; // TODO BAA@2015-01-28. This is currently hardcoded and shouldn't be.
-  results["Eelec_dhw"] = rawResults.Q_dhw;
-  results["Egas_ht"] = (heating.energyType() != 1) ? v_Qht_sys : zeroes; // If not electric.
-  results["Egas_cl"] = zeroes;
-  results["Egas_plug"] = zeroes;
-  results["Egas_dhw"] = zeroes;
-
-  // Convert to EUI in kWh/m^2
-  auto wattsPerHourTokWh = [](double watts) {return watts / 1000.0;};
-
-  for (auto& kv : results) {
-    std::transform(kv.second.begin(), kv.second.end(), kv.second.begin(), wattsPerHourTokWh);
+  auto& results = workspace.endUses;
+  for (auto& column : results) {
+    column.resize(TIMESLICES);
+  }
+  double hourEndUses[HourlyWorkspace::END_USES];
+  for (auto i = 0; i < TIMESLICES; ++i) {
+    convert(i, hourEndUses);
+    for (auto euse = 0; euse < HourlyWorkspace::END_USES; ++euse) {
+      results[euse][i] = hourEndUses[euse];
+    }
   }
 
   if (aggregateByMonth) {
-    // Calculate monthly results
-    for (const auto& kv : results) {
-      results[kv.first] = sumHoursByMonth(kv.second);
+    // Calculate monthly results in place.
+    for (auto& column : results) {
+      sumHoursByMonth(column);
     }
   }
 
-  auto numberOfResults = aggregateByMonth ? 12 : 8760;
+  auto numberOfResults = aggregateByMonth ? 12 : TIMESLICES;
 
   std::vector<EndUses> allResults;
+  allResults.reserve(numberOfResults);
   for (auto i = 0; i < numberOfResults; ++i) {
     EndUses timestepEndUses;
 #ifdef ISOMODEL_STANDALONE
-    auto euse = 0;
-    timestepEndUses.addEndUse(euse++, results["Eelec_ht"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_cl"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_int_lt"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_ext_lt"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_fan"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_pump"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_int_plug"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_ext_plug"][i]);
-    timestepEndUses.addEndUse(euse++, results["Eelec_dhw"][i]);
-    timestepEndUses.addEndUse(euse++, results["Egas_ht"][i]);
-    timestepEndUses.addEndUse(euse++, results["Egas_cl"][i]);
-    timestepEndUses.addEndUse(euse++, results["Egas_plug"][i]);
-    timestepEndUses.addEndUse(euse++, results["Egas_dhw"][i]);
+    for (auto euse = 0; euse < HourlyWorkspace::END_USES; ++euse) {
+      timestepEndUses.addEndUse(euse, results[euse][i]);
+    }
 #else
-    timestepEndUses.addEndUse(results["Eelec_ht"][i], EndUseFuelType::Electricity, EndUseCategoryType::Heating);
-    timestepEndUses.addEndUse(results["Eelec_cl"][i], EndUseFuelType::Electricity, EndUseCategoryType::Cooling);
-    timestepEndUses.addEndUse(results["Eelec_int_lt"][i], EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights);
-    timestepEndUses.addEndUse(results["Eelec_ext_lt"][i], EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights);
-    timestepEndUses.addEndUse(results["Eelec_fan"][i], EndUseFuelType::Electricity, EndUseCategoryType::Fans);
-    timestepEndUses.addEndUse(results["Eelec_pump"][i], EndUseFuelType::Electricity, EndUseCategoryType::Pumps);
-    timestepEndUses.addEndUse(results["Eelec_int_plug"][i], EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment);
-    timestepEndUses.addEndUse(results["Eelec_ext_plug"][i], EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment);
-    timestepEndUses.addEndUse(results["Eelec_dhw"][i], EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems);
-
-    timestepEndUses.addEndUse(results["Egas_ht"][i], EndUseFuelType::Gas, EndUseCategoryType::Heating);
-    timestepEndUses.addEndUse(results["Egas_cl"][i], EndUseFuelType::Gas, EndUseCategoryType::Cooling);
-    timestepEndUses.addEndUse(results["Egas_plug"][i], EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment);
-    timestepEndUses.addEndUse(results["Egas_dhw"][i], EndUseFuelType::Gas, EndUseCategoryType::WaterSystems);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_ht][i], EndUseFuelType::Electricity, EndUseCategoryType::Heating);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_cl][i], EndUseFuelType::Electricity, EndUseCategoryType::Cooling);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_int_lt][i], EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_ext_lt][i], EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_fan][i], EndUseFuelType::Electricity, EndUseCategoryType::Fans);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_pump][i], EndUseFuelType::Electricity, EndUseCategoryType::Pumps);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_int_plug][i], EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_ext_plug][i], EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Eelec_dhw][i], EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems);
+
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Egas_ht][i], EndUseFuelType::Gas, EndUseCategoryType::Heating);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Egas_cl][i], EndUseFuelType::Gas, EndUseCategoryType::Cooling);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Egas_plug][i], EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment);
+    timestepEndUses.addEndUse(results[HourlyWorkspace::Egas_dhw][i], EndUseFuelType::Gas, EndUseCategoryType::WaterSystems);
 #endif
     allResults.push_back(timestepEndUses);
   }
   return allResults;
 }
 
-void HourlyModel::calculateHour(int hourOfYear,
+void HourlyModel::aggregate(HourlyAggregator& aggregator) const
+{
+  HourlyWorkspace workspace;
+  aggregate(plan(), *epwData->hourlyWeather(), workspace, aggregator);
+}
+
+void HourlyModel::aggregate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyAggregator& aggregator)
+{
+  HourlyWorkspace workspace;
+  aggregate(plan, weather, workspace, aggregator);
+}
+
+void HourlyModel::aggregate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyWorkspace& workspace,
+                            HourlyAggregator& aggregator)
+{
+  aggregator.begin(plan);
+  calculateNeeds(plan, weather, workspace.raw);
+  EndUseConversion convert(plan, workspace.raw);
+  double hourEndUses[HourlyWorkspace::END_USES];
+  for (auto i = 0; i < TIMESLICES; ++i) {
+    convert(i, hourEndUses);
+    aggregator.add(i, hourEndUses);
+  }
+}
+
+void HourlyModel::calculateNeeds(const HourlyPlan& plan, const HourlyWeather& weather, HourResults<std::vector<double>>& rawResults)
+{
+  printMatrix("Cooling Setpoint", (double*) plan.coolingSetpointSchedule, 24, 7);
+  printMatrix("Heating Setpoint", (double*) plan.heatingSetpointSchedule, 24, 7);
+  printMatrix("Exterior Equipment", (double*) plan.exteriorEquipmentSchedule, 24, 7);
+  printMatrix("Exterior Lighting", (double*) plan.exteriorLightingSchedule, 24, 7);
+  printMatrix("Interior Equipment", (double*) plan.interiorEquipmentSchedule, 24, 7);
+  printMatrix("Interior Lighting", (double*) plan.interiorLightingSchedule, 24, 7);
+  printMatrix("Ventilation", (double*) plan.ventilationSchedule, 24, 7);
+
+  auto TMT1 = 20.0;
+  auto tiHeatCool = 20.0;
+
+  HourResults<double> tempHourResults;
+  rawResults.Qneed_ht.resize(TIMESLICES);
+  rawResults.Qneed_cl.resize(TIMESLICES);
+  rawResults.Q_illum_tot.resize(TIMESLICES);
+  rawResults.Q_illum_ext_tot.resize(TIMESLICES);
+  rawResults.Qfan_tot.resize(TIMESLICES);
+  rawResults.Qpump_tot.resize(TIMESLICES);
+  rawResults.phi_plug.resize(TIMESLICES);
+  rawResults.externalEquipmentEnergyWperm2.resize(TIMESLICES);
+  rawResults.Q_dhw.resize(TIMESLICES);
+
+  for (auto i = 0; i < TIMESLICES; ++i) {
+    // Check for cancellation every block of 256 hours.
+    if ((i & 255) == 0) {
+      checkCancellation();
+    }
+    calculateHour(plan,
+                  i + 1, //hourOfYear
+                  weather.month[i], //month
+                  weather.dayOfWeek[i], //dayOfWeek
+                  weather.hourOfDay[i], //hourOfDay
+                  weather.wind[i], //windMps
+                  weather.temperature[i], //temperature
+                  &weather.radiation[i * HourlyWeather::SURFACES],
+                  TMT1, //TMT1
+                  tiHeatCool, //tiHeatCool
+                  tempHourResults);
+    // Store each result type in its own vector.
+    rawResults.Qneed_ht[i] = tempHourResults.Qneed_ht;
+    rawResults.Qneed_cl[i] = tempHourResults.Qneed_cl;
+    rawResults.Q_illum_tot[i] = tempHourResults.Q_illum_tot;
+    rawResults.Q_illum_ext_tot[i] = tempHourResults.Q_illum_ext_tot;
+    rawResults.Qfan_tot[i] = tempHourResults.Qfan_tot;
+    rawResults.Qpump_tot[i] = tempHourResults.Qpump_tot;
+    rawResults.phi_plug[i] = tempHourResults.phi_plug;
+    rawResults.externalEquipmentEnergyWperm2[i] = tempHourResults.externalEquipmentEnergyWperm2;
+    rawResults.Q_dhw[i] = tempHourResults.Q_dhw;
+  }
+}
+
+void HourlyModel::calculateHour(const HourlyPlan& plan,
+                              int hourOfYear,
                               int month,
                               int dayOfWeek,
                               int hourOfDay,
                               double windMps,
                               double temperature,
-                              const std::vector<double>& solarRadiation,
+                              const double* solarRadiation,
                               double& TMT1,
                               double& tiHeatCool,
                               HourResults<double>& results)
@@ -202,40 +260,36 @@ void HourlyModel::calculateHour(int hourOfYear,
   // auto scheduleOffset = (dayOfWeek % 7) == 0 ? 7 : dayOfWeek % 7; // ExcelFunctions.printOut("E156",scheduleOffset,1);
   auto scheduleOffset = dayOfWeek;
 
-  // Extract schedules to a function so that we can populate them based on
-  // timeslice instead of fixed schedules.
   // Convert ventilation from L/s to m^3/h and divide by floor area.
-  auto ventExhaustM3phpm2 = ventilationSchedule(hourOfYear, hourOfDay, scheduleOffset) * 3.6 / structure.floorArea(); 
-  auto externalEquipmentPower = exteriorEquipmentSchedule(hourOfYear, hourOfDay, scheduleOffset);
-  auto interiorEquipmentPowerDensity = interiorEquipmentSchedule(hourOfYear, hourOfDay, scheduleOffset); 
-  auto exteriorLightingEnabled = exteriorLightingSchedule(hourOfYear, hourOfDay, scheduleOffset); 
-  auto interiorLightingPowerDensity = interiorLightingSchedule(hourOfYear, hourOfDay, scheduleOffset);
-  auto actualHeatingSetpoint = heatingSetpointSchedule(hourOfYear, hourOfDay, scheduleOffset);
-  auto actualCoolingSetpoint = coolingSetpointSchedule(hourOfYear, hourOfDay, scheduleOffset);
+  auto ventExhaustM3phpm2 = plan.ventilationSchedule[hourOfDay][scheduleOffset] * 3.6 / plan.floorArea;
+  auto externalEquipmentPower = plan.exteriorEquipmentSchedule[hourOfDay][scheduleOffset];
+  auto interiorEquipmentPowerDensity = plan.interiorEquipmentSchedule[hourOfDay][scheduleOffset];
+  auto exteriorLightingEnabled = plan.exteriorLightingSchedule[hourOfDay][scheduleOffset];
+  auto interiorLightingPowerDensity = plan.interiorLightingSchedule[hourOfDay][scheduleOffset];
+  auto actualHeatingSetpoint = plan.heatingSetpointSchedule[hourOfDay][scheduleOffset];
+  auto actualCoolingSetpoint = plan.coolingSetpointSchedule[hourOfDay][scheduleOffset];
 
-  results.externalEquipmentEnergyWperm2 = externalEquipmentPower / structure.floorArea();
+  results.externalEquipmentEnergyWperm2 = externalEquipmentPower / plan.floorArea;
 
   // \Phi_{int,A}, ISO 13790 10.4.2.
   // Monthly name: phi_plug_occ and phi_plug_unocc.
   results.phi_plug = interiorEquipmentPowerDensity;
 
-  std::vector<double> lightingContribution;
+  auto lightingLevel = 0.0;
   for (auto i = 0; i != 9; ++i) {
-    lightingContribution.push_back(53 / areaNaturallyLightedRatio * solarRadiation[i]
-        * (naturalLightRatio[i] + shadingUsePerWPerM2 * naturalLightShadeRatioReduction[i] * std::min(structure.irradianceForMaxShadingUse(), solarRadiation[i])));
+    lightingLevel += 53 / plan.areaNaturallyLightedRatio * solarRadiation[i]
+        * (plan.naturalLightRatio[i] + plan.shadingUsePerWPerM2 * plan.naturalLightShadeRatioReduction[i] * std::min(plan.irradianceForMaxShadingUse, solarRadiation[i]));
   }
-
-  auto lightingLevel = std::accumulate(std::begin(lightingContribution), std::end(lightingContribution), 0.0);
-  auto electricForNaturalLightArea = std::max(0.0, maxRatioElectricLighting * (1 - lightingLevel / elightNatural));
-  auto electricForTotalLightArea = electricForNaturalLightArea * areaNaturallyLightedRatio
-         + (1 - areaNaturallyLightedRatio) * maxRatioElectricLighting;
+  auto electricForNaturalLightArea = std::max(0.0, plan.maxRatioElectricLighting * (1 - lightingLevel / plan.elightNatural));
+  auto electricForTotalLightArea = electricForNaturalLightArea * plan.areaNaturallyLightedRatio
+         + (1 - plan.areaNaturallyLightedRatio) * plan.maxRatioElectricLighting;
 
   // Heat produced by lighting.
   // \Phi_{int,L}, ISO 13790 10.4.3. 
   // Monthly name: phi_illum_occ, phi_illum_unocc
-  auto phi_illum = electricForTotalLightArea * interiorLightingPowerDensity * lights.elecInternalGains();
+  auto phi_illum = electricForTotalLightArea * interiorLightingPowerDensity * plan.elecInternalGains;
 
-  // TODO: lights.permLightPowerDensity() is unused.
+  // TODO: lights->permLightPowerDensity() is unused.
 
   results.Q_illum_tot = electricForTotalLightArea * interiorLightingPowerDensity;
 
@@ -246,17 +300,15 @@ void HourlyModel::calculateHour(int hourOfYear,
   // \Phi_{sol,k}, ISO 13790 11.3.2 eq. 43. 
   // Note: method of calculating A_{sol,k} with movable shading differs from
   // the method in the standard.
-  std::vector<double> solarHeatGain;
+  // \Phi_{sol}, ISO 13790 11.2.2 eq. 41.
+  auto qSolarHeatGain = 0.0;
   for (auto i = 0; i != 9; ++i) {
-    solarHeatGain.push_back(
-      solarRadiation[i] * (solarRatio[i] + solarShadeRatioReduction[i] * shadingUsePerWPerM2 * std::min(solarRadiation[i], structure.irradianceForMaxShadingUse())));
+    qSolarHeatGain += solarRadiation[i] * (plan.solarRatio[i] + plan.solarShadeRatioReduction[i] * plan.shadingUsePerWPerM2
+        * std::min(solarRadiation[i], plan.irradianceForMaxShadingUse));
   }
-
-  // \Phi_{sol}, ISO 13790 11.2.2 eq. 41.
-  auto qSolarHeatGain = std::accumulate(std::begin(solarHeatGain), std::end(solarHeatGain), 0.0);
   // \Phi_{ia}, ISO 13790 C.2 eq. C.1. 
   // (Note that solarPair = 0 and intPair = 0.5).
-  auto phii = simSettings.phiSolFractionToAirNode() * qSolarHeatGain + simSettings.phiIntFractionToAirNode() * phi_int;
+  auto phii = plan.phiSolFractionToAirNode * qSolarHeatGain + plan.phiIntFractionToAirNode * phi_int;
   // \Phi_{ia10}, ISO 13790 C.4.2. 
   // Used to calculate \theta_{air,ac} when available heating or cooling power
   // is insufficient to achieve the setpoint. Adding 10 is equivalent to
@@ -265,13 +317,13 @@ void HourlyModel::calculateHour(int hourOfYear,
   auto phii10 = phii + 10;
   
   // Ventilation from wind. ISO 15242.
-  auto qSupplyBySystem = ventExhaustM3phpm2 * windImpactSupplyRatio;
+  auto qSupplyBySystem = ventExhaustM3phpm2 * plan.windImpactSupplyRatio;
   auto exhaustSupply = -(qSupplyBySystem - ventExhaustM3phpm2); // ISO 15242 q_{v-diff}.
-  auto tAfterExchange = (1 - ventilation.heatRecoveryEfficiency()) * temperature + ventilation.heatRecoveryEfficiency() * 20;
-  auto tSuppliedAir = std::max(ventilation.ventPreheatDegC(), tAfterExchange);
+  auto tAfterExchange = (1 - plan.heatRecoveryEfficiency) * temperature + plan.heatRecoveryEfficiency * 20;
+  auto tSuppliedAir = std::max(plan.ventPreheatDegC, tAfterExchange);
   // ISO 15242 6.7.1 Step 1.
-  auto qWind = 0.0769 * q4Pa * std::pow((ventilation.dCp() * windMps * windMps), 0.667);
-  auto qStackPrevIntTemp = 0.0146 * q4Pa * std::pow((0.5 * windImpactHz * (std::max(0.00001, fabs(temperature - tiHeatCool)))), 0.667);
+  auto qWind = 0.0769 * plan.q4Pa * std::pow((plan.dCp * windMps * windMps), 0.667);
+  auto qStackPrevIntTemp = 0.0146 * plan.q4Pa * std::pow((0.5 * plan.windImpactHz * (std::max(0.00001, fabs(temperature - tiHeatCool)))), 0.667);
   // ISO 15242 6.7.1 Step 2.
   auto qExfiltration = std::max(0.0,
       std::max(qStackPrevIntTemp, qWind) - fabs(exhaustSupply) * (0.5 * qStackPrevIntTemp + 0.667 * (qWind) / (qStackPrevIntTemp + qWind)));
@@ -285,9 +337,9 @@ void HourlyModel::calculateHour(int hourOfYear,
   // what the 0.34 is.
   auto hei = 0.34 * qEnteringTotal;
   // H_{tr,1}, ISO 13790 C.3 eq. C.6.
-  auto h1 = 1 / (1 / hei + 1 / H_tris);
+  auto h1 = 1 / (1 / hei + 1 / plan.H_tris);
   // H_{tr,2}, ISO 13790 C.3 eq. C.7.
-  auto h2 = h1 + hwindowWperkm2;
+  auto h2 = h1 + plan.hwindowWperkm2;
   //ExcelFunctions.printOut("h2",h2,0.726440377838674);
 
   // Subscript '0' indicates the free-floating condition and sub '10' indicates
@@ -298,29 +350,29 @@ void HourlyModel::calculateHour(int hourOfYear,
 
   // \Phi_{st}, ISO 13790 C.2 eq. C.3 
   // In generalized form from Georgia Tech spreadsheet.
-  auto phisPhi0 = prsSolar * qSolarHeatGain + prsInterior * phi_int;
+  auto phisPhi0 = plan.prsSolar * qSolarHeatGain + plan.prsInterior * phi_int;
   // \Phi_{m}, ISO 13790 C.2 eq. C.2.
   // In generalized form from Georgia Tech spreadsheet.
-  auto phimPhi0 = prmSolar * qSolarHeatGain + prmInterior * phi_int;
+  auto phimPhi0 = plan.prmSolar * qSolarHeatGain + plan.prmInterior * phi_int;
   // H_{tr,3}, ISO 13790 C.3 eq. C.9.
-  auto h3 = 1 / (1 / h2 + 1 / H_ms);
+  auto h3 = 1 / (1 / h2 + 1 / plan.H_ms);
   // \Phi_{mtot}, ISO 13790 C.3 eq. C.5.
-  auto phimTotalPhi10 = phimPhi0 + hem * temperature
-       + h3 * (phisPhi0 + hwindowWperkm2 * temperature + h1 * (phii10 / hei + tEnteringAndSupplied)) / h2;
-  auto phimTotalPhi0 = phimPhi0 + hem * temperature
-       + h3 * (phisPhi0 + hwindowWperkm2 * temperature + h1 * (phii / hei + tEnteringAndSupplied)) / h2;
+  auto phimTotalPhi10 = phimPhi0 + plan.hem * temperature
+       + h3 * (phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (phii10 / hei + tEnteringAndSupplied)) / h2;
+  auto phimTotalPhi0 = phimPhi0 + plan.hem * temperature
+       + h3 * (phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (phii / hei + tEnteringAndSupplied)) / h2;
       // \theta_{m,t10}, ISO 13790 C.3 eq. C.4.
-  auto tmt1Phi10 = (TMT1 * (Cm / 3.6 - 0.5 * (h3 + hem)) + phimTotalPhi10) / (Cm / 3.6 + 0.5 * (h3 + hem));
+  auto tmt1Phi10 = (TMT1 * (plan.Cm / 3.6 - 0.5 * (h3 + plan.hem)) + phimTotalPhi10) / (plan.Cm / 3.6 + 0.5 * (h3 + plan.hem));
   auto tmPhi10 = 0.5 * (TMT1 + tmt1Phi10);
-  auto tsPhi10 = (H_ms * tmPhi10 + phisPhi0 + hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phii10 / hei))
-       / (H_ms + hwindowWperkm2 + h1);
+  auto tsPhi10 = (plan.H_ms * tmPhi10 + phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phii10 / hei))
+       / (plan.H_ms + plan.hwindowWperkm2 + h1);
   //ExcelFunctions.printOut("BA156",tsPhi10,19.8762155145252);
-  auto tiPhi10 = (H_tris * tsPhi10 + hei * tEnteringAndSupplied + phii10) / (H_tris + hei);
+  auto tiPhi10 = (plan.H_tris * tsPhi10 + hei * tEnteringAndSupplied + phii10) / (plan.H_tris + hei);
   // \theta_{m,t}, ISO 13790 C.3 eq. C.4.
-  auto tmt1Phi0 = (TMT1 * (Cm / 3.6 - 0.5 * (h3 + hem)) + phimTotalPhi0) / (Cm / 3.6 + 0.5 * (h3 + hem));
+  auto tmt1Phi0 = (TMT1 * (plan.Cm / 3.6 - 0.5 * (h3 + plan.hem)) + phimTotalPhi0) / (plan.Cm / 3.6 + 0.5 * (h3 + plan.hem));
   auto tmPhi0 = 0.5 * (TMT1 + tmt1Phi0);
-  auto tsPhi0 = (H_ms * tmPhi0 + phisPhi0 + hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phii / hei)) / (H_ms + hwindowWperkm2 + h1);
-  auto tiPhi0 = (H_tris * tsPhi0 + hei * tEnteringAndSupplied + phii) / (H_tris + hei);
+  auto tsPhi0 = (plan.H_ms * tmPhi0 + phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phii / hei)) / (plan.H_ms + plan.hwindowWperkm2 + h1);
+  auto tiPhi0 = (plan.H_tris * tsPhi0 + hei * tEnteringAndSupplied + phii) / (plan.H_tris + hei);
   auto phiCooling = 10 * (actualCoolingSetpoint - tiPhi0) / (tiPhi10 - tiPhi0);
   auto phiHeating = 10 * (actualHeatingSetpoint - tiPhi0) / (tiPhi10 - tiPhi0);
   auto phiActual = std::max(0.0, phiHeating) + std::min(phiCooling, 0.0);
@@ -328,25 +380,25 @@ void HourlyModel::calculateHour(int hourOfYear,
   results.Qneed_ht = std::max(0.0, phiActual); // Raw need. Not adjusted for efficiency.
   
   // Fan power
-  auto T_sup_ht = heating.temperatureSetPointOccupied() + heating.dT_supp_ht(); //%hot air supply temp  - assume supply air is 7C hotter than room
-  auto T_sup_cl = cooling.temperatureSetPointOccupied() - cooling.dT_supp_cl(); //%cool air supply temp - assume 7C lower than room
+  auto T_sup_ht = plan.heatingSupplyTemperature;
+  auto T_sup_cl = plan.coolingSupplyTemperature;
 
   // XXX In the unlikely event that (T_sup_ht - TMT1) * n_rhoC_a was equal to -DBL_MIN, would this divide by zero? - BAA@2015-02-18.
-  auto Vair_ht = heating.forcedAirHeating() ? results.Qneed_ht / (((T_sup_ht - tiHeatCool) * phys.rhoCpAir()*277.777778) + DBL_MIN) : 0.0;
-  auto Vair_cl = cooling.forcedAirCooling() ? results.Qneed_cl / (((tiHeatCool - T_sup_cl) * phys.rhoCpAir()*277.777778) + DBL_MIN) : 0.0;
+  auto Vair_ht = plan.forcedAirHeating ? results.Qneed_ht / (((T_sup_ht - tiHeatCool) * plan.rhoCpAir*277.777778) + DBL_MIN) : 0.0;
+  auto Vair_cl = plan.forcedAirCooling ? results.Qneed_cl / (((tiHeatCool - T_sup_cl) * plan.rhoCpAir*277.777778) + DBL_MIN) : 0.0;
 
   auto Vair_tot = std::max((Vair_ht + Vair_cl), ventExhaustM3phpm2);
 
   // Calculate fan energy in W/m2. Air volumes in m3/h/m2, fan power in W/(L/s). Convert with (m^3 / 1000 L) * (3600 s / h)
-  results.Qfan_tot = Vair_tot * ventilation.fanPower() * 1000.0 / 3600.0;
+  results.Qfan_tot = Vair_tot * plan.fanPower * 1000.0 / 3600.0;
 
   // Determine pump energy by using the fixed pump power of .25 W/m2 if the heating
   // or cooling system is active, 0.0 if not. The .25 W/m2 comes from the monthly
   // pump calculations.
   if (results.Qneed_cl > 0.0) {
-    results.Qpump_tot = cooling.E_pumps() * cooling.pumpControlReduction();
+    results.Qpump_tot = plan.coolingPumpPower;
   } else if (results.Qneed_ht > 0.0) {
-    results.Qpump_tot = heating.E_pumps() * heating.pumpControlReduction();
+    results.Qpump_tot = plan.heatingPumpPower;
   } else {
     results.Qpump_tot = 0.0;
   }
@@ -354,7 +406,7 @@ void HourlyModel::calculateHour(int hourOfYear,
   if (solarRadiation[8] > 0) { // Check roof radiation to see if sun is up.
     results.Q_illum_ext_tot = 0; // No exterior lights during the day.
   } else {
-    results.Q_illum_ext_tot = lights.exteriorEnergy() * exteriorLightingEnabled / structure.floorArea();
+    results.Q_illum_ext_tot = plan.exteriorLightingEnergy * exteriorLightingEnabled / plan.floorArea;
     //ExcelFunctions.printOut("CS156",exteriorLightingEnergyWperm2,0.0539503346043362);
   }
 
@@ -365,91 +417,136 @@ void HourlyModel::calculateHour(int hourOfYear,
   // hour.
   auto phiiHeatCool = phiActual + phii;
   // \Phi_{mtot} ISO 13790 C.3 eq. C.5
-  auto phimHeatCoolTotal = phimPhi0 + hem * temperature
-       + h3 * (phisPhi0 + hwindowWperkm2 * temperature + h1 * (phiiHeatCool / hei + tEnteringAndSupplied)) / h2;
+  auto phimHeatCoolTotal = phimPhi0 + plan.hem * temperature
+       + h3 * (phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (phiiHeatCool / hei + tEnteringAndSupplied)) / h2;
   // Set tmt to this hour's \theta_{m,t-1}.
   auto tmt = TMT1;
   // \theta_{m,t}, ISO 13790 C.3 eq. C.4.
   // Set TMT1 to next hour's \theta_{m,t-1} (this hour's \theta_{m,t}).
-  TMT1 = (TMT1 * (Cm / 3.6 - 0.5 * (h3 + hem)) + phimHeatCoolTotal) / (Cm / 3.6 + 0.5 * (h3 + hem));
+  TMT1 = (TMT1 * (plan.Cm / 3.6 - 0.5 * (h3 + plan.hem)) + phimHeatCoolTotal) / (plan.Cm / 3.6 + 0.5 * (h3 + plan.hem));
   // \theta_{m}, ISO 13790 C.3 eq. C.9.
   auto tmHeatCool = 0.5 * (TMT1 + tmt);
   // \theta_{s}, ISO 13790 C.3 eq. C.10.
-  auto tsHeatCool = (H_ms * tmHeatCool + phisPhi0 + hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phiiHeatCool / hei))
-                    / (H_ms + hwindowWperkm2 + h1);
+  auto tsHeatCool = (plan.H_ms * tmHeatCool + phisPhi0 + plan.hwindowWperkm2 * temperature + h1 * (tEnteringAndSupplied + phiiHeatCool / hei))
+                    / (plan.H_ms + plan.hwindowWperkm2 + h1);
   // \theta_{air}, ISO 13790, C.3 eq. C.11.
-  tiHeatCool = (H_tris * tsHeatCool + hei * tEnteringAndSupplied + phiiHeatCool) / (H_tris + hei);
+  tiHeatCool = (plan.H_tris * tsHeatCool + hei * tEnteringAndSupplied + phiiHeatCool) / (plan.H_tris + hei);
 
 }
 
 
-void HourlyModel::initialize()
+HourlyPlan HourlyModel::plan() const
 {
+  HourlyPlan plan;
+
+  // Schedules.
+  auto dayStart = (int) pop->daysStart();
+  auto dayEnd = (int) pop->daysEnd();
+  auto hourStart = (int) pop->hoursStart();
+  auto hourEnd = (int) pop->hoursEnd();
+
+  bool hoccupied, doccupied, popoccupied;
+  for (auto h = 0; h < 24; ++h) {
+    hoccupied = h >= hourStart && h <= hourEnd;
+    for (auto d = 0; d < 7; ++d) {
+      doccupied = (d >= dayStart && d <= dayEnd);
+      popoccupied = hoccupied && doccupied;
+      plan.occupied[h][d] = popoccupied;
+
+      plan.ventilationSchedule[h][d] = hoccupied ? ventilation->supplyRate() : 0.0;
+
+      // TODO: Add externalEquipment occ and unocc. BAA@2015-07-15.
+      plan.exteriorEquipmentSchedule[h][d] = building->externalEquipment();
+
+      plan.interiorEquipmentSchedule[h][d] = popoccupied ? building->electricApplianceHeatGainOccupied() : building->electricApplianceHeatGainUnoccupied();
+
+      // TODO: Determine if the exterior lights should be on or not here. BAA@2015-07-15.
+      plan.exteriorLightingSchedule[h][d] = 1; // in calculateHour, the lights are only turned on when the sun is down.
+
+      plan.interiorLightingSchedule[h][d] = popoccupied ? lights->powerDensityOccupied() : lights->powerDensityUnoccupied();
+
+      plan.heatingSetpointSchedule[h][d] = popoccupied ? heating->temperatureSetPointOccupied() : heating->temperatureSetPointUnoccupied();
+
+      plan.coolingSetpointSchedule[h][d] = popoccupied ? cooling->temperatureSetPointOccupied() : cooling->temperatureSetPointUnoccupied();
+    }
+  }
 
   // TODO BAA@2014-12-22: This is still pretty rough and needs ought to be confirmed to be working correctly.
-  auto lightingOccupancySensorDimmingFraction = building.lightingOccupancySensor();
-  auto daylightSensorDimmingFraction = lights.dimmingFraction();
+  auto lightingOccupancySensorDimmingFraction = building->lightingOccupancySensor();
+  auto daylightSensorDimmingFraction = lights->dimmingFraction();
 
   if (lightingOccupancySensorDimmingFraction < 1.0 && daylightSensorDimmingFraction < 1.0) {
-    maxRatioElectricLighting = lights.presenceAutoAd();
-    elightNatural = lights.presenceAutoLux();
+    plan.maxRatioElectricLighting = lights->presenceAutoAd();
+    plan.elightNatural = lights->presenceAutoLux();
   } else if (lightingOccupancySensorDimmingFraction < 1.0) {
-    maxRatioElectricLighting = lights.presenceSensorAd();
-    elightNatural = lights.presenceSensorLux();
+    plan.maxRatioElectricLighting = lights->presenceSensorAd();
+    plan.elightNatural = lights->presenceSensorLux();
   } else if (daylightSensorDimmingFraction < 1.0) {
-    maxRatioElectricLighting = lights.automaticAd();
-    elightNatural = lights.automaticLux();
+    plan.maxRatioElectricLighting = lights->automaticAd();
+    plan.elightNatural = lights->automaticLux();
   } else {
-    maxRatioElectricLighting = lights.manualSwitchAd();
-    elightNatural = lights.manualSwitchLux();
+    plan.maxRatioElectricLighting = lights->manualSwitchAd();
+    plan.elightNatural = lights->manualSwitchLux();
   }
 
-  areaNaturallyLighted = std::max(0.0001, lights.naturallyLightedArea());
-  areaNaturallyLightedRatio = areaNaturallyLighted / structure.floorArea();
+  auto floorArea = structure->floorArea();
+  auto areaNaturallyLighted = std::max(0.0001, lights->naturallyLightedArea());
+  plan.areaNaturallyLightedRatio = areaNaturallyLighted / floorArea;
 
+  // Calculated surface values.
+  double htot[9];
+  double hWindow[9];
   for (auto i = 0; i != 9; ++i) {
-    structureCalculations(structure.windowShadingDevice()[i],
-                          structure.wallArea()[i],
-                          structure.windowArea()[i],
-                          structure.wallUniform()[i],
-                          structure.windowUniform()[i],
-                          structure.wallSolarAbsorption()[i],
-                          structure.windowShadingCorrectionFactor()[i],
-                          structure.windowNormalIncidenceSolarEnergyTransmittance()[i],
-                          i);
-
-    nlaWMovableShading.push_back(nlams[i] / structure.floorArea());
-    naturalLightRatio.push_back(nla[i] / structure.floorArea());
-    naturalLightShadeRatioReduction.push_back(nlaWMovableShading[i] - naturalLightRatio[i]);
-
-    saWMovableShading.push_back(sams[i] / structure.floorArea());
-    solarRatio.push_back(sa[i] / structure.floorArea());
-    solarShadeRatioReduction.push_back(saWMovableShading[i] - solarRatio[i]);
+    double wallAreaM2 = structure->wallArea()[i];
+    double windowAreaM2 = structure->windowArea()[i];
+    double wallUValue = structure->wallUniform()[i];
+    double windowUValue = structure->windowUniform()[i];
+    double wallSolarAbsorption = structure->wallSolarAbsorption()[i];
+    double solarFactorWith = structure->windowShadingCorrectionFactor()[i];
+    double solarFactorWithout = structure->windowNormalIncidenceSolarEnergyTransmittance()[i];
+
+    double WindowT = structure->windowShadingDevice()[i] / 0.87;
+    double nlams = windowAreaM2 * WindowT; // Natural lighted area movable shade.
+    double nla = windowAreaM2 * WindowT; // Natural lighted area.
+    double sams = wallAreaM2 * (wallSolarAbsorption * wallUValue * structure->R_se()) + windowAreaM2 * solarFactorWith; // ISO13790 11.3.4
+    double sa = wallAreaM2 * (wallSolarAbsorption * wallUValue * structure->R_se()) + windowAreaM2 * solarFactorWithout; // ISO13790 11.3.4
+    htot[i] = wallAreaM2 * wallUValue + windowAreaM2 * windowUValue;
+    hWindow[i] = windowAreaM2 * windowUValue;
+
+    double nlaWMovableShading = nlams / floorArea;
+    plan.naturalLightRatio[i] = nla / floorArea;
+    plan.naturalLightShadeRatioReduction[i] = nlaWMovableShading - plan.naturalLightRatio[i];
+
+    double saWMovableShading = sams / floorArea;
+    plan.solarRatio[i] = sa / floorArea;
+    plan.solarShadeRatioReduction[i] = saWMovableShading - plan.solarRatio[i];
   }
 
-  shadingUsePerWPerM2 = structure.shadingFactorAtMaxUse() / structure.irradianceForMaxShadingUse();
+  plan.shadingUsePerWPerM2 = structure->shadingFactorAtMaxUse() / structure->irradianceForMaxShadingUse();
 
   // ISO 15242 Air leakage values.
   // Total air leakage at 4Pa in m3/hr. ISO 15242 Annex D Table D.1.
-  auto buildingv8 = 0.19 * (ventilation.n50() * (structure.floorArea() * structure.buildingHeight()));
+  auto buildingv8 = 0.19 * (ventilation->n50() * (floorArea * structure->buildingHeight()));
   // Air leakage per area at 4Pa (m3/hr/m2).
-  q4Pa = std::max(0.000001, buildingv8 / structure.floorArea());
+  plan.q4Pa = std::max(0.000001, buildingv8 / floorArea);
 
   // ISO 13790 12.2.2: h_ms is fixed at 9.1 W/(m^2*K).
-  h_ms = simSettings.hci() + simSettings.hri() * 1.2; 
+  auto h_ms = simSettings->hci() + simSettings->hri() * 1.2;
   // ISO 13790 7.2.2.2: h_is is fixed at 3.45 W/(m^2*K).
-  h_is = 1 / (1 / simSettings.hci() - 1 / h_ms);
+  auto h_is = 1 / (1 / simSettings->hci() - 1 / h_ms);
   // ISO 13790 7.2.2.2 eq. 9 
-  H_tris = h_is * structure.totalAreaPerFloorArea();
+  plan.H_tris = h_is * structure->totalAreaPerFloorArea();
 
   // Calculate Cm from the data in the .ism file.
   // Units seem to need to be in KJ, so divide by 1000.
-  auto Cm_int = structure.interiorHeatCapacity() / 1000.0;
+  auto Cm_int = structure->interiorHeatCapacity() / 1000.0;
   // Convert env Cm to per floor area.
-  auto Cm_env = (structure.wallHeatCapacity() * sum(structure.wallArea()) / structure.floorArea()) / 1000.0;
-  Cm = Cm_int + Cm_env;
+  auto Cm_env = (structure->wallHeatCapacity() * sum(structure->wallArea()) / floorArea) / 1000.0;
+  auto Cm = Cm_int + Cm_env;
+  plan.Cm = Cm;
 
   // Calculate Am based the Cm value and the default values in ISO 13790 12.3.1.2 Table 12.
+  double Am;
   if (Cm > 370.0) {
     Am = 3.5;
   } else if (Cm > 260.0) {
@@ -469,84 +566,65 @@ void HourlyModel::initialize()
     hWind += hWindow[i];
     hWall += htot[i] - hWindow[i];
   }
-  hwindowWperkm2 = hWind / structure.floorArea();
+  plan.hwindowWperkm2 = hWind / floorArea;
+
+  // \Phi_{st} and \Phi_{m} are calculated differently than in ISO 13790 to
+  // allow variation in the values that factor the amount of interior and solar
+  // heat gain that heats the air.
 
   // Constant portion of \Phi_{st}, i.e. without multiplying by
   // (.5*\Phi_{int} + \Phi_{sol}).  ISO 13790 C.2 eq. C.3.
-  prs = (structure.totalAreaPerFloorArea() - Am - hwindowWperkm2 / h_ms) / structure.totalAreaPerFloorArea();
+  auto prs = (structure->totalAreaPerFloorArea() - Am - plan.hwindowWperkm2 / h_ms) / structure->totalAreaPerFloorArea();
   // intPair = 0.5, this ends up providing the ".5" in ".5*\Phi_{int}" in
   // eq. C.3. When used in phisPhi0.
-  prsInterior = (1 - simSettings.phiIntFractionToAirNode()) * prs;
-  prsSolar = (1 - simSettings.phiSolFractionToAirNode()) * prs;
+  plan.prsInterior = (1 - simSettings->phiIntFractionToAirNode()) * prs;
+  plan.prsSolar = (1 - simSettings->phiSolFractionToAirNode()) * prs;
 
   // Constant portion of \Phi_{m}, i.e. without multiplying by
   // (.5*\Phi_{int} + \Phi_{sol}).  ISO 13790 C.2 eq. C.2.
-  prm = Am / structure.totalAreaPerFloorArea();
-  prmInterior = (1 - simSettings.phiIntFractionToAirNode()) * prm;
-  prmSolar = (1 - simSettings.phiSolFractionToAirNode()) * prm;
+  auto prm = Am / structure->totalAreaPerFloorArea();
+  plan.prmInterior = (1 - simSettings->phiIntFractionToAirNode()) * prm;
+  plan.prmSolar = (1 - simSettings->phiSolFractionToAirNode()) * prm;
 
   // ISO 13790 12.2.2 eq. 64
-  H_ms = h_ms * Am;
+  plan.H_ms = h_ms * Am;
 
-  hOpaqueWperkm2 = std::max(hWall / structure.floorArea(), 0.000001);
+  auto hOpaqueWperkm2 = std::max(hWall / floorArea, 0.000001);
 
   // ISO 13790 12.2.2 eq. 63
-  hem = 1 / (1 / hOpaqueWperkm2 - 1 / H_ms);
-
-  windImpactHz = std::max(0.1, ventilation.hzone());
-  windImpactSupplyRatio = std::max(0.00001, ventilation.fanControlFactor()); //TODO ventSupplyExhaustRatio = SingleBuilding.P40 ?
-}
-
-void HourlyModel::populateSchedules()
-{
-  auto dayStart = (int) pop.daysStart();
-  auto dayEnd = (int) pop.daysEnd();
-  auto hourStart = (int) pop.hoursStart();
-  auto hourEnd = (int) pop.hoursEnd();
-
-  bool hoccupied, doccupied, popoccupied;
-  for (auto h = 0; h < 24; ++h) {
-    hoccupied = h >= hourStart && h <= hourEnd;
-    for (auto d = 0; d < 7; ++d) {
-      doccupied = (d >= dayStart && d <= dayEnd);
-      popoccupied = hoccupied && doccupied;
-
-      fixedVentilationSchedule[h][d] = hoccupied ? ventilation.supplyRate() : 0.0;
-
-      // TODO: Add externalEquipment occ and unocc. BAA@2015-07-15.
-      fixedExteriorEquipmentSchedule[h][d] = building.externalEquipment();
-
-      fixedInteriorEquipmentSchedule[h][d] = popoccupied ? building.electricApplianceHeatGainOccupied() : building.electricApplianceHeatGainUnoccupied();
-
-      // TODO: Determine if the exterior lights should be on or not here. BAA@2015-07-15.
-      fixedExteriorLightingSchedule[h][d] = 1; // in calculateHour, the lights are only turned on when the sun is down.
-
-      fixedInteriorLightingSchedule[h][d] = popoccupied ? lights.powerDensityOccupied() : lights.powerDensityUnoccupied();
-
-      fixedActualHeatingSetpoint[h][d] = popoccupied ? heating.temperatureSetPointOccupied() : heating.temperatureSetPointUnoccupied();
-
-      fixedActualCoolingSetpoint[h][d] = popoccupied ? cooling.temperatureSetPointOccupied() : cooling.temperatureSetPointUnoccupied();
-    }
-  }
-}
-
-void HourlyModel::structureCalculations(double SHGC,
-                           double wallAreaM2,
-                           double windowAreaM2,
-                           double wallUValue,
-                           double windowUValue,
-                           double wallSolarAbsorption,
-                           double solarFactorWith,
-                           double solarFactorWithout,
-                           int direction)
-{
-  double WindowT = SHGC / 0.87;
-  nlams[direction] = windowAreaM2 * WindowT; // Natural lighted area movable shade.
-  nla[direction] = windowAreaM2 * WindowT; // Natural lighted area.
-  sams[direction] = wallAreaM2 * (wallSolarAbsorption * wallUValue * structure.R_se()) + windowAreaM2 * solarFactorWith;
-  sa[direction] = wallAreaM2 * (wallSolarAbsorption * wallUValue * structure.R_se()) + windowAreaM2 * solarFactorWithout;
-  htot[direction] = wallAreaM2 * wallUValue + windowAreaM2 * windowUValue;
-  hWindow[direction] = windowAreaM2 * windowUValue;
+  plan.hem = 1 / (1 / hOpaqueWperkm2 - 1 / plan.H_ms);
+
+  plan.windImpactHz = std::max(0.1, ventilation->hzone());
+  plan.windImpactSupplyRatio = std::max(0.00001, ventilation->fanControlFactor()); //TODO ventSupplyExhaustRatio = SingleBuilding.P40 ?
+
+  // Component values used each hour.
+  plan.floorArea = floorArea;
+  plan.elecInternalGains = lights->elecInternalGains();
+  plan.exteriorLightingEnergy = lights->exteriorEnergy();
+  plan.irradianceForMaxShadingUse = structure->irradianceForMaxShadingUse();
+  plan.phiSolFractionToAirNode = simSettings->phiSolFractionToAirNode();
+  plan.phiIntFractionToAirNode = simSettings->phiIntFractionToAirNode();
+  plan.heatRecoveryEfficiency = ventilation->heatRecoveryEfficiency();
+  plan.ventPreheatDegC = ventilation->ventPreheatDegC();
+  plan.dCp = ventilation->dCp();
+  plan.fanPower = ventilation->fanPower();
+  plan.heatingSupplyTemperature = heating->temperatureSetPointOccupied() + heating->dT_supp_ht(); //%hot air supply temp  - assume supply air is 7C hotter than room
+  plan.coolingSupplyTemperature = cooling->temperatureSetPointOccupied() - cooling->dT_supp_cl(); //%cool air supply temp - assume 7C lower than room
+  plan.forcedAirHeating = heating->forcedAirHeating();
+  plan.forcedAirCooling = cooling->forcedAirCooling();
+  plan.rhoCpAir = phys->rhoCpAir();
+  // The pumps use a fixed power when the heating or cooling system is active.
+  plan.heatingPumpPower = heating->E_pumps() * heating->pumpControlReduction();
+  plan.coolingPumpPower = cooling->E_pumps() * cooling->pumpControlReduction();
+
+  // Distribution and generation efficiencies applied to the yearly results.
+  plan.heatingLossFactor = heating->hvacLossFactor();
+  plan.coolingLossFactor = cooling->hvacLossFactor();
+  plan.hotcoldWasteFactor = heating->hotcoldWasteFactor();
+  plan.heatingEfficiency = heating->efficiency();
+  plan.coolingCop = cooling->cop();
+  plan.heatingEnergyType = heating->energyType();
+  return plan;
 }
 
 // TODO BAA@2015-01-28 Is there a better place to keep these debug functions?
@@ -569,18 +647,17 @@ void printMatrix(const char* matName, double* mat, unsigned int dim1, unsigned i
   }
 }
 
-std::vector<double> HourlyModel::sumHoursByMonth(const std::vector<double>& hourlyData)
+void HourlyModel::sumHoursByMonth(std::vector<double>& data)
 {
-  std::vector<double> monthlyData(12);
-  std::vector<int> monthsInHours = { 0, 744, 1416, 2160, 2880, 3624, 4344, 5088, 5832, 6552, 7296, 8016, 8760 };
+  static const int monthsInHours[] = { 0, 744, 1416, 2160, 2880, 3624, 4344, 5088, 5832, 6552, 7296, 8016, 8760 };
 
+  // Month m starts at or after hour m, so the sums can be written over the hourly values.
   for (int month = 0; month < 12; ++month) {
-    monthlyData[month] = std::accumulate(hourlyData.begin() + monthsInHours[month],
-                                         hourlyData.begin() + monthsInHours[month + 1],
-                                         0.0);
+    data[month] = std::accumulate(data.begin() + monthsInHours[month],
+                                  data.begin() + monthsInHours[month + 1],
+                                  0.0);
   }
-
-  return monthlyData;
+  data.resize(12);
 }
 
 // TODO: I don't think this is used. Confirm and delete it. BAA@2015-08-04.
@@ -14,6 +14,7 @@
 #include "Simulation.hpp"
 #include "TimeFrame.hpp"
 #include "MonthlyModel.hpp"
+#include "SimulationPlan.hpp"
 
 #include <memory>
 #include <map>
@@ -36,6 +37,8 @@
 namespace openstudio {
 namespace isomodel {
 
+class HourlyAggregator;
+
 // Struct to hold the results of each hour and the vector of results of all the hours.
 template<typename T>
 struct HourResults
@@ -51,6 +54,38 @@ struct HourResults
   T Q_dhw;
 };
 
+/**
+ * Scratch space of HourlyModel::simulate. Passing the same workspace to repeated
+ * simulations reuses its buffers rather than reallocating them each run. A workspace
+ * must not be used by two simulations at the same time.
+ */
+struct ISOMODEL_API HourlyWorkspace
+{
+  // End uses in EndUses order.
+  enum EndUse
+  {
+    Eelec_ht,
+    Eelec_cl,
+    Eelec_int_lt,
+    Eelec_ext_lt,
+    Eelec_fan,
+    Eelec_pump,
+    Eelec_int_plug,
+    Eelec_ext_plug,
+    Eelec_dhw,
+    Egas_ht,
+    Egas_cl,
+    Egas_plug,
+    Egas_dhw,
+    END_USES
+  };
+
+  // Raw hourly results of calculateHour, W/m2.
+  HourResults<std::vector<double>> raw;
+  // Hourly (or, once aggregated, monthly) end uses, kWh/m2.
+  std::vector<double> endUses[END_USES];
+};
+
 class ISOMODEL_API HourlyModel : public Simulation
 {
 public:
@@ -68,19 +103,46 @@ public:
    * EUI (i.e., per area) throughout the calculations. The end results are the
    * same, but it's important to know that the intermediate results are generally
    * in terms of EUI if you need them for any reason.
+   *
+   * simulate does not modify the model, so a single HourlyModel may be simulated
+   * from several threads at once.
    */
-  std::vector<EndUses> simulate(bool aggregateByMonth = false);
+  std::vector<EndUses> simulate(bool aggregateByMonth = false) const;
+
+  /**
+   * As above, using workspace for the intermediate results.
+   */
+  std::vector<EndUses> simulate(HourlyWorkspace& workspace, bool aggregateByMonth = false) const;
+
+  /**
+   * Computes the schedules and constant coefficients of the hourly method from the
+   * model's components.
+   */
+  HourlyPlan plan() const;
 
-private:
   /**
-   * Populates the ventilation, fan, exterior equipment, interior equipment,
-   * exterior lighting, interior lighting, heating setpoint, and cooling
-   * setpoint schedules.
+   * Runs the hourly method on a compiled plan. Reads nothing but its arguments, so
+   * it may be called from several threads at once.
    */
-  void populateSchedules();
+  static std::vector<EndUses> simulate(const HourlyPlan& plan, const HourlyWeather& weather, bool aggregateByMonth = false);
 
-  void initialize();
+  static std::vector<EndUses> simulate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyWorkspace& workspace,
+                                       bool aggregateByMonth = false);
 
+  /**
+   * Runs the hourly method, passing the end uses of each hour to aggregator as they are
+   * computed instead of returning them. aggregator is cleared first. Only the raw needs
+   * are kept for the whole year, since the distribution efficiencies depend on their
+   * yearly totals.
+   */
+  void aggregate(HourlyAggregator& aggregator) const;
+
+  static void aggregate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyAggregator& aggregator);
+
+  static void aggregate(const HourlyPlan& plan, const HourlyWeather& weather, HourlyWorkspace& workspace,
+                        HourlyAggregator& aggregator);
+
+private:
   /**
    * Calculates the energy use for one hour and sets the state for the next
    * hour. The hourly calculations largely correspond to those described by the
@@ -89,153 +151,27 @@ private:
    * discrepency in units where this code uses "units per area" while the
    * standard just uses "units" is likely due to this difference.
    */
-  void calculateHour(int hourOfYear,
-                     int month,
-                     int dayOfWeek,
-                     int hourOfDay,
-                     double windMps,
-                     double temperature,
-                     const std::vector<double>& solarRadiation,
-                     double& TMT1,
-                     double& tiHeatCool,
-                     HourResults<double>& results);
-
-  void structureCalculations(double SHGC,
-                             double wallAreaM2,
-                             double windowAreaM2,
-                             double wallUValue,
-                             double windowUValue,
-                             double wallSolarAbsorption,
-                             double solarFactorWith,
-                             double solarFactorWithout,
-                             int direction);
-
-  std::vector<double> sumHoursByMonth(const std::vector<double>& hourlyData);
-
-  /** Returns the ventilation schedule. */
-  virtual double ventilationSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedVentilationSchedule[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the exterior equipment schedule. */
-  virtual double exteriorEquipmentSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedExteriorEquipmentSchedule[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the interior equipment schedule. */
-  virtual double interiorEquipmentSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedInteriorEquipmentSchedule[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the exterior lighting schedule. */
-  virtual double exteriorLightingSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedExteriorLightingSchedule[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the interior lighting schedule. */
-  virtual double interiorLightingSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedInteriorLightingSchedule[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the heating setpoint schedule. */
-  virtual double heatingSetpointSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedActualHeatingSetpoint[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  /** Returns the cooling setpoint schedule. */
-  virtual double coolingSetpointSchedule(int hourOfYear, int hourOfDay, int scheduleOffset) {
-    return fixedActualCoolingSetpoint[(int) hourOfDay][(int) scheduleOffset];
-  }
-
-  // BAA@20150717: Variables that correspond to symbols in ISO 13790 have the symbols noted
-  // in LaTeX format in the comments. Symbols from other standards have their
-  // standard noted. Symbols are case sensitive, e.g., H_{ms} is different than
-  // h_{ms}. References to spreadsheet cells are from the Gerogia Tech
-  // ISOHourly spreadsheet.  Suggested name changes are marked with XXX. If I'm
-  // not confident in the suggested name, it's followed with '???'.  
-
-  // Lighting controls.
-  // Used to determine the amount of electric light used.
-  double maxRatioElectricLighting; // Ratio of electric light used due to lighting controls.
-  double elightNatural; // Target lux level in naturally lit area.
-
-  // Ventilation from wind. ISO 15242
-  double windImpactSupplyRatio; //I119
-  double q4Pa; // ISO 15242 Q_{4Pa}. XXX infiltrationM3PerHourAt4Pa ???
-  double windImpactHz; // ISO 15242 H_{z}. H119
-
-  // Thermal Mass
-  double Am; // A_{m}. XXX: effectiveMassAreaM2
-  double Cm; // C_{m}. XXX: internalHeatCapacityJPerK 
-
-  // Movable shading.
-  // These variables are used to model movable shading. ISO 13790 does it
-  // by switching between g_{gl} and g_{gl+sh}. The method here allows varying
-  // degrees of shading rather than just on or off.
-  double shadingUsePerWPerM2; // K146. The shading factor per unit irradiance. XXX: shadingUsePerWPerM2
-
-  double areaNaturallyLighted;
-  double areaNaturallyLightedRatio;
-  
-  std::vector<double> nlaWMovableShading;
-  std::vector<double> naturalLightRatio;
-  std::vector<double> naturalLightShadeRatioReduction;
-
-  std::vector<double> saWMovableShading;
-  std::vector<double> solarRatio;
-  std::vector<double> solarShadeRatioReduction;
-
-  // Fan power constants.
-
-  // Wind constants.
-  double hzone; // Not totally clear what this is. Something wind related.
-
-  // Pump constants.
-
-
-  // Heat transfer coefficients.
-  double h_ms; // h_{ms} Heat transfer coefficient, mass(m) to surface(s).
-  double h_is; // h_{is} Heat transfer coefficient, air(s) to surface(s).
-
-  double H_tris; // H_{tr,is}. Coupling conductance from air(i) to surface(s).
-  double hwindowWperkm2; // H_{tr,w}.
-
-  // \Phi_{st} and \Phi_{m} are calculated differently than in ISO 13790 to
-  // allow variation in the values that factor the amount of interior and solar
-  // heat gain that heats the air. These variables are used in those
-  // calculations.
-  double prs; // Constant part of \Phi_{st}.
-  double prsInterior; // Interior part of \Phi_{st}.
-  double prsSolar; // Solar part of \Phi_{st}.
-  double prm; // Constant part of \Phi_{m}.
-  double prmInterior; // Interior part of \Phi_{m}.
-  double prmSolar; // Solar part of \Phi_{m}.
-
-  double H_ms; // H_{ms}
-  double hOpaqueWperkm2; // H_{op}
-  double hem; // H_{em}
-
-  // TODO: I don't think this is used. Confirm and delete it. BAA@2015-08-04.
-  // static const int NORTH, NORTHEAST, EAST, SOUTHEAST, SOUTH, SOUTHWEST, WEST, NORTHWEST, ROOF;
-
-  // Calculated surface values
-  double nlams[9];
-  double nla[9];
-  double sams[9]; // ISO13790 11.3.4
-  double sa[9]; // ISO13790 11.3.4
-  double htot[9];
-  double hWindow[9];
-
-  double fixedVentilationSchedule[24][7];
-  double fixedExteriorEquipmentSchedule[24][7];
-  double fixedInteriorEquipmentSchedule[24][7];
-  double fixedExteriorLightingSchedule[24][7];
-  double fixedInteriorLightingSchedule[24][7];
-  double fixedActualHeatingSetpoint[24][7];
-  double fixedActualCoolingSetpoint[24][7];
-
-  // XXX Unused variables.
-  double provisionalCFlowad = 1; // Appears to be unused. Calculation.S106
+  static void calculateHour(const HourlyPlan& plan,
+                            int hourOfYear,
+                            int month,
+                            int dayOfWeek,
+                            int hourOfDay,
+                            double windMps,
+                            double temperature,
+                            const double* solarRadiation,
+                            double& TMT1,
+                            double& tiHeatCool,
+                            HourResults<double>& results);
+
+  /**
+   * Runs calculateHour for every hour of the year, storing the raw results.
+   */
+  static void calculateNeeds(const HourlyPlan& plan, const HourlyWeather& weather, HourResults<std::vector<double>>& rawResults);
+
+  /**
+   * Replaces the hourly values of a year with their twelve monthly sums.
+   */
+  static void sumHoursByMonth(std::vector<double>& data);
 };
 }
 }
@@ -0,0 +1,432 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+
+#include "IsmSchema.hpp"
+#include "UserModel.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <stdexcept>
+#include <unordered_map>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+/**
+ * .ism file is N, NE, E, SE, S, SW, W, NW, Roof.
+ * Structure is S, SE, E, NE, N, NW, W, SW, Roof.
+ * This reorders a vector from the .ism format to the Structure format.
+ */
+void northToSouth(Vector& vec)
+{
+  std::swap(vec[0], vec[4]); // N and S.
+  std::swap(vec[1], vec[3]); // NE and SE.
+  std::swap(vec[5], vec[7]); // SW and NW.
+}
+
+IsmBindResult missingOrInvalid(const Properties& props, const std::string& name)
+{
+  return props.contains(name) ? ISM_INVALID : ISM_MISSING;
+}
+
+// Binders, one pair per setter signature. The assign binders take a converted value;
+// the bind binders look the value up in a Properties, convert it and assign it.
+
+template<void (UserModel::*Setter)(double)>
+IsmBindResult assignDouble(UserModel& model, const IsmValue& value)
+{
+  (model.*Setter)(value.number);
+  return ISM_BOUND;
+}
+
+template<void (UserModel::*Setter)(int)>
+IsmBindResult assignInt(UserModel& model, const IsmValue& value)
+{
+  (model.*Setter)(static_cast<int>(value.number));
+  return ISM_BOUND;
+}
+
+template<void (UserModel::*Setter)(bool)>
+IsmBindResult assignBool(UserModel& model, const IsmValue& value)
+{
+  (model.*Setter)(value.number != 0);
+  return ISM_BOUND;
+}
+
+template<void (UserModel::*Setter)(std::string)>
+IsmBindResult assignString(UserModel& model, const IsmValue& value)
+{
+  try {
+    (model.*Setter)(*value.text);
+  } catch (std::invalid_argument&) {
+    return ISM_INVALID; // Keyword not recognized by the setter.
+  }
+  return ISM_BOUND;
+}
+
+template<void (UserModel::*Setter)(const Vector&)>
+IsmBindResult assignVector(UserModel& model, const IsmValue& value)
+{
+  Vector vec(9);
+  for (int i = 0; i < 9; i++) {
+    vec[i] = value.vector[i];
+  }
+  // TODO: Update the .ism format order to match the order used internall so we don't
+  // have to do this reordering. BAA@2015-06-24.
+  northToSouth(vec);
+  (model.*Setter)(vec);
+  return ISM_BOUND;
+}
+
+// Sets one surface (in .ism order) of a vector property, keeping the model's others.
+template<void (UserModel::*Setter)(const Vector&), Vector (UserModel::*Getter)() const>
+IsmBindResult assignSurface(UserModel& model, int surface, double value)
+{
+  Vector vec = (model.*Getter)();
+  // northToSouth is its own inverse: to .ism order and back.
+  northToSouth(vec);
+  vec[surface] = value;
+  northToSouth(vec);
+  (model.*Setter)(vec);
+  return ISM_BOUND;
+}
+
+template<void (UserModel::*Setter)(double)>
+IsmBindResult bindDouble(UserModel& model, const Properties& props, const std::string& name)
+{
+  if (auto number = props.getPropertyAsDouble(name)) {
+    IsmValue value = { *number, nullptr, nullptr };
+    return assignDouble<Setter>(model, value);
+  }
+  return missingOrInvalid(props, name);
+}
+
+template<void (UserModel::*Setter)(int)>
+IsmBindResult bindInt(UserModel& model, const Properties& props, const std::string& name)
+{
+  if (auto number = props.getPropertyAsInt(name)) {
+    IsmValue value = { static_cast<double>(*number), nullptr, nullptr };
+    return assignInt<Setter>(model, value);
+  }
+  return missingOrInvalid(props, name);
+}
+
+template<void (UserModel::*Setter)(bool)>
+IsmBindResult bindBool(UserModel& model, const Properties& props, const std::string& name)
+{
+  if (auto flag = props.getPropertyAsBool(name)) {
+    IsmValue value = { *flag ? 1.0 : 0.0, nullptr, nullptr };
+    return assignBool<Setter>(model, value);
+  }
+  return missingOrInvalid(props, name);
+}
+
+template<void (UserModel::*Setter)(std::string)>
+IsmBindResult bindString(UserModel& model, const Properties& props, const std::string& name)
+{
+  if (auto text = props.getProperty(name)) {
+    IsmValue value = { 0, nullptr, &*text };
+    return assignString<Setter>(model, value);
+  }
+  return ISM_MISSING;
+}
+
+template<void (UserModel::*Setter)(const Vector&)>
+IsmBindResult bindVector(UserModel& model, const Properties& props, const std::string& name)
+{
+  std::vector<double> numbers;
+  if (props.getPropertyAsDoubleVector(name, numbers)) {
+    if (numbers.size() != 9) {
+      return ISM_INVALID;
+    }
+    IsmValue value = { 0, numbers.data(), nullptr };
+    return assignVector<Setter>(model, value);
+  }
+  return missingOrInvalid(props, name);
+}
+
+// Entry factories. The type and binder come from the same template argument, so an
+// entry whose setter does not take the declared type fails to compile.
+
+template<void (UserModel::*Setter)(double)>
+IsmProperty requiredDouble(const char* name)
+{
+  IsmProperty property = { name, ISM_DOUBLE, true, nullptr, &bindDouble<Setter>, &assignDouble<Setter>, nullptr };
+  return property;
+}
+
+template<void (UserModel::*Setter)(double)>
+IsmProperty optionalDouble(const char* name, const char* defaultValue)
+{
+  IsmProperty property = { name, ISM_DOUBLE, false, defaultValue, &bindDouble<Setter>, &assignDouble<Setter>, nullptr };
+  return property;
+}
+
+template<void (UserModel::*Setter)(int)>
+IsmProperty optionalInt(const char* name, const char* defaultValue)
+{
+  IsmProperty property = { name, ISM_INT, false, defaultValue, &bindInt<Setter>, &assignInt<Setter>, nullptr };
+  return property;
+}
+
+template<void (UserModel::*Setter)(bool)>
+IsmProperty optionalBool(const char* name, const char* defaultValue)
+{
+  IsmProperty property = { name, ISM_BOOL, false, defaultValue, &bindBool<Setter>, &assignBool<Setter>, nullptr };
+  return property;
+}
+
+template<void (UserModel::*Setter)(std::string)>
+IsmProperty requiredString(const char* name)
+{
+  IsmProperty property = { name, ISM_STRING, true, nullptr, &bindString<Setter>, &assignString<Setter>, nullptr };
+  return property;
+}
+
+template<void (UserModel::*Setter)(const Vector&), Vector (UserModel::*Getter)() const>
+IsmProperty requiredVector(const char* name)
+{
+  IsmProperty property = { name, ISM_VECTOR, true, nullptr, &bindVector<Setter>, &assignVector<Setter>, &assignSurface<Setter, Getter> };
+  return property;
+}
+
+}
+
+const std::vector<IsmProperty>& ismSchema()
+{
+  static const std::vector<IsmProperty> schema = {
+    requiredDouble<&UserModel::setTerrainClass>("terrainclass"),
+    requiredDouble<&UserModel::setBuildingHeight>("buildingheight"),
+    requiredDouble<&UserModel::setFloorArea>("floorarea"),
+    requiredDouble<&UserModel::setBuildingOccupancyFrom>("occupancydayfirst"),
+    requiredDouble<&UserModel::setBuildingOccupancyTo>("occupancydaylast"),
+    requiredDouble<&UserModel::setEquivFullLoadOccupancyFrom>("occupancyhourfirst"),
+    requiredDouble<&UserModel::setEquivFullLoadOccupancyTo>("occupancyhourlast"),
+    requiredDouble<&UserModel::setPeopleDensityOccupied>("peopledensityoccupied"),
+    requiredDouble<&UserModel::setPeopleDensityUnoccupied>("peopledensityunoccupied"),
+    requiredDouble<&UserModel::setLightingPowerIntensityOccupied>("lightingpowerdensityoccupied"),
+    requiredDouble<&UserModel::setLightingPowerIntensityUnoccupied>("lightingpowerdensityunoccupied"),
+    requiredDouble<&UserModel::setElecPowerAppliancesOccupied>("electricappliancepowerdensityoccupied"),
+    requiredDouble<&UserModel::setElecPowerAppliancesUnoccupied>("electricappliancepowerdensityunoccupied"),
+    requiredDouble<&UserModel::setGasPowerAppliancesOccupied>("gasappliancepowerdensityoccupied"),
+    requiredDouble<&UserModel::setGasPowerAppliancesUnoccupied>("gasappliancepowerdensityunoccupied"),
+    requiredDouble<&UserModel::setExteriorLightingPower>("exteriorlightingpower"),
+    requiredDouble<&UserModel::setHvacWasteFactor>("hvacwastefactor"),
+    requiredDouble<&UserModel::setHvacHeatingLossFactor>("hvacheatinglossfactor"),
+    requiredDouble<&UserModel::setHvacCoolingLossFactor>("hvaccoolinglossfactor"),
+    requiredDouble<&UserModel::setDaylightSensorSystem>("daylightsensordimmingfraction"),
+    requiredDouble<&UserModel::setLightingOccupancySensorSystem>("lightingoccupancysensordimmingfraction"),
+    requiredDouble<&UserModel::setConstantIlluminationControl>("constantilluminationcontrolmultiplier"),
+    requiredDouble<&UserModel::setCoolingSystemCOP>("coolingsystemcop"),
+    requiredDouble<&UserModel::setCoolingSystemIPLVToCOPRatio>("coolingsystemiplvtocopratio"),
+    requiredDouble<&UserModel::setHeatingSystemEfficiency>("heatingsystemefficiency"),
+    requiredString<&UserModel::setHeatingEnergyCarrier>("heatingfueltype"),
+    requiredString<&UserModel::setVentilationType>("ventilationtype"),
+    requiredString<&UserModel::setDhwEnergyCarrier>("dhwfueltype"),
+    requiredString<&UserModel::setBemType>("bemtype"),
+    requiredDouble<&UserModel::setFreshAirFlowRate>("ventilationintakerateoccupied"),
+    requiredDouble<&UserModel::setSupplyExhaustRate>("ventilationExhaustRateOccupied"),
+    requiredDouble<&UserModel::setHeatRecovery>("heatrecovery"),
+    requiredDouble<&UserModel::setExhaustAirRecirclation>("exhaustairrecirculation"),
+    requiredDouble<&UserModel::setBuildingAirLeakage>("infiltrationrateoccupied"),
+    requiredDouble<&UserModel::setDhwDemand>("dhwdemand"),
+    requiredDouble<&UserModel::setDhwEfficiency>("dhwsystemefficiency"),
+    requiredDouble<&UserModel::setDhwDistributionEfficiency>("dhwdistributionefficiency"),
+    requiredDouble<&UserModel::setInteriorHeatCapacity>("interiorheatcapacity"),
+    requiredDouble<&UserModel::setExteriorHeatCapacity>("exteriorheatcapacity"),
+    requiredDouble<&UserModel::setHeatingPumpControl>("heatingpumpcontrol"),
+    requiredDouble<&UserModel::setCoolingPumpControl>("coolingpumpcontrol"),
+    requiredDouble<&UserModel::setHeatGainPerPerson>("heatgainperperson"),
+    requiredDouble<&UserModel::setSpecificFanPower>("specificfanpower"),
+    requiredDouble<&UserModel::setFanFlowControlFactor>("fanflowcontrolfactor"),
+    requiredDouble<&UserModel::setCoolingOccupiedSetpoint>("coolingsetpointoccupied"),
+    requiredDouble<&UserModel::setCoolingUnoccupiedSetpoint>("coolingsetpointunoccupied"),
+    requiredDouble<&UserModel::setHeatingOccupiedSetpoint>("heatingsetpointoccupied"),
+    requiredDouble<&UserModel::setHeatingUnoccupiedSetpoint>("heatingsetpointunoccupied"),
+
+#if (USE_NEW_BUILDING_PARAMS)
+    requiredDouble<&UserModel::setVentilationIntakeRateUnoccupied>("ventilationIntakeRateUnoccupied"),
+    requiredDouble<&UserModel::setVentilationExhaustRateUnoccupied>("ventilationExhaustRateUnoccupied"),
+    requiredDouble<&UserModel::setInfiltrationRateUnoccupied>("infiltrationRateUnoccupied"),
+    requiredDouble<&UserModel::setLightingPowerFixedOccupied>("lightingPowerFixedOccupied"),
+    requiredDouble<&UserModel::setLightingPowerFixedUnoccupied>("lightingPowerFixedUnoccupied"),
+    requiredDouble<&UserModel::setElectricAppliancePowerFixedOccupied>("electricAppliancePowerFixedOccupied"),
+    requiredDouble<&UserModel::setElectricAppliancePowerFixedUnoccupied>("electricAppliancePowerFixedUnoccupied"),
+    requiredDouble<&UserModel::setGasAppliancePowerFixedOccupied>("gasAppliancePowerFixedOccupied"),
+    requiredDouble<&UserModel::setGasAppliancePowerFixedUnoccupied>("gasAppliancePowerFixedUnoccupied"),
+    requiredString<&UserModel::setScheduleFilePath>("schedulefilepath"),
+#endif
+
+    requiredString<&UserModel::setWeatherFilePath>("weatherfilepath"),
+
+    // Optional properties with hard-coded default values:
+    optionalDouble<&UserModel::setExternalEquipment>("externalequipment", "0.0"),
+    optionalBool<&UserModel::setForcedAirCooling>("forcedaircooling", "true"),
+    optionalDouble<&UserModel::setT_cl_ctrl_flag>("t_cl_ctrl_flag", "1"),
+    optionalDouble<&UserModel::setDT_supp_cl>("dt_supp_cl", "7.0"),
+    optionalDouble<&UserModel::setDC_YesNo>("dc_yesno", "0"),
+    optionalDouble<&UserModel::setEta_DC_network>("eta_dc_network", "0.9"),
+    optionalDouble<&UserModel::setEta_DC_COP>("eta_dc_cop", "5.5"),
+    optionalDouble<&UserModel::setEta_DC_frac_abs>("eta_dc_frac_abs", "0"),
+    optionalDouble<&UserModel::setEta_DC_COP_abs>("eta_dc_cop_abs", "1"),
+    optionalDouble<&UserModel::setFrac_DC_free>("frac_dc_free", "0"),
+    optionalDouble<&UserModel::setE_pumps_cl>("e_pumps_cl", "0.25"),
+    optionalBool<&UserModel::setForcedAirHeating>("forcedairheating", "true"),
+    optionalDouble<&UserModel::setDT_supp_ht>("dt_supp_ht", "7.0"),
+    optionalDouble<&UserModel::setE_pumps_ht>("e_pumps_ht", "0.25"),
+    optionalDouble<&UserModel::setT_ht_ctrl_flag>("t_ht_ctrl_flag", "1"),
+    optionalDouble<&UserModel::setA_H0>("a_h0", "1"),
+    optionalDouble<&UserModel::setTau_H0>("tau_h0", "15"),
+    optionalDouble<&UserModel::setDH_YesNo>("dh_yesno", "0"),
+    optionalDouble<&UserModel::setEta_DH_network>("eta_dh_network", "0.9"),
+    optionalDouble<&UserModel::setEta_DH_sys>("eta_dh_sys", "0.87"),
+    optionalDouble<&UserModel::setFrac_DH_free>("frac_dh_free", "0"),
+    optionalDouble<&UserModel::setDhw_tset>("dhw_tset", "60"),
+    optionalDouble<&UserModel::setDhw_tsupply>("dhw_tsupply", "20"),
+    optionalDouble<&UserModel::setN_day_start>("n_day_start", "7.0"),
+    optionalDouble<&UserModel::setN_day_end>("n_day_end", "18.0"),
+    optionalDouble<&UserModel::setN_weeks>("n_weeks", "50.0"),
+    optionalDouble<&UserModel::setElecInternalGains>("elecinternalgains", "1.0"),
+    optionalDouble<&UserModel::setPermLightPowerDensity>("permlightpowerdensity", "0.0"),
+    optionalDouble<&UserModel::setPresenceSensorAd>("presencesensorad", "0.6"),
+    optionalDouble<&UserModel::setAutomaticAd>("automaticad", "0.8"),
+    optionalDouble<&UserModel::setPresenceAutoAd>("presenceautoad", "0.6"),
+    optionalDouble<&UserModel::setManualSwitchAd>("manualswitchad", "1"),
+    optionalDouble<&UserModel::setPresenceSensorLux>("presencesensorlux", "500.0"),
+    optionalDouble<&UserModel::setAutomaticLux>("automaticlux", "300.0"),
+    optionalDouble<&UserModel::setPresenceAutoLux>("presenceautolux", "300.0"),
+    optionalDouble<&UserModel::setManualSwitchLux>("manualswitchlux", "500.0"),
+    optionalDouble<&UserModel::setNaturallyLightedArea>("naturallylightedarea", "0.0"),
+    optionalDouble<&UserModel::setRhoCpAir>("rhocpair", "0.00123991252"),
+    optionalDouble<&UserModel::setRhoCpWater>("rhocpwater", "4.1813"),
+    optionalDouble<&UserModel::setPhiIntFractionToAirNode>("phiintfractiontoairnode", "0.5"),
+    optionalDouble<&UserModel::setPhiSolFractionToAirNode>("phisolfractiontoairnode", "0"),
+    optionalDouble<&UserModel::setHci>("hci", "2.5"),
+    optionalDouble<&UserModel::setHri>("hri", "5.5"),
+    optionalDouble<&UserModel::setR_se>("r_se", "0.04"),
+    optionalDouble<&UserModel::setIrradianceForMaxShadingUse>("irradianceformaxshadinguse", "500"),
+    optionalDouble<&UserModel::setShadingFactorAtMaxUse>("shadingfactoratmaxuse", "0.5"),
+    optionalDouble<&UserModel::setTotalAreaPerFloorArea>("totalareaperfloorarea", "4.5"),
+    optionalDouble<&UserModel::setWin_ff>("win_ff", "0.25"),
+    optionalDouble<&UserModel::setWin_F_W>("win_f_w", "0.9"),
+    optionalDouble<&UserModel::setR_sc_ext>("r_sc_ext", "0.04"),
+    optionalDouble<&UserModel::setVentPreheatDegC>("ventpreheatdegc", "-50.0"),
+    optionalDouble<&UserModel::setN50>("n50", "2.0"),
+    optionalDouble<&UserModel::setHzone>("hzone", "39.0"),
+    optionalDouble<&UserModel::setP_exp>("p_exp", "0.65"),
+    optionalDouble<&UserModel::setZone_frac>("zone_frac", "0.7"),
+    optionalDouble<&UserModel::setStack_exp>("stack_exp", "0.667"),
+    optionalDouble<&UserModel::setStack_coeff>("stack_coeff", "0.0146"),
+    optionalDouble<&UserModel::setWind_exp>("wind_exp", "0.667"),
+    optionalDouble<&UserModel::setWind_coeff>("wind_coeff", "0.0769"),
+    optionalDouble<&UserModel::setDCp>("dcp", "0.75"),
+    optionalInt<&UserModel::setVent_rate_flag>("vent_rate_flag", "1"),
+    optionalDouble<&UserModel::setH_ve>("h_ve", "0.0"),
+
+    // Structure properties, one value per orientation:
+    requiredVector<&UserModel::setWallArea, &UserModel::wallArea>("wallArea"),
+    requiredVector<&UserModel::setWallU, &UserModel::wallU>("wallU"),
+    requiredVector<&UserModel::setWallThermalEmissivity, &UserModel::wallThermalEmissivity>("wallEmissivity"),
+    requiredVector<&UserModel::setWallSolarAbsorption, &UserModel::wallSolarAbsorption>("wallAbsorption"),
+    requiredVector<&UserModel::setWindowArea, &UserModel::windowArea>("windowArea"),
+    requiredVector<&UserModel::setWindowU, &UserModel::windowU>("windowU"),
+    requiredVector<&UserModel::setWindowSHGC, &UserModel::windowSHGC>("windowSHGC"),
+    requiredVector<&UserModel::setWindowSCF, &UserModel::windowSCF>("windowSCF"),
+    requiredVector<&UserModel::setWindowSDF, &UserModel::windowSDF>("windowSDF")
+  };
+  return schema;
+}
+
+const IsmProperty* findIsmProperty(const std::string& name)
+{
+  // Schema indices by lower case name.
+  static const std::unordered_map<std::string, size_t> index = [] {
+    std::unordered_map<std::string, size_t> names;
+    const std::vector<IsmProperty>& schema = ismSchema();
+    for (size_t i = 0; i < schema.size(); ++i) {
+      names[boost::to_lower_copy(std::string(schema[i].name))] = i;
+    }
+    return names;
+  }();
+  auto found = index.find(boost::to_lower_copy(name));
+  if (found == index.end()) {
+    return nullptr;
+  }
+  return &ismSchema()[found->second];
+}
+
+int findIsmSurface(const std::string& name)
+{
+  static const char* surfaces[] = { "n", "ne", "e", "se", "s", "sw", "w", "nw", "roof" };
+  std::string lower = boost::to_lower_copy(name);
+  for (int i = 0; i < 9; i++) {
+    if (lower == surfaces[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void bindIsmProperties(UserModel& model, const Properties& props, bool requireAll)
+{
+  // The documented values of the optional properties.
+  static const Properties defaults = [] {
+    Properties props;
+    for (auto& property : ismSchema()) {
+      if (!property.required) {
+        props.putProperty(property.name, std::string(property.defaultValue));
+      }
+    }
+    return props;
+  }();
+  std::string missing, invalid;
+  int missingCount = 0;
+  const std::vector<IsmProperty>& schema = ismSchema();
+  for (auto& property : schema) {
+    std::string name(property.name);
+    IsmBindResult result = property.bind(model, props, name);
+    if (result == ISM_MISSING && !property.required && requireAll) {
+      result = property.bind(model, defaults, name);
+    }
+    if (result == ISM_INVALID) {
+      invalid += (invalid.empty() ? "" : ", ") + name;
+    } else if (result == ISM_MISSING && property.required && requireAll) {
+      missing += (missing.empty() ? "" : ", ") + name;
+      ++missingCount;
+    }
+  }
+  if (missing.empty() && invalid.empty()) {
+    return;
+  }
+  std::string message;
+  if (missingCount == 1 && invalid.empty()) {
+    message = "Required property " + missing + " missing in .ism file.";
+  } else if (!missing.empty()) {
+    message = "Required properties missing in .ism file: " + missing + ".";
+  }
+  if (!invalid.empty()) {
+    message += (message.empty() ? "" : " ") + std::string("Invalid property values in .ism file: ") + invalid + ".";
+  }
+  throw std::invalid_argument(message);
+}
+
+}
+}
@@ -0,0 +1,114 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_ISM_SCHEMA_HPP
+#define ISOMODEL_ISM_SCHEMA_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class UserModel;
+class Properties;
+
+/**
+ * Value types of .ism properties.
+ */
+enum IsmPropertyType
+{
+  ISM_DOUBLE,
+  ISM_INT,
+  ISM_BOOL,
+  ISM_STRING,
+  ISM_VECTOR // Nine comma separated values in .ism order: N, NE, E, SE, S, SW, W, NW, Roof.
+};
+
+/**
+ * Outcome of binding a single property to a UserModel.
+ */
+enum IsmBindResult
+{
+  ISM_BOUND,
+  ISM_MISSING,
+  ISM_INVALID // Present but not convertible to the property type, or rejected by the setter.
+};
+
+/**
+ * An already converted property value. number holds double, int and bool (0 or 1)
+ * values, vector points at the nine values of a vector property in .ism order, and
+ * text points at the value of a string property.
+ */
+struct ISOMODEL_API IsmValue
+{
+  double number;
+  const double* vector;
+  const std::string* text;
+};
+
+/**
+ * One property of the .ism format: its name, type, whether it is required, the
+ * hard-coded default used when an optional property is absent, and the binders that
+ * pass the value to the UserModel setter. bind looks the value up in a Properties and
+ * converts it; assign takes a value that has already been converted; assignSurface
+ * sets a single surface of a vector property.
+ */
+struct ISOMODEL_API IsmProperty
+{
+  const char* name;
+  IsmPropertyType type;
+  bool required;
+  const char* defaultValue; // nullptr for required properties.
+  IsmBindResult (*bind)(UserModel& model, const Properties& props, const std::string& name);
+  IsmBindResult (*assign)(UserModel& model, const IsmValue& value);
+  // Sets one surface (0 to 8, in .ism order) of a vector property and keeps the model's
+  // other surfaces; nullptr for the other types.
+  IsmBindResult (*assignSurface)(UserModel& model, int surface, double value);
+};
+
+/**
+ * The .ism schema in binding order. The type and binder of each entry are generated
+ * from the setter's signature, so a mismatched entry does not compile.
+ */
+ISOMODEL_API const std::vector<IsmProperty>& ismSchema();
+
+/**
+ * Finds a schema entry by name (case insensitive). Returns nullptr if there is none.
+ */
+ISOMODEL_API const IsmProperty* findIsmProperty(const std::string& name);
+
+/**
+ * The index (in .ism order) of the surface of a vector property named N, NE, E, SE, S,
+ * SW, W, NW or Roof (case insensitive). Returns -1 for any other name.
+ */
+ISOMODEL_API int findIsmSurface(const std::string& name);
+
+/**
+ * Binds the schema properties found in props to model in a single pass over the schema.
+ * If requireAll is true, absent required properties are errors and absent optional
+ * properties are set to their defaultValue; otherwise absent properties are left as they are. Every missing or invalid
+ * property is collected and reported together in one std::invalid_argument.
+ */
+ISOMODEL_API void bindIsmProperties(UserModel& model, const Properties& props, bool requireAll = true);
+
+}
+}
+#endif
@@ -4,6 +4,8 @@ namespace openstudio {
 namespace isomodel {
 
 Lighting::Lighting(void)
+    : m_powerDensityOccupied(0), m_powerDensityUnoccupied(0), m_dimmingFraction(0), m_exteriorEnergy(0),
+      m_lightingPowerFixedOccupied(0), m_lightingPowerFixedUnoccupied(0)
 {
 }
 
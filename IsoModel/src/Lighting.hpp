@@ -253,6 +253,16 @@ public:
     m_lightingPowerFixedUnoccupied = lightingPowerFixedUnoccupied;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_powerDensityOccupied & m_powerDensityUnoccupied & m_dimmingFraction & m_exteriorEnergy
+        & m_n_day_start & m_n_day_end & m_n_weeks & m_elecInternalGains & m_permLightPowerDensity
+        & m_presenceSensorAd & m_automaticAd & m_presenceAutoAd & m_manualSwitchAd
+        & m_presenceSensorLux & m_automaticLux & m_presenceAutoLux & m_manualSwitchLux
+        & m_naturallyLightedArea & m_lightingPowerFixedOccupied & m_lightingPowerFixedUnoccupied;
+  }
+
 private:
   double m_powerDensityOccupied;
   double m_powerDensityUnoccupied;
@@ -4,6 +4,7 @@ namespace openstudio {
 namespace isomodel {
 
 Location::Location(void)
+    : m_terrain(0)
 {
 }
 
@@ -54,6 +54,12 @@ public:
     m_weather = value;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp. The weather data is serialized by the UserModel.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_terrain;
+  }
+
 private:
   double m_terrain;
   std::shared_ptr<WeatherData> m_weather;
@@ -0,0 +1,162 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "ModelParameters.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char* const endUseNames[END_USE_COUNT] = { "ElecHeat", "ElecCool", "ElecIntLights", "ElecExtLights", "ElecFans", "ElecPump",
+                                                 "ElecEquipInt", "ElecEquipExt", "ElectDHW", "GasHeat", "GasCool", "GasEquip", "GasDHW" };
+
+#ifndef ISOMODEL_STANDALONE
+const std::pair<EndUseFuelType, EndUseCategoryType> endUseTypes[END_USE_COUNT] = {
+  { EndUseFuelType::Electricity, EndUseCategoryType::Heating },
+  { EndUseFuelType::Electricity, EndUseCategoryType::Cooling },
+  { EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights },
+  { EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights },
+  { EndUseFuelType::Electricity, EndUseCategoryType::Fans },
+  { EndUseFuelType::Electricity, EndUseCategoryType::Pumps },
+  { EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment },
+  { EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment },
+  { EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems },
+  { EndUseFuelType::Gas, EndUseCategoryType::Heating },
+  { EndUseFuelType::Gas, EndUseCategoryType::Cooling },
+  { EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment },
+  { EndUseFuelType::Gas, EndUseCategoryType::WaterSystems }
+};
+#endif
+
+}
+
+const char* endUseName(int endUse)
+{
+  if (endUse < 0 || endUse >= END_USE_COUNT) {
+    throw std::invalid_argument("Invalid end use " + std::to_string(endUse) + ".");
+  }
+  return endUseNames[endUse];
+}
+
+double endUseValue(const EndUses& result, int endUse)
+{
+#ifdef ISOMODEL_STANDALONE
+  return const_cast<EndUses&>(result).getEndUse(endUse);
+#else
+  return result.getEndUse(endUseTypes[endUse].first, endUseTypes[endUse].second);
+#endif
+}
+
+void setEndUseValue(EndUses& result, int endUse, double value)
+{
+#ifdef ISOMODEL_STANDALONE
+  result.addEndUse(endUse, value);
+#else
+  result.addEndUse(value, endUseTypes[endUse].first, endUseTypes[endUse].second);
+#endif
+}
+
+SimulationEngine parseSimulationEngine(const std::string& name)
+{
+  if (name == "monthly") {
+    return MONTHLY_ENGINE;
+  } else if (name == "hourly") {
+    return HOURLY_ENGINE;
+  }
+  throw std::invalid_argument("Unknown simulation engine \"" + name + "\", expected monthly or hourly.");
+}
+
+std::vector<EndUses> simulateByMonth(const UserModel& model, SimulationEngine engine)
+{
+  if (engine == HOURLY_ENGINE) {
+    return model.toHourlyModel().simulate(true);
+  }
+  return model.toMonthlyModel().simulate();
+}
+
+ParameterBinding::ParameterBinding()
+{
+}
+
+ParameterBinding::ParameterBinding(const std::vector<std::string>& names) : m_names(names)
+{
+  std::string unknown;
+  for (const auto& name : names) {
+    // A name is a property, or a vector property and a surface, e.g. windowArea[S].
+    size_t bracket = name.find('[');
+    const IsmProperty* property = findIsmProperty(name.substr(0, bracket));
+    int surface = -1;
+    bool valid = property != nullptr && property->type != ISM_STRING;
+    if (bracket != std::string::npos) {
+      surface = name.back() == ']' ? findIsmSurface(name.substr(bracket + 1, name.size() - bracket - 2)) : -1;
+      valid = valid && property->type == ISM_VECTOR && surface >= 0;
+    }
+    if (!valid) {
+      unknown += (unknown.empty() ? "" : ", ") + name;
+    }
+    m_properties.push_back(property);
+    m_surfaces.push_back(surface);
+  }
+  if (!unknown.empty()) {
+    throw std::invalid_argument("Unknown or non-numeric parameters: " + unknown + ".");
+  }
+}
+
+void ParameterBinding::apply(UserModel& model, const double* values) const
+{
+  for (size_t i = 0; i < m_properties.size(); i++) {
+    const IsmProperty* property = m_properties[i];
+    double surfaces[9];
+    IsmValue value = { values[i], nullptr, nullptr };
+    switch (property->type) {
+    case ISM_INT:
+      value.number = std::floor(values[i] + 0.5);
+      break;
+    case ISM_BOOL:
+      value.number = values[i] >= 0.5 ? 1.0 : 0.0;
+      break;
+    case ISM_VECTOR:
+      for (int s = 0; s < 9; s++) {
+        surfaces[s] = values[i];
+      }
+      value.vector = surfaces;
+      break;
+    default:
+      break;
+    }
+    IsmBindResult result =
+        m_surfaces[i] >= 0 ? property->assignSurface(model, m_surfaces[i], values[i]) : property->assign(model, value);
+    if (result != ISM_BOUND) {
+      throw std::invalid_argument("Invalid value " + std::to_string(values[i]) + " for " + m_names[i] + ".");
+    }
+  }
+}
+
+UserModel ParameterBinding::bind(const UserModel& base, const double* values) const
+{
+  UserModel model(base);
+  apply(model, values);
+  return model;
+}
+
+}
+}
@@ -0,0 +1,123 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_MODEL_PARAMETERS_HPP
+#define ISOMODEL_MODEL_PARAMETERS_HPP
+
+#include "ISOModelAPI.hpp"
+#include "IsmSchema.hpp"
+#include "UserModel.hpp"
+
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Number of end uses in the simulation results.
+ */
+const int END_USE_COUNT = 13;
+
+/**
+ * Name of an end use (in EndUses order, 0 to END_USE_COUNT - 1) as used in CSV headers,
+ * e.g. "ElecHeat".
+ */
+ISOMODEL_API const char* endUseName(int endUse);
+
+/**
+ * The value of an end use (in EndUses order) of a result.
+ */
+ISOMODEL_API double endUseValue(const EndUses& result, int endUse);
+
+/**
+ * Sets the value of an end use (in EndUses order) of a result.
+ */
+ISOMODEL_API void setEndUseValue(EndUses& result, int endUse, double value);
+
+/**
+ * The simulation method used by the sweep, uncertainty and optimization engines.
+ */
+enum SimulationEngine
+{
+  MONTHLY_ENGINE,
+  HOURLY_ENGINE
+};
+
+/**
+ * Parses "monthly" or "hourly". Throws std::invalid_argument for anything else.
+ */
+ISOMODEL_API SimulationEngine parseSimulationEngine(const std::string& name);
+
+/**
+ * Simulates model with engine and returns the 12 monthly results (the hourly method is
+ * aggregated by month).
+ */
+ISOMODEL_API std::vector<EndUses> simulateByMonth(const UserModel& model, SimulationEngine engine);
+
+/**
+ * A list of numeric .ism properties (double, integer, boolean or vector) that are set
+ * from plain numbers, e.g. the sampled inputs of a sweep. Integer values are rounded and
+ * booleans are true for values of 0.5 or more.
+ *
+ * A vector property named with a surface, e.g. windowArea[S] or wallU[Roof], sets that
+ * surface only and keeps the model's values of the others. The surfaces are N, NE, E,
+ * SE, S, SW, W, NW and Roof. A vector property named alone, e.g. windowArea, gets the
+ * same value for all nine surfaces, the roof included, so a window area also becomes a
+ * skylight area of the same size; name the surfaces to vary the facades only.
+ */
+class ISOMODEL_API ParameterBinding
+{
+public:
+  ParameterBinding();
+
+  /**
+   * Looks up the properties by name (case insensitive). Throws std::invalid_argument
+   * listing the names that are unknown or not numeric, and those with a surface that is
+   * unknown or given for a property that is not a vector.
+   */
+  explicit ParameterBinding(const std::vector<std::string>& names);
+
+  size_t size() const {
+    return m_properties.size();
+  }
+
+  const std::vector<std::string>& names() const {
+    return m_names;
+  }
+
+  /**
+   * Sets the properties of model to values, which holds size() values.
+   */
+  void apply(UserModel& model, const double* values) const;
+
+  /**
+   * A copy of base with the properties set to values.
+   */
+  UserModel bind(const UserModel& base, const double* values) const;
+
+private:
+  std::vector<std::string> m_names;
+  std::vector<const IsmProperty*> m_properties;
+  // The surface (in .ism order) of each property, or -1 for all nine.
+  std::vector<int> m_surfaces;
+};
+
+}
+}
+#endif
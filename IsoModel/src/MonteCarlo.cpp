@@ -0,0 +1,127 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "MonteCarlo.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace openstudio {
+namespace isomodel {
+
+MonteCarlo::MonteCarlo(const UserModel& base, const SweepSpec& spec)
+  : m_base(base), m_engine(spec.engine), m_maxSamples(spec.samples), m_minSamples(spec.minSamples), m_batch(spec.batch),
+    m_tolerance(spec.tolerance), m_z(inverseNormal((1 + spec.confidence) / 2)), m_random(spec.seed), m_samples(0),
+    m_converged(false), m_stats(END_USE_COUNT * PERIODS), m_digests(END_USE_COUNT * PERIODS)
+{
+  std::vector<std::string> names;
+  for (const auto& parameter : spec.parameters) {
+    names.push_back(parameter.name);
+    m_distributions.push_back(parameter.distribution);
+  }
+  m_binding = ParameterBinding(names);
+}
+
+bool MonteCarlo::run(ThreadPool& pool)
+{
+  size_t dimensions = m_distributions.size();
+  std::vector<double> inputs;
+  std::vector<std::vector<EndUses> > results;
+  while (m_samples < m_maxSamples && !m_converged) {
+    size_t count = std::min(m_batch, m_maxSamples - m_samples);
+
+    // Draw the batch serially, so that the samples only depend on the seed.
+    inputs.resize(count * dimensions);
+    for (size_t i = 0; i < count * dimensions; i++) {
+      double u = ((m_random() >> 11) + 0.5) / 9007199254740992.0;
+      inputs[i] = m_distributions[i % dimensions].quantile(u);
+    }
+
+    results.assign(count, std::vector<EndUses>());
+    pool.parallelFor(count, [&](size_t i) {
+      results[i] = simulateByMonth(m_binding.bind(m_base, inputs.data() + i * dimensions), m_engine);
+    });
+    for (const auto& monthly : results) {
+      add(monthly);
+    }
+
+    m_samples += count;
+    m_converged = m_tolerance > 0 && m_samples >= std::max<size_t>(m_minSamples, 2) && hasConverged();
+  }
+  return m_converged;
+}
+
+void MonteCarlo::add(const std::vector<EndUses>& monthly)
+{
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    double annual = 0;
+    for (int month = 0; month < 12; month++) {
+      double value = endUseValue(monthly[month], endUse);
+      annual += value;
+      m_stats[index(endUse, month)].add(value);
+      m_digests[index(endUse, month)].add(value);
+    }
+    m_stats[index(endUse, ANNUAL)].add(annual);
+    m_digests[index(endUse, ANNUAL)].add(annual);
+  }
+}
+
+double MonteCarlo::halfWidth(int endUse, int period) const
+{
+  return m_z * stats(endUse, period).standardError();
+}
+
+bool MonteCarlo::hasConverged() const
+{
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    // End uses that are always 0 have no relative error to bound.
+    if (halfWidth(endUse, ANNUAL) > m_tolerance * std::abs(stats(endUse, ANNUAL).mean())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MonteCarlo::writeCsv(std::ostream& out) const
+{
+  out << "EndUse,Period,Samples,Mean,StdDev,Min,P5,P25,P50,P75,P95,Max,HalfWidth\n";
+  out << std::setprecision(10);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    for (int period = 0; period < PERIODS; period++) {
+      const RunningStats& s = stats(endUse, period);
+      const TDigest& digest = distribution(endUse, period);
+      out << endUseName(endUse) << ",";
+      if (period == ANNUAL) {
+        out << "Annual";
+      } else {
+        out << period + 1;
+      }
+      out << "," << s.count() << "," << s.mean() << "," << s.standardDeviation() << "," << s.min();
+      double quantiles[] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+      for (double q : quantiles) {
+        out << "," << digest.quantile(q);
+      }
+      out << "," << s.max() << "," << halfWidth(endUse, period) << "\n";
+    }
+  }
+}
+
+}
+}
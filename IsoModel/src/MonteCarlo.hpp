@@ -0,0 +1,119 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_MONTE_CARLO_HPP
+#define ISOMODEL_MONTE_CARLO_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Statistics.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Monte Carlo uncertainty propagation: draws the parameters of a SweepSpec at random
+ * from their distributions, simulates the runs in parallel batches and keeps, for every
+ * end use and every month and the year, running moments and a t-digest of the results.
+ * Only one batch of results is held at a time, so memory does not depend on the number
+ * of samples. Batches are folded into the statistics in sample order, so the results
+ * do not depend on the number of threads.
+ */
+class ISOMODEL_API MonteCarlo
+{
+public:
+  /**
+   * Period index of the annual statistics; months are 0 to 11.
+   */
+  static const int ANNUAL = 12;
+  static const int PERIODS = 13;
+
+  MonteCarlo(const UserModel& base, const SweepSpec& spec);
+
+  /**
+   * Simulates batches until spec.samples runs are done or the results converge.
+   * Returns true if they converged.
+   */
+  bool run(ThreadPool& pool);
+
+  /**
+   * Number of runs simulated so far.
+   */
+  size_t samples() const {
+    return m_samples;
+  }
+
+  bool converged() const {
+    return m_converged;
+  }
+
+  const RunningStats& stats(int endUse, int period) const {
+    return m_stats[index(endUse, period)];
+  }
+
+  const TDigest& distribution(int endUse, int period) const {
+    return m_digests[index(endUse, period)];
+  }
+
+  /**
+   * Half width of the confidence interval of the mean of an end use in a period.
+   */
+  double halfWidth(int endUse, int period) const;
+
+  /**
+   * Writes one CSV row per end use and period with the number of samples, the mean,
+   * standard deviation, range, 5th, 25th, 50th, 75th and 95th percentiles and the
+   * half width of the confidence interval of the mean.
+   */
+  void writeCsv(std::ostream& out) const;
+
+private:
+  static size_t index(int endUse, int period) {
+    return (size_t) endUse * PERIODS + period;
+  }
+
+  void add(const std::vector<EndUses>& monthly);
+  bool hasConverged() const;
+
+  UserModel m_base;
+  SimulationEngine m_engine;
+  std::vector<Distribution> m_distributions;
+  ParameterBinding m_binding;
+  size_t m_maxSamples;
+  size_t m_minSamples;
+  size_t m_batch;
+  double m_tolerance;
+  double m_z;
+  std::mt19937_64 m_random;
+  size_t m_samples;
+  bool m_converged;
+  std::vector<RunningStats> m_stats;
+  std::vector<TDigest> m_digests;
+};
+
+}
+}
+#endif
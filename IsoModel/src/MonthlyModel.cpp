@@ -17,7 +17,9 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  **********************************************************************/
 #include "MonthlyModel.hpp"
+#include "Cancellation.hpp"
 //to run main
+#include "SimulationPlan.hpp"
 #include "UserModel.hpp"
 
 namespace openstudio {
@@ -296,11 +298,11 @@ void MonthlyModel::scheduleAndOccupancy(Vector& weekdayOccupiedMegaseconds, Vect
     Vector& weekendUnoccupiedMegaseconds, Vector& clockHourOccupied, Vector& clockHourUnoccupied, double& frac_hrs_wk_day,
     double& hoursUnoccupiedPerDay, double& hoursOccupiedPerDay, double& frac_hrs_wk_nt, double& frac_hrs_wke_tot) const
 {
-  hoursOccupiedPerDay = pop.hoursEnd() - pop.hoursStart() + 1;
+  hoursOccupiedPerDay = pop->hoursEnd() - pop->hoursStart() + 1;
   if (hoursOccupiedPerDay < 0) {
     hoursOccupiedPerDay += 24;
   }
-  double daysOccupiedPerWeek = pop.daysEnd() - pop.daysStart() + 1;
+  double daysOccupiedPerWeek = pop->daysEnd() - pop->daysStart() + 1;
   if (daysOccupiedPerWeek < 0) {
     daysOccupiedPerWeek += 7;
   }
@@ -312,8 +314,8 @@ void MonthlyModel::scheduleAndOccupancy(Vector& weekdayOccupiedMegaseconds, Vect
   double hoursUnoccupiedDuringWeek = (daysOccupiedPerWeek - 1) * hoursUnoccupiedPerDay;
   frac_hrs_wk_nt = hoursUnoccupiedDuringWeek / hoursInWeek;
 
-  double occupationDensity = pop.densityOccupied();
-  double unoccupiedDensity = pop.densityUnoccupied();
+  double occupationDensity = pop->densityOccupied();
+  double unoccupiedDensity = pop->densityUnoccupied();
   double densityRatio = occupationDensity / unoccupiedDensity;
 
   double totalWeekendHours = hoursInWeek - hoursOccupiedDuringWeek - hoursUnoccupiedDuringWeek;
@@ -352,8 +354,8 @@ void MonthlyModel::solarRadiationBreakdown(const Vector& weekdayOccupiedMegaseco
     Vector& v_Tdbt_nt, Vector& v_Tdbt_Day) const
 {
   // Copy to a new variables so matrix nature is clear.
-  Matrix m_mhEgh = location.weather()->mhEgh();
-  Matrix m_mhdbt = location.weather()->mhdbt();
+  Matrix m_mhEgh = location->weather()->mhEgh();
+  Matrix m_mhdbt = location->weather()->mhdbt();
 
   // Note, these are matrix multiplies (matrix*vector) resulting in a vector.
 
@@ -435,15 +437,15 @@ void MonthlyModel::solarRadiationBreakdown(const Vector& weekdayOccupiedMegaseco
 void MonthlyModel::lightingEnergyUse(const Vector& v_hrs_sun_down_mo, double& Q_illum_occ, double& Q_illum_unocc, double& Q_illum_tot_yr,
     Vector& v_Q_illum_tot, Vector& v_Q_illum_ext_tot) const
 {
-  double lpd_occ = lights.powerDensityOccupied();
-  double lpd_unocc = lights.powerDensityUnoccupied();
+  double lpd_occ = lights->powerDensityOccupied();
+  double lpd_unocc = lights->powerDensityUnoccupied();
 
   // Daylight sensor dimming fraction.
-  double F_D = lights.dimmingFraction();
+  double F_D = lights->dimmingFraction();
   // Occupancy sensor control fraction.
-  double F_O = building.lightingOccupancySensor();
+  double F_O = building->lightingOccupancySensor();
   // Constant illimance control fraction.
-  double F_C = building.constantIllumination();
+  double F_C = building->constantIllumination();
 
   // TODO: The following assumes day starts at hour 7 and ends at hour 19
   // and 2 weeks per year are considered completely unoccupied for lighting
@@ -451,27 +453,27 @@ void MonthlyModel::lightingEnergyUse(const Vector& v_hrs_sun_down_mo, double& Q_
   // average sunup and sundown times.
 
   // Lighting operational hours during the daytime.
-  double t_lt_D = (std::min(lights.n_day_end(), pop.hoursEnd()) - std::max(pop.hoursStart(), lights.n_day_start()) + 1)
-      * (pop.daysEnd() - pop.daysStart() + 1) * lights.n_weeks();
+  double t_lt_D = (std::min(lights->n_day_end(), pop->hoursEnd()) - std::max(pop->hoursStart(), lights->n_day_start()) + 1)
+      * (pop->daysEnd() - pop->daysStart() + 1) * lights->n_weeks();
 
   // Lighting operational hours during the nighttime.
-  double t_lt_N = (std::max(lights.n_day_start() - pop.hoursStart(), 0.0) + std::max(pop.hoursEnd() - lights.n_day_end(), 0.0))
-      * (pop.daysEnd() - pop.daysStart() + 1) * lights.n_weeks();
+  double t_lt_N = (std::max(lights->n_day_start() - pop->hoursStart(), 0.0) + std::max(pop->hoursEnd() - lights->n_day_end(), 0.0))
+      * (pop->daysEnd() - pop->daysStart() + 1) * lights->n_weeks();
 
   // Unoccupied hours.
   double t_unocc = hoursInYear - t_lt_D - t_lt_N;
 
   // Total lighting energy for occupied times (kWh).
-  Q_illum_occ = structure.floorArea() * lpd_occ * F_C * F_O * (t_lt_D * F_D + t_lt_N) / 1000.0;
+  Q_illum_occ = structure->floorArea() * lpd_occ * F_C * F_O * (t_lt_D * F_D + t_lt_N) / 1000.0;
   // Total annual lighting energy for unnocupied times (kWh).
-  Q_illum_unocc = structure.floorArea() * lpd_unocc * t_unocc / 1000.0;
+  Q_illum_unocc = structure->floorArea() * lpd_unocc * t_unocc / 1000.0;
   // Total annual lighting energy (kWh).
   Q_illum_tot_yr = Q_illum_occ + Q_illum_unocc;
 
   // Split annual lighting energy into monthly lighting energy via the month fraction of the year (kWh).
   v_Q_illum_tot = mult(monthFractionOfYear, Q_illum_tot_yr, 12);
   // Total exterior lighting (kWh).
-  v_Q_illum_ext_tot = mult(v_hrs_sun_down_mo, lights.exteriorEnergy() / 1000.0);
+  v_Q_illum_ext_tot = mult(v_hrs_sun_down_mo, lights->exteriorEnergy() / 1000.0);
 }
 
 /**
@@ -481,10 +483,10 @@ void MonthlyModel::envelopCalculations(Vector& v_win_A, Vector& v_wall_emiss, Ve
     double& H_tr) const
 {
   // TODO: Copying the various structure values to new variables (e.g. v_wall_A) is not necessary. BAA@2015-07-13.
-  v_wall_A = structure.wallArea();
-  v_win_A = structure.windowArea();
-  v_wall_U = structure.wallUniform();
-  Vector v_win_U = structure.windowUniform();
+  v_wall_A = structure->wallArea();
+  v_win_A = structure->windowArea();
+  v_wall_U = structure->wallUniform();
+  Vector v_win_U = structure->windowUniform();
 
   // Compute total envelope U*A.
   Vector v_env_UA = sum(mult(v_wall_A, v_wall_U), mult(v_win_A, v_win_U));
@@ -503,8 +505,8 @@ void MonthlyModel::envelopCalculations(Vector& v_win_A, Vector& v_wall_emiss, Ve
   // Total transmission heat transfer coefficient. ISO 13790 8.3.1 eq. 17.
   H_tr = H_D + H_g + H_U + H_A;
 
-  v_wall_emiss = structure.wallThermalEmissivity();
-  v_wall_alpha_sc = structure.wallSolarAbsorption();
+  v_wall_emiss = structure->wallThermalEmissivity();
+  v_wall_alpha_sc = structure->wallSolarAbsorption();
 }
 
 /*
@@ -536,11 +538,13 @@ void MonthlyModel::windowSolarGain(const Vector& v_win_A, const Vector& v_wall_e
   Vector v_win_SDF_frac = Vector(vsize);
 
   for (int i = 0; i < vsize; i++) {
-    v_win_ff[i] = 1.0 - structure.win_ff();
+    v_win_ff[i] = 1.0 - structure->win_ff();
     // Assign SDF based on pulldown value of 1, 2 or 3.
     // TODO: This needs to be clarified in the .ism file as it's not obvious that the
     // window SDF is a magic number rather than the actual value. BAA@2015-07-13 BAA@2015-07-143
-    v_win_SDF[i] = n_win_SDF_table[((int) structure.windowShadingDevice()[i]) - 1];
+    // Values outside the table (e.g. 0 where a facade has no windows) mean no shading device.
+    int shadingDevice = (int) structure->windowShadingDevice()[i];
+    v_win_SDF[i] = (shadingDevice >= 1 && shadingDevice <= 3) ? n_win_SDF_table[shadingDevice - 1] : 1.0;
     // Set the SDF fractions which include heat transfer - set at 100% for now.
     v_win_SDF_frac[i] = 1.0;
   }
@@ -548,9 +552,9 @@ void MonthlyModel::windowSolarGain(const Vector& v_win_A, const Vector& v_wall_e
   Vector v_win_F_shgl = mult(v_win_SDF, v_win_SDF_frac);
 
   // Normal incidence solar energy transmittance which is SHGC in america.
-  Vector v_g_gln = structure.windowNormalIncidenceSolarEnergyTransmittance();
+  Vector v_g_gln = structure->windowNormalIncidenceSolarEnergyTransmittance();
   // Solar energy transmittance of glazing as per ISO 13790 11.4.2.
-  Vector v_g_gl = mult(v_g_gln, structure.win_F_W());
+  Vector v_g_gl = mult(v_g_gln, structure->win_F_W());
 
   v_win_A_sol = mult(mult(mult(v_win_F_shgl, v_g_gl), v_win_ff), v_win_A);
 
@@ -561,7 +565,7 @@ void MonthlyModel::windowSolarGain(const Vector& v_win_A, const Vector& v_wall_e
   // Vertical wall external convective surface heat resistances. 
   v_wall_R_sc = Vector(vsize);
   for (int i = 0; i < vsize; i++) {
-    v_wall_R_sc[i] = structure.R_sc_ext();
+    v_wall_R_sc[i] = structure->R_sc_ext();
   }
 
   // Window external radiative heat xfer coeff.
@@ -592,7 +596,7 @@ void MonthlyModel::solarHeatGain(const Vector& v_win_A_sol, const Vector& v_wall
   // calculate effective sky temp so we can better estimate theta_er and
   // theta_ss.
 
-  Vector v_win_SCF_frac(structure.windowShadingCorrectionFactor().size());
+  Vector v_win_SCF_frac(structure->windowShadingCorrectionFactor().size());
   for (unsigned int i = 0; i < v_win_SCF_frac.size(); i++) {
     // SCF fraction to include in HX. Fixed at 100% for now.
     v_win_SCF_frac[i] = 1;
@@ -602,9 +606,9 @@ void MonthlyModel::solarHeatGain(const Vector& v_win_A_sol, const Vector& v_wall
   Matrix m_I_sol(12, 9); // 12 months, 8 directions + 1 roof.
   for (unsigned int r = 0; r < m_I_sol.size1(); r++) {
     for (unsigned int c = 0; c < m_I_sol.size2() - 1; c++) {
-      m_I_sol(r, c) = location.weather()->msolar()(r, c);
+      m_I_sol(r, c) = location->weather()->msolar()(r, c);
     }
-    m_I_sol(r, m_I_sol.size2() - 1) = location.weather()->mEgh()[r];
+    m_I_sol(r, m_I_sol.size2() - 1) = location->weather()->mEgh()[r];
   }
   printMatrix("m_I_sol", m_I_sol);
 
@@ -613,7 +617,7 @@ void MonthlyModel::solarHeatGain(const Vector& v_win_A_sol, const Vector& v_wall
   Vector temp(9);
   for (unsigned int i = 0; i < v_win_phi_sol.size(); i++) {
     for (unsigned int j = 0; j < temp.size(); j++) {
-      temp[j] = structure.windowShadingCorrectionFactor()[j] * v_win_SCF_frac[j] * v_win_A_sol[j] * m_I_sol(i, j);
+      temp[j] = structure->windowShadingCorrectionFactor()[j] * v_win_SCF_frac[j] * v_win_A_sol[j] * m_I_sol(i, j);
     }
     v_win_phi_sol[i] = sum(temp);
   }
@@ -670,19 +674,19 @@ void MonthlyModel::heatGainsAndLosses(double frac_hrs_wk_day, double Q_illum_occ
     double& phi_plug_avg, double& phi_illum_avg, double& phi_int_wke_nt, double& phi_int_wke_day, double& phi_int_wk_nt) const
 {
   // Internal heat gains from people (W/m2).
-  double phi_int_occ = pop.heatGainPerPerson() / pop.densityOccupied();
-  double phi_int_unocc = pop.heatGainPerPerson() / pop.densityUnoccupied();
+  double phi_int_occ = pop->heatGainPerPerson() / pop->densityOccupied();
+  double phi_int_unocc = pop->heatGainPerPerson() / pop->densityUnoccupied();
   phi_int_avg = frac_hrs_wk_day * phi_int_occ + (1 - frac_hrs_wk_day) * phi_int_unocc;
 
   // Internal heat gain from appliances (W/m2).
-  double phi_plug_occ = building.electricApplianceHeatGainOccupied() + building.gasApplianceHeatGainOccupied();
-  double phi_plug_unocc = building.electricApplianceHeatGainUnoccupied() + building.gasApplianceHeatGainUnoccupied();
+  double phi_plug_occ = building->electricApplianceHeatGainOccupied() + building->gasApplianceHeatGainOccupied();
+  double phi_plug_unocc = building->electricApplianceHeatGainUnoccupied() + building->gasApplianceHeatGainUnoccupied();
   phi_plug_avg = phi_plug_occ * frac_hrs_wk_day + phi_plug_unocc * (1 - frac_hrs_wk_day);
 
   // Internal heat gain from illumination (W/m2).
-  double phi_illum_occ = Q_illum_occ / structure.floorArea() / hoursInYear / frac_hrs_wk_day * 1000;
-  double phi_illum_unocc = Q_illum_unocc / structure.floorArea() / hoursInYear / (1 - frac_hrs_wk_day) * 1000;
-  phi_illum_avg = Q_illum_tot_yr / structure.floorArea() / hoursInYear * 1000;
+  double phi_illum_occ = Q_illum_occ / structure->floorArea() / hoursInYear / frac_hrs_wk_day * 1000;
+  double phi_illum_unocc = Q_illum_unocc / structure->floorArea() / hoursInYear / (1 - frac_hrs_wk_day) * 1000;
+  phi_illum_avg = Q_illum_tot_yr / structure->floorArea() / hoursInYear * 1000;
 
 
   // Original spreadsheet computed the approximate internal heat gain for week nights, weekend days, and weekend nights
@@ -704,13 +708,13 @@ void MonthlyModel::heatGainsAndLosses(double frac_hrs_wk_day, double Q_illum_occ
 void MonthlyModel::internalHeatGain(double phi_int_avg, double phi_plug_avg, double phi_illum_avg, double& phi_I_tot) const
 {
   // Total occupant internal heat gain per year (W).
-  double phi_I_occ = phi_int_avg * structure.floorArea();
+  double phi_I_occ = phi_int_avg * structure->floorArea();
 
   // Total appliance internal heat gain per year (W). 
-  double phi_I_app = phi_plug_avg * structure.floorArea();
+  double phi_I_app = phi_plug_avg * structure->floorArea();
 
   // Total lighting internal heat gain per year (W).
-  double phi_I_lt = phi_illum_avg * structure.floorArea();
+  double phi_I_lt = phi_illum_avg * structure->floorArea();
 
   // Total internal heat gain (W).
   phi_I_tot = phi_I_occ + phi_I_app + phi_I_lt;
@@ -725,9 +729,9 @@ void MonthlyModel::unoccupiedHeatGain(double phi_int_wk_nt, double phi_int_wke_d
     Vector& v_P_tot_wke_nt) const
 {
   // Internal heat gain for unoccupied times (MJ).
-  Vector v_W_int_wk_nt = mult(weekdayUnoccupiedMegaseconds, phi_int_wk_nt * structure.floorArea());
-  Vector v_W_int_wke_day = mult(weekendOccupiedMegaseconds, phi_int_wke_day * structure.floorArea());
-  Vector v_W_int_wke_nt = mult(weekendUnoccupiedMegaseconds, phi_int_wke_nt * structure.floorArea());
+  Vector v_W_int_wk_nt = mult(weekdayUnoccupiedMegaseconds, phi_int_wk_nt * structure->floorArea());
+  Vector v_W_int_wke_day = mult(weekendOccupiedMegaseconds, phi_int_wke_day * structure->floorArea());
+  Vector v_W_int_wke_nt = mult(weekendUnoccupiedMegaseconds, phi_int_wke_nt * structure->floorArea());
   printVector("v_W_int_wk_nt", v_W_int_wk_nt);
   printVector("v_W_int_wke_day", v_W_int_wke_day);
   printVector("v_W_int_wke_nt", v_W_int_wke_nt);
@@ -758,7 +762,7 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
   // effective heating temp and raising the effective cooling temp during
   // times of control (i.e. during occupancy).  
   double T_adj = 0;
-  switch ((int) building.buildingEnergyManagement()) {
+  switch ((int) building->buildingEnergyManagement()) {
   case 1:
     T_adj = 0.0;
     break;
@@ -771,18 +775,18 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
   }
 
   if (DEBUG_ISO_MODEL_SIMULATION) {
-    std::cout << "BEM: " << building.buildingEnergyManagement() << ", " << ((int) building.buildingEnergyManagement()) << std::endl;
+    std::cout << "BEM: " << building->buildingEnergyManagement() << ", " << ((int) building->buildingEnergyManagement()) << std::endl;
     std::cout << "T_adj: " << T_adj << std::endl;
   }
 
   // Adjust the heating set points.
-  double ht_tset_ctrl = heating.temperatureSetPointOccupied() - T_adj;
-  double cl_tset_ctrl = cooling.temperatureSetPointOccupied() + T_adj;
+  double ht_tset_ctrl = heating->temperatureSetPointOccupied() - T_adj;
+  double cl_tset_ctrl = cooling->temperatureSetPointOccupied() + T_adj;
 
   // During unoccupied times, we use a setback temp and even if we have a BEM
   // it has no effect.
-  double ht_tset_unocc = heating.temperatureSetPointUnoccupied();
-  double cl_tset_unocc = cooling.temperatureSetPointUnoccupied();
+  double ht_tset_unocc = heating->temperatureSetPointUnoccupied();
+  double cl_tset_unocc = cooling->temperatureSetPointUnoccupied();
 
   Vector v_ht_tset_ctrl(12);
   Vector v_cl_tset_ctrl(12);
@@ -799,16 +803,16 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
   }
 
   // Interior heat capacity (J/k).
-  double Cm_int = structure.interiorHeatCapacity() * structure.floorArea();
+  double Cm_int = structure->interiorHeatCapacity() * structure->floorArea();
 
   // Envelope heat capacity (J/k).
-  double Cm_env = structure.wallHeatCapacity() * sum(v_wall_A);
+  double Cm_env = structure->wallHeatCapacity() * sum(v_wall_A);
 
   // Total heat capacity (J/k).
   double Cm = Cm_int + Cm_env;
 
   // Total heat transfer coefficient.
-  double H_tot = H_tr + ventilation.H_ve();
+  double H_tot = H_tr + ventilation->H_ve();
 
   // Building time constant in hours as pwer ISO 13790 12.2.1.3 eq. 62.
   tau = Cm / H_tot / 3600.0;
@@ -866,7 +870,7 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
   }
 
   // Compute the change in temp from setback to another heating temp in unoccupied times 
-  if (heating.T_ht_ctrl_flag() == 1) { // If the HVAC heating controls are turned on.
+  if (heating->T_ht_ctrl_flag() == 1) { // If the HVAC heating controls are turned on.
     Matrix M_Ta(12, 4);
     Vector v_Tstart(v_ht_tset_ctrl);
     for (unsigned int i = 0; i < M_Ta.size2(); i++) {
@@ -945,7 +949,7 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
 
   // If cooling is on, find the temp decay after any changes in cooling temp setpoint.
   // TODO: Consider pulling this giant if statement into its own function. -BAA@2015-07-14
-  if (cooling.T_cl_ctrl_flag() == 1) {
+  if (cooling->T_cl_ctrl_flag() == 1) {
     Matrix M_Tc(12, 4);
     Vector v_Tstart(v_cl_tset_ctrl);
     for (unsigned int i = 0; i < M_Tc.size2(); i++) {
@@ -1031,13 +1035,13 @@ void MonthlyModel::interiorTemp(const Vector& v_wall_A, const Vector& v_P_tot_wk
 void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_avg, double frac_hrs_wk_day, Vector& v_Hve_ht, Vector& v_Hve_cl) const
 {
   // Ventilation Zone Height (m) with a minimum of 0.1 m.
-  double vent_zone_height = std::max(0.1, structure.buildingHeight());
+  double vent_zone_height = std::max(0.1, structure->buildingHeight());
 
   // Vent supply rate m3/h/m2 (input is in in L/s).
-  double qv_supp = ventilation.supplyRate() / structure.floorArea() / 3.6;
+  double qv_supp = ventilation->supplyRate() / structure->floorArea() / 3.6;
 
   // Vent exhaust rate m3/h/m2, negative indicates out of building.
-  double qv_ext = -(qv_supp - ventilation.supplyDifference() / structure.floorArea() / 3.6);
+  double qv_ext = -(qv_supp - ventilation->supplyDifference() / structure->floorArea() / 3.6);
 
   // Combustion appliance ventilation rate - not implemented yet but will be impt for restaurants.
   double qv_comb = 0;
@@ -1045,12 +1049,12 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
   // Difference between air intake and air exhaust including combustion exhaust.
   double qv_diff = qv_supp + qv_ext + qv_comb;
 
-  double vent_ht_recov = ventilation.heatRecoveryEfficiency();
+  double vent_ht_recov = ventilation->heatRecoveryEfficiency();
 
-  double vent_outdoor_frac = 1 - ventilation.exhaustAirRecirculated();
+  double vent_outdoor_frac = 1 - ventilation->exhaustAirRecirculated();
 
   // Infilatration source EN 15242:2007 Sec 6.7 direct method
-  double tot_env_A = sum(structure.wallArea()) + sum(structure.windowArea());
+  double tot_env_A = sum(structure->wallArea()) + sum(structure->windowArea());
 
   // Infiltration data from:
   // Tamura, (1976), Studies on exterior wall air tightness and air infiltration of tall buildings, ASHRAE Transactions, 82(1), 122-134.
@@ -1058,38 +1062,38 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
   // Emmerich, (2005), Investigation of the Impact of Commercial Building Envelope Airtightness on HVAC Energy Use.
 
   // Infiltration rate in m3/h/m2 @ 75 Pa based on wall area.
-  double v_Q75pa = structure.infiltrationRate();
+  double v_Q75pa = structure->infiltrationRate();
 
   // Convert infiltration to Q@4Pa in m3/h /m2 based on floor area. 
-  double v_Q4pa = v_Q75pa * tot_env_A / structure.floorArea() * (std::pow((4.0 / 75.0), ventilation.p_exp()));
+  double v_Q4pa = v_Q75pa * tot_env_A / structure->floorArea() * (std::pow((4.0 / 75.0), ventilation->p_exp()));
 
   // Effective stack height.
-  double h_stack = ventilation.zone_frac() * vent_zone_height;
+  double h_stack = ventilation->zone_frac() * vent_zone_height;
 
-  Vector dbtDiff = dif(location.weather()->mdbt(), v_Th_avg);
+  Vector dbtDiff = dif(location->weather()->mdbt(), v_Th_avg);
   printVector("dbtDiff", dbtDiff);
   Vector dbtDiffAbs = abs(dbtDiff);
   printVector("dbtDiffAbs", dbtDiffAbs);
   Vector dbtHStack = mult(dbtDiffAbs, h_stack);
   printVector("dbtHstack", dbtHStack);
-  Vector dbtPowered = pow(dbtHStack, ventilation.stack_exp());
+  Vector dbtPowered = pow(dbtHStack, ventilation->stack_exp());
   printVector("dbtPowered", dbtPowered);
-  Vector dbtMultQ4 = mult(dbtPowered, ventilation.stack_coeff() * v_Q4pa);
+  Vector dbtMultQ4 = mult(dbtPowered, ventilation->stack_coeff() * v_Q4pa);
   printVector("dbtMultQ4", dbtMultQ4);
 
   // Calculate the infiltration from stack effect pressure difference for heating from EN 15242: sec 6.7.1 (m3/h/m2).
   Vector v_qv_stack_ht = maximum(dbtMultQ4, 0.001);
 
   // Recalculate for cooling.
-  dbtDiff = dif(location.weather()->mdbt(), v_Tc_avg);
+  dbtDiff = dif(location->weather()->mdbt(), v_Tc_avg);
   printVector("dbtDiff", dbtDiff);
   dbtDiffAbs = abs(dbtDiff);
   printVector("dbtDiffAbs", dbtDiffAbs);
   dbtHStack = mult(dbtDiffAbs, h_stack);
   printVector("dbtHstack", dbtHStack);
-  dbtPowered = pow(dbtHStack, ventilation.stack_exp());
+  dbtPowered = pow(dbtHStack, ventilation->stack_exp());
   printVector("dbtPowered", dbtPowered);
-  dbtMultQ4 = mult(dbtPowered, ventilation.stack_coeff() * v_Q4pa);
+  dbtMultQ4 = mult(dbtPowered, ventilation->stack_coeff() * v_Q4pa);
   printVector("dbtMultQ4", dbtMultQ4);
 
   // Calculate the infiltration from stack effect pressure difference for cooling from EN 15242: sec 6.7.1 (m3/h/m2).
@@ -1097,10 +1101,10 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
   printVector("v_qv_stack_ht", v_qv_stack_ht);
   printVector("v_qv_stack_cl", v_qv_stack_cl);
 
-  Vector v_qv_wind_ht = mult(mult(pow(mult(mult(location.weather()->mwind(), location.weather()->mwind()), ventilation.dCp() * location.terrain()),
-                             ventilation.wind_exp()), v_Q4pa), ventilation.wind_coeff());
-  Vector v_qv_wind_cl = mult(mult(pow(mult(mult(location.weather()->mwind(), location.weather()->mwind()), ventilation.dCp() * location.terrain()),
-                             ventilation.wind_exp()), v_Q4pa), ventilation.wind_coeff());
+  Vector v_qv_wind_ht = mult(mult(pow(mult(mult(location->weather()->mwind(), location->weather()->mwind()), ventilation->dCp() * location->terrain()),
+                             ventilation->wind_exp()), v_Q4pa), ventilation->wind_coeff());
+  Vector v_qv_wind_cl = mult(mult(pow(mult(mult(location->weather()->mwind(), location->weather()->mwind()), ventilation->dCp() * location->terrain()),
+                             ventilation->wind_exp()), v_Q4pa), ventilation->wind_coeff());
   printVector("v_qv_wind_ht", v_qv_wind_ht);
   printVector("v_qv_wind_cl", v_qv_wind_cl);
 
@@ -1134,7 +1138,7 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
   // 2 if we assume ventilation rate is dropped proportionally to population
   // set to 1 to mimic the behavior of the original spreadsheet.
   double vent_op_frac;
-  switch (ventilation.vent_rate_flag()) {
+  switch (ventilation->vent_rate_flag()) {
   case 0:
     vent_op_frac = 1;
     break;
@@ -1142,11 +1146,11 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
     vent_op_frac = frac_hrs_wk_day;
     break;
   default:
-    vent_op_frac = frac_hrs_wk_day + (1 - frac_hrs_wk_day) * pop.densityOccupied() / pop.densityUnoccupied();
+    vent_op_frac = frac_hrs_wk_day + (1 - frac_hrs_wk_day) * pop->densityOccupied() / pop->densityUnoccupied();
     break;
   }
 
-  double initVal = ventilation.ventType() == 3 ? 0 : (vent_op_frac * qv_supp * vent_outdoor_frac * (1 - vent_ht_recov));
+  double initVal = ventilation->ventType() == 3 ? 0 : (vent_op_frac * qv_supp * vent_outdoor_frac * (1 - vent_ht_recov));
   Vector v_qv_mve_ht(12, initVal);
   Vector v_qv_mve_cl(12, initVal);
 
@@ -1158,9 +1162,9 @@ void MonthlyModel::ventilationCalc(const Vector& v_Th_avg, const Vector& v_Tc_av
   printVector("v_qve_cl", v_qve_cl);
 
   // Hve heating (W/K/m2).
-  v_Hve_ht = div(mult(v_qve_ht, phys.rhoCpAir()*1000000), 3600.0); // Multiply rhoCpAir by 1000000 to convert from MJ to W.
+  v_Hve_ht = div(mult(v_qve_ht, phys->rhoCpAir()*1000000), 3600.0); // Multiply rhoCpAir by 1000000 to convert from MJ to W.
   // Hve cooling (W/K/m2).
-  v_Hve_cl = div(mult(v_qve_cl, phys.rhoCpAir()*1000000), 3600.0); // Multiply rhoCpAir by 1000000 to convert from MJ to W.
+  v_Hve_cl = div(mult(v_qve_cl, phys->rhoCpAir()*1000000), 3600.0); // Multiply rhoCpAir by 1000000 to convert from MJ to W.
 }
 
 /**
@@ -1177,12 +1181,12 @@ void MonthlyModel::heatingAndCooling(const Vector& v_E_sol, const Vector& v_Th_a
   Vector v_tot_mo_ht_gain = sum(temp, v_E_sol);
 
   // Building heating dimensionless constant.
-  double a_H = heating.a_H0() + tau / heating.tau_H0();
+  double a_H = heating->a_H0() + tau / heating->tau_H0();
 
   // Heat transfer (loss) by transmission, heating (MJ).
-  Vector v_QT_ht = mult(mult(dif(v_Th_avg, location.weather()->mdbt()), megasecondsInMonth), H_tr);
+  Vector v_QT_ht = mult(mult(dif(v_Th_avg, location->weather()->mdbt()), megasecondsInMonth), H_tr);
   // Heat transfer (loss) by ventilation, heating (MJ).
-  Vector v_QV_ht = mult(mult(mult(v_Hve_ht, structure.floorArea()), dif(v_Th_avg, location.weather()->mdbt())), megasecondsInMonth);
+  Vector v_QV_ht = mult(mult(mult(v_Hve_ht, structure->floorArea()), dif(v_Th_avg, location->weather()->mdbt())), megasecondsInMonth);
   // Total heat transfer (loss) (MJ). ISO 13790 7.2.1.3 eq. 7.
   Vector v_Qtot_ht = sum(v_QT_ht, v_QV_ht);
 
@@ -1203,9 +1207,9 @@ void MonthlyModel::heatingAndCooling(const Vector& v_E_sol, const Vector& v_Th_a
   Qneed_ht_yr = sum(v_Qneed_ht);
 
   // Heat transfer (loss) by transmission, cooling (MJ).
-  Vector v_QT_cl = mult(mult(dif(v_Tc_avg, location.weather()->mdbt()), H_tr), megasecondsInMonth);
+  Vector v_QT_cl = mult(mult(dif(v_Tc_avg, location->weather()->mdbt()), H_tr), megasecondsInMonth);
   // Heat transfer (loss) by ventilation, cooling (MJ).
-  Vector v_QV_cl = mult(mult(mult(v_Hve_cl, structure.floorArea()), dif(v_Tc_avg, location.weather()->mdbt())), megasecondsInMonth);
+  Vector v_QV_cl = mult(mult(mult(v_Hve_cl, structure->floorArea()), dif(v_Tc_avg, location->weather()->mdbt())), megasecondsInMonth);
   // Total heat transfer (loss), cooling (MJ). ISO 13790 7.2.1.3 eq. 7.
   Vector v_Qtot_cl = sum(v_QT_cl, v_QV_cl);
 
@@ -1229,14 +1233,14 @@ void MonthlyModel::heatingAndCooling(const Vector& v_E_sol, const Vector& v_Th_a
   Qneed_cl_yr = sum(v_Qneed_cl);
 
   // Hot air supply temperature (C).
-  double T_sup_ht = heating.temperatureSetPointOccupied() + heating.dT_supp_ht();
+  double T_sup_ht = heating->temperatureSetPointOccupied() + heating->dT_supp_ht();
   // Cool air supply temperature (C).
-  double T_sup_cl = cooling.temperatureSetPointOccupied() - cooling.dT_supp_cl();
+  double T_sup_cl = cooling->temperatureSetPointOccupied() - cooling->dT_supp_cl();
 
   // Volume of air moved for heating (m3).
-  Vector v_Vair_ht = div(v_Qneed_ht, sum(mult(dif(T_sup_ht, v_Th_avg), phys.rhoCpAir()), DBL_MIN));
+  Vector v_Vair_ht = div(v_Qneed_ht, sum(mult(dif(T_sup_ht, v_Th_avg), phys->rhoCpAir()), DBL_MIN));
   // Volume of air moved for cooling (m3).
-  Vector v_Vair_cl = div(v_Qneed_cl, sum(mult(dif(v_Tc_avg, T_sup_cl), phys.rhoCpAir()), DBL_MIN));
+  Vector v_Vair_cl = div(v_Qneed_cl, sum(mult(dif(v_Tc_avg, T_sup_cl), phys->rhoCpAir()), DBL_MIN));
 
   printVector("v_Vair_ht", v_Vair_ht);
   printVector("v_Vair_cl", v_Vair_cl);
@@ -1244,22 +1248,22 @@ void MonthlyModel::heatingAndCooling(const Vector& v_E_sol, const Vector& v_Th_a
   // Total air flow (m3).
   // Multiply by 1000000 to convert megaseconds to seconds.
   // Divide by 1000 to convert liters to m3.
-  Vector v_Vair_tot = maximum(sum(v_Vair_ht, v_Vair_cl), div(mult(megasecondsInMonth, ventilation.supplyRate() * frac_hrs_wk_day * 1000000.0, 12), 1000));
+  Vector v_Vair_tot = maximum(sum(v_Vair_ht, v_Vair_cl), div(mult(megasecondsInMonth, ventilation->supplyRate() * frac_hrs_wk_day * 1000000.0, 12), 1000));
   printVector("v_Vair_tot", v_Vair_tot);
 
   // Fan power (MJ)
   // ventilation.fanPower is in W/L/s is also J/L which is also kJ/m3. Divide by 1000 for MJ/m3 to get fanEnergy in MJ.
-  Vector fanEnergy = mult(v_Vair_tot, ventilation.fanPower() * ventilation.fanControlFactor() / 1000.0);
+  Vector fanEnergy = mult(v_Vair_tot, ventilation->fanPower() * ventilation->fanControlFactor() / 1000.0);
   printVector("fanEnergy", fanEnergy);
 
   if (DEBUG_ISO_MODEL_SIMULATION) {
-    std::cout << "ventilation.fanPower() = " << ventilation.fanPower() << std::endl;
-    std::cout << "ventilation.fanControlFactor() = " << ventilation.fanControlFactor() << std::endl;
-    std::cout << "structure.floorArea() = " << structure.floorArea() << std::endl;
+    std::cout << "ventilation->fanPower() = " << ventilation->fanPower() << std::endl;
+    std::cout << "ventilation->fanControlFactor() = " << ventilation->fanControlFactor() << std::endl;
+    std::cout << "structure->floorArea() = " << structure->floorArea() << std::endl;
   }
 
   // Calculate fan EUI (kWh/m2).
-  v_Qfan_tot = div(div(fanEnergy, structure.floorArea()), 3.6);
+  v_Qfan_tot = div(div(fanEnergy, structure->floorArea()), 3.6);
 }
 
 /**
@@ -1290,13 +1294,13 @@ void MonthlyModel::hvac(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
   // From EN 15243-2007 Annex E.
   // HVAC system info table from EN 15243:2007 Table E1.
   // The integrated energy efficiency ratio (IEER) is the effective average COP for the system.
-  double IEER = cooling.cop() * cooling.partialLoadValue();
+  double IEER = cooling->cop() * cooling->partialLoadValue();
 
   // Copy over the HVAC loss/waste factors into local variables with names
   // that match the equations better
-  double f_waste = heating.hotcoldWasteFactor();
-  double a_ht_loss = heating.hvacLossFactor();
-  double a_cl_loss = cooling.hvacLossFactor();
+  double f_waste = heating->hotcoldWasteFactor();
+  double a_ht_loss = heating->hvacLossFactor();
+  double a_cl_loss = cooling->hvacLossFactor();
 
   // Fraction of yearly heating demand with regard to total heating + cooling demand.
   double f_dem_ht = std::max(Qneed_ht_yr / (Qneed_cl_yr + Qneed_ht_yr), 0.1);
@@ -1320,13 +1324,13 @@ void MonthlyModel::hvac(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
   Vector v_Qcl_sys(12, 0.0);
   Vector v_Qcool_DC(12, 0.0);
 
-  if (heating.DH_YesNo() == 1) {
+  if (heating->DH_YesNo() == 1) {
     v_Qht_DH = sum(v_Qneed_ht, v_Qloss_ht_dist);
   } else {
-    v_Qht_sys = div(sum(v_Qloss_ht_dist, v_Qneed_ht), heating.efficiency() + DBL_MIN);
+    v_Qht_sys = div(sum(v_Qloss_ht_dist, v_Qneed_ht), heating->efficiency() + DBL_MIN);
   }
 
-  if (cooling.DC_YesNo() == 1) {
+  if (cooling->DC_YesNo() == 1) {
     v_Qcool_DC = sum(v_Qneed_cl, v_Qloss_cl_dist);
   } else {
     v_Qcl_sys = div(sum(v_Qloss_cl_dist, v_Qneed_cl), IEER + DBL_MIN);
@@ -1356,12 +1360,12 @@ void MonthlyModel::hvac(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
 
 
    */
-  Vector v_Qcl_DC_elec = div(mult(v_Qcool_DC, 1 - cooling.eta_DC_frac_abs()), cooling.eta_DC_COP() * cooling.eta_DC_network());
-  Vector v_Qcl_DC_abs = div(mult(v_Qcool_DC, 1 - cooling.frac_DC_free()), cooling.eta_DC_COP_abs());
+  Vector v_Qcl_DC_elec = div(mult(v_Qcool_DC, 1 - cooling->eta_DC_frac_abs()), cooling->eta_DC_COP() * cooling->eta_DC_network());
+  Vector v_Qcl_DC_abs = div(mult(v_Qcool_DC, 1 - cooling->frac_DC_free()), cooling->eta_DC_COP_abs());
   printVector("v_Qcl_DC_elec", v_Qcl_DC_elec);
   printVector("v_Qcl_DC_abs", v_Qcl_DC_abs);
 
-  Vector v_Qht_DH_total = div(mult(v_Qht_DH, 1 - heating.frac_DH_free()), heating.eta_DH_sys() * heating.eta_DH_network());
+  Vector v_Qht_DH_total = div(mult(v_Qht_DH, 1 - heating->frac_DH_free()), heating->eta_DH_sys() * heating->eta_DH_network());
   v_Qcl_elec_tot = sum(v_Qcl_sys, v_Qcl_DC_elec);
   v_Qcl_gas_tot = v_Qcl_DC_abs;
   printVector("v_Qht_DH_total", v_Qht_DH_total);
@@ -1370,7 +1374,7 @@ void MonthlyModel::hvac(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
 
   //Vector v_Qelec_ht,v_Qgas_ht;
 
-  if (heating.energyType() == 1) {
+  if (heating->energyType() == 1) {
     v_Qelec_ht = v_Qht_sys;
     v_Qgas_ht = v_Qht_DH_total;
   } else {
@@ -1408,23 +1412,23 @@ void MonthlyModel::hvac(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
 void MonthlyModel::pump(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, double Qneed_ht_yr, double Qneed_cl_yr, Vector& v_Q_pump_tot) const
 {
   // TODO: The current implementation is wrong. It either needs to be revised to be more like the hourly implementation where the pump energy
-  // is multiplied by the amount of time the pumps are actually on or heating.E_pumps()/cooling.E_pumps() needs to be expressed in terms of the
+  // is multiplied by the amount of time the pumps are actually on or heating->E_pumps()/cooling->E_pumps() needs to be expressed in terms of the
   // heating/cooling delivered so that the pump energy can be determined by multiplying it by the heating/cooling delivered. Both methods
   // have challenges, which is why they are not yet implements. Until then, consider the monthly pump values unreliable. BAA@2015-07-15.
 
   // Total annual pump energy for heating systems if the pumps are running continuously.
   // NOTE: This assumption (that the annual pump energy is equal to the energy of the pumps running continuosly) is the source of the
   // problems in the pump results. BAA@2015-07-15.
-  double Q_pumps_yr_ht = sum(mult(megasecondsInMonth, heating.E_pumps(), 12));
+  double Q_pumps_yr_ht = sum(mult(megasecondsInMonth, heating->E_pumps(), 12));
   // Total annual pump energy for cooling systems if the pumps are running continuously.
-  double Q_pumps_yr_cl = sum(mult(megasecondsInMonth, cooling.E_pumps(), 12));
+  double Q_pumps_yr_cl = sum(mult(megasecondsInMonth, cooling->E_pumps(), 12));
 
   // Fraction of time the system is in heating mode each month.
   Vector v_frac_ht_mode = div(v_Qneed_ht, sum(v_Qneed_ht, v_Qneed_cl));
   // Total heating energy fraction.
   double frac_ht_total = sum(v_frac_ht_mode);
   // Total yearly pump energy.
-  double Q_pumps_ht = Q_pumps_yr_ht * heating.pumpControlReduction() * structure.floorArea();
+  double Q_pumps_ht = Q_pumps_yr_ht * heating->pumpControlReduction() * structure->floorArea();
   // Distribute the total annual pump energy between the 12 months proportional to the distribution of the heating
   Vector v_Q_pumps_ht = div(mult(v_frac_ht_mode, Q_pumps_ht), frac_ht_total);
 
@@ -1433,7 +1437,7 @@ void MonthlyModel::pump(const Vector& v_Qneed_ht, const Vector& v_Qneed_cl, doub
   // Total cooling energy fraction.
   double frac_cl_total = sum(v_frac_cl_mode);
   // Total yearly pump energy.
-  double Q_pumps_cl = Q_pumps_yr_cl * cooling.pumpControlReduction() * structure.floorArea();
+  double Q_pumps_cl = Q_pumps_yr_cl * cooling->pumpControlReduction() * structure->floorArea();
   // Distribute the total annual pump energy between the 12 months proportional to the distribution of the cooling.
   Vector v_Q_pumps_cl = div(mult(v_frac_cl_mode, Q_pumps_cl), frac_cl_total);
 
@@ -1470,16 +1474,16 @@ void MonthlyModel::heatedWater(Vector& v_Q_dhw_elec, Vector& v_Q_dhw_gas) const
   zero(v_Q_dhw_solar);
 
   // Total annual energy demand required for heating DHW (MJ/yr).
-  double Q_dhw_yr = heating.hotWaterDemand() * (heating.dhw_tset() - heating.dhw_tsupply()) * phys.rhoCpWater();
+  double Q_dhw_yr = heating->hotWaterDemand() * (heating->dhw_tset() - heating->dhw_tsupply()) * phys->rhoCpWater();
 
   Vector v_MonthlyDemand = mult(daysInMonth, Q_dhw_yr, 12);
   Vector v_frac_MonthlyDemand_yr = div(v_MonthlyDemand, daysInYear);
-  Vector v_Qe_demand = div(v_frac_MonthlyDemand_yr, heating.hotWaterDistributionEfficiency());
+  Vector v_Qe_demand = div(v_frac_MonthlyDemand_yr, heating->hotWaterDistributionEfficiency());
 
   // Monthly DHW energy demand including distribution efficiency.
   Vector v_Q_dhw_demand = div(v_Qe_demand, kWh2MJ);
   // Total monthly supply need is (demand - solar)/system efficiency.
-  Vector v_Q_dhw_need = maximum(div(dif(v_Q_dhw_demand, v_Q_dhw_solar), heating.hotWaterSystemEfficiency()), 0);
+  Vector v_Q_dhw_need = maximum(div(dif(v_Q_dhw_demand, v_Q_dhw_solar), heating->hotWaterSystemEfficiency()), 0);
 
   // Vector of zeroes for fuel type that is unused.
   Vector Z(v_Q_dhw_need.size(), 0.0);
@@ -1491,7 +1495,7 @@ void MonthlyModel::heatedWater(Vector& v_Q_dhw_elec, Vector& v_Q_dhw_gas) const
   printVector("v_Q_dhw_need", v_Q_dhw_need);
   printVector("Z", Z);
 
-  if (heating.hotWaterEnergyType() == 1) {
+  if (heating->hotWaterEnergyType() == 1) {
     v_Q_dhw_elec = v_Q_dhw_need;
     v_Q_dhw_gas = Z;
   } else {
@@ -1502,7 +1506,55 @@ void MonthlyModel::heatedWater(Vector& v_Q_dhw_elec, Vector& v_Q_dhw_gas) const
   printVector("v_Q_dhw_elec", v_Q_dhw_elec);
 }
 
+namespace {
+
+Vector toVector(const double* values)
+{
+  Vector v(9);
+  for (int i = 0; i < 9; i++) {
+    v[i] = values[i];
+  }
+  return v;
+}
+
+void fromVector(const Vector& v, double* values)
+{
+  for (int i = 0; i < 9; i++) {
+    values[i] = v[i];
+  }
+}
+
+}
+
+EnvelopePlan MonthlyModel::envelope() const
+{
+  Vector v_win_A, v_wall_emiss, v_wall_alpha_sc, v_wall_U, v_wall_A;
+  Vector v_wall_A_sol, v_win_hr, v_wall_R_sc, v_win_A_sol;
+  EnvelopePlan plan;
+  envelopCalculations(v_win_A, v_wall_emiss, v_wall_alpha_sc, v_wall_U, v_wall_A, plan.H_tr);
+  windowSolarGain(v_win_A, v_wall_emiss, v_wall_alpha_sc, v_wall_U, v_wall_A, v_wall_A_sol, v_win_hr, v_wall_R_sc, v_win_A_sol);
+
+  fromVector(v_wall_A, plan.wallArea);
+  fromVector(v_win_A, plan.windowArea);
+  fromVector(v_wall_U, plan.wallU);
+  fromVector(v_wall_emiss, plan.wallEmissivity);
+  fromVector(v_wall_alpha_sc, plan.wallSolarAbsorption);
+  fromVector(v_wall_A_sol, plan.wallSolarArea);
+  fromVector(v_win_A_sol, plan.windowSolarArea);
+  fromVector(v_win_hr, plan.windowRadiativeCoefficient);
+  fromVector(v_wall_R_sc, plan.wallExternalResistance);
+  return plan;
+}
+
 std::vector<EndUses> MonthlyModel::simulate() const
+{
+  if (cache) {
+    return cache->getOrCompute(resultKey(MONTHLY_RESULTS), [this]() { return simulate(envelope()); });
+  }
+  return simulate(envelope());
+}
+
+std::vector<EndUses> MonthlyModel::simulate(const EnvelopePlan& envelope) const
 {
   Vector weekdayOccupiedMegaseconds(12);
   Vector weekdayUnoccupiedMegaseconds(12);
@@ -1544,6 +1596,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
   Vector v_Qelec_ht, v_Qcl_elec_tot, v_Q_illum_tot, v_Q_illum_ext_tot, v_Qfan_tot, v_Q_pump_tot, v_Q_dhw_elec, v_Qgas_ht, v_Qcl_gas_tot, v_Q_dhw_gas;
 
+  checkCancellation();
   frac_hrs_wk_day = hoursUnoccupiedPerDay = hoursOccupiedPerDay = frac_hrs_wk_nt = frac_hrs_wke_tot = 1;
 
   //openstudio::isomodel::loadDefaults(monthlyModel);
@@ -1569,6 +1622,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "solarRadiationBreakdown: " << std::endl;
   }
+  checkCancellation();
   solarRadiationBreakdown(weekdayOccupiedMegaseconds, weekdayUnoccupiedMegaseconds, weekendOccupiedMegaseconds, weekendUnoccupiedMegaseconds,
       clockHourOccupied, clockHourUnoccupied, v_hrs_sun_down_mo, frac_Pgh_wk_nt, frac_Pgh_wke_day, frac_Pgh_wke_nt, v_Tdbt_nt, v_Tdbt_day);
 
@@ -1591,16 +1645,21 @@ std::vector<EndUses> MonthlyModel::simulate() const
     printVector("v_Q_illum_ext_tot", v_Q_illum_ext_tot);
 
     std::cout << std::endl << "envelopCalculations: " << std::endl;/*
-     v_wall_A = structure.wallArea();
-     v_win_A = structure.windowArea();
-     v_wall_U = structure.wallUniform();
-     Vector v_win_U = structure.windowUniform();*/
-    printVector("structure.wallArea()", structure.wallArea());
-    printVector("structure.windowArea()", structure.windowArea());
-    printVector("structure.wallUniform()", structure.wallUniform());
-    printVector("structure.windowUniform()", structure.windowUniform());
-  }
-  envelopCalculations(v_win_A, v_wall_emiss, v_wall_alpha_sc, v_wall_U, v_wall_A, H_tr);
+     v_wall_A = structure->wallArea();
+     v_win_A = structure->windowArea();
+     v_wall_U = structure->wallUniform();
+     Vector v_win_U = structure->windowUniform();*/
+    printVector("structure->wallArea()", structure->wallArea());
+    printVector("structure->windowArea()", structure->windowArea());
+    printVector("structure->wallUniform()", structure->wallUniform());
+    printVector("structure->windowUniform()", structure->windowUniform());
+  }
+  v_win_A = toVector(envelope.windowArea);
+  v_wall_emiss = toVector(envelope.wallEmissivity);
+  v_wall_alpha_sc = toVector(envelope.wallSolarAbsorption);
+  v_wall_U = toVector(envelope.wallU);
+  v_wall_A = toVector(envelope.wallArea);
+  H_tr = envelope.H_tr;
   if (DEBUG_ISO_MODEL_SIMULATION) {
     std::cout << "H_tr: " << H_tr << std::endl;
     printVector("v_win_A", v_win_A);
@@ -1611,7 +1670,10 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "windowSolarGain: " << std::endl;
   }
-  windowSolarGain(v_win_A, v_wall_emiss, v_wall_alpha_sc, v_wall_U, v_wall_A, v_wall_A_sol, v_win_hr, v_wall_R_sc, v_win_A_sol);
+  v_wall_A_sol = toVector(envelope.wallSolarArea);
+  v_win_hr = toVector(envelope.windowRadiativeCoefficient);
+  v_wall_R_sc = toVector(envelope.wallExternalResistance);
+  v_win_A_sol = toVector(envelope.windowSolarArea);
 
   if (DEBUG_ISO_MODEL_SIMULATION) {
     printVector("v_wall_A_sol", v_wall_A_sol);
@@ -1621,6 +1683,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "solarHeatGain: " << std::endl;
   }
+  checkCancellation();
   solarHeatGain(v_win_A_sol, v_wall_R_sc, v_wall_U, v_wall_A, v_win_hr, v_wall_A_sol, v_E_sol);
 
   if (DEBUG_ISO_MODEL_SIMULATION) {
@@ -1655,6 +1718,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "interiorTemp: " << std::endl;
   }
+  checkCancellation();
   interiorTemp(v_wall_A, v_P_tot_wke_day, v_P_tot_wk_nt, v_P_tot_wke_nt, v_Tdbt_nt, v_Tdbt_day, H_tr, hoursUnoccupiedPerDay, hoursOccupiedPerDay, frac_hrs_wk_day,
       frac_hrs_wk_nt, frac_hrs_wke_tot, v_Th_avg, v_Tc_avg, tau);
   if (DEBUG_ISO_MODEL_SIMULATION) {
@@ -1671,6 +1735,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "heatingAndCooling: " << std::endl;
   }
+  checkCancellation();
   heatingAndCooling(v_E_sol, v_Th_avg, v_Hve_ht, v_Tc_avg, v_Hve_cl, tau, H_tr, phi_I_tot, frac_hrs_wk_day, v_Qfan_tot, v_Qneed_ht, v_Qneed_cl,
       Qneed_ht_yr, Qneed_cl_yr);
   if (DEBUG_ISO_MODEL_SIMULATION) {
@@ -1680,6 +1745,7 @@ std::vector<EndUses> MonthlyModel::simulate() const
 
     std::cout << std::endl << "hvac: " << std::endl;
   }
+  checkCancellation();
   hvac(v_Qneed_ht, v_Qneed_cl, Qneed_ht_yr, Qneed_cl_yr, v_Qelec_ht, v_Qgas_ht, v_Qcl_elec_tot, v_Qcl_gas_tot);
   if (DEBUG_ISO_MODEL_SIMULATION) {
     printVector("v_Qelec_ht", v_Qelec_ht);
@@ -1717,11 +1783,11 @@ std::vector<EndUses> MonthlyModel::outputGeneration(const Vector& v_Qelec_ht, co
   // TODO: Move the plug load calcs to a separate function. BAA@2015-07-15
 
   // Average electric plug loads (W/m2).
-  double E_plug_elec = building.electricApplianceHeatGainOccupied() * frac_hrs_wk_day
-      + building.electricApplianceHeatGainUnoccupied() * (1.0 - frac_hrs_wk_day);
+  double E_plug_elec = building->electricApplianceHeatGainOccupied() * frac_hrs_wk_day
+      + building->electricApplianceHeatGainUnoccupied() * (1.0 - frac_hrs_wk_day);
   // Average gas plug loads (W/m2).
-  double E_plug_gas = building.gasApplianceHeatGainOccupied() * frac_hrs_wk_day
-      + building.gasApplianceHeatGainUnoccupied() * (1.0 - frac_hrs_wk_day);
+  double E_plug_gas = building->gasApplianceHeatGainOccupied() * frac_hrs_wk_day
+      + building->gasApplianceHeatGainUnoccupied() * (1.0 - frac_hrs_wk_day);
 
   // Electric plug load (kWh/m2).
   Vector v_Q_plug_elec = div(mult(hoursInMonth, E_plug_elec, 12), 1000.0);
@@ -1731,28 +1797,28 @@ std::vector<EndUses> MonthlyModel::outputGeneration(const Vector& v_Qelec_ht, co
   printVector("v_Q_plug_gas", v_Q_plug_gas);
 
   // Electric loads (kWh/m2).
-  Vector Eelec_ht = div(div(v_Qelec_ht, structure.floorArea()), kWh2MJ); // Total monthly electric usage for heating.
-  Vector Eelec_cl = div(div(v_Qcl_elec_tot, structure.floorArea()), kWh2MJ); // Total monthly electric usage for cooling.
-  Vector Eelec_int_lt = div(v_Q_illum_tot, structure.floorArea()); // Total monthly electric usage density for interior lighting.
-  Vector Eelec_ext_lt = div(v_Q_illum_ext_tot, structure.floorArea()); // Total monthly electric usage for exterior lights.
+  Vector Eelec_ht = div(div(v_Qelec_ht, structure->floorArea()), kWh2MJ); // Total monthly electric usage for heating.
+  Vector Eelec_cl = div(div(v_Qcl_elec_tot, structure->floorArea()), kWh2MJ); // Total monthly electric usage for cooling.
+  Vector Eelec_int_lt = div(v_Q_illum_tot, structure->floorArea()); // Total monthly electric usage density for interior lighting.
+  Vector Eelec_ext_lt = div(v_Q_illum_ext_tot, structure->floorArea()); // Total monthly electric usage for exterior lights.
   Vector Eelec_fan = v_Qfan_tot; // Total monthly elec usage for fans.
-  Vector Eelec_pump = div(div(v_Q_pump_tot, structure.floorArea()), kWh2MJ); // Total monthly elec usage for pumps.
+  Vector Eelec_pump = div(div(v_Q_pump_tot, structure->floorArea()), kWh2MJ); // Total monthly elec usage for pumps.
   Vector Eelec_plug = v_Q_plug_elec; // Total monthly elec usage for elec plugloads.
-  Vector Eelec_dhw = div(v_Q_dhw_elec, structure.floorArea());
+  Vector Eelec_dhw = div(v_Q_dhw_elec, structure->floorArea());
 
   if (DEBUG_ISO_MODEL_SIMULATION) {
       printVector("v_Qcl_elec_tot", v_Qcl_elec_tot);
       printVector("v_Q_pump_tot", v_Q_pump_tot);
       printVector("Eelec_cl", Eelec_cl);
       printVector("Eelec_pump", Eelec_pump);
-      std::cout << "floorArea: " << structure.floorArea() << std::endl;
+      std::cout << "floorArea: " << structure->floorArea() << std::endl;
     }
 
   // Gas loads (kWh/m2).
-  Vector Egas_ht = div(div(v_Qgas_ht, structure.floorArea()), kWh2MJ); // Total monthly gas usage for heating.
-  Vector Egas_cl = div(div(v_Qcl_gas_tot, structure.floorArea()), kWh2MJ); // Total monthly gas usage for cooling.
+  Vector Egas_ht = div(div(v_Qgas_ht, structure->floorArea()), kWh2MJ); // Total monthly gas usage for heating.
+  Vector Egas_cl = div(div(v_Qcl_gas_tot, structure->floorArea()), kWh2MJ); // Total monthly gas usage for cooling.
   Vector Egas_plug = v_Q_plug_gas; // Total monthly gas plugloads.
-  Vector Egas_dhw = div(v_Q_dhw_gas, structure.floorArea()); // Total monthly dhw gas plugloads.
+  Vector Egas_dhw = div(v_Q_dhw_gas, structure->floorArea()); // Total monthly dhw gas plugloads.
 
   EndUses results[12];
   for (int i = 0; i < 12; i++) {
@@ -43,6 +43,9 @@ namespace openstudio {
 class EndUses;
 
 namespace isomodel {
+
+struct EnvelopePlan;
+
 #ifndef DBL_MAX
 #define DBL_MAX    1.7976931348623157E+308
 #endif
@@ -95,6 +98,17 @@ public:
    */
   std::vector<EndUses> simulate() const;
 
+  /**
+   * Computes the envelope values of the monthly method (ISO 13790 8.3 and 11.3).
+   */
+  EnvelopePlan envelope() const;
+
+  /**
+   * Runs the monthly method with precomputed envelope values. simulate() is equivalent
+   * to simulate(envelope()).
+   */
+  std::vector<EndUses> simulate(const EnvelopePlan& envelope) const;
+
 private:
   // Simulation functions.
   void scheduleAndOccupancy(Vector& weekdayOccupiedMegaseconds, Vector& weekdayUnoccupiedMegaseconds, Vector& weekendOccupiedMegaseconds,
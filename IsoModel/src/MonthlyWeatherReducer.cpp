@@ -0,0 +1,135 @@
+#include "MonthlyWeatherReducer.hpp"
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+const int daysInMonth[MONTHS] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+}
+
+MonthlyWeatherReducer::MonthlyWeatherReducer(EpwData* header)
+  : m_solar(nullptr, header), m_hour(0), m_month(0), m_dayOfYear(0), m_hourOfDay(0), m_dayOfMonth(1), m_count(0)
+{
+  for (int m = 0; m < MONTHS; m++) {
+    m_monthlyDryBulbTemp[m] = 0;
+    m_monthlyWindspeed[m] = 0;
+    m_monthlyGlobalHorizontalRadiation[m] = 0;
+    for (int s = 0; s < NUM_SURFACES; s++) {
+      m_monthlySolarRadiation[m][s] = 0;
+    }
+    for (int h = 0; h < HOURS; h++) {
+      m_hourlyDryBulbTemp[m][h] = 0;
+      m_hourlyGlobalHorizontalRadiation[m][h] = 0;
+    }
+  }
+}
+
+MonthlyWeatherReducer::~MonthlyWeatherReducer(void)
+{
+}
+
+void MonthlyWeatherReducer::addHour(const double* values)
+{
+  if (m_hour >= TIMESLICES) {
+    return;
+  }
+  m_solar.calculateHourSurfaceRadiation(m_dayOfYear, m_hourOfDay, values[EB], values[ED], m_eglobe);
+
+  // Accumulate in the same order as SolarRadiation::calculateAverages() so the sums match.
+  m_monthlyDryBulbTemp[m_month] += values[DBT];
+  m_monthlyGlobalHorizontalRadiation[m_month] += values[EGH];
+  m_monthlyWindspeed[m_month] += values[WSPD];
+  for (int s = 0; s < NUM_SURFACES; s++) {
+    m_monthlySolarRadiation[m_month][s] += m_eglobe[s];
+  }
+  m_hourlyDryBulbTemp[m_month][m_hourOfDay] += values[DBT];
+  m_hourlyGlobalHorizontalRadiation[m_month][m_hourOfDay] += values[EGH];
+  m_count++;
+  m_hour++;
+
+  // Advance the calendar, averaging the month when it ends.
+  if (++m_hourOfDay == HOURS) {
+    m_hourOfDay = 0;
+    m_dayOfYear++;
+    if (++m_dayOfMonth > daysInMonth[m_month]) {
+      finishMonth();
+      m_dayOfMonth = 1;
+      m_month++;
+      m_count = 0;
+    }
+  }
+}
+
+void MonthlyWeatherReducer::finishMonth()
+{
+  int midx = m_month;
+  m_monthlyDryBulbTemp[midx] /= m_count;
+  m_monthlyWindspeed[midx] /= m_count;
+  m_monthlyGlobalHorizontalRadiation[midx] /= m_count;
+  for (int s = 0; s < NUM_SURFACES; s++) {
+    m_monthlySolarRadiation[midx][s] /= m_count;
+  }
+  //hours are averaged over days in the month
+  for (int h = 0; h < HOURS; h++) {
+    m_hourlyDryBulbTemp[midx][h] /= daysInMonth[midx];
+    m_hourlyGlobalHorizontalRadiation[midx][h] /= daysInMonth[midx];
+  }
+}
+
+void MonthlyWeatherReducer::finish(WeatherData& weather)
+{
+  Matrix msolar(MONTHS, NUM_SURFACES);
+  Matrix mhdbt(MONTHS, HOURS);
+  Matrix mhEgh(MONTHS, HOURS);
+  Vector mEgh(MONTHS);
+  Vector mdbt(MONTHS);
+  Vector mwind(MONTHS);
+  for (int m = 0; m < MONTHS; m++) {
+    mEgh[m] = m_monthlyGlobalHorizontalRadiation[m];
+    mdbt[m] = m_monthlyDryBulbTemp[m];
+    mwind[m] = m_monthlyWindspeed[m];
+    for (int s = 0; s < NUM_SURFACES; s++) {
+      msolar(m, s) = m_monthlySolarRadiation[m][s];
+    }
+    for (int h = 0; h < HOURS; h++) {
+      mhdbt(m, h) = m_hourlyDryBulbTemp[m][h];
+      mhEgh(m, h) = m_hourlyGlobalHorizontalRadiation[m][h];
+    }
+  }
+  weather.setMdbt(mdbt);
+  weather.setMEgh(mEgh);
+  weather.setMhdbt(mhdbt);
+  weather.setMhEgh(mhEgh);
+  weather.setMsolar(msolar);
+  weather.setMwind(mwind);
+}
+
+bool MonthlyWeatherReducer::reduceFile(std::string fn, EpwData& epw, WeatherData& weather)
+{
+  std::ifstream file(fn.c_str());
+  if (!file.is_open()) {
+    return false;
+  }
+  std::string line;
+  double values[7];
+  std::getline(file, line);
+  epw.parseHeader(line);
+  // The remaining 7 header lines carry nothing the averages need.
+  for (int i = 0; i < 7 && file.good(); i++) {
+    std::getline(file, line);
+  }
+  MonthlyWeatherReducer reducer(&epw);
+  while (reducer.hours() < TIMESLICES && std::getline(file, line)) {
+    EpwData::parseRow(line, values);
+    reducer.addHour(values);
+  }
+  if (reducer.hours() < TIMESLICES) {
+    return false;
+  }
+  reducer.finish(weather);
+  epw.setDeferredFile(fn);
+  return true;
+}
+
+}
+}
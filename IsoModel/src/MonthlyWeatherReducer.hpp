@@ -0,0 +1,98 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_MONTHLY_WEATHER_REDUCER_HPP
+#define ISOMODEL_MONTHLY_WEATHER_REDUCER_HPP
+
+#include "ISOModelAPI.hpp"
+#include "EpwData.hpp"
+#include "SolarRadiation.hpp"
+#include "WeatherData.hpp"
+
+#include <string>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Reduces hourly weather to the monthly and month-by-hour averages held in WeatherData
+ * in a single pass. The sun position and surface irradiance of each hour are computed as
+ * the hour is added and accumulated straight into the monthly bins, so no hourly arrays
+ * are kept. Produces the same averages as SolarRadiation::Calculate().
+ */
+class ISOMODEL_API MonthlyWeatherReducer
+{
+public:
+  /**
+   * header must have its location parsed (latitude, longitude and time zone).
+   */
+  explicit MonthlyWeatherReducer(EpwData* header);
+  ~MonthlyWeatherReducer(void);
+
+  /**
+   * Adds the next hour of the year, starting at midnight on January 1st. values holds
+   * the hourly columns in EpwData column order (DBT, DPT, RH, EGH, EB, ED, WSPD).
+   */
+  void addHour(const double* values);
+
+  /**
+   * Number of hours added so far.
+   */
+  int hours() const {
+    return m_hour;
+  }
+
+  /**
+   * Stores the averages in weather. All TIMESLICES hours must have been added.
+   */
+  void finish(WeatherData& weather);
+
+  /**
+   * Streams an EPW file through a reducer. The header is parsed into epw and loading of
+   * its hourly data is deferred until first use (see EpwData::setDeferredFile), so a run
+   * that only needs monthly weather never holds the hourly arrays.
+   * Returns false if the file could not be read.
+   */
+  static bool reduceFile(std::string fn, EpwData& epw, WeatherData& weather);
+
+private:
+  void finishMonth();
+
+  SolarRadiation m_solar;
+
+  int m_hour;
+  int m_month;       // 0-11
+  int m_dayOfYear;   // 0-364
+  int m_hourOfDay;   // 0-23
+  int m_dayOfMonth;  // 1-monthLength
+  int m_count;       // hours accumulated in the current month
+
+  double m_eglobe[NUM_SURFACES];
+
+  // Sums for the current month, turned into averages when the month ends.
+  double m_monthlyDryBulbTemp[MONTHS];
+  double m_monthlyWindspeed[MONTHS];
+  double m_monthlyGlobalHorizontalRadiation[MONTHS];
+  double m_monthlySolarRadiation[MONTHS][NUM_SURFACES];
+  double m_hourlyDryBulbTemp[MONTHS][HOURS];
+  double m_hourlyGlobalHorizontalRadiation[MONTHS][HOURS];
+};
+
+}
+}
+#endif
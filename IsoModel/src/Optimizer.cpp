@@ -0,0 +1,694 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Optimizer.hpp"
+#include "Sampling.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+struct PointHash
+{
+  size_t operator()(const std::vector<double>& point) const {
+    size_t hash = 0;
+    for (double value : point) {
+      hash ^= std::hash<double>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+  }
+};
+
+double annualEndUse(const std::vector<EndUses>& monthly, int endUse)
+{
+  double total = 0;
+  for (const auto& month : monthly) {
+    total += endUseValue(month, endUse);
+  }
+  return total;
+}
+
+bool dominates(const std::vector<double>& a, const std::vector<double>& b)
+{
+  bool better = false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i] > b[i]) {
+      return false;
+    }
+    better = better || a[i] < b[i];
+  }
+  return better;
+}
+
+double uniform(std::mt19937_64& random)
+{
+  return ((random() >> 11) + 0.5) / 9007199254740992.0;
+}
+
+// Splits points into successive non-dominated fronts (fast non-dominated sort).
+std::vector<std::vector<size_t> > nondominatedSort(const std::vector<std::vector<double> >& objectives)
+{
+  size_t count = objectives.size();
+  std::vector<std::vector<size_t> > dominated(count);
+  std::vector<size_t> dominators(count, 0);
+  std::vector<std::vector<size_t> > fronts(1);
+  for (size_t p = 0; p < count; p++) {
+    for (size_t q = 0; q < count; q++) {
+      if (dominates(objectives[p], objectives[q])) {
+        dominated[p].push_back(q);
+      } else if (dominates(objectives[q], objectives[p])) {
+        dominators[p]++;
+      }
+    }
+    if (dominators[p] == 0) {
+      fronts[0].push_back(p);
+    }
+  }
+  while (!fronts.back().empty()) {
+    std::vector<size_t> next;
+    for (size_t p : fronts.back()) {
+      for (size_t q : dominated[p]) {
+        if (--dominators[q] == 0) {
+          next.push_back(q);
+        }
+      }
+    }
+    fronts.push_back(next);
+  }
+  fronts.pop_back();
+  return fronts;
+}
+
+// Sets distance[p] to the crowding distance of each point p of front.
+void crowdingDistances(const std::vector<std::vector<double> >& objectives, const std::vector<size_t>& front, std::vector<double>& distance)
+{
+  for (size_t p : front) {
+    distance[p] = 0;
+  }
+  std::vector<size_t> sorted(front);
+  for (size_t m = 0; m < objectives[front[0]].size(); m++) {
+    std::sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) { return objectives[a][m] < objectives[b][m]; });
+    double range = objectives[sorted.back()][m] - objectives[sorted.front()][m];
+    distance[sorted.front()] = std::numeric_limits<double>::infinity();
+    distance[sorted.back()] = std::numeric_limits<double>::infinity();
+    if (range <= 0) {
+      continue;
+    }
+    for (size_t i = 1; i + 1 < sorted.size(); i++) {
+      distance[sorted[i]] += (objectives[sorted[i + 1]][m] - objectives[sorted[i - 1]][m]) / range;
+    }
+  }
+}
+
+// Simulated binary crossover of two points of the unit cube.
+void crossover(std::vector<double>& x, std::vector<double>& y, std::mt19937_64& random)
+{
+  const double eta = 15;
+  for (size_t i = 0; i < x.size(); i++) {
+    if (uniform(random) > 0.5 || std::abs(x[i] - y[i]) < 1e-14) {
+      continue;
+    }
+    double low = std::min(x[i], y[i]);
+    double high = std::max(x[i], y[i]);
+    double u = uniform(random);
+    double children[2];
+    for (int c = 0; c < 2; c++) {
+      double beta = 1 + 2 * (c == 0 ? low : 1 - high) / (high - low);
+      double alpha = 2 - std::pow(beta, -(eta + 1));
+      double betaq = u <= 1 / alpha ? std::pow(u * alpha, 1 / (eta + 1)) : std::pow(1 / (2 - u * alpha), 1 / (eta + 1));
+      children[c] = 0.5 * ((low + high) + (c == 0 ? -1 : 1) * betaq * (high - low));
+      children[c] = std::min(std::max(children[c], 0.0), 1.0);
+    }
+    bool swap = uniform(random) < 0.5;
+    x[i] = children[swap ? 1 : 0];
+    y[i] = children[swap ? 0 : 1];
+  }
+}
+
+// Polynomial mutation of a point of the unit cube.
+void mutate(std::vector<double>& x, std::mt19937_64& random)
+{
+  const double eta = 20;
+  double probability = 1.0 / x.size();
+  for (size_t i = 0; i < x.size(); i++) {
+    if (uniform(random) >= probability) {
+      continue;
+    }
+    double u = uniform(random);
+    double delta;
+    if (u < 0.5) {
+      double value = 2 * u + (1 - 2 * u) * std::pow(1 - x[i], eta + 1);
+      delta = std::pow(value, 1 / (eta + 1)) - 1;
+    } else {
+      double value = 2 * (1 - u) + 2 * (u - 0.5) * std::pow(x[i], eta + 1);
+      delta = 1 - std::pow(value, 1 / (eta + 1));
+    }
+    x[i] = std::min(std::max(x[i] + delta, 0.0), 1.0);
+  }
+}
+
+// Eigen decomposition of the symmetric n by n matrix a (row major) by cyclic Jacobi
+// rotations. vectors holds the eigenvectors as columns.
+void symmetricEigen(size_t n, std::vector<double> a, std::vector<double>& values, std::vector<double>& vectors)
+{
+  vectors.assign(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    vectors[i * n + i] = 1;
+  }
+  for (int sweep = 0; sweep < 100; sweep++) {
+    double off = 0;
+    double diagonal = 0;
+    for (size_t p = 0; p < n; p++) {
+      diagonal += a[p * n + p] * a[p * n + p];
+      for (size_t q = p + 1; q < n; q++) {
+        off += a[p * n + q] * a[p * n + q];
+      }
+    }
+    if (off <= 1e-30 * diagonal) {
+      break;
+    }
+    for (size_t p = 0; p < n; p++) {
+      for (size_t q = p + 1; q < n; q++) {
+        if (a[p * n + q] == 0) {
+          continue;
+        }
+        double theta = (a[q * n + q] - a[p * n + p]) / (2 * a[p * n + q]);
+        double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1);
+        double s = t * c;
+        for (size_t k = 0; k < n; k++) {
+          double kp = a[k * n + p];
+          double kq = a[k * n + q];
+          a[k * n + p] = c * kp - s * kq;
+          a[k * n + q] = s * kp + c * kq;
+        }
+        for (size_t k = 0; k < n; k++) {
+          double pk = a[p * n + k];
+          double qk = a[q * n + k];
+          a[p * n + k] = c * pk - s * qk;
+          a[q * n + k] = s * pk + c * qk;
+        }
+        for (size_t k = 0; k < n; k++) {
+          double kp = vectors[k * n + p];
+          double kq = vectors[k * n + q];
+          vectors[k * n + p] = c * kp - s * kq;
+          vectors[k * n + q] = s * kp + c * kq;
+        }
+      }
+    }
+  }
+  values.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    values[i] = a[i * n + i];
+  }
+}
+
+}
+
+Objective Objective::eui()
+{
+  Objective objective;
+  objective.name = "EUI";
+  objective.evaluate = [](const double*, const std::vector<EndUses>& monthly) {
+    double total = 0;
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      total += annualEndUse(monthly, endUse);
+    }
+    return total;
+  };
+  return objective;
+}
+
+Objective Objective::endUse(int endUse)
+{
+  Objective objective;
+  objective.name = endUseName(endUse);
+  objective.evaluate = [endUse](const double*, const std::vector<EndUses>& monthly) { return annualEndUse(monthly, endUse); };
+  return objective;
+}
+
+Objective Objective::parse(const std::string& text, const std::vector<std::string>& parameterNames)
+{
+  std::vector<std::string> tokens;
+  std::istringstream in(text);
+  for (std::string token; in >> token;) {
+    tokens.push_back(token);
+  }
+  if (tokens.size() == 1) {
+    if (boost::iequals(tokens[0], "eui")) {
+      return eui();
+    }
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      if (boost::iequals(tokens[0], endUseName(endUse))) {
+        return Objective::endUse(endUse);
+      }
+    }
+    throw std::invalid_argument("Unknown objective \"" + tokens[0] + "\", expected eui or an end use.");
+  }
+  if (tokens.size() < 4 || tokens.size() % 2 != 0 || !boost::iequals(tokens[1], "linear")) {
+    throw std::invalid_argument("Objective \"" + text + "\" is not \"name linear parameter coefficient ...\".");
+  }
+
+  std::vector<std::pair<size_t, double> > terms;
+  for (size_t t = 2; t < tokens.size(); t += 2) {
+    size_t parameter = 0;
+    while (parameter < parameterNames.size() && !boost::iequals(parameterNames[parameter], tokens[t])) {
+      parameter++;
+    }
+    if (parameter == parameterNames.size()) {
+      throw std::invalid_argument("Objective " + tokens[0] + " refers to \"" + tokens[t] + "\", which is not a parameter.");
+    }
+    char* end = nullptr;
+    double coefficient = std::strtod(tokens[t + 1].c_str(), &end);
+    if (*end != '\0') {
+      throw std::invalid_argument("Objective " + tokens[0] + " has the coefficient \"" + tokens[t + 1] + "\", which is not a number.");
+    }
+    terms.push_back(std::make_pair(parameter, coefficient));
+  }
+  Objective objective;
+  objective.name = tokens[0];
+  objective.evaluate = [terms](const double* parameters, const std::vector<EndUses>&) {
+    double total = 0;
+    for (const auto& term : terms) {
+      total += term.second * parameters[term.first];
+    }
+    return total;
+  };
+  return objective;
+}
+
+struct Optimizer::Cache
+{
+  std::unordered_map<std::vector<double>, std::vector<double>, PointHash> objectives;
+};
+
+Optimizer::Optimizer(const UserModel& base, const SweepSpec& spec)
+  : m_base(base), m_engine(spec.engine), m_algorithm(spec.algorithm), m_population(spec.population), m_generations(spec.generations),
+    m_seed(spec.seed)
+{
+  std::vector<std::string> names;
+  for (const auto& parameter : spec.parameters) {
+    const Distribution& distribution = parameter.distribution;
+    if (distribution.type != Distribution::UNIFORM && distribution.type != Distribution::TRIANGULAR) {
+      throw std::invalid_argument("Optimization parameter " + parameter.name + " needs a range (a uniform or triangular distribution).");
+    }
+    names.push_back(parameter.name);
+    m_low.push_back(distribution.quantile(0));
+    m_high.push_back(distribution.quantile(1));
+  }
+  if (names.empty()) {
+    throw std::invalid_argument("An optimization needs at least one parameter.");
+  }
+  m_binding = ParameterBinding(names);
+  for (const auto& objective : spec.objectives) {
+    m_objectives.push_back(Objective::parse(objective, names));
+  }
+  m_statistics = OptimizationStatistics();
+}
+
+void Optimizer::addObjective(const Objective& objective)
+{
+  m_objectives.push_back(objective);
+}
+
+std::vector<double> Optimizer::values(const std::vector<double>& point) const
+{
+  std::vector<double> result(point.size());
+  for (size_t i = 0; i < point.size(); i++) {
+    result[i] = m_low[i] + std::min(std::max(point[i], 0.0), 1.0) * (m_high[i] - m_low[i]);
+  }
+  return result;
+}
+
+std::vector<std::vector<double> > Optimizer::evaluate(ThreadPool& pool, const std::vector<std::vector<double> >& points, Cache& cache)
+{
+  size_t count = points.size();
+  std::vector<std::vector<double> > designs(count);
+  std::vector<std::vector<double> > results(count);
+  // Designs to simulate, and for the others the index of the same design in this
+  // generation (or count if it was cached).
+  std::vector<size_t> misses;
+  std::vector<size_t> sources(count, count);
+  std::unordered_map<std::vector<double>, size_t, PointHash> firstIndex;
+  for (size_t i = 0; i < count; i++) {
+    designs[i] = values(points[i]);
+    auto cached = cache.objectives.find(designs[i]);
+    auto repeated = firstIndex.find(designs[i]);
+    if (cached != cache.objectives.end()) {
+      results[i] = cached->second;
+    } else if (repeated != firstIndex.end()) {
+      sources[i] = repeated->second;
+    } else {
+      firstIndex[designs[i]] = i;
+      misses.push_back(i);
+    }
+  }
+
+  pool.parallelFor(misses.size(), [&](size_t m) {
+    size_t i = misses[m];
+    auto monthly = simulateByMonth(m_binding.bind(m_base, designs[i].data()), m_engine);
+    results[i].resize(m_objectives.size());
+    for (size_t o = 0; o < m_objectives.size(); o++) {
+      results[i][o] = m_objectives[o].evaluate(designs[i].data(), monthly);
+    }
+  });
+
+  for (size_t i = 0; i < count; i++) {
+    if (sources[i] < count) {
+      results[i] = results[sources[i]];
+    }
+  }
+  for (size_t i : misses) {
+    cache.objectives[designs[i]] = results[i];
+
+    // Keep the front of every design evaluated so far.
+    bool dominated = false;
+    for (const auto& point : m_front) {
+      if (dominates(point.objectives, results[i]) || point.objectives == results[i]) {
+        dominated = true;
+        break;
+      }
+    }
+    if (!dominated) {
+      m_front.erase(std::remove_if(m_front.begin(), m_front.end(),
+                                   [&](const ParetoPoint& point) { return dominates(results[i], point.objectives); }),
+                    m_front.end());
+      ParetoPoint point = { designs[i], results[i] };
+      m_front.push_back(point);
+    }
+  }
+  m_statistics.evaluations += count;
+  m_statistics.cacheHits += count - misses.size();
+  return results;
+}
+
+void Optimizer::nsga2(ThreadPool& pool, Cache& cache)
+{
+  size_t size = m_population > 0 ? m_population : 40;
+  size_t dimensions = m_low.size();
+  std::mt19937_64 random(m_seed);
+  std::vector<std::vector<double> > population = latinHypercube(size, dimensions, m_seed);
+  std::vector<std::vector<double> > objectives = evaluate(pool, population, cache);
+
+  for (size_t generation = 0; generation < m_generations; generation++) {
+    std::vector<size_t> rank(size);
+    std::vector<double> distance(size);
+    auto fronts = nondominatedSort(objectives);
+    for (size_t f = 0; f < fronts.size(); f++) {
+      crowdingDistances(objectives, fronts[f], distance);
+      for (size_t p : fronts[f]) {
+        rank[p] = f;
+      }
+    }
+    auto tournament = [&]() {
+      size_t a = (size_t) (random() % size);
+      size_t b = (size_t) (random() % size);
+      if (rank[a] != rank[b]) {
+        return rank[a] < rank[b] ? a : b;
+      }
+      return distance[a] >= distance[b] ? a : b;
+    };
+
+    std::vector<std::vector<double> > offspring;
+    while (offspring.size() < size) {
+      std::vector<double> x = population[tournament()];
+      std::vector<double> y = population[tournament()];
+      if (uniform(random) < 0.9) {
+        crossover(x, y, random);
+      }
+      mutate(x, random);
+      mutate(y, random);
+      offspring.push_back(x);
+      if (offspring.size() < size) {
+        offspring.push_back(y);
+      }
+    }
+    std::vector<std::vector<double> > offspringObjectives = evaluate(pool, offspring, cache);
+
+    // Elitist selection from parents and offspring by front, then crowding distance.
+    population.insert(population.end(), offspring.begin(), offspring.end());
+    objectives.insert(objectives.end(), offspringObjectives.begin(), offspringObjectives.end());
+    std::vector<std::vector<double> > nextPopulation;
+    std::vector<std::vector<double> > nextObjectives;
+    std::vector<double> combinedDistance(population.size());
+    for (auto& front : nondominatedSort(objectives)) {
+      if (nextPopulation.size() + front.size() > size) {
+        crowdingDistances(objectives, front, combinedDistance);
+        std::stable_sort(front.begin(), front.end(), [&](size_t a, size_t b) { return combinedDistance[a] > combinedDistance[b]; });
+        front.resize(size - nextPopulation.size());
+      }
+      for (size_t p : front) {
+        nextPopulation.push_back(population[p]);
+        nextObjectives.push_back(objectives[p]);
+      }
+      if (nextPopulation.size() == size) {
+        break;
+      }
+    }
+    population.swap(nextPopulation);
+    objectives.swap(nextObjectives);
+    m_statistics.generations++;
+  }
+}
+
+std::vector<double> minimizeCmaes(size_t dimensions, size_t lambda, size_t generations, uint64_t seed,
+                                  const std::function<std::vector<double>(const std::vector<std::vector<double> >&)>& fitness,
+                                  double* bestFitness)
+{
+  size_t n = dimensions;
+  if (n == 0) {
+    throw std::invalid_argument("CMA-ES needs at least one dimension.");
+  }
+  if (lambda == 0) {
+    lambda = 4 + (size_t) std::floor(3 * std::log((double) n));
+  }
+  lambda = std::max<size_t>(lambda, 2);
+  size_t mu = lambda / 2;
+  std::vector<double> weights(mu);
+  double weightSum = 0;
+  for (size_t i = 0; i < mu; i++) {
+    weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+    weightSum += weights[i];
+  }
+  double squareSum = 0;
+  for (auto& weight : weights) {
+    weight /= weightSum;
+    squareSum += weight * weight;
+  }
+  double mueff = 1 / squareSum;
+  double cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+  double cs = (mueff + 2) / (n + mueff + 5);
+  double c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+  double cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff));
+  double damps = 1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) + cs;
+  double chiN = std::sqrt((double) n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+  // The search runs in the unit cube of the parameter ranges.
+  std::mt19937_64 random(seed);
+  std::vector<double> mean(n, 0.5);
+  double sigma = 0.3;
+  std::vector<double> pc(n, 0.0);
+  std::vector<double> ps(n, 0.0);
+  std::vector<double> covariance(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    covariance[i * n + i] = 1;
+  }
+  std::vector<double> eigenvalues;
+  std::vector<double> eigenvectors;
+  std::vector<double> scales(n);
+  std::vector<double> z(n);
+  std::vector<double> best;
+  double bestValue = std::numeric_limits<double>::infinity();
+
+  for (size_t generation = 0; generation < generations; generation++) {
+    symmetricEigen(n, covariance, eigenvalues, eigenvectors);
+    for (size_t i = 0; i < n; i++) {
+      scales[i] = std::sqrt(std::max(eigenvalues[i], 1e-20));
+    }
+
+    std::vector<std::vector<double> > samples(lambda, std::vector<double>(n));
+    std::vector<std::vector<double> > points(lambda);
+    for (auto& sample : samples) {
+      for (size_t i = 0; i < n; i++) {
+        z[i] = scales[i] * inverseNormal(uniform(random));
+      }
+      for (size_t i = 0; i < n; i++) {
+        double y = 0;
+        for (size_t j = 0; j < n; j++) {
+          y += eigenvectors[i * n + j] * z[j];
+        }
+        sample[i] = mean[i] + sigma * y;
+      }
+    }
+    for (size_t k = 0; k < lambda; k++) {
+      points[k] = samples[k];
+      for (auto& x : points[k]) {
+        x = std::min(std::max(x, 0.0), 1.0);
+      }
+    }
+    std::vector<double> values = fitness(points);
+
+    // Samples outside of the cube are evaluated at the nearest point inside and
+    // penalized by their squared distance to it.
+    std::vector<double> penalized(lambda);
+    std::vector<size_t> order(lambda);
+    for (size_t k = 0; k < lambda; k++) {
+      if (values[k] < bestValue) {
+        bestValue = values[k];
+        best = points[k];
+      }
+      double outside = 0;
+      for (size_t i = 0; i < n; i++) {
+        outside += (samples[k][i] - points[k][i]) * (samples[k][i] - points[k][i]);
+      }
+      penalized[k] = values[k] + (std::abs(values[k]) + 1) * outside;
+      order[k] = k;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return penalized[a] < penalized[b]; });
+
+    std::vector<double> oldMean(mean);
+    std::vector<double> step(n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+      mean[i] = 0;
+      for (size_t k = 0; k < mu; k++) {
+        mean[i] += weights[k] * samples[order[k]][i];
+      }
+      step[i] = (mean[i] - oldMean[i]) / sigma;
+    }
+
+    // ps is updated with C^-1/2 step = B D^-1 B^T step.
+    std::vector<double> projected(n, 0.0);
+    for (size_t j = 0; j < n; j++) {
+      double dot = 0;
+      for (size_t i = 0; i < n; i++) {
+        dot += eigenvectors[i * n + j] * step[i];
+      }
+      projected[j] = dot / scales[j];
+    }
+    double psNorm = 0;
+    for (size_t i = 0; i < n; i++) {
+      double whitened = 0;
+      for (size_t j = 0; j < n; j++) {
+        whitened += eigenvectors[i * n + j] * projected[j];
+      }
+      ps[i] = (1 - cs) * ps[i] + std::sqrt(cs * (2 - cs) * mueff) * whitened;
+      psNorm += ps[i] * ps[i];
+    }
+    psNorm = std::sqrt(psNorm);
+    bool hsig = psNorm / std::sqrt(1 - std::pow(1 - cs, 2.0 * (generation + 1))) / chiN < 1.4 + 2.0 / (n + 1);
+    for (size_t i = 0; i < n; i++) {
+      pc[i] = (1 - cc) * pc[i] + (hsig ? std::sqrt(cc * (2 - cc) * mueff) : 0) * step[i];
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j <= i; j++) {
+        double rankMu = 0;
+        for (size_t k = 0; k < mu; k++) {
+          const auto& sample = samples[order[k]];
+          rankMu += weights[k] * (sample[i] - oldMean[i]) / sigma * (sample[j] - oldMean[j]) / sigma;
+        }
+        double value = (1 - c1 - cmu) * covariance[i * n + j]
+                       + c1 * (pc[i] * pc[j] + (hsig ? 0 : cc * (2 - cc)) * covariance[i * n + j]) + cmu * rankMu;
+        covariance[i * n + j] = value;
+        covariance[j * n + i] = value;
+      }
+    }
+    sigma *= std::exp(cs / damps * (psNorm / chiN - 1));
+  }
+  if (bestFitness != nullptr) {
+    *bestFitness = bestValue;
+  }
+  return best;
+}
+
+void Optimizer::cmaes(ThreadPool& pool, Cache& cache)
+{
+  minimizeCmaes(m_low.size(), m_population, m_generations, m_seed, [&](const std::vector<std::vector<double> >& points) {
+    std::vector<double> sums;
+    for (const auto& objectives : evaluate(pool, points, cache)) {
+      double total = 0;
+      for (double objective : objectives) {
+        total += objective;
+      }
+      sums.push_back(total);
+    }
+    m_statistics.generations++;
+    return sums;
+  });
+}
+
+std::vector<ParetoPoint> Optimizer::run(ThreadPool& pool)
+{
+  if (m_objectives.empty()) {
+    m_objectives.push_back(Objective::eui());
+  }
+  m_front.clear();
+  m_statistics = OptimizationStatistics();
+  Cache cache;
+  auto start = std::chrono::steady_clock::now();
+  if (m_algorithm == SweepSpec::CMA_ES) {
+    cmaes(pool, cache);
+  } else {
+    nsga2(pool, cache);
+  }
+  m_statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::sort(m_front.begin(), m_front.end(), [](const ParetoPoint& a, const ParetoPoint& b) { return a.objectives < b.objectives; });
+  return m_front;
+}
+
+void Optimizer::writeCsv(const std::vector<ParetoPoint>& front, std::ostream& out) const
+{
+  std::string separator;
+  for (const auto& name : m_binding.names()) {
+    out << separator << name;
+    separator = ",";
+  }
+  for (const auto& objective : m_objectives) {
+    out << "," << objective.name;
+  }
+  out << "\n" << std::setprecision(10);
+  for (const auto& point : front) {
+    separator.clear();
+    for (double value : point.parameters) {
+      out << separator << value;
+      separator = ",";
+    }
+    for (double value : point.objectives) {
+      out << "," << value;
+    }
+    out << "\n";
+  }
+}
+
+}
+}
@@ -0,0 +1,173 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_OPTIMIZER_HPP
+#define ISOMODEL_OPTIMIZER_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A quantity to minimize, computed from the parameter values of a design (in parameter
+ * order) and its 12 monthly results. Objectives are evaluated concurrently, so evaluate
+ * must be thread safe.
+ */
+struct ISOMODEL_API Objective
+{
+  std::string name;
+  std::function<double(const double* parameters, const std::vector<EndUses>& monthly)> evaluate;
+
+  /**
+   * Total annual energy use intensity (kWh/m2).
+   */
+  static Objective eui();
+
+  /**
+   * Annual use of one end use (kWh/m2).
+   */
+  static Objective endUse(int endUse);
+
+  /**
+   * Parses "eui", an end use name (e.g. "GasHeat") or "name linear parameter
+   * coefficient [parameter coefficient ...]", a linear cost of the named parameters such
+   * as an envelope cost. Throws std::invalid_argument for unknown names.
+   */
+  static Objective parse(const std::string& text, const std::vector<std::string>& parameterNames);
+};
+
+/**
+ * Minimizes a function of the unit cube of dimensions dimensions with CMA-ES (Hansen's
+ * (mu/mu_w, lambda) strategy; lambda 0 for its default population). fitness is called
+ * once per generation with all of its points, which lie inside the cube, so that they
+ * can be evaluated concurrently; samples outside of the cube are evaluated at the
+ * nearest point inside and penalized by their squared distance to it. Returns the best
+ * point evaluated and stores its value in bestFitness if that is not null.
+ */
+ISOMODEL_API std::vector<double> minimizeCmaes(size_t dimensions, size_t lambda, size_t generations, uint64_t seed,
+                                               const std::function<std::vector<double>(const std::vector<std::vector<double> >&)>& fitness,
+                                               double* bestFitness = nullptr);
+
+/**
+ * A design of a Pareto front: its parameter values and objective values.
+ */
+struct ISOMODEL_API ParetoPoint
+{
+  std::vector<double> parameters;
+  std::vector<double> objectives;
+};
+
+struct ISOMODEL_API OptimizationStatistics
+{
+  size_t evaluations; // Designs evaluated, including those found in the cache.
+  size_t cacheHits;
+  size_t generations;
+  double seconds;
+
+  double evaluationsPerSecond() const {
+    return seconds > 0 ? evaluations / seconds : 0;
+  }
+
+  double cacheHitRate() const {
+    return evaluations > 0 ? (double) cacheHits / evaluations : 0;
+  }
+};
+
+/**
+ * Minimizes objectives of a model over the ranges of the parameters of a SweepSpec with
+ * NSGA-II (Deb et al. 2002; simulated binary crossover and polynomial mutation) or
+ * CMA-ES (Hansen's (mu/mu_w, lambda) strategy, minimizing the sum of the objectives).
+ * The designs of a generation are simulated concurrently and every evaluated design is
+ * cached, so repeated designs are not simulated again. The result is the Pareto front
+ * of all evaluated designs.
+ */
+class ISOMODEL_API Optimizer
+{
+public:
+  /**
+   * Throws std::invalid_argument if a parameter is unknown or has no bounded range, or
+   * an objective of the spec cannot be parsed.
+   */
+  Optimizer(const UserModel& base, const SweepSpec& spec);
+
+  /**
+   * Adds an objective, e.g. a user supplied cost.
+   */
+  void addObjective(const Objective& objective);
+
+  const std::vector<Objective>& objectives() const {
+    return m_objectives;
+  }
+
+  const ParameterBinding& binding() const {
+    return m_binding;
+  }
+
+  /**
+   * Runs the spec's algorithm on pool and returns the Pareto front, sorted by the first
+   * objective. If no objective was given, the EUI is minimized.
+   */
+  std::vector<ParetoPoint> run(ThreadPool& pool);
+
+  const OptimizationStatistics& statistics() const {
+    return m_statistics;
+  }
+
+  /**
+   * Writes a front as CSV: the parameter values and objective values of each point.
+   */
+  void writeCsv(const std::vector<ParetoPoint>& front, std::ostream& out) const;
+
+private:
+  struct Cache;
+
+  // Evaluates designs given as points of the unit cube of the parameter ranges. Returns
+  // the objectives of each design and adds the designs to the front.
+  std::vector<std::vector<double> > evaluate(ThreadPool& pool, const std::vector<std::vector<double> >& points, Cache& cache);
+  std::vector<double> values(const std::vector<double>& point) const;
+  void nsga2(ThreadPool& pool, Cache& cache);
+  void cmaes(ThreadPool& pool, Cache& cache);
+
+  UserModel m_base;
+  SimulationEngine m_engine;
+  SweepSpec::OptimizationAlgorithm m_algorithm;
+  size_t m_population;
+  size_t m_generations;
+  uint64_t m_seed;
+  ParameterBinding m_binding;
+  std::vector<double> m_low;
+  std::vector<double> m_high;
+  std::vector<Objective> m_objectives;
+  std::vector<ParetoPoint> m_front;
+  OptimizationStatistics m_statistics;
+};
+
+}
+}
+#endif
@@ -53,6 +53,12 @@ public:
     m_rhoCpWater = rhoCpWater;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_rhoCpAir & m_rhoCpWater;
+  }
+
 private:
   double m_rhoCpAir = 1.22521 * 0.001012;
   double m_rhoCpWater = 4.1813; 
@@ -0,0 +1,505 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Pipeline.hpp"
+#include "IsmSchema.hpp"
+#include "Properties.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double since(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// A queue of at most capacity items between two stages. It closes once each of its
+// producers is done and it is empty.
+template<typename T>
+class BoundedQueue
+{
+public:
+  BoundedQueue(size_t capacity, unsigned producers) : m_capacity(std::max<size_t>(capacity, 1)), m_producers(producers)
+  {
+  }
+
+  // Waits for room. Returns the seconds waited.
+  double push(T item)
+  {
+    Clock::time_point start = Clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this]() { return m_items.size() < m_capacity; });
+    double waited = since(start);
+    m_items.push_back(std::move(item));
+    m_notEmpty.notify_one();
+    return waited;
+  }
+
+  // Waits for an item, adding the seconds waited to waited. Returns false once the queue
+  // is closed.
+  bool pop(T& item, double& waited)
+  {
+    Clock::time_point start = Clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_producers == 0; });
+    waited += since(start);
+    if (m_items.empty()) {
+      return false;
+    }
+    item = std::move(m_items.front());
+    m_items.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  void producerDone()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_producers == 0) {
+      m_notEmpty.notify_all();
+    }
+  }
+
+private:
+  size_t m_capacity;
+  unsigned m_producers;
+  std::deque<T> m_items;
+  std::mutex m_mutex;
+  std::condition_variable m_notEmpty;
+  std::condition_variable m_notFull;
+};
+
+// A building on its way through the pipeline. Once error is set the stages pass it on
+// untouched.
+struct Work
+{
+  size_t index;
+  const PipelineJob* job;
+  std::string text;
+  UserModel model;
+  std::string station;
+  std::vector<EndUses> results;
+  std::string error;
+};
+
+typedef std::unique_ptr<Work> WorkPtr;
+typedef BoundedQueue<WorkPtr> WorkQueue;
+
+// The weather of a station, loaded by the first building that needs it.
+struct Station
+{
+  std::once_flag loaded;
+  std::shared_ptr<WeatherData> weather;
+  std::shared_ptr<EpwData> epwData;
+  std::string error;
+};
+
+// The workers of one stage and the statistics they add up.
+class Stage
+{
+public:
+  Stage(const std::string& name, unsigned workers)
+  {
+    m_statistics.name = name;
+    m_statistics.workers = std::max(workers, 1u);
+    m_statistics.items = 0;
+    m_statistics.busySeconds = 0;
+    m_statistics.starvedSeconds = 0;
+    m_statistics.blockedSeconds = 0;
+  }
+
+  unsigned workers() const
+  {
+    return m_statistics.workers;
+  }
+
+  // Starts the workers. Each pops from in (or, without in, calls next until it returns
+  // false) and calls process, which returns the seconds it was blocked. finish is called
+  // by each worker when it is out of input and returns the seconds it was blocked.
+  template<typename Process, typename Finish>
+  void start(WorkQueue* in, std::function<bool(WorkPtr&)> next, Process process, Finish finish)
+  {
+    for (unsigned w = 0; w < workers(); w++) {
+      m_threads.push_back(std::thread([this, in, next, process, finish]() {
+        double starved = 0;
+        double blocked = 0;
+        double busy = 0;
+        size_t items = 0;
+        WorkPtr work;
+        while (in != nullptr ? in->pop(work, starved) : next(work)) {
+          Clock::time_point start = Clock::now();
+          double waited = process(std::move(work));
+          busy += since(start) - waited;
+          blocked += waited;
+          items++;
+        }
+        blocked += finish();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.items += items;
+        m_statistics.busySeconds += busy;
+        m_statistics.starvedSeconds += starved;
+        m_statistics.blockedSeconds += blocked;
+      }));
+    }
+  }
+
+  StageStatistics join()
+  {
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+    return m_statistics;
+  }
+
+private:
+  StageStatistics m_statistics;
+  std::mutex m_mutex;
+  std::vector<std::thread> m_threads;
+};
+
+std::string resolve(const std::string& file, const std::string& baseDirectory)
+{
+  if (file.empty() || baseDirectory.empty()) {
+    return file;
+  }
+  boost::filesystem::path path(file);
+  return path.is_absolute() ? file : (boost::filesystem::path(baseDirectory) / path).string();
+}
+
+void parseBuilding(Work& work)
+{
+  std::shared_ptr<const Properties> defaults;
+  if (!work.job->defaultsFile.empty()) {
+    if (!boost::filesystem::exists(work.job->defaultsFile)) {
+      throw std::invalid_argument("Defaults file " + work.job->defaultsFile + " not found.");
+    }
+    defaults = Properties::shared(work.job->defaultsFile);
+  }
+  Properties properties(defaults);
+  std::istringstream in(work.text);
+  properties.readStream(in, work.job->ismFile);
+  std::string().swap(work.text);
+  bindIsmProperties(work.model, properties);
+
+  boost::filesystem::path weatherFile(work.model.weatherFilePath());
+  if (!boost::filesystem::exists(weatherFile)) {
+    weatherFile = boost::filesystem::path(work.job->ismFile).parent_path() / weatherFile;
+    if (!boost::filesystem::exists(weatherFile)) {
+      throw std::invalid_argument("Weather file " + work.model.weatherFilePath() + " not found.");
+    }
+  }
+  work.station = boost::filesystem::canonical(weatherFile).string();
+}
+
+}
+
+PipelineOptions::PipelineOptions()
+  : readers(2), parsers(1), weatherLoaders(1), simulators(0), queueCapacity(64), stationGroup(16), engine(MONTHLY_ENGINE)
+{
+}
+
+std::vector<PipelineJob> PipelineJob::loadList(const std::string& listFile)
+{
+  std::ifstream in(listFile.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open building list " + listFile + ".");
+  }
+  std::string directory = boost::filesystem::path(listFile).parent_path().string();
+  std::vector<PipelineJob> jobs;
+  for (std::string line; std::getline(in, line);) {
+    line = line.substr(0, line.find('#'));
+    boost::trim(line);
+    if (line.empty()) {
+      continue;
+    }
+    size_t comma = line.find(',');
+    PipelineJob job;
+    job.ismFile = resolve(boost::trim_copy(line.substr(0, comma)), directory);
+    if (comma != std::string::npos) {
+      job.defaultsFile = resolve(boost::trim_copy(line.substr(comma + 1)), directory);
+    }
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+double StageStatistics::utilization(double wallSeconds) const
+{
+  return wallSeconds > 0 ? busySeconds / (workers * wallSeconds) : 0;
+}
+
+std::string PipelineReport::bottleneck() const
+{
+  const StageStatistics* busiest = nullptr;
+  for (const auto& stage : stages) {
+    if (busiest == nullptr || stage.utilization(seconds) > busiest->utilization(seconds)) {
+      busiest = &stage;
+    }
+  }
+  return busiest != nullptr ? busiest->name : std::string();
+}
+
+void PipelineReport::write(std::ostream& out) const
+{
+  out << std::left << std::setw(10) << "Stage" << std::right << std::setw(8) << "Workers" << std::setw(8) << "Items" << std::setw(8)
+      << "Busy" << std::setw(10) << "Starved" << std::setw(10) << "Blocked" << "\n";
+  for (const auto& stage : stages) {
+    double workerSeconds = stage.workers * seconds;
+    out << std::left << std::setw(10) << stage.name << std::right << std::setw(8) << stage.workers << std::setw(8) << stage.items
+        << std::fixed << std::setprecision(1) << std::setw(7) << 100 * stage.utilization(seconds) << "%" << std::setw(9)
+        << (workerSeconds > 0 ? 100 * stage.starvedSeconds / workerSeconds : 0) << "%" << std::setw(9)
+        << (workerSeconds > 0 ? 100 * stage.blockedSeconds / workerSeconds : 0) << "%" << std::defaultfloat << "\n";
+  }
+  out << buildings << " buildings, " << errors.size() << " failed, " << stations << " stations in " << std::setprecision(4) << seconds
+      << " s; bottleneck: " << bottleneck() << "\n";
+}
+
+BuildingPipeline::BuildingPipeline(const PipelineOptions& options) : m_options(options)
+{
+  if (m_options.simulators == 0) {
+    m_options.simulators = ThreadPool::hardwareThreads();
+  }
+}
+
+PipelineReport BuildingPipeline::run(const std::vector<PipelineJob>& jobs, std::ostream& out) const
+{
+  Clock::time_point start = Clock::now();
+  const PipelineOptions& options = m_options;
+  Stage reading("read", options.readers);
+  Stage parsing("parse", options.parsers);
+  Stage weathering("weather", options.weatherLoaders);
+  Stage simulating("simulate", options.simulators);
+  Stage writing("write", 1);
+  WorkQueue read(options.queueCapacity, reading.workers());
+  WorkQueue parsed(options.queueCapacity, parsing.workers());
+  WorkQueue grouped(options.queueCapacity, weathering.workers());
+  WorkQueue simulated(options.queueCapacity, simulating.workers());
+  auto none = []() { return 0.0; };
+
+  std::atomic<size_t> nextJob(0);
+  reading.start(nullptr,
+      [&](WorkPtr& work) {
+        size_t index = nextJob++;
+        if (index >= jobs.size()) {
+          return false;
+        }
+        work.reset(new Work());
+        work->index = index;
+        work->job = &jobs[index];
+        return true;
+      },
+      [&](WorkPtr work) {
+        std::ifstream in(work->job->ismFile.c_str(), std::ios::binary);
+        if (!in) {
+          work->error = "Cannot open the file.";
+        } else {
+          work->text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        return read.push(std::move(work));
+      },
+      [&]() {
+        read.producerDone();
+        return 0.0;
+      });
+
+  parsing.start(&read, nullptr,
+      [&](WorkPtr work) {
+        if (work->error.empty()) {
+          try {
+            parseBuilding(*work);
+          } catch (std::domain_error* e) {
+            work->error = e->what();
+            delete e;
+          } catch (std::exception& e) {
+            work->error = e.what();
+          }
+        }
+        return parsed.push(std::move(work));
+      },
+      [&]() {
+        parsed.producerDone();
+        return 0.0;
+      });
+
+  // Buildings held back until their station's group is full, at most queueCapacity in all.
+  std::mutex groupMutex;
+  std::map<std::string, std::shared_ptr<Station> > stations;
+  std::map<std::string, std::vector<WorkPtr> > pending;
+  size_t pendingCount = 0;
+  unsigned weatherDone = 0;
+  auto pushAll = [&](std::vector<WorkPtr>& works) {
+    double blocked = 0;
+    for (auto& work : works) {
+      blocked += grouped.push(std::move(work));
+    }
+    return blocked;
+  };
+  weathering.start(&parsed, nullptr,
+      [&](WorkPtr work) {
+        if (!work->error.empty()) {
+          return grouped.push(std::move(work));
+        }
+        std::shared_ptr<Station> station;
+        {
+          std::lock_guard<std::mutex> lock(groupMutex);
+          std::shared_ptr<Station>& slot = stations[work->station];
+          if (!slot) {
+            slot = std::make_shared<Station>();
+          }
+          station = slot;
+        }
+        std::call_once(station->loaded, [&]() {
+          try {
+            UserModel loader;
+            loader.setWeatherFilePath(work->station);
+            loader.loadWeather();
+            station->weather = loader.weatherData();
+            station->epwData = loader.epwData();
+            if (options.engine == HOURLY_ENGINE) {
+              station->epwData->hourlyWeather();
+            }
+          } catch (std::exception& e) {
+            station->error = e.what();
+          }
+        });
+        if (!station->error.empty()) {
+          work->error = station->error;
+          return grouped.push(std::move(work));
+        }
+        work->model.setWeather(station->weather, station->epwData);
+        work->model.setValid(true);
+
+        std::vector<WorkPtr> ready;
+        {
+          std::lock_guard<std::mutex> lock(groupMutex);
+          std::vector<WorkPtr>& group = pending[work->station];
+          group.push_back(std::move(work));
+          pendingCount++;
+          auto full = pending.end();
+          if (group.size() >= options.stationGroup) {
+            full = pending.find(group.front()->station);
+          } else if (pendingCount > options.queueCapacity) {
+            for (auto it = pending.begin(); it != pending.end(); ++it) {
+              if (full == pending.end() || it->second.size() > full->second.size()) {
+                full = it;
+              }
+            }
+          }
+          if (full != pending.end()) {
+            ready.swap(full->second);
+            pending.erase(full);
+            pendingCount -= ready.size();
+          }
+        }
+        return pushAll(ready);
+      },
+      [&]() {
+        double blocked = 0;
+        std::unique_lock<std::mutex> lock(groupMutex);
+        if (++weatherDone == weathering.workers()) {
+          // The last worker passes on the partial groups.
+          std::map<std::string, std::vector<WorkPtr> > rest;
+          rest.swap(pending);
+          lock.unlock();
+          for (auto& group : rest) {
+            blocked += pushAll(group.second);
+          }
+        } else {
+          lock.unlock();
+        }
+        grouped.producerDone();
+        return blocked;
+      });
+
+  simulating.start(&grouped, nullptr,
+      [&](WorkPtr work) {
+        if (work->error.empty()) {
+          try {
+            work->results = simulateByMonth(work->model, options.engine);
+          } catch (std::exception& e) {
+            work->error = e.what();
+          }
+        }
+        work->model = UserModel();
+        return simulated.push(std::move(work));
+      },
+      [&]() {
+        simulated.producerDone();
+        return 0.0;
+      });
+
+  PipelineReport report;
+  report.buildings = 0;
+  out << "building,file,month";
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    out << "," << endUseName(endUse);
+  }
+  out << "\n" << std::setprecision(10);
+  writing.start(&simulated, nullptr,
+      [&](WorkPtr work) {
+        if (!work->error.empty()) {
+          report.errors.push_back(work->job->ismFile + ": " + work->error);
+          return 0.0;
+        }
+        for (size_t month = 0; month < work->results.size(); month++) {
+          out << work->index + 1 << "," << work->job->ismFile << "," << month + 1;
+          for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+            out << "," << endUseValue(work->results[month], endUse);
+          }
+          out << "\n";
+        }
+        report.buildings++;
+        return 0.0;
+      },
+      none);
+
+  report.stages.push_back(reading.join());
+  report.stages.push_back(parsing.join());
+  report.stages.push_back(weathering.join());
+  report.stages.push_back(simulating.join());
+  report.stages.push_back(writing.join());
+  report.stations = stations.size();
+  report.seconds = since(start);
+  return report;
+}
+
+}
+}
@@ -0,0 +1,141 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_PIPELINE_HPP
+#define ISOMODEL_PIPELINE_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A building of a pipeline run: its .ism file and optional defaults .ism file.
+ */
+struct ISOMODEL_API PipelineJob
+{
+  std::string ismFile;
+  std::string defaultsFile;
+
+  /**
+   * Reads a building list: one building per line, an .ism file optionally followed by a
+   * comma and a defaults .ism file, relative to the list file; # starts a comment.
+   * Throws std::invalid_argument if the list cannot be read.
+   */
+  static std::vector<PipelineJob> loadList(const std::string& listFile);
+};
+
+/**
+ * Worker counts of the pipeline stages and the capacity of the queues between them.
+ */
+struct ISOMODEL_API PipelineOptions
+{
+  unsigned readers;
+  unsigned parsers;
+  unsigned weatherLoaders;
+  unsigned simulators; // 0 for one per hardware thread.
+  // Buildings held by each queue before its producers wait.
+  size_t queueCapacity;
+  // Buildings of one station passed on together by the weather stage.
+  size_t stationGroup;
+  SimulationEngine engine;
+
+  PipelineOptions();
+};
+
+/**
+ * Activity of the workers of a stage over a run, in seconds summed over the workers.
+ * busy is time spent working, starved time spent waiting for input and blocked time spent
+ * waiting for room in the next queue.
+ */
+struct ISOMODEL_API StageStatistics
+{
+  std::string name;
+  unsigned workers;
+  size_t items;
+  double busySeconds;
+  double starvedSeconds;
+  double blockedSeconds;
+
+  /**
+   * The fraction of the workers' time over a run of wallSeconds spent working.
+   */
+  double utilization(double wallSeconds) const;
+};
+
+/**
+ * Outcome of a pipeline run.
+ */
+struct ISOMODEL_API PipelineReport
+{
+  size_t buildings;
+  // Failed buildings, each as "file: message".
+  std::vector<std::string> errors;
+  size_t stations;
+  double seconds;
+  std::vector<StageStatistics> stages;
+
+  /**
+   * The name of the stage with the highest utilization.
+   */
+  std::string bottleneck() const;
+
+  /**
+   * Writes a table of the stages and their utilization.
+   */
+  void write(std::ostream& out) const;
+};
+
+/**
+ * Simulates many buildings, each with its own .ism and weather files, as a pipeline of
+ * stages with their own worker threads:
+ *
+ * read (the .ism file) -> parse (properties and model, resolving the weather file) ->
+ * weather (load each station once, precompute its solar inputs and group its buildings) ->
+ * simulate -> write
+ *
+ * Bounded queues join the stages, so a slow stage holds back the ones before it instead
+ * of letting buildings pile up in memory. The weather stage passes on the buildings of a
+ * station in groups of stationGroup, so that a simulator works through buildings that
+ * share weather while it is in cache. Results are written as they finish, in a CSV file
+ * with a row per building and month:
+ *
+ * building,file,month,ElecHeat,...,GasDHW
+ *
+ * where building is the position of the building in the job list (from 1). Buildings
+ * that fail are left out of the results and listed in the report.
+ */
+class ISOMODEL_API BuildingPipeline
+{
+public:
+  explicit BuildingPipeline(const PipelineOptions& options = PipelineOptions());
+
+  PipelineReport run(const std::vector<PipelineJob>& jobs, std::ostream& out) const;
+
+private:
+  PipelineOptions m_options;
+};
+
+}
+}
+#endif
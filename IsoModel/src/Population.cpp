@@ -4,6 +4,8 @@ namespace openstudio {
 namespace isomodel {
 
 Population::Population(void)
+    : m_hoursEnd(0), m_hoursStart(0), m_daysEnd(0), m_daysStart(0), m_densityOccupied(0), m_densityUnoccupied(0),
+      m_heatGainPerPerson(0)
 {
 }
 
@@ -126,6 +126,13 @@ public:
   m_scheduleFilePath = scheduleFilePath;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_hoursEnd & m_hoursStart & m_daysEnd & m_daysStart & m_densityOccupied
+        & m_densityUnoccupied & m_heatGainPerPerson & m_scheduleFilePath;
+  }
+
 private:
   double m_hoursEnd;
   double m_hoursStart;
@@ -0,0 +1,596 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+
+#include "Portfolio.hpp"
+#include "BinaryArchive.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char BINARY_MAGIC[8] = { 'I', 'S', 'M', 'P', 'O', 'R', 'T', 'F' };
+const uint32_t BINARY_VERSION = 1;
+const char* ID_COLUMN = "id";
+
+// Empty numeric cells are stored as NaN. Cells with a value hold only finite numbers, as
+// parseCell and validateRows reject the others.
+bool isEmptyCell(double value)
+{
+  return std::isnan(value);
+}
+
+// A numeric cell of n values is either empty or entirely finite.
+bool isValidCell(const double* values, size_t n)
+{
+  if (isEmptyCell(values[0])) {
+    return std::all_of(values, values + n, [](double value) { return std::isnan(value); });
+  }
+  return std::all_of(values, values + n, [](double value) { return std::isfinite(value); });
+}
+
+// Values per row of a column.
+size_t width(const IsmProperty* property)
+{
+  return (property != nullptr && property->type == ISM_VECTOR) ? 9 : 1;
+}
+
+bool isTextColumn(const IsmProperty* property)
+{
+  return property == nullptr || property->type == ISM_STRING;
+}
+
+void trim(const char*& begin, const char*& end)
+{
+  while (begin < end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+    --end;
+  }
+}
+
+// Reads one CSV field of the line [p, lineEnd) into field. Quoted fields may contain
+// commas and "" for a quote. Returns a pointer past the comma that ends the field; more
+// is set if there was one.
+const char* readField(const char* p, const char* lineEnd, std::string& field, bool& more)
+{
+  field.clear();
+  const char* begin = p;
+  while (p < lineEnd && *p != ',' && *p != '"') {
+    ++p;
+  }
+  if (p < lineEnd && *p == '"') {
+    for (++p; p < lineEnd; ++p) {
+      if (*p == '"') {
+        if (p + 1 < lineEnd && p[1] == '"') {
+          ++p;
+        } else {
+          break;
+        }
+      }
+      field += *p;
+    }
+    while (p < lineEnd && *p != ',') {
+      ++p;
+    }
+  } else {
+    const char* end = p;
+    trim(begin, end);
+    field.assign(begin, end);
+  }
+  more = p < lineEnd;
+  return more ? p + 1 : p;
+}
+
+// Converts a cell as the .ism reader does: numbers as by strtod, ints as by strtol and
+// bools from "true" or "false". Numbers that are not finite, such as "nan", are rejected
+// rather than read as an empty cell.
+bool parseCell(const IsmProperty* property, const std::string& cell, double* values, std::vector<double>& buffer)
+{
+  const char* str = cell.c_str();
+  char* end;
+  errno = 0;
+  switch (property->type) {
+  case ISM_DOUBLE:
+    values[0] = std::strtod(str, &end);
+    return end != str && errno != ERANGE && std::isfinite(values[0]);
+  case ISM_INT:
+  {
+    long number = std::strtol(str, &end, 10);
+    values[0] = static_cast<double>(number);
+    return end != str && errno != ERANGE && number >= INT_MIN && number <= INT_MAX;
+  }
+  case ISM_BOOL:
+    values[0] = (cell == "true") ? 1.0 : 0.0;
+    return cell == "true" || cell == "false";
+  case ISM_VECTOR:
+    if (!Properties::parseDoubleList(cell, buffer) || buffer.size() != 9 ||
+        !std::all_of(buffer.begin(), buffer.end(), [](double value) { return std::isfinite(value); })) {
+      return false;
+    }
+    std::copy(buffer.begin(), buffer.end(), values);
+    return true;
+  default:
+    return false;
+  }
+}
+
+std::string readWholeFile(const std::string& file, std::ios_base::openmode mode)
+{
+  std::ifstream in(file.c_str(), std::ios_base::in | mode);
+  if (!in.is_open()) {
+    throw std::invalid_argument("Error opening portfolio file '" + file + "'");
+  }
+  in.seekg(0, std::ios_base::end);
+  std::string data(static_cast<size_t>(in.tellg()), '\0');
+  in.seekg(0, std::ios_base::beg);
+  in.read(&data[0], data.size());
+  return data;
+}
+
+}
+
+Portfolio::Portfolio() : m_rows(0), m_idColumn(-1), m_weatherColumn(-1), m_threadCount(0), m_lazyWeather(false)
+{
+}
+
+Portfolio::~Portfolio()
+{
+}
+
+unsigned Portfolio::threadCount() const
+{
+  if (m_threadCount > 0) {
+    return m_threadCount;
+  }
+  return ThreadPool::hardwareThreads();
+}
+
+template<typename Task>
+void Portfolio::forEachChunk(ThreadPool& pool, size_t count, Task task) const
+{
+  size_t chunks = std::max<size_t>(1, std::min<size_t>(threadCount(), count));
+  size_t chunkSize = (count + chunks - 1) / chunks;
+  std::vector<std::string> errors(chunks);
+  pool.parallelFor(chunks, [&](size_t chunk) {
+    size_t begin = chunk * chunkSize;
+    size_t end = std::min(count, begin + chunkSize);
+    try {
+      errors[chunk] = task(begin, end);
+    } catch (std::exception& e) {
+      errors[chunk] = e.what();
+    }
+  });
+  // Chunks are in row order, so this is the first error in the file.
+  for (auto& error : errors) {
+    if (!error.empty()) {
+      throw std::invalid_argument(error);
+    }
+  }
+}
+
+void Portfolio::clear()
+{
+  m_columns.clear();
+  m_rows = 0;
+  m_idColumn = -1;
+  m_weatherColumn = -1;
+  m_defaults = Properties();
+  m_prototype = UserModel();
+  m_stations.clear();
+  m_rowStation.clear();
+}
+
+void Portfolio::loadDefaults(const std::string& defaultsFile)
+{
+  if (!defaultsFile.empty()) {
+    m_defaults = Properties(defaultsFile);
+    bindIsmProperties(m_prototype, m_defaults, false);
+  }
+}
+
+void Portfolio::addColumn(const std::string& name)
+{
+  Column column;
+  column.name = name;
+  column.property = nullptr;
+  column.hasDefault = false;
+  if (name.size() == 2 && ::tolower(name[0]) == 'i' && ::tolower(name[1]) == 'd') {
+    if (m_idColumn >= 0) {
+      throw std::invalid_argument("Portfolio has more than one id column.");
+    }
+    column.name = ID_COLUMN;
+    m_idColumn = static_cast<int>(m_columns.size());
+  } else {
+    column.property = findIsmProperty(name);
+    if (column.property == nullptr) {
+      throw std::invalid_argument("Unknown property '" + name + "' in portfolio header.");
+    }
+    column.name = column.property->name;
+    column.hasDefault = m_defaults.contains(column.name) || !column.property->required;
+    for (auto& other : m_columns) {
+      if (other.property == column.property) {
+        throw std::invalid_argument("Property '" + column.name + "' has more than one column in portfolio.");
+      }
+    }
+    if (column.property->type == ISM_STRING && column.name == std::string("weatherfilepath")) {
+      m_weatherColumn = static_cast<int>(m_columns.size());
+    }
+  }
+  m_columns.push_back(column);
+}
+
+void Portfolio::allocateColumns()
+{
+  for (auto& column : m_columns) {
+    if (isTextColumn(column.property)) {
+      column.text.resize(m_rows);
+    } else {
+      column.numbers.resize(m_rows * width(column.property));
+    }
+  }
+  // A required property needs a column or a default.
+  for (auto& property : ismSchema()) {
+    if (!property.required || m_defaults.contains(property.name)) {
+      continue;
+    }
+    bool hasColumn = false;
+    for (auto& column : m_columns) {
+      hasColumn = hasColumn || column.property == &property;
+    }
+    if (!hasColumn) {
+      throw std::invalid_argument("Required property " + std::string(property.name) + " has no portfolio column and no default.");
+    }
+  }
+}
+
+std::string Portfolio::parseRows(const std::vector<const char*>& lines, const std::vector<size_t>& lineNumbers,
+    const char* fileEnd, size_t begin, size_t end)
+{
+  std::string cell;
+  std::vector<double> buffer;
+  for (size_t row = begin; row < end; row++) {
+    const char* p = lines[row];
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', fileEnd - p));
+    if (lineEnd == nullptr) {
+      lineEnd = fileEnd;
+    }
+    auto line = [&]() { return "line " + std::to_string(lineNumbers[row]); };
+    bool more = true;
+    for (size_t c = 0; c < m_columns.size(); c++) {
+      if (!more) {
+        return "Portfolio " + line() + " has " + std::to_string(c) + " values, expected " + std::to_string(m_columns.size()) + ".";
+      }
+      p = readField(p, lineEnd, cell, more);
+      Column& column = m_columns[c];
+      if (isTextColumn(column.property)) {
+        column.text[row] = cell;
+        continue;
+      }
+      size_t n = width(column.property);
+      double* values = &column.numbers[row * n];
+      if (cell.empty()) {
+        std::fill(values, values + n, std::numeric_limits<double>::quiet_NaN());
+      } else if (!parseCell(column.property, cell, values, buffer)) {
+        return "Invalid value '" + cell + "' for property " + column.name + " on portfolio " + line() + ".";
+      }
+    }
+    if (more) {
+      return "Portfolio " + line() + " has more than " + std::to_string(m_columns.size()) + " values.";
+    }
+  }
+  return std::string();
+}
+
+std::string Portfolio::validateRows(size_t begin, size_t end) const
+{
+  UserModel scratch(m_prototype);
+  for (size_t row = begin; row < end; row++) {
+    for (auto& column : m_columns) {
+      if (column.property == nullptr || column.hasDefault) {
+        continue;
+      }
+      bool empty = isTextColumn(column.property) ? column.text[row].empty() : isEmptyCell(column.numbers[row * width(column.property)]);
+      if (empty) {
+        return "Required property " + column.name + " missing for building " + id(row) + ".";
+      }
+    }
+    // Binary files skip parseCell, so their numbers are checked here.
+    for (auto& column : m_columns) {
+      if (!isTextColumn(column.property) && !isValidCell(&column.numbers[row * width(column.property)], width(column.property))) {
+        return "Invalid value for property " + column.name + " for building " + id(row) + ".";
+      }
+    }
+    if (const IsmProperty* property = assignRow(scratch, row)) {
+      return "Invalid value for property " + std::string(property->name) + " for building " + id(row) + ".";
+    }
+  }
+  return std::string();
+}
+
+const IsmProperty* Portfolio::assignRow(UserModel& model, size_t row) const
+{
+  for (auto& column : m_columns) {
+    if (column.property == nullptr) {
+      continue;
+    }
+    IsmValue value = { 0, nullptr, nullptr };
+    if (isTextColumn(column.property)) {
+      if (column.text[row].empty()) {
+        continue;
+      }
+      value.text = &column.text[row];
+    } else {
+      const double* values = &column.numbers[row * width(column.property)];
+      if (isEmptyCell(values[0])) {
+        continue;
+      }
+      value.number = values[0];
+      value.vector = values;
+    }
+    if (column.property->assign(model, value) != ISM_BOUND) {
+      return column.property;
+    }
+  }
+  return nullptr;
+}
+
+void Portfolio::loadCsv(const std::string& csvFile, const std::string& defaultsFile)
+{
+  clear();
+  loadDefaults(defaultsFile);
+  std::string data = readWholeFile(csvFile, std::ios_base::in);
+  const char* p = data.data();
+  const char* fileEnd = p + data.size();
+
+  // Find the header and the start of each row. Blank lines and # comments are skipped.
+  std::vector<const char*> lines;
+  std::vector<size_t> lineNumbers;
+  const char* header = nullptr;
+  size_t lineNumber = 0;
+  while (p < fileEnd) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', fileEnd - p));
+    if (lineEnd == nullptr) {
+      lineEnd = fileEnd;
+    }
+    ++lineNumber;
+    const char* first = p;
+    const char* last = lineEnd;
+    trim(first, last);
+    if (first < last && *first != '#') {
+      if (header == nullptr) {
+        header = p;
+      } else {
+        lines.push_back(p);
+        lineNumbers.push_back(lineNumber);
+      }
+    }
+    p = (lineEnd < fileEnd) ? lineEnd + 1 : fileEnd;
+  }
+  if (header == nullptr) {
+    throw std::invalid_argument("Portfolio file '" + csvFile + "' has no header.");
+  }
+
+  const char* headerEnd = static_cast<const char*>(std::memchr(header, '\n', fileEnd - header));
+  if (headerEnd == nullptr) {
+    headerEnd = fileEnd;
+  }
+  std::string name;
+  bool more = true;
+  for (const char* field = header; more;) {
+    field = readField(field, headerEnd, name, more);
+    addColumn(name);
+  }
+
+  m_rows = lines.size();
+  allocateColumns();
+  ThreadPool pool(threadCount());
+  forEachChunk(pool, m_rows, [&](size_t begin, size_t end) {
+    return parseRows(lines, lineNumbers, fileEnd, begin, end);
+  });
+  finishLoad(pool, csvFile);
+}
+
+void Portfolio::loadBinary(const std::string& binaryFile, const std::string& defaultsFile)
+{
+  clear();
+  loadDefaults(defaultsFile);
+  std::string data = readWholeFile(binaryFile, std::ios_base::binary);
+  BinaryReader reader(data, "Portfolio file '" + binaryFile + "'");
+  if (std::memcmp(reader.take(sizeof(BINARY_MAGIC)), BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+    throw std::invalid_argument("'" + binaryFile + "' is not a binary portfolio file.");
+  }
+  uint32_t version = reader.u32();
+  if (version != BINARY_VERSION) {
+    throw std::invalid_argument("Unsupported binary portfolio version " + std::to_string(version) + " in '" + binaryFile + "'.");
+  }
+  uint32_t columnCount = reader.u32();
+  m_rows = static_cast<size_t>(reader.u64());
+  for (uint32_t c = 0; c < columnCount; c++) {
+    addColumn(reader.text());
+  }
+  // Check the row count against the size of the file before allocating the columns. A row
+  // takes 8 bytes per number and at least the 4 byte length of each string.
+  size_t rowBytes = 0;
+  for (auto& column : m_columns) {
+    rowBytes += isTextColumn(column.property) ? 4 : 8 * width(column.property);
+  }
+  if (rowBytes > 0 && m_rows > (data.size() - reader.position()) / rowBytes) {
+    throw std::invalid_argument("Portfolio file '" + binaryFile + "' is truncated.");
+  }
+  allocateColumns();
+
+  // Numeric columns have a fixed size, so each column's data can be found up front and
+  // the columns decoded in parallel.
+  std::vector<size_t> offsets;
+  for (auto& column : m_columns) {
+    offsets.push_back(reader.position());
+    if (isTextColumn(column.property)) {
+      for (size_t row = 0; row < m_rows; row++) {
+        reader.take(reader.u32());
+      }
+    } else {
+      reader.take(column.numbers.size() * 8);
+    }
+  }
+  ThreadPool pool(threadCount());
+  forEachChunk(pool, m_columns.size(), [&](size_t begin, size_t end) {
+    BinaryReader columnReader(data, "Portfolio file '" + binaryFile + "'");
+    for (size_t c = begin; c < end; c++) {
+      Column& column = m_columns[c];
+      columnReader.seek(offsets[c]);
+      if (isTextColumn(column.property)) {
+        for (auto& text : column.text) {
+          text = columnReader.text();
+        }
+      } else {
+        columnReader.numbers(column.numbers.data(), column.numbers.size());
+      }
+    }
+    return std::string();
+  });
+  finishLoad(pool, binaryFile);
+}
+
+void Portfolio::saveBinary(const std::string& binaryFile) const
+{
+  BinaryWriter out;
+  out.bytes(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  out.u32(BINARY_VERSION);
+  out.u32(static_cast<uint32_t>(m_columns.size()));
+  out.u64(m_rows);
+  for (auto& column : m_columns) {
+    out.text(column.name);
+  }
+  for (auto& column : m_columns) {
+    for (auto& text : column.text) {
+      out.text(text);
+    }
+    out.numbers(column.numbers.data(), column.numbers.size());
+  }
+  out.save(binaryFile, "portfolio");
+}
+
+void Portfolio::finishLoad(ThreadPool& pool, const std::string& baseFile)
+{
+  forEachChunk(pool, m_rows, [&](size_t begin, size_t end) {
+    return validateRows(begin, end);
+  });
+  loadStations(pool, baseFile);
+}
+
+void Portfolio::loadStations(ThreadPool& pool, const std::string& baseFile)
+{
+  // Resolve each building's weather file and give every distinct file a station.
+  boost::filesystem::path baseDir = boost::filesystem::path(baseFile).parent_path();
+  std::map<std::string, int> stationIndex;
+  std::vector<std::string> stationFiles;
+  m_rowStation.resize(m_rows);
+  for (size_t row = 0; row < m_rows; row++) {
+    std::string path = m_prototype.weatherFilePath();
+    if (m_weatherColumn >= 0 && !m_columns[m_weatherColumn].text[row].empty()) {
+      path = m_columns[m_weatherColumn].text[row];
+    }
+    boost::filesystem::path resolved(path);
+    if (!boost::filesystem::exists(resolved)) {
+      resolved = baseDir / path;
+      if (!boost::filesystem::exists(resolved)) {
+        throw std::invalid_argument("Weather file '" + path + "' for building " + id(row) + " not found.");
+      }
+    }
+    std::string key = boost::filesystem::canonical(resolved).string();
+    auto station = stationIndex.find(key);
+    if (station == stationIndex.end()) {
+      station = stationIndex.insert(std::make_pair(key, static_cast<int>(stationFiles.size()))).first;
+      stationFiles.push_back(key);
+    }
+    m_rowStation[row] = station->second;
+  }
+
+  m_stations.resize(stationFiles.size());
+  for (size_t s = 0; s < m_stations.size(); s++) {
+    m_stations[s].file = stationFiles[s];
+    m_stations[s].loaded = std::make_shared<std::once_flag>();
+  }
+  if (m_lazyWeather) {
+    return;
+  }
+  forEachChunk(pool, m_stations.size(), [&](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; s++) {
+      loadStation(m_stations[s]);
+    }
+    return std::string();
+  });
+}
+
+void Portfolio::loadStation(const Station& station) const
+{
+  std::call_once(*station.loaded, [&station]() {
+    UserModel loader;
+    loader.setWeatherFilePath(station.file);
+    loader.loadWeather();
+    station.weather = loader.weatherData();
+    station.epwData = loader.epwData();
+  });
+}
+
+std::vector<std::string> Portfolio::keys() const
+{
+  std::vector<std::string> result;
+  for (auto& column : m_columns) {
+    result.push_back(column.name);
+  }
+  return result;
+}
+
+std::string Portfolio::id(size_t building) const
+{
+  if (m_idColumn >= 0 && !m_columns[m_idColumn].text[building].empty()) {
+    return m_columns[m_idColumn].text[building];
+  }
+  return std::to_string(building + 1);
+}
+
+UserModel Portfolio::model(size_t building) const
+{
+  UserModel model(m_prototype);
+  assignRow(model, building);
+  const Station& station = m_stations[m_rowStation[building]];
+  loadStation(station);
+  model.setWeather(station.weather, station.epwData);
+  model.setValid(true);
+  return model;
+}
+
+}
+}
@@ -0,0 +1,262 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_PORTFOLIO_HPP
+#define ISOMODEL_PORTFOLIO_HPP
+
+#include "ISOModelAPI.hpp"
+#include "IsmSchema.hpp"
+#include "UserModel.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class ThreadPool;
+
+/**
+ * A set of buildings held column by column, one column per .ism property.
+ *
+ * A portfolio is read from a CSV file whose header row holds .ism property names and
+ * whose other rows each describe one building, for example
+ *
+ * id,floorarea,heatingfueltype,wallu<br>
+ * office_1,2000,gas,"0.5,0.5,0.5,0.5,0.5,0.5,0.5,0.5,0.2"
+ *
+ * Vector properties are quoted lists of nine values in .ism order. An optional "id"
+ * column names the buildings. Empty cells, and properties without a column, take their
+ * values from a defaults .ism file shared by every building. The same data can be saved
+ * to and read from a binary columnar file, which loads without any text conversion.
+ *
+ * Rows are parsed in parallel chunks straight into typed columns and every value is
+ * validated when the portfolio is loaded. Each weather file is loaded once and shared by
+ * all of the buildings that use it, so model() and the iterators build ready to simulate
+ * UserModels without any file I/O and may be used from several threads at once.
+ */
+class ISOMODEL_API Portfolio
+{
+public:
+  Portfolio();
+  ~Portfolio();
+
+  /**
+   * Loads a CSV portfolio. Relative weather file paths are resolved against the
+   * directory of csvFile. Throws std::invalid_argument describing the first bad row if
+   * a cell cannot be converted, a number is not finite (such as "nan" or "inf") or a
+   * required property has neither a value nor a default.
+   */
+  void loadCsv(const std::string& csvFile, const std::string& defaultsFile = std::string());
+
+  /**
+   * Loads a portfolio saved by saveBinary(). The defaults file is not part of the binary
+   * file and has to be given again.
+   */
+  void loadBinary(const std::string& binaryFile, const std::string& defaultsFile = std::string());
+
+  /**
+   * Saves the columns in the binary columnar format. Numbers are stored as little endian
+   * IEEE doubles whatever the host byte order.
+   */
+  void saveBinary(const std::string& binaryFile) const;
+
+  /**
+   * Number of ThreadPool workers used to parse rows and load weather. 0, the default,
+   * uses one per hardware thread.
+   */
+  void setThreadCount(unsigned threadCount) {
+    m_threadCount = threadCount;
+  }
+
+  /**
+   * If true, a weather file is read by the first model() that needs it instead of when the
+   * portfolio is loaded, so that working on a subset of the buildings only reads their
+   * weather. Defaults to false. Set it before loading.
+   */
+  void setLazyWeather(bool lazyWeather) {
+    m_lazyWeather = lazyWeather;
+  }
+
+  /**
+   * Number of buildings.
+   */
+  size_t size() const {
+    return m_rows;
+  }
+
+  /**
+   * The properties that have a column, in column order.
+   */
+  std::vector<std::string> keys() const;
+
+  /**
+   * Name of a building from the "id" column, or its row number (from 1) if there is none.
+   */
+  std::string id(size_t building) const;
+
+  /**
+   * Number of distinct weather files, or stations.
+   */
+  size_t stationCount() const {
+    return m_stations.size();
+  }
+
+  /**
+   * The station of a building, from 0 to stationCount() - 1.
+   */
+  size_t station(size_t building) const {
+    return static_cast<size_t>(m_rowStation[building]);
+  }
+
+  /**
+   * The canonical path of a station's weather file.
+   */
+  const std::string& stationFile(size_t station) const {
+    return m_stations[station].file;
+  }
+
+  /**
+   * Builds the UserModel of a building: the defaults overlaid with the building's row,
+   * sharing the weather of its station.
+   */
+  UserModel model(size_t building) const;
+
+  /**
+   * Input iterator over the buildings. Dereferencing builds the building's UserModel.
+   */
+  class const_iterator
+  {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef UserModel value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const UserModel* pointer;
+    typedef UserModel reference;
+
+    const_iterator(const Portfolio* portfolio, size_t building) : m_portfolio(portfolio), m_building(building)
+    {
+    }
+
+    UserModel operator*() const {
+      return m_portfolio->model(m_building);
+    }
+
+    const_iterator& operator++() {
+      ++m_building;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator previous(*this);
+      ++m_building;
+      return previous;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return m_portfolio == other.m_portfolio && m_building == other.m_building;
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+    size_t building() const {
+      return m_building;
+    }
+
+  private:
+    const Portfolio* m_portfolio;
+    size_t m_building;
+  };
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, m_rows);
+  }
+
+private:
+  // One column of the portfolio. Numbers hold double, int and bool values (one per row)
+  // and vector values (nine per row); a NaN marks an empty cell. Text holds string values
+  // and the ids, where an empty string marks an empty cell.
+  struct Column
+  {
+    std::string name;
+    const IsmProperty* property; // nullptr for the id column.
+    bool hasDefault;
+    std::vector<double> numbers;
+    std::vector<std::string> text;
+  };
+
+  // A weather file, loaded once under loaded.
+  struct Station
+  {
+    std::string file;
+    std::shared_ptr<std::once_flag> loaded;
+    mutable std::shared_ptr<WeatherData> weather;
+    mutable std::shared_ptr<EpwData> epwData;
+  };
+
+  void clear();
+  void loadDefaults(const std::string& defaultsFile);
+  void addColumn(const std::string& name);
+  void allocateColumns();
+  // Converts the CSV lines [begin, end) into rows of the columns. Returns an empty string
+  // or the description of the first bad cell.
+  std::string parseRows(const std::vector<const char*>& lines, const std::vector<size_t>& lineNumbers, const char* fileEnd,
+      size_t begin, size_t end);
+  // Checks the rows [begin, end) for missing required values and values rejected by the
+  // setters. Returns an empty string or the description of the first bad row.
+  std::string validateRows(size_t begin, size_t end) const;
+  // Assigns the non-empty cells of a row to model. Returns the first property whose value
+  // the model rejected, or nullptr.
+  const IsmProperty* assignRow(UserModel& model, size_t row) const;
+  // Runs task(begin, end) over threadCount() chunks of [0, count) on pool. Throws
+  // std::invalid_argument with the first error a chunk returned.
+  template<typename Task>
+  void forEachChunk(ThreadPool& pool, size_t count, Task task) const;
+  void finishLoad(ThreadPool& pool, const std::string& baseFile);
+  void loadStations(ThreadPool& pool, const std::string& baseFile);
+  void loadStation(const Station& station) const;
+  unsigned threadCount() const;
+
+  std::vector<Column> m_columns;
+  size_t m_rows;
+  int m_idColumn;
+  int m_weatherColumn;
+  unsigned m_threadCount;
+  bool m_lazyWeather;
+
+  // The defaults .ism, and a model with them bound that each building starts from.
+  Properties m_defaults;
+  UserModel m_prototype;
+
+  std::vector<Station> m_stations;
+  std::vector<int> m_rowStation;
+};
+
+}
+}
+#endif
@@ -2,6 +2,15 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
 
 #include <boost/tokenizer.hpp>
 
@@ -13,9 +22,89 @@ namespace openstudio {
 
 namespace isomodel {
 
-string KeyGetter::operator()(const map<string, string>::value_type& value) const
+namespace {
+inline char lowerAscii(char c)
 {
-  return value.first;
+  return (c >= 'A' && c <= 'Z') ? (char) (c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lower case characters of the key, so keys hash the same regardless of case.
+size_t hashKey(const std::string& key)
+{
+  size_t hash = 2166136261u;
+  for (size_t i = 0; i < key.size(); i++) {
+    hash ^= (unsigned char) lowerAscii(key[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool equalsLower(const std::string& lowerKey, const std::string& key)
+{
+  if (lowerKey.size() != key.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < key.size(); i++) {
+    if (lowerKey[i] != lowerAscii(key[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Converts as std::stod does, but reports failure instead of throwing.
+bool parseDouble(const char* str, double& value)
+{
+  char* end;
+  errno = 0;
+  value = std::strtod(str, &end);
+  return end != str && errno != ERANGE;
+}
+
+// Converts as std::stoi does, but reports failure instead of throwing.
+bool parseInt(const char* str, int& value)
+{
+  char* end;
+  errno = 0;
+  long result = std::strtol(str, &end, 10);
+  if (end == str || errno == ERANGE || result < INT_MIN || result > INT_MAX) {
+    return false;
+  }
+  value = (int) result;
+  return true;
+}
+}
+
+PropertyEntry::PropertyEntry(const std::string& key, const std::string& value, size_t hash)
+  : key(key), value(value), hash(hash), parsed(0), numberOk(false), integerOk(false), numbersOk(false), number(0), integer(0)
+{
+}
+
+PropertyEntry::PropertyEntry(const PropertyEntry& other)
+  : key(other.key), value(other.value), hash(other.hash), parsed(0), numberOk(false), integerOk(false), numbersOk(false), number(0), integer(0)
+{
+  *this = other;
+}
+
+PropertyEntry& PropertyEntry::operator=(const PropertyEntry& other)
+{
+  key = other.key;
+  value = other.value;
+  hash = other.hash;
+  int flags = other.parsed.load(std::memory_order_acquire);
+  numberOk = other.numberOk;
+  integerOk = other.integerOk;
+  numbersOk = other.numbersOk;
+  number = other.number;
+  integer = other.integer;
+  numbers = other.numbers;
+  parsed.store(flags, std::memory_order_release);
+  return *this;
+}
+
+string KeyGetter::operator()(const PropertyEntry& value) const
+{
+  return value.key;
 }
 
 void str_trim(string &str)
@@ -41,182 +130,366 @@ Properties::Properties(const std::string& file) {
 }
 
 Properties::Properties(const std::string& buildingFile, const std::string& defaultsFile) {
-  // Read the buildingsFile first, then the defaultsFile because map::insert does not overwrite
-  // values and if a property exists in both files, we want the buildingFile to take precedence
-  // over the defaultsFile.
+  // The buildingFile is this layer, so its properties take precedence over the defaultsFile.
   readFile(buildingFile);
-  readFile(defaultsFile);
+  m_parent = shared(defaultsFile);
 }
 
-bool Properties::getPropertyAsDoubleVector(const std::string& key, std::vector<double>& vec) const {
-  if (auto val = getProperty(key)) {
-    vec.clear();
-    // tokenize the line using boost's escaped list separator which parses CSV format
-    boost::tokenizer<boost::escaped_list_separator<char> > tok(*val);
-    // assign those values to the vector
-    try {
-      for (auto& item : tok) {
-        vec.push_back(std::stod(item));
+Properties::Properties(std::shared_ptr<const Properties> parent) : m_parent(parent)
+{
+}
+
+Properties::Properties(const std::string& file, std::shared_ptr<const Properties> parent) : m_parent(parent)
+{
+  readFile(file);
+}
+
+Properties::Properties(const Properties& other) : m_entries(other.m_entries), m_slots(other.m_slots), m_parent(other.m_parent)
+{
+}
+
+Properties& Properties::operator=(const Properties& other)
+{
+  m_entries = other.m_entries;
+  m_slots = other.m_slots;
+  m_parent = other.m_parent;
+  return *this;
+}
+
+const size_t Properties::SHARED_FILE_LIMIT;
+
+std::shared_ptr<const Properties> Properties::shared(const std::string& file)
+{
+  struct CachedFile
+  {
+    std::time_t modified;
+    boost::uintmax_t size;
+    std::shared_ptr<const Properties> properties;
+    uint64_t lastUsed;
+  };
+  static std::mutex cacheMutex;
+  static std::map<std::string, CachedFile> cache;
+  static uint64_t useCount = 0;
+
+  std::string path = boost::filesystem::absolute(file).string();
+  boost::system::error_code ec;
+  std::time_t modified = boost::filesystem::last_write_time(path, ec);
+  boost::uintmax_t size = ec ? 0 : boost::filesystem::file_size(path, ec);
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto cached = cache.find(path);
+  if (!ec && cached != cache.end() && cached->second.modified == modified && cached->second.size == size) {
+    cached->second.lastUsed = ++useCount;
+    return cached->second.properties;
+  }
+  std::shared_ptr<const Properties> properties = std::make_shared<Properties>(file);
+  if (!ec) {
+    // Forget the least recently used file when full. Its callers keep their copy.
+    if (cached == cache.end() && cache.size() >= SHARED_FILE_LIMIT) {
+      auto oldest = cache.begin();
+      for (auto i = cache.begin(); i != cache.end(); ++i) {
+        if (i->second.lastUsed < oldest->second.lastUsed) {
+          oldest = i;
+        }
       }
+      cache.erase(oldest);
     }
-    catch (std::invalid_argument& ex) {
-      (void)ex; // Void cast to eliminate compiler warning about unused variables... seems hacky - BAA@2015-08-04.
-      return false; // Cannot be converted to a double.
+    CachedFile entry = { modified, size, properties, ++useCount };
+    cache[path] = entry;
+  }
+  return properties;
+}
+
+void Properties::setParent(std::shared_ptr<const Properties> parent)
+{
+  for (const Properties* layer = parent.get(); layer != nullptr; layer = layer->m_parent.get()) {
+    if (layer == this) {
+      throw std::invalid_argument("Properties cannot be layered over themselves.");
     }
-    return true;
   }
-  else {
-    return false; // Key missing.
+  m_parent = parent;
+}
+
+std::vector<std::string> Properties::keys() const
+{
+  std::vector<std::string> result;
+  std::unordered_set<std::string> seen;
+  for (const Properties* layer = this; layer != nullptr; layer = layer->m_parent.get()) {
+    for (auto& entry : layer->m_entries) {
+      if (seen.insert(entry.key).second) {
+        result.push_back(entry.key);
+      }
+    }
   }
+  std::sort(result.begin(), result.end());
+  return result;
 }
 
-bool Properties::getPropertyAsDoubleVector(const std::string& key, Vector& vec) const {
-  if (auto val = getProperty(key)) {
-    vec.clear();
-    // tokenize the line using boost's escaped list separator which parses CSV format
-    boost::tokenizer<boost::escaped_list_separator<char> > tok(*val);
-    // assign those values to the vector
+const PropertyEntry* Properties::find(const std::string& key, const Properties** layer) const
+{
+  for (const Properties* current = this; current != nullptr; current = current->m_parent.get()) {
+    if (const PropertyEntry* entry = current->findLocal(key)) {
+      if (layer != nullptr) {
+        *layer = current;
+      }
+      return entry;
+    }
+  }
+  return nullptr;
+}
 
-    // Make sure the ublas vector is the same size as the number of tokens.
-    auto numTokens = std::distance(std::begin(tok), std::end(tok));
-    if (vec.size() != numTokens) {
-      vec.resize(numTokens);
+const PropertyEntry* Properties::findLocal(const std::string& key) const
+{
+  if (m_slots.empty()) {
+    return nullptr;
+  }
+  size_t hash = hashKey(key);
+  size_t mask = m_slots.size() - 1;
+  for (size_t i = hash & mask; m_slots[i] != -1; i = (i + 1) & mask) {
+    const PropertyEntry& entry = m_entries[m_slots[i]];
+    if (entry.hash == hash && equalsLower(entry.key, key)) {
+      return &entry;
     }
+  }
+  return nullptr;
+}
+
+PropertyEntry& Properties::insert(const std::string& key, const std::string& value, bool& added)
+{
+  if (const PropertyEntry* entry = findLocal(key)) {
+    added = false;
+    return const_cast<PropertyEntry&>(*entry);
+  }
+  // Keep the table at most half full.
+  if (2 * (m_entries.size() + 1) > m_slots.size()) {
+    rehash(std::max<size_t>(64, 2 * m_slots.size()));
+  }
+  std::string k(key);
+  std::transform(key.begin(), key.end(), k.begin(), lowerAscii);
+  size_t hash = hashKey(key);
+  size_t mask = m_slots.size() - 1;
+  size_t i = hash & mask;
+  while (m_slots[i] != -1) {
+    i = (i + 1) & mask;
+  }
+  m_slots[i] = static_cast<int>(m_entries.size());
+  m_entries.push_back(PropertyEntry(k, value, hash));
+  added = true;
+  return m_entries.back();
+}
+
+void Properties::rehash(size_t slotCount)
+{
+  m_slots.assign(slotCount, -1);
+  size_t mask = slotCount - 1;
+  for (size_t e = 0; e < m_entries.size(); e++) {
+    size_t i = m_entries[e].hash & mask;
+    while (m_slots[i] != -1) {
+      i = (i + 1) & mask;
+    }
+    m_slots[i] = static_cast<int>(e);
+  }
+}
 
-    try {
-      auto index = 0;
-      for (auto& item : tok) {
-        vec[index] = (std::stod(item));
-        ++index;
+bool Properties::parseDoubleList(const std::string& value, std::vector<double>& vec)
+{
+  vec.clear();
+  if (value.find_first_of("\"\\") != string::npos) {
+    // tokenize the line using boost's escaped list separator which parses CSV format
+    boost::tokenizer<boost::escaped_list_separator<char> > tok(value);
+    for (auto& item : tok) {
+      double number;
+      if (!parseDouble(item.c_str(), number)) {
+        return false; // Cannot be converted to a double.
       }
+      vec.push_back(number);
     }
-    catch (std::invalid_argument& ex) {
-      (void)ex; // Void cast to eliminate compiler warning about unused variables... seems hacky - BAA@2015-08-04.
+    return true;
+  }
+  // Plain lists are converted in place, field by field.
+  const char* field = value.c_str();
+  while (true) {
+    double number;
+    const char* comma = std::strchr(field, ',');
+    if (!parseDouble(field, number)) {
       return false; // Cannot be converted to a double.
     }
-    return true;
+    vec.push_back(number);
+    if (comma == nullptr) {
+      return true;
+    }
+    field = comma + 1;
   }
-  else {
+}
+
+bool Properties::getPropertyAsDoubleVector(const std::string& key, std::vector<double>& vec) const {
+  const Properties* layer = this;
+  const PropertyEntry* entry = find(key, &layer);
+  if (entry == nullptr) {
     return false; // Key missing.
   }
+  if (!(entry->parsed.load(std::memory_order_acquire) & PropertyEntry::NUMBERS)) {
+    std::lock_guard<std::mutex> lock(layer->m_cacheMutex);
+    if (!(entry->parsed.load(std::memory_order_relaxed) & PropertyEntry::NUMBERS)) {
+      entry->numbersOk = parseDoubleList(entry->value, entry->numbers);
+      entry->parsed.fetch_or(PropertyEntry::NUMBERS, std::memory_order_release);
+    }
+  }
+  if (!entry->numbersOk) {
+    return false; // Cannot be converted to a double.
+  }
+  vec = entry->numbers;
+  return true;
+}
+
+bool Properties::getPropertyAsDoubleVector(const std::string& key, Vector& vec) const {
+  std::vector<double> numbers;
+  if (!getPropertyAsDoubleVector(key, numbers)) {
+    return false;
+  }
+  // Make sure the ublas vector is the same size as the number of values.
+  if (vec.size() != numbers.size()) {
+    vec.resize(numbers.size());
+  }
+  for (size_t i = 0; i < numbers.size(); ++i) {
+    vec[i] = numbers[i];
+  }
+  return true;
 }
 
 boost::optional<double> Properties::getPropertyAsDouble(const std::string& key) const
 {
-  if (auto val = getProperty(key)) {
-    try {
-      return std::stod(*val);
-    } catch (std::invalid_argument& ex) {
-      (void)ex; // Void cast to eliminate compiler warning about unused variables... seems hacky - BAA@2015-08-04.
-      return boost::none; // Cannot be converted to a double.
+  const Properties* layer = this;
+  const PropertyEntry* entry = find(key, &layer);
+  if (entry == nullptr) {
+    return boost::none; // Key missing.
+  }
+  if (!(entry->parsed.load(std::memory_order_acquire) & PropertyEntry::NUMBER)) {
+    std::lock_guard<std::mutex> lock(layer->m_cacheMutex);
+    if (!(entry->parsed.load(std::memory_order_relaxed) & PropertyEntry::NUMBER)) {
+      entry->numberOk = parseDouble(entry->value.c_str(), entry->number);
+      entry->parsed.fetch_or(PropertyEntry::NUMBER, std::memory_order_release);
     }
   }
-  else {
-    return boost::none; // Key missing.
+  if (!entry->numberOk) {
+    return boost::none; // Cannot be converted to a double.
   }
+  return entry->number;
 }
 
 boost::optional<int> Properties::getPropertyAsInt(const std::string& key) const
 {
-  if (auto val = getProperty(key)) {
-    try {
-      return std::stoi(*val);
-    } catch (std::invalid_argument& ex) {
-      (void)ex; // Void cast to eliminate compiler warning about unused variables... seems hacky - BAA@2015-08-04.
-      return boost::none; // Cannot be converted to a int.
+  const Properties* layer = this;
+  const PropertyEntry* entry = find(key, &layer);
+  if (entry == nullptr) {
+    return boost::none; // Key missing.
+  }
+  if (!(entry->parsed.load(std::memory_order_acquire) & PropertyEntry::INTEGER)) {
+    std::lock_guard<std::mutex> lock(layer->m_cacheMutex);
+    if (!(entry->parsed.load(std::memory_order_relaxed) & PropertyEntry::INTEGER)) {
+      entry->integerOk = parseInt(entry->value.c_str(), entry->integer);
+      entry->parsed.fetch_or(PropertyEntry::INTEGER, std::memory_order_release);
     }
   }
-  else {
-    return boost::none; // Key missing.
+  if (!entry->integerOk) {
+    return boost::none; // Cannot be converted to a int.
   }
+  return entry->integer;
 }
 
 boost::optional<bool> Properties::getPropertyAsBool(const std::string& key) const
 {
-  if (auto val = getProperty(key)) {
-    if (*val == "true") {
-      return true;
-    } else if (*val == "false") {
-      return false;
-    } else {
-      return boost::none; // Cannot be converted to a bool.
-    }
-  }
-  else {
+  const PropertyEntry* entry = find(key);
+  if (entry == nullptr) {
     return boost::none; // Key missing.
   }
+  if (entry->value == "true") {
+    return true;
+  } else if (entry->value == "false") {
+    return false;
+  } else {
+    return boost::none; // Cannot be converted to a bool.
+  }
 }
 
 void Properties::putProperty(const string& key, string value)
 {
-  std::string k(key);
-  std::transform(key.begin(), key.end(), k.begin(), ::tolower);
-  map[k] = value;
+  bool added;
+  PropertyEntry& entry = insert(key, value, added);
+  if (!added) {
+    entry.value = value;
+    entry.parsed.store(0, std::memory_order_release);
+  }
 }
 
 void Properties::putProperty(const string& key, double value)
 {
-  std::string k(key);
-  std::transform(key.begin(), key.end(), k.begin(), ::tolower);
-  map[k] = std::to_string(value);
+  bool added;
+  PropertyEntry& entry = insert(key, std::to_string(value), added);
+  if (!added) {
+    entry.value = std::to_string(value);
+  }
+  // The string form is rounded, so cache the exact number.
+  entry.number = value;
+  entry.numberOk = true;
+  entry.parsed.store(PropertyEntry::NUMBER, std::memory_order_release);
 }
 
 bool Properties::contains(const string& key) const
 {
-
-  std::string k(key);
-  std::transform(key.begin(), key.end(), k.begin(), ::tolower);
-  return map.find(k) != map.end();
+  return find(key) != nullptr;
 }
 
 boost::optional<string> Properties::getProperty(const string& key) const
 {
-  std::string k(key);
-  std::transform(key.begin(), key.end(), k.begin(), ::tolower);
-  std::map<string, string>::const_iterator iter = map.find(k);
-  if (iter == map.end())
+  const PropertyEntry* entry = find(key);
+  if (entry == nullptr)
     return boost::none;
   else
-    return iter->second;
+    return entry->value;
 }
 
 void Properties::readFile(const std::string& file)
 {
   ifstream in_file(file.c_str(), ios_base::in);
   if (in_file.is_open()) {
-    std::string line;
-    int line_num = 0;
-    while (std::getline(in_file, line)) {
-      ++line_num;
-      str_trim(line);
-      if (line.length() > 0 && line[0] != '#') {
-
-        size_t pos = line.find_first_of("=");
-        if (pos == string::npos)
-          throw new domain_error("Invalid format in file '" + file + "' on line " + std::to_string(line_num));
-        string key = line.substr(0, pos);
-        str_trim(key);
-        if (key.length() == 0)
-          throw new domain_error("Missing property key in properties file '" + file + "'on line " + std::to_string(line_num));
-        string value = "";
-        if (line.length() > pos) {
-          // this makes sure we only try to get value if it exists
-          value = line.substr(pos + 1, line.length());
-        }
-        str_trim(value);
-        if (value.length() == 0)
-          throw new domain_error("Missing property value in properties file '" + file + "'on line " + std::to_string(line_num));
-
-        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-        map.insert(std::make_pair(key, value));
-      }
-    }
+    readStream(in_file, file);
     in_file.close();
   } else {
     throw new domain_error("Error opening properties file '" + file + "'");
   }
 }
 
+void Properties::readStream(std::istream& in, const std::string& source)
+{
+  std::string line;
+  int line_num = 0;
+  while (std::getline(in, line)) {
+    ++line_num;
+    str_trim(line);
+    if (line.length() > 0 && line[0] != '#') {
+
+      size_t pos = line.find_first_of("=");
+      if (pos == string::npos)
+        throw new domain_error("Invalid format in file '" + source + "' on line " + std::to_string(line_num));
+      string key = line.substr(0, pos);
+      str_trim(key);
+      if (key.length() == 0)
+        throw new domain_error("Missing property key in properties file '" + source + "'on line " + std::to_string(line_num));
+      string value = "";
+      if (line.length() > pos) {
+        // this makes sure we only try to get value if it exists
+        value = line.substr(pos + 1, line.length());
+      }
+      str_trim(value);
+      if (value.length() == 0)
+        throw new domain_error("Missing property value in properties file '" + source + "'on line " + std::to_string(line_num));
+
+      bool added;
+      insert(key, value, added);
+    }
+  }
+}
+
 }
 
 }
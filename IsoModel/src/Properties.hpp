@@ -7,8 +7,11 @@
 #include <fstream>
 
 #include <iostream>
-#include <map>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/filesystem.hpp>
@@ -25,13 +28,37 @@ namespace openstudio {
 namespace isomodel {
 
 /**
- * Unary function used in a transform_iterator that allows the map
+ * A property stored in a Properties. The key is held in lower case, and typed
+ * conversions of the value are parsed on first use and cached.
+ */
+struct ISOMODEL_API PropertyEntry
+{
+  PropertyEntry(const std::string& key, const std::string& value, size_t hash);
+  PropertyEntry(const PropertyEntry& other);
+  PropertyEntry& operator=(const PropertyEntry& other);
+
+  std::string key;
+  std::string value;
+  size_t hash;
+
+  // Bit flags of the conversions that have been cached.
+  enum { NUMBER = 1, INTEGER = 2, NUMBERS = 4 };
+  mutable std::atomic<int> parsed;
+  mutable bool numberOk, integerOk, numbersOk;
+  mutable double number;
+  mutable int integer;
+  mutable std::vector<double> numbers;
+};
+
+/**
+ * Unary function used in a transform_iterator that allows the entry
  * iterator to return the keys
  */
 
-struct ISOMODEL_API KeyGetter: public std::unary_function<std::map<std::string, std::string>::value_type, std::string>
+struct ISOMODEL_API KeyGetter
 {
-  std::string operator()(const std::map<std::string, std::string>::value_type& value) const;
+  typedef std::string result_type;
+  std::string operator()(const PropertyEntry& value) const;
 };
 
 /**
@@ -43,18 +70,44 @@ struct ISOMODEL_API KeyGetter: public std::unary_function<std::map<std::string,
  * another.property = hello
  *
  * Key are case insensitive and stored in lower case.
+ *
+ * Properties are held in an open addressing hash table. Keys are lowercased once
+ * when they are inserted; lookups hash and compare the requested key case
+ * insensitively without copying it. Numeric conversions are parsed on first use
+ * and cached, so a Properties may be read from several threads at once.
+ *
+ * A Properties may be layered over a parent, e.g. building properties over building
+ * type defaults over organization defaults. Lookups consult this layer first and then
+ * each parent in turn; parents are shared by pointer and never copied or modified.
+ * keys_begin(), keys_end() and size() describe this layer only; keys() lists every
+ * visible key.
  */
 class ISOMODEL_API Properties
 {
 
 private:
-  std::map<std::string, std::string> map;
+  // Entries in insertion order, and the hash slots indexing them (-1 is empty).
+  std::vector<PropertyEntry> m_entries;
+  std::vector<int> m_slots;
+  // Guards filling the typed value caches of the entries.
+  mutable std::mutex m_cacheMutex;
+
+  // Layer consulted for keys not in this one.
+  std::shared_ptr<const Properties> m_parent;
 
   void readFile(const std::string& file);
 
+  // Finds key in this layer only.
+  const PropertyEntry* findLocal(const std::string& key) const;
+  // Finds key in this layer or a parent. layer is set to the Properties holding the entry.
+  const PropertyEntry* find(const std::string& key, const Properties** layer = nullptr) const;
+  // Adds the property if it is not present. Returns the entry and whether it was added.
+  PropertyEntry& insert(const std::string& key, const std::string& value, bool& added);
+  void rehash(size_t slotCount);
+
 public:
 
-  typedef boost::transform_iterator<KeyGetter, std::map<std::string, std::string>::const_iterator> key_iterator;
+  typedef boost::transform_iterator<KeyGetter, std::vector<PropertyEntry>::const_iterator> key_iterator;
 
   /**
    * Creates an empty Properties.
@@ -74,10 +127,52 @@ public:
   
   /**
   * Creates a new Properties using the properties defined in the specified
-  * buildingFile and defaults from the specified defaultsFile
+  * buildingFile and defaults from the specified defaultsFile. The defaults are
+  * a parent layer obtained from shared(defaultsFile), so a defaults file used
+  * by many buildings is only parsed once.
   */
   Properties(const std::string& buildingFile, const std::string& defaultFile);
 
+  /**
+   * Creates an empty layer over parent.
+   */
+  explicit Properties(std::shared_ptr<const Properties> parent);
+
+  /**
+   * Creates a layer holding the properties defined in file over parent.
+   */
+  Properties(const std::string& file, std::shared_ptr<const Properties> parent);
+
+  /**
+   * Returns the parsed properties of file, shared with every other caller asking for
+   * the same file. The file is parsed again only if it has changed since it was last
+   * parsed. The SHARED_FILE_LIMIT most recently used files are kept; others are parsed
+   * again when asked for. Safe to call from several threads.
+   */
+  static std::shared_ptr<const Properties> shared(const std::string& file);
+
+  // Number of files whose properties shared() keeps.
+  static const size_t SHARED_FILE_LIMIT = 32;
+
+  /**
+   * The layer consulted for keys not in this one, or nullptr.
+   */
+  std::shared_ptr<const Properties> parent() const
+  {
+    return m_parent;
+  }
+
+  void setParent(std::shared_ptr<const Properties> parent);
+
+  /**
+   * Adds the properties defined in in, which has the format of a properties file, to
+   * this layer. source names the text in error messages.
+   */
+  void readStream(std::istream& in, const std::string& source);
+
+  Properties(const Properties& other);
+  Properties& operator=(const Properties& other);
+
   virtual ~Properties()
   {
   }
@@ -95,7 +190,8 @@ public:
    * Puts a property into this Properties with
    * the specified key and value. Note that
    * even though the second argument can be passed
-   * as a numeric value, it is stored as a string
+   * as a numeric value, it is stored as a string.
+   * getPropertyAsDouble returns the exact value.
    *
    * @param key the property key
    * @param value the property value
@@ -155,6 +251,21 @@ public:
   bool getPropertyAsDoubleVector(const std::string& key, std::vector<double>& vec) const;
   bool getPropertyAsDoubleVector(const std::string& key, Vector& vec) const;
 
+  /**
+   * Parses a comma separated list of doubles into vec. Fields are converted as by
+   * std::stod. Values containing quotes or escapes are split as CSV by boost's
+   * escaped_list_separator.
+   *
+   * @return false if any field cannot be converted to a double.
+   */
+  static bool parseDoubleList(const std::string& value, std::vector<double>& vec);
+
+  /**
+   * Gets the keys visible through this Properties, from this layer and its parents,
+   * each listed once, in sorted order.
+   */
+  std::vector<std::string> keys() const;
+
   /**
    * Gets whether or not this Properties contains the specified key.
    *
@@ -163,13 +274,14 @@ public:
   bool contains(const std::string& key) const;
 
   /**
-   * Gets the start of an iterator over this Properties' keys.
+   * Gets the start of an iterator over this Properties' keys. The keys are in the
+   * order they were first put, i.e. file order, not sorted; use keys() for sorted keys.
    *
    * @return the start of an iterator over this Properties' keys.
    */
   key_iterator keys_begin() const
   {
-    return key_iterator(map.begin());
+    return key_iterator(m_entries.begin());
   }
 
   /**
@@ -179,7 +291,7 @@ public:
    */
   key_iterator keys_end() const
   {
-    return key_iterator(map.end());
+    return key_iterator(m_entries.end());
   }
 
   /**
@@ -189,7 +301,7 @@ public:
    */
   int size() const
   {
-    return static_cast<int>(map.size());
+    return static_cast<int>(m_entries.size());
   }
 
 };
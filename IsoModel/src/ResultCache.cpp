@@ -0,0 +1,308 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "ResultCache.hpp"
+#include "ModelParameters.hpp"
+#include "Simulation.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char STORE_MAGIC[8] = { 'I', 'S', 'M', 'R', 'E', 'S', 'L', 'T' };
+const uint32_t STORE_VERSION = 1;
+
+// Part of every result key. Must be incremented whenever a change to the simulation
+// changes its results, so that stored results of the previous version are not used.
+const uint32_t RESULT_KEY_VERSION = 1;
+
+// Memory held by an entry besides its values.
+const size_t ENTRY_OVERHEAD = 96;
+
+struct ContentHashHasher
+{
+  size_t operator()(const ContentHash& key) const {
+    return (size_t) key.low;
+  }
+};
+
+template<class T>
+void writeComponent(BinaryWriter& out, const CopyOnWrite<T>& component)
+{
+  // Writing does not modify the component.
+  const_cast<T&>(*component).serialize(out);
+}
+
+std::vector<double> flatten(const std::vector<EndUses>& results)
+{
+  std::vector<double> values;
+  values.reserve(results.size() * END_USE_COUNT);
+  for (const auto& period : results) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      values.push_back(endUseValue(period, endUse));
+    }
+  }
+  return values;
+}
+
+std::vector<EndUses> unflatten(const std::vector<double>& values)
+{
+  std::vector<EndUses> results(values.size() / END_USE_COUNT);
+  const double* value = values.data();
+  for (auto& period : results) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      setEndUseValue(period, endUse, *value++);
+    }
+  }
+  return results;
+}
+
+}
+
+ContentHash Simulation::resultKey(ResultKind kind) const
+{
+  BinaryWriter out;
+  out.u32(RESULT_KEY_VERSION);
+  out.u8((uint8_t) kind);
+  writeComponent(out, pop);
+  writeComponent(out, location);
+  writeComponent(out, lights);
+  writeComponent(out, building);
+  writeComponent(out, structure);
+  writeComponent(out, heating);
+  writeComponent(out, cooling);
+  writeComponent(out, ventilation);
+  writeComponent(out, phys);
+  writeComponent(out, simSettings);
+  // The monthly method uses the weather reduced to monthly values, the hourly method the
+  // hourly data itself. Both are hashed once and identified by their hash.
+  ContentHash weather = location->weather() ? location->weather()->fingerprint() : ContentHash::of("", 0);
+  out.u64(weather.high);
+  out.u64(weather.low);
+  if (kind != MONTHLY_RESULTS) {
+    weather = epwData->fingerprint();
+    out.u64(weather.high);
+    out.u64(weather.low);
+  }
+  return out.hash();
+}
+
+struct ResultCache::Shard
+{
+  typedef std::list<std::pair<ContentHash, std::vector<double> > > Entries;
+
+  std::mutex mutex;
+  // Most recently used first.
+  Entries entries;
+  std::unordered_map<ContentHash, Entries::iterator, ContentHashHasher> index;
+  size_t bytes;
+
+  Shard() : bytes(0)
+  {
+  }
+};
+
+const size_t ResultCache::DEFAULT_CAPACITY;
+
+ResultCache::ResultCache(size_t capacity, const std::string& directory, size_t shards)
+  : m_shardCapacity(capacity / std::max<size_t>(shards, 1)), m_directory(directory), m_hits(0), m_diskHits(0), m_misses(0),
+    m_evictions(0), m_diskErrors(0)
+{
+  for (size_t i = 0; i < std::max<size_t>(shards, 1); i++) {
+    m_shards.push_back(std::unique_ptr<Shard>(new Shard()));
+  }
+  if (!m_directory.empty()) {
+    boost::system::error_code error;
+    boost::filesystem::create_directories(m_directory, error);
+    if (!boost::filesystem::is_directory(m_directory)) {
+      throw std::invalid_argument("Cannot create the result store " + m_directory + ".");
+    }
+  }
+}
+
+ResultCache::~ResultCache()
+{
+}
+
+ResultCache::Shard& ResultCache::shard(const ContentHash& key) const
+{
+  return *m_shards[key.high % m_shards.size()];
+}
+
+bool ResultCache::find(const ContentHash& key, std::vector<EndUses>& results)
+{
+  {
+    Shard& entries = shard(key);
+    std::lock_guard<std::mutex> lock(entries.mutex);
+    auto found = entries.index.find(key);
+    if (found != entries.index.end()) {
+      entries.entries.splice(entries.entries.begin(), entries.entries, found->second);
+      results = unflatten(found->second->second);
+      m_hits++;
+      return true;
+    }
+  }
+  std::vector<double> values;
+  if (!m_directory.empty() && readStore(key, values)) {
+    results = unflatten(values);
+    remember(key, std::move(values));
+    m_diskHits++;
+    return true;
+  }
+  m_misses++;
+  return false;
+}
+
+void ResultCache::insert(const ContentHash& key, const std::vector<EndUses>& results)
+{
+  std::vector<double> values = flatten(results);
+  if (!m_directory.empty()) {
+    writeStore(key, values);
+  }
+  remember(key, std::move(values));
+}
+
+std::vector<EndUses> ResultCache::getOrCompute(const ContentHash& key, const std::function<std::vector<EndUses>()>& compute)
+{
+  std::vector<EndUses> results;
+  if (!find(key, results)) {
+    results = compute();
+    insert(key, results);
+  }
+  return results;
+}
+
+void ResultCache::remember(const ContentHash& key, std::vector<double>&& values)
+{
+  size_t size = values.size() * sizeof(double) + ENTRY_OVERHEAD;
+  if (size > m_shardCapacity) {
+    return;
+  }
+  Shard& entries = shard(key);
+  std::lock_guard<std::mutex> lock(entries.mutex);
+  auto found = entries.index.find(key);
+  if (found != entries.index.end()) {
+    entries.entries.splice(entries.entries.begin(), entries.entries, found->second);
+    return;
+  }
+  while (entries.bytes + size > m_shardCapacity) {
+    auto& oldest = entries.entries.back();
+    entries.bytes -= oldest.second.size() * sizeof(double) + ENTRY_OVERHEAD;
+    entries.index.erase(oldest.first);
+    entries.entries.pop_back();
+    m_evictions++;
+  }
+  entries.entries.push_front(std::make_pair(key, std::move(values)));
+  entries.index[key] = entries.entries.begin();
+  entries.bytes += size;
+}
+
+std::string ResultCache::storeFile(const ContentHash& key) const
+{
+  return (boost::filesystem::path(m_directory) / (key.toString() + ".isr")).string();
+}
+
+bool ResultCache::readStore(const ContentHash& key, std::vector<double>& values)
+{
+  std::string file = storeFile(key);
+  if (!boost::filesystem::exists(file)) {
+    return false;
+  }
+  try {
+    std::string data = BinaryReader::load(file, "result");
+    BinaryReader in(data, "Result file '" + file + "'");
+    ContentHash stored;
+    bool valid = std::memcmp(in.take(sizeof(STORE_MAGIC)), STORE_MAGIC, sizeof(STORE_MAGIC)) == 0 && in.u32() == STORE_VERSION;
+    if (valid) {
+      stored.high = in.u64();
+      stored.low = in.u64();
+      in & values;
+    }
+    if (valid && stored == key && values.size() % END_USE_COUNT == 0) {
+      return true;
+    }
+  } catch (std::invalid_argument&) {
+  }
+  m_diskErrors++;
+  return false;
+}
+
+void ResultCache::writeStore(const ContentHash& key, const std::vector<double>& values)
+{
+  BinaryWriter out;
+  out.bytes(STORE_MAGIC, sizeof(STORE_MAGIC));
+  out.u32(STORE_VERSION);
+  out.u64(key.high);
+  out.u64(key.low);
+  out & values;
+  std::string file = storeFile(key);
+  std::string temporary = file + "." + boost::filesystem::unique_path().string() + ".tmp";
+  try {
+    out.save(temporary, "result");
+    boost::filesystem::rename(temporary, file);
+  } catch (std::exception&) {
+    boost::system::error_code error;
+    boost::filesystem::remove(temporary, error);
+    m_diskErrors++;
+  }
+}
+
+ResultCacheStatistics ResultCache::statistics() const
+{
+  ResultCacheStatistics statistics;
+  statistics.hits = m_hits;
+  statistics.diskHits = m_diskHits;
+  statistics.misses = m_misses;
+  statistics.evictions = m_evictions;
+  statistics.diskErrors = m_diskErrors;
+  statistics.entries = 0;
+  statistics.bytes = 0;
+  for (const auto& entries : m_shards) {
+    std::lock_guard<std::mutex> lock(entries->mutex);
+    statistics.entries += entries->index.size();
+    statistics.bytes += entries->bytes;
+  }
+  return statistics;
+}
+
+void ResultCache::clear()
+{
+  for (const auto& entries : m_shards) {
+    std::lock_guard<std::mutex> lock(entries->mutex);
+    entries->entries.clear();
+    entries->index.clear();
+    entries->bytes = 0;
+  }
+  m_hits = 0;
+  m_diskHits = 0;
+  m_misses = 0;
+  m_evictions = 0;
+  m_diskErrors = 0;
+}
+
+}
+}
@@ -0,0 +1,140 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_RESULT_CACHE_HPP
+#define ISOMODEL_RESULT_CACHE_HPP
+
+#include "ISOModelAPI.hpp"
+#include "BinaryArchive.hpp"
+
+#ifdef ISOMODEL_STANDALONE
+#include "EndUses.hpp"
+#else
+#include "../utilities/data/EndUses.hpp"
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * The results a key of a ResultCache stands for: the method and how they are aggregated.
+ */
+enum ResultKind
+{
+  MONTHLY_RESULTS,
+  HOURLY_BY_MONTH_RESULTS,
+  HOURLY_RESULTS
+};
+
+struct ISOMODEL_API ResultCacheStatistics
+{
+  uint64_t hits; // Found in memory.
+  uint64_t diskHits; // Found in the disk store (and then kept in memory).
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t diskErrors; // Store files that could not be written or read back.
+  size_t entries;
+  size_t bytes;
+
+  double hitRate() const {
+    uint64_t lookups = hits + diskHits + misses;
+    return lookups > 0 ? (double) (hits + diskHits) / lookups : 0;
+  }
+};
+
+/**
+ * A thread safe cache of simulation results addressed by the hash of their inputs (see
+ * Simulation::resultKey), so identical models share results whichever UserModel, plan or
+ * request they come from.
+ *
+ * Results are kept in memory in shards, each a least recently used list under its own
+ * lock, holding up to capacity bytes in all. With a directory, every result is also
+ * written to a file named by its key, and results missing from memory are looked up
+ * there, so the store outlives the process and may be shared by several processes.
+ * Files are written to a temporary name and renamed, so readers never see partial
+ * results; files that cannot be read are treated as misses.
+ *
+ * Concurrent misses of the same key both compute the results.
+ */
+class ISOMODEL_API ResultCache
+{
+public:
+  static const size_t DEFAULT_CAPACITY = 64 << 20;
+
+  /**
+   * Throws std::invalid_argument if directory cannot be created.
+   */
+  explicit ResultCache(size_t capacity = DEFAULT_CAPACITY, const std::string& directory = std::string(), size_t shards = 16);
+  ~ResultCache();
+
+  const std::string& directory() const {
+    return m_directory;
+  }
+
+  /**
+   * Copies the results of key to results. Returns false on a miss.
+   */
+  bool find(const ContentHash& key, std::vector<EndUses>& results);
+
+  void insert(const ContentHash& key, const std::vector<EndUses>& results);
+
+  /**
+   * The results of key, computed by compute and inserted on a miss.
+   */
+  std::vector<EndUses> getOrCompute(const ContentHash& key, const std::function<std::vector<EndUses>()>& compute);
+
+  ResultCacheStatistics statistics() const;
+
+  /**
+   * Empties the memory cache (not the disk store) and resets the statistics.
+   */
+  void clear();
+
+private:
+  struct Shard;
+
+  ResultCache(const ResultCache&);
+  ResultCache& operator=(const ResultCache&);
+
+  Shard& shard(const ContentHash& key) const;
+  std::string storeFile(const ContentHash& key) const;
+  bool readStore(const ContentHash& key, std::vector<double>& values);
+  void writeStore(const ContentHash& key, const std::vector<double>& values);
+  // Adds values to the memory cache, evicting the least recently used results of the shard.
+  void remember(const ContentHash& key, std::vector<double>&& values);
+
+  std::vector<std::unique_ptr<Shard> > m_shards;
+  size_t m_shardCapacity;
+  std::string m_directory;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_diskHits;
+  std::atomic<uint64_t> m_misses;
+  std::atomic<uint64_t> m_evictions;
+  std::atomic<uint64_t> m_diskErrors;
+};
+
+}
+}
+#endif
@@ -0,0 +1,676 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "ResultFile.hpp"
+#include "BinaryArchive.hpp"
+#include "CsvWriter.hpp"
+#include "ModelParameters.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char FILE_MAGIC[8] = { 'I', 'S', 'M', 'C', 'O', 'L', 'R', 'S' };
+const uint32_t FILE_VERSION = 1;
+// The magic, the version and the size of the rest of the header.
+const size_t PREAMBLE_SIZE = 16;
+// The directory offset and the magic.
+const size_t TRAILER_SIZE = 16;
+
+bool hostIsLittleEndian()
+{
+  const uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+const bool LITTLE_ENDIAN_HOST = hostIsLittleEndian();
+
+uint64_t readU64(const char* data)
+{
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | (unsigned char) data[i];
+  }
+  return value;
+}
+
+uint32_t readU32(const char* data)
+{
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; i--) {
+    value = (value << 8) | (unsigned char) data[i];
+  }
+  return value;
+}
+
+// Runs of zero bytes at least this long are replaced by their length.
+const size_t MIN_ZERO_RUN = 3;
+
+void putVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out += (char) ((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += (char) value;
+}
+
+// Appends data to out as tokens: a count byte of 1 to 255 followed by that many literal
+// bytes, or a zero byte followed by the varint length of a run of zero bytes.
+void packZeros(const unsigned char* data, size_t size, std::string& out)
+{
+  size_t literal = 0; // Start of the pending literal bytes.
+  size_t i = 0;
+  auto flush = [&](size_t end) {
+    while (literal < end) {
+      size_t count = std::min(end - literal, (size_t) 255);
+      out += (char) count;
+      out.append((const char*) data + literal, count);
+      literal += count;
+    }
+  };
+  while (i < size) {
+    const void* zero = std::memchr(data + i, 0, size - i);
+    if (!zero) {
+      break;
+    }
+    size_t start = (const unsigned char*) zero - data;
+    size_t run = start + 1;
+    uint64_t word;
+    while (run + sizeof(word) <= size && (std::memcpy(&word, data + run, sizeof(word)), word == 0)) {
+      run += sizeof(word);
+    }
+    while (run < size && data[run] == 0) {
+      run++;
+    }
+    if (run - start >= MIN_ZERO_RUN) {
+      flush(start);
+      out += '\0';
+      putVarint(out, run - start);
+      literal = run;
+    }
+    i = run;
+  }
+  flush(size);
+}
+
+void unpackZeros(const unsigned char* data, size_t size, unsigned char* out, size_t outSize)
+{
+  size_t written = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    unsigned count = data[pos++];
+    if (count > 0) {
+      if (count > size - pos || count > outSize - written) {
+        throw std::invalid_argument("bad literal");
+      }
+      std::memcpy(out + written, data + pos, count);
+      pos += count;
+      written += count;
+      continue;
+    }
+    uint64_t run = 0;
+    for (int shift = 0;; shift += 7) {
+      if (pos == size || shift > 63) {
+        throw std::invalid_argument("bad run length");
+      }
+      unsigned char byte = data[pos++];
+      run |= (uint64_t) (byte & 0x7F) << shift;
+      if (byte < 0x80) {
+        break;
+      }
+    }
+    if (run > outSize - written) {
+      throw std::invalid_argument("bad run length");
+    }
+    std::memset(out + written, 0, (size_t) run);
+    written += (size_t) run;
+  }
+  if (written != outSize) {
+    throw std::invalid_argument("short column");
+  }
+}
+
+// The bit patterns of the values as stored.
+template<class Word>
+void toWords(const double* values, size_t count, Word* words);
+
+template<>
+void toWords<uint64_t>(const double* values, size_t count, uint64_t* words)
+{
+  std::memcpy(words, values, count * sizeof(double));
+}
+
+template<>
+void toWords<uint32_t>(const double* values, size_t count, uint32_t* words)
+{
+  for (size_t i = 0; i < count; i++) {
+    float value = (float) values[i];
+    std::memcpy(&words[i], &value, sizeof(value));
+  }
+}
+
+template<class Word>
+void fromWords(const Word* words, size_t count, double* values);
+
+template<>
+void fromWords<uint64_t>(const uint64_t* words, size_t count, double* values)
+{
+  std::memcpy(values, words, count * sizeof(double));
+}
+
+template<>
+void fromWords<uint32_t>(const uint32_t* words, size_t count, double* values)
+{
+  for (size_t i = 0; i < count; i++) {
+    float value;
+    std::memcpy(&value, &words[i], sizeof(value));
+    values[i] = value;
+  }
+}
+
+template<class Word>
+void encodeWords(const std::vector<Word>& words, ResultColumnCodec codec, std::vector<Word>& transformed,
+                 std::vector<unsigned char>& shuffled)
+{
+  const size_t count = words.size();
+  const int bits = 8 * sizeof(Word);
+  transformed.resize(count);
+  Word previous = 0;
+  if (codec == COLUMN_XOR) {
+    for (size_t i = 0; i < count; i++) {
+      transformed[i] = words[i] ^ previous;
+      previous = words[i];
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      Word delta = words[i] - previous;
+      // Zigzag, so that small negative differences have small codes too.
+      transformed[i] = (Word) (delta << 1) ^ (Word) (0 - (delta >> (bits - 1)));
+      previous = words[i];
+    }
+  }
+  shuffled.resize(count * sizeof(Word));
+  for (size_t byte = 0; byte < sizeof(Word); byte++) {
+    unsigned char* plane = &shuffled[byte * count];
+    for (size_t i = 0; i < count; i++) {
+      plane[i] = (unsigned char) (transformed[i] >> (8 * byte));
+    }
+  }
+}
+
+template<class Word>
+void decodeWords(const unsigned char* shuffled, size_t count, ResultColumnCodec codec, Word* words)
+{
+  std::fill(words, words + count, Word(0));
+  for (size_t byte = 0; byte < sizeof(Word); byte++) {
+    const unsigned char* plane = shuffled + byte * count;
+    for (size_t i = 0; i < count; i++) {
+      words[i] |= (Word) plane[i] << (8 * byte);
+    }
+  }
+  Word previous = 0;
+  if (codec == COLUMN_XOR) {
+    for (size_t i = 0; i < count; i++) {
+      previous = words[i] ^= previous;
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      Word delta = (words[i] >> 1) ^ (Word) (0 - (words[i] & 1));
+      previous = words[i] = previous + delta;
+    }
+  }
+}
+
+template<class Word>
+uint8_t encodeColumn(const double* values, size_t count, bool compress, std::string& out)
+{
+  std::vector<Word> words(count);
+  toWords(values, count, words.data());
+  out.resize(count * sizeof(Word));
+  if (LITTLE_ENDIAN_HOST) {
+    std::memcpy(&out[0], words.data(), out.size());
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      for (size_t byte = 0; byte < sizeof(Word); byte++) {
+        out[i * sizeof(Word) + byte] = (char) (words[i] >> (8 * byte));
+      }
+    }
+  }
+  uint8_t codec = COLUMN_RAW;
+  if (compress) {
+    std::vector<Word> transformed;
+    std::vector<unsigned char> shuffled;
+    std::string packed;
+    for (ResultColumnCodec candidate : { COLUMN_XOR, COLUMN_DELTA }) {
+      encodeWords(words, candidate, transformed, shuffled);
+      packed.clear();
+      packZeros(shuffled.data(), shuffled.size(), packed);
+      if (packed.size() < out.size()) {
+        out.swap(packed);
+        codec = candidate;
+      }
+    }
+  }
+  return codec;
+}
+
+template<class Word>
+void decodeColumn(const char* data, size_t size, ResultColumnCodec codec, size_t count, double* values)
+{
+  std::vector<Word> words(count);
+  if (codec == COLUMN_RAW && LITTLE_ENDIAN_HOST) {
+    std::memcpy(words.data(), data, count * sizeof(Word));
+  } else if (codec == COLUMN_RAW) {
+    for (size_t i = 0; i < count; i++) {
+      Word word = 0;
+      for (size_t byte = 0; byte < sizeof(Word); byte++) {
+        word |= (Word) (unsigned char) data[i * sizeof(Word) + byte] << (8 * byte);
+      }
+      words[i] = word;
+    }
+  } else {
+    std::vector<unsigned char> shuffled(count * sizeof(Word));
+    unpackZeros((const unsigned char*) data, size, shuffled.data(), shuffled.size());
+    decodeWords(shuffled.data(), count, codec, words.data());
+  }
+  fromWords(words.data(), count, values);
+}
+
+std::string csvField(const std::string& text)
+{
+  if (text.find_first_of(",\"\n") == std::string::npos) {
+    return text;
+  }
+  std::string quoted = "\"";
+  for (char c : text) {
+    quoted += c;
+    if (c == '"') {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+}
+
+ResultFileOptions::ResultFileOptions() : valueType(RESULT_FLOAT64), compress(true)
+{
+}
+
+ResultFileWriter::ResultFileWriter(const std::string& path, size_t periods, const ResultFileOptions& options)
+  : m_path(path), m_periods(periods), m_options(options), m_offset(0), m_closed(false)
+{
+  if (periods == 0) {
+    throw std::invalid_argument("A result file needs at least one period.");
+  }
+  m_out.open(path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!m_out) {
+    throw std::invalid_argument("Cannot write " + path + ".");
+  }
+  BinaryWriter header;
+  header.u32(options.valueType == RESULT_FLOAT32 ? 4 : 8);
+  header.u64(periods);
+  header.u32(END_USE_COUNT);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    header.text(endUseName(endUse));
+  }
+  header.u32((uint32_t) options.metadata.size());
+  for (const auto& setting : options.metadata) {
+    header.text(setting.first);
+    header.text(setting.second);
+  }
+  BinaryWriter preamble;
+  preamble.bytes(FILE_MAGIC, sizeof(FILE_MAGIC));
+  preamble.u32(FILE_VERSION);
+  preamble.u32((uint32_t) header.data().size());
+  write(preamble.data().data(), preamble.data().size());
+  write(header.data().data(), header.data().size());
+}
+
+ResultFileWriter::~ResultFileWriter()
+{
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void ResultFileWriter::write(const char* data, size_t size)
+{
+  m_out.write(data, size);
+  m_offset += size;
+  if (!m_out) {
+    throw std::invalid_argument("Cannot write " + m_path + ".");
+  }
+}
+
+size_t ResultFileWriter::append(const ResultFileBuilding& building, const std::vector<EndUses>& results)
+{
+  if (results.size() != m_periods) {
+    throw std::invalid_argument("Building " + building.id + " has " + std::to_string(results.size()) + " periods of results, expected " +
+                                std::to_string(m_periods) + ".");
+  }
+  std::vector<double> values(m_periods);
+  std::vector<std::string> encoded(END_USE_COUNT);
+  std::vector<uint8_t> codecs(END_USE_COUNT);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    for (size_t period = 0; period < m_periods; period++) {
+      values[period] = endUseValue(results[period], endUse);
+    }
+    codecs[endUse] = m_options.valueType == RESULT_FLOAT32 ? encodeColumn<uint32_t>(values.data(), m_periods, m_options.compress, encoded[endUse])
+                                                           : encodeColumn<uint64_t>(values.data(), m_periods, m_options.compress, encoded[endUse]);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_closed) {
+    throw std::invalid_argument("Cannot append to the closed result file " + m_path + ".");
+  }
+  static const char padding[8] = { 0 };
+  std::vector<Chunk> chunks(END_USE_COUNT);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    // Aligned, so that raw columns can be used in place in a mapping of the file.
+    write(padding, (8 - m_offset % 8) % 8);
+    chunks[endUse].offset = m_offset;
+    chunks[endUse].size = encoded[endUse].size();
+    chunks[endUse].codec = codecs[endUse];
+    write(encoded[endUse].data(), encoded[endUse].size());
+  }
+  m_buildings.push_back(building);
+  m_chunks.push_back(chunks);
+  return m_buildings.size() - 1;
+}
+
+void ResultFileWriter::close()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_closed) {
+    return;
+  }
+  m_closed = true;
+  BinaryWriter directory;
+  directory.u64(m_buildings.size());
+  for (size_t i = 0; i < m_buildings.size(); i++) {
+    directory.text(m_buildings[i].id);
+    directory.u32((uint32_t) m_buildings[i].metadata.size());
+    for (const auto& setting : m_buildings[i].metadata) {
+      directory.text(setting.first);
+      directory.text(setting.second);
+    }
+    for (const auto& chunk : m_chunks[i]) {
+      directory.u64(chunk.offset);
+      directory.u64(chunk.size);
+      directory.u8(chunk.codec);
+    }
+  }
+  directory.u64(m_offset);
+  directory.bytes(FILE_MAGIC, sizeof(FILE_MAGIC));
+  write(directory.data().data(), directory.data().size());
+  m_out.close();
+  if (!m_out) {
+    throw std::invalid_argument("Cannot write " + m_path + ".");
+  }
+}
+
+struct ResultFileReader::Mapping
+{
+  const char* data;
+  size_t size;
+#ifdef _WIN32
+  // Read into memory instead.
+  std::string contents;
+
+  explicit Mapping(const std::string& path) : contents(BinaryReader::load(path, "result"))
+  {
+    data = contents.data();
+    size = contents.size();
+  }
+#else
+  explicit Mapping(const std::string& path) : data(nullptr), size(0)
+  {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      throw std::invalid_argument("Cannot open result file " + path + ".");
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+      ::close(file);
+      throw std::invalid_argument("Cannot open result file " + path + ".");
+    }
+    size = (size_t) status.st_size;
+    if (size > 0) {
+      void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+      if (address == MAP_FAILED) {
+        ::close(file);
+        throw std::invalid_argument("Cannot map result file " + path + ".");
+      }
+      data = (const char*) address;
+    }
+    // The mapping stays valid without the descriptor.
+    ::close(file);
+  }
+
+  ~Mapping()
+  {
+    if (data) {
+      munmap((void*) data, size);
+    }
+  }
+#endif
+};
+
+ResultFileReader::ResultFileReader(const std::string& path) : m_path(path), m_mapping(new Mapping(path))
+{
+  const char* data = m_mapping->data;
+  size_t size = m_mapping->size;
+  if (size < PREAMBLE_SIZE + TRAILER_SIZE || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    throw std::invalid_argument(path + " is not a result file.");
+  }
+  if (readU32(data + 8) != FILE_VERSION) {
+    throw std::invalid_argument("Result file " + path + " has unsupported version " + std::to_string(readU32(data + 8)) + ".");
+  }
+  if (std::memcmp(data + size - sizeof(FILE_MAGIC), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    throw std::invalid_argument("Result file " + path + " is truncated or was not closed.");
+  }
+  size_t headerSize = readU32(data + 12);
+  uint64_t directoryOffset = readU64(data + size - TRAILER_SIZE);
+  size_t dataStart = PREAMBLE_SIZE + headerSize;
+  if (headerSize > size - PREAMBLE_SIZE - TRAILER_SIZE || directoryOffset < dataStart || directoryOffset > size - TRAILER_SIZE) {
+    throw std::invalid_argument("Result file " + path + " is damaged.");
+  }
+
+  std::string header(data + PREAMBLE_SIZE, headerSize);
+  BinaryReader in(header, "Result file " + path);
+  uint32_t valueBytes = in.u32();
+  if (valueBytes != 4 && valueBytes != 8) {
+    throw std::invalid_argument("Result file " + path + " has values of " + std::to_string(valueBytes) + " bytes.");
+  }
+  m_valueType = valueBytes == 4 ? RESULT_FLOAT32 : RESULT_FLOAT64;
+  m_periods = (size_t) in.u64();
+  uint32_t columns = in.u32();
+  if (columns != END_USE_COUNT) {
+    throw std::invalid_argument("Result file " + path + " has " + std::to_string(columns) + " columns, expected " +
+                                std::to_string(END_USE_COUNT) + ".");
+  }
+  for (uint32_t column = 0; column < columns; column++) {
+    m_columns.push_back(in.text());
+  }
+  for (uint32_t settings = in.u32(); settings > 0; settings--) {
+    std::string key = in.text();
+    m_metadata[key] = in.text();
+  }
+
+  std::string directory(data + directoryOffset, size - TRAILER_SIZE - directoryOffset);
+  BinaryReader entries(directory, "Result file " + path);
+  uint64_t buildings = entries.u64();
+  // Every entry takes at least its id length, metadata count and chunks.
+  if (buildings > directory.size() / (8 + columns * 17)) {
+    throw std::invalid_argument("Result file " + path + " is damaged.");
+  }
+  m_buildings.resize((size_t) buildings);
+  m_chunks.reserve((size_t) buildings * columns);
+  for (auto& building : m_buildings) {
+    building.id = entries.text();
+    for (uint32_t settings = entries.u32(); settings > 0; settings--) {
+      std::string key = entries.text();
+      building.metadata[key] = entries.text();
+    }
+    for (uint32_t column = 0; column < columns; column++) {
+      uint64_t offset = entries.u64();
+      uint64_t chunkSize = entries.u64();
+      uint8_t codec = entries.u8();
+      if (offset < dataStart || offset > directoryOffset || chunkSize > directoryOffset - offset || codec > COLUMN_DELTA ||
+          (codec == COLUMN_RAW && chunkSize != m_periods * valueBytes)) {
+        throw std::invalid_argument("Result file " + path + " is damaged (building " + building.id + ").");
+      }
+      Chunk chunk = { data + offset, chunkSize, (ResultColumnCodec) codec };
+      m_chunks.push_back(chunk);
+    }
+  }
+}
+
+ResultFileReader::~ResultFileReader()
+{
+}
+
+size_t ResultFileReader::find(const std::string& id) const
+{
+  for (size_t i = 0; i < m_buildings.size(); i++) {
+    if (m_buildings[i].id == id) {
+      return i;
+    }
+  }
+  return m_buildings.size();
+}
+
+const ResultFileReader::Chunk& ResultFileReader::chunk(size_t building, size_t column) const
+{
+  if (building >= m_buildings.size() || column >= m_columns.size()) {
+    throw std::invalid_argument("Result file " + m_path + " has no column " + std::to_string(column) + " of building " +
+                                std::to_string(building) + ".");
+  }
+  return m_chunks[building * m_columns.size() + column];
+}
+
+ResultColumnCodec ResultFileReader::codec(size_t building, size_t column) const
+{
+  return chunk(building, column).codec;
+}
+
+void ResultFileReader::column(size_t building, size_t column, double* values) const
+{
+  const Chunk& chunk = this->chunk(building, column);
+  try {
+    if (m_valueType == RESULT_FLOAT32) {
+      decodeColumn<uint32_t>(chunk.data, (size_t) chunk.size, chunk.codec, m_periods, values);
+    } else {
+      decodeColumn<uint64_t>(chunk.data, (size_t) chunk.size, chunk.codec, m_periods, values);
+    }
+  } catch (const std::invalid_argument& e) {
+    throw std::invalid_argument("Result file " + m_path + " is damaged (" + e.what() + " in building " + m_buildings[building].id + ").");
+  }
+}
+
+std::vector<EndUses> ResultFileReader::results(size_t building) const
+{
+  std::vector<EndUses> results(m_periods);
+  std::vector<double> values(m_periods);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    column(building, endUse, values.data());
+    for (size_t period = 0; period < m_periods; period++) {
+      setEndUseValue(results[period], endUse, values[period]);
+    }
+  }
+  return results;
+}
+
+const double* ResultFileReader::mappedDoubles(size_t building, size_t column) const
+{
+  const Chunk& chunk = this->chunk(building, column);
+  if (chunk.codec != COLUMN_RAW || m_valueType != RESULT_FLOAT64 || !LITTLE_ENDIAN_HOST) {
+    return nullptr;
+  }
+  return reinterpret_cast<const double*>(chunk.data);
+}
+
+const float* ResultFileReader::mappedFloats(size_t building, size_t column) const
+{
+  const Chunk& chunk = this->chunk(building, column);
+  if (chunk.codec != COLUMN_RAW || m_valueType != RESULT_FLOAT32 || !LITTLE_ENDIAN_HOST) {
+    return nullptr;
+  }
+  return reinterpret_cast<const float*>(chunk.data);
+}
+
+void ResultFileReader::writeCsv(CsvWriter& out) const
+{
+  std::set<std::string> keys;
+  for (const auto& building : m_buildings) {
+    for (const auto& setting : building.metadata) {
+      keys.insert(setting.first);
+    }
+  }
+  out.field(std::string("id"));
+  for (const auto& key : keys) {
+    out.field(csvField(key));
+  }
+  out.field(std::string("period"));
+  for (const auto& column : m_columns) {
+    out.field(csvField(column));
+  }
+  out.endRow();
+
+  std::vector<double> values(m_columns.size() * m_periods);
+  for (size_t building = 0; building < m_buildings.size(); building++) {
+    for (size_t column = 0; column < m_columns.size(); column++) {
+      this->column(building, column, &values[column * m_periods]);
+    }
+    // The fields before the period are the same on every row.
+    std::string prefix = csvField(m_buildings[building].id);
+    for (const auto& key : keys) {
+      auto setting = m_buildings[building].metadata.find(key);
+      prefix += out.separator() + (setting == m_buildings[building].metadata.end() ? std::string() : csvField(setting->second));
+    }
+    for (size_t period = 0; period < m_periods; period++) {
+      out.field(prefix);
+      out.field((int) period + 1);
+      for (size_t column = 0; column < m_columns.size(); column++) {
+        out.field(values[column * m_periods + period]);
+      }
+      out.endRow();
+    }
+  }
+}
+
+}
+}
@@ -0,0 +1,252 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_RESULT_FILE_HPP
+#define ISOMODEL_RESULT_FILE_HPP
+
+#include "ISOModelAPI.hpp"
+
+#ifdef ISOMODEL_STANDALONE
+#include "EndUses.hpp"
+#else
+#include "../utilities/data/EndUses.hpp"
+#endif
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class CsvWriter;
+
+/**
+ * How the values of a result file are stored. FLOAT32 halves the size before compression
+ * and keeps about seven significant digits.
+ */
+enum ResultValueType
+{
+  RESULT_FLOAT32,
+  RESULT_FLOAT64
+};
+
+/**
+ * Encoding of one column of one building. The compressed encodings transform the bit
+ * patterns of the values, XOR with the previous value or the zigzag encoded difference
+ * from it, store the bytes of every value grouped by significance (byte shuffling) and
+ * replace runs of zero bytes by their length. Both are lossless.
+ */
+enum ResultColumnCodec
+{
+  COLUMN_RAW,
+  COLUMN_XOR,
+  COLUMN_DELTA
+};
+
+struct ISOMODEL_API ResultFileOptions
+{
+  ResultValueType valueType; // RESULT_FLOAT64 by default.
+  // Stores each column with the smaller of the compressed encodings, or raw where neither
+  // is smaller (the default). Without compression every column is raw and can be read
+  // in place.
+  bool compress;
+  // Settings of the whole file, such as the batch fingerprint.
+  std::map<std::string, std::string> metadata;
+
+  ResultFileOptions();
+};
+
+/**
+ * A building of a result file: its identifier and attributes such as its floor area.
+ */
+struct ISOMODEL_API ResultFileBuilding
+{
+  std::string id;
+  std::map<std::string, std::string> metadata;
+};
+
+/**
+ * Writes the results of many buildings, a column per end use with one value per period
+ * (hour or month), to a binary columnar result file.
+ *
+ * The file starts with a header naming the columns, the number of periods, the value type
+ * and the file metadata. The columns of each building follow as they are appended, each
+ * at an 8 byte aligned offset, and close writes the directory of the buildings, with
+ * their metadata and the offset, size and encoding of each of their columns, and a
+ * trailer pointing at it. All numbers are little endian.
+ *
+ * append may be called from several threads at once: the columns are encoded on the
+ * calling thread and only the write to the file is serialized, so buildings are stored
+ * in the order their appends complete.
+ */
+class ISOMODEL_API ResultFileWriter
+{
+public:
+  /**
+   * Creates the file at path for results of periods periods. Throws
+   * std::invalid_argument if it cannot be written.
+   */
+  ResultFileWriter(const std::string& path, size_t periods, const ResultFileOptions& options = ResultFileOptions());
+
+  /**
+   * Closes the file if close was not called, ignoring errors.
+   */
+  ~ResultFileWriter();
+
+  size_t periods() const {
+    return m_periods;
+  }
+
+  /**
+   * Adds a building and returns its index in the file. Throws std::invalid_argument if
+   * results does not hold one EndUses per period, the file is closed or the write fails.
+   */
+  size_t append(const ResultFileBuilding& building, const std::vector<EndUses>& results);
+
+  /**
+   * Writes the directory and the trailer. A file that was not closed cannot be read.
+   * Throws std::invalid_argument if the write fails.
+   */
+  void close();
+
+private:
+  struct Chunk
+  {
+    uint64_t offset;
+    uint64_t size;
+    uint8_t codec;
+  };
+
+  ResultFileWriter(const ResultFileWriter&);
+  ResultFileWriter& operator=(const ResultFileWriter&);
+
+  void write(const char* data, size_t size);
+
+  std::string m_path;
+  size_t m_periods;
+  ResultFileOptions m_options;
+  std::mutex m_mutex;
+  std::ofstream m_out;
+  uint64_t m_offset;
+  std::vector<ResultFileBuilding> m_buildings;
+  std::vector<std::vector<Chunk> > m_chunks;
+  bool m_closed;
+};
+
+/**
+ * Reads a result file written by ResultFileWriter. The file is memory mapped, so opening
+ * it only reads the header and the directory, and raw columns are read in place, without
+ * a copy. Every method is const and may be called from several threads at once.
+ */
+class ISOMODEL_API ResultFileReader
+{
+public:
+  /**
+   * Throws std::invalid_argument if the file cannot be read, is not a result file, was
+   * not closed or is damaged.
+   */
+  explicit ResultFileReader(const std::string& path);
+  ~ResultFileReader();
+
+  size_t periods() const {
+    return m_periods;
+  }
+
+  ResultValueType valueType() const {
+    return m_valueType;
+  }
+
+  const std::vector<std::string>& columns() const {
+    return m_columns;
+  }
+
+  const std::map<std::string, std::string>& metadata() const {
+    return m_metadata;
+  }
+
+  size_t size() const {
+    return m_buildings.size();
+  }
+
+  const ResultFileBuilding& building(size_t index) const {
+    return m_buildings[index];
+  }
+
+  /**
+   * The index of the first building with id, or size() if there is none.
+   */
+  size_t find(const std::string& id) const;
+
+  ResultColumnCodec codec(size_t building, size_t column) const;
+
+  /**
+   * Decodes the periods() values of a column of a building into values.
+   */
+  void column(size_t building, size_t column, double* values) const;
+
+  /**
+   * The results of a building, one EndUses per period.
+   */
+  std::vector<EndUses> results(size_t building) const;
+
+  /**
+   * The values of a raw column in the mapped file, or nullptr if the column is compressed,
+   * of the other value type, or the host is big endian.
+   */
+  const double* mappedDoubles(size_t building, size_t column) const;
+  const float* mappedFloats(size_t building, size_t column) const;
+
+  /**
+   * Writes every building as CSV rows: a header row, then a row per building and period
+   * with the id, the building metadata (a column per key of any building), the period
+   * from 1 and the values.
+   */
+  void writeCsv(CsvWriter& out) const;
+
+private:
+  struct Mapping;
+  struct Chunk
+  {
+    const char* data;
+    uint64_t size;
+    ResultColumnCodec codec;
+  };
+
+  ResultFileReader(const ResultFileReader&);
+  ResultFileReader& operator=(const ResultFileReader&);
+
+  const Chunk& chunk(size_t building, size_t column) const;
+
+  std::string m_path;
+  std::unique_ptr<Mapping> m_mapping;
+  size_t m_periods;
+  ResultValueType m_valueType;
+  std::vector<std::string> m_columns;
+  std::map<std::string, std::string> m_metadata;
+  std::vector<ResultFileBuilding> m_buildings;
+  std::vector<Chunk> m_chunks;
+};
+
+}
+}
+#endif
@@ -0,0 +1,422 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Sampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// Closest points to 0 and 1 passed to the quantile functions of unbounded distributions.
+const double MIN_PROBABILITY = 1e-15;
+
+// Primitive polynomials and initial direction numbers of the Sobol dimensions after
+// the first, from Joe and Kuo's new-joe-kuo-6.21201: degree s, coefficients a and the
+// s values m_1 ... m_s.
+struct SobolInitialization
+{
+  int degree;
+  uint32_t coefficients;
+  uint32_t m[7];
+};
+
+const SobolInitialization joeKuo[] = {
+  { 1, 0, { 1 } },
+  { 2, 1, { 1, 3 } },
+  { 3, 1, { 1, 3, 1 } },
+  { 3, 2, { 1, 1, 1 } },
+  { 4, 1, { 1, 1, 3, 3 } },
+  { 4, 4, { 1, 3, 5, 13 } },
+  { 5, 2, { 1, 1, 5, 5, 17 } },
+  { 5, 4, { 1, 1, 5, 5, 5 } },
+  { 5, 7, { 1, 1, 7, 11, 19 } },
+  { 5, 11, { 1, 1, 5, 1, 1 } },
+  { 5, 13, { 1, 1, 1, 3, 11 } },
+  { 5, 14, { 1, 3, 5, 5, 31 } },
+  { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+  { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+  { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+  { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+  { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+  { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+  { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+  { 7, 4, { 1, 3, 7, 13, 13, 15, 69 } }
+};
+
+// Product of two polynomials over GF(2) (bit i is the coefficient of x^i) modulo the
+// polynomial modulus of the given degree.
+uint64_t multiplyModulo(uint64_t x, uint64_t y, uint64_t modulus, int degree)
+{
+  uint64_t product = 0;
+  while (y != 0) {
+    if (y & 1) {
+      product ^= x;
+    }
+    y >>= 1;
+    x <<= 1;
+    if (x & (uint64_t(1) << degree)) {
+      x ^= modulus;
+    }
+  }
+  return product;
+}
+
+uint64_t powerModulo(uint64_t x, uint64_t exponent, uint64_t modulus, int degree)
+{
+  uint64_t result = 1;
+  while (exponent != 0) {
+    if (exponent & 1) {
+      result = multiplyModulo(result, x, modulus, degree);
+    }
+    x = multiplyModulo(x, x, modulus, degree);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// True if the polynomial of the given degree is primitive, i.e. x has order 2^degree - 1.
+bool isPrimitive(uint64_t polynomial, int degree)
+{
+  uint64_t order = (uint64_t(1) << degree) - 1;
+  if (powerModulo(2, order, polynomial, degree) != 1) {
+    return false;
+  }
+  uint64_t rest = order;
+  for (uint64_t factor = 2; factor * factor <= rest; factor++) {
+    if (rest % factor == 0) {
+      if (powerModulo(2, order / factor, polynomial, degree) == 1) {
+        return false;
+      }
+      while (rest % factor == 0) {
+        rest /= factor;
+      }
+    }
+  }
+  // What is left is 1 or a prime factor.
+  return rest == 1 || powerModulo(2, order / rest, polynomial, degree) != 1;
+}
+
+// The primitive polynomials after those of joeKuo, in order of degree and coefficients.
+std::vector<SobolInitialization> morePolynomials(size_t count)
+{
+  std::vector<SobolInitialization> result;
+  const auto& last = joeKuo[sizeof(joeKuo) / sizeof(joeKuo[0]) - 1];
+  int degree = last.degree;
+  uint32_t coefficients = last.coefficients + 1;
+  std::mt19937 random(21201);
+  while (result.size() < count) {
+    if (coefficients >= (uint32_t(1) << (degree - 1))) {
+      degree++;
+      coefficients = 0;
+      if (degree >= 32) {
+        throw std::invalid_argument("Too many Sobol dimensions.");
+      }
+    }
+    uint64_t polynomial = (uint64_t(1) << degree) | (uint64_t(coefficients) << 1) | 1;
+    if (isPrimitive(polynomial, degree)) {
+      SobolInitialization init;
+      init.degree = degree;
+      init.coefficients = coefficients;
+      // Random odd m_i < 2^i; only the first 7 are kept in the table, the rest are
+      // generated the same way when the direction numbers are computed.
+      for (int i = 0; i < 7; i++) {
+        init.m[i] = (random() % (uint32_t(1) << (i + 1))) | 1;
+      }
+      result.push_back(init);
+    }
+    coefficients++;
+  }
+  return result;
+}
+
+}
+
+Distribution Distribution::uniform(double low, double high)
+{
+  if (!(low <= high)) {
+    throw std::invalid_argument("A uniform distribution needs low <= high.");
+  }
+  Distribution d = { UNIFORM, low, high, 0.0 };
+  return d;
+}
+
+Distribution Distribution::normal(double mean, double standardDeviation)
+{
+  if (!(standardDeviation >= 0)) {
+    throw std::invalid_argument("A normal distribution needs a non-negative standard deviation.");
+  }
+  Distribution d = { NORMAL, mean, standardDeviation, 0.0 };
+  return d;
+}
+
+Distribution Distribution::lognormal(double logMean, double logStandardDeviation)
+{
+  if (!(logStandardDeviation >= 0)) {
+    throw std::invalid_argument("A lognormal distribution needs a non-negative standard deviation.");
+  }
+  Distribution d = { LOGNORMAL, logMean, logStandardDeviation, 0.0 };
+  return d;
+}
+
+Distribution Distribution::triangular(double low, double mode, double high)
+{
+  if (!(low <= mode && mode <= high)) {
+    throw std::invalid_argument("A triangular distribution needs low <= mode <= high.");
+  }
+  Distribution d = { TRIANGULAR, low, mode, high };
+  return d;
+}
+
+Distribution Distribution::parse(const std::string& name, const std::vector<double>& parameters)
+{
+  auto expect = [&](size_t count) {
+    if (parameters.size() != count) {
+      throw std::invalid_argument("A " + name + " distribution takes " + std::to_string(count) + " parameters.");
+    }
+  };
+  if (name == "uniform") {
+    expect(2);
+    return uniform(parameters[0], parameters[1]);
+  } else if (name == "normal") {
+    expect(2);
+    return normal(parameters[0], parameters[1]);
+  } else if (name == "lognormal") {
+    expect(2);
+    return lognormal(parameters[0], parameters[1]);
+  } else if (name == "triangular") {
+    expect(3);
+    return triangular(parameters[0], parameters[1], parameters[2]);
+  }
+  throw std::invalid_argument("Unknown distribution \"" + name + "\".");
+}
+
+double Distribution::quantile(double u) const
+{
+  switch (type) {
+  case UNIFORM:
+    u = std::min(std::max(u, 0.0), 1.0);
+    return a + u * (b - a);
+  case NORMAL:
+    return a + b * inverseNormal(std::min(std::max(u, MIN_PROBABILITY), 1.0 - MIN_PROBABILITY));
+  case LOGNORMAL:
+    return std::exp(a + b * inverseNormal(std::min(std::max(u, MIN_PROBABILITY), 1.0 - MIN_PROBABILITY)));
+  case TRIANGULAR:
+  default:
+    u = std::min(std::max(u, 0.0), 1.0);
+    if (c == a) {
+      return a;
+    }
+    if (u < (b - a) / (c - a)) {
+      return a + std::sqrt(u * (c - a) * (b - a));
+    }
+    return c - std::sqrt((1 - u) * (c - a) * (c - b));
+  }
+}
+
+double Distribution::cdf(double x) const
+{
+  switch (type) {
+  case UNIFORM:
+    if (b == a) {
+      return x < a ? 0 : 1;
+    }
+    return std::min(std::max((x - a) / (b - a), 0.0), 1.0);
+  case NORMAL:
+    return 0.5 * std::erfc(-(x - a) / (b * std::sqrt(2.0)));
+  case LOGNORMAL:
+    if (x <= 0) {
+      return 0;
+    }
+    return 0.5 * std::erfc(-(std::log(x) - a) / (b * std::sqrt(2.0)));
+  case TRIANGULAR:
+  default:
+    if (x <= a) {
+      return 0;
+    }
+    if (x >= c) {
+      return 1;
+    }
+    if (x <= b) {
+      return (x - a) * (x - a) / ((c - a) * (b - a));
+    }
+    return 1 - (c - x) * (c - x) / ((c - a) * (c - b));
+  }
+}
+
+double Distribution::gridPoint(int level, int levels) const
+{
+  if (type == NORMAL || type == LOGNORMAL) {
+    return (level + 0.5) / levels;
+  }
+  return levels > 1 ? (double) level / (levels - 1) : 0.5;
+}
+
+double inverseNormal(double p)
+{
+  // Acklam's rational approximation followed by one step of Halley's method, which
+  // gives full double precision.
+  static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02,
+                              -3.066479806614716e+01, 2.506628277459239e+00 };
+  static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01,
+                              -1.328068155288572e+01 };
+  static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00,
+                              4.374664141464968e+00, 2.938163982698783e+00 };
+  static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+  const double low = 0.02425;
+
+  if (p <= 0) {
+    return -HUGE_VAL;
+  }
+  if (p >= 1) {
+    return HUGE_VAL;
+  }
+  double x;
+  if (p < low) {
+    double q = std::sqrt(-2 * std::log(p));
+    x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+  } else if (p <= 1 - low) {
+    double q = p - 0.5;
+    double r = q * q;
+    x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+        / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+  } else {
+    double q = std::sqrt(-2 * std::log(1 - p));
+    x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+  }
+  double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+  double u = e * std::sqrt(2 * M_PI) * std::exp(x * x / 2);
+  return x - u / (1 + x * u / 2);
+}
+
+std::vector<std::vector<int> > gridDesign(const std::vector<int>& levels)
+{
+  size_t count = 1;
+  for (int n : levels) {
+    if (n < 1) {
+      throw std::invalid_argument("Every grid dimension needs at least one level.");
+    }
+    count *= n;
+  }
+  std::vector<std::vector<int> > design(count, std::vector<int>(levels.size()));
+  for (size_t i = 0; i < count; i++) {
+    size_t rest = i;
+    for (size_t d = levels.size(); d-- > 0;) {
+      design[i][d] = (int) (rest % levels[d]);
+      rest /= levels[d];
+    }
+  }
+  return design;
+}
+
+std::vector<std::vector<double> > latinHypercube(size_t samples, size_t dimensions, uint64_t seed)
+{
+  std::mt19937_64 random(seed);
+  std::uniform_real_distribution<double> jitter(0.0, 1.0);
+  std::vector<std::vector<double> > design(samples, std::vector<double>(dimensions));
+  std::vector<size_t> strata(samples);
+  for (size_t d = 0; d < dimensions; d++) {
+    for (size_t i = 0; i < samples; i++) {
+      strata[i] = i;
+    }
+    std::shuffle(strata.begin(), strata.end(), random);
+    for (size_t i = 0; i < samples; i++) {
+      design[i][d] = (strata[i] + jitter(random)) / samples;
+    }
+  }
+  return design;
+}
+
+SobolSequence::SobolSequence(size_t dimensions) : m_dimensions(dimensions), m_index(0), m_directions(dimensions * BITS), m_state(dimensions)
+{
+  // The first dimension is the van der Corput sequence.
+  if (dimensions > 0) {
+    for (int i = 0; i < BITS; i++) {
+      m_directions[i] = uint32_t(1) << (BITS - 1 - i);
+    }
+  }
+  const size_t tabulated = sizeof(joeKuo) / sizeof(joeKuo[0]);
+  std::vector<SobolInitialization> inits(joeKuo, joeKuo + std::min(tabulated, dimensions > 0 ? dimensions - 1 : 0));
+  if (dimensions > tabulated + 1) {
+    auto more = morePolynomials(dimensions - tabulated - 1);
+    inits.insert(inits.end(), more.begin(), more.end());
+  }
+
+  std::mt19937 random(6);
+  for (size_t j = 1; j < dimensions; j++) {
+    const SobolInitialization& init = inits[j - 1];
+    uint32_t* v = &m_directions[j * BITS];
+    int s = init.degree;
+    for (int i = 0; i < s && i < BITS; i++) {
+      uint32_t m = i < 7 ? init.m[i] : ((random() % (uint32_t(1) << (i + 1))) | 1);
+      v[i] = m << (BITS - 1 - i);
+    }
+    for (int i = s; i < BITS; i++) {
+      v[i] = v[i - s] ^ (v[i - s] >> s);
+      for (int k = 1; k < s; k++) {
+        if ((init.coefficients >> (s - 1 - k)) & 1) {
+          v[i] ^= v[i - k];
+        }
+      }
+    }
+  }
+}
+
+void SobolSequence::next(double* point)
+{
+  const double scale = 1.0 / 4294967296.0;
+  for (size_t j = 0; j < m_dimensions; j++) {
+    point[j] = (m_state[j] + 0.5) * scale;
+  }
+  // Gray code order: the next point flips the direction number of the lowest zero bit
+  // of the index.
+  int bit = 0;
+  for (uint64_t n = m_index; n & 1; n >>= 1) {
+    bit++;
+  }
+  if (bit >= BITS) {
+    throw std::invalid_argument("The Sobol sequence is exhausted.");
+  }
+  for (size_t j = 0; j < m_dimensions; j++) {
+    m_state[j] ^= m_directions[j * BITS + bit];
+  }
+  m_index++;
+}
+
+void SobolSequence::discard(uint64_t count)
+{
+  m_index += count;
+  uint64_t gray = m_index ^ (m_index >> 1);
+  for (size_t j = 0; j < m_dimensions; j++) {
+    uint32_t x = 0;
+    for (int bit = 0; bit < BITS; bit++) {
+      if ((gray >> bit) & 1) {
+        x ^= m_directions[j * BITS + bit];
+      }
+    }
+    m_state[j] = x;
+  }
+}
+
+}
+}
@@ -0,0 +1,144 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SAMPLING_HPP
+#define ISOMODEL_SAMPLING_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A probability distribution of a model input, sampled by mapping points of the unit
+ * interval through its quantile function.
+ */
+struct ISOMODEL_API Distribution
+{
+  enum Type
+  {
+    UNIFORM, // Between a and b.
+    NORMAL, // Mean a and standard deviation b.
+    LOGNORMAL, // Log of the value has mean a and standard deviation b.
+    TRIANGULAR // Between a and c with mode b.
+  };
+
+  Type type;
+  double a;
+  double b;
+  double c;
+
+  static Distribution uniform(double low, double high);
+  static Distribution normal(double mean, double standardDeviation);
+  static Distribution lognormal(double logMean, double logStandardDeviation);
+  static Distribution triangular(double low, double mode, double high);
+
+  /**
+   * Parses a distribution from its name ("uniform", "normal", "lognormal" or
+   * "triangular") and parameters, in the order of the factory functions. Throws
+   * std::invalid_argument if the name is unknown or the parameters are invalid.
+   */
+  static Distribution parse(const std::string& name, const std::vector<double>& parameters);
+
+  /**
+   * The value below which a fraction u of the distribution lies. u is clamped to the
+   * open unit interval, so unbounded distributions always give finite values.
+   */
+  double quantile(double u) const;
+
+  /**
+   * The fraction of the distribution below x: the inverse of quantile.
+   */
+  double cdf(double x) const;
+
+  /**
+   * The point of the unit interval of level (from 0) of a grid of levels values.
+   * Bounded distributions are gridded from end to end, unbounded ones at the midpoints
+   * of levels equally likely intervals.
+   */
+  double gridPoint(int level, int levels) const;
+};
+
+/**
+ * The inverse of the standard normal cumulative distribution function.
+ */
+ISOMODEL_API double inverseNormal(double p);
+
+/**
+ * A full factorial design: every combination of levels[d] levels of each dimension d,
+ * as level indices, with the last dimension varying fastest.
+ */
+ISOMODEL_API std::vector<std::vector<int> > gridDesign(const std::vector<int>& levels);
+
+/**
+ * A Latin hypercube design of samples points in the unit hypercube of dimensions
+ * dimensions: each dimension is split into samples equally likely strata and every
+ * stratum holds exactly one point. The same seed gives the same design.
+ */
+ISOMODEL_API std::vector<std::vector<double> > latinHypercube(size_t samples, size_t dimensions, uint64_t seed);
+
+/**
+ * The Sobol low discrepancy sequence (Gray code order). The first 21 dimensions use the
+ * primitive polynomials and initial direction numbers of Joe and Kuo; higher dimensions
+ * use the following primitive polynomials with seeded random initial direction
+ * numbers. Points are offset by half of the 2^-32 resolution so that no coordinate is
+ * exactly 0, which keeps every point inside the same dyadic intervals.
+ */
+class ISOMODEL_API SobolSequence
+{
+public:
+  explicit SobolSequence(size_t dimensions);
+
+  size_t dimensions() const {
+    return m_dimensions;
+  }
+
+  /**
+   * Index of the next point.
+   */
+  uint64_t index() const {
+    return m_index;
+  }
+
+  /**
+   * Writes the next point (dimensions() values) to point.
+   */
+  void next(double* point);
+
+  /**
+   * Skips count points.
+   */
+  void discard(uint64_t count);
+
+private:
+  static const int BITS = 32;
+
+  size_t m_dimensions;
+  uint64_t m_index;
+  // BITS direction numbers per dimension.
+  std::vector<uint32_t> m_directions;
+  std::vector<uint32_t> m_state;
+};
+
+}
+}
+#endif
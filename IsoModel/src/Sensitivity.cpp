@@ -0,0 +1,317 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Sensitivity.hpp"
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// Sets the bounds of estimate to the bootstrap percentile interval of estimates (which
+// is sorted in place).
+void percentileInterval(std::vector<double>& estimates, double confidence, SensitivityEstimate& estimate)
+{
+  if (estimates.empty()) {
+    estimate.low = estimate.value;
+    estimate.high = estimate.value;
+    return;
+  }
+  std::sort(estimates.begin(), estimates.end());
+  double last = (double) (estimates.size() - 1);
+  estimate.low = estimates[(size_t) std::floor((1 - confidence) / 2 * last + 0.5)];
+  estimate.high = estimates[(size_t) std::floor((1 + confidence) / 2 * last + 0.5)];
+}
+
+}
+
+Sensitivity::Sensitivity(SweepSpec::SensitivityMethod method, const std::vector<Distribution>& distributions, size_t samples,
+                         int levels, uint64_t seed)
+  : m_method(method), m_dimensions(distributions.size()), m_samples(samples), m_outputCount(0)
+{
+  if (m_dimensions == 0) {
+    throw std::invalid_argument("A sensitivity analysis needs at least one parameter.");
+  }
+  if (samples < 2) {
+    throw std::invalid_argument("A sensitivity analysis needs at least two samples.");
+  }
+
+  if (method == SweepSpec::MORRIS) {
+    if (levels < 2) {
+      throw std::invalid_argument("A Morris design needs at least two levels.");
+    }
+    int jump = levels / 2;
+    std::mt19937_64 random(seed);
+    std::vector<int> level(m_dimensions);
+    std::vector<size_t> order(m_dimensions);
+    m_inputs.reserve(samples * (m_dimensions + 1) * m_dimensions);
+    for (size_t t = 0; t < samples; t++) {
+      for (size_t i = 0; i < m_dimensions; i++) {
+        level[i] = (int) (random() % levels);
+        order[i] = i;
+      }
+      for (size_t i = m_dimensions - 1; i > 0; i--) {
+        std::swap(order[i], order[random() % (i + 1)]);
+      }
+      for (size_t s = 0; s <= m_dimensions; s++) {
+        if (s > 0) {
+          size_t i = order[s - 1];
+          int next = level[i] + jump < levels ? level[i] + jump : level[i] - jump;
+          Step step = { i, distributions[i].gridPoint(next, levels) - distributions[i].gridPoint(level[i], levels) };
+          m_steps.push_back(step);
+          level[i] = next;
+        }
+        for (size_t i = 0; i < m_dimensions; i++) {
+          m_inputs.push_back(distributions[i].quantile(distributions[i].gridPoint(level[i], levels)));
+        }
+      }
+    }
+  } else {
+    // The first Sobol point is a corner of the unit cube, which is skipped.
+    SobolSequence sobol(2 * m_dimensions);
+    sobol.discard(1);
+    std::vector<double> point(2 * m_dimensions);
+    std::vector<double> a(m_dimensions);
+    std::vector<double> b(m_dimensions);
+    m_inputs.reserve(samples * (m_dimensions + 2) * m_dimensions);
+    for (size_t j = 0; j < samples; j++) {
+      sobol.next(point.data());
+      for (size_t i = 0; i < m_dimensions; i++) {
+        a[i] = distributions[i].quantile(point[i]);
+        b[i] = distributions[i].quantile(point[m_dimensions + i]);
+      }
+      m_inputs.insert(m_inputs.end(), a.begin(), a.end());
+      m_inputs.insert(m_inputs.end(), b.begin(), b.end());
+      for (size_t i = 0; i < m_dimensions; i++) {
+        size_t row = m_inputs.size();
+        m_inputs.insert(m_inputs.end(), a.begin(), a.end());
+        m_inputs[row + i] = b[i];
+      }
+    }
+  }
+}
+
+void Sensitivity::evaluate(ThreadPool& pool, size_t outputCount, const std::function<void(size_t, const double*, double*)>& model)
+{
+  m_outputCount = outputCount;
+  m_outputs.assign(size() * outputCount, 0.0);
+  pool.parallelFor(size(), [&](size_t run) { model(run, inputs(run), m_outputs.data() + run * m_outputCount); }, 8);
+}
+
+void Sensitivity::morrisMeasures(size_t output, const std::vector<size_t>& selection, double* mu, double* muStar,
+                                 double* sigma) const
+{
+  std::vector<RunningStats> effects(m_dimensions);
+  std::vector<double> absoluteSums(m_dimensions, 0.0);
+  for (size_t t : selection) {
+    size_t run = t * (m_dimensions + 1);
+    for (size_t s = 0; s < m_dimensions; s++) {
+      const Step& step = m_steps[t * m_dimensions + s];
+      double effect = (this->output(run + s + 1, output) - this->output(run + s, output)) / step.delta;
+      effects[step.parameter].add(effect);
+      absoluteSums[step.parameter] += std::abs(effect);
+    }
+  }
+  for (size_t i = 0; i < m_dimensions; i++) {
+    mu[i] = effects[i].mean();
+    muStar[i] = absoluteSums[i] / selection.size();
+    if (sigma != nullptr) {
+      sigma[i] = effects[i].standardDeviation();
+    }
+  }
+}
+
+void Sensitivity::sobolMeasures(size_t output, const std::vector<size_t>& selection, double* first, double* total) const
+{
+  size_t stride = m_dimensions + 2;
+  RunningStats outputs;
+  for (size_t j : selection) {
+    outputs.add(this->output(j * stride, output));
+    outputs.add(this->output(j * stride + 1, output));
+  }
+  double variance = outputs.variance();
+
+  for (size_t i = 0; i < m_dimensions; i++) {
+    double firstSum = 0;
+    double totalSum = 0;
+    for (size_t j : selection) {
+      double a = this->output(j * stride, output);
+      double b = this->output(j * stride + 1, output);
+      double ab = this->output(j * stride + 2 + i, output);
+      firstSum += b * (ab - a);
+      totalSum += (a - ab) * (a - ab);
+    }
+    first[i] = variance > 0 ? firstSum / selection.size() / variance : 0;
+    total[i] = variance > 0 ? totalSum / (2 * selection.size()) / variance : 0;
+  }
+}
+
+void Sensitivity::analyze(ThreadPool& pool, size_t bootstrap, double confidence, uint64_t seed)
+{
+  if (m_outputCount == 0 || m_outputs.size() != size() * m_outputCount) {
+    throw std::invalid_argument("The sensitivity design has not been evaluated.");
+  }
+
+  // The resamples are drawn up front, so that all of the outputs use the same ones and
+  // the results do not depend on the number of threads.
+  std::vector<size_t> all(m_samples);
+  for (size_t j = 0; j < m_samples; j++) {
+    all[j] = j;
+  }
+  std::vector<std::vector<size_t> > resamples(bootstrap, std::vector<size_t>(m_samples));
+  std::mt19937_64 random(seed);
+  for (auto& resample : resamples) {
+    for (auto& j : resample) {
+      j = (size_t) (random() % m_samples);
+    }
+  }
+
+  bool morris = m_method == SweepSpec::MORRIS;
+  m_variances.assign(m_outputCount, 0.0);
+  m_morris.assign(morris ? m_outputCount * m_dimensions : 0, MorrisEffects());
+  m_sobol.assign(morris ? 0 : m_outputCount * m_dimensions, SobolIndices());
+  pool.parallelFor(m_outputCount, [&](size_t output) {
+    RunningStats outputs;
+    for (size_t run = 0; run < size(); run++) {
+      outputs.add(this->output(run, output));
+    }
+    m_variances[output] = outputs.variance();
+
+    // Point estimates of the two measures of every parameter, and their bootstrap estimates.
+    std::vector<double> first(m_dimensions);
+    std::vector<double> second(m_dimensions);
+    std::vector<double> sigma(m_dimensions);
+    std::vector<double> resampledFirst(m_dimensions);
+    std::vector<double> resampledSecond(m_dimensions);
+    std::vector<std::vector<double> > firstEstimates(m_dimensions);
+    std::vector<std::vector<double> > secondEstimates(m_dimensions);
+    if (morris) {
+      morrisMeasures(output, all, first.data(), second.data(), sigma.data());
+    } else {
+      sobolMeasures(output, all, first.data(), second.data());
+    }
+    for (const auto& resample : resamples) {
+      if (morris) {
+        morrisMeasures(output, resample, resampledFirst.data(), resampledSecond.data(), nullptr);
+      } else {
+        sobolMeasures(output, resample, resampledFirst.data(), resampledSecond.data());
+      }
+      for (size_t i = 0; i < m_dimensions; i++) {
+        firstEstimates[i].push_back(resampledFirst[i]);
+        secondEstimates[i].push_back(resampledSecond[i]);
+      }
+    }
+
+    for (size_t i = 0; i < m_dimensions; i++) {
+      SensitivityEstimate firstEstimate = { first[i], first[i], first[i] };
+      SensitivityEstimate secondEstimate = { second[i], second[i], second[i] };
+      percentileInterval(firstEstimates[i], confidence, firstEstimate);
+      percentileInterval(secondEstimates[i], confidence, secondEstimate);
+      if (morris) {
+        MorrisEffects& effects = m_morris[output * m_dimensions + i];
+        effects.mu = firstEstimate;
+        effects.muStar = secondEstimate;
+        effects.sigma = sigma[i];
+      } else {
+        SobolIndices& indices = m_sobol[output * m_dimensions + i];
+        indices.first = firstEstimate;
+        indices.total = secondEstimate;
+      }
+    }
+  });
+}
+
+namespace {
+
+std::vector<Distribution> distributions(const SweepSpec& spec)
+{
+  std::vector<Distribution> result;
+  for (const auto& parameter : spec.parameters) {
+    result.push_back(parameter.distribution);
+  }
+  return result;
+}
+
+std::vector<std::string> parameterNames(const SweepSpec& spec)
+{
+  std::vector<std::string> result;
+  for (const auto& parameter : spec.parameters) {
+    result.push_back(parameter.name);
+  }
+  return result;
+}
+
+}
+
+SensitivityStudy::SensitivityStudy(const UserModel& base, const SweepSpec& spec)
+  : m_base(base), m_engine(spec.engine), m_bootstrap(spec.bootstrap), m_confidence(spec.confidence), m_seed(spec.seed),
+    m_binding(parameterNames(spec)), m_sensitivity(spec.method, distributions(spec), spec.samples, spec.levels, spec.seed)
+{
+}
+
+void SensitivityStudy::run(ThreadPool& pool)
+{
+  m_sensitivity.evaluate(pool, END_USE_COUNT, [&](size_t, const double* inputs, double* outputs) {
+    auto results = simulateByMonth(m_binding.bind(m_base, inputs), m_engine);
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      for (const auto& month : results) {
+        outputs[endUse] += endUseValue(month, endUse);
+      }
+    }
+  });
+  m_sensitivity.analyze(pool, m_bootstrap, m_confidence, m_seed);
+}
+
+void SensitivityStudy::writeCsv(std::ostream& out) const
+{
+  bool morris = m_sensitivity.method() == SweepSpec::MORRIS;
+  if (morris) {
+    out << "EndUse,Parameter,Mu,MuLow,MuHigh,MuStar,MuStarLow,MuStarHigh,Sigma\n";
+  } else {
+    out << "EndUse,Parameter,S1,S1Low,S1High,ST,STLow,STHigh\n";
+  }
+  out << std::setprecision(10);
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    if (!(m_sensitivity.outputVariance(endUse) > 0)) {
+      continue;
+    }
+    for (size_t i = 0; i < m_sensitivity.dimensions(); i++) {
+      out << endUseName(endUse) << "," << m_binding.names()[i];
+      if (morris) {
+        const MorrisEffects& effects = m_sensitivity.morris(endUse, i);
+        out << "," << effects.mu.value << "," << effects.mu.low << "," << effects.mu.high << "," << effects.muStar.value << ","
+            << effects.muStar.low << "," << effects.muStar.high << "," << effects.sigma << "\n";
+      } else {
+        const SobolIndices& indices = m_sensitivity.sobol(endUse, i);
+        out << "," << indices.first.value << "," << indices.first.low << "," << indices.first.high << "," << indices.total.value
+            << "," << indices.total.low << "," << indices.total.high << "\n";
+      }
+    }
+  }
+}
+
+}
+}
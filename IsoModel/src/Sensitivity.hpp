@@ -0,0 +1,209 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SENSITIVITY_HPP
+#define ISOMODEL_SENSITIVITY_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Sampling.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A sensitivity measure and the bounds of its bootstrap confidence interval.
+ */
+struct ISOMODEL_API SensitivityEstimate
+{
+  double value;
+  double low;
+  double high;
+};
+
+/**
+ * Morris elementary effect statistics of one parameter on one output: the mean effect,
+ * the mean absolute effect and the standard deviation of the effects. Effects are
+ * output changes per unit change of the parameter's quantile.
+ */
+struct ISOMODEL_API MorrisEffects
+{
+  SensitivityEstimate mu;
+  SensitivityEstimate muStar;
+  double sigma;
+};
+
+/**
+ * First and total order Sobol indices of one parameter on one output.
+ */
+struct ISOMODEL_API SobolIndices
+{
+  SensitivityEstimate first;
+  SensitivityEstimate total;
+};
+
+/**
+ * A global sensitivity design over the quantiles of independent parameters and the
+ * analysis of its outputs.
+ *
+ * Morris designs are samples random one-at-a-time trajectories of dimensions + 1 points
+ * over a grid of levels quantiles; each step moves one parameter by levels / 2 grid
+ * levels. Saltelli designs take two matrices A and B of samples rows from a Sobol
+ * sequence and, for every parameter i, the matrix A with column i taken from B, for
+ * samples * (dimensions + 2) runs. First order indices use the estimator of Saltelli et
+ * al. (2010) and total indices that of Jansen (1999).
+ *
+ * Confidence intervals are bootstrap percentile intervals over resampled trajectories
+ * or base samples.
+ */
+class ISOMODEL_API Sensitivity
+{
+public:
+  Sensitivity(SweepSpec::SensitivityMethod method, const std::vector<Distribution>& distributions, size_t samples,
+              int levels = 4, uint64_t seed = 1);
+
+  SweepSpec::SensitivityMethod method() const {
+    return m_method;
+  }
+
+  size_t dimensions() const {
+    return m_dimensions;
+  }
+
+  /**
+   * Number of runs of the design.
+   */
+  size_t size() const {
+    return m_inputs.size() / m_dimensions;
+  }
+
+  /**
+   * The dimensions() parameter values of a run.
+   */
+  const double* inputs(size_t run) const {
+    return m_inputs.data() + run * m_dimensions;
+  }
+
+  /**
+   * Calls model(run, inputs, outputs) for every run on pool. model writes outputCount
+   * values to outputs.
+   */
+  void evaluate(ThreadPool& pool, size_t outputCount, const std::function<void(size_t, const double*, double*)>& model);
+
+  /**
+   * Computes the measures of every parameter on every output from the evaluated outputs,
+   * with confidence intervals from bootstrap resamples (none if bootstrap is 0).
+   */
+  void analyze(ThreadPool& pool, size_t bootstrap = 100, double confidence = 0.95, uint64_t seed = 1);
+
+  size_t outputCount() const {
+    return m_outputCount;
+  }
+
+  /**
+   * Variance of an output over all runs.
+   */
+  double outputVariance(size_t output) const {
+    return m_variances[output];
+  }
+
+  const MorrisEffects& morris(size_t output, size_t parameter) const {
+    return m_morris[output * m_dimensions + parameter];
+  }
+
+  const SobolIndices& sobol(size_t output, size_t parameter) const {
+    return m_sobol[output * m_dimensions + parameter];
+  }
+
+private:
+  struct Step
+  {
+    size_t parameter;
+    double delta; // Signed change of the parameter's quantile.
+  };
+
+  // Measures of output from the trajectories or base samples in selection.
+  void morrisMeasures(size_t output, const std::vector<size_t>& selection, double* mu, double* muStar, double* sigma) const;
+  void sobolMeasures(size_t output, const std::vector<size_t>& selection, double* first, double* total) const;
+
+  double output(size_t run, size_t output) const {
+    return m_outputs[run * m_outputCount + output];
+  }
+
+  SweepSpec::SensitivityMethod m_method;
+  size_t m_dimensions;
+  size_t m_samples;
+  std::vector<double> m_inputs;
+  std::vector<Step> m_steps;
+  size_t m_outputCount;
+  std::vector<double> m_outputs;
+  std::vector<double> m_variances;
+  std::vector<MorrisEffects> m_morris;
+  std::vector<SobolIndices> m_sobol;
+};
+
+/**
+ * Sensitivity of the annual end uses of a model to the parameters of a SweepSpec.
+ */
+class ISOMODEL_API SensitivityStudy
+{
+public:
+  SensitivityStudy(const UserModel& base, const SweepSpec& spec);
+
+  const Sensitivity& sensitivity() const {
+    return m_sensitivity;
+  }
+
+  const ParameterBinding& binding() const {
+    return m_binding;
+  }
+
+  /**
+   * Simulates the design on pool and analyzes the annual end uses.
+   */
+  void run(ThreadPool& pool);
+
+  /**
+   * Writes one CSV row per end use and parameter: mu, mu* (with their confidence
+   * intervals) and sigma of Morris designs, or the first and total order indices (with
+   * their confidence intervals) of Saltelli designs. End uses that do not vary are
+   * left out.
+   */
+  void writeCsv(std::ostream& out) const;
+
+private:
+  UserModel m_base;
+  SimulationEngine m_engine;
+  size_t m_bootstrap;
+  double m_confidence;
+  uint64_t m_seed;
+  ParameterBinding m_binding;
+  Sensitivity m_sensitivity;
+};
+
+}
+}
+#endif
@@ -2,6 +2,7 @@
 #define ISOMODEL_SIMULATION_HPP
 
 #include "ISOModelAPI.hpp"
+#include "CopyOnWrite.hpp"
 
 #include "Population.hpp"
 #include "Location.hpp"
@@ -14,6 +15,7 @@
 #include "EpwData.hpp"
 #include "PhysicalQuantities.hpp"
 #include "SimulationSettings.hpp"
+#include "ResultCache.hpp"
 
 namespace openstudio {
 namespace isomodel {
@@ -24,35 +26,35 @@ public:
   virtual ~Simulation() {}
 
   // Setters for the pointers to the classes that store the .ism parameters.
-  void setPop(Population value) {
+  void setPop(const CopyOnWrite<Population>& value) {
     pop = value;
   }
 
-  void setLocation(Location value) {
+  void setLocation(const CopyOnWrite<Location>& value) {
     location = value;
   }
 
-  void setLights(Lighting value) {
+  void setLights(const CopyOnWrite<Lighting>& value) {
     lights = value;
   }
 
-  void setBuilding(Building value) {
+  void setBuilding(const CopyOnWrite<Building>& value) {
     building = value;
   }
 
-  void setStructure(Structure value) {
+  void setStructure(const CopyOnWrite<Structure>& value) {
     structure = value;
   }
 
-  void setHeating(Heating value) {
+  void setHeating(const CopyOnWrite<Heating>& value) {
     heating = value;
   }
 
-  void setCooling(Cooling value) {
+  void setCooling(const CopyOnWrite<Cooling>& value) {
     cooling = value;
   }
 
-  void setVentilation(Ventilation value) {
+  void setVentilation(const CopyOnWrite<Ventilation>& value) {
     ventilation = value;
   }
   
@@ -60,27 +62,46 @@ public:
     epwData = value;
   }
 
-  void setPhysicalQuantities(PhysicalQuantities value) {
+  void setPhysicalQuantities(const CopyOnWrite<PhysicalQuantities>& value) {
     phys = value;
   }
 
-  void setSimulationSettings(SimulationSettings value) {
+  void setSimulationSettings(const CopyOnWrite<SimulationSettings>& value) {
     simSettings = value;
   }
 
+  /**
+   * Results of simulate() are looked up in and added to cache, if it is not null.
+   */
+  void setResultCache(const std::shared_ptr<ResultCache>& value) {
+    cache = value;
+  }
+
+  std::shared_ptr<ResultCache> resultCache() const {
+    return cache;
+  }
+
+  /**
+   * The key of the results of kind of this simulation in a ResultCache: a hash of every
+   * component, the weather and the kind. Implemented in ResultCache.cpp.
+   */
+  ContentHash resultKey(ResultKind kind) const;
+
 protected:
-  // Pointers to classes that store the .ism parameters.
-  Population pop;
-  Location location;
-  Lighting lights;
-  Building building;
-  Structure structure;
-  Heating heating;
-  Cooling cooling;
-  Ventilation ventilation;
+  // Pointers to classes that store the .ism parameters. These are shared with the
+  // UserModel the simulation was created from, so creating a simulation copies no values.
+  CopyOnWrite<Population> pop;
+  CopyOnWrite<Location> location;
+  CopyOnWrite<Lighting> lights;
+  CopyOnWrite<Building> building;
+  CopyOnWrite<Structure> structure;
+  CopyOnWrite<Heating> heating;
+  CopyOnWrite<Cooling> cooling;
+  CopyOnWrite<Ventilation> ventilation;
   std::shared_ptr<EpwData> epwData;
-  PhysicalQuantities phys;
-  SimulationSettings simSettings;
+  CopyOnWrite<PhysicalQuantities> phys;
+  CopyOnWrite<SimulationSettings> simSettings;
+  std::shared_ptr<ResultCache> cache;
 };
 } // isomodel
 } // openstudio
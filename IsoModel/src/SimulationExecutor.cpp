@@ -0,0 +1,250 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "SimulationExecutor.hpp"
+#include "SimulationPlan.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const int PRIORITY_COUNT = BACKGROUND_PRIORITY + 1;
+
+}
+
+struct SimulationJob::State
+{
+  std::function<std::vector<EndUses>()> work;
+  SimulationJobOptions options;
+  CancellationToken token;
+  std::promise<std::vector<EndUses> > promise;
+  std::shared_future<std::vector<EndUses> > future;
+  std::atomic<int> status;
+
+  State() : future(promise.get_future().share()), status(JOB_QUEUED)
+  {
+  }
+};
+
+struct SimulationExecutor::Queue
+{
+  typedef std::shared_ptr<SimulationJob::State> Job;
+
+  mutable std::mutex mutex;
+  std::condition_variable idle;
+  std::deque<Job> jobs[PRIORITY_COUNT];
+  // Unfinished jobs, and those with a key by key.
+  std::set<Job> unfinished;
+  std::map<std::string, Job> keyed;
+  // Runner tasks posted and not yet done.
+  size_t runners;
+
+  Queue() : runners(0)
+  {
+  }
+
+  // Runs the most urgent queued job, if there is one.
+  void runNext()
+  {
+    Job job;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (int priority = 0; priority < PRIORITY_COUNT && !job; priority++) {
+        if (!jobs[priority].empty()) {
+          job = jobs[priority].front();
+          jobs[priority].pop_front();
+        }
+      }
+    }
+    if (job) {
+      run(*job);
+      std::lock_guard<std::mutex> lock(mutex);
+      unfinished.erase(job);
+      auto keyedJob = keyed.find(job->options.key);
+      if (keyedJob != keyed.end() && keyedJob->second == job) {
+        keyed.erase(keyedJob);
+      }
+    }
+    if (job && job->options.callback) {
+      try {
+        job->options.callback(SimulationJob(job));
+      } catch (...) {
+        // A callback has nowhere to report to; it must not take the worker down.
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--runners == 0) {
+      idle.notify_all();
+    }
+  }
+
+  static void run(SimulationJob::State& job)
+  {
+    if (job.token.cancelled()) {
+      job.status = JOB_CANCELLED;
+      job.promise.set_exception(std::make_exception_ptr(SimulationCancelled()));
+      return;
+    }
+    job.status = JOB_RUNNING;
+    try {
+      CancellationScope scope(job.token);
+      std::vector<EndUses> results = job.work();
+      job.status = JOB_DONE;
+      job.promise.set_value(results);
+    } catch (SimulationCancelled&) {
+      job.status = JOB_CANCELLED;
+      job.promise.set_exception(std::current_exception());
+    } catch (...) {
+      job.status = JOB_FAILED;
+      job.promise.set_exception(std::current_exception());
+    }
+  }
+};
+
+std::shared_future<std::vector<EndUses> > SimulationJob::future() const
+{
+  return m_state->future;
+}
+
+std::vector<EndUses> SimulationJob::get() const
+{
+  return m_state->future.get();
+}
+
+SimulationJobStatus SimulationJob::status() const
+{
+  return (SimulationJobStatus) m_state->status.load();
+}
+
+void SimulationJob::cancel() const
+{
+  m_state->token.cancel();
+}
+
+SimulationPriority SimulationJob::priority() const
+{
+  return m_state->options.priority;
+}
+
+CancellationToken SimulationJob::token() const
+{
+  return m_state->token;
+}
+
+SimulationExecutor::SimulationExecutor(unsigned threadCount) : m_ownedPool(new ThreadPool(threadCount)), m_queue(std::make_shared<Queue>())
+{
+  ThreadPool* pool = m_ownedPool.get();
+  m_backend = [pool](std::function<void()> task) { pool->post(std::move(task)); };
+}
+
+SimulationExecutor::SimulationExecutor(ThreadPool& pool) : m_queue(std::make_shared<Queue>())
+{
+  ThreadPool* shared = &pool;
+  m_backend = [shared](std::function<void()> task) { shared->post(std::move(task)); };
+}
+
+SimulationExecutor::SimulationExecutor(const Backend& backend) : m_backend(backend), m_queue(std::make_shared<Queue>())
+{
+}
+
+SimulationExecutor::~SimulationExecutor()
+{
+  wait();
+}
+
+SimulationJob SimulationExecutor::submit(const std::function<std::vector<EndUses>()>& work, const SimulationJobOptions& options)
+{
+  std::shared_ptr<SimulationJob::State> job = std::make_shared<SimulationJob::State>();
+  job->work = work;
+  job->options = options;
+  int priority = std::min(std::max((int) options.priority, 0), PRIORITY_COUNT - 1);
+  {
+    std::lock_guard<std::mutex> lock(m_queue->mutex);
+    if (!options.key.empty()) {
+      auto superseded = m_queue->keyed.find(options.key);
+      if (superseded != m_queue->keyed.end()) {
+        superseded->second->token.cancel();
+      }
+      m_queue->keyed[options.key] = job;
+    }
+    m_queue->jobs[priority].push_back(job);
+    m_queue->unfinished.insert(job);
+    m_queue->runners++;
+  }
+  std::shared_ptr<Queue> queue = m_queue;
+  m_backend([queue]() { queue->runNext(); });
+  return SimulationJob(job);
+}
+
+SimulationJob SimulationExecutor::submit(const std::shared_ptr<const SimulationPlan>& plan, SimulationEngine engine,
+                                         const SimulationJobOptions& options, bool aggregateByMonth)
+{
+  return submit(
+      [plan, engine, aggregateByMonth]() {
+        return engine == HOURLY_ENGINE ? plan->simulateHourly(aggregateByMonth) : plan->simulateMonthly();
+      },
+      options);
+}
+
+SimulationJob SimulationExecutor::submit(const UserModel& model, SimulationEngine engine, const SimulationJobOptions& options,
+                                         bool aggregateByMonth)
+{
+  return submit(
+      [model, engine, aggregateByMonth]() {
+        std::shared_ptr<const SimulationPlan> plan = model.compile();
+        checkCancellation();
+        return engine == HOURLY_ENGINE ? plan->simulateHourly(aggregateByMonth) : plan->simulateMonthly();
+      },
+      options);
+}
+
+void SimulationExecutor::cancelAll()
+{
+  std::lock_guard<std::mutex> lock(m_queue->mutex);
+  for (const auto& job : m_queue->unfinished) {
+    job->token.cancel();
+  }
+}
+
+void SimulationExecutor::wait()
+{
+  std::unique_lock<std::mutex> lock(m_queue->mutex);
+  m_queue->idle.wait(lock, [this]() { return m_queue->runners == 0; });
+}
+
+size_t SimulationExecutor::queued() const
+{
+  std::lock_guard<std::mutex> lock(m_queue->mutex);
+  size_t count = 0;
+  for (const auto& jobs : m_queue->jobs) {
+    count += jobs.size();
+  }
+  return count;
+}
+
+}
+}
@@ -0,0 +1,204 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SIMULATION_EXECUTOR_HPP
+#define ISOMODEL_SIMULATION_EXECUTOR_HPP
+
+#include "Cancellation.hpp"
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class SimulationPlan;
+
+/**
+ * Priority classes of SimulationExecutor jobs, most urgent first.
+ */
+enum SimulationPriority
+{
+  INTERACTIVE_PRIORITY,
+  NORMAL_PRIORITY,
+  BACKGROUND_PRIORITY
+};
+
+enum SimulationJobStatus
+{
+  JOB_QUEUED,
+  JOB_RUNNING,
+  JOB_DONE,
+  JOB_FAILED,
+  JOB_CANCELLED
+};
+
+class SimulationJob;
+
+/**
+ * Options of a submitted job. Submitting a job with the key of an unfinished job
+ * cancels that job, so that a new what-if run supersedes the one it replaces. callback,
+ * if given, is called on the worker once the job has finished, failed or been cancelled.
+ */
+struct ISOMODEL_API SimulationJobOptions
+{
+  SimulationPriority priority;
+  std::string key;
+  std::function<void(const SimulationJob&)> callback;
+
+  SimulationJobOptions(SimulationPriority priority = NORMAL_PRIORITY) : priority(priority)
+  {
+  }
+};
+
+/**
+ * A handle to a job submitted to a SimulationExecutor. Copies refer to the same job.
+ */
+class ISOMODEL_API SimulationJob
+{
+public:
+  /**
+   * The job's results. get() rethrows the job's exception, SimulationCancelled if the
+   * job was cancelled.
+   */
+  std::shared_future<std::vector<EndUses> > future() const;
+
+  /**
+   * Waits for the job and returns its results, as future().get().
+   */
+  std::vector<EndUses> get() const;
+
+  SimulationJobStatus status() const;
+
+  /**
+   * Cancels the job: a queued job is dropped and a running one stops at its next
+   * cancellation check (see CancellationScope).
+   */
+  void cancel() const;
+
+  SimulationPriority priority() const;
+
+  /**
+   * The job's cancellation token, for work that checks it itself.
+   */
+  CancellationToken token() const;
+
+private:
+  friend class SimulationExecutor;
+  struct State;
+
+  explicit SimulationJob(const std::shared_ptr<State>& state) : m_state(state)
+  {
+  }
+
+  std::shared_ptr<State> m_state;
+};
+
+/**
+ * Runs simulations asynchronously without blocking the submitting thread. Jobs wait in
+ * one queue per priority class and each worker that becomes free takes the oldest job of
+ * the most urgent class. Jobs can be cancelled while queued or running.
+ *
+ * The workers come from a backend: an executor-owned ThreadPool, an application's
+ * ThreadPool, or any function that runs a task on some thread. The executor posts one
+ * task per submitted job; a task runs whichever job is then most urgent, so priorities
+ * hold however the backend orders its tasks.
+ */
+class ISOMODEL_API SimulationExecutor
+{
+public:
+  typedef std::function<void(std::function<void()>)> Backend;
+
+  /**
+   * Runs the jobs on an owned pool of threadCount threads (0 for one per hardware thread).
+   */
+  explicit SimulationExecutor(unsigned threadCount = 0);
+
+  /**
+   * Runs the jobs on pool, which must outlive the executor.
+   */
+  explicit SimulationExecutor(ThreadPool& pool);
+
+  /**
+   * Runs the jobs on the threads backend hands its tasks to. Every task posted must
+   * eventually be run.
+   */
+  explicit SimulationExecutor(const Backend& backend);
+
+  /**
+   * Waits for the jobs submitted.
+   */
+  ~SimulationExecutor();
+
+  /**
+   * Submits work, which returns the results of a simulation and may call
+   * checkCancellation() to stop early. Work runs with the job's token as the thread's
+   * cancellation token.
+   */
+  SimulationJob submit(const std::function<std::vector<EndUses>()>& work,
+                       const SimulationJobOptions& options = SimulationJobOptions());
+
+  /**
+   * Submits a simulation of a compiled plan: the monthly method, or the hourly method by
+   * month or (with aggregateByMonth false) by hour.
+   */
+  SimulationJob submit(const std::shared_ptr<const SimulationPlan>& plan, SimulationEngine engine,
+                       const SimulationJobOptions& options = SimulationJobOptions(), bool aggregateByMonth = true);
+
+  /**
+   * Submits a simulation of model, which is compiled on the worker.
+   */
+  SimulationJob submit(const UserModel& model, SimulationEngine engine, const SimulationJobOptions& options = SimulationJobOptions(),
+                       bool aggregateByMonth = true);
+
+  /**
+   * Cancels every unfinished job.
+   */
+  void cancelAll();
+
+  /**
+   * Waits until every job submitted so far has finished.
+   */
+  void wait();
+
+  /**
+   * Number of jobs queued and not yet started.
+   */
+  size_t queued() const;
+
+private:
+  SimulationExecutor(const SimulationExecutor&);
+  SimulationExecutor& operator=(const SimulationExecutor&);
+
+  struct Queue;
+
+  std::unique_ptr<ThreadPool> m_ownedPool;
+  Backend m_backend;
+  std::shared_ptr<Queue> m_queue;
+};
+
+}
+}
+#endif
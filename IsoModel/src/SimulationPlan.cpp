@@ -0,0 +1,89 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "SimulationPlan.hpp"
+
+#include "EpwData.hpp"
+#include "HourlyModel.hpp"
+#include "SolarRadiation.hpp"
+#include "TimeFrame.hpp"
+
+namespace openstudio {
+namespace isomodel {
+
+std::shared_ptr<const HourlyWeather> HourlyWeather::compute(EpwData& epw)
+{
+  auto weather = std::make_shared<HourlyWeather>();
+  epw.column(WSPD, weather->wind);
+  epw.column(DBT, weather->temperature);
+  std::vector<double> egh;
+  epw.column(EGH, egh);
+
+  TimeFrame frame;
+  SolarRadiation pos(&frame, &epw);
+  pos.Calculate();
+
+  // Radiation for 8 directions (N, NE, E, etc.) plus the roof radiation (9th direction).
+  // EGH is global horizontal radiation.
+  weather->radiation.resize(TIMESLICES * SURFACES);
+  weather->month.resize(TIMESLICES);
+  weather->dayOfWeek.resize(TIMESLICES);
+  weather->hourOfDay.resize(TIMESLICES);
+  for (auto i = 0; i != TIMESLICES; ++i) {
+    double* radiation = &weather->radiation[i * SURFACES];
+    for (auto s = 0; s != NUM_SURFACES; ++s) {
+      radiation[s] = pos.eglobe(i, s);
+    }
+    radiation[NUM_SURFACES] = egh[i];
+    weather->month[i] = frame.Month[i];
+    weather->dayOfWeek[i] = frame.DayOfWeek[i];
+    weather->hourOfDay[i] = frame.Hour[i];
+  }
+  return weather;
+}
+
+SimulationPlan::SimulationPlan(const HourlyPlan& hourly, const MonthlyModel& monthly, std::shared_ptr<EpwData> epwData)
+  : m_hourly(hourly), m_envelope(monthly.envelope()), m_monthly(monthly), m_epwData(epwData)
+{
+}
+
+std::vector<EndUses> SimulationPlan::simulateMonthly() const
+{
+  if (auto cache = m_monthly.resultCache()) {
+    return cache->getOrCompute(m_monthly.resultKey(MONTHLY_RESULTS), [this]() { return m_monthly.simulate(m_envelope); });
+  }
+  return m_monthly.simulate(m_envelope);
+}
+
+std::vector<EndUses> SimulationPlan::simulateHourly(bool aggregateByMonth) const
+{
+  if (auto cache = m_monthly.resultCache()) {
+    // The monthly model holds the same components and weather as the hourly plan.
+    return cache->getOrCompute(m_monthly.resultKey(aggregateByMonth ? HOURLY_BY_MONTH_RESULTS : HOURLY_RESULTS),
+                               [&]() { return HourlyModel::simulate(m_hourly, *m_epwData->hourlyWeather(), aggregateByMonth); });
+  }
+  return HourlyModel::simulate(m_hourly, *m_epwData->hourlyWeather(), aggregateByMonth);
+}
+
+void SimulationPlan::aggregateHourly(HourlyAggregator& aggregator) const
+{
+  HourlyModel::aggregate(m_hourly, *m_epwData->hourlyWeather(), aggregator);
+}
+
+}
+}
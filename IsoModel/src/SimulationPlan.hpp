@@ -0,0 +1,195 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SIMULATION_PLAN_HPP
+#define ISOMODEL_SIMULATION_PLAN_HPP
+
+#include "ISOModelAPI.hpp"
+#include "MonthlyModel.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class EpwData;
+class HourlyAggregator;
+
+/**
+ * The hourly weather inputs of the hourly method, computed once per EpwData and
+ * shared by every simulation using it (see EpwData::hourlyWeather).
+ */
+struct ISOMODEL_API HourlyWeather
+{
+  // Number of radiation values per hour: 8 vertical surfaces (N, NE, E, etc.) plus the roof.
+  static const int SURFACES = 9;
+
+  std::vector<double> wind; // m/s.
+  std::vector<double> temperature; // Dry bulb, C.
+  std::vector<double> radiation; // W/m2, SURFACES values per hour. The roof value is the global horizontal radiation.
+  std::vector<int> month; // 1-12.
+  std::vector<int> dayOfWeek; // 0-6.
+  std::vector<int> hourOfDay; // 0-23.
+
+  /**
+   * Computes the hourly weather from epw, which must hold (or be able to load) hourly data.
+   */
+  static std::shared_ptr<const HourlyWeather> compute(EpwData& epw);
+};
+
+/**
+ * Everything the hourly method needs besides the weather: the constant coefficients
+ * derived from the model's components and the component values used each hour.
+ * Plain data, filled in by HourlyModel::plan().
+ */
+struct ISOMODEL_API HourlyPlan
+{
+  // Schedules by hour of day and day of week.
+  double ventilationSchedule[24][7];
+  double exteriorEquipmentSchedule[24][7];
+  double interiorEquipmentSchedule[24][7];
+  double exteriorLightingSchedule[24][7];
+  double interiorLightingSchedule[24][7];
+  double heatingSetpointSchedule[24][7];
+  double coolingSetpointSchedule[24][7];
+  bool occupied[24][7];
+
+  // Lighting.
+  double maxRatioElectricLighting; // Ratio of electric light used due to lighting controls.
+  double elightNatural; // Target lux level in naturally lit area.
+  double areaNaturallyLightedRatio;
+  double naturalLightRatio[9];
+  double naturalLightShadeRatioReduction[9];
+  double elecInternalGains;
+  double exteriorLightingEnergy;
+
+  // Solar gains and movable shading.
+  double solarRatio[9];
+  double solarShadeRatioReduction[9];
+  double shadingUsePerWPerM2;
+  double irradianceForMaxShadingUse;
+  double phiSolFractionToAirNode;
+  double phiIntFractionToAirNode;
+
+  // Ventilation and infiltration (ISO 15242).
+  double windImpactSupplyRatio;
+  double windImpactHz;
+  double q4Pa;
+  double heatRecoveryEfficiency;
+  double ventPreheatDegC;
+  double dCp;
+  double fanPower;
+
+  // Heat transfer and thermal mass (ISO 13790 C).
+  double floorArea;
+  double H_tris;
+  double hwindowWperkm2;
+  double H_ms;
+  double hem;
+  double Cm;
+  double prsInterior;
+  double prsSolar;
+  double prmInterior;
+  double prmSolar;
+
+  // HVAC.
+  double heatingSupplyTemperature;
+  double coolingSupplyTemperature;
+  bool forcedAirHeating;
+  bool forcedAirCooling;
+  double rhoCpAir;
+  double heatingPumpPower;
+  double coolingPumpPower;
+  double heatingLossFactor;
+  double coolingLossFactor;
+  double hotcoldWasteFactor;
+  double heatingEfficiency;
+  double coolingCop;
+  double heatingEnergyType;
+};
+
+/**
+ * Envelope values of the monthly method (ISO 13790 8.3 and 11.3) by surface, in
+ * .ism component order. Plain data, filled in by MonthlyModel::envelope().
+ */
+struct ISOMODEL_API EnvelopePlan
+{
+  double wallArea[9];
+  double windowArea[9];
+  double wallU[9];
+  double wallEmissivity[9];
+  double wallSolarAbsorption[9];
+  double wallSolarArea[9];
+  double windowSolarArea[9];
+  double windowRadiativeCoefficient[9];
+  double wallExternalResistance[9];
+  double H_tr;
+};
+
+/**
+ * A model compiled for simulation by UserModel::compile(). The plan holds no reference to
+ * the UserModel, so it may be simulated any number of times, from any number of threads
+ * at once. Later changes to the model do not affect it: the components are copied on
+ * write, and UserModel::loadWeather, setWeather and setCompactWeather give the model new
+ * weather objects rather than changing the ones the plan shares. Changing the shared
+ * EpwData itself, e.g. through UserModel::epwData(), does change the results of the plan.
+ */
+class ISOMODEL_API SimulationPlan
+{
+public:
+  SimulationPlan(const HourlyPlan& hourly, const MonthlyModel& monthly, std::shared_ptr<EpwData> epwData);
+
+  const HourlyPlan& hourly() const {
+    return m_hourly;
+  }
+
+  const EnvelopePlan& envelope() const {
+    return m_envelope;
+  }
+
+  /**
+   * Runs the monthly method. Equivalent to UserModel::toMonthlyModel().simulate().
+   */
+  std::vector<EndUses> simulateMonthly() const;
+
+  /**
+   * Runs the hourly method. Equivalent to UserModel::toHourlyModel().simulate(aggregateByMonth).
+   * The hourly weather is computed on first use and shared with other plans using the
+   * same weather.
+   */
+  std::vector<EndUses> simulateHourly(bool aggregateByMonth = false) const;
+
+  /**
+   * Runs the hourly method into aggregator. Equivalent to
+   * UserModel::toHourlyModel().aggregate(aggregator).
+   */
+  void aggregateHourly(HourlyAggregator& aggregator) const;
+
+private:
+  HourlyPlan m_hourly;
+  EnvelopePlan m_envelope;
+  // The monthly method still reads most of its inputs from the components, which the
+  // MonthlyModel shares with the UserModel at the time of compilation.
+  MonthlyModel m_monthly;
+  std::shared_ptr<EpwData> m_epwData;
+};
+
+}
+}
+#endif
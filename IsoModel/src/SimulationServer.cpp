@@ -0,0 +1,666 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "SimulationServer.hpp"
+#include "Cancellation.hpp"
+#include "IsmSchema.hpp"
+#include "ModelParameters.hpp"
+#include "SimulationPlan.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+std::string jsonString(const std::string& text)
+{
+  std::string result = "\"";
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      result += "\\\"";
+      break;
+    case '\\':
+      result += "\\\\";
+      break;
+    case '\n':
+      result += "\\n";
+      break;
+    case '\r':
+      result += "\\r";
+      break;
+    case '\t':
+      result += "\\t";
+      break;
+    default:
+      if ((unsigned char) c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) c);
+        result += escaped;
+      } else {
+        result += c;
+      }
+    }
+  }
+  return result + "\"";
+}
+
+// The id as JSON: numbers as they were, anything else as a string.
+std::string jsonId(const std::string& id)
+{
+  char* end = nullptr;
+  std::strtod(id.c_str(), &end);
+  return !id.empty() && *end == '\0' ? id : jsonString(id);
+}
+
+// A property value: the text of a JSON value or the comma separated values of an array.
+std::string propertyValue(const boost::property_tree::ptree& value)
+{
+  if (value.empty()) {
+    return value.data();
+  }
+  std::string result;
+  for (const auto& element : value) {
+    result += (result.empty() ? "" : ",") + element.second.data();
+  }
+  return result;
+}
+
+Properties toProperties(const boost::property_tree::ptree& object, std::shared_ptr<const Properties> parent = nullptr)
+{
+  Properties properties(parent);
+  for (const auto& property : object) {
+    properties.putProperty(property.first, propertyValue(property.second));
+  }
+  return properties;
+}
+
+// A description of the properties of an object that does not depend on their order or
+// the case of their names.
+std::string describe(const boost::property_tree::ptree& object)
+{
+  std::vector<std::string> properties;
+  for (const auto& property : object) {
+    properties.push_back(boost::to_lower_copy(property.first) + "=" + propertyValue(property.second));
+  }
+  std::sort(properties.begin(), properties.end());
+  return boost::join(properties, ";");
+}
+
+// The absolute path and modification time of a file, which identify its contents.
+std::string describeFile(const std::string& file)
+{
+  if (file.empty()) {
+    return std::string();
+  }
+  if (!boost::filesystem::exists(file)) {
+    throw std::invalid_argument("File not found: " + file);
+  }
+  return boost::filesystem::absolute(file).string() + "@" + std::to_string(boost::filesystem::last_write_time(file));
+}
+
+double milliseconds(std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+struct SimulationServer::Request
+{
+  boost::property_tree::ptree json;
+  std::string id;
+  std::chrono::steady_clock::time_point received;
+  std::function<void(const std::string&)> respond;
+  // Cancelled when the request times out, which stops its simulation.
+  CancellationToken cancellation;
+  // Guards answered, so that a response is complete once answered is seen.
+  std::mutex mutex;
+  std::atomic<bool> answered;
+  bool watched;
+  std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<Request> >::iterator deadline;
+
+  Request() : answered(false), watched(false)
+  {
+  }
+};
+
+SimulationServer::SimulationServer(unsigned threadCount, size_t planCacheSize)
+  : m_pool(threadCount), m_planCacheSize(std::max<size_t>(planCacheSize, 1)), m_stopping(false), m_requests(0), m_errors(0),
+    m_timeouts(0), m_inFlight(0), m_stopWatching(false)
+{
+  m_watchdog = std::thread(&SimulationServer::watch, this);
+}
+
+SimulationServer::~SimulationServer()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    m_stopWatching = true;
+  }
+  m_watchWake.notify_all();
+  m_watchdog.join();
+}
+
+bool SimulationServer::handle(const std::string& line, const std::function<void(const std::string&)>& respond)
+{
+  auto request = std::make_shared<Request>();
+  request->received = std::chrono::steady_clock::now();
+  request->respond = respond;
+  std::string command;
+  try {
+    std::istringstream in(line);
+    boost::property_tree::read_json(in, request->json);
+    request->id = request->json.get<std::string>("id", "");
+    command = request->json.get<std::string>("command", "");
+  } catch (std::exception& e) {
+    finish(*request, "error", ",\"message\":" + jsonString(std::string("Invalid request: ") + e.what()));
+    return true;
+  }
+
+  if (command == "stats") {
+    respond("{\"id\":" + jsonId(request->id) + "," + statistics().substr(1));
+    return true;
+  } else if (command == "shutdown") {
+    m_stopping = true;
+    respond("{\"id\":" + jsonId(request->id) + ",\"status\":\"ok\"}");
+    return false;
+  } else if (!command.empty()) {
+    finish(*request, "error", ",\"message\":" + jsonString("Unknown command \"" + command + "\"."));
+    return true;
+  }
+
+  auto timeout = request->json.get_optional<double>("timeout");
+  if (timeout) {
+    auto deadline = request->received + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double, std::milli>(std::max(*timeout, 0.0)));
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    request->deadline = m_deadlines.insert(std::make_pair(deadline, std::weak_ptr<Request>(request)));
+    request->watched = true;
+    m_watchWake.notify_one();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_inFlightMutex);
+    m_inFlight++;
+  }
+  m_pool.post([this, request]() {
+    run(request);
+    std::lock_guard<std::mutex> lock(m_inFlightMutex);
+    if (--m_inFlight == 0) {
+      m_idle.notify_all();
+    }
+  });
+  return true;
+}
+
+void SimulationServer::run(const std::shared_ptr<Request>& request)
+{
+  if (!request->answered) {
+    try {
+      CancellationScope scope(request->cancellation);
+      auto plan = this->plan(*request);
+      std::string results = request->json.get<std::string>("results", "monthly");
+      std::vector<EndUses> endUses;
+      if (results == "monthly") {
+        endUses = plan->simulateMonthly();
+      } else if (results == "hourlyByMonth") {
+        endUses = plan->simulateHourly(true);
+      } else if (results == "hourly") {
+        endUses = plan->simulateHourly(false);
+      } else {
+        throw std::invalid_argument("Unknown results \"" + results + "\", expected monthly, hourlyByMonth or hourly.");
+      }
+
+      std::ostringstream body;
+      body << std::setprecision(10) << ",\"results\":{";
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        body << (endUse > 0 ? "," : "") << "\"" << endUseName(endUse) << "\":[";
+        for (size_t period = 0; period < endUses.size(); period++) {
+          body << (period > 0 ? "," : "") << endUseValue(endUses[period], endUse);
+        }
+        body << "]";
+      }
+      body << "}";
+      finish(*request, "ok", body.str());
+    } catch (std::exception& e) {
+      finish(*request, "error", ",\"message\":" + jsonString(e.what()));
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_watchMutex);
+  if (request->watched) {
+    m_deadlines.erase(request->deadline);
+    request->watched = false;
+  }
+}
+
+void SimulationServer::finish(Request& request, const std::string& status, const std::string& body)
+{
+  std::lock_guard<std::mutex> lock(request.mutex);
+  if (request.answered) {
+    return;
+  }
+  request.answered = true;
+  double latency = milliseconds(std::chrono::steady_clock::now() - request.received);
+  {
+    std::lock_guard<std::mutex> statisticsLock(m_statisticsMutex);
+    m_requests++;
+    m_errors += status == "error" ? 1 : 0;
+    m_timeouts += status == "timeout" ? 1 : 0;
+    m_latency.add(latency);
+    m_latencies.add(latency);
+  }
+  std::ostringstream response;
+  response << "{\"id\":" << jsonId(request.id) << ",\"status\":\"" << status << "\",\"latencyMs\":" << std::setprecision(6) << latency
+           << body << "}";
+  request.respond(response.str());
+}
+
+void SimulationServer::watch()
+{
+  std::unique_lock<std::mutex> lock(m_watchMutex);
+  while (!m_stopWatching) {
+    if (m_deadlines.empty()) {
+      m_watchWake.wait(lock);
+      continue;
+    }
+    auto first = m_deadlines.begin();
+    if (first->first > std::chrono::steady_clock::now()) {
+      m_watchWake.wait_until(lock, first->first);
+      continue;
+    }
+    std::shared_ptr<Request> request = first->second.lock();
+    m_deadlines.erase(first);
+    if (request) {
+      request->watched = false;
+      lock.unlock();
+      // Answered first, so that the cancelled simulation cannot answer with an error.
+      finish(*request, "timeout", "");
+      request->cancellation.cancel();
+      lock.lock();
+    }
+  }
+}
+
+std::shared_ptr<const SimulationPlan> SimulationServer::plan(const Request& request)
+{
+  const auto& json = request.json;
+  std::string ismFile = json.get<std::string>("ism", "");
+  std::string defaultsFile = json.get<std::string>("defaults", "");
+  auto properties = json.get_child_optional("properties");
+  auto overrides = json.get_child_optional("overrides");
+  if (ismFile.empty() == !properties) {
+    throw std::invalid_argument("A request needs either an ism file or properties.");
+  }
+
+  std::string key = ismFile.empty() ? "properties:" + describe(*properties) + "|directory:" + json.get<std::string>("directory", "")
+                                    : "ism:" + describeFile(ismFile);
+  key += "|defaults:" + describeFile(defaultsFile);
+  if (overrides) {
+    key += "|overrides:" + describe(*overrides);
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto cached = m_planIndex.find(key);
+    if (cached != m_planIndex.end()) {
+      m_plans.splice(m_plans.begin(), m_plans, cached->second);
+      return cached->second->second;
+    }
+  }
+
+  UserModel model = ismFile.empty() ? inlineModel(request, defaultsFile) : fileModel(ismFile, defaultsFile);
+  if (overrides) {
+    model = model.withOverrides(toProperties(*overrides));
+  }
+  model.setResultCache(m_resultCache);
+  std::shared_ptr<const SimulationPlan> plan = model.compile();
+
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  if (m_planIndex.find(key) == m_planIndex.end()) {
+    m_plans.push_front(CachedPlan(key, plan));
+    m_planIndex[key] = m_plans.begin();
+    if (m_plans.size() > m_planCacheSize) {
+      m_planIndex.erase(m_plans.back().first);
+      m_plans.pop_back();
+    }
+  }
+  return plan;
+}
+
+UserModel SimulationServer::fileModel(const std::string& ismFile, const std::string& defaultsFile)
+{
+  std::string key = describeFile(ismFile) + "|" + describeFile(defaultsFile);
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto cached = m_models.find(key);
+    if (cached != m_models.end()) {
+      return cached->second;
+    }
+  }
+
+  UserModel model;
+  if (defaultsFile.empty()) {
+    model.load(ismFile);
+  } else {
+    model.load(ismFile, defaultsFile);
+  }
+  if (!model.valid()) {
+    throw std::invalid_argument("Cannot load " + ismFile + ".");
+  }
+  // Models with the same weather file share one copy of the weather.
+  boost::filesystem::path weatherFile(model.weatherFilePath());
+  if (!boost::filesystem::exists(weatherFile)) {
+    weatherFile = boost::filesystem::path(ismFile).parent_path() / weatherFile;
+  }
+  Station loaded = { model.weatherData(), model.epwData() };
+  Station shared = station(boost::filesystem::canonical(weatherFile).string(), &loaded);
+  model.setWeather(shared.weather, shared.epwData);
+
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  m_models.insert(std::make_pair(key, model));
+  return model;
+}
+
+UserModel SimulationServer::inlineModel(const Request& request, const std::string& defaultsFile)
+{
+  std::shared_ptr<const Properties> defaults;
+  if (!defaultsFile.empty()) {
+    describeFile(defaultsFile);
+    defaults = Properties::shared(defaultsFile);
+  }
+  Properties properties = toProperties(request.json.get_child("properties"), defaults);
+  UserModel model;
+  bindIsmProperties(model, properties);
+
+  std::string directory = request.json.get<std::string>("directory", "");
+  if (directory.empty() && !defaultsFile.empty()) {
+    directory = boost::filesystem::path(defaultsFile).parent_path().string();
+  }
+  boost::filesystem::path weatherFile(model.weatherFilePath());
+  if (!weatherFile.is_absolute() && !directory.empty()) {
+    weatherFile = boost::filesystem::path(directory) / weatherFile;
+  }
+  if (!boost::filesystem::exists(weatherFile)) {
+    throw std::invalid_argument("Weather file not found: " + weatherFile.string());
+  }
+  Station shared = station(boost::filesystem::canonical(weatherFile).string());
+  model.setWeather(shared.weather, shared.epwData);
+  model.setValid(true);
+  return model;
+}
+
+SimulationServer::Station SimulationServer::station(const std::string& weatherFile, const Station* loaded)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto cached = m_stations.find(weatherFile);
+    if (cached != m_stations.end()) {
+      return cached->second;
+    }
+  }
+  Station station;
+  if (loaded != nullptr) {
+    station = *loaded;
+  } else {
+    UserModel loader;
+    loader.setWeatherFilePath(weatherFile);
+    loader.loadWeather();
+    station.weather = loader.weatherData();
+    station.epwData = loader.epwData();
+  }
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  return m_stations.insert(std::make_pair(weatherFile, station)).first->second;
+}
+
+void SimulationServer::wait()
+{
+  std::unique_lock<std::mutex> lock(m_inFlightMutex);
+  m_idle.wait(lock, [this]() { return m_inFlight == 0; });
+}
+
+std::string SimulationServer::statistics() const
+{
+  size_t models;
+  size_t plans;
+  size_t stations;
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    models = m_models.size();
+    plans = m_plans.size();
+    stations = m_stations.size();
+  }
+  std::lock_guard<std::mutex> lock(m_statisticsMutex);
+  std::ostringstream out;
+  out << std::setprecision(6) << "{\"status\":\"ok\",\"requests\":" << m_requests << ",\"errors\":" << m_errors
+      << ",\"timeouts\":" << m_timeouts << ",\"meanMs\":" << m_latency.mean() << ",\"p50Ms\":"
+      << (m_requests > 0 ? m_latencies.quantile(0.5) : 0) << ",\"p99Ms\":" << (m_requests > 0 ? m_latencies.quantile(0.99) : 0)
+      << ",\"maxMs\":" << (m_requests > 0 ? m_latency.max() : 0) << ",\"models\":" << models << ",\"plans\":" << plans
+      << ",\"stations\":" << stations;
+  if (m_resultCache) {
+    ResultCacheStatistics results = m_resultCache->statistics();
+    out << ",\"resultHits\":" << results.hits + results.diskHits << ",\"resultMisses\":" << results.misses;
+  }
+  out << "}";
+  return out.str();
+}
+
+void SimulationServer::serve(std::istream& in, std::ostream& out)
+{
+  m_stopping = false;
+  std::mutex outMutex;
+  auto respond = [&](const std::string& line) {
+    std::lock_guard<std::mutex> lock(outMutex);
+    out << line << "\n";
+    out.flush();
+  };
+  for (std::string line; std::getline(in, line);) {
+    if (boost::trim_copy(line).empty()) {
+      continue;
+    }
+    if (!handle(line, respond)) {
+      break;
+    }
+  }
+  wait();
+}
+
+#ifdef _WIN32
+
+void SimulationServer::serveSocket(const std::string&)
+{
+  throw std::invalid_argument("Unix domain sockets are not supported on this platform.");
+}
+
+void SimulationServer::serveConnection(int)
+{
+}
+
+#else
+
+namespace {
+
+// A client connection, closed once the reader and every response are done with it.
+struct Connection
+{
+  int socket;
+  std::mutex mutex;
+
+  explicit Connection(int socket) : socket(socket)
+  {
+  }
+
+  ~Connection()
+  {
+    close(socket);
+  }
+
+  void send(const std::string& line)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+      ssize_t count = ::send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (count <= 0) {
+        return; // The client has gone.
+      }
+      sent += (size_t) count;
+    }
+  }
+};
+
+// Removes the socket file at path, if any. Returns false, removing nothing, if path is
+// something other than a socket.
+bool removeSocketFile(const std::string& path)
+{
+  struct stat status;
+  if (lstat(path.c_str(), &status) != 0) {
+    return true;
+  }
+  if (!S_ISSOCK(status.st_mode)) {
+    return false;
+  }
+  unlink(path.c_str());
+  return true;
+}
+
+// A connection's thread, and whether it has finished and can be joined.
+struct ConnectionThread
+{
+  std::thread thread;
+  std::shared_ptr<std::atomic<bool> > finished;
+};
+
+}
+
+void SimulationServer::serveSocket(const std::string& path)
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("The socket path " + path + " is too long.");
+  }
+  std::strcpy(address.sun_path, path.c_str());
+
+  if (!removeSocketFile(path)) {
+    throw std::invalid_argument("Cannot listen on " + path + ", which exists and is not a socket.");
+  }
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    throw std::invalid_argument("Cannot create a socket.");
+  }
+  if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+    close(listener);
+    throw std::invalid_argument("Cannot listen on " + path + ".");
+  }
+
+  m_stopping = false;
+  std::list<ConnectionThread> connections;
+  while (!m_stopping) {
+    // Join the threads of closed connections, so that they do not pile up.
+    for (auto connection = connections.begin(); connection != connections.end();) {
+      if (*connection->finished) {
+        connection->thread.join();
+        connection = connections.erase(connection);
+      } else {
+        ++connection;
+      }
+    }
+    pollfd ready = { listener, POLLIN, 0 };
+    if (poll(&ready, 1, 100) <= 0) {
+      continue;
+    }
+    int client = accept(listener, nullptr, nullptr);
+    if (client >= 0) {
+      auto finished = std::make_shared<std::atomic<bool> >(false);
+      std::thread thread([this, client, finished]() {
+        serveConnection(client);
+        *finished = true;
+      });
+      ConnectionThread connection = { std::move(thread), finished };
+      connections.push_back(std::move(connection));
+    }
+  }
+  close(listener);
+  removeSocketFile(path);
+  for (auto& connection : connections) {
+    connection.thread.join();
+  }
+  wait();
+}
+
+void SimulationServer::serveConnection(int socket)
+{
+  auto connection = std::make_shared<Connection>(socket);
+  auto respond = [connection](const std::string& line) { connection->send(line); };
+  std::string buffer;
+  char chunk[65536];
+  while (!m_stopping) {
+    pollfd ready = { socket, POLLIN, 0 };
+    if (poll(&ready, 1, 100) <= 0) {
+      continue;
+    }
+    ssize_t count = read(socket, chunk, sizeof(chunk));
+    if (count <= 0) {
+      break;
+    }
+    buffer.append(chunk, (size_t) count);
+    size_t start = 0;
+    for (size_t end; (end = buffer.find('\n', start)) != std::string::npos; start = end + 1) {
+      std::string line = buffer.substr(start, end - start);
+      if (!boost::trim_copy(line).empty() && !handle(line, respond)) {
+        break;
+      }
+    }
+    buffer.erase(0, start);
+  }
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,178 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SIMULATION_SERVER_HPP
+#define ISOMODEL_SIMULATION_SERVER_HPP
+
+#include "ISOModelAPI.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace openstudio {
+namespace isomodel {
+
+class SimulationPlan;
+
+/**
+ * A long running simulation service that answers JSON lines requests, keeping loaded
+ * models, weather and compiled simulation plans in memory between requests. A request
+ * is one JSON object per line:
+ *
+ * {"id": 1, "ism": "office.ism", "defaults": "defaults.ism", "overrides": {"floorArea": 1500}, "results": "monthly", "timeout": 250}
+ *
+ * The model is either an .ism file ("ism", with optional "defaults") or inline
+ * "properties" (over optional "defaults"; a relative weatherFilePath is resolved against
+ * "directory", else the directory of the defaults file, else the working directory).
+ * "overrides" sets properties of either; vector properties may be JSON arrays. "results"
+ * is monthly (monthly method, the default), hourlyByMonth or hourly (8760 values per end
+ * use). "timeout" is in milliseconds from receipt.
+ *
+ * Requests run on an internal thread pool and may be pipelined: responses are written
+ * as they finish, each echoing the request's id, e.g.
+ *
+ * {"id":1,"status":"ok","latencyMs":0.4,"results":{"ElecHeat":[...],...}}
+ *
+ * A status of error comes with a message; a request not finished within its timeout is
+ * answered with a status of timeout as soon as it expires, and its simulation stops at
+ * its next cancellation check (see CancellationScope). {"command": "stats"} reports
+ * the request counts, the mean, p50 and p99 latencies and the result cache hits and
+ * misses, and {"command": "shutdown"} stops serve() and serveSocket().
+ */
+class ISOMODEL_API SimulationServer
+{
+public:
+  /**
+   * threadCount workers (0 for one per hardware thread) and at most planCacheSize
+   * compiled plans, least recently used first out.
+   */
+  explicit SimulationServer(unsigned threadCount = 0, size_t planCacheSize = 256);
+
+  /**
+   * Waits for the requests in progress.
+   */
+  ~SimulationServer();
+
+  /**
+   * Answers requests whose inputs match earlier ones from cache (see ResultCache), which
+   * may be shared with other servers or a disk store. Call before handling requests.
+   */
+  void setResultCache(const std::shared_ptr<ResultCache>& cache) {
+    m_resultCache = cache;
+  }
+
+  /**
+   * Handles one request line. respond is called exactly once with the response line (no
+   * newline); it may be called on another thread, before or after handle returns.
+   * Returns false if the request was a shutdown command.
+   */
+  bool handle(const std::string& line, const std::function<void(const std::string&)>& respond);
+
+  /**
+   * Answers the requests read from in on out until the end of in or a shutdown command,
+   * then waits for the requests in progress.
+   */
+  void serve(std::istream& in, std::ostream& out);
+
+  /**
+   * Listens on a Unix domain socket at path and answers the requests of each connection
+   * on that connection until a shutdown command. A stale socket at path is replaced; any
+   * other file there is left alone. Throws std::invalid_argument if path exists and is
+   * not a socket, if the socket cannot be created or on platforms without Unix domain
+   * sockets.
+   */
+  void serveSocket(const std::string& path);
+
+  /**
+   * Waits until no request is in progress.
+   */
+  void wait();
+
+  /**
+   * The stats response: request, error and timeout counts, latencies and cache sizes.
+   */
+  std::string statistics() const;
+
+private:
+  struct Request;
+
+  struct Station
+  {
+    std::shared_ptr<WeatherData> weather;
+    std::shared_ptr<EpwData> epwData;
+  };
+
+  void run(const std::shared_ptr<Request>& request);
+  std::shared_ptr<const SimulationPlan> plan(const Request& request);
+  UserModel fileModel(const std::string& ismFile, const std::string& defaultsFile);
+  UserModel inlineModel(const Request& request, const std::string& defaultsFile);
+  // The shared weather of a weather file, loading it unless loaded is given.
+  Station station(const std::string& weatherFile, const Station* loaded = nullptr);
+  void serveConnection(int socket);
+  // Sends response unless the request has already been answered.
+  void finish(Request& request, const std::string& status, const std::string& body);
+  void watch();
+
+  ThreadPool m_pool;
+  size_t m_planCacheSize;
+  std::shared_ptr<ResultCache> m_resultCache;
+  std::atomic<bool> m_stopping;
+
+  mutable std::mutex m_cacheMutex;
+  std::map<std::string, UserModel> m_models;
+  std::map<std::string, Station> m_stations;
+  // Compiled plans by model description, most recently used first.
+  typedef std::pair<std::string, std::shared_ptr<const SimulationPlan> > CachedPlan;
+  std::list<CachedPlan> m_plans;
+  std::unordered_map<std::string, std::list<CachedPlan>::iterator> m_planIndex;
+
+  mutable std::mutex m_statisticsMutex;
+  size_t m_requests;
+  size_t m_errors;
+  size_t m_timeouts;
+  RunningStats m_latency;
+  TDigest m_latencies;
+
+  std::mutex m_inFlightMutex;
+  std::condition_variable m_idle;
+  size_t m_inFlight;
+
+  // Deadlines of the requests with a timeout.
+  std::mutex m_watchMutex;
+  std::condition_variable m_watchWake;
+  std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<Request> > m_deadlines;
+  bool m_stopWatching;
+  std::thread m_watchdog;
+};
+
+}
+}
+#endif
@@ -83,6 +83,12 @@ public:
     m_hri = hri;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_phiIntFractionToAirNode & m_phiSolFractionToAirNode & m_hci & m_hri;
+  }
+
 private:
   double m_phiIntFractionToAirNode = 0.5; // Default value is the "0.5" from ISO 13790 C.2 eq C.1.
   double m_phiSolFractionToAirNode = 0; // Default is that no solar heat flows directly to air node per ISO 13790 C.2 eq C.1.
@@ -23,7 +23,6 @@ SolarRadiation::SolarRadiation(TimeFrame* frame, EpwData* wdata, double tilt)
   m_hourlyDewPointTemp.resize(MONTHS);
   m_hourlyGlobalHorizontalRadiation.resize(MONTHS);
   m_monthlySolarRadiation.resize(MONTHS);
-  m_eglobe.resize(TIMESLICES);
   for (int i = 0; i < MONTHS; i++) {
     m_hourlyDryBulbTemp[i].resize(HOURS);
     m_hourlyDewPointTemp[i].resize(HOURS);
@@ -32,9 +31,6 @@ SolarRadiation::SolarRadiation(TimeFrame* frame, EpwData* wdata, double tilt)
   for (int i = 0; i < MONTHS; i++) {
     m_monthlySolarRadiation[i].resize(NUM_SURFACES);
   }
-  for (int i = 0; i < TIMESLICES; i++) {
-    m_eglobe[i].resize(NUM_SURFACES);
-  }
   m_frame = frame;
   m_epwData = wdata;
   m_longitude = wdata->longitude() * PI / 180.0; // Convert to radians.
@@ -54,46 +50,50 @@ SolarRadiation::~SolarRadiation(void)
  * Wiley 2006
  */
 void SolarRadiation::calculateSurfaceSolarRadiation()
+{
+  //decode only the columns needed rather than copying data()
+  std::vector<double> vecEB, vecED;
+  m_epwData->column(EB, vecEB);
+  m_epwData->column(ED, vecED);
+  m_eglobe.resize(TIMESLICES * NUM_SURFACES);
+  for (int i = 0; i < TIMESLICES; i++) {
+    calculateHourSurfaceRadiation(m_frame->YTD[i], m_frame->Hour[i], vecEB[i], vecED[i], &m_eglobe[i * NUM_SURFACES]);
+  }
+}
+
+void SolarRadiation::calculateHourSurfaceRadiation(int dayOfYear, int hourOfDay, double directBeam, double diffuse, double* eglobe)
 {
   double GroundReflected = 0, SolarAzimuthSin = 0, SolarAzimuthCos = 0, SolarAzimuth = 0, Revolution, EquationOfTime, ApparentSolarTime,
       SolarDeclination, SolarHourAngles, SolarAltitudeAngles;
 
   double AngleOfIncidence, SurfaceSolarAzimuth, DirectBeam, diffuseAngleOfIncidenceFactor, DiffuseComponent;
 
-  //avoid calling data() to reduce copy time
-  std::vector<std::vector<double> > data = m_epwData->data();
-  std::vector<double> vecEB = data[EB];
-  std::vector<double> vecED = data[ED];
-  std::vector<double>* vecEGI;
-  for (int i = 0; i < TIMESLICES; i++) {
-    // First compute the solar azimuth for each hour of the year for our location
-    Revolution = calculateRevolutionAngle(m_frame->YTD[i]);
-    EquationOfTime = calculateEquationOfTime(Revolution);
-    ApparentSolarTime = calculateApparentSolarTime(m_frame->Hour[i], EquationOfTime);
+  // First compute the solar azimuth for the hour for our location
+  Revolution = calculateRevolutionAngle(dayOfYear);
+  EquationOfTime = calculateEquationOfTime(Revolution);
+  ApparentSolarTime = calculateApparentSolarTime(hourOfDay, EquationOfTime);
 
-    SolarDeclination = calculateSolarDeclination(Revolution);
-    SolarHourAngles = calculateSolarHourAngle(ApparentSolarTime);
-    SolarAltitudeAngles = calculateSolarAltitude(SolarDeclination, SolarHourAngles);
+  SolarDeclination = calculateSolarDeclination(Revolution);
+  SolarHourAngles = calculateSolarHourAngle(ApparentSolarTime);
+  SolarAltitudeAngles = calculateSolarAltitude(SolarDeclination, SolarHourAngles);
 
-    SolarAzimuthSin = calculateSolarAzimuthSin(SolarDeclination, SolarHourAngles, SolarAltitudeAngles);
-    SolarAzimuthCos = calculateSolarAzimuthCos(SolarDeclination, SolarHourAngles, SolarAltitudeAngles);
-    SolarAzimuth = calculateSolarAzimuth(SolarAzimuthSin, SolarAzimuthCos);
+  SolarAzimuthSin = calculateSolarAzimuthSin(SolarDeclination, SolarHourAngles, SolarAltitudeAngles);
+  SolarAzimuthCos = calculateSolarAzimuthCos(SolarDeclination, SolarHourAngles, SolarAltitudeAngles);
+  SolarAzimuth = calculateSolarAzimuth(SolarAzimuthSin, SolarAzimuthCos);
 
-    GroundReflected = calculateGroundReflectedIrradiance(vecEB[i], vecED[i], m_groundReflectance, SolarAltitudeAngles, m_surfaceTilt);
-    vecEGI = &(m_eglobe[i]);
+  GroundReflected = calculateGroundReflectedIrradiance(directBeam, diffuse, m_groundReflectance, SolarAltitudeAngles, m_surfaceTilt);
 
-    //then compute the hourly radiation on each vertical surface given the solar azimuth for each hour
-    for (int s = 0; s < NUM_SURFACES; s++) {
-      SurfaceSolarAzimuth = calculateSurfaceSolarAzimuth(SolarAzimuth, SurfaceAzimuths[s]);
-      AngleOfIncidence = calculateAngleOfIncidence(SolarAltitudeAngles, SurfaceSolarAzimuth, m_surfaceTilt);
+  //then compute the hourly radiation on each vertical surface given the solar azimuth for the hour
+  for (int s = 0; s < NUM_SURFACES; s++) {
+    SurfaceSolarAzimuth = calculateSurfaceSolarAzimuth(SolarAzimuth, SurfaceAzimuths[s]);
+    AngleOfIncidence = calculateAngleOfIncidence(SolarAltitudeAngles, SurfaceSolarAzimuth, m_surfaceTilt);
 
-      DirectBeam = calculateTotalDirectBeamIrradiance(vecEB[i], AngleOfIncidence);
+    DirectBeam = calculateTotalDirectBeamIrradiance(directBeam, AngleOfIncidence);
 
-      diffuseAngleOfIncidenceFactor = calculateDiffuseAngleOfIncidenceFactor(AngleOfIncidence);
-      DiffuseComponent = calculateTotalDiffuseIrradiance(vecED[i], diffuseAngleOfIncidenceFactor, m_surfaceTilt);
+    diffuseAngleOfIncidenceFactor = calculateDiffuseAngleOfIncidenceFactor(AngleOfIncidence);
+    DiffuseComponent = calculateTotalDiffuseIrradiance(diffuse, diffuseAngleOfIncidenceFactor, m_surfaceTilt);
 
-      (*vecEGI)[s] = calculateTotalIrradiance(DirectBeam, DiffuseComponent, GroundReflected);
-    }
+    eglobe[s] = calculateTotalIrradiance(DirectBeam, DiffuseComponent, GroundReflected);
   }
 }
 
@@ -145,13 +145,12 @@ void SolarRadiation::calculateAverages()
   int cnt = 0;
   int h = 0;
 
-  std::vector<std::vector<double> > data = m_epwData->data();
-  std::vector<double> vecDBT = data[DBT];
-  std::vector<double> vecDPT = data[DPT];
-  std::vector<double> vecRH = data[RH];
-
-  std::vector<double> vecEGH = data[EGH];
-  std::vector<double> vecWSPD = data[WSPD];
+  std::vector<double> vecDBT, vecDPT, vecRH, vecEGH, vecWSPD;
+  m_epwData->column(DBT, vecDBT);
+  m_epwData->column(DPT, vecDPT);
+  m_epwData->column(RH, vecRH);
+  m_epwData->column(EGH, vecEGH);
+  m_epwData->column(WSPD, vecWSPD);
 
   for (int i = 0; i < TIMESLICES; i++, cnt++) {
     if (m_frame->Month[i] != month) {
@@ -170,7 +169,7 @@ void SolarRadiation::calculateAverages()
     m_monthlyGlobalHorizontalRadiation[midx] += vecEGH[i];
     m_monthlyWindspeed[midx] += vecWSPD[i];
     for (int s = 0; s < NUM_SURFACES; s++)
-      m_monthlySolarRadiation[midx][s] += m_eglobe[i][s];
+      m_monthlySolarRadiation[midx][s] += m_eglobe[i * NUM_SURFACES + s];
     h = m_frame->Hour[i];
     m_hourlyDryBulbTemp[midx][h] += vecDBT[i];
     m_hourlyDewPointTemp[midx][h] += vecDPT[i];
@@ -180,6 +179,15 @@ void SolarRadiation::calculateAverages()
   calculateMonthAvg(midx, cnt);
 }
 
+std::vector<std::vector<double> > SolarRadiation::eglobe()
+{
+  std::vector<std::vector<double> > result(TIMESLICES);
+  for (int i = 0; i < TIMESLICES; i++) {
+    result[i].assign(m_eglobe.begin() + i * NUM_SURFACES, m_eglobe.begin() + (i + 1) * NUM_SURFACES);
+  }
+  return result;
+}
+
 //Calculate hourly solar radiation for each surface
 //and then calculate the monthly/hourly averages
 void SolarRadiation::Calculate()
@@ -49,7 +49,7 @@ protected:
   double m_groundReflectance; // rho_g
 
   //outputs
-  std::vector<std::vector<double> > m_eglobe; //total solar radiation from direct beam, ground reflect and diffuse
+  std::vector<double> m_eglobe; //total solar radiation from direct beam, ground reflect and diffuse, NUM_SURFACES values per hour
   //averages
   std::vector<double> m_monthlyDryBulbTemp;
   std::vector<double> m_monthlyDewPointTemp;
@@ -68,6 +68,12 @@ public:
   ~SolarRadiation(void);
 
   void calculateSurfaceSolarRadiation();
+
+  /**
+  * Calculates the total irradiance on each of the NUM_SURFACES surfaces for a single hour
+  * from the direct beam and diffuse irradiance of that hour. Writes NUM_SURFACES values to eglobe.
+  */
+  void calculateHourSurfaceRadiation(int dayOfYear, int hourOfDay, double directBeam, double diffuse, double* eglobe);
   void calculateAverages();
   void calculateMonthAvg(int midx, int cnt);
   void clearMonthlyAvg(int midx);
@@ -248,9 +254,14 @@ public:
   }
 
   // Outputs
-  std::vector<std::vector<double> > eglobe() {
-    return m_eglobe;
-  }	//total solar radiation from direct beam, ground reflect and diffuse
+  std::vector<std::vector<double> > eglobe();	//total solar radiation from direct beam, ground reflect and diffuse
+
+  /**
+  * Total solar radiation on a surface for an hour of the year, without copying the whole table.
+  */
+  double eglobe(int hourOfYear, int surface) const {
+    return m_eglobe[hourOfYear * NUM_SURFACES + surface];
+  }
 
   // Averages
   std::vector<double> monthlyDryBulbTemp() {
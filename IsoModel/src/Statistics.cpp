@@ -0,0 +1,194 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+RunningStats::RunningStats()
+  : m_count(0), m_mean(0), m_m2(0), m_min(std::numeric_limits<double>::infinity()), m_max(-std::numeric_limits<double>::infinity())
+{
+}
+
+void RunningStats::add(double value)
+{
+  m_count++;
+  double delta = value - m_mean;
+  m_mean += delta / m_count;
+  m_m2 += delta * (value - m_mean);
+  m_min = std::min(m_min, value);
+  m_max = std::max(m_max, value);
+}
+
+void RunningStats::merge(const RunningStats& other)
+{
+  if (other.m_count == 0) {
+    return;
+  }
+  if (m_count == 0) {
+    *this = other;
+    return;
+  }
+  double count = (double) (m_count + other.m_count);
+  double delta = other.m_mean - m_mean;
+  m_mean += delta * other.m_count / count;
+  m_m2 += other.m_m2 + delta * delta * m_count * other.m_count / count;
+  m_count += other.m_count;
+  m_min = std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+}
+
+double RunningStats::variance() const
+{
+  return m_count < 2 ? 0 : m_m2 / (m_count - 1);
+}
+
+double RunningStats::standardDeviation() const
+{
+  return std::sqrt(variance());
+}
+
+double RunningStats::standardError() const
+{
+  return m_count == 0 ? 0 : standardDeviation() / std::sqrt((double) m_count);
+}
+
+TDigest::TDigest(double compression)
+  : m_compression(compression), m_bufferLimit((size_t) (5 * compression)), m_min(std::numeric_limits<double>::infinity()),
+    m_max(-std::numeric_limits<double>::infinity()), m_totalWeight(0), m_bufferWeight(0)
+{
+  if (!(compression >= 10)) {
+    throw std::invalid_argument("The t-digest compression must be at least 10.");
+  }
+}
+
+void TDigest::add(double value, double weight)
+{
+  if (std::isnan(value) || !(weight > 0)) {
+    return;
+  }
+  m_min = std::min(m_min, value);
+  m_max = std::max(m_max, value);
+  Centroid centroid = { value, weight };
+  m_buffer.push_back(centroid);
+  m_bufferWeight += weight;
+  if (m_buffer.size() >= m_bufferLimit) {
+    compress();
+  }
+}
+
+void TDigest::merge(const TDigest& other)
+{
+  other.compress();
+  for (const auto& centroid : other.m_centroids) {
+    add(centroid.mean, centroid.weight);
+  }
+  // Centroid means lie inside the range, so the extremes are carried over separately.
+  m_min = std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+}
+
+void TDigest::compress() const
+{
+  if (m_buffer.empty()) {
+    return;
+  }
+  m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+  std::sort(m_buffer.begin(), m_buffer.end(), [](const Centroid& x, const Centroid& y) { return x.mean < y.mean; });
+
+  double total = m_totalWeight + m_bufferWeight;
+  // The k1 scale function k(q) = compression / (2 pi) asin(2q - 1): a centroid may span
+  // at most one unit of k, which keeps centroids near the tails small.
+  const double pi = 3.14159265358979323846;
+  auto k = [&](double q) { return m_compression / (2 * pi) * std::asin(2 * q - 1); };
+  auto kInverse = [&](double value) { return (std::sin(value * 2 * pi / m_compression) + 1) / 2; };
+
+  m_centroids.clear();
+  Centroid current = m_buffer.front();
+  double mergedWeight = 0;
+  double limit = total * kInverse(k(0) + 1);
+  for (size_t i = 1; i < m_buffer.size(); i++) {
+    const Centroid& next = m_buffer[i];
+    if (mergedWeight + current.weight + next.weight <= limit) {
+      current.weight += next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / current.weight;
+    } else {
+      mergedWeight += current.weight;
+      m_centroids.push_back(current);
+      limit = total * kInverse(k(std::min(1.0, mergedWeight / total)) + 1);
+      current = next;
+    }
+  }
+  m_centroids.push_back(current);
+
+  m_buffer.clear();
+  m_totalWeight = total;
+  m_bufferWeight = 0;
+}
+
+size_t TDigest::centroidCount() const
+{
+  compress();
+  return m_centroids.size();
+}
+
+double TDigest::quantile(double q) const
+{
+  compress();
+  if (m_centroids.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (q <= 0) {
+    return m_min;
+  }
+  if (q >= 1) {
+    return m_max;
+  }
+  if (m_centroids.size() == 1) {
+    return m_centroids.front().mean;
+  }
+
+  // Each centroid is taken to be centred on its cumulative weight; values are
+  // interpolated between neighbouring centres and, outside of them, the extremes.
+  double index = q * m_totalWeight;
+  const Centroid& first = m_centroids.front();
+  if (index < first.weight / 2) {
+    return m_min + (first.mean - m_min) * index / (first.weight / 2);
+  }
+  double weightSoFar = first.weight / 2;
+  for (size_t i = 0; i + 1 < m_centroids.size(); i++) {
+    double step = (m_centroids[i].weight + m_centroids[i + 1].weight) / 2;
+    if (index < weightSoFar + step) {
+      double fraction = (index - weightSoFar) / step;
+      return m_centroids[i].mean + (m_centroids[i + 1].mean - m_centroids[i].mean) * fraction;
+    }
+    weightSoFar += step;
+  }
+  const Centroid& last = m_centroids.back();
+  double fraction = std::min(1.0, (index - weightSoFar) / (last.weight / 2));
+  return last.mean + (m_max - last.mean) * fraction;
+}
+
+}
+}
@@ -0,0 +1,143 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_STATISTICS_HPP
+#define ISOMODEL_STATISTICS_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Count, mean, variance and range of a stream of values, updated one value at a time
+ * with Welford's algorithm so that no values are stored.
+ */
+class ISOMODEL_API RunningStats
+{
+public:
+  RunningStats();
+
+  void add(double value);
+
+  /**
+   * Adds the values summarized by other (Chan's parallel update).
+   */
+  void merge(const RunningStats& other);
+
+  size_t count() const {
+    return m_count;
+  }
+
+  double mean() const {
+    return m_mean;
+  }
+
+  /**
+   * Sample variance (n - 1 denominator); 0 for fewer than two values.
+   */
+  double variance() const;
+
+  double standardDeviation() const;
+
+  /**
+   * Standard error of the mean.
+   */
+  double standardError() const;
+
+  double min() const {
+    return m_min;
+  }
+
+  double max() const {
+    return m_max;
+  }
+
+private:
+  size_t m_count;
+  double m_mean;
+  double m_m2;
+  double m_min;
+  double m_max;
+};
+
+/**
+ * A merging t-digest: a streaming sketch of a distribution that answers quantile
+ * queries with an error that is smallest in the tails. Values are buffered and merged
+ * into at most about compression centroids, so its size does not grow with the number
+ * of values added.
+ */
+class ISOMODEL_API TDigest
+{
+public:
+  explicit TDigest(double compression = 100);
+
+  void add(double value, double weight = 1);
+
+  /**
+   * Adds the values summarized by other.
+   */
+  void merge(const TDigest& other);
+
+  /**
+   * The value below which a fraction q of the values lie. NaN if the digest is empty.
+   */
+  double quantile(double q) const;
+
+  /**
+   * Total weight of the values added.
+   */
+  double count() const {
+    return m_totalWeight + m_bufferWeight;
+  }
+
+  /**
+   * Number of centroids after merging the buffered values.
+   */
+  size_t centroidCount() const;
+
+  double compression() const {
+    return m_compression;
+  }
+
+private:
+  struct Centroid
+  {
+    double mean;
+    double weight;
+  };
+
+  void compress() const;
+
+  double m_compression;
+  size_t m_bufferLimit;
+  double m_min;
+  double m_max;
+  // Merged lazily, so that queries are const.
+  mutable std::vector<Centroid> m_centroids;
+  mutable std::vector<Centroid> m_buffer;
+  mutable double m_totalWeight;
+  mutable double m_bufferWeight;
+};
+
+}
+}
+#endif
@@ -317,6 +317,17 @@ public:
     m_R_sc_ext = R_sc_ext;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_floorArea & m_wallArea & m_windowArea & m_wallUniform & m_windowUniform
+        & m_wallThermalEmissivity & m_wallSolarAbsorbtion & m_windowShadingDevice
+        & m_windowNormalIncidenceSolarEnergyTransmittance & m_windowShadingCorrectionFactor
+        & m_interiorHeatCapacity & m_wallHeatCapacity & m_buildingHeight & m_infiltrationRate
+        & m_R_se & m_irradianceForMaxShadingUse & m_shadingFactorAtMaxUse & m_totalAreaPerFloorArea
+        & m_win_ff & m_win_F_W & m_R_sc_ext;
+  }
+
 private:
   double m_floorArea;
   Vector m_wallArea;
@@ -0,0 +1,478 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Surrogate.hpp"
+#include "BinaryArchive.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+const char SURROGATE_MAGIC[8] = { 'I', 'S', 'M', 'S', 'U', 'R', 'R', 'O' };
+const uint32_t SURROGATE_VERSION = 1;
+const int MAX_DEGREE = 10;
+
+void checkDegree(int degree)
+{
+  if (degree < 1 || degree > MAX_DEGREE) {
+    throw std::invalid_argument("The surrogate degree must be between 1 and " + std::to_string(MAX_DEGREE) + ".");
+  }
+}
+
+// The exponents of every term of total degree up to degree in dimensions
+// parameters, ordered by total degree.
+std::vector<uint16_t> totalDegreeTerms(size_t dimensions, int degree)
+{
+  std::vector<uint16_t> exponents;
+  std::vector<uint16_t> term(dimensions, 0);
+  // Distributes remaining over the parameters from dimension on.
+  std::function<void(size_t, int)> distribute = [&](size_t dimension, int remaining) {
+    if (dimension + 1 == dimensions) {
+      term[dimension] = (uint16_t) remaining;
+      exponents.insert(exponents.end(), term.begin(), term.end());
+      return;
+    }
+    for (int e = remaining; e >= 0; e--) {
+      term[dimension] = (uint16_t) e;
+      distribute(dimension + 1, remaining - e);
+    }
+  };
+  for (int total = 0; total <= degree; total++) {
+    distribute(0, total);
+  }
+  return exponents;
+}
+
+bool isValidationRun(size_t run, double validation)
+{
+  return std::floor((run + 1) * validation) > std::floor(run * validation);
+}
+
+// Solves the least squares problem min |A x - B| for every column of B by Householder
+// QR. A is rows x columns and B rows x outputs, both column by column. Returns the
+// solution column by column, or throws if A does not have full column rank.
+std::vector<double> leastSquares(std::vector<double>& a, std::vector<double>& b, size_t rows, size_t columns, size_t outputs)
+{
+  std::vector<double> v(rows);
+  for (size_t k = 0; k < columns; k++) {
+    double* column = &a[k * rows];
+    double norm = 0;
+    double scale = 0;
+    for (size_t r = 0; r < rows; r++) {
+      scale = std::max(scale, std::abs(column[r]));
+    }
+    for (size_t r = k; r < rows; r++) {
+      norm += column[r] * column[r];
+    }
+    norm = std::sqrt(norm);
+    if (scale == 0 || !(norm > 1e-10 * scale * std::sqrt((double) rows))) {
+      throw std::invalid_argument("The runs do not determine term " + std::to_string(k + 1) +
+                                  " of the surrogate; use more samples or levels, or a lower degree.");
+    }
+    double alpha = column[k] > 0 ? -norm : norm;
+    double vNorm2 = 0;
+    for (size_t r = k; r < rows; r++) {
+      v[r] = column[r];
+    }
+    v[k] -= alpha;
+    for (size_t r = k; r < rows; r++) {
+      vNorm2 += v[r] * v[r];
+    }
+    auto reflect = [&](double* target) {
+      double dot = 0;
+      for (size_t r = k; r < rows; r++) {
+        dot += v[r] * target[r];
+      }
+      double factor = 2 * dot / vNorm2;
+      for (size_t r = k; r < rows; r++) {
+        target[r] -= factor * v[r];
+      }
+    };
+    for (size_t j = k + 1; j < columns; j++) {
+      reflect(&a[j * rows]);
+    }
+    for (size_t j = 0; j < outputs; j++) {
+      reflect(&b[j * rows]);
+    }
+    column[k] = alpha;
+  }
+
+  std::vector<double> x(columns * outputs);
+  for (size_t j = 0; j < outputs; j++) {
+    for (size_t k = columns; k-- > 0;) {
+      double sum = b[j * rows + k];
+      for (size_t c = k + 1; c < columns; c++) {
+        sum -= a[c * rows + k] * x[j * columns + c];
+      }
+      x[j * columns + k] = sum / a[k * rows + k];
+    }
+  }
+  return x;
+}
+
+}
+
+Surrogate::Surrogate() : m_degree(0), m_termCount(0), m_trainingRuns(0), m_validationRuns(0)
+{
+}
+
+Surrogate Surrogate::train(const UserModel& base, const SweepSpec& spec, ThreadPool& pool)
+{
+  checkDegree(spec.degree);
+  if (spec.parameters.empty()) {
+    throw std::invalid_argument("A surrogate needs at least one parameter.");
+  }
+  // Checked before simulating, as fit checks it only afterwards.
+  Sweep sweep(base, spec);
+  size_t training = 0;
+  for (size_t run = 0; run < sweep.size(); run++) {
+    training += isValidationRun(run, spec.validation) ? 0 : 1;
+  }
+  size_t terms = totalDegreeTerms(spec.parameters.size(), spec.degree).size() / spec.parameters.size();
+  if (training < terms) {
+    throw std::invalid_argument("A surrogate of degree " + std::to_string(spec.degree) + " has " + std::to_string(terms) +
+                                " terms but the design leaves only " + std::to_string(training) + " training runs.");
+  }
+
+  std::vector<std::vector<double> > inputs(sweep.size());
+  std::vector<std::vector<double> > outputs(sweep.size(), std::vector<double>(END_USE_COUNT, 0.0));
+  sweep.run(pool, [&](size_t run, const std::vector<EndUses>& results) {
+    inputs[run] = sweep.inputs(run);
+    for (const auto& month : results) {
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        outputs[run][endUse] += endUseValue(month, endUse);
+      }
+    }
+  });
+  return fit(spec.parameters, inputs, outputs, spec.degree, spec.validation);
+}
+
+Surrogate Surrogate::fit(const std::vector<SweepParameter>& parameters, const std::vector<std::vector<double> >& inputs,
+                         const std::vector<std::vector<double> >& outputs, int degree, double validation)
+{
+  checkDegree(degree);
+  if (parameters.empty()) {
+    throw std::invalid_argument("A surrogate needs at least one parameter.");
+  }
+  if (!(validation >= 0 && validation < 1)) {
+    throw std::invalid_argument("The validation fraction must be at least 0 and less than 1.");
+  }
+  if (inputs.size() != outputs.size()) {
+    throw std::invalid_argument("The surrogate needs the outputs of every run.");
+  }
+
+  Surrogate surrogate;
+  for (const auto& parameter : parameters) {
+    surrogate.m_names.push_back(parameter.name);
+    surrogate.m_distributions.push_back(parameter.distribution);
+  }
+  size_t dimensions = parameters.size();
+  surrogate.m_degree = degree;
+  surrogate.m_exponents = totalDegreeTerms(dimensions, degree);
+  size_t terms = surrogate.m_termCount = surrogate.m_exponents.size() / dimensions;
+
+  std::vector<size_t> trainingRuns;
+  std::vector<size_t> validationRuns;
+  for (size_t run = 0; run < inputs.size(); run++) {
+    if (inputs[run].size() != dimensions || outputs[run].size() != (size_t) END_USE_COUNT) {
+      throw std::invalid_argument("Run " + std::to_string(run) + " has the wrong number of inputs or outputs.");
+    }
+    (isValidationRun(run, validation) ? validationRuns : trainingRuns).push_back(run);
+  }
+  size_t rows = trainingRuns.size();
+  if (rows < terms) {
+    throw std::invalid_argument("A surrogate of degree " + std::to_string(degree) + " has " + std::to_string(terms) +
+                                " terms but there are only " + std::to_string(rows) + " training runs.");
+  }
+
+  std::vector<double> a(rows * terms);
+  std::vector<double> b(rows * END_USE_COUNT);
+  std::vector<double> basis(terms);
+  for (size_t r = 0; r < rows; r++) {
+    size_t run = trainingRuns[r];
+    surrogate.expand(inputs[run].data(), basis.data());
+    for (size_t t = 0; t < terms; t++) {
+      a[t * rows + r] = basis[t];
+    }
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      b[endUse * rows + r] = outputs[run][endUse];
+    }
+  }
+  std::vector<double> solution = leastSquares(a, b, rows, terms, END_USE_COUNT);
+  surrogate.m_coefficients.resize(terms * END_USE_COUNT);
+  for (size_t t = 0; t < terms; t++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      surrogate.m_coefficients[t * END_USE_COUNT + endUse] = solution[endUse * terms + t];
+    }
+  }
+  surrogate.m_trainingRuns = rows;
+  surrogate.m_validationRuns = validationRuns.size();
+
+  if (!validationRuns.empty()) {
+    // The end uses and then the EUI.
+    const int outputCount = END_USE_COUNT + 1;
+    std::vector<std::vector<double> > actual(outputCount);
+    std::vector<std::vector<double> > predicted(outputCount);
+    double values[END_USE_COUNT];
+    for (size_t run : validationRuns) {
+      surrogate.evaluate(inputs[run].data(), values);
+      double actualEui = 0;
+      double predictedEui = 0;
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        actual[endUse].push_back(outputs[run][endUse]);
+        predicted[endUse].push_back(values[endUse]);
+        actualEui += outputs[run][endUse];
+        predictedEui += values[endUse];
+      }
+      actual[END_USE_COUNT].push_back(actualEui);
+      predicted[END_USE_COUNT].push_back(predictedEui);
+    }
+    for (int output = 0; output < outputCount; output++) {
+      size_t n = actual[output].size();
+      double mean = 0;
+      for (double value : actual[output]) {
+        mean += value / n;
+      }
+      double squaredError = 0;
+      double squaredDeviation = 0;
+      SurrogateError error = { 0, 0, 0 };
+      for (size_t i = 0; i < n; i++) {
+        double residual = predicted[output][i] - actual[output][i];
+        squaredError += residual * residual;
+        squaredDeviation += (actual[output][i] - mean) * (actual[output][i] - mean);
+        error.maxError = std::max(error.maxError, std::abs(residual));
+      }
+      error.rmse = std::sqrt(squaredError / n);
+      // Outputs that vary only by rounding, such as lighting under envelope parameters,
+      // count as constant.
+      double tolerance = 1e-9 * (1 + std::abs(mean));
+      if (std::sqrt(squaredDeviation / n) > tolerance) {
+        error.r2 = 1 - squaredError / squaredDeviation;
+      } else {
+        error.r2 = error.maxError <= tolerance ? 1 : 0;
+      }
+      surrogate.m_validation.push_back(error);
+    }
+  }
+  return surrogate;
+}
+
+void Surrogate::expand(const double* parameters, double* basis) const
+{
+  size_t dimensions = m_names.size();
+  int stride = m_degree + 1;
+  double legendre[(MAX_DEGREE + 1) * 64];
+  std::vector<double> heap;
+  double* table = legendre;
+  if (dimensions * stride > sizeof(legendre) / sizeof(legendre[0])) {
+    heap.resize(dimensions * stride);
+    table = heap.data();
+  }
+  for (size_t d = 0; d < dimensions; d++) {
+    double u = 2 * m_distributions[d].cdf(parameters[d]) - 1;
+    double* p = table + d * stride;
+    // Legendre recurrence, then scaled to unit variance under the uniform distribution.
+    double previous = 1;
+    double current = u;
+    p[0] = 1;
+    for (int n = 1; n <= m_degree; n++) {
+      p[n] = current * std::sqrt(2.0 * n + 1);
+      double next = ((2 * n + 1) * u * current - n * previous) / (n + 1);
+      previous = current;
+      current = next;
+    }
+  }
+  const uint16_t* exponents = m_exponents.data();
+  for (size_t t = 0; t < m_termCount; t++) {
+    double value = 1;
+    for (size_t d = 0; d < dimensions; d++, exponents++) {
+      if (*exponents != 0) {
+        value *= table[d * stride + *exponents];
+      }
+    }
+    basis[t] = value;
+  }
+}
+
+void Surrogate::evaluate(const double* parameters, double* endUses) const
+{
+  if (m_termCount == 0) {
+    throw std::invalid_argument("The surrogate has not been trained.");
+  }
+  double local[512];
+  std::vector<double> heap;
+  double* basis = local;
+  if (m_termCount > sizeof(local) / sizeof(local[0])) {
+    heap.resize(m_termCount);
+    basis = heap.data();
+  }
+  expand(parameters, basis);
+  std::fill(endUses, endUses + END_USE_COUNT, 0.0);
+  const double* coefficients = m_coefficients.data();
+  for (size_t t = 0; t < m_termCount; t++, coefficients += END_USE_COUNT) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      endUses[endUse] += basis[t] * coefficients[endUse];
+    }
+  }
+}
+
+std::vector<double> Surrogate::evaluate(const std::vector<double>& parameters) const
+{
+  if (parameters.size() != m_names.size()) {
+    throw std::invalid_argument("The surrogate takes " + std::to_string(m_names.size()) + " parameters.");
+  }
+  std::vector<double> endUses(END_USE_COUNT);
+  evaluate(parameters.data(), endUses.data());
+  return endUses;
+}
+
+double Surrogate::eui(const double* parameters) const
+{
+  double endUses[END_USE_COUNT];
+  evaluate(parameters, endUses);
+  double sum = 0;
+  for (double value : endUses) {
+    sum += value;
+  }
+  return sum;
+}
+
+double Surrogate::mean(int endUse) const
+{
+  double sum = 0;
+  for (int e = 0; e < END_USE_COUNT; e++) {
+    if (e == endUse || endUse == END_USE_COUNT) {
+      sum += m_coefficients[e];
+    }
+  }
+  return sum;
+}
+
+double Surrogate::standardDeviation(int endUse) const
+{
+  double variance = 0;
+  for (size_t t = 1; t < m_termCount; t++) {
+    double coefficient = 0;
+    for (int e = 0; e < END_USE_COUNT; e++) {
+      if (e == endUse || endUse == END_USE_COUNT) {
+        coefficient += m_coefficients[t * END_USE_COUNT + e];
+      }
+    }
+    variance += coefficient * coefficient;
+  }
+  return std::sqrt(variance);
+}
+
+void Surrogate::writeReport(std::ostream& out) const
+{
+  out << "output,mean,standardDeviation,rmse,maxError,r2\n";
+  std::streamsize precision = out.precision(10);
+  for (int output = 0; output <= END_USE_COUNT; output++) {
+    out << (output < END_USE_COUNT ? endUseName(output) : "eui") << "," << mean(output) << "," << standardDeviation(output);
+    if (m_validation.empty()) {
+      out << ",,,";
+    } else {
+      const SurrogateError& error = m_validation[output];
+      out << "," << error.rmse << "," << error.maxError << "," << error.r2;
+    }
+    out << "\n";
+  }
+  out.precision(precision);
+}
+
+void Surrogate::save(const std::string& file) const
+{
+  BinaryWriter out;
+  out.bytes(SURROGATE_MAGIC, sizeof(SURROGATE_MAGIC));
+  out.u32(SURROGATE_VERSION);
+  out.u32((uint32_t) m_names.size());
+  for (size_t d = 0; d < m_names.size(); d++) {
+    const Distribution& distribution = m_distributions[d];
+    out.text(m_names[d]);
+    out.u8((uint8_t) distribution.type);
+    out & distribution.a & distribution.b & distribution.c;
+  }
+  out & m_degree & m_exponents & m_coefficients;
+  out.u64(m_trainingRuns);
+  out.u64(m_validationRuns);
+  out.u32((uint32_t) m_validation.size());
+  for (const auto& error : m_validation) {
+    out & error.rmse & error.maxError & error.r2;
+  }
+  out.save(file, "surrogate");
+}
+
+Surrogate Surrogate::load(const std::string& file)
+{
+  std::string data = BinaryReader::load(file, "surrogate");
+  BinaryReader in(data, "Surrogate file '" + file + "'");
+  if (std::memcmp(in.take(sizeof(SURROGATE_MAGIC)), SURROGATE_MAGIC, sizeof(SURROGATE_MAGIC)) != 0) {
+    throw std::invalid_argument("'" + file + "' is not a surrogate file.");
+  }
+  uint32_t version = in.u32();
+  if (version != SURROGATE_VERSION) {
+    throw std::invalid_argument("Unsupported surrogate version " + std::to_string(version) + " in '" + file + "'.");
+  }
+  Surrogate surrogate;
+  uint32_t dimensions = in.u32();
+  for (uint32_t d = 0; d < dimensions; d++) {
+    surrogate.m_names.push_back(in.text());
+    Distribution distribution;
+    uint8_t type = in.u8();
+    if (type > Distribution::TRIANGULAR) {
+      throw std::invalid_argument("'" + file + "' has an unknown distribution.");
+    }
+    distribution.type = (Distribution::Type) type;
+    in & distribution.a & distribution.b & distribution.c;
+    surrogate.m_distributions.push_back(distribution);
+  }
+  in & surrogate.m_degree & surrogate.m_exponents & surrogate.m_coefficients;
+  surrogate.m_trainingRuns = in.u64();
+  surrogate.m_validationRuns = in.u64();
+  uint32_t errors = in.u32();
+  for (uint32_t i = 0; i < errors; i++) {
+    SurrogateError error;
+    in & error.rmse & error.maxError & error.r2;
+    surrogate.m_validation.push_back(error);
+  }
+  surrogate.m_termCount = dimensions == 0 ? 0 : surrogate.m_exponents.size() / dimensions;
+  bool consistent = dimensions > 0 && surrogate.m_degree >= 1 && surrogate.m_degree <= MAX_DEGREE &&
+                    surrogate.m_exponents.size() == surrogate.m_termCount * dimensions &&
+                    surrogate.m_coefficients.size() == surrogate.m_termCount * END_USE_COUNT &&
+                    (errors == 0 || errors == END_USE_COUNT + 1);
+  for (uint16_t exponent : surrogate.m_exponents) {
+    consistent = consistent && exponent <= surrogate.m_degree;
+  }
+  if (!consistent) {
+    throw std::invalid_argument("'" + file + "' is not a consistent surrogate file.");
+  }
+  return surrogate;
+}
+
+}
+}
@@ -0,0 +1,172 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SURROGATE_HPP
+#define ISOMODEL_SURROGATE_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * Error of a surrogate's predictions of one output on the held-out validation runs, in
+ * the units of the output (kWh/m2 per year).
+ */
+struct ISOMODEL_API SurrogateError
+{
+  double rmse;
+  double maxError;
+  double r2; // 1 for an output that is constant over the validation runs and predicted to rounding.
+};
+
+/**
+ * A polynomial chaos expansion of the annual end uses of a model in the parameters of a
+ * SweepSpec, for answering what-if queries in microseconds.
+ *
+ * Each parameter is mapped through the cumulative distribution function of its
+ * distribution to u in [-1, 1], which is uniformly distributed when the parameter
+ * follows its distribution, and every annual end use is approximated by a sum of
+ * products of orthonormal Legendre polynomials in the u of total degree up to degree().
+ * The coefficients are fitted by least squares to simulated runs of the spec's design,
+ * so the expansion is accurate where the distributions put their weight; values outside
+ * the range of a bounded distribution are clamped to it.
+ *
+ * A fraction of the runs, spread evenly over the design, is held out of the fit and
+ * gives the error estimates returned by validation(). Since the basis is orthonormal
+ * under the input distributions, the mean of an end use is its constant coefficient and
+ * its variance the sum of the squares of the others.
+ */
+class ISOMODEL_API Surrogate
+{
+public:
+  Surrogate();
+
+  /**
+   * Simulates the runs of spec against base on pool with the spec's engine and fits an
+   * expansion of total degree spec.degree, holding out spec.validation of the runs.
+   * Throws std::invalid_argument if a parameter is unknown or there are fewer training
+   * runs than terms.
+   */
+  static Surrogate train(const UserModel& base, const SweepSpec& spec, ThreadPool& pool);
+
+  /**
+   * Fits an expansion to given runs: the parameter values of each run (in parameter
+   * order) and its END_USE_COUNT annual end uses. Run r is held out if
+   * floor((r + 1) * validation) > floor(r * validation).
+   */
+  static Surrogate fit(const std::vector<SweepParameter>& parameters, const std::vector<std::vector<double> >& inputs,
+                       const std::vector<std::vector<double> >& outputs, int degree, double validation);
+
+  size_t parameterCount() const {
+    return m_names.size();
+  }
+
+  const std::vector<std::string>& parameterNames() const {
+    return m_names;
+  }
+
+  int degree() const {
+    return m_degree;
+  }
+
+  /**
+   * Number of polynomials of the expansion.
+   */
+  size_t termCount() const {
+    return m_termCount;
+  }
+
+  size_t trainingRuns() const {
+    return m_trainingRuns;
+  }
+
+  size_t validationRuns() const {
+    return m_validationRuns;
+  }
+
+  /**
+   * Writes the predicted annual end uses (END_USE_COUNT values, kWh/m2) for parameters
+   * (parameterCount() values) to endUses.
+   */
+  void evaluate(const double* parameters, double* endUses) const;
+
+  std::vector<double> evaluate(const std::vector<double>& parameters) const;
+
+  /**
+   * The predicted sum of the annual end uses.
+   */
+  double eui(const double* parameters) const;
+
+  /**
+   * The validation error of each end use, followed by that of the EUI. Empty if no
+   * runs were held out.
+   */
+  const std::vector<SurrogateError>& validation() const {
+    return m_validation;
+  }
+
+  /**
+   * Mean and standard deviation of an end use (END_USE_COUNT for the EUI) over the
+   * parameter distributions.
+   */
+  double mean(int endUse) const;
+  double standardDeviation(int endUse) const;
+
+  /**
+   * Writes a CSV table of the mean, standard deviation and validation errors of every
+   * end use and the EUI.
+   */
+  void writeReport(std::ostream& out) const;
+
+  /**
+   * Saves to or loads from a binary file. load throws std::invalid_argument if the file
+   * is not a surrogate file.
+   */
+  void save(const std::string& file) const;
+  static Surrogate load(const std::string& file);
+
+private:
+  // Writes the value of every term at parameters to basis.
+  void expand(const double* parameters, double* basis) const;
+
+  std::vector<std::string> m_names;
+  std::vector<Distribution> m_distributions;
+  int m_degree;
+  size_t m_termCount;
+  // The degree of each parameter in each term, term by term.
+  std::vector<uint16_t> m_exponents;
+  // END_USE_COUNT coefficients per term, term by term.
+  std::vector<double> m_coefficients;
+  size_t m_trainingRuns;
+  size_t m_validationRuns;
+  std::vector<SurrogateError> m_validation;
+};
+
+}
+}
+#endif
@@ -0,0 +1,360 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "Sweep.hpp"
+#include "CsvWriter.hpp"
+#include "ResultFile.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+double parseNumber(const std::string& text)
+{
+  char* end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0') {
+    throw std::invalid_argument("\"" + text + "\" is not a number.");
+  }
+  return value;
+}
+
+long long parseInteger(const std::string& text)
+{
+  char* end = nullptr;
+  long long value = std::strtoll(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || value < 0) {
+    throw std::invalid_argument("\"" + text + "\" is not a non-negative integer.");
+  }
+  return value;
+}
+
+std::string resolve(const std::string& file, const std::string& baseDirectory)
+{
+  if (file.empty() || baseDirectory.empty()) {
+    return file;
+  }
+  boost::filesystem::path path(file);
+  return path.is_absolute() ? file : (boost::filesystem::path(baseDirectory) / path).string();
+}
+
+// Parses "name distribution p1 p2 [p3] [levels=N]".
+SweepParameter parseParameter(const std::string& value, int defaultLevels)
+{
+  std::vector<std::string> tokens;
+  std::istringstream in(value);
+  for (std::string token; in >> token;) {
+    tokens.push_back(token);
+  }
+  if (tokens.size() < 2) {
+    throw std::invalid_argument("A parameter needs a name and a distribution.");
+  }
+  SweepParameter parameter;
+  parameter.name = tokens[0];
+  parameter.levels = defaultLevels;
+  std::vector<double> numbers;
+  for (size_t i = 2; i < tokens.size(); i++) {
+    if (boost::istarts_with(tokens[i], "levels=")) {
+      parameter.levels = (int) parseInteger(tokens[i].substr(7));
+    } else {
+      numbers.push_back(parseNumber(tokens[i]));
+    }
+  }
+  parameter.distribution = Distribution::parse(boost::to_lower_copy(tokens[1]), numbers);
+  return parameter;
+}
+
+}
+
+SweepSpec::SweepSpec()
+  : design(LATIN_HYPERCUBE), samples(100), levels(3), seed(1), engine(MONTHLY_ENGINE), threads(0), monthlyColumns(false),
+    tolerance(0), confidence(0.95), batch(256), minSamples(100),
+    method(SALTELLI), bootstrap(100), algorithm(NSGA2), population(0), generations(50),
+    degree(3), validation(0.2)
+{
+}
+
+SweepSpec SweepSpec::load(const std::string& specFile)
+{
+  std::ifstream in(specFile.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open sweep spec " + specFile + ".");
+  }
+  return parse(in, boost::filesystem::path(specFile).parent_path().string());
+}
+
+SweepSpec SweepSpec::parse(std::istream& in, const std::string& baseDirectory)
+{
+  SweepSpec spec;
+  // Parameter lines are parsed at the end, so that "levels" may follow them.
+  std::vector<std::pair<int, std::string> > parameterLines;
+  int lineNumber = 0;
+  for (std::string line; std::getline(in, line);) {
+    lineNumber++;
+    line = line.substr(0, line.find('#'));
+    boost::trim(line);
+    if (line.empty()) {
+      continue;
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the sweep spec is not a \"key = value\" setting.");
+    }
+    std::string key = boost::to_lower_copy(boost::trim_copy(line.substr(0, equals)));
+    std::string value = boost::trim_copy(line.substr(equals + 1));
+    try {
+      if (key == "model") {
+        spec.modelFile = resolve(value, baseDirectory);
+      } else if (key == "defaults") {
+        spec.defaultsFile = resolve(value, baseDirectory);
+      } else if (key == "output") {
+        spec.outputFile = resolve(value, baseDirectory);
+      } else if (key == "metered") {
+        spec.meteredFile = resolve(value, baseDirectory);
+      } else if (key == "design") {
+        std::string design = boost::to_lower_copy(value);
+        if (design == "grid") {
+          spec.design = GRID;
+        } else if (design == "lhs") {
+          spec.design = LATIN_HYPERCUBE;
+        } else if (design == "sobol") {
+          spec.design = SOBOL;
+        } else {
+          throw std::invalid_argument("Unknown design \"" + value + "\", expected grid, lhs or sobol.");
+        }
+      } else if (key == "samples") {
+        spec.samples = (size_t) parseInteger(value);
+      } else if (key == "levels") {
+        spec.levels = (int) parseInteger(value);
+      } else if (key == "seed") {
+        spec.seed = (uint64_t) parseInteger(value);
+      } else if (key == "engine") {
+        spec.engine = parseSimulationEngine(boost::to_lower_copy(value));
+      } else if (key == "threads") {
+        spec.threads = (unsigned) parseInteger(value);
+      } else if (key == "columns") {
+        std::string columns = boost::to_lower_copy(value);
+        if (columns != "annual" && columns != "monthly") {
+          throw std::invalid_argument("Unknown columns \"" + value + "\", expected annual or monthly.");
+        }
+        spec.monthlyColumns = columns == "monthly";
+      } else if (key == "tolerance") {
+        spec.tolerance = parseNumber(value);
+        if (spec.tolerance < 0) {
+          throw std::invalid_argument("The tolerance must not be negative.");
+        }
+      } else if (key == "confidence") {
+        spec.confidence = parseNumber(value);
+        if (!(spec.confidence > 0 && spec.confidence < 1)) {
+          throw std::invalid_argument("The confidence must be between 0 and 1.");
+        }
+      } else if (key == "batch") {
+        spec.batch = (size_t) parseInteger(value);
+        if (spec.batch == 0) {
+          throw std::invalid_argument("The batch must hold at least one run.");
+        }
+      } else if (key == "minsamples") {
+        spec.minSamples = (size_t) parseInteger(value);
+      } else if (key == "method") {
+        std::string method = boost::to_lower_copy(value);
+        if (method == "saltelli") {
+          spec.method = SALTELLI;
+        } else if (method == "morris") {
+          spec.method = MORRIS;
+        } else {
+          throw std::invalid_argument("Unknown method \"" + value + "\", expected saltelli or morris.");
+        }
+      } else if (key == "bootstrap") {
+        spec.bootstrap = (size_t) parseInteger(value);
+      } else if (key == "algorithm") {
+        std::string algorithm = boost::to_lower_copy(value);
+        if (algorithm == "nsga2") {
+          spec.algorithm = NSGA2;
+        } else if (algorithm == "cmaes") {
+          spec.algorithm = CMA_ES;
+        } else {
+          throw std::invalid_argument("Unknown algorithm \"" + value + "\", expected nsga2 or cmaes.");
+        }
+      } else if (key == "population") {
+        spec.population = (size_t) parseInteger(value);
+      } else if (key == "generations") {
+        spec.generations = (size_t) parseInteger(value);
+      } else if (key == "degree") {
+        spec.degree = (int) parseInteger(value);
+      } else if (key == "validation") {
+        spec.validation = parseNumber(value);
+        if (!(spec.validation >= 0 && spec.validation < 1)) {
+          throw std::invalid_argument("The validation fraction must be at least 0 and less than 1.");
+        }
+      } else if (key == "surrogate") {
+        spec.surrogateFile = resolve(value, baseDirectory);
+      } else if (key == "objective") {
+        spec.objectives.push_back(value);
+      } else if (key == "parameter") {
+        parameterLines.push_back(std::make_pair(lineNumber, value));
+      } else {
+        throw std::invalid_argument("Unknown setting \"" + key + "\".");
+      }
+    } catch (std::invalid_argument& e) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the sweep spec: " + e.what());
+    }
+  }
+  for (const auto& parameterLine : parameterLines) {
+    try {
+      spec.parameters.push_back(parseParameter(parameterLine.second, spec.levels));
+    } catch (std::invalid_argument& e) {
+      throw std::invalid_argument("Line " + std::to_string(parameterLine.first) + " of the sweep spec: " + e.what());
+    }
+  }
+  return spec;
+}
+
+std::vector<std::vector<double> > SweepSpec::runs() const
+{
+  size_t dimensions = parameters.size();
+  std::vector<std::vector<double> > values;
+  if (design == GRID) {
+    std::vector<int> levelCounts;
+    for (const auto& parameter : parameters) {
+      levelCounts.push_back(parameter.levels);
+    }
+    for (const auto& point : gridDesign(levelCounts)) {
+      std::vector<double> run(dimensions);
+      for (size_t d = 0; d < dimensions; d++) {
+        const Distribution& distribution = parameters[d].distribution;
+        run[d] = distribution.quantile(distribution.gridPoint(point[d], parameters[d].levels));
+      }
+      values.push_back(run);
+    }
+    return values;
+  }
+
+  std::vector<std::vector<double> > unit;
+  if (design == SOBOL) {
+    SobolSequence sobol(dimensions);
+    unit.assign(samples, std::vector<double>(dimensions));
+    for (auto& point : unit) {
+      sobol.next(point.data());
+    }
+  } else {
+    unit = latinHypercube(samples, dimensions, seed);
+  }
+  for (auto& point : unit) {
+    for (size_t d = 0; d < dimensions; d++) {
+      point[d] = parameters[d].distribution.quantile(point[d]);
+    }
+  }
+  return unit;
+}
+
+Sweep::Sweep(const UserModel& base, const SweepSpec& spec) : m_base(base), m_engine(spec.engine), m_monthlyColumns(spec.monthlyColumns)
+{
+  std::vector<std::string> names;
+  for (const auto& parameter : spec.parameters) {
+    names.push_back(parameter.name);
+  }
+  m_binding = ParameterBinding(names);
+  m_inputs = spec.runs();
+}
+
+void Sweep::run(ThreadPool& pool, const std::function<void(size_t, const std::vector<EndUses>&)>& sink) const
+{
+  std::mutex sinkMutex;
+  pool.parallelFor(m_inputs.size(), [&](size_t run) {
+    UserModel model = m_binding.bind(m_base, m_inputs[run].data());
+    auto results = simulateByMonth(model, m_engine);
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sink(run, results);
+  });
+}
+
+void Sweep::writeCsv(ThreadPool& pool, std::ostream& out) const
+{
+  CsvWriter writer(out, 10);
+  writeCsv(pool, writer);
+  writer.flush();
+}
+
+void Sweep::writeCsv(ThreadPool& pool, CsvWriter& out) const
+{
+  out.field("run");
+  for (const auto& name : m_binding.names()) {
+    out.field(name);
+  }
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    if (m_monthlyColumns) {
+      for (int month = 1; month <= 12; month++) {
+        out.field(std::string(endUseName(endUse)) + "_" + std::to_string(month));
+      }
+    } else {
+      out.field(endUseName(endUse));
+    }
+  }
+  out.endRow();
+
+  run(pool, [&](size_t run, const std::vector<EndUses>& results) {
+    out.field(static_cast<int>(run));
+    for (double value : m_inputs[run]) {
+      out.field(value);
+    }
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      if (m_monthlyColumns) {
+        for (const auto& month : results) {
+          out.field(endUseValue(month, endUse));
+        }
+      } else {
+        double annual = 0;
+        for (const auto& month : results) {
+          annual += endUseValue(month, endUse);
+        }
+        out.field(annual);
+      }
+    }
+    out.endRow();
+  });
+}
+
+void Sweep::writeResults(ThreadPool& pool, ResultFileWriter& out) const
+{
+  if (out.periods() != 12) {
+    throw std::invalid_argument("A sweep writes 12 monthly periods per run, not " + std::to_string(out.periods()) + ".");
+  }
+  const std::vector<std::string>& names = m_binding.names();
+  run(pool, [&](size_t run, const std::vector<EndUses>& results) {
+    ResultFileBuilding building;
+    building.id = std::to_string(run);
+    char value[CsvWriter::MAX_DOUBLE_LENGTH];
+    for (size_t i = 0; i < names.size(); i++) {
+      building.metadata[names[i]] = std::string(value, CsvWriter::formatDouble(m_inputs[run][i], CsvWriter::SHORTEST, value));
+    }
+    out.append(building, results);
+  });
+}
+
+}
+}
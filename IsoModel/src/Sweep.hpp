@@ -0,0 +1,226 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_SWEEP_HPP
+#define ISOMODEL_SWEEP_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+#include "Sampling.hpp"
+#include "ThreadPool.hpp"
+#include "UserModel.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class CsvWriter;
+class ResultFileWriter;
+
+/**
+ * A swept model input: a numeric .ism property, the distribution its values are drawn
+ * from and its number of levels in a grid design.
+ */
+struct ISOMODEL_API SweepParameter
+{
+  std::string name;
+  Distribution distribution;
+  int levels;
+};
+
+/**
+ * Description of a parametric sweep. A spec file holds one "key = value" setting per
+ * line; # starts a comment. For example
+ *
+ * model = SmallOffice_v2.ism<br>
+ * design = lhs<br>
+ * samples = 200<br>
+ * engine = monthly<br>
+ * parameter = floorArea uniform 1000 2000<br>
+ * parameter = heatingSetpointOccupied normal 20 1<br>
+ * parameter = wallU triangular 0.2 0.4 0.8 levels=5
+ *
+ * The settings are model and defaults (.ism files, relative to the spec file), design
+ * (grid, lhs or sobol), samples (runs of lhs and sobol designs), levels (default grid
+ * levels per parameter), seed (of lhs designs), engine (monthly or hourly), threads (0
+ * for one per hardware thread), output (CSV file, relative to the spec file; standard
+ * output if absent) and columns (annual or monthly results). Each parameter line names
+ * a property, a distribution (see Distribution::parse) and its parameters, and may
+ * override the grid levels. A vector property such as windowArea gets the same value on
+ * all nine surfaces, the roof included; windowArea[S] varies the south facade only (see
+ * ParameterBinding).
+ *
+ * Monte Carlo runs (see MonteCarlo) draw up to samples random runs in batches of batch
+ * runs and stop early once, after at least minsamples runs, the confidence (default
+ * 0.95) interval of the mean annual value of every end use is within a relative
+ * tolerance of the mean. A tolerance of 0 (the default) always runs every sample.
+ *
+ * Sensitivity analyses (see SensitivityStudy) use method (saltelli, the default, or
+ * morris), samples (base samples of a Saltelli design or Morris trajectories), levels
+ * (of the Morris grid; best even), seed and bootstrap (resamples for the confidence
+ * intervals of the indices, default 100).
+ *
+ * Optimizations (see Optimizer) search the ranges of the parameters, which must be
+ * uniform or triangular, with algorithm (nsga2, the default, or cmaes), population (0
+ * for the algorithm's default), generations and seed, minimizing every objective line
+ * (see Objective::parse; the EUI if there are none).
+ *
+ * Calibrations (see Calibration) fit the parameters to metered (a CSV file of monthly
+ * or hourly electricity and gas use, relative to the spec file) with CMA-ES, using
+ * population, generations and seed.
+ *
+ * Surrogates (see Surrogate) are polynomial chaos expansions of total degree degree
+ * (default 3) fitted to the runs of the design, of which the fraction validation
+ * (default 0.2) is held out to estimate their error. The fitted surrogate is saved to
+ * surrogate (relative to the spec file) and its report written to output.
+ */
+struct ISOMODEL_API SweepSpec
+{
+  enum Design
+  {
+    GRID,
+    LATIN_HYPERCUBE,
+    SOBOL
+  };
+
+  enum SensitivityMethod
+  {
+    SALTELLI,
+    MORRIS
+  };
+
+  enum OptimizationAlgorithm
+  {
+    NSGA2,
+    CMA_ES
+  };
+
+  SweepSpec();
+
+  std::string modelFile;
+  std::string defaultsFile;
+  std::string outputFile;
+  std::string meteredFile;
+  std::string surrogateFile;
+  Design design;
+  size_t samples;
+  int levels;
+  uint64_t seed;
+  SimulationEngine engine;
+  unsigned threads;
+  bool monthlyColumns;
+  double tolerance;
+  double confidence;
+  size_t batch;
+  size_t minSamples;
+  SensitivityMethod method;
+  size_t bootstrap;
+  OptimizationAlgorithm algorithm;
+  size_t population;
+  size_t generations;
+  int degree;
+  double validation;
+  std::vector<std::string> objectives;
+  std::vector<SweepParameter> parameters;
+
+  /**
+   * Reads a spec file. Throws std::invalid_argument naming the line of the first error.
+   */
+  static SweepSpec load(const std::string& specFile);
+
+  /**
+   * Reads a spec from in, resolving relative file names against baseDirectory.
+   */
+  static SweepSpec parse(std::istream& in, const std::string& baseDirectory = std::string());
+
+  /**
+   * The input values of every run of the design, one vector of parameter values
+   * (in parameter order) per run.
+   */
+  std::vector<std::vector<double> > runs() const;
+};
+
+/**
+ * Runs the design of a SweepSpec against a base model on a thread pool.
+ */
+class ISOMODEL_API Sweep
+{
+public:
+  Sweep(const UserModel& base, const SweepSpec& spec);
+
+  /**
+   * Number of runs.
+   */
+  size_t size() const {
+    return m_inputs.size();
+  }
+
+  /**
+   * The parameter values of a run.
+   */
+  const std::vector<double>& inputs(size_t run) const {
+    return m_inputs[run];
+  }
+
+  const ParameterBinding& binding() const {
+    return m_binding;
+  }
+
+  /**
+   * Simulates every run on pool. sink(run, results) receives the 12 monthly results of
+   * each run as soon as it finishes, so runs arrive in completion order; calls to sink
+   * never overlap.
+   */
+  void run(ThreadPool& pool, const std::function<void(size_t, const std::vector<EndUses>&)>& sink) const;
+
+  /**
+   * Runs the sweep and writes a header and one CSV row per run to out as it finishes:
+   * the run number, the parameter values and the annual (or, with monthlyColumns,
+   * monthly) end uses in kWh/m2. The caller flushes out.
+   */
+  void writeCsv(ThreadPool& pool, CsvWriter& out) const;
+
+  /**
+   * As writeCsv, through a CsvWriter with 10 significant digits.
+   */
+  void writeCsv(ThreadPool& pool, std::ostream& out) const;
+
+  /**
+   * Runs the sweep and appends each run to out as it finishes, the columnar form of
+   * writeCsv: a building per run, identified by the run number, with the parameter values
+   * as its metadata and the 12 monthly results. Throws std::invalid_argument unless out
+   * has 12 periods. The caller closes out.
+   */
+  void writeResults(ThreadPool& pool, ResultFileWriter& out) const;
+
+private:
+  UserModel m_base;
+  SimulationEngine m_engine;
+  bool m_monthlyColumns;
+  ParameterBinding m_binding;
+  std::vector<std::vector<double> > m_inputs;
+};
+
+}
+}
+#endif
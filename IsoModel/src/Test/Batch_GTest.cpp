@@ -0,0 +1,167 @@
+/*
+ * Batch_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Batch.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// The result rows of a partial or merged result file, without the comment lines.
+std::vector<std::string> dataLines(const std::string& text)
+{
+  std::vector<std::string> lines;
+  std::istringstream in(text);
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty() && line[0] != '#') {
+      lines.push_back(line);
+    }
+  }
+  return lines;
+}
+
+std::string mergeError(const std::vector<std::string>& files)
+{
+  std::ostringstream out;
+  try {
+    mergeBatchPartials(files, out);
+  } catch (const std::invalid_argument& e) {
+    return e.what();
+  }
+  return std::string();
+}
+
+}
+
+TEST_F(ISOModelFixture, BatchManifestTests)
+{
+  std::istringstream text("output = nightly.csv\n"
+                          "defaults = SmallOffice_v2.ism\n"
+                          "portfolio = portfolio.csv # monthly by default\n"
+                          "engine = hourly\n"
+                          "portfolio = portfolio.csv\n");
+  BatchManifest manifest = BatchManifest::parse(text, test_data_path);
+  ASSERT_EQ(2u, manifest.jobs.size());
+  EXPECT_EQ(MONTHLY_ENGINE, manifest.jobs[0].engine);
+  EXPECT_EQ(HOURLY_ENGINE, manifest.jobs[1].engine);
+  EXPECT_EQ((boost::filesystem::path(test_data_path) / "SmallOffice_v2.ism").string(), manifest.jobs[1].defaultsFile);
+  EXPECT_EQ((boost::filesystem::path(test_data_path) / "nightly.csv").string(), manifest.outputFile);
+  EXPECT_EQ(16u, manifest.fingerprint().size());
+
+  BatchManifest monthly = manifest;
+  monthly.jobs[1].engine = MONTHLY_ENGINE;
+  EXPECT_NE(manifest.fingerprint(), monthly.fingerprint());
+
+  std::istringstream bad("portfolio = a.csv\nengine = daily\n");
+  EXPECT_THROW(BatchManifest::parse(bad), std::invalid_argument);
+  std::istringstream empty("engine = hourly\n");
+  EXPECT_THROW(BatchManifest::parse(empty), std::invalid_argument);
+
+  ShardId shard = ShardId::parse("2/5");
+  EXPECT_EQ(2u, shard.index);
+  EXPECT_EQ(5u, shard.count);
+  EXPECT_EQ("2/5", shard.toString());
+  EXPECT_THROW(ShardId::parse("0/5"), std::invalid_argument);
+  EXPECT_THROW(ShardId::parse("6/5"), std::invalid_argument);
+  EXPECT_THROW(ShardId::parse("2"), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, BatchShardBalanceTests)
+{
+  // 40 buildings at one station: monthly in the first job, hourly in the second.
+  std::string csvFile = test_data_path + "/batch_test.csv";
+  {
+    std::ofstream csv(csvFile.c_str());
+    csv << "id,floorArea\n";
+    for (int i = 0; i < 40; i++) {
+      csv << "b" << i << "," << 1000 + 10 * i << "\n";
+    }
+  }
+  BatchManifest manifest;
+  BatchJob job = { csvFile, test_data_path + "/SmallOffice_v2.ism", MONTHLY_ENGINE };
+  manifest.jobs.push_back(job);
+  job.engine = HOURLY_ENGINE;
+  manifest.jobs.push_back(job);
+  Batch batch(manifest, 2);
+  EXPECT_EQ(80u, batch.size());
+
+  for (unsigned count = 1; count <= 5; count++) {
+    auto shards = batch.plan(count);
+    ASSERT_EQ(count, shards.size());
+    std::vector<int> seen(80, 0);
+    double maxCost = 0;
+    double minCost = 1e300;
+    for (const auto& shard : shards) {
+      for (const auto& item : shard) {
+        seen[item.job * 40 + item.building]++;
+      }
+      maxCost = std::max(maxCost, batch.cost(shard));
+      minCost = std::min(minCost, batch.cost(shard));
+    }
+    // Every building is in exactly one shard, and the hourly job is spread out.
+    EXPECT_EQ(std::vector<int>(80, 1), seen);
+    EXPECT_LE(maxCost, 1.25 * minCost) << count << " shards";
+    // Every process computes the same division.
+    EXPECT_EQ(shards.back().size(), batch.shard(ShardId(count, count)).size());
+  }
+  boost::filesystem::remove(csvFile);
+}
+
+TEST_F(ISOModelFixture, BatchShardMergeTests)
+{
+  BatchManifest manifest;
+  BatchJob job = { test_data_path + "/portfolio.csv", test_data_path + "/SmallOffice_v2.ism", MONTHLY_ENGINE };
+  manifest.jobs.push_back(job);
+  job.engine = HOURLY_ENGINE;
+  manifest.jobs.push_back(job);
+  Batch batch(manifest, 1);
+  ThreadPool pool(2);
+
+  std::ostringstream whole;
+  EXPECT_EQ(6u, batch.run(pool, ShardId(), whole));
+
+  // Three shards written as separate processes would, merged in any order.
+  std::vector<std::string> files;
+  for (unsigned index = 3; index >= 1; index--) {
+    std::string file = test_data_path + "/batch_test.shard-" + std::to_string(index) + "-of-3";
+    std::ofstream out(file.c_str());
+    Batch(manifest, 1).run(pool, ShardId(index, 3), out);
+    files.push_back(file);
+  }
+  std::ostringstream merged;
+  BatchSummary summary = mergeBatchPartials(files, merged);
+  EXPECT_EQ(3u, summary.shards);
+  EXPECT_EQ(6u, summary.buildings);
+  EXPECT_EQ(6u, summary.eui.count());
+  EXPECT_GT(summary.totals[9], 0);
+  EXPECT_EQ(dataLines(whole.str()), dataLines(merged.str()));
+  EXPECT_EQ(1u + 6 * 12, dataLines(merged.str()).size());
+
+  EXPECT_NE(std::string::npos, mergeError(std::vector<std::string>(files.begin(), files.begin() + 2)).find("Shards 1 of 3 are missing"));
+  EXPECT_NE(std::string::npos, mergeError({ files[0], files[1], files[1] }).find("another file"));
+
+  // Partials of other inputs are refused.
+  std::string otherFile = test_data_path + "/batch_test.other";
+  {
+    std::ofstream out(otherFile.c_str());
+    BatchManifest other = manifest;
+    other.jobs.pop_back();
+    Batch(other, 1).run(pool, ShardId(1, 3), out);
+  }
+  EXPECT_NE(std::string::npos, mergeError({ otherFile, files[0], files[1] }).find("different batch"));
+
+  boost::filesystem::remove(otherFile);
+  for (const auto& file : files) {
+    boost::filesystem::remove(file);
+  }
+}
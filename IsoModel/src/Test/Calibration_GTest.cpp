@@ -0,0 +1,100 @@
+/*
+ * Calibration_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Calibration.hpp"
+
+#include <cmath>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, FitStatisticsTests)
+{
+  std::vector<double> measured = { 100, 110, 90, std::nan(""), 100 };
+  std::vector<double> simulated = { 90, 110, 100, 0, 100 };
+  FitStatistics fit = fitStatistics(measured, simulated);
+  EXPECT_EQ(4u, fit.points);
+  EXPECT_NEAR(0, fit.nmbe, 1e-12);
+  EXPECT_NEAR(100 * std::sqrt(200.0 / 3) / 100, fit.cvrmse, 1e-12);
+  EXPECT_TRUE(fit.compliant(false));
+  fit.nmbe = -6;
+  EXPECT_FALSE(fit.compliant(false));
+  EXPECT_TRUE(fit.compliant(true));
+
+  std::istringstream bills("Month,Electricity,Gas\n1,100,\n2,100,5\n3,100,5\n4,100,5\n5,100,5\n6,100,5\n"
+                           "7,100,5\n8,100,5\n9,100,5\n10,100,5\n11,100,5\n12,100,5\n");
+  MeteredData data = MeteredData::parse(bills);
+  EXPECT_EQ(12u, data.periods());
+  EXPECT_FALSE(data.hourly());
+  EXPECT_TRUE(std::isnan(data.gas[0]));
+  std::istringstream short_("Electricity\n1\n2\n");
+  EXPECT_THROW(MeteredData::parse(short_), std::invalid_argument);
+  std::istringstream unknown("Month,Water\n1,2\n");
+  EXPECT_THROW(MeteredData::parse(unknown), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, MonthlyCalibrationTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  std::istringstream in("generations = 40\n"
+                        "parameter = heatingSetpointOccupied uniform 18 23\n"
+                        "parameter = lightingPowerDensityOccupied uniform 5 20\n");
+  SweepSpec spec = SweepSpec::parse(in);
+
+  // Bills of the same model with known parameters.
+  std::vector<double> truth = { 21.3, 12.5 };
+  MeteredData bills;
+  Calibration(base, spec, MeteredData()).simulate(truth.data(), false, bills.electricity, bills.gas);
+  ASSERT_EQ(12u, bills.periods());
+
+  Calibration calibration(base, spec, bills);
+  ThreadPool pool(4);
+  CalibrationResult result = calibration.run(pool);
+  EXPECT_TRUE(result.compliant);
+  EXPECT_LT(result.electricity.cvrmse, 0.5);
+  EXPECT_LT(result.gas.cvrmse, 0.5);
+  EXPECT_NEAR(truth[0], result.parameters[0], 0.05);
+  EXPECT_NEAR(truth[1], result.parameters[1], 0.1);
+  EXPECT_GT(result.evaluations, 40u);
+
+  std::vector<double> start = { 18, 20 };
+  EXPECT_FALSE(calibration.evaluate(start.data()).compliant);
+
+  std::ostringstream report;
+  calibration.writeReport(result, report);
+  EXPECT_EQ(0u, report.str().find("Parameter,Value\nheatingSetpointOccupied,"));
+  EXPECT_NE(std::string::npos, report.str().find("\nGas,"));
+}
+
+TEST_F(ISOModelFixture, HourlyCalibrationTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  std::istringstream in("engine = hourly\n"
+                        "population = 8\n"
+                        "generations = 12\n"
+                        "parameter = heatingSetpointOccupied uniform 18 23\n");
+  SweepSpec spec = SweepSpec::parse(in);
+  std::vector<double> truth = { 20.4 };
+  MeteredData readings;
+  Calibration(base, spec, MeteredData()).simulate(truth.data(), true, readings.electricity, readings.gas);
+  ASSERT_TRUE(readings.hourly());
+  readings.gas.clear();
+
+  ThreadPool pool(4);
+  CalibrationResult result = Calibration(base, spec, readings).run(pool);
+  EXPECT_TRUE(result.compliant);
+  EXPECT_EQ(8760u, result.electricity.points);
+  EXPECT_EQ(0u, result.gas.points);
+
+  spec.engine = MONTHLY_ENGINE;
+  EXPECT_THROW(Calibration(base, spec, readings), std::invalid_argument);
+}
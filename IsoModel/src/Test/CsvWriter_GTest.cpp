@@ -0,0 +1,131 @@
+/*
+ * CsvWriter_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../CsvWriter.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+std::string format(double value, int precision = CsvWriter::SHORTEST)
+{
+  char text[CsvWriter::MAX_DOUBLE_LENGTH];
+  return std::string(text, CsvWriter::formatDouble(value, precision, text));
+}
+
+std::string printed(double value, int precision)
+{
+  char text[64];
+  std::snprintf(text, sizeof(text), "%.*g", precision, value);
+  return text;
+}
+
+}
+
+TEST_F(ISOModelFixture, CsvWriterFormatTests)
+{
+  EXPECT_EQ("0", format(0.0));
+  EXPECT_EQ("-0", format(-0.0));
+  EXPECT_EQ("0.1", format(0.1));
+  EXPECT_EQ("-1.5", format(-1.5));
+  EXPECT_EQ("100", format(100));
+  EXPECT_EQ("0.0001", format(1e-4));
+  EXPECT_EQ("1e-05", format(1e-5));
+  EXPECT_EQ("0.3333333333333333", format(1.0 / 3));
+  EXPECT_EQ("10000000000000000", format(1e16));
+  EXPECT_EQ("1e+17", format(1e17));
+  EXPECT_EQ("5e-324", format(std::numeric_limits<double>::denorm_min()));
+  EXPECT_EQ("1.7976931348623157e+308", format(std::numeric_limits<double>::max()));
+  EXPECT_EQ("nan", format(std::numeric_limits<double>::quiet_NaN()));
+  EXPECT_EQ("-inf", format(-std::numeric_limits<double>::infinity()));
+
+  // With a precision, the digits are rounded as by printf.
+  EXPECT_EQ("10", format(9.9996, 4));
+  EXPECT_EQ("1e+06", format(999999.7, 6));
+  EXPECT_EQ("745", format(745.05, 4)); // Slightly below 745.05.
+
+  std::mt19937_64 random(7);
+  for (int i = 0; i < 200000; i++) {
+    double value;
+    if (i % 2 == 0) {
+      uint64_t bits = random();
+      std::memcpy(&value, &bits, sizeof(value));
+      if (!(value - value == 0)) {
+        continue; // Not finite.
+      }
+    } else {
+      value = (double) (random() % 1000000) / 100;
+    }
+    std::string text = format(value);
+    ASSERT_EQ(value, std::strtod(text.c_str(), nullptr)) << text;
+    ASSERT_LE(text.size(), printed(value, 17).size()) << text;
+    // Up to 15 digits, which always identify a double, as printf; above, never longer
+    // than the shortest digits.
+    int precision = 1 + i % 15;
+    ASSERT_EQ(printed(value, precision), format(value, precision)) << value;
+    EXPECT_EQ(text, format(value, 17));
+  }
+}
+
+TEST_F(ISOModelFixture, CsvWriterTests)
+{
+  std::ostringstream out;
+  {
+    // A buffer smaller than the text is drained as it fills.
+    CsvWriter writer(out, CsvWriter::SHORTEST, 16);
+    writer.write("Title:\n");
+    writer.field(std::string("a")).field(std::string("b")).endRow();
+    writer.setSeparator(", ");
+    for (int row = 0; row < 20; row++) {
+      writer.field(row - 1).field(row * 0.25).endRow();
+    }
+    writer.setPrecision(3);
+    writer.write("| ").field(2.0 / 3).field(12345.0).write(" |").endRow();
+    EXPECT_THROW(writer.setPrecision(18), std::invalid_argument);
+  }
+  std::istringstream in(out.str());
+  std::string line;
+  std::getline(in, line);
+  EXPECT_EQ("Title:", line);
+  std::getline(in, line);
+  EXPECT_EQ("a,b", line);
+  std::getline(in, line);
+  EXPECT_EQ("-1, 0", line);
+  for (int row = 1; row < 19; row++) {
+    std::getline(in, line);
+  }
+  std::getline(in, line);
+  EXPECT_EQ("18, 4.75", line);
+  std::getline(in, line);
+  EXPECT_EQ("| 0.667, 1.23e+04 |", line);
+  EXPECT_FALSE(std::getline(in, line));
+
+  std::string file = test_data_path + "/csv_writer_test.csv";
+  {
+    CsvWriter writer(file, 6);
+    writer.field(1).field(0.1 + 0.2).endRow();
+    writer.flush();
+  }
+  std::ifstream written(file.c_str());
+  std::getline(written, line);
+  EXPECT_EQ("1,0.3", line);
+  written.close();
+  boost::filesystem::remove(file);
+
+  EXPECT_THROW(CsvWriter(test_data_path + "/missing/directory/out.csv"), std::invalid_argument);
+}
@@ -0,0 +1,107 @@
+/*
+ * EpwData_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../UserModel.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, CompactWeatherStorage)
+{
+  EpwData full;
+  full.loadData(test_data_path + "/ORD.epw");
+  EpwData compact;
+  compact.setCompactStorage(true);
+  compact.loadData(test_data_path + "/ORD.epw");
+
+  EXPECT_EQ(8760, compact.rows());
+  EXPECT_GE(full.memoryUsage(), 4 * compact.memoryUsage());
+
+  // Every decoded value must be within the documented error of its column.
+  std::vector<std::vector<double> > expected = full.data();
+  std::vector<std::vector<double> > decoded = compact.data();
+  for (int c = 0; c < 7; c++) {
+    EXPECT_LE(EpwData::quantizationError(c), 0.1);
+    for (int r = 0; r < 8760; r++) {
+      ASSERT_NEAR(expected[c][r], decoded[c][r], EpwData::quantizationError(c) + 1e-9) << "Column = " << c << ", Row = " << r;
+    }
+  }
+
+  // Switching modes after loading round trips through the packed form.
+  full.setCompactStorage(true);
+  EXPECT_EQ(compact.memoryUsage(), full.memoryUsage());
+  full.setCompactStorage(false);
+  EXPECT_NEAR(expected[EGH][4000], full.value(EGH, 4000), EpwData::quantizationError(EGH));
+}
+
+TEST_F(ISOModelFixture, CompactWeatherSimulationResults)
+{
+  UserModel reference;
+  reference.load(test_data_path + "/SmallOffice_v2.ism");
+  UserModel compact;
+  compact.setCompactWeather(true);
+  compact.load(test_data_path + "/SmallOffice_v2.ism");
+  EXPECT_TRUE(compact.epwData()->compactStorage());
+
+  auto monthlyExpected = reference.toMonthlyModel().simulate();
+  auto monthly = compact.toMonthlyModel().simulate();
+  auto hourlyExpected = reference.toHourlyModel().simulate(true);
+  auto hourly = compact.toHourlyModel().simulate(true);
+
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      EXPECT_NEAR(monthlyExpected[i].getEndUse(j), monthly[i].getEndUse(j), 0.001) << "Month = " << i << ", End Use = " << endUseNames[j];
+      EXPECT_NEAR(hourlyExpected[i].getEndUse(j), hourly[i].getEndUse(j), 0.001) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+      auto fuel = isoResultsEndUseTypes[j].first;
+      auto category = isoResultsEndUseTypes[j].second;
+      EXPECT_NEAR(monthlyExpected[i].getEndUse(fuel, category), monthly[i].getEndUse(fuel, category), 0.001);
+      EXPECT_NEAR(hourlyExpected[i].getEndUse(fuel, category), hourly[i].getEndUse(fuel, category), 0.001);
+#endif
+    }
+  }
+}
+
+TEST_F(ISOModelFixture, WeatherFingerprint)
+{
+  EpwData full;
+  full.loadData(test_data_path + "/ORD.epw");
+  EpwData compact;
+  compact.setCompactStorage(true);
+  compact.loadData(test_data_path + "/ORD.epw");
+  ContentHash fullHash = full.fingerprint();
+  ContentHash compactHash = compact.fingerprint();
+  EXPECT_NE(fullHash, compactHash);
+
+  // A change of the data is picked up by the next fingerprint, also when the change is
+  // made while other threads compute fingerprints.
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        full.fingerprint();
+      }
+    });
+  }
+  for (int i = 0; i < 21; i++) {
+    full.setCompactStorage(i % 2 == 0);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(compactHash, full.fingerprint());
+  // Unpacking keeps the quantized values, so the data no longer matches the file.
+  full.setCompactStorage(false);
+  EXPECT_NE(fullHash, full.fingerprint());
+  EXPECT_NE(compactHash, full.fingerprint());
+}
@@ -0,0 +1,166 @@
+/*
+ * HourlyAggregator_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../HourlyAggregator.hpp"
+#include "../TimeFrame.hpp"
+#include "../UserModel.hpp"
+
+#include <algorithm>
+#include <functional>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// The series of the aggregator from the hourly results.
+std::vector<std::vector<double> > seriesOf(const std::vector<openstudio::EndUses>& hourly)
+{
+  std::vector<std::vector<double> > series(AGGREGATE_SERIES, std::vector<double>(hourly.size()));
+  for (size_t hour = 0; hour < hourly.size(); hour++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      double value = endUseValue(hourly[hour], endUse);
+      series[endUse][hour] = value;
+      series[endUse < 9 ? ELECTRICITY_SERIES : GAS_SERIES][hour] += value;
+    }
+  }
+  return series;
+}
+
+}
+
+TEST_F(ISOModelFixture, LoadHistogramTests)
+{
+  EXPECT_THROW(LoadHistogram(3), std::invalid_argument);
+  EXPECT_THROW(LoadHistogram(0), std::invalid_argument);
+
+  LoadHistogram histogram(8);
+  histogram.add(0);
+  histogram.add(-1);
+  EXPECT_EQ(0, histogram.binWidth());
+  EXPECT_EQ(2u, histogram.counts()[0]);
+
+  // 3 / 8 sets the width to 0.5, 9 doubles it twice.
+  histogram.add(3);
+  EXPECT_EQ(0.5, histogram.binWidth());
+  histogram.add(1);
+  histogram.add(9);
+  EXPECT_EQ(2, histogram.binWidth());
+  EXPECT_EQ(5u, histogram.count());
+  EXPECT_EQ(9, histogram.max());
+  EXPECT_EQ((std::vector<size_t>{ 3, 1, 0, 0, 1, 0, 0, 0 }), histogram.counts());
+  EXPECT_EQ(5u, histogram.hoursAtOrAbove(0));
+  EXPECT_EQ(2u, histogram.hoursAtOrAbove(2));
+  EXPECT_EQ(1u, histogram.hoursAtOrAbove(4));
+  EXPECT_EQ(0u, histogram.hoursAtOrAbove(10));
+  EXPECT_EQ(8, histogram.loadExceeded(1));
+  EXPECT_EQ(2, histogram.loadExceeded(2));
+  EXPECT_EQ(0, histogram.loadExceeded(3));
+
+  auto curve = histogram.durationCurve();
+  ASSERT_EQ(5u, curve.size());
+  EXPECT_EQ(8, curve[0].load);
+  EXPECT_EQ(1u, curve[0].hours);
+  EXPECT_EQ(0, curve[4].load);
+  EXPECT_EQ(5u, curve[4].hours);
+}
+
+TEST_F(ISOModelFixture, HourlyAggregatorTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  HourlyModel hourlyModel = model.toHourlyModel();
+  auto series = seriesOf(hourlyModel.simulate(false));
+  HourlyPlan plan = hourlyModel.plan();
+  TimeFrame frame;
+
+  HourlyAggregator aggregator;
+  hourlyModel.aggregate(aggregator);
+  EXPECT_EQ((size_t) TIMESLICES, aggregator.hours());
+
+  for (int period = 0; period < CALENDAR_PERIODS; period++) {
+    int count = HourlyAggregator::periodCount((CalendarPeriod) period);
+    std::vector<double> sums(count * AGGREGATE_SERIES);
+    std::vector<double> occupied(count * AGGREGATE_SERIES);
+    for (int hour = 0; hour < TIMESLICES; hour++) {
+      int index = HourlyAggregator::periodOf((CalendarPeriod) period, hour);
+      ASSERT_LT(index, count);
+      bool isOccupied = plan.occupied[frame.Hour[hour]][frame.DayOfWeek[hour]];
+      for (int s = 0; s < AGGREGATE_SERIES; s++) {
+        sums[index * AGGREGATE_SERIES + s] += series[s][hour];
+        if (isOccupied) {
+          occupied[index * AGGREGATE_SERIES + s] += series[s][hour];
+        }
+      }
+    }
+    for (int index = 0; index < count; index++) {
+      for (int s = 0; s < AGGREGATE_SERIES; s++) {
+        double expected = sums[index * AGGREGATE_SERIES + s];
+        EXPECT_NEAR(expected, aggregator.sum((CalendarPeriod) period, index, s), 1e-9 * (1 + expected));
+        expected = occupied[index * AGGREGATE_SERIES + s];
+        EXPECT_NEAR(expected, aggregator.occupiedSum((CalendarPeriod) period, index, s), 1e-9 * (1 + expected));
+      }
+    }
+  }
+  // The first week is January 1-7, the last one December 31, and winter holds December.
+  EXPECT_EQ(0, HourlyAggregator::periodOf(CALENDAR_WEEK, 7 * 24 - 1));
+  EXPECT_EQ(52, HourlyAggregator::periodOf(CALENDAR_WEEK, TIMESLICES - 1));
+  EXPECT_EQ(0, HourlyAggregator::periodOf(CALENDAR_SEASON, TIMESLICES - 1));
+  EXPECT_EQ(2, HourlyAggregator::periodOf(CALENDAR_SEASON, 24 * 200));
+  EXPECT_GT(aggregator.unoccupiedSum(CALENDAR_MONTH, 0, ELECTRICITY_SERIES), 0);
+
+  for (int s = 0; s < AGGREGATE_SERIES; s++) {
+    const std::vector<double>& values = series[s];
+    for (int month = 0; month < 12; month++) {
+      int expectedHour = -1;
+      for (int hour = 0; hour < TIMESLICES; hour++) {
+        if (frame.Month[hour] == month + 1 && (expectedHour < 0 || values[hour] > values[expectedHour])) {
+          expectedHour = hour;
+        }
+      }
+      const CalendarPeak& peak = aggregator.peak(month, s);
+      EXPECT_EQ(expectedHour, peak.hourOfYear) << endUseName(std::min(s, END_USE_COUNT - 1)) << " " << month;
+      EXPECT_EQ(values[expectedHour], peak.value);
+      EXPECT_EQ(month + 1, peak.month);
+      EXPECT_EQ(frame.DayOfMonth[expectedHour], peak.dayOfMonth);
+      EXPECT_EQ(frame.Hour[expectedHour], peak.hour);
+    }
+    EXPECT_EQ(*std::max_element(values.begin(), values.end()), aggregator.annualPeak(s).value);
+
+    // The duration curve is exact at the bin edges.
+    const LoadHistogram& histogram = aggregator.loadDuration(s);
+    EXPECT_EQ((size_t) TIMESLICES, histogram.count());
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end(), std::greater<double>());
+    for (const auto& point : histogram.durationCurve()) {
+      if (point.load > 0) {
+        EXPECT_EQ((size_t) std::count_if(values.begin(), values.end(), [&](double v) { return v >= point.load; }), point.hours);
+      }
+    }
+    for (size_t hours : { 1, 100, 2000, 8760 }) {
+      double load = histogram.loadExceeded(hours);
+      EXPECT_LE(load, sorted[hours - 1]);
+      if (sorted[hours - 1] > 0) {
+        EXPECT_GT(load + histogram.binWidth(), sorted[hours - 1]);
+      }
+    }
+  }
+
+  // The compiled plan aggregates the same, and a disabled reducer is refused.
+  AggregationOptions options;
+  options.periods[CALENDAR_DAY] = false;
+  options.occupancy = false;
+  options.durationBins = 0;
+  HourlyAggregator reduced(options);
+  model.compile()->aggregateHourly(reduced);
+  EXPECT_EQ(aggregator.sum(CALENDAR_SEASON, 1, GAS_SERIES), reduced.sum(CALENDAR_SEASON, 1, GAS_SERIES));
+  EXPECT_EQ(aggregator.peak(6, ELECTRICITY_SERIES).hourOfYear, reduced.peak(6, ELECTRICITY_SERIES).hourOfYear);
+  EXPECT_THROW(reduced.sum(CALENDAR_DAY, 0, 0), std::invalid_argument);
+  EXPECT_THROW(reduced.occupiedSum(CALENDAR_MONTH, 0, 0), std::invalid_argument);
+  EXPECT_THROW(reduced.loadDuration(0), std::invalid_argument);
+  EXPECT_THROW(aggregator.sum(CALENDAR_MONTH, 12, 0), std::invalid_argument);
+}
@@ -13,6 +13,8 @@
 #include "../UserModel.hpp"
 #include "../ISOResults.hpp"
 
+#include <thread>
+
 using namespace openstudio::isomodel;
 
 TEST_F(ISOModelFixture, HourlyModelTests)
@@ -55,3 +57,53 @@ TEST_F(ISOModelFixture, HourlyModelTests)
     }
   }
 }
+
+TEST_F(ISOModelFixture, HourlyModelConcurrentSimulationTests)
+{
+  openstudio::isomodel::UserModel userModel;
+  userModel.load(test_data_path + "/SmallOffice_v2.ism");
+  const HourlyModel hourlyModel = userModel.toHourlyModel();
+
+  // Repeated runs, with or without a reused workspace, give identical results.
+  auto expected = hourlyModel.simulate();
+  HourlyWorkspace workspace;
+  auto monthlyExpected = hourlyModel.simulate(workspace, true);
+  auto hourly = hourlyModel.simulate(workspace);
+  ASSERT_EQ(8760u, hourly.size());
+  ASSERT_EQ(12u, monthlyExpected.size());
+
+  // Run the same model on many threads at once.
+  const int threadCount = 32;
+  std::vector<std::vector<openstudio::EndUses> > results(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(std::thread([&, t]() {
+      results[t] = (t % 2 == 0) ? hourlyModel.simulate() : hourlyModel.simulate(true);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < threadCount; t++) {
+    auto& reference = (t % 2 == 0) ? expected : monthlyExpected;
+    ASSERT_EQ(reference.size(), results[t].size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+      for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+        ASSERT_EQ(reference[i].getEndUse(j), results[t][i].getEndUse(j)) << "Thread = " << t << ", Step = " << i << ", End Use = " << endUseNames[j];
+        if (t == 0) {
+          ASSERT_EQ(expected[i].getEndUse(j), hourly[i].getEndUse(j));
+        }
+#else
+        auto fuel = isoResultsEndUseTypes[j].first;
+        auto category = isoResultsEndUseTypes[j].second;
+        ASSERT_EQ(reference[i].getEndUse(fuel, category), results[t][i].getEndUse(fuel, category));
+        if (t == 0) {
+          ASSERT_EQ(expected[i].getEndUse(fuel, category), hourly[i].getEndUse(fuel, category));
+        }
+#endif
+      }
+    }
+  }
+}
@@ -1,6 +1,16 @@
 #include "../UserModel.hpp"
+#include "../CsvWriter.hpp"
+#include "../HourlyAggregator.hpp"
+#include "../ResultCache.hpp"
+#include "../ResultFile.hpp"
+#include "../Surrogate.hpp"
+#include "../UtilityAccounting.hpp"
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 using namespace openstudio::isomodel;
 
@@ -82,6 +92,226 @@ int main(int argc, char** argv)
     monthlyTime = std::chrono::duration<double, std::micro>(monthDiff).count() / iterations;
     std::cout << "Monthly simulation including modifying properties ran in " << monthlyTime << " us, average over " << iterations << " loops." << std::endl;
 
+    std::cout << "Benchmark: Parsing the .ism and defaults files into Properties and reading every property.\n";
+
+    int propertyIterations = iterations / 10;
+    std::string ismFile = test_data_path + "/SmallOffice_v2.ism";
+    std::string defaultsFile = test_data_path + "/defaults_test_defaults.ism";
+    std::vector<double> vec;
+    size_t found = 0;
+    auto propsStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != propertyIterations; ++i) {
+      Properties props(ismFile, defaultsFile);
+      for (auto key = props.keys_begin(); key != props.keys_end(); ++key) {
+        if (props.getPropertyAsDouble(*key)) {
+          ++found;
+        }
+        if (props.getPropertyAsDoubleVector(*key, vec)) {
+          ++found;
+        }
+      }
+    }
+    auto propsEnd = std::chrono::steady_clock::now();
+    double propsTime = std::chrono::duration<double, std::micro>(propsEnd - propsStart).count() / propertyIterations;
+    std::cout << "Properties parse and lookup ran in " << propsTime << " us, average over " << propertyIterations << " loops (" << found << " values)." << std::endl;
+
+    Properties props(ismFile, defaultsFile);
+    std::vector<std::string> keys(props.keys_begin(), props.keys_end());
+    propsStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != iterations; ++i) {
+      for (const auto& key : keys) {
+        if (props.getPropertyAsDouble(key)) {
+          ++found;
+        }
+      }
+    }
+    propsEnd = std::chrono::steady_clock::now();
+    propsTime = std::chrono::duration<double, std::nano>(propsEnd - propsStart).count() / (double(iterations) * keys.size());
+    std::cout << "Cached getPropertyAsDouble ran in " << propsTime << " ns per lookup, average over " << iterations * keys.size() << " lookups." << std::endl;
+
+    std::cout << "Benchmark: Monthly simulation answered from the result cache (key hashing and lookup).\n";
+
+    UserModel cachedModel = userModel;
+    cachedModel.setResultCache(std::make_shared<ResultCache>());
+    MonthlyModel cachedMonthlyModel = cachedModel.toMonthlyModel();
+    cachedMonthlyModel.simulate();
+    auto cacheStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != iterations; ++i) {
+      auto monthlyResults = cachedMonthlyModel.simulate();
+    }
+    auto cacheEnd = std::chrono::steady_clock::now();
+    double cacheTime = std::chrono::duration<double, std::micro>(cacheEnd - cacheStart).count() / iterations;
+    std::cout << "Cached monthly simulation ran in " << cacheTime << " us, average over " << iterations << " loops." << std::endl;
+
+    std::cout << "Benchmark: Evaluating a degree 3 surrogate of four parameters.\n";
+
+    std::istringstream spec("design = sobol\nsamples = 128\n"
+                            "parameter = heatingSetpointOccupied uniform 18 24\n"
+                            "parameter = coolingSetpointOccupied uniform 23 28\n"
+                            "parameter = lightingPowerDensityOccupied uniform 5 15\n"
+                            "parameter = infiltrationRateOccupied uniform 0.5 2\n");
+    ThreadPool pool;
+    Surrogate surrogate = Surrogate::train(userModel, SweepSpec::parse(spec), pool);
+    double parameters[] = { 21, 25, 10, 1 };
+    double endUses[END_USE_COUNT];
+    double checksum = 0;
+    int surrogateIterations = iterations * 10;
+    auto surrogateStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != surrogateIterations; ++i) {
+      parameters[2] = 5 + (i % 100) * 0.1;
+      surrogate.evaluate(parameters, endUses);
+      for (double value : endUses) {
+        checksum += value;
+      }
+    }
+    auto surrogateEnd = std::chrono::steady_clock::now();
+    double surrogateTime = std::chrono::duration<double, std::micro>(surrogateEnd - surrogateStart).count() / surrogateIterations;
+    std::cout << "Surrogate evaluation of " << surrogate.termCount() << " terms ran in " << surrogateTime << " us, average over "
+              << surrogateIterations << " loops (EUI RMSE " << surrogate.validation().back().rmse << " kWh/m2, checksum " << checksum << ")." << std::endl;
+
+    std::cout << "Benchmark: Writing the hourly results as CSV, with a stream operation per value and a flush per row and with CsvWriter.\n";
+
+    auto hourlyResults = userModel.toHourlyModel().simulate(false);
+    std::string csvFile = test_data_path + "/benchmark_hourly.csv";
+    int csvIterations = 10;
+    auto streamStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != csvIterations; ++i) {
+      std::ofstream out(csvFile.c_str());
+      for (size_t hour = 0; hour < hourlyResults.size(); ++hour) {
+        out << hour + 1;
+        for (int endUse = 0; endUse < END_USE_COUNT; ++endUse) {
+          out << ", " << hourlyResults[hour].getEndUse(endUse);
+        }
+        out << std::endl;
+      }
+    }
+    auto streamEnd = std::chrono::steady_clock::now();
+    double streamTime = std::chrono::duration<double, std::milli>(streamEnd - streamStart).count() / csvIterations;
+    auto writerStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != csvIterations; ++i) {
+      CsvWriter out(csvFile);
+      out.setSeparator(", ");
+      for (size_t hour = 0; hour < hourlyResults.size(); ++hour) {
+        out.field((int) hour + 1);
+        for (int endUse = 0; endUse < END_USE_COUNT; ++endUse) {
+          out.field(hourlyResults[hour].getEndUse(endUse));
+        }
+        out.endRow();
+      }
+    }
+    auto writerEnd = std::chrono::steady_clock::now();
+    double writerTime = std::chrono::duration<double, std::milli>(writerEnd - writerStart).count() / csvIterations;
+    size_t csvBytes = (size_t) std::ifstream(csvFile.c_str(), std::ios::binary | std::ios::ate).tellg();
+    std::remove(csvFile.c_str());
+    std::cout << "Hourly CSV written in " << streamTime << " ms with streams (6 digits) and in " << writerTime
+              << " ms with CsvWriter (shortest round trip digits), " << streamTime / writerTime << " times faster, average over "
+              << csvIterations << " loops." << std::endl;
+
+    std::cout << "Benchmark: Appending the hourly results of 100 buildings to a compressed binary result file from the thread pool.\n";
+
+    std::string resultFile = test_data_path + "/benchmark_hourly.icr";
+    auto resultStart = std::chrono::steady_clock::now();
+    {
+      ResultFileWriter writer(resultFile, hourlyResults.size());
+      pool.parallelFor(100, [&](size_t i) {
+        ResultFileBuilding building;
+        building.id = std::to_string(i);
+        writer.append(building, hourlyResults);
+      });
+    }
+    auto resultEnd = std::chrono::steady_clock::now();
+    double resultTime = std::chrono::duration<double, std::milli>(resultEnd - resultStart).count() / 100;
+    size_t resultBytes = (size_t) std::ifstream(resultFile.c_str(), std::ios::binary | std::ios::ate).tellg() / 100;
+    resultStart = std::chrono::steady_clock::now();
+    double resultChecksum = 0;
+    {
+      ResultFileReader reader(resultFile);
+      for (size_t i = 0; i < reader.size(); i++) {
+        resultChecksum += endUseValue(reader.results(i)[4000], 2);
+      }
+    }
+    resultEnd = std::chrono::steady_clock::now();
+    double readTime = std::chrono::duration<double, std::milli>(resultEnd - resultStart).count() / 100;
+    std::remove(resultFile.c_str());
+    std::cout << "Binary results written in " << resultTime << " ms and read in " << readTime << " ms per building, " << resultBytes
+              << " bytes per building against " << csvBytes << " bytes of CSV (checksum " << resultChecksum << ")." << std::endl;
+
+    std::cout << "Benchmark: Daily sums, monthly peaks and load duration curves, from the hourly results and inside the simulation.\n";
+
+    HourlyModel aggregatedModel = userModel.toHourlyModel();
+    int aggregateIterations = 50;
+    double aggregateChecksum = 0;
+    auto postStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != aggregateIterations; ++i) {
+      auto hourly = aggregatedModel.simulate(false);
+      std::vector<double> daily(365 * END_USE_COUNT, 0.0);
+      std::vector<double> peaks(12 * END_USE_COUNT, 0.0);
+      std::vector<double> loads(hourly.size());
+      for (int endUse = 0; endUse < END_USE_COUNT; ++endUse) {
+        for (size_t hour = 0; hour < hourly.size(); ++hour) {
+          double value = hourly[hour].getEndUse(endUse);
+          daily[HourlyAggregator::periodOf(CALENDAR_DAY, (int) hour) * END_USE_COUNT + endUse] += value;
+          double& peak = peaks[HourlyAggregator::periodOf(CALENDAR_MONTH, (int) hour) * END_USE_COUNT + endUse];
+          peak = std::max(peak, value);
+          loads[hour] = value;
+        }
+        std::sort(loads.begin(), loads.end());
+        aggregateChecksum += loads[loads.size() - 100];
+      }
+      aggregateChecksum += daily[100 * END_USE_COUNT + 2] + peaks[6 * END_USE_COUNT + 1];
+    }
+    auto postEnd = std::chrono::steady_clock::now();
+    double postTime = std::chrono::duration<double, std::milli>(postEnd - postStart).count() / aggregateIterations;
+    AggregationOptions aggregateOptions;
+    aggregateOptions.periods[CALENDAR_WEEK] = false;
+    aggregateOptions.periods[CALENDAR_SEASON] = false;
+    aggregateOptions.occupancy = false;
+    HourlyAggregator aggregator(aggregateOptions);
+    auto inLoopStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != aggregateIterations; ++i) {
+      aggregatedModel.aggregate(aggregator);
+      for (int endUse = 0; endUse < END_USE_COUNT; ++endUse) {
+        aggregateChecksum -= aggregator.loadDuration(endUse).loadExceeded(100);
+      }
+      aggregateChecksum -= aggregator.sum(CALENDAR_DAY, 100, 2) + aggregator.peak(6, 1).value;
+    }
+    auto inLoopEnd = std::chrono::steady_clock::now();
+    double inLoopTime = std::chrono::duration<double, std::milli>(inLoopEnd - inLoopStart).count() / aggregateIterations;
+    std::cout << "Aggregations computed in " << postTime << " ms from the 8760 hourly results and in " << inLoopTime
+              << " ms inside the simulation, " << postTime / inLoopTime << " times faster, average over " << aggregateIterations
+              << " loops (checksum " << aggregateChecksum << ")." << std::endl;
+
+    std::cout << "Benchmark: Monthly utility cost and emissions of the hourly results under a time of use tariff with demand charges.\n";
+
+    std::istringstream tariffText("fixed = 25\n"
+                                  "period = peak, 6-9, 1-5, 12-17\n"
+                                  "period = off-peak, 1-12, 0-6, 0-23\n"
+                                  "energy = peak, 0.22, 1000\n"
+                                  "energy = peak, 0.25\n"
+                                  "energy = off-peak, 0.08\n"
+                                  "demand = 12.5\n"
+                                  "demand = 8, peak\n");
+    EmissionFactors emissionFactors(0.4, 0.18);
+    UtilityAccounting accounting(Tariff::parse(tariffText), Tariff(), emissionFactors);
+    std::vector<const double*> billColumns;
+    std::vector<std::vector<double> > billValues(END_USE_COUNT, std::vector<double>(hourlyResults.size()));
+    for (int endUse = 0; endUse < END_USE_COUNT; ++endUse) {
+      for (size_t hour = 0; hour < hourlyResults.size(); ++hour) {
+        billValues[endUse][hour] = endUseValue(hourlyResults[hour], endUse);
+      }
+      billColumns.push_back(billValues[endUse].data());
+    }
+    int billIterations = 1000;
+    double billChecksum = 0;
+    auto billStart = std::chrono::steady_clock::now();
+    for (int i = 0; i != billIterations; ++i) {
+      billChecksum += accounting.evaluate(billColumns.data(), 1000 + i).annualCost();
+    }
+    auto billEnd = std::chrono::steady_clock::now();
+    double billTime = std::chrono::duration<double, std::micro>(billEnd - billStart).count() / billIterations;
+    std::cout << "Utility bill evaluated in " << billTime << " us per building, average over " << billIterations
+              << " loops (checksum " << billChecksum << ")." << std::endl;
+
     std::cout << "Benchmarking monthly simulation with reloading the ism file each run (weather is cached).\n";
 
     std::cout << "Done!" << std::endl;
@@ -0,0 +1,130 @@
+/*
+ * MonteCarlo_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../MonteCarlo.hpp"
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, RunningStatsTests)
+{
+  std::mt19937_64 random(3);
+  std::normal_distribution<double> normal(1e6, 2);
+  std::vector<double> values;
+  RunningStats all;
+  RunningStats first;
+  RunningStats second;
+  for (int i = 0; i < 1000; i++) {
+    values.push_back(normal(random));
+    all.add(values.back());
+    (i < 300 ? first : second).add(values.back());
+  }
+
+  // Two pass reference; the large offset defeats the naive sum of squares.
+  double mean = 0;
+  for (double value : values) {
+    mean += value;
+  }
+  mean /= values.size();
+  double squares = 0;
+  for (double value : values) {
+    squares += (value - mean) * (value - mean);
+  }
+  EXPECT_NEAR(mean, all.mean(), 1e-8);
+  EXPECT_NEAR(squares / (values.size() - 1), all.variance(), 1e-8);
+
+  first.merge(second);
+  EXPECT_EQ(1000u, first.count());
+  EXPECT_NEAR(all.mean(), first.mean(), 1e-8);
+  EXPECT_NEAR(all.variance(), first.variance(), 1e-8);
+  EXPECT_EQ(all.min(), first.min());
+  EXPECT_EQ(all.max(), first.max());
+}
+
+TEST_F(ISOModelFixture, TDigestTests)
+{
+  TDigest digest(100);
+  TDigest left(100);
+  TDigest right(100);
+  std::mt19937_64 random(5);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  for (int i = 0; i < 100000; i++) {
+    double value = uniform(random);
+    digest.add(value);
+    (i % 2 ? left : right).add(value);
+  }
+  EXPECT_EQ(100000, digest.count());
+  EXPECT_LE(digest.centroidCount(), 100u);
+
+  double quantiles[] = { 0.001, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 0.999 };
+  left.merge(right);
+  for (double q : quantiles) {
+    EXPECT_NEAR(q, digest.quantile(q), 0.005) << "Quantile = " << q;
+    EXPECT_NEAR(q, left.quantile(q), 0.005) << "Quantile = " << q;
+  }
+  // The tails are much more accurate than the middle.
+  EXPECT_NEAR(0.01, digest.quantile(0.01), 0.001);
+  EXPECT_NEAR(0.99, digest.quantile(0.99), 0.001);
+
+  TDigest empty;
+  EXPECT_TRUE(std::isnan(empty.quantile(0.5)));
+  empty.add(7);
+  EXPECT_EQ(7, empty.quantile(0.5));
+}
+
+TEST_F(ISOModelFixture, MonteCarloTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  std::istringstream in("samples = 2000\n"
+                        "batch = 50\n"
+                        "minsamples = 100\n"
+                        "tolerance = 0.01\n"
+                        "seed = 11\n"
+                        "parameter = heatingSetpointOccupied normal 20 0.5\n"
+                        "parameter = infiltrationRateOccupied uniform 5 10\n");
+  SweepSpec spec = SweepSpec::parse(in);
+
+  ThreadPool pool(4);
+  MonteCarlo analysis(base, spec);
+  EXPECT_TRUE(analysis.run(pool));
+  EXPECT_LT(analysis.samples(), 2000u);
+  EXPECT_EQ(0u, analysis.samples() % 50);
+
+  // GasHeat varies with both parameters and has converged to the tolerance.
+  const int gasHeat = 9;
+  const RunningStats& annual = analysis.stats(gasHeat, MonteCarlo::ANNUAL);
+  EXPECT_EQ(analysis.samples(), annual.count());
+  EXPECT_GT(annual.standardDeviation(), 0);
+  EXPECT_LE(analysis.halfWidth(gasHeat, MonteCarlo::ANNUAL), 0.01 * annual.mean());
+  double monthlySum = 0;
+  for (int month = 0; month < 12; month++) {
+    monthlySum += analysis.stats(gasHeat, month).mean();
+  }
+  EXPECT_NEAR(annual.mean(), monthlySum, 1e-9 * annual.mean());
+  const TDigest& digest = analysis.distribution(gasHeat, MonteCarlo::ANNUAL);
+  EXPECT_LE(annual.min(), digest.quantile(0.05));
+  EXPECT_LT(digest.quantile(0.05), digest.quantile(0.95));
+  EXPECT_LE(digest.quantile(0.95), annual.max());
+
+  // Batches are folded in sample order, so the thread count does not change the results.
+  ThreadPool single(1);
+  MonteCarlo serial(base, spec);
+  serial.run(single);
+  EXPECT_EQ(analysis.samples(), serial.samples());
+  EXPECT_EQ(annual.mean(), serial.stats(gasHeat, MonteCarlo::ANNUAL).mean());
+  EXPECT_EQ(annual.variance(), serial.stats(gasHeat, MonteCarlo::ANNUAL).variance());
+
+  std::ostringstream csv;
+  analysis.writeCsv(csv);
+  EXPECT_EQ(0u, csv.str().find("EndUse,Period,Samples,Mean,StdDev,Min,P5,P25,P50,P75,P95,Max,HalfWidth\nElecHeat,1,"));
+}
@@ -12,6 +12,8 @@
 #include "../Properties.hpp"
 #include "../UserModel.hpp"
 
+#include <cmath>
+
 using namespace openstudio::isomodel;
 
 TEST_F(ISOModelFixture, MonthlyModelTests)
@@ -54,3 +56,78 @@ TEST_F(ISOModelFixture, MonthlyModelTests)
     }
   }
 }
+
+TEST_F(ISOModelFixture, MonthlyModelRegressionTests)
+{
+  // The results since the solar values are passed to WeatherData at full precision
+  // instead of being printed to text and parsed back, printed with 10 significant digits.
+  // Any change to the code that changes the monthly results by more than their printed
+  // precision fails here, so it is noticed and its size recorded.
+  double expected[12][13] =
+  {
+    { 0, 0.02311659481, 2.72099861, 0.2578224281, 7.478597863, 0.808168172, 2.244567869, 0, 0, 42.5212204, 0, 0, 0 },
+    { 0, 0.0452249249, 2.457676164, 0.1996044604, 6.0533569, 0.6541507472, 2.027351624, 0, 0, 34.36548605, 0, 0, 0 },
+    { 0, 0.1359841326, 2.72099861, 0.1841588772, 4.726183094, 0.5107308644, 2.244567869, 0, 0, 26.6327412, 0, 0, 0 },
+    { 0, 0.341923193, 2.633224461, 0.1782182683, 2.712807731, 0.2931572074, 2.172162454, 0, 0, 14.76745235, 0, 0, 0 },
+    { 0, 1.083672912, 2.72099861, 0.1473271018, 1.409970993, 0.1523672888, 2.244567869, 0, 0, 5.891274163, 0, 0, 0 },
+    { 0, 2.12929859, 2.633224461, 0.1425746146, 0.8372382649, 0.09047542473, 2.172162454, 0, 0, 0.572303656, 0, 0, 0 },
+    { 0, 3.287411253, 2.72099861, 0.1473271018, 1.137370639, 0.1229089687, 2.244567869, 0, 0, 0, 0, 0, 0 },
+    { 0, 1.799181522, 2.72099861, 0.1473271018, 0.6887617583, 0.07443044022, 2.244567869, 0, 0, 0.377282979, 0, 0, 0 },
+    { 0, 0.7586114616, 2.633224461, 0.1782182683, 0.8751197521, 0.09456905469, 2.172162454, 0, 0, 3.487127001, 0, 0, 0 },
+    { 0, 0.1805032382, 2.72099861, 0.2025747649, 2.760490325, 0.2983099854, 2.244567869, 0, 0, 15.35672683, 0, 0, 0 },
+    { 0, 0.04043117518, 2.633224461, 0.2316837487, 4.680146013, 0.5057559073, 2.172162454, 0, 0, 26.55887349, 0, 0, 0 },
+    { 0, 0.01853143392, 2.72099861, 0.2578224281, 7.171445835, 0.7749760552, 2.244567869, 0, 0, 40.78199933, 0, 0, 0 }
+  };
+
+  openstudio::isomodel::UserModel userModel;
+  userModel.load(test_data_path + "/SmallOffice_v2.ism");
+  auto results = userModel.toMonthlyModel().simulate();
+
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      double result = results[i].getEndUse(j);
+#else
+      double result = results[i].getEndUse(isoResultsEndUseTypes[j].first, isoResultsEndUseTypes[j].second);
+#endif
+      EXPECT_NEAR(expected[i][j], result, 1e-9 * std::abs(expected[i][j])) << "Month = " << i << ", End Use = " << endUseNames[j] << "\n";
+    }
+  }
+}
+
+namespace {
+
+double annualCooling(UserModel& model, double shadingDevice)
+{
+  openstudio::Vector windowSDF(9, 0.0);
+  for (size_t i = 0; i < windowSDF.size(); i += 2) {
+    windowSDF[i] = shadingDevice;
+  }
+  model.setWindowSDF(windowSDF);
+  auto results = model.toMonthlyModel().simulate();
+  double cooling = 0;
+  for (auto& month : results) {
+#ifdef ISOMODEL_STANDALONE
+    cooling += month.getEndUse(1);
+#else
+    cooling += month.getEndUse(isoResultsEndUseTypes[1].first, isoResultsEndUseTypes[1].second);
+#endif
+  }
+  return cooling;
+}
+
+}
+
+TEST_F(ISOModelFixture, MonthlyModelShadingDeviceTests)
+{
+  // windowSDF selects a shading reduction factor of 0.5 (1), 0.35 (2) or 1 (3). Any
+  // other value, e.g. the 0 of a facade without windows, means no shading device.
+  openstudio::isomodel::UserModel userModel;
+  userModel.load(test_data_path + "/SmallOffice_v2.ism");
+  double none = annualCooling(userModel, 3);
+  EXPECT_LT(annualCooling(userModel, 2), annualCooling(userModel, 1));
+  EXPECT_LT(annualCooling(userModel, 1), none);
+  EXPECT_EQ(none, annualCooling(userModel, 0));
+  EXPECT_EQ(none, annualCooling(userModel, 4));
+  EXPECT_EQ(none, annualCooling(userModel, -1));
+}
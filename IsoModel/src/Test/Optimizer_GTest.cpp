@@ -0,0 +1,106 @@
+/*
+ * Optimizer_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Optimizer.hpp"
+
+#include <atomic>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, ObjectiveParsingTests)
+{
+  std::vector<std::string> names = { "wallU", "floorArea" };
+  EXPECT_EQ("EUI", Objective::parse("EUI", names).name);
+  EXPECT_EQ("GasHeat", Objective::parse("gasheat", names).name);
+
+  Objective cost = Objective::parse("envelopeCost linear WALLU -100 floorArea 2", names);
+  EXPECT_EQ("envelopeCost", cost.name);
+  double parameters[] = { 0.5, 1000 };
+  EXPECT_DOUBLE_EQ(1950, cost.evaluate(parameters, std::vector<openstudio::EndUses>()));
+
+  EXPECT_THROW(Objective::parse("carbon", names), std::invalid_argument);
+  EXPECT_THROW(Objective::parse("cost linear roofU 3", names), std::invalid_argument);
+  EXPECT_THROW(Objective::parse("cost linear wallU", names), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, Nsga2ParetoFrontTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  // Better walls save heating energy but cost more.
+  std::istringstream in("population = 24\n"
+                        "generations = 15\n"
+                        "seed = 5\n"
+                        "parameter = wallU uniform 0.2 2\n"
+                        "parameter = heatingSetpointOccupied uniform 19 21\n"
+                        "objective = GasHeat\n"
+                        "objective = wallCost linear wallU -10\n");
+  Optimizer optimizer(base, SweepSpec::parse(in));
+  std::atomic<int> calls(0);
+  Objective comfort;
+  comfort.name = "discomfort";
+  comfort.evaluate = [&calls](const double* parameters, const std::vector<openstudio::EndUses>&) {
+    calls++;
+    return 21 - parameters[1];
+  };
+  optimizer.addObjective(comfort);
+
+  ThreadPool pool(4);
+  auto front = optimizer.run(pool);
+  ASSERT_GT(front.size(), 5u);
+  for (size_t p = 0; p < front.size(); p++) {
+    ASSERT_EQ(3u, front[p].objectives.size());
+    EXPECT_GE(front[p].parameters[0], 0.2);
+    EXPECT_LE(front[p].parameters[0], 2);
+    for (size_t q = 0; q < front.size(); q++) {
+      bool dominated = true;
+      bool better = false;
+      for (size_t o = 0; o < 3; o++) {
+        dominated = dominated && front[q].objectives[o] <= front[p].objectives[o];
+        better = better || front[q].objectives[o] < front[p].objectives[o];
+      }
+      EXPECT_FALSE(dominated && better) << "Point " << p << " is dominated by " << q;
+    }
+  }
+
+  const OptimizationStatistics& statistics = optimizer.statistics();
+  EXPECT_EQ(15u, statistics.generations);
+  EXPECT_EQ(24u * 16, statistics.evaluations);
+  EXPECT_EQ(statistics.evaluations - statistics.cacheHits, (size_t) calls.load());
+  EXPECT_GT(statistics.evaluationsPerSecond(), 0);
+
+  std::ostringstream csv;
+  optimizer.writeCsv(front, csv);
+  EXPECT_EQ(0u, csv.str().find("wallU,heatingSetpointOccupied,GasHeat,wallCost,discomfort\n"));
+}
+
+TEST_F(ISOModelFixture, CmaesTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  // Heating energy falls with the setpoint and the wall U value, so the optimum is a corner.
+  std::istringstream in("algorithm = cmaes\n"
+                        "generations = 40\n"
+                        "parameter = heatingSetpointOccupied uniform 18 22\n"
+                        "parameter = wallU uniform 0.2 2\n"
+                        "objective = GasHeat\n");
+  Optimizer optimizer(base, SweepSpec::parse(in));
+  ThreadPool pool(4);
+  auto front = optimizer.run(pool);
+  ASSERT_EQ(1u, front.size());
+  EXPECT_NEAR(18, front[0].parameters[0], 0.05);
+  EXPECT_NEAR(0.2, front[0].parameters[1], 0.01);
+  // Samples beyond the bounds are evaluated at the bounds, so repeats come from the cache.
+  EXPECT_GT(optimizer.statistics().cacheHitRate(), 0);
+
+  std::istringstream unbounded("parameter = wallU normal 1 0.1\n");
+  EXPECT_THROW(Optimizer(base, SweepSpec::parse(unbounded)), std::invalid_argument);
+}
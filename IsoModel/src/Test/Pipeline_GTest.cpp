@@ -0,0 +1,107 @@
+/*
+ * Pipeline_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Pipeline.hpp"
+#include "../UserModel.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// The result rows by building, each with its 12 months of end uses.
+std::map<int, std::vector<std::vector<double> > > readResults(const std::string& csv)
+{
+  std::map<int, std::vector<std::vector<double> > > results;
+  std::istringstream in(csv);
+  std::string line;
+  std::getline(in, line);
+  while (std::getline(in, line)) {
+    std::vector<std::string> fields;
+    std::istringstream row(line);
+    for (std::string field; std::getline(row, field, ',');) {
+      fields.push_back(field);
+    }
+    std::vector<double> values;
+    for (size_t i = 3; i < fields.size(); i++) {
+      values.push_back(std::stod(fields[i]));
+    }
+    results[std::stoi(fields[0])].push_back(values);
+  }
+  return results;
+}
+
+void expectResults(UserModel& model, const std::vector<std::vector<double> >& results)
+{
+  auto expected = model.toMonthlyModel().simulate();
+  ASSERT_EQ(12u, results.size());
+  for (int month = 0; month < 12; month++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      EXPECT_NEAR(endUseValue(expected[month], endUse), results[month][endUse], 1e-7 * (1 + std::abs(results[month][endUse])));
+    }
+  }
+}
+
+}
+
+TEST_F(ISOModelFixture, PipelineTests)
+{
+  std::string listFile = test_data_path + "/pipeline_test.txt";
+  {
+    std::ofstream list(listFile.c_str());
+    list << "# Buildings\n";
+    for (int i = 0; i < 20; i++) {
+      list << (i == 7 ? "missing.ism" : "SmallOffice_v2.ism") << "\n";
+    }
+    list << "defaults_test_building.ism, defaults_test_defaults.ism\n";
+  }
+  std::vector<PipelineJob> jobs = PipelineJob::loadList(listFile);
+  boost::filesystem::remove(listFile);
+  ASSERT_EQ(21u, jobs.size());
+  EXPECT_EQ((boost::filesystem::path(test_data_path) / "defaults_test_defaults.ism").string(), jobs[20].defaultsFile);
+
+  // Small queues and groups exercise the back pressure and the partial groups.
+  PipelineOptions options;
+  options.simulators = 3;
+  options.queueCapacity = 2;
+  options.stationGroup = 3;
+  std::ostringstream out;
+  PipelineReport report = BuildingPipeline(options).run(jobs, out);
+
+  EXPECT_EQ(20u, report.buildings);
+  ASSERT_EQ(1u, report.errors.size());
+  EXPECT_NE(std::string::npos, report.errors[0].find("missing.ism"));
+  EXPECT_EQ(1u, report.stations);
+  ASSERT_EQ(5u, report.stages.size());
+  for (const auto& stage : report.stages) {
+    EXPECT_EQ(21u, stage.items) << stage.name;
+    EXPECT_GE(stage.utilization(report.seconds), 0);
+    EXPECT_LE(stage.utilization(report.seconds), 1.01);
+  }
+  EXPECT_EQ(3u, report.stages[3].workers);
+  EXPECT_FALSE(report.bottleneck().empty());
+  std::ostringstream table;
+  report.write(table);
+  EXPECT_NE(std::string::npos, table.str().find("simulate"));
+
+  auto results = readResults(out.str());
+  ASSERT_EQ(20u, results.size());
+  EXPECT_EQ(0u, results.count(8));
+  UserModel office;
+  office.load(test_data_path + "/SmallOffice_v2.ism");
+  expectResults(office, results[1]);
+  expectResults(office, results[20]);
+  UserModel withDefaults;
+  withDefaults.load(test_data_path + "/defaults_test_building.ism", test_data_path + "/defaults_test_defaults.ism");
+  expectResults(withDefaults, results[21]);
+}
@@ -0,0 +1,201 @@
+/*
+ * Portfolio_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Portfolio.hpp"
+
+#include <fstream>
+#include <iterator>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+void expectSameResults(UserModel& expectedModel, UserModel& model, const std::vector<std::string>& endUseNames)
+{
+  auto expected = expectedModel.toMonthlyModel().simulate();
+  auto results = model.toMonthlyModel().simulate();
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      EXPECT_DOUBLE_EQ(expected[i].getEndUse(j), results[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+      auto fuel = isoResultsEndUseTypes[j].first;
+      auto category = isoResultsEndUseTypes[j].second;
+      EXPECT_DOUBLE_EQ(expected[i].getEndUse(fuel, category), results[i].getEndUse(fuel, category));
+#endif
+    }
+  }
+}
+
+std::string loadError(const std::string& csvFile, const std::string& defaultsFile, const std::string& contents)
+{
+  {
+    std::ofstream file(csvFile.c_str());
+    file << contents;
+  }
+  Portfolio portfolio;
+  try {
+    portfolio.loadCsv(csvFile, defaultsFile);
+  } catch (const std::invalid_argument& e) {
+    boost::filesystem::remove(csvFile);
+    return e.what();
+  }
+  boost::filesystem::remove(csvFile);
+  return std::string();
+}
+
+}
+
+TEST_F(ISOModelFixture, PortfolioCsvTests)
+{
+  Portfolio portfolio;
+  portfolio.setThreadCount(2);
+  portfolio.loadCsv(test_data_path + "/portfolio.csv", test_data_path + "/SmallOffice_v2.ism");
+  ASSERT_EQ(3u, portfolio.size());
+  EXPECT_EQ("office_b", portfolio.id(1));
+  std::vector<std::string> keys = portfolio.keys();
+  ASSERT_EQ(6u, keys.size());
+  EXPECT_EQ("id", keys[0]);
+  EXPECT_EQ("heatingfueltype", keys[2]);
+
+  // Empty cells take the defaults.
+  UserModel reference;
+  reference.load(test_data_path + "/SmallOffice_v2.ism");
+  UserModel first = portfolio.model(0);
+  EXPECT_TRUE(first.valid());
+  expectSameResults(reference, first, endUseNames);
+
+  // Cells override the defaults just as the same properties in an .ism file do.
+  Properties overrides;
+  overrides.putProperty("floorarea", "1500");
+  overrides.putProperty("heatingfueltype", "electric");
+  overrides.putProperty("wallu", "0.5,0.5,0.5,0.5,0.5,0.5,0.5,0.5,0.2");
+  overrides.putProperty("forcedaircooling", "false");
+  bindIsmProperties(reference, overrides, false);
+  UserModel second = portfolio.model(1);
+  EXPECT_DOUBLE_EQ(1500, second.floorArea());
+  EXPECT_FALSE(second.forcedAirCooling());
+  expectSameResults(reference, second, endUseNames);
+
+  // Buildings on the same station share its weather.
+  UserModel third = portfolio.model(2);
+  EXPECT_DOUBLE_EQ(2500.5, third.floorArea());
+  EXPECT_EQ(first.weatherData().get(), third.weatherData().get());
+  EXPECT_EQ(first.epwData().get(), second.epwData().get());
+
+  size_t count = 0;
+  for (auto model : portfolio) {
+    EXPECT_TRUE(model.valid());
+    ++count;
+  }
+  EXPECT_EQ(portfolio.size(), count);
+
+  // The binary form loads the same buildings.
+  std::string binaryFile = test_data_path + "/portfolio_test.bin";
+  portfolio.saveBinary(binaryFile);
+  Portfolio binary;
+  binary.loadBinary(binaryFile, test_data_path + "/SmallOffice_v2.ism");
+  boost::filesystem::remove(binaryFile);
+  ASSERT_EQ(portfolio.size(), binary.size());
+  EXPECT_EQ(portfolio.keys(), binary.keys());
+  for (size_t i = 0; i < portfolio.size(); i++) {
+    EXPECT_EQ(portfolio.id(i), binary.id(i));
+    UserModel expected = portfolio.model(i);
+    UserModel model = binary.model(i);
+    expectSameResults(expected, model, endUseNames);
+  }
+}
+
+TEST_F(ISOModelFixture, PortfolioErrorTests)
+{
+  std::string csvFile = test_data_path + "/portfolio_errors.csv";
+  std::string defaultsFile = test_data_path + "/SmallOffice_v2.ism";
+
+  std::string error = loadError(csvFile, defaultsFile, "id,floorarea\na,100\nb,big\n");
+  EXPECT_NE(std::string::npos, error.find("floorarea")) << error;
+  EXPECT_NE(std::string::npos, error.find("line 3")) << error;
+
+  error = loadError(csvFile, defaultsFile, "id,heatingfueltype\na,coal\n");
+  EXPECT_NE(std::string::npos, error.find("heatingfueltype")) << error;
+  EXPECT_NE(std::string::npos, error.find("building a")) << error;
+
+  error = loadError(csvFile, defaultsFile, "id,wallu\na,\"1,2,3\"\n");
+  EXPECT_NE(std::string::npos, error.find("wallU")) << error;
+
+  error = loadError(csvFile, defaultsFile, "id,notaproperty\na,1\n");
+  EXPECT_NE(std::string::npos, error.find("notaproperty")) << error;
+
+  error = loadError(csvFile, defaultsFile, "id,floorarea,buildingheight\na,100\n");
+  EXPECT_NE(std::string::npos, error.find("line 2")) << error;
+
+  // Without defaults every required property needs a column.
+  error = loadError(csvFile, "", "id,floorarea\na,100\n");
+  EXPECT_NE(std::string::npos, error.find("Required property")) << error;
+
+  // Numbers that are not finite are errors, not empty cells.
+  error = loadError(csvFile, defaultsFile, "id,floorarea\na,nan\n");
+  EXPECT_NE(std::string::npos, error.find("'nan'")) << error;
+  error = loadError(csvFile, defaultsFile, "id,wallu\na,\"1,1,1,1,inf,1,1,1,1\"\n");
+  EXPECT_NE(std::string::npos, error.find("wallU")) << error;
+
+  EXPECT_EQ("", loadError(csvFile, defaultsFile, "floorarea\n100\n200\n"));
+
+  // A binary file whose row count exceeds its data is rejected before any column is allocated.
+  std::string binaryFile = test_data_path + "/portfolio_errors.bin";
+  Portfolio portfolio;
+  {
+    std::ofstream csv(csvFile.c_str());
+    csv << "id,floorarea,wallu\na,100,\"1,1,1,1,1,1,1,1,1\"\n";
+  }
+  portfolio.loadCsv(csvFile, defaultsFile);
+  portfolio.saveBinary(binaryFile);
+  std::ifstream in(binaryFile.c_str(), std::ios_base::binary);
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  for (uint64_t rows : { (uint64_t) 2, (uint64_t) 1 << 40, ~(uint64_t) 0 }) {
+    // The row count follows the magic, the version and the column count.
+    for (int i = 0; i < 8; i++) {
+      data[16 + i] = static_cast<char>(rows >> (8 * i));
+    }
+    {
+      std::ofstream out(binaryFile.c_str(), std::ios_base::binary | std::ios_base::trunc);
+      out << data;
+    }
+    try {
+      Portfolio damaged;
+      damaged.loadBinary(binaryFile, defaultsFile);
+      ADD_FAILURE() << rows;
+    } catch (const std::invalid_argument& e) {
+      EXPECT_NE(std::string::npos, std::string(e.what()).find("is truncated")) << e.what();
+    }
+  }
+
+  // Nor are they accepted from a binary file. Replace the floor area of 100 with infinity.
+  data[16] = 1;
+  const char hundred[8] = { 0, 0, 0, 0, 0, 0, 0x59, 0x40 };
+  size_t floorArea = data.find(std::string(hundred, 8));
+  ASSERT_NE(std::string::npos, floorArea);
+  data.replace(floorArea, 8, std::string("\0\0\0\0\0\0\xf0\x7f", 8));
+  for (int i = 17; i < 24; i++) {
+    data[i] = 0;
+  }
+  {
+    std::ofstream out(binaryFile.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    out << data;
+  }
+  try {
+    Portfolio damaged;
+    damaged.loadBinary(binaryFile, defaultsFile);
+    ADD_FAILURE();
+  } catch (const std::invalid_argument& e) {
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("floorarea")) << e.what();
+  }
+
+  boost::filesystem::remove(binaryFile);
+  boost::filesystem::remove(csvFile);
+}
@@ -11,6 +11,9 @@
 
 #include "../Properties.hpp"
 
+#include <algorithm>
+#include <fstream>
+
 using namespace openstudio::isomodel;
 
 /*
@@ -67,3 +70,112 @@ TEST_F(ISOModelFixture, PropsMissingValueTests) {
   EXPECT_FALSE(props.getPropertyAsDoubleVector("aMissingProperty", vec)); // Mising
   EXPECT_FALSE(props.getPropertyAsDoubleVector("weatherFilePath", vec)); // Cannot convert to double.
 }
+
+TEST_F(ISOModelFixture, PropsTypedValueCacheTests) {
+  Properties props(test_data_path + "/test_properties.props");
+
+  // Repeated lookups return the cached conversions.
+  ASSERT_EQ(6.33, *props.getPropertyAsDouble("buildingHeight"));
+  ASSERT_EQ(6.33, *props.getPropertyAsDouble("BuildingHeight"));
+  ASSERT_EQ(6, *props.getPropertyAsInt("buildingHeight"));
+  EXPECT_FALSE(bool(props.getPropertyAsDouble("weatherFilePath")));
+  EXPECT_FALSE(bool(props.getPropertyAsDouble("weatherFilePath")));
+
+  // Overwriting a property replaces its cached conversions.
+  props.putProperty("buildingHeight", "7.5");
+  ASSERT_EQ(7.5, *props.getPropertyAsDouble("buildingHeight"));
+  props.putProperty("BUILDINGHEIGHT", 1.0 / 3.0);
+  ASSERT_EQ(1.0 / 3.0, *props.getPropertyAsDouble("buildingHeight"));
+  ASSERT_EQ(5, props.size());
+
+  // Copies keep the properties and their cached values.
+  Properties copy(props);
+  ASSERT_EQ(1.0 / 3.0, *copy.getPropertyAsDouble("buildingHeight"));
+  ASSERT_EQ("ORD.epw", *copy.getProperty("WEATHERFILEPATH"));
+}
+
+TEST_F(ISOModelFixture, PropsDoubleListParsingTests) {
+  std::vector<double> vec;
+  ASSERT_TRUE(Properties::parseDoubleList("2.1, 234.3,12.3", vec));
+  ASSERT_EQ(3, vec.size());
+  EXPECT_EQ(2.1, vec[0]);
+  EXPECT_EQ(234.3, vec[1]);
+  EXPECT_EQ(12.3, vec[2]);
+
+  ASSERT_TRUE(Properties::parseDoubleList("-1e-3", vec));
+  ASSERT_EQ(1, vec.size());
+  EXPECT_EQ(-1e-3, vec[0]);
+
+  // Quoted fields are split as CSV.
+  ASSERT_TRUE(Properties::parseDoubleList("\"1.5\", 2", vec));
+  ASSERT_EQ(2, vec.size());
+  EXPECT_EQ(1.5, vec[0]);
+
+  EXPECT_FALSE(Properties::parseDoubleList("1,,2", vec)); // Empty field.
+  EXPECT_FALSE(Properties::parseDoubleList("1,2,", vec));
+  EXPECT_FALSE(Properties::parseDoubleList("1, two", vec));
+  EXPECT_FALSE(Properties::parseDoubleList("", vec));
+}
+
+TEST_F(ISOModelFixture, PropsLayeringTests) {
+  // Organization defaults -> building type defaults -> building.
+  std::shared_ptr<const Properties> organization = Properties::shared(test_data_path + "/test_properties.props");
+  EXPECT_EQ(organization, Properties::shared(test_data_path + "/test_properties.props"));
+
+  auto buildingType = std::make_shared<Properties>(organization);
+  buildingType->putProperty("buildingHeight", 9.0);
+  buildingType->putProperty("floorArea", 500.0);
+  Properties building(buildingType);
+  building.putProperty("floorArea", 750.0);
+
+  EXPECT_EQ(750.0, *building.getPropertyAsDouble("FLOORAREA"));
+  EXPECT_EQ(9.0, *building.getPropertyAsDouble("buildingheight"));
+  EXPECT_EQ(0.8, *building.getPropertyAsDouble("terrainClass"));
+  EXPECT_EQ("ORD.epw", *building.getProperty("weatherFilePath"));
+  std::vector<double> vec;
+  ASSERT_TRUE(building.getPropertyAsDoubleVector("wallU", vec));
+  EXPECT_EQ(3, vec.size());
+  EXPECT_FALSE(building.contains("missing"));
+
+  // The parents are not modified, and each key is listed once.
+  EXPECT_EQ(6.33, *organization->getPropertyAsDouble("buildingHeight"));
+  EXPECT_EQ(500.0, *buildingType->getPropertyAsDouble("floorArea"));
+  EXPECT_EQ(1, building.size());
+  std::vector<std::string> keys = building.keys();
+  EXPECT_EQ(6, keys.size());
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  EXPECT_EQ("floorarea", *building.keys_begin());
+
+  // The two file constructor layers the building over the shared defaults.
+  Properties withDefaults(test_data_path + "/SmallOffice_v2.ism", test_data_path + "/test_properties.props");
+  EXPECT_EQ(organization, withDefaults.parent());
+  ASSERT_TRUE(withDefaults.getPropertyAsDoubleVector("wallU", vec));
+  EXPECT_EQ(9, vec.size());
+
+  EXPECT_THROW(buildingType->setParent(std::make_shared<Properties>(buildingType)), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, PropsSharedFileLimitTests)
+{
+  // Only the most recently used files are kept.
+  std::vector<std::string> files;
+  for (size_t i = 0; i <= Properties::SHARED_FILE_LIMIT; i++) {
+    files.push_back(test_data_path + "/shared_limit_" + std::to_string(i) + ".props");
+    std::ofstream out(files.back().c_str());
+    out << "index = " << i << std::endl;
+  }
+  auto first = Properties::shared(files[0]);
+  auto second = Properties::shared(files[1]);
+  for (size_t i = 2; i < files.size(); i++) {
+    Properties::shared(files[i]);
+  }
+  // The second file is now the least recently used and the first was just evicted.
+  EXPECT_EQ(second, Properties::shared(files[1]));
+  auto reparsed = Properties::shared(files[0]);
+  EXPECT_NE(first, reparsed);
+  EXPECT_EQ(0, *reparsed->getPropertyAsInt("index"));
+  EXPECT_EQ(0, *first->getPropertyAsInt("index"));
+  for (auto& file : files) {
+    boost::filesystem::remove(file);
+  }
+}
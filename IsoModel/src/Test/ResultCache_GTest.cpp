@@ -0,0 +1,200 @@
+/*
+ * ResultCache_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../ModelParameters.hpp"
+#include "../ResultCache.hpp"
+#include "../SimulationPlan.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <typeinfo>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+void expectEqualResults(const std::vector<openstudio::EndUses>& expected, const std::vector<openstudio::EndUses>& actual)
+{
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t period = 0; period < expected.size(); period++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      EXPECT_EQ(endUseValue(expected[period], endUse), endUseValue(actual[period], endUse)) << period << " " << endUseName(endUse);
+    }
+  }
+}
+
+template<class T>
+ContentHash constructedIn(char fill)
+{
+  std::vector<char> memory(sizeof(T) + alignof(T), fill);
+  void* place = memory.data();
+  size_t space = memory.size();
+  T* component = new (std::align(alignof(T), sizeof(T), place, space)) T();
+  BinaryWriter out;
+  component->serialize(out);
+  component->~T();
+  return out.hash();
+}
+
+template<class T>
+void expectInitialized()
+{
+  EXPECT_EQ(constructedIn<T>(0), constructedIn<T>((char) 0xa5)) << typeid(T).name();
+}
+
+}
+
+TEST_F(ISOModelFixture, ContentHashTests)
+{
+  // Reference values of MurmurHash3 x64 128 with seed 0.
+  ContentHash empty = ContentHash::of("", 0);
+  EXPECT_EQ("00000000000000000000000000000000", empty.toString());
+  ContentHash hello = ContentHash::of("hello", 5);
+  EXPECT_EQ("cbd8a7b341bd9b025b1e906a48ae1d19", hello.toString());
+  const char* text = "The quick brown fox jumps over the lazy dog";
+  EXPECT_EQ("e34bbc7bbc071b6c7a433ca9c49a9347", ContentHash::of(text, std::strlen(text)).toString());
+  EXPECT_NE(hello, ContentHash::of("hellO", 5));
+}
+
+TEST_F(ISOModelFixture, ResultCacheTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> monthly = model.toMonthlyModel().simulate();
+  std::vector<openstudio::EndUses> hourly = model.toHourlyModel().simulate(true);
+
+  auto cache = std::make_shared<ResultCache>();
+  model.setResultCache(cache);
+  expectEqualResults(monthly, model.toMonthlyModel().simulate());
+  expectEqualResults(monthly, model.toMonthlyModel().simulate());
+  // A plan of the same inputs finds the results of the model, and so does a variant
+  // that ends up with the same values.
+  expectEqualResults(monthly, model.compile()->simulateMonthly());
+  double floorArea = model.floorArea();
+  UserModel larger = model.withOverrides({ { "floorArea", "1500" } });
+  larger.toMonthlyModel().simulate();
+  expectEqualResults(monthly, larger.withOverrides({ { "floorArea", std::to_string(floorArea) } }).toMonthlyModel().simulate());
+  ResultCacheStatistics statistics = cache->statistics();
+  EXPECT_EQ(3u, statistics.hits);
+  EXPECT_EQ(2u, statistics.misses);
+  EXPECT_EQ(2u, statistics.entries);
+
+  // The hourly results are keyed separately by their aggregation.
+  expectEqualResults(hourly, model.toHourlyModel().simulate(true));
+  expectEqualResults(hourly, model.compile()->simulateHourly(true));
+  EXPECT_EQ(8760u, model.compile()->simulateHourly(false).size());
+  EXPECT_EQ(8760u, model.toHourlyModel().simulate(false).size());
+  statistics = cache->statistics();
+  EXPECT_EQ(5u, statistics.hits);
+  EXPECT_EQ(4u, statistics.misses);
+  EXPECT_DOUBLE_EQ(5 / 9.0, statistics.hitRate());
+
+  // Room for about one monthly result per shard.
+  ResultCache small(2 * 1500, std::string(), 2);
+  for (int i = 0; i < 10; i++) {
+    std::vector<openstudio::EndUses> results(12);
+    setEndUseValue(results[0], 0, i);
+    ContentHash key = { (uint64_t) i, (uint64_t) i };
+    small.insert(key, results);
+  }
+  statistics = small.statistics();
+  EXPECT_EQ(2u, statistics.entries);
+  EXPECT_EQ(8u, statistics.evictions);
+  EXPECT_LE(statistics.bytes, 3000u);
+  std::vector<openstudio::EndUses> found;
+  ContentHash last = { 9, 9 };
+  ASSERT_TRUE(small.find(last, found));
+  EXPECT_EQ(9, endUseValue(found[0], 0));
+  ContentHash first = { 0, 0 };
+  EXPECT_FALSE(small.find(first, found));
+  small.clear();
+  EXPECT_EQ(0u, small.statistics().entries);
+}
+
+TEST_F(ISOModelFixture, ResultKeyTests)
+{
+  // Every serialized member of a component has a value whatever memory it is constructed in.
+  expectInitialized<Population>();
+  expectInitialized<Location>();
+  expectInitialized<Lighting>();
+  expectInitialized<Building>();
+  expectInitialized<Structure>();
+  expectInitialized<Heating>();
+  expectInitialized<Cooling>();
+  expectInitialized<Ventilation>();
+  expectInitialized<PhysicalQuantities>();
+  expectInitialized<SimulationSettings>();
+
+  // Two models of the same .ism have the same key and the same snapshot.
+  std::string first = test_data_path + "/result_key_test_1.snapshot";
+  std::string second = test_data_path + "/result_key_test_2.snapshot";
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  ContentHash key = model.toMonthlyModel().resultKey(MONTHLY_RESULTS);
+  model.saveSnapshot(first);
+
+  UserModel fresh;
+  fresh.load(test_data_path + "/SmallOffice_v2.ism");
+  EXPECT_EQ(key, fresh.toMonthlyModel().resultKey(MONTHLY_RESULTS));
+  EXPECT_EQ(model.toHourlyModel().resultKey(HOURLY_RESULTS), fresh.toHourlyModel().resultKey(HOURLY_RESULTS));
+  fresh.saveSnapshot(second);
+  std::ifstream firstIn(first.c_str(), std::ios_base::binary);
+  std::ifstream secondIn(second.c_str(), std::ios_base::binary);
+  std::string firstBytes((std::istreambuf_iterator<char>(firstIn)), std::istreambuf_iterator<char>());
+  std::string secondBytes((std::istreambuf_iterator<char>(secondIn)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(firstBytes, secondBytes);
+
+  boost::filesystem::remove(first);
+  boost::filesystem::remove(second);
+}
+
+TEST_F(ISOModelFixture, ResultCacheStoreTests)
+{
+  std::string directory = test_data_path + "/result_cache_test";
+  boost::filesystem::remove_all(directory);
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> monthly = model.toMonthlyModel().simulate();
+  ContentHash key = model.toMonthlyModel().resultKey(MONTHLY_RESULTS);
+
+  model.setResultCache(std::make_shared<ResultCache>(ResultCache::DEFAULT_CAPACITY, directory));
+  model.toMonthlyModel().simulate();
+  std::string file = (boost::filesystem::path(directory) / (key.toString() + ".isr")).string();
+  EXPECT_TRUE(boost::filesystem::exists(file));
+
+  // Another process, here another cache, finds the stored results.
+  auto reopened = std::make_shared<ResultCache>(ResultCache::DEFAULT_CAPACITY, directory);
+  model.setResultCache(reopened);
+  expectEqualResults(monthly, model.compile()->simulateMonthly());
+  expectEqualResults(monthly, model.compile()->simulateMonthly());
+  ResultCacheStatistics statistics = reopened->statistics();
+  EXPECT_EQ(1u, statistics.diskHits);
+  EXPECT_EQ(1u, statistics.hits);
+  EXPECT_EQ(0u, statistics.misses);
+
+  // A damaged file is a miss, and is replaced.
+  {
+    std::ofstream damaged(file.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    damaged << "ISMRESLT";
+  }
+  auto third = std::make_shared<ResultCache>(ResultCache::DEFAULT_CAPACITY, directory);
+  model.setResultCache(third);
+  expectEqualResults(monthly, model.toMonthlyModel().simulate());
+  statistics = third->statistics();
+  EXPECT_EQ(1u, statistics.misses);
+  EXPECT_EQ(1u, statistics.diskErrors);
+  std::vector<openstudio::EndUses> found;
+  EXPECT_TRUE(ResultCache(ResultCache::DEFAULT_CAPACITY, directory).find(key, found));
+
+  boost::filesystem::remove_all(directory);
+}
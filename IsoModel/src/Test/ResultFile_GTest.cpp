@@ -0,0 +1,226 @@
+/*
+ * ResultFile_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Batch.hpp"
+#include "../CsvWriter.hpp"
+#include "../ResultFile.hpp"
+#include "../ThreadPool.hpp"
+#include "../UserModel.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// The results of a building, scaled so that every building differs.
+std::vector<openstudio::EndUses> scaled(const std::vector<openstudio::EndUses>& results, double factor)
+{
+  std::vector<openstudio::EndUses> scaledResults(results.size());
+  for (size_t period = 0; period < results.size(); period++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      setEndUseValue(scaledResults[period], endUse, factor * endUseValue(results[period], endUse));
+    }
+  }
+  return scaledResults;
+}
+
+ResultFileBuilding building(int index)
+{
+  ResultFileBuilding building;
+  building.id = "building " + std::to_string(index);
+  building.metadata["index"] = std::to_string(index);
+  return building;
+}
+
+std::string readError(const std::string& file)
+{
+  try {
+    ResultFileReader reader(file);
+  } catch (const std::invalid_argument& e) {
+    return e.what();
+  }
+  return std::string();
+}
+
+}
+
+TEST_F(ISOModelFixture, ResultFileTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> hourly = model.toHourlyModel().simulate(false);
+  ASSERT_EQ(8760u, hourly.size());
+
+  // Appended from several threads at once.
+  std::string file = test_data_path + "/result_file_test.icr";
+  {
+    ResultFileOptions options;
+    options.metadata["shard"] = "1/1";
+    ResultFileWriter writer(file, hourly.size(), options);
+    ThreadPool pool(4);
+    pool.parallelFor(40, [&](size_t i) { writer.append(building((int) i), scaled(hourly, 1 + 0.1 * i)); });
+    EXPECT_THROW(writer.append(building(40), std::vector<openstudio::EndUses>(12)), std::invalid_argument);
+    writer.close();
+    EXPECT_THROW(writer.append(building(40), hourly), std::invalid_argument);
+  }
+  ResultFileReader reader(file);
+  EXPECT_EQ(8760u, reader.periods());
+  EXPECT_EQ(RESULT_FLOAT64, reader.valueType());
+  EXPECT_EQ("1/1", reader.metadata().at("shard"));
+  ASSERT_EQ((size_t) END_USE_COUNT, reader.columns().size());
+  EXPECT_EQ("ElecHeat", reader.columns()[0]);
+  ASSERT_EQ(40u, reader.size());
+  EXPECT_EQ(40u, reader.find("missing"));
+  // The compressed columns take a fraction of the raw values.
+  EXPECT_LT(boost::filesystem::file_size(file), 40u * END_USE_COUNT * 8760 * 8 / 3);
+  for (int i : { 0, 17, 39 }) {
+    size_t index = reader.find("building " + std::to_string(i));
+    ASSERT_LT(index, reader.size());
+    EXPECT_EQ(std::to_string(i), reader.building(index).metadata.at("index"));
+    std::vector<openstudio::EndUses> expected = scaled(hourly, 1 + 0.1 * i);
+    std::vector<openstudio::EndUses> results = reader.results(index);
+    for (size_t period = 0; period < expected.size(); period++) {
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        ASSERT_EQ(endUseValue(expected[period], endUse), endUseValue(results[period], endUse)) << period;
+      }
+    }
+  }
+  bool compressed = false;
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    if (reader.codec(0, endUse) != COLUMN_RAW) {
+      compressed = true;
+      EXPECT_EQ(nullptr, reader.mappedDoubles(0, endUse));
+    }
+  }
+  EXPECT_TRUE(compressed);
+
+  // Raw float32 columns are read in place.
+  std::string rawFile = test_data_path + "/result_file_test_raw.icr";
+  {
+    ResultFileOptions options;
+    options.valueType = RESULT_FLOAT32;
+    options.compress = false;
+    ResultFileWriter writer(rawFile, hourly.size(), options);
+    writer.append(building(0), hourly);
+  }
+  {
+    ResultFileReader raw(rawFile);
+    EXPECT_EQ(RESULT_FLOAT32, raw.valueType());
+    EXPECT_EQ(nullptr, raw.mappedDoubles(0, 2));
+    const float* values = raw.mappedFloats(0, 2);
+    ASSERT_NE(nullptr, values);
+    std::vector<double> decoded(hourly.size());
+    raw.column(0, 2, decoded.data());
+    for (size_t hour = 0; hour < hourly.size(); hour++) {
+      EXPECT_EQ((float) endUseValue(hourly[hour], 2), values[hour]);
+      EXPECT_EQ(values[hour], decoded[hour]);
+    }
+  }
+
+  // Files that were not closed or were cut short are refused.
+  std::string cutFile = test_data_path + "/result_file_test_cut.icr";
+  {
+    std::ifstream in(rawFile.c_str(), std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(cutFile.c_str(), std::ios::binary);
+    out.write(contents.data(), contents.size() - 1);
+  }
+  EXPECT_NE(std::string::npos, readError(cutFile).find("not closed"));
+  {
+    std::ofstream out(cutFile.c_str(), std::ios::binary);
+    out << "id,ElecHeat\n";
+  }
+  EXPECT_NE(std::string::npos, readError(cutFile).find("not a result file"));
+
+  for (const auto& path : { file, rawFile, cutFile }) {
+    boost::filesystem::remove(path);
+  }
+}
+
+TEST_F(ISOModelFixture, ResultFileCsvTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> monthly = model.toMonthlyModel().simulate();
+
+  std::string file = test_data_path + "/result_file_test_monthly.icr";
+  {
+    ResultFileWriter writer(file, 12);
+    writer.append(building(1), monthly);
+    ResultFileBuilding other;
+    other.id = "office, north";
+    other.metadata["floorArea"] = "1500";
+    writer.append(other, monthly);
+  }
+  std::ostringstream out;
+  {
+    ResultFileReader reader(file);
+    CsvWriter csv(out);
+    reader.writeCsv(csv);
+  }
+  boost::filesystem::remove(file);
+
+  std::istringstream in(out.str());
+  std::string line;
+  std::getline(in, line);
+  EXPECT_EQ(0u, line.find("id,floorArea,index,period,ElecHeat,ElecCool"));
+  std::getline(in, line);
+  EXPECT_EQ(0u, line.find("building 1,,1,1,"));
+  std::vector<std::string> lines(1, line);
+  while (std::getline(in, line)) {
+    lines.push_back(line);
+  }
+  ASSERT_EQ(24u, lines.size());
+  EXPECT_EQ(0u, lines[23].find("\"office, north\",1500,,12,"));
+  std::istringstream fields(lines[11]);
+  std::string field;
+  for (int i = 0; i < 4 + 9; i++) {
+    std::getline(fields, field, ',');
+  }
+  EXPECT_EQ(endUseValue(monthly[11], 8), std::stod(field));
+}
+
+TEST_F(ISOModelFixture, ResultFileBatchTests)
+{
+  BatchManifest manifest;
+  BatchJob job = { test_data_path + "/portfolio.csv", test_data_path + "/SmallOffice_v2.ism", HOURLY_ENGINE };
+  manifest.jobs.push_back(job);
+  Batch batch(manifest, 1);
+  ThreadPool pool(2);
+
+  std::string file = test_data_path + "/result_file_test_batch.icr";
+  {
+    ResultFileWriter monthly(file, 12);
+    EXPECT_THROW(batch.run(pool, ShardId(), monthly), std::invalid_argument);
+  }
+  {
+    ResultFileWriter writer(file, 8760);
+    EXPECT_EQ(3u, batch.run(pool, ShardId(), writer));
+  }
+  ResultFileReader reader(file);
+  ASSERT_EQ(3u, reader.size());
+  size_t first = reader.find("office_a");
+  ASSERT_LT(first, reader.size());
+  EXPECT_EQ("1", reader.building(first).metadata.at("row"));
+  EXPECT_EQ("1", reader.building(first).metadata.at("job"));
+  EXPECT_EQ("1500", reader.building(reader.find("office_b")).metadata.at("floorArea"));
+
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> expected = model.toHourlyModel().simulate(false);
+  std::vector<double> heating(8760);
+  reader.column(first, 9, heating.data());
+  for (size_t hour = 0; hour < heating.size(); hour++) {
+    ASSERT_EQ(endUseValue(expected[hour], 9), heating[hour]) << hour;
+  }
+  boost::filesystem::remove(file);
+}
@@ -0,0 +1,101 @@
+/*
+ * Sensitivity_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Sensitivity.hpp"
+
+#include <cmath>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, SaltelliIshigamiTests)
+{
+  // The Ishigami function has known first and total order indices.
+  const double pi = 3.14159265358979323846;
+  std::vector<Distribution> distributions(3, Distribution::uniform(-pi, pi));
+  Sensitivity sensitivity(SweepSpec::SALTELLI, distributions, 8192);
+  EXPECT_EQ(8192u * 5, sensitivity.size());
+
+  ThreadPool pool(4);
+  sensitivity.evaluate(pool, 1, [](size_t, const double* x, double* y) {
+    y[0] = std::sin(x[0]) + 7 * std::sin(x[1]) * std::sin(x[1]) + 0.1 * std::pow(x[2], 4) * std::sin(x[0]);
+  });
+  sensitivity.analyze(pool, 100);
+
+  double first[] = { 0.3139, 0.4424, 0 };
+  double total[] = { 0.5576, 0.4424, 0.2437 };
+  for (size_t i = 0; i < 3; i++) {
+    const SobolIndices& indices = sensitivity.sobol(0, i);
+    EXPECT_NEAR(first[i], indices.first.value, 0.02) << "Parameter = " << i;
+    EXPECT_NEAR(total[i], indices.total.value, 0.02) << "Parameter = " << i;
+    EXPECT_LE(indices.first.low, indices.first.value);
+    EXPECT_GE(indices.first.high, indices.first.value);
+    EXPECT_LT(indices.total.low, indices.total.high);
+  }
+}
+
+TEST_F(ISOModelFixture, MorrisLinearTests)
+{
+  std::vector<Distribution> distributions;
+  distributions.push_back(Distribution::uniform(0, 10));
+  distributions.push_back(Distribution::uniform(-1, 1));
+  distributions.push_back(Distribution::normal(0, 1));
+  Sensitivity sensitivity(SweepSpec::MORRIS, distributions, 50, 4, 3);
+  EXPECT_EQ(50u * 4, sensitivity.size());
+
+  ThreadPool pool(2);
+  sensitivity.evaluate(pool, 2, [](size_t, const double* x, double* y) {
+    y[0] = 2 * x[0] - 3 * x[1];
+    y[1] = x[0] * x[1];
+  });
+  sensitivity.analyze(pool, 50);
+
+  // Effects are per unit of quantile: the ranges are 10 and 2.
+  EXPECT_NEAR(20, sensitivity.morris(0, 0).mu.value, 1e-9);
+  EXPECT_NEAR(20, sensitivity.morris(0, 0).muStar.value, 1e-9);
+  EXPECT_NEAR(0, sensitivity.morris(0, 0).sigma, 1e-9);
+  EXPECT_NEAR(-6, sensitivity.morris(0, 1).mu.value, 1e-9);
+  EXPECT_NEAR(6, sensitivity.morris(0, 1).muStar.value, 1e-9);
+  EXPECT_NEAR(0, sensitivity.morris(0, 2).muStar.value, 1e-12);
+  // Interactions show up as spread of the effects.
+  EXPECT_GT(sensitivity.morris(1, 0).sigma, 0);
+  EXPECT_LE(sensitivity.morris(1, 0).muStar.low, sensitivity.morris(1, 0).muStar.value);
+}
+
+TEST_F(ISOModelFixture, SensitivityStudyTests)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  std::istringstream in("method = saltelli\n"
+                        "samples = 128\n"
+                        "bootstrap = 20\n"
+                        "parameter = heatingSetpointOccupied uniform 18 22\n"
+                        "parameter = exteriorLightingPower uniform 0 0.5\n");
+  SweepSpec spec = SweepSpec::parse(in);
+  SensitivityStudy study(base, spec);
+
+  ThreadPool pool(4);
+  study.run(pool);
+  const int gasHeat = 9;
+  EXPECT_GT(study.sensitivity().sobol(gasHeat, 0).total.value, 0.9);
+  EXPECT_LT(study.sensitivity().sobol(gasHeat, 1).total.value, 0.1);
+
+  // The design and the resamples are fixed by the seed, so a single thread gives the same indices.
+  ThreadPool single(1);
+  SensitivityStudy serial(base, spec);
+  serial.run(single);
+  EXPECT_EQ(study.sensitivity().sobol(gasHeat, 0).first.value, serial.sensitivity().sobol(gasHeat, 0).first.value);
+  EXPECT_EQ(study.sensitivity().sobol(gasHeat, 0).first.low, serial.sensitivity().sobol(gasHeat, 0).first.low);
+
+  std::ostringstream csv;
+  study.writeCsv(csv);
+  EXPECT_EQ(0u, csv.str().find("EndUse,Parameter,S1,S1Low,S1High,ST,STLow,STHigh\n"));
+  EXPECT_NE(std::string::npos, csv.str().find("\nGasHeat,heatingSetpointOccupied,"));
+  EXPECT_EQ(std::string::npos, csv.str().find("GasDHW"));
+}
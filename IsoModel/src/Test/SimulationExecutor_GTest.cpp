@@ -0,0 +1,170 @@
+/*
+ * SimulationExecutor_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../SimulationExecutor.hpp"
+#include "../SimulationPlan.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// Blocks the worker it runs on until opened.
+struct Gate
+{
+  std::mutex mutex;
+  std::condition_variable opened;
+  bool open;
+
+  Gate() : open(false)
+  {
+  }
+
+  std::vector<openstudio::EndUses> wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    opened.wait(lock, [this]() { return open; });
+    return std::vector<openstudio::EndUses>();
+  }
+
+  void release()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    open = true;
+    opened.notify_all();
+  }
+};
+
+}
+
+TEST_F(ISOModelFixture, CancellationScopeTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  auto plan = model.compile();
+  CancellationToken token;
+  {
+    CancellationScope scope(token);
+    EXPECT_NO_THROW(plan->simulateMonthly());
+    token.cancel();
+    EXPECT_THROW(plan->simulateMonthly(), SimulationCancelled);
+    EXPECT_THROW(plan->simulateHourly(true), SimulationCancelled);
+    {
+      // An inner scope with its own token hides the outer one.
+      CancellationScope inner((CancellationToken()));
+      EXPECT_NO_THROW(checkCancellation());
+    }
+    EXPECT_THROW(checkCancellation(), SimulationCancelled);
+  }
+  EXPECT_NO_THROW(checkCancellation());
+  EXPECT_NO_THROW(plan->simulateMonthly());
+}
+
+TEST_F(ISOModelFixture, SimulationExecutorTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  auto expected = model.toMonthlyModel().simulate();
+
+  SimulationExecutor executor(1);
+  Gate gate;
+  SimulationJob blocker = executor.submit([&gate]() { return gate.wait(); });
+  while (blocker.status() != JOB_RUNNING) {
+    std::this_thread::yield();
+  }
+
+  // Queued behind the blocker: the interactive job runs before the background ones,
+  // and a job superseded by a newer one with the same key is dropped.
+  std::vector<int> order;
+  std::mutex orderMutex;
+  auto record = [&](int id) {
+    SimulationJobOptions options(id == 3 ? INTERACTIVE_PRIORITY : BACKGROUND_PRIORITY);
+    options.key = id == 1 || id == 2 ? "what-if" : "";
+    options.callback = [&order, &orderMutex, id](const SimulationJob& job) {
+      if (job.status() == JOB_DONE) {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order.push_back(id);
+      }
+    };
+    return options;
+  };
+  SimulationJob superseded = executor.submit(model, MONTHLY_ENGINE, record(1));
+  SimulationJob background = executor.submit(model, MONTHLY_ENGINE, record(2));
+  SimulationJob interactive = executor.submit(model.compile(), HOURLY_ENGINE, record(3));
+  SimulationJob other = executor.submit(model, MONTHLY_ENGINE, record(4));
+  EXPECT_EQ(4u, executor.queued());
+  EXPECT_EQ(JOB_QUEUED, background.status());
+  gate.release();
+  executor.wait();
+
+  EXPECT_EQ(JOB_DONE, blocker.status());
+  EXPECT_EQ(JOB_CANCELLED, superseded.status());
+  EXPECT_THROW(superseded.get(), SimulationCancelled);
+  EXPECT_EQ((std::vector<int>{ 3, 2, 4 }), order);
+  EXPECT_EQ(12u, interactive.get().size());
+  auto results = background.get();
+  ASSERT_EQ(12u, results.size());
+  for (int month = 0; month < 12; month++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      EXPECT_DOUBLE_EQ(endUseValue(expected[month], endUse), endUseValue(results[month], endUse));
+    }
+  }
+
+  // A running job stops at its next check.
+  SimulationJob running = executor.submit([]() {
+    for (;;) {
+      checkCancellation();
+      std::this_thread::yield();
+    }
+    return std::vector<openstudio::EndUses>();
+  });
+  while (running.status() != JOB_RUNNING) {
+    std::this_thread::yield();
+  }
+  executor.cancelAll();
+  EXPECT_THROW(running.get(), SimulationCancelled);
+  EXPECT_EQ(JOB_CANCELLED, running.status());
+
+  SimulationJob failing = executor.submit([]() -> std::vector<openstudio::EndUses> { throw std::invalid_argument("bad model"); });
+  EXPECT_THROW(failing.get(), std::invalid_argument);
+  EXPECT_EQ(JOB_FAILED, failing.status());
+}
+
+TEST_F(ISOModelFixture, SimulationExecutorBackendTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+
+  // The application's own pool.
+  ThreadPool pool(2);
+  {
+    SimulationExecutor executor(pool);
+    std::vector<SimulationJob> jobs;
+    for (int i = 0; i < 8; i++) {
+      jobs.push_back(executor.submit(model, i % 2 == 0 ? MONTHLY_ENGINE : HOURLY_ENGINE));
+    }
+    for (auto& job : jobs) {
+      EXPECT_EQ(12u, job.get().size());
+    }
+  }
+
+  // Any function that runs the tasks, here on the calling thread when asked.
+  std::vector<std::function<void()> > tasks;
+  SimulationExecutor executor([&tasks](std::function<void()> task) { tasks.push_back(task); });
+  SimulationJob low = executor.submit(model, MONTHLY_ENGINE, SimulationJobOptions(BACKGROUND_PRIORITY));
+  SimulationJob high = executor.submit(model, MONTHLY_ENGINE, SimulationJobOptions(INTERACTIVE_PRIORITY));
+  ASSERT_EQ(2u, tasks.size());
+  tasks[0]();
+  EXPECT_EQ(JOB_DONE, high.status());
+  EXPECT_EQ(JOB_QUEUED, low.status());
+  tasks[1]();
+  EXPECT_EQ(JOB_DONE, low.status());
+}
@@ -0,0 +1,262 @@
+/*
+ * SimulationServer_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../ModelParameters.hpp"
+#include "../Properties.hpp"
+#include "../ResultCache.hpp"
+#include "../SimulationServer.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+// Collects the responses of a server.
+struct Responses
+{
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::vector<boost::property_tree::ptree> lines;
+
+  std::function<void(const std::string&)> callback()
+  {
+    return [this](const std::string& line) {
+      boost::property_tree::ptree response;
+      std::istringstream in(line);
+      boost::property_tree::read_json(in, response);
+      std::lock_guard<std::mutex> lock(mutex);
+      lines.push_back(response);
+      ready.notify_all();
+    };
+  }
+
+  boost::property_tree::ptree waitFor(size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [&]() { return lines.size() >= count; });
+    return lines[count - 1];
+  }
+};
+
+std::vector<double> values(const boost::property_tree::ptree& response, int endUse)
+{
+  std::vector<double> result;
+  for (const auto& value : response.get_child(std::string("results.") + endUseName(endUse))) {
+    result.push_back(value.second.get_value<double>());
+  }
+  return result;
+}
+
+void expectResults(const std::vector<openstudio::EndUses>& expected, const boost::property_tree::ptree& response)
+{
+  ASSERT_EQ("ok", response.get<std::string>("status")) << response.get<std::string>("message", "");
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    std::vector<double> actual = values(response, endUse);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t period = 0; period < expected.size(); period++) {
+      EXPECT_NEAR(endUseValue(expected[period], endUse), actual[period], 1e-7 * (1 + std::abs(actual[period])))
+          << endUseName(endUse) << " " << period;
+    }
+  }
+}
+
+}
+
+TEST_F(ISOModelFixture, SimulationServerRequests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> monthly = model.compile()->simulateMonthly();
+  Properties overrides;
+  overrides.putProperty("floorArea", "1500");
+  std::vector<openstudio::EndUses> overridden = model.withOverrides(overrides).compile()->simulateMonthly();
+  std::vector<openstudio::EndUses> hourly = model.compile()->simulateHourly(true);
+
+  SimulationServer server(2);
+  Responses responses;
+  std::string ism = "\"ism\":\"" + test_data_path + "/SmallOffice_v2.ism\"";
+  server.handle("{\"id\":1," + ism + "}", responses.callback());
+  expectResults(monthly, responses.waitFor(1));
+  EXPECT_EQ(1, responses.lines[0].get<int>("id"));
+
+  server.handle("{\"id\":\"b\"," + ism + ",\"overrides\":{\"floorArea\":1500}}", responses.callback());
+  expectResults(overridden, responses.waitFor(2));
+  EXPECT_EQ("b", responses.lines[1].get<std::string>("id"));
+
+  server.handle("{\"id\":3," + ism + ",\"results\":\"hourlyByMonth\"}", responses.callback());
+  expectResults(hourly, responses.waitFor(3));
+
+  // Inline properties, with the weather file resolved against the directory.
+  Properties properties(test_data_path + "/SmallOffice_v2.ism");
+  std::string request = "{\"id\":4,\"directory\":\"" + test_data_path + "\",\"properties\":{";
+  std::vector<std::string> keys = properties.keys();
+  for (size_t i = 0; i < keys.size(); i++) {
+    request += (i > 0 ? ",\"" : "\"") + keys[i] + "\":\"" + *properties.getProperty(keys[i]) + "\"";
+  }
+  server.handle(request + "}}", responses.callback());
+  expectResults(monthly, responses.waitFor(4));
+
+  server.handle("{\"id\":5,\"ism\":\"missing.ism\"}", responses.callback());
+  EXPECT_EQ("error", responses.waitFor(5).get<std::string>("status"));
+  server.handle("not json", responses.callback());
+  EXPECT_EQ("error", responses.waitFor(6).get<std::string>("status"));
+
+  server.handle("{\"id\":7,\"command\":\"stats\"}", responses.callback());
+  boost::property_tree::ptree stats = responses.waitFor(7);
+  EXPECT_EQ(6, stats.get<int>("requests"));
+  EXPECT_EQ(2, stats.get<int>("errors"));
+  EXPECT_EQ(1, stats.get<int>("stations"));
+  EXPECT_EQ(3, stats.get<int>("plans"));
+  EXPECT_GT(stats.get<double>("p99Ms"), 0);
+}
+
+TEST_F(ISOModelFixture, SimulationServerPipelining)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::vector<openstudio::EndUses> monthly = model.compile()->simulateMonthly();
+
+  SimulationServer server(4);
+  std::ostringstream requests;
+  for (int i = 0; i < 50; i++) {
+    requests << "{\"id\":" << i << ",\"ism\":\"" << test_data_path << "/SmallOffice_v2.ism\"}\n";
+  }
+  // A request that cannot finish in time is answered with a timeout, exactly once.
+  requests << "{\"id\":50,\"ism\":\"" << test_data_path << "/SmallOffice_v2.ism\",\"results\":\"hourly\",\"timeout\":0}\n";
+  requests << "{\"command\":\"shutdown\"}\n";
+  requests << "{\"id\":99,\"ism\":\"ignored.ism\"}\n";
+  std::istringstream in(requests.str());
+  std::ostringstream out;
+  server.serve(in, out);
+
+  std::istringstream lines(out.str());
+  std::vector<bool> answered(51, false);
+  int responses = 0;
+  for (std::string line; std::getline(lines, line); responses++) {
+    boost::property_tree::ptree response;
+    std::istringstream json(line);
+    boost::property_tree::read_json(json, response);
+    if (!response.get_optional<int>("id")) {
+      continue; // The shutdown acknowledgement.
+    }
+    int id = response.get<int>("id");
+    ASSERT_LT(id, 51);
+    EXPECT_FALSE(answered[id]);
+    answered[id] = true;
+    if (id == 50) {
+      EXPECT_EQ("timeout", response.get<std::string>("status"));
+    } else {
+      expectResults(monthly, response);
+    }
+  }
+  EXPECT_EQ(52, responses);
+  EXPECT_EQ(std::vector<bool>(51, true), answered);
+}
+
+TEST_F(ISOModelFixture, SimulationServerTimeoutCancels)
+{
+  // A request that times out stops simulating, so its results are never computed and
+  // never reach the result cache.
+  auto cache = std::make_shared<ResultCache>();
+  SimulationServer server(1);
+  server.setResultCache(cache);
+  Responses responses;
+  server.handle("{\"id\":1,\"ism\":\"" + test_data_path + "/SmallOffice_v2.ism\",\"results\":\"hourly\",\"timeout\":1}",
+                responses.callback());
+  EXPECT_EQ("timeout", responses.waitFor(1).get<std::string>("status"));
+  server.wait();
+  EXPECT_EQ(0, cache->statistics().entries);
+
+  server.handle("{\"id\":2,\"ism\":\"" + test_data_path + "/SmallOffice_v2.ism\",\"results\":\"hourly\"}", responses.callback());
+  EXPECT_EQ("ok", responses.waitFor(2).get<std::string>("status"));
+  EXPECT_EQ(1, cache->statistics().entries);
+}
+
+#ifndef _WIN32
+
+TEST_F(ISOModelFixture, SimulationServerSocket)
+{
+  std::string path = "isomodel_server_test.sock";
+  SimulationServer server(2);
+  std::thread serving([&]() { server.serveSocket(path); });
+
+  int client = -1;
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+  for (int attempt = 0; attempt < 100 && client < 0; attempt++) {
+    client = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(client, (sockaddr*) &address, sizeof(address)) != 0) {
+      close(client);
+      client = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+  ASSERT_GE(client, 0);
+
+  std::string request = "{\"id\":1,\"ism\":\"" + test_data_path + "/SmallOffice_v2.ism\"}\n{\"command\":\"shutdown\"}\n";
+  ASSERT_EQ((ssize_t) request.size(), write(client, request.data(), request.size()));
+  std::string received;
+  char chunk[4096];
+  for (ssize_t count; (count = read(client, chunk, sizeof(chunk))) > 0;) {
+    received.append(chunk, (size_t) count);
+  }
+  close(client);
+  serving.join();
+
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  std::istringstream lines(received);
+  std::string line;
+  int results = 0;
+  while (std::getline(lines, line)) {
+    boost::property_tree::ptree response;
+    std::istringstream json(line);
+    boost::property_tree::read_json(json, response);
+    if (response.get_child_optional("results")) {
+      expectResults(model.compile()->simulateMonthly(), response);
+      results++;
+    }
+  }
+  EXPECT_EQ(1, results);
+}
+
+TEST_F(ISOModelFixture, SimulationServerSocketPath)
+{
+  // A file that is not a socket is never replaced by the socket.
+  std::string path = "isomodel_server_test.txt";
+  {
+    std::ofstream file(path.c_str());
+    file << "not a socket";
+  }
+  SimulationServer server(1);
+  EXPECT_THROW(server.serveSocket(path), std::invalid_argument);
+  std::ifstream file(path.c_str());
+  std::string contents;
+  std::getline(file, contents);
+  EXPECT_EQ("not a socket", contents);
+  file.close();
+  std::remove(path.c_str());
+}
+
+#endif
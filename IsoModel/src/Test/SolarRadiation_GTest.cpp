@@ -125,3 +125,36 @@ TEST_F(ISOModelFixture, SunPositionAndRadiationTests) {
   auto totalIrradiance = solarRadiation.calculateTotalIrradiance(totalDirectBeamIrradiance, totalDiffuseIrradiance, groundReflectedIrradiance);
   EXPECT_NEAR(512.0124511801172, totalIrradiance, 0.0001);
 }
+
+TEST_F(ISOModelFixture, MonthlyWeatherReducerTests) {
+  // The single pass reducer must produce the same averages as the full hourly calculation.
+  EpwData full;
+  full.loadData(test_data_path + "/ORD.epw");
+  TimeFrame frame;
+  SolarRadiation solarRadiation(&frame, &full);
+  solarRadiation.Calculate();
+
+  EpwData deferred;
+  WeatherData weather;
+  ASSERT_TRUE(MonthlyWeatherReducer::reduceFile(test_data_path + "/ORD.epw", deferred, weather));
+  EXPECT_EQ(0, deferred.rows()); // No hourly data held yet.
+  EXPECT_TRUE(deferred.hasData());
+  EXPECT_DOUBLE_EQ(full.latitude(), deferred.latitude());
+
+  for (int m = 0; m < MONTHS; m++) {
+    EXPECT_DOUBLE_EQ(solarRadiation.monthlyDryBulbTemp()[m], weather.mdbt()[m]);
+    EXPECT_DOUBLE_EQ(solarRadiation.monthlyWindspeed()[m], weather.mwind()[m]);
+    EXPECT_DOUBLE_EQ(solarRadiation.monthlyGlobalHorizontalRadiation()[m], weather.mEgh()[m]);
+    for (int s = 0; s < NUM_SURFACES; s++) {
+      EXPECT_DOUBLE_EQ(solarRadiation.monthlySolarRadiation()[m][s], weather.msolar()(m, s));
+    }
+    for (int h = 0; h < HOURS; h++) {
+      EXPECT_DOUBLE_EQ(solarRadiation.hourlyDryBulbTemp()[m][h], weather.mhdbt()(m, h));
+      EXPECT_DOUBLE_EQ(solarRadiation.hourlyGlobalHorizontalRadiation()[m][h], weather.mhEgh()(m, h));
+    }
+  }
+
+  // The hourly data is loaded on first access.
+  EXPECT_DOUBLE_EQ(full.value(DBT, 1234), deferred.value(DBT, 1234));
+  EXPECT_EQ(8760, deferred.rows());
+}
@@ -0,0 +1,124 @@
+/*
+ * Surrogate_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../Surrogate.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, DistributionCdf)
+{
+  std::vector<Distribution> distributions = { Distribution::uniform(2, 6), Distribution::normal(10, 2),
+                                              Distribution::lognormal(0.5, 0.3), Distribution::triangular(0, 1, 4) };
+  for (const auto& distribution : distributions) {
+    for (double u = 0.05; u < 1; u += 0.1) {
+      EXPECT_NEAR(u, distribution.cdf(distribution.quantile(u)), 1e-9) << distribution.type;
+    }
+  }
+  EXPECT_EQ(0, distributions[0].cdf(1));
+  EXPECT_EQ(1, distributions[3].cdf(5));
+}
+
+TEST_F(ISOModelFixture, SurrogateFitTests)
+{
+  // Outputs that are polynomials of degree 2 in the transformed inputs are fitted exactly.
+  std::vector<SweepParameter> parameters(2);
+  parameters[0].name = "a";
+  parameters[0].distribution = Distribution::uniform(0, 2);
+  parameters[1].name = "b";
+  parameters[1].distribution = Distribution::normal(5, 1);
+  std::vector<std::vector<double> > inputs;
+  std::vector<std::vector<double> > outputs;
+  for (const auto& point : latinHypercube(40, 2, 3)) {
+    double a = parameters[0].distribution.quantile(point[0]);
+    double b = parameters[1].distribution.quantile(point[1]);
+    double u = 2 * point[0] - 1;
+    double v = 2 * point[1] - 1;
+    std::vector<double> output(END_USE_COUNT, 0.0);
+    output[0] = 3 + u - 2 * u * v + v * v;
+    output[9] = 1 + 0.5 * u * u;
+    inputs.push_back({ a, b });
+    outputs.push_back(output);
+  }
+  Surrogate surrogate = Surrogate::fit(parameters, inputs, outputs, 2, 0.25);
+  EXPECT_EQ(6u, surrogate.termCount());
+  EXPECT_EQ(30u, surrogate.trainingRuns());
+  EXPECT_EQ(10u, surrogate.validationRuns());
+  ASSERT_EQ((size_t) END_USE_COUNT + 1, surrogate.validation().size());
+  for (const auto& error : surrogate.validation()) {
+    EXPECT_LT(error.maxError, 1e-9);
+    EXPECT_NEAR(1, error.r2, 1e-9);
+  }
+  // The mean of u^2 and v^2 over [-1, 1] is 1/3.
+  EXPECT_NEAR(3 + 1 / 3.0, surrogate.mean(0), 1e-9);
+  EXPECT_NEAR(1 + 0.5 / 3.0, surrogate.mean(9), 1e-9);
+  EXPECT_NEAR(surrogate.mean(0) + surrogate.mean(9), surrogate.mean(END_USE_COUNT), 1e-9);
+  EXPECT_NEAR(0, surrogate.standardDeviation(1), 1e-9);
+  double point[] = { 1.5, 5.0 };
+  EXPECT_NEAR(3.5 + 1.125, surrogate.eui(point), 1e-9);
+
+  EXPECT_THROW(Surrogate::fit(parameters, inputs, outputs, 8, 0.25), std::invalid_argument);
+  // Two levels cannot determine a quadratic term.
+  std::vector<std::vector<double> > twoLevels(inputs.size(), { 0.0, 5.0 });
+  for (size_t run = 0; run < twoLevels.size(); run++) {
+    twoLevels[run] = { run % 2 == 0 ? 0.0 : 2.0, inputs[run][1] };
+  }
+  EXPECT_THROW(Surrogate::fit(parameters, twoLevels, outputs, 2, 0.25), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, SurrogateTrainTests)
+{
+  std::istringstream text("model = SmallOffice_v2.ism\n"
+                          "design = sobol\n"
+                          "samples = 64\n"
+                          "degree = 3\n"
+                          "validation = 0.25\n"
+                          "parameter = heatingSetpointOccupied uniform 18 24\n"
+                          "parameter = lightingPowerDensityOccupied uniform 5 15\n"
+                          "parameter = infiltrationRateOccupied triangular 0.5 1 2\n");
+  SweepSpec spec = SweepSpec::parse(text, test_data_path);
+  UserModel model;
+  model.load(spec.modelFile);
+  ThreadPool pool(2);
+  Surrogate surrogate = Surrogate::train(model, spec, pool);
+  EXPECT_EQ(20u, surrogate.termCount());
+  EXPECT_EQ(16u, surrogate.validationRuns());
+  EXPECT_GT(surrogate.validation().back().r2, 0.99);
+
+  // A point off the design agrees with a direct simulation within the validation error.
+  std::vector<double> point = { 21.3, 9.7, 1.2 };
+  Sweep sweep(model, spec);
+  auto results = simulateByMonth(sweep.binding().bind(model, point.data()), MONTHLY_ENGINE);
+  double eui = 0;
+  for (const auto& month : results) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      eui += endUseValue(month, endUse);
+    }
+  }
+  EXPECT_NEAR(eui, surrogate.eui(point.data()), 3 * surrogate.validation().back().maxError + 1e-6 * eui);
+
+  std::string file = test_data_path + "/surrogate_test.bin";
+  surrogate.save(file);
+  Surrogate loaded = Surrogate::load(file);
+  boost::filesystem::remove(file);
+  EXPECT_EQ(surrogate.parameterNames(), loaded.parameterNames());
+  EXPECT_EQ(surrogate.evaluate(point), loaded.evaluate(point));
+  EXPECT_EQ(surrogate.validation().back().rmse, loaded.validation().back().rmse);
+  EXPECT_THROW(Surrogate::load(spec.modelFile), std::invalid_argument);
+
+  std::ostringstream report;
+  surrogate.writeReport(report);
+  EXPECT_NE(std::string::npos, report.str().find("\neui,"));
+
+  spec.samples = 20;
+  EXPECT_THROW(Surrogate::train(model, spec, pool), std::invalid_argument);
+}
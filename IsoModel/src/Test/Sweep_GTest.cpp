@@ -0,0 +1,260 @@
+/*
+ * Sweep_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../CsvWriter.hpp"
+#include "../ResultFile.hpp"
+#include "../Sweep.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace openstudio::isomodel;
+
+TEST_F(ISOModelFixture, ThreadPoolParallelFor)
+{
+  ThreadPool pool(4);
+  EXPECT_EQ(4u, pool.size());
+
+  std::vector<int> hits(10000, 0);
+  pool.parallelFor(hits.size(), [&](size_t i) { hits[i]++; }, 7);
+  for (size_t i = 0; i < hits.size(); i++) {
+    ASSERT_EQ(1, hits[i]) << "Index = " << i;
+  }
+
+  // Nested loops run on the same workers without deadlocking.
+  std::atomic<int> total(0);
+  pool.parallelFor(16, [&](size_t) {
+    pool.parallelFor(16, [&](size_t j) { total += (int) j; });
+  });
+  EXPECT_EQ(16 * 120, total.load());
+
+  EXPECT_THROW(pool.parallelFor(100, [](size_t i) {
+    if (i == 42) {
+      throw std::invalid_argument("run 42");
+    }
+  }), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, SamplingDesigns)
+{
+  // Every one of the n strata of every dimension holds exactly one sample.
+  auto lhs = latinHypercube(50, 3, 7);
+  ASSERT_EQ(50u, lhs.size());
+  for (size_t d = 0; d < 3; d++) {
+    std::set<int> strata;
+    for (const auto& point : lhs) {
+      strata.insert((int) (point[d] * 50));
+    }
+    EXPECT_EQ(50u, strata.size()) << "Dimension = " << d;
+  }
+  EXPECT_EQ(lhs, latinHypercube(50, 3, 7));
+
+  // The first Sobol points, offset by half of the 2^-32 resolution.
+  SobolSequence sobol(2);
+  double expected[4][2] = { { 0, 0 }, { 0.5, 0.5 }, { 0.75, 0.25 }, { 0.25, 0.75 } };
+  double point[2];
+  for (int i = 0; i < 4; i++) {
+    sobol.next(point);
+    EXPECT_NEAR(expected[i][0], point[0], 1e-9) << "Point = " << i;
+    EXPECT_NEAR(expected[i][1], point[1], 1e-9) << "Point = " << i;
+  }
+
+  // 2^k points stratify each dimension into 2^k intervals, also beyond the tabulated directions.
+  SobolSequence wide(40);
+  std::vector<std::set<int> > strata(40);
+  std::vector<double> values(40);
+  for (int i = 0; i < 256; i++) {
+    wide.next(values.data());
+    for (size_t d = 0; d < 40; d++) {
+      strata[d].insert((int) (values[d] * 256));
+    }
+  }
+  for (size_t d = 0; d < 40; d++) {
+    EXPECT_EQ(256u, strata[d].size()) << "Dimension = " << d;
+  }
+
+  EXPECT_EQ(24u, gridDesign({ 2, 3, 4 }).size());
+  EXPECT_NEAR(1.959963985, inverseNormal(0.975), 1e-8);
+  EXPECT_NEAR(-2.326347874, inverseNormal(0.01), 1e-8);
+  EXPECT_NEAR(0.4, Distribution::triangular(0.2, 0.4, 0.8).quantile(1.0 / 3.0), 1e-12);
+}
+
+TEST_F(ISOModelFixture, SweepSpecParsing)
+{
+  std::string specFile = test_data_path + "/sweep_spec_test.txt";
+  {
+    std::ofstream out(specFile.c_str());
+    out << "# Envelope sweep\n"
+        << "model = SmallOffice_v2.ism\n"
+        << "design = grid\n"
+        << "levels = 2\n"
+        << "engine = hourly\n"
+        << "parameter = floorArea uniform 1000 2000\n"
+        << "parameter = wallU triangular 0.2 0.4 0.8 levels=3  # per surface\n";
+  }
+  SweepSpec spec = SweepSpec::load(specFile);
+  boost::filesystem::remove(specFile);
+
+  EXPECT_EQ(SweepSpec::GRID, spec.design);
+  EXPECT_EQ(HOURLY_ENGINE, spec.engine);
+  EXPECT_TRUE(boost::filesystem::equivalent(test_data_path + "/SmallOffice_v2.ism", spec.modelFile));
+  ASSERT_EQ(2u, spec.parameters.size());
+  EXPECT_EQ(2, spec.parameters[0].levels);
+  EXPECT_EQ(3, spec.parameters[1].levels);
+
+  auto design = spec.runs();
+  ASSERT_EQ(6u, design.size());
+  EXPECT_DOUBLE_EQ(1000, design.front()[0]);
+  EXPECT_DOUBLE_EQ(0.2, design.front()[1]);
+  EXPECT_DOUBLE_EQ(2000, design.back()[0]);
+  EXPECT_DOUBLE_EQ(0.8, design.back()[1]);
+
+  std::istringstream unknownKey("desgin = lhs\n");
+  EXPECT_THROW(SweepSpec::parse(unknownKey), std::invalid_argument);
+  std::istringstream badDistribution("parameter = floorArea cauchy 1 2\n");
+  EXPECT_THROW(SweepSpec::parse(badDistribution), std::invalid_argument);
+  std::istringstream unknownProperty("parameter = floorAreas uniform 1 2\n");
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  EXPECT_THROW(Sweep(model, SweepSpec::parse(unknownProperty)), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, SweepMatchesSerialRuns)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  std::istringstream in("design = lhs\n"
+                        "samples = 24\n"
+                        "parameter = heatingSetpointOccupied normal 20 1\n"
+                        "parameter = wallU uniform 0.3 1.2\n"
+                        "parameter = lightingPowerDensityOccupied uniform 5 15\n");
+  Sweep sweep(base, SweepSpec::parse(in));
+  ASSERT_EQ(24u, sweep.size());
+
+  ThreadPool pool(4);
+  std::vector<std::vector<openstudio::EndUses> > results(sweep.size());
+  sweep.run(pool, [&](size_t run, const std::vector<openstudio::EndUses>& monthly) { results[run] = monthly; });
+
+  for (size_t run = 0; run < sweep.size(); run++) {
+    auto expected = simulateByMonth(sweep.binding().bind(base, sweep.inputs(run).data()), MONTHLY_ENGINE);
+    ASSERT_EQ(12u, results[run].size());
+    for (int month = 0; month < 12; month++) {
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        ASSERT_EQ(endUseValue(expected[month], endUse), endUseValue(results[run][month], endUse))
+          << "Run = " << run << ", Month = " << month << ", End Use = " << endUseName(endUse);
+      }
+    }
+  }
+
+  std::ostringstream csv;
+  sweep.writeCsv(pool, csv);
+  std::istringstream lines(csv.str());
+  std::string header;
+  std::getline(lines, header);
+  EXPECT_EQ(0u, header.find("run,heatingSetpointOccupied,wallU,lightingPowerDensityOccupied,ElecHeat,"));
+  size_t rows = 0;
+  for (std::string line; std::getline(lines, line);) {
+    rows++;
+  }
+  EXPECT_EQ(sweep.size(), rows);
+}
+
+TEST_F(ISOModelFixture, ParameterBindingSurfaces)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  // A vector property with a surface sets that surface only. The model holds the surfaces
+  // in Structure order: S, SE, E, NE, N, NW, W, SW, Roof.
+  ParameterBinding surfaces({ "windowArea[S]", "windowArea[n]", "wallU[Roof]" });
+  double values[] = { 12.5, 7.5, 0.25 };
+  UserModel model = surfaces.bind(base, values);
+  for (int s = 0; s < 9; s++) {
+    double windowArea = s == 0 ? 12.5 : s == 4 ? 7.5 : base.windowArea()[s];
+    EXPECT_EQ(windowArea, model.windowArea()[s]) << s;
+    EXPECT_EQ(s == 8 ? 0.25 : base.wallU()[s], model.wallU()[s]) << s;
+  }
+
+  // Alone, a vector property gets the value on all nine surfaces, the roof included.
+  ParameterBinding all(std::vector<std::string>(1, "windowArea"));
+  model = all.bind(base, values);
+  for (int s = 0; s < 9; s++) {
+    EXPECT_EQ(12.5, model.windowArea()[s]) << s;
+  }
+
+  EXPECT_THROW(ParameterBinding(std::vector<std::string>(1, "windowArea[Up]")), std::invalid_argument);
+  EXPECT_THROW(ParameterBinding(std::vector<std::string>(1, "windowArea[S")), std::invalid_argument);
+  EXPECT_THROW(ParameterBinding(std::vector<std::string>(1, "floorArea[S]")), std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, SweepResultFile)
+{
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+  std::istringstream in("design = lhs\n"
+                        "samples = 6\n"
+                        "parameter = wallU uniform 0.3 1.2\n"
+                        "parameter = windowArea[S] uniform 5 20\n");
+  Sweep sweep(base, SweepSpec::parse(in));
+  ThreadPool pool(2);
+
+  // The columnar form holds a building per run with its inputs as metadata.
+  std::string file = test_data_path + "/sweep_results_test.isr";
+  {
+    ResultFileWriter writer(file, 12);
+    sweep.writeResults(pool, writer);
+    writer.close();
+  }
+  {
+    ResultFileReader reader(file);
+    ASSERT_EQ(sweep.size(), reader.size());
+    for (size_t run = 0; run < sweep.size(); run++) {
+      size_t building = reader.find(std::to_string(run));
+      ASSERT_LT(building, reader.size());
+      EXPECT_EQ(sweep.inputs(run)[0], std::stod(reader.building(building).metadata.at("wallU")));
+      EXPECT_EQ(sweep.inputs(run)[1], std::stod(reader.building(building).metadata.at("windowArea[S]")));
+      auto expected = simulateByMonth(sweep.binding().bind(base, sweep.inputs(run).data()), MONTHLY_ENGINE);
+      auto results = reader.results(building);
+      for (int month = 0; month < 12; month++) {
+        for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+          EXPECT_EQ(endUseValue(expected[month], endUse), endUseValue(results[month], endUse));
+        }
+      }
+    }
+  }
+  boost::filesystem::remove(file);
+
+  ResultFileWriter hourly(file, 8760);
+  EXPECT_THROW(sweep.writeResults(pool, hourly), std::invalid_argument);
+  hourly.close();
+  boost::filesystem::remove(file);
+
+  // The CSV form goes through a CsvWriter, here with the shortest round trip digits.
+  std::ostringstream csv;
+  CsvWriter writer(csv);
+  sweep.writeCsv(pool, writer);
+  writer.flush();
+  std::istringstream lines(csv.str());
+  std::string header;
+  std::getline(lines, header);
+  EXPECT_EQ(0u, header.find("run,wallU,windowArea[S],ElecHeat,"));
+  size_t rows = 0;
+  for (std::string line; std::getline(lines, line); rows++) {
+    size_t run = std::stoul(line.substr(0, line.find(',')));
+    ASSERT_LT(run, sweep.size());
+    EXPECT_EQ(sweep.inputs(run)[0], std::stod(line.substr(line.find(',') + 1)));
+  }
+  EXPECT_EQ(sweep.size(), rows);
+}
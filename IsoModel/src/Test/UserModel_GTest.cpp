@@ -9,9 +9,12 @@
 
 #include "ISOModelFixture.hpp"
 
+#include "../IsmSchema.hpp"
 #include "../Properties.hpp"
 #include "../UserModel.hpp"
 
+#include <thread>
+
 using namespace openstudio::isomodel;
 
 TEST_F(ISOModelFixture, UserModelInitializationTests)
@@ -478,3 +481,280 @@ TEST_F(ISOModelFixture, UserModelOptionalPropertiesOverrideTests) {
   EXPECT_EQ(2, userModel.vent_rate_flag());
   EXPECT_DOUBLE_EQ(1.0, userModel.H_ve());
 }
+
+TEST_F(ISOModelFixture, IsmSchemaTests) {
+  // The schema can be enumerated and looked up case insensitively.
+  const std::vector<IsmProperty>& schema = ismSchema();
+  ASSERT_FALSE(schema.empty());
+  for (auto& property : schema) {
+    EXPECT_EQ(&property, findIsmProperty(property.name)) << property.name;
+    EXPECT_EQ(property.required, property.defaultValue == nullptr) << property.name;
+  }
+  const IsmProperty* wallU = findIsmProperty("WALLU");
+  ASSERT_NE(nullptr, wallU);
+  EXPECT_EQ(ISM_VECTOR, wallU->type);
+  EXPECT_TRUE(wallU->required);
+  const IsmProperty* rhoCpWater = findIsmProperty("rhocpwater");
+  ASSERT_NE(nullptr, rhoCpWater);
+  EXPECT_EQ(ISM_DOUBLE, rhoCpWater->type);
+  EXPECT_FALSE(rhoCpWater->required);
+  EXPECT_STREQ("4.1813", rhoCpWater->defaultValue);
+  EXPECT_EQ(nullptr, findIsmProperty("notaproperty"));
+
+  // Every missing and invalid property is reported in one exception.
+  Properties complete(test_data_path + "/SmallOffice_v2.ism");
+  Properties props;
+  for (auto key = complete.keys_begin(); key != complete.keys_end(); ++key) {
+    if (*key != "floorarea" && *key != "wallu") {
+      props.putProperty(*key, *complete.getProperty(*key));
+    }
+  }
+  props.putProperty("buildingheight", "tall");
+  props.putProperty("windowarea", "1,2,3");
+  UserModel userModel;
+  try {
+    bindIsmProperties(userModel, props);
+    FAIL() << "Expected invalid_argument.";
+  } catch (const std::invalid_argument& e) {
+    std::string message = e.what();
+    EXPECT_NE(std::string::npos, message.find("floorarea")) << message;
+    EXPECT_NE(std::string::npos, message.find("wallU")) << message;
+    EXPECT_NE(std::string::npos, message.find("buildingheight")) << message;
+    EXPECT_NE(std::string::npos, message.find("windowArea")) << message;
+  }
+
+  // Overrides may bind a subset of the schema.
+  Properties overrides;
+  overrides.putProperty("floorarea", 123.0);
+  bindIsmProperties(userModel, overrides, false);
+  EXPECT_DOUBLE_EQ(123.0, userModel.floorArea());
+
+  // Binding a complete .ism sets the optional properties it leaves out to their defaults,
+  // whereas overrides leave them as they are.
+  userModel.setRhoCpWater(1.0);
+  bindIsmProperties(userModel, overrides, false);
+  EXPECT_DOUBLE_EQ(1.0, userModel.rhoCpWater());
+  bindIsmProperties(userModel, complete);
+  EXPECT_DOUBLE_EQ(4.1813, userModel.rhoCpWater());
+
+  // The documented defaults match the defaults hard-coded in the components.
+  UserModel reference;
+  reference.load(test_data_path + "/SmallOffice_v2.ism");
+  UserModel withDefaults;
+  withDefaults.load(test_data_path + "/SmallOffice_v2.ism");
+  Properties defaults;
+  for (auto& property : schema) {
+    if (!property.required) {
+      defaults.putProperty(property.name, std::string(property.defaultValue));
+    }
+  }
+  bindIsmProperties(withDefaults, defaults, false);
+  auto monthlyExpected = reference.toMonthlyModel().simulate();
+  auto monthly = withDefaults.toMonthlyModel().simulate();
+  auto hourlyExpected = reference.toHourlyModel().simulate(true);
+  auto hourly = withDefaults.toHourlyModel().simulate(true);
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(j), monthly[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+      EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(j), hourly[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+      auto fuel = isoResultsEndUseTypes[j].first;
+      auto category = isoResultsEndUseTypes[j].second;
+      EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(fuel, category), monthly[i].getEndUse(fuel, category));
+      EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(fuel, category), hourly[i].getEndUse(fuel, category));
+#endif
+    }
+  }
+}
+
+TEST_F(ISOModelFixture, UserModelSnapshotTests) {
+  UserModel reference;
+  reference.load(test_data_path + "/SmallOffice_v2.ism");
+  std::string snapshotFile = test_data_path + "/snapshot_test.snap";
+  reference.saveSnapshot(snapshotFile);
+
+  UserModel restored;
+  restored.loadSnapshot(snapshotFile);
+  boost::filesystem::remove(snapshotFile);
+  EXPECT_TRUE(restored.valid());
+  EXPECT_EQ(reference.weatherFilePath(), restored.weatherFilePath());
+  EXPECT_DOUBLE_EQ(reference.floorArea(), restored.floorArea());
+  EXPECT_EQ(reference.epwData()->stationid(), restored.epwData()->stationid());
+  // The hourly weather is not read until it is needed.
+  EXPECT_EQ(0, restored.epwData()->rows());
+
+  auto monthlyExpected = reference.toMonthlyModel().simulate();
+  auto monthly = restored.toMonthlyModel().simulate();
+  auto hourlyExpected = reference.toHourlyModel().simulate(true);
+  auto hourly = restored.toHourlyModel().simulate(true);
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(j), monthly[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+      EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(j), hourly[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+      auto fuel = isoResultsEndUseTypes[j].first;
+      auto category = isoResultsEndUseTypes[j].second;
+      EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(fuel, category), monthly[i].getEndUse(fuel, category));
+      EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(fuel, category), hourly[i].getEndUse(fuel, category));
+#endif
+    }
+  }
+
+  // Weather loaded from an array has no file to refer to, so it is embedded.
+  std::vector<double> weather;
+  weather.push_back(41.98);
+  weather.push_back(-87.92);
+  weather.push_back(-6.0);
+  for (int c = 0; c < 7; c++) {
+    std::vector<double> column;
+    reference.epwData()->column(c, column);
+    weather.insert(weather.end(), column.begin(), column.end());
+  }
+  UserModel fromArray;
+  fromArray.load(test_data_path + "/SmallOffice_v2.ism");
+  fromArray.loadWeather(8760, &weather[0]);
+  fromArray.saveSnapshot(snapshotFile);
+  UserModel embedded;
+  embedded.loadSnapshot(snapshotFile);
+  boost::filesystem::remove(snapshotFile);
+  EXPECT_EQ(8760, embedded.epwData()->rows());
+  EXPECT_DOUBLE_EQ(fromArray.epwData()->value(DBT, 4000), embedded.epwData()->value(DBT, 4000));
+  EXPECT_DOUBLE_EQ(-87.92, embedded.epwData()->longitude());
+
+  // A file that is not a snapshot is rejected and leaves the model unchanged.
+  EXPECT_THROW(restored.loadSnapshot(test_data_path + "/SmallOffice_v2.ism"), std::invalid_argument);
+  EXPECT_THROW(restored.loadSnapshot(test_data_path + "/missing.snap"), std::invalid_argument);
+  EXPECT_DOUBLE_EQ(reference.floorArea(), restored.floorArea());
+}
+
+TEST_F(ISOModelFixture, UserModelOverridesTests) {
+  UserModel base;
+  base.load(test_data_path + "/SmallOffice_v2.ism");
+
+  UserModel variant = base.withOverrides({{"floorArea", "1500"}, {"wallU", "0.3,0.3,0.3,0.3,0.3,0.3,0.3,0.3,0.2"}});
+  EXPECT_DOUBLE_EQ(1500, variant.floorArea());
+  EXPECT_DOUBLE_EQ(0.3, variant.wallUvalueN());
+  EXPECT_DOUBLE_EQ(0.2, variant.roofUValue());
+  EXPECT_NE(base.floorArea(), variant.floorArea());
+  EXPECT_NE(base.roofUValue(), variant.roofUValue());
+  EXPECT_DOUBLE_EQ(base.heatingOccupiedSetpoint(), variant.heatingOccupiedSetpoint());
+
+  // A variant simulates the same as a model changed through its setters.
+  UserModel changed;
+  changed.load(test_data_path + "/SmallOffice_v2.ism");
+  changed.setFloorArea(1500);
+  auto expected = changed.toMonthlyModel().simulate();
+  auto results = base.withOverrides({{"floorArea", "1500"}}).toMonthlyModel().simulate();
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+      EXPECT_DOUBLE_EQ(expected[i].getEndUse(j), results[i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+      auto fuel = isoResultsEndUseTypes[j].first;
+      auto category = isoResultsEndUseTypes[j].second;
+      EXPECT_DOUBLE_EQ(expected[i].getEndUse(fuel, category), results[i].getEndUse(fuel, category));
+#endif
+    }
+  }
+
+  // Variants of one model may be created and simulated concurrently.
+  const int threadCount = 8;
+  std::vector<double> serial(threadCount), concurrent(threadCount);
+  for (int t = 0; t < threadCount; t++) {
+    auto monthly = base.withOverrides({{"heatingSetpointOccupied", std::to_string(18 + t)}}).toMonthlyModel().simulate();
+    serial[t] = monthly[0].getEndUse(0) + monthly[0].getEndUse(1);
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(std::thread([&, t]() {
+      auto monthly = base.withOverrides({{"heatingSetpointOccupied", std::to_string(18 + t)}}).toMonthlyModel().simulate();
+      concurrent[t] = monthly[0].getEndUse(0) + monthly[0].getEndUse(1);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(serial, concurrent);
+
+  EXPECT_THROW(base.withOverrides({{"floorAreaa", "1500"}}), std::invalid_argument);
+  EXPECT_THROW(base.withOverrides({{"floorArea", "large"}}), std::invalid_argument);
+
+  // Copies share a component until one of them writes to it.
+  CopyOnWrite<Structure> structure;
+  CopyOnWrite<Structure> copy(structure);
+  EXPECT_TRUE(copy.shares(structure));
+  copy.write().setFloorArea(10);
+  EXPECT_FALSE(copy.shares(structure));
+  EXPECT_DOUBLE_EQ(10, copy->floorArea());
+}
+
+TEST_F(ISOModelFixture, UserModelCompileTests) {
+  UserModel userModel;
+  userModel.load(test_data_path + "/SmallOffice_v2.ism");
+  auto plan = userModel.compile();
+
+  auto monthlyExpected = userModel.toMonthlyModel().simulate();
+  auto hourlyExpected = userModel.toHourlyModel().simulate(true);
+
+  // Changes to the model after compilation do not affect the plan.
+  userModel.setFloorArea(1500);
+  userModel.setHeatingOccupiedSetpoint(15);
+
+  // Nor do changes to its weather, although the plan computes its hourly weather later.
+  auto epwData = userModel.epwData();
+  std::vector<double> weather = { epwData->latitude(), epwData->longitude(), (double) epwData->timezone() };
+  for (auto& column : epwData->data()) {
+    weather.insert(weather.end(), column.begin(), column.end());
+  }
+  for (int r = 0; r < 8760; r++) {
+    weather[3 + DBT * 8760 + r] += 5;
+  }
+  userModel.setCompactWeather(true);
+  EXPECT_FALSE(epwData->compactStorage());
+  userModel.loadWeather(8760, weather.data());
+  EXPECT_TRUE(userModel.epwData()->compactStorage());
+  EXPECT_NEAR(epwData->value(DBT, 100) + 5, userModel.epwData()->value(DBT, 100), EpwData::quantizationError(DBT));
+
+  // Simulate the plan concurrently.
+  const int threadCount = 4;
+  std::vector<std::vector<openstudio::EndUses> > monthly(threadCount), hourly(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(std::thread([&, t]() {
+      monthly[t] = plan->simulateMonthly();
+      hourly[t] = plan->simulateHourly(true);
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < threadCount; t++) {
+    ASSERT_EQ(12u, monthly[t].size());
+    ASSERT_EQ(12u, hourly[t].size());
+    for (int i = 0; i < 12; ++i) {
+      for (int j = 0; j < 13; ++j) {
+#ifdef ISOMODEL_STANDALONE
+        EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(j), monthly[t][i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+        EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(j), hourly[t][i].getEndUse(j)) << "Month = " << i << ", End Use = " << endUseNames[j];
+#else
+        auto fuel = isoResultsEndUseTypes[j].first;
+        auto category = isoResultsEndUseTypes[j].second;
+        EXPECT_DOUBLE_EQ(monthlyExpected[i].getEndUse(fuel, category), monthly[t][i].getEndUse(fuel, category));
+        EXPECT_DOUBLE_EQ(hourlyExpected[i].getEndUse(fuel, category), hourly[t][i].getEndUse(fuel, category));
+#endif
+      }
+    }
+  }
+
+  EXPECT_EQ(8760u, plan->simulateHourly().size());
+}
+
+TEST_F(ISOModelFixture, UserModelInvalidSimulationTests) {
+  UserModel userModel;
+  EXPECT_FALSE(userModel.valid());
+  EXPECT_THROW(userModel.toMonthlyModel(), std::invalid_argument);
+  EXPECT_THROW(userModel.toHourlyModel(), std::invalid_argument);
+}
@@ -0,0 +1,215 @@
+/*
+ * UtilityAccounting_GTest.cpp
+ */
+
+#include "gtest/gtest.h"
+
+#include "ISOModelFixture.hpp"
+
+#include "../CsvWriter.hpp"
+#include "../ResultFile.hpp"
+#include "../ThreadPool.hpp"
+#include "../TimeFrame.hpp"
+#include "../UserModel.hpp"
+#include "../UtilityAccounting.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <sstream>
+
+using namespace openstudio::isomodel;
+
+namespace {
+
+const char* const TOU_TARIFF = "name = Small commercial\n"
+                               "fixed = 25\n"
+                               "period = peak, 6-9, 1-5, 12-17 # Summer afternoons\n"
+                               "period = night, 1-12, 0-6, 22-5\n"
+                               "period = shoulder, 1-12, 0-6, 0-23\n"
+                               "energy = peak, 0.22, 1000\n"
+                               "energy = peak, 0.25\n"
+                               "energy = night, 0.05\n"
+                               "energy = shoulder, 0.08\n"
+                               "demand = 12.5\n"
+                               "demand = 8, peak\n";
+
+Tariff parseTariff(const std::string& text)
+{
+  std::istringstream in(text);
+  return Tariff::parse(in);
+}
+
+std::string tariffError(const std::string& text)
+{
+  try {
+    parseTariff(text);
+  } catch (const std::invalid_argument& e) {
+    return e.what();
+  }
+  return std::string();
+}
+
+}
+
+TEST_F(ISOModelFixture, TariffTests)
+{
+  Tariff tariff = parseTariff(TOU_TARIFF);
+  EXPECT_EQ("Small commercial", tariff.name);
+  EXPECT_EQ(25, tariff.fixedCharge);
+  ASSERT_EQ(3u, tariff.periods.size());
+  EXPECT_EQ(0, tariff.periodOf(7, 3, 12));
+  EXPECT_EQ(2, tariff.periodOf(7, 6, 12));
+  EXPECT_EQ(1, tariff.periodOf(1, 0, 23));
+  EXPECT_EQ(1, tariff.periodOf(7, 3, 3));
+  EXPECT_EQ(2, tariff.periodOf(12, 3, 21));
+  ASSERT_EQ(2u, tariff.demandCharges.size());
+  EXPECT_EQ(-1, tariff.demandCharges[0].period);
+  EXPECT_EQ(0, tariff.demandCharges[1].period);
+
+  // 1000 kWh at 0.22 and the rest at 0.25.
+  EXPECT_DOUBLE_EQ(0.22 * 400, tariff.energyCharge(0, 400));
+  EXPECT_DOUBLE_EQ(220 + 0.25 * 500, tariff.energyCharge(0, 1500));
+  EXPECT_DOUBLE_EQ(0.08 * 100, tariff.energyCharge(2, 100));
+
+  // Without periods every hour is in "all", and the default tariff charges nothing.
+  Tariff flat = parseTariff("energy = all, 0.1\n");
+  EXPECT_EQ(0, flat.periodOf(3, 3, 3));
+  EXPECT_DOUBLE_EQ(10, flat.energyCharge(0, 100));
+  EXPECT_EQ(0, Tariff().energyCharge(0, 100));
+
+  EXPECT_NE(std::string::npos, tariffError("energy = peak, 0.1\n").find("Line 1 of the tariff: there is no period \"peak\""));
+  EXPECT_NE(std::string::npos, tariffError("period = a, 1-13, 0-6, 0-23\n").find("Line 1"));
+  EXPECT_NE(std::string::npos, tariffError("period = a, 1-12, 1-5, 0-23\n").find("is in no period"));
+  EXPECT_NE(std::string::npos, tariffError("energy = all, 0.1, 100\n").find("last tier"));
+  EXPECT_NE(std::string::npos, tariffError("energy = all, 0.1, 100\nenergy = all, 0.1, 50\nenergy = all, 1\n").find("do not increase"));
+  EXPECT_NE(std::string::npos, tariffError("energy = all, 0.1\nenergy = all, 0.2\n").find("unlimited"));
+  EXPECT_NE(std::string::npos, tariffError("\n\nrate = 1\n").find("Line 3 of the tariff: Unknown setting"));
+}
+
+TEST_F(ISOModelFixture, EmissionFactorsTests)
+{
+  std::ostringstream csv;
+  csv << "hour,Gas,Electricity\n";
+  for (int hour = 0; hour < 8760; hour++) {
+    csv << hour + 1 << ",0.18," << 0.3 + hour % 24 * 0.01 << "\n";
+  }
+  std::istringstream in(csv.str());
+  EmissionFactors factors = EmissionFactors::parse(in);
+  ASSERT_EQ(8760u, factors.electricity.size());
+  EXPECT_DOUBLE_EQ(0.31, factors.electricity[25]);
+  EXPECT_DOUBLE_EQ(0.18, factors.gas[8759]);
+
+  std::istringstream shortTable("electricity\n0.4\n");
+  EXPECT_THROW(EmissionFactors::parse(shortTable), std::invalid_argument);
+  std::istringstream noFuel("hour,co2\n1,0.4\n");
+  EXPECT_THROW(EmissionFactors::parse(noFuel), std::invalid_argument);
+  EXPECT_THROW(UtilityAccounting(Tariff(), Tariff(), EmissionFactors()).evaluate(std::vector<openstudio::EndUses>(12), 100),
+               std::invalid_argument);
+}
+
+TEST_F(ISOModelFixture, UtilityAccountingTests)
+{
+  UserModel model;
+  model.load(test_data_path + "/SmallOffice_v2.ism");
+  auto hourly = model.toHourlyModel().simulate(false);
+  double floorArea = model.floorArea();
+
+  Tariff electricity = parseTariff(TOU_TARIFF);
+  Tariff gas = parseTariff("fixed = 10\nenergy = all, 0.03, 20000\nenergy = all, 0.02\n");
+  EmissionFactors factors(0.4, 0.18);
+  for (int hour = 0; hour < 8760; hour++) {
+    factors.electricity[hour] += hour % 24 * 0.01;
+  }
+  UtilityAccounting accounting(electricity, gas, factors);
+  UtilityBill bill = accounting.evaluate(hourly, floorArea);
+
+  // The same charges, hour by hour.
+  TimeFrame frame;
+  for (int month = 0; month < 12; month++) {
+    double periodUse[3] = { 0, 0, 0 };
+    double gasUse = 0;
+    double peak = 0;
+    double peakOfPeriod = 0;
+    double emissions[END_USE_COUNT] = { 0 };
+    for (int hour = 0; hour < 8760; hour++) {
+      if (frame.Month[hour] != month + 1) {
+        continue;
+      }
+      int period = electricity.periodOf(frame.Month[hour], frame.DayOfWeek[hour], frame.Hour[hour]);
+      double demand = 0;
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        double use = endUseValue(hourly[hour], endUse) * floorArea;
+        (endUse < 9 ? periodUse[period] : gasUse) += use;
+        demand += endUse < 9 ? use : 0;
+        emissions[endUse] += use * (endUse < 9 ? factors.electricity[hour] : factors.gas[hour]);
+      }
+      peak = std::max(peak, demand);
+      peakOfPeriod = period == 0 ? std::max(peakOfPeriod, demand) : peakOfPeriod;
+    }
+    double electricityCost = 0;
+    double gasCost = 0;
+    double demandCost = 0;
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      (endUse < 9 ? electricityCost : gasCost) += bill.cost[month][endUse];
+      demandCost += bill.demandCost[month][endUse];
+      EXPECT_NEAR(emissions[endUse], bill.emissions[month][endUse], 1e-9 * (1 + emissions[endUse]));
+    }
+    double expectedDemand = 12.5 * peak + 8 * peakOfPeriod;
+    double expected = expectedDemand;
+    for (int period = 0; period < 3; period++) {
+      expected += electricity.energyCharge(period, periodUse[period]);
+    }
+    EXPECT_NEAR(expected, electricityCost, 1e-9 * expected) << month;
+    EXPECT_NEAR(expectedDemand, demandCost, 1e-9 * expectedDemand) << month;
+    EXPECT_NEAR(gas.energyCharge(0, gasUse), gasCost, 1e-9 * gasCost) << month;
+    EXPECT_EQ(25, bill.fixedCost[month][ELECTRICITY_FUEL]);
+    EXPECT_EQ(10, bill.fixedCost[month][GAS_FUEL]);
+    EXPECT_NEAR(electricityCost + gasCost + 35, bill.monthlyCost(month), 1e-9 * bill.monthlyCost(month));
+    // Summer months have peak hours and the building is heated by gas.
+    EXPECT_EQ(month >= 5 && month <= 8, peakOfPeriod > 0) << month;
+    EXPECT_GT(bill.cost[month][9], 0);
+  }
+  EXPECT_GT(bill.annualEmissions(), 0);
+
+  // A batch, from a result file, gives the same bills.
+  std::string resultFile = test_data_path + "/utility_accounting_test.icr";
+  {
+    ResultFileWriter writer(resultFile, 8760);
+    for (int i = 0; i < 3; i++) {
+      ResultFileBuilding building;
+      building.id = "b" + std::to_string(i);
+      building.metadata["floorArea"] = std::to_string(1000 * (i + 1));
+      writer.append(building, hourly);
+    }
+  }
+  ThreadPool pool(2);
+  std::vector<UtilityBill> bills;
+  {
+    ResultFileReader reader(resultFile);
+    bills = accounting.evaluate(reader, pool);
+  }
+  boost::filesystem::remove(resultFile);
+  ASSERT_EQ(3u, bills.size());
+  UtilityBill expectedBill = accounting.evaluate(hourly, 3000);
+  for (int month = 0; month < 12; month++) {
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      EXPECT_DOUBLE_EQ(expectedBill.cost[month][endUse], bills[2].cost[month][endUse]);
+      EXPECT_DOUBLE_EQ(expectedBill.emissions[month][endUse], bills[2].emissions[month][endUse]);
+    }
+  }
+
+  std::ostringstream out;
+  {
+    CsvWriter writer(out);
+    writeBills(writer, { "b0", "b1", "b2" }, bills);
+  }
+  std::istringstream lines(out.str());
+  std::string line;
+  std::getline(lines, line);
+  EXPECT_EQ(0u, line.find("id,month,cost,emissions,ElecFixedCost,GasFixedCost,ElecHeatCost"));
+  int rows = 0;
+  while (std::getline(lines, line)) {
+    rows++;
+  }
+  EXPECT_EQ(36, rows);
+}
@@ -0,0 +1,198 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+// The pool and queue index of the current thread if it is a worker.
+thread_local ThreadPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+}
+
+// State of one parallelFor call, shared by the tasks running its ranges.
+struct ThreadPool::Loop
+{
+  const std::function<void(size_t)>* body;
+  size_t grain;
+  std::atomic<size_t> remaining;
+  std::atomic<bool> failed;
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+ThreadPool::ThreadPool(unsigned threadCount) : m_next(0), m_pending(0), m_stop(false)
+{
+  if (threadCount == 0) {
+    threadCount = hardwareThreads();
+  }
+  for (unsigned i = 0; i < threadCount; i++) {
+    m_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+  }
+  for (unsigned i = 0; i < threadCount; i++) {
+    m_threads.push_back(std::thread(&ThreadPool::work, this, (size_t) i));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+unsigned ThreadPool::hardwareThreads()
+{
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::post(std::function<void()> task)
+{
+  size_t index = (currentPool == this) ? currentQueue : m_next++ % m_queues.size();
+  {
+    std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+    m_queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    ++m_pending;
+  }
+  m_wake.notify_one();
+}
+
+bool ThreadPool::take(size_t preferred, std::function<void()>& task)
+{
+  size_t count = m_queues.size();
+  if (preferred < count) {
+    Queue& own = *m_queues[preferred];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --m_pending;
+      return true;
+    }
+  }
+  size_t start = (preferred < count) ? preferred + 1 : m_next.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; i++) {
+    Queue& victim = *m_queues[(start + i) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --m_pending;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runPendingTask()
+{
+  std::function<void()> task;
+  if (!take(currentPool == this ? currentQueue : m_queues.size(), task)) {
+    return false;
+  }
+  task();
+  return true;
+}
+
+void ThreadPool::work(size_t index)
+{
+  currentPool = this;
+  currentQueue = index;
+  std::function<void()> task;
+  for (;;) {
+    if (take(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock, [this]() { return m_stop || m_pending > 0; });
+    if (m_stop && m_pending == 0) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::runRange(const std::shared_ptr<Loop>& loop, size_t begin, size_t end)
+{
+  // Split off the upper halves for other workers to steal.
+  while (end - begin > loop->grain) {
+    size_t middle = begin + (end - begin) / 2;
+    std::shared_ptr<Loop> shared = loop;
+    post([this, shared, middle, end]() { runRange(shared, middle, end); });
+    end = middle;
+  }
+  for (size_t i = begin; i < end && !loop->failed.load(std::memory_order_relaxed); i++) {
+    try {
+      (*loop->body)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(loop->mutex);
+      if (!loop->failed) {
+        loop->error = std::current_exception();
+        loop->failed = true;
+      }
+    }
+  }
+  if (loop->remaining.fetch_sub(end - begin) == end - begin) {
+    std::lock_guard<std::mutex> lock(loop->mutex);
+    loop->done.notify_all();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grain)
+{
+  if (count == 0) {
+    return;
+  }
+  auto loop = std::make_shared<Loop>();
+  loop->body = &body;
+  loop->grain = std::max<size_t>(1, grain);
+  loop->remaining = count;
+  loop->failed = false;
+
+  runRange(loop, 0, count);
+  // Help with the queued ranges (and whatever else is queued) until all have finished.
+  while (loop->remaining > 0) {
+    if (runPendingTask()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait_for(lock, std::chrono::milliseconds(1), [&loop]() { return loop->remaining == 0; });
+  }
+  if (loop->error) {
+    std::rethrow_exception(loop->error);
+  }
+}
+
+}
+}
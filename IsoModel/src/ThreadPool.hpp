@@ -0,0 +1,121 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_THREAD_POOL_HPP
+#define ISOMODEL_THREAD_POOL_HPP
+
+#include "ISOModelAPI.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+/**
+ * A work stealing thread pool. Each worker has its own task queue: tasks posted from a
+ * worker go to the back of its own queue and it runs them newest first, while idle
+ * workers steal the oldest tasks from the other queues. parallelFor splits a range in
+ * halves that are posted as stealable tasks, so large loops spread over all of the
+ * workers without a central queue.
+ */
+class ISOMODEL_API ThreadPool
+{
+public:
+  /**
+   * Starts threadCount workers. 0, the default, starts one per hardware thread.
+   */
+  explicit ThreadPool(unsigned threadCount = 0);
+
+  /**
+   * Runs the tasks still queued and stops the workers.
+   */
+  ~ThreadPool();
+
+  /**
+   * Number of worker threads.
+   */
+  unsigned size() const {
+    return (unsigned) m_threads.size();
+  }
+
+  /**
+   * Queues a task. Tasks must not throw; use parallelFor or a std::packaged_task to get
+   * exceptions back to the caller.
+   */
+  void post(std::function<void()> task);
+
+  /**
+   * Calls body(i) for every i in [0, count) on the workers and waits for all of the
+   * calls to finish. The calling thread runs queued tasks while it waits, so
+   * parallelFor may be called from a task. Ranges of up to grain indices run as one
+   * task. If a call throws, the remaining indices are skipped and the first exception
+   * is rethrown.
+   */
+  void parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grain = 1);
+
+  /**
+   * Runs one queued task on the calling thread, if there is one. Returns true if a task
+   * ran.
+   */
+  bool runPendingTask();
+
+  /**
+   * The number of hardware threads, at least 1.
+   */
+  static unsigned hardwareThreads();
+
+private:
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator=(const ThreadPool&);
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  struct Loop;
+
+  void work(size_t index);
+  // Takes a task, from the back of queue preferred (if it is a valid index) or else from
+  // the front of another queue.
+  bool take(size_t preferred, std::function<void()>& task);
+  void runRange(const std::shared_ptr<Loop>& loop, size_t begin, size_t end);
+
+  std::vector<std::unique_ptr<Queue> > m_queues;
+  std::vector<std::thread> m_threads;
+  std::atomic<size_t> m_next;
+  // Tasks queued but not yet taken. Incremented under m_sleepMutex so that a worker
+  // going to sleep cannot miss a new task.
+  std::atomic<size_t> m_pending;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  bool m_stop;
+};
+
+}
+}
+#endif
@@ -18,13 +18,64 @@
  **********************************************************************/
 
 #include "UserModel.hpp"
+#include "IsmSchema.hpp"
+#include "BinaryArchive.hpp"
+
+#include <cstring>
 
 using namespace std;
 namespace openstudio {
 namespace isomodel {
 
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = { 'I', 'S', 'M', 'S', 'N', 'A', 'P', 'S' };
+
+// Must be incremented whenever a serialize() member list changes.
+const uint32_t SNAPSHOT_VERSION = 1;
+
+template<class T>
+void serializeComponent(BinaryWriter& ar, CopyOnWrite<T>& component)
+{
+  // Writing does not modify the component, so it need not be unshared.
+  const_cast<T&>(*component).serialize(ar);
+}
+
+template<class T>
+void serializeComponent(BinaryReader& ar, CopyOnWrite<T>& component)
+{
+  component.write().serialize(ar);
+}
+
+// A copy of weather held in compact storage or not. Weather loaded from a file is
+// loaded from it again when first needed; weather loaded from an array is copied.
+std::shared_ptr<EpwData> copyWeather(EpwData& source, bool compact)
+{
+  std::string weatherFile = source.sourceFile();
+  BinaryWriter out;
+  source.serialize(out, weatherFile.empty());
+  BinaryReader in(out.data(), "Weather data");
+  auto copy = std::make_shared<EpwData>();
+  copy->serialize(in, weatherFile.empty());
+  copy->setCompactStorage(compact);
+  if (!weatherFile.empty()) {
+    copy->setDeferredFile(weatherFile);
+  }
+  return copy;
+}
+
+// Empty weather in the storage mode of previous.
+std::shared_ptr<EpwData> newWeather(const EpwData& previous)
+{
+  auto edata = std::make_shared<EpwData>();
+  edata->setCompactStorage(previous.compactStorage());
+  return edata;
+}
+
+}
+
 UserModel::UserModel() :
-    _weather_cache(), _weather(new WeatherData()), _edata(new EpwData())
+    _weather_cache(), _weather(new WeatherData()), _edata(new EpwData()), _valid(false)
 {
 }
 
@@ -44,312 +95,58 @@ void UserModel::setCoreSimulationProperties(Simulation& sim) const {
   sim.setEpwData(_edata); // TODO: should this stay a shared pointer between the UserModel and the MonthlyModel?
   sim.setSimulationSettings(simSettings);
   sim.setPhysicalQuantities(phys);
+  sim.setResultCache(_resultCache);
 }
 
 HourlyModel UserModel::toHourlyModel() const
 {
-  HourlyModel sim = HourlyModel();
   if (!_valid) {
-    return *((HourlyModel*) NULL);
+    throw std::invalid_argument("Cannot simulate an invalid UserModel.");
   }
+  HourlyModel sim = HourlyModel();
   
   setCoreSimulationProperties(sim);
   return sim;
 }
 
-MonthlyModel UserModel::toMonthlyModel() const
+std::shared_ptr<const SimulationPlan> UserModel::compile() const
 {
+  if (!_valid) {
+    throw std::invalid_argument("Cannot compile an invalid UserModel.");
+  }
+  return std::make_shared<SimulationPlan>(toHourlyModel().plan(), toMonthlyModel(), _edata);
+}
 
-  MonthlyModel sim;
+MonthlyModel UserModel::toMonthlyModel() const
+{
 
   if (!valid()) {
-    std::cout << "Invalid" << std::endl;
-    return *((MonthlyModel*) NULL);
+    throw std::invalid_argument("Cannot simulate an invalid UserModel.");
   }
 
+  MonthlyModel sim;
+
   setCoreSimulationProperties(sim);
 
   return sim;
 }
-//http://stackoverflow.com/questions/10051679/c-tokenize-string
-std::vector<std::string> inline stringSplit(const std::string &source, char delimiter = ' ', bool keepEmpty = false)
-{
-  std::vector<std::string> results;
-
-  size_t prev = 0;
-  size_t next = 0;
-  if (source.size() == 0)
-    return results;
-  while ((next = source.find_first_of(delimiter, prev)) != std::string::npos) {
-    if (keepEmpty || (next - prev != 0)) {
-      results.push_back(source.substr(prev, next - prev));
-    }
-    prev = next + 1;
-  }
-
-  if (prev < source.size()) {
-    results.push_back(source.substr(prev));
-  }
-
-  return results;
-}
-
-void UserModel::initializeStructure(const Properties& buildingParams)
-{
-  initializeParameter(&UserModel::setWallArea, buildingParams, "wallArea", true);
-  initializeParameter(&UserModel::setWallU, buildingParams, "wallU", true);
-  initializeParameter(&UserModel::setWallThermalEmissivity, buildingParams, "wallEmissivity", true);
-  initializeParameter(&UserModel::setWallSolarAbsorption, buildingParams, "wallAbsorption", true);
-  initializeParameter(&UserModel::setWindowArea, buildingParams, "windowArea", true);
-  initializeParameter(&UserModel::setWindowU, buildingParams, "windowU", true);
-  initializeParameter(&UserModel::setWindowSHGC, buildingParams, "windowSHGC", true);
-  initializeParameter(&UserModel::setWindowSCF, buildingParams, "windowSCF", true);
-  initializeParameter(&UserModel::setWindowSDF, buildingParams, "windowSDF", true);
-}
-
 void UserModel::initializeParameters(const Properties& buildingParams)
 {
-  initializeParameter(&UserModel::setTerrainClass, buildingParams, "terrainclass", true);
-  initializeParameter(&UserModel::setBuildingHeight, buildingParams, "buildingheight", true);
-  initializeParameter(&UserModel::setFloorArea, buildingParams, "floorarea", true);
-  initializeParameter(&UserModel::setBuildingOccupancyFrom, buildingParams, "occupancydayfirst", true);
-  initializeParameter(&UserModel::setBuildingOccupancyTo, buildingParams, "occupancydaylast", true);
-  initializeParameter(&UserModel::setEquivFullLoadOccupancyFrom, buildingParams, "occupancyhourfirst", true);
-  initializeParameter(&UserModel::setEquivFullLoadOccupancyTo, buildingParams, "occupancyhourlast", true);
-  initializeParameter(&UserModel::setPeopleDensityOccupied, buildingParams, "peopledensityoccupied", true);
-  initializeParameter(&UserModel::setPeopleDensityUnoccupied, buildingParams, "peopledensityunoccupied", true);
-  initializeParameter(&UserModel::setLightingPowerIntensityOccupied, buildingParams, "lightingpowerdensityoccupied", true);
-  initializeParameter(&UserModel::setLightingPowerIntensityUnoccupied, buildingParams, "lightingpowerdensityunoccupied", true);
-  initializeParameter(&UserModel::setElecPowerAppliancesOccupied, buildingParams, "electricappliancepowerdensityoccupied", true);
-  initializeParameter(&UserModel::setElecPowerAppliancesUnoccupied, buildingParams, "electricappliancepowerdensityunoccupied", true);
-  initializeParameter(&UserModel::setGasPowerAppliancesOccupied, buildingParams, "gasappliancepowerdensityoccupied", true);
-  initializeParameter(&UserModel::setGasPowerAppliancesUnoccupied, buildingParams, "gasappliancepowerdensityunoccupied", true);
-  initializeParameter(&UserModel::setExteriorLightingPower, buildingParams, "exteriorlightingpower", true);
-  initializeParameter(&UserModel::setHvacWasteFactor, buildingParams, "hvacwastefactor", true);
-  initializeParameter(&UserModel::setHvacHeatingLossFactor, buildingParams, "hvacheatinglossfactor", true);
-  initializeParameter(&UserModel::setHvacCoolingLossFactor, buildingParams, "hvaccoolinglossfactor", true);
-  initializeParameter(&UserModel::setDaylightSensorSystem, buildingParams, "daylightsensordimmingfraction", true);
-  initializeParameter(&UserModel::setLightingOccupancySensorSystem, buildingParams, "lightingoccupancysensordimmingfraction", true);
-  initializeParameter(&UserModel::setConstantIlluminationControl, buildingParams, "constantilluminationcontrolmultiplier", true);
-  initializeParameter(&UserModel::setCoolingSystemCOP, buildingParams, "coolingsystemcop", true);
-  initializeParameter(&UserModel::setCoolingSystemIPLVToCOPRatio, buildingParams, "coolingsystemiplvtocopratio", true);
-
-  initializeParameter(&UserModel::setHeatingSystemEfficiency, buildingParams, "heatingsystemefficiency", true);
-
-  // Create the named function pointers to disambiguate which overload of setter we want.
-  // TODO: Switch the keyword based properties use enums throughout, rather than the current
-  // combination of strings and doubles. If the setter has a consistent interface and doesn't
-  // have to be overloaded, we don't have to do this disambiguation. BAA@2015-06-24
-  void(UserModel::*setHeatingEnergyCarrierWithString)(std::string) = &UserModel::setHeatingEnergyCarrier;
-  initializeParameter(setHeatingEnergyCarrierWithString, buildingParams, "heatingfueltype", true);
-
-  void(UserModel::*setVentilationTypeWithString)(std::string) = &UserModel::setVentilationType;
-  initializeParameter(setVentilationTypeWithString, buildingParams, "ventilationtype", true);
-
-  void(UserModel::*setDhwEnergyCarrierWithString)(std::string) = &UserModel::setDhwEnergyCarrier;
-  initializeParameter(setDhwEnergyCarrierWithString, buildingParams, "dhwfueltype", true);
-
-  void(UserModel::*setBemTypeWithString)(std::string) = &UserModel::setBemType;
-  initializeParameter(setBemTypeWithString, buildingParams, "bemtype", true);
-
-  initializeParameter(&UserModel::setFreshAirFlowRate, buildingParams, "ventilationintakerateoccupied", true);
-  initializeParameter(&UserModel::setSupplyExhaustRate, buildingParams, "ventilationExhaustRateOccupied", true);
-  initializeParameter(&UserModel::setHeatRecovery, buildingParams, "heatrecovery", true);
-  initializeParameter(&UserModel::setExhaustAirRecirclation, buildingParams, "exhaustairrecirculation", true);
-  initializeParameter(&UserModel::setBuildingAirLeakage, buildingParams, "infiltrationrateoccupied", true);
-  initializeParameter(&UserModel::setDhwDemand, buildingParams, "dhwdemand", true);
-  initializeParameter(&UserModel::setDhwEfficiency, buildingParams, "dhwsystemefficiency", true);
-  initializeParameter(&UserModel::setDhwDistributionEfficiency, buildingParams, "dhwdistributionefficiency", true);
-
-  initializeParameter(&UserModel::setInteriorHeatCapacity, buildingParams, "interiorheatcapacity", true);
-  initializeParameter(&UserModel::setExteriorHeatCapacity, buildingParams, "exteriorheatcapacity", true);
-  initializeParameter(&UserModel::setHeatingPumpControl, buildingParams, "heatingpumpcontrol", true);
-  initializeParameter(&UserModel::setCoolingPumpControl, buildingParams, "coolingpumpcontrol", true);
-  initializeParameter(&UserModel::setHeatGainPerPerson, buildingParams, "heatgainperperson", true);
-  initializeParameter(&UserModel::setSpecificFanPower, buildingParams, "specificfanpower", true);
-  initializeParameter(&UserModel::setFanFlowControlFactor, buildingParams, "fanflowcontrolfactor", true);
-  initializeParameter(&UserModel::setCoolingOccupiedSetpoint, buildingParams, "coolingsetpointoccupied", true);
-  initializeParameter(&UserModel::setCoolingUnoccupiedSetpoint, buildingParams, "coolingsetpointunoccupied", true);
-  initializeParameter(&UserModel::setHeatingOccupiedSetpoint, buildingParams, "heatingsetpointoccupied", true);
-  initializeParameter(&UserModel::setHeatingUnoccupiedSetpoint, buildingParams, "heatingsetpointunoccupied", true);
-
-#if (USE_NEW_BUILDING_PARAMS)
-  initializeParameter(&UserModel::setVentilationIntakeRateUnoccupied, buildingParams, "ventilationIntakeRateUnoccupied", true);
-  initializeParameter(&UserModel::setVentilationExhaustRateUnoccupied, buildingParams, "ventilationExhaustRateUnoccupied", true);
-  initializeParameter(&UserModel::setInfiltrationRateUnoccupied, buildingParams, "infiltrationRateUnoccupied", true);
-  initializeParameter(&UserModel::setLightingPowerFixedOccupied, buildingParams, "lightingPowerFixedOccupied", true);
-  initializeParameter(&UserModel::setLightingPowerFixedUnoccupied, buildingParams, "lightingPowerFixedUnoccupied", true);
-  initializeParameter(&UserModel::setElectricAppliancePowerFixedOccupied, buildingParams, "electricAppliancePowerFixedOccupied", true);
-  initializeParameter(&UserModel::setElectricAppliancePowerFixedUnoccupied, buildingParams, "electricAppliancePowerFixedUnoccupied", true);
-  initializeParameter(&UserModel::setGasAppliancePowerFixedOccupied, buildingParams, "gasAppliancePowerFixedOccupied", true);
-  initializeParameter(&UserModel::setGasAppliancePowerFixedUnoccupied, buildingParams, "gasAppliancePowerFixedUnoccupied", true);
-
-  initializeParameter(&UserModel::setScheduleFilePath, buildingParams, "schedulefilepath", true);
-#endif
-
-  initializeParameter(&UserModel::setWeatherFilePath, buildingParams, "weatherfilepath", true);
-
-  // Optional properties with hard-coded default values:
-  initializeParameter(&UserModel::setExternalEquipment, buildingParams, "externalequipment", false);
-  initializeParameter(&UserModel::setForcedAirCooling, buildingParams, "forcedaircooling", false);
-  initializeParameter(&UserModel::setT_cl_ctrl_flag, buildingParams, "t_cl_ctrl_flag", false);
-  initializeParameter(&UserModel::setDT_supp_cl, buildingParams, "dt_supp_cl", false);
-  initializeParameter(&UserModel::setDC_YesNo, buildingParams, "dc_yesno", false);
-  initializeParameter(&UserModel::setEta_DC_network, buildingParams, "eta_dc_network", false);
-  initializeParameter(&UserModel::setEta_DC_COP, buildingParams, "eta_dc_cop", false);
-  initializeParameter(&UserModel::setEta_DC_frac_abs, buildingParams, "eta_dc_frac_abs", false);
-  initializeParameter(&UserModel::setEta_DC_COP_abs, buildingParams, "eta_dc_cop_abs", false);
-  initializeParameter(&UserModel::setFrac_DC_free, buildingParams, "frac_dc_free", false);
-  initializeParameter(&UserModel::setE_pumps_cl, buildingParams, "e_pumps_cl", false);
-  initializeParameter(&UserModel::setForcedAirHeating, buildingParams, "forcedairheating", false);
-  initializeParameter(&UserModel::setDT_supp_ht, buildingParams, "dt_supp_ht", false);
-  initializeParameter(&UserModel::setE_pumps_ht, buildingParams, "e_pumps_ht", false);
-  initializeParameter(&UserModel::setT_ht_ctrl_flag, buildingParams, "t_ht_ctrl_flag", false);
-  initializeParameter(&UserModel::setA_H0, buildingParams, "a_h0", false);
-  initializeParameter(&UserModel::setTau_H0, buildingParams, "tau_h0", false);
-  initializeParameter(&UserModel::setDH_YesNo, buildingParams, "dh_yesno", false);
-  initializeParameter(&UserModel::setEta_DH_network, buildingParams, "eta_dh_network", false);
-  initializeParameter(&UserModel::setEta_DH_sys, buildingParams, "eta_dh_sys", false);
-  initializeParameter(&UserModel::setFrac_DH_free, buildingParams, "frac_dh_free", false);
-  initializeParameter(&UserModel::setDhw_tset, buildingParams, "dhw_tset", false);
-  initializeParameter(&UserModel::setDhw_tsupply, buildingParams, "dhw_tsupply", false);
-  initializeParameter(&UserModel::setN_day_start, buildingParams, "n_day_start", false);
-  initializeParameter(&UserModel::setN_day_end, buildingParams, "n_day_end", false);
-  initializeParameter(&UserModel::setN_weeks, buildingParams, "n_weeks", false);
-  initializeParameter(&UserModel::setElecInternalGains, buildingParams, "elecinternalgains", false);
-  initializeParameter(&UserModel::setPermLightPowerDensity, buildingParams, "permlightpowerdensity", false);
-  initializeParameter(&UserModel::setPresenceSensorAd, buildingParams, "presencesensorad", false);
-  initializeParameter(&UserModel::setAutomaticAd, buildingParams, "automaticad", false);
-  initializeParameter(&UserModel::setPresenceAutoAd, buildingParams, "presenceautoad", false);
-  initializeParameter(&UserModel::setManualSwitchAd, buildingParams, "manualswitchad", false);
-  initializeParameter(&UserModel::setPresenceSensorLux, buildingParams, "presencesensorlux", false);
-  initializeParameter(&UserModel::setAutomaticLux, buildingParams, "automaticlux", false);
-  initializeParameter(&UserModel::setPresenceAutoLux, buildingParams, "presenceautolux", false);
-  initializeParameter(&UserModel::setManualSwitchLux, buildingParams, "manualswitchlux", false);
-  initializeParameter(&UserModel::setNaturallyLightedArea, buildingParams, "naturallylightedarea", false);
-  initializeParameter(&UserModel::setRhoCpAir, buildingParams, "rhocpair", false);
-  initializeParameter(&UserModel::setRhoCpWater, buildingParams, "rhocpwater", false);
-  initializeParameter(&UserModel::setPhiIntFractionToAirNode, buildingParams, "phiintfractiontoairnode", false);
-  initializeParameter(&UserModel::setPhiSolFractionToAirNode, buildingParams, "phisolfractiontoairnode", false);
-  initializeParameter(&UserModel::setHci, buildingParams, "hci", false);
-  initializeParameter(&UserModel::setHri, buildingParams, "hri", false);
-  initializeParameter(&UserModel::setR_se, buildingParams, "r_se", false);
-  initializeParameter(&UserModel::setIrradianceForMaxShadingUse, buildingParams, "irradianceformaxshadinguse", false);
-  initializeParameter(&UserModel::setShadingFactorAtMaxUse, buildingParams, "shadingfactoratmaxuse", false);
-  initializeParameter(&UserModel::setTotalAreaPerFloorArea, buildingParams, "totalareaperfloorarea", false);
-  initializeParameter(&UserModel::setWin_ff, buildingParams, "win_ff", false);
-  initializeParameter(&UserModel::setWin_F_W, buildingParams, "win_f_w", false);
-  initializeParameter(&UserModel::setR_sc_ext, buildingParams, "r_sc_ext", false);
-  initializeParameter(&UserModel::setVentPreheatDegC, buildingParams, "ventpreheatdegc", false);
-  initializeParameter(&UserModel::setN50, buildingParams, "n50", false);
-  initializeParameter(&UserModel::setHzone, buildingParams, "hzone", false);
-  initializeParameter(&UserModel::setP_exp, buildingParams, "p_exp", false);
-  initializeParameter(&UserModel::setZone_frac, buildingParams, "zone_frac", false);
-  initializeParameter(&UserModel::setStack_exp, buildingParams, "stack_exp", false);
-  initializeParameter(&UserModel::setStack_coeff, buildingParams, "stack_coeff", false);
-  initializeParameter(&UserModel::setWind_exp, buildingParams, "wind_exp", false);
-  initializeParameter(&UserModel::setWind_coeff, buildingParams, "wind_coeff", false);
-  initializeParameter(&UserModel::setDCp, buildingParams, "dcp", false);
-  initializeParameter(&UserModel::setVent_rate_flag, buildingParams, "vent_rate_flag", false);
-  initializeParameter(&UserModel::setH_ve, buildingParams, "h_ve", false);
-}
-
-void UserModel::initializeParameter(void(UserModel::*setProp)(double), const Properties& props, std::string propertyName, bool required) {
-  if (auto prop = props.getPropertyAsDouble(propertyName)) {
-    (this->*setProp)(*prop);
-  } else if (required) {
-    throw std::invalid_argument("Required property " + propertyName + " missing in .ism file.");
-  } 
-}
-
-void UserModel::initializeParameter(void(UserModel::*setProp)(int), const Properties& props, std::string propertyName, bool required) {
-  if (auto prop = props.getPropertyAsInt(propertyName)) {
-    (this->*setProp)(*prop);
-  } else if (required) {
-    throw std::invalid_argument("Required property " + propertyName + " missing in .ism file.");
-  } 
-}
-
-void UserModel::initializeParameter(void(UserModel::*setProp)(bool), const Properties& props, std::string propertyName, bool required) {
-  if (auto prop = props.getPropertyAsBool(propertyName)) {
-    (this->*setProp)(*prop);
-  } else if (required) {
-    throw std::invalid_argument("Required property " + propertyName + " missing in .ism file.");
-  } 
+  bindIsmProperties(*this, buildingParams);
 }
 
-void UserModel::initializeParameter(void(UserModel::*setProp)(const Vector&), const Properties& props, std::string propertyName, bool required) {
-  Vector vec;
-  if (props.getPropertyAsDoubleVector(propertyName, vec)) {
-    // TODO: Update the .ism format order to match the order used internall so we don't
-    // have to do this reordering. BAA@2015-06-24.
-    northToSouth(vec);
-    (this->*setProp)(vec);
-  } else if (required) {
-    throw std::invalid_argument("Required property " + propertyName + " missing in .ism file.");
-  } 
-}
-
-void UserModel::initializeParameter(void(UserModel::*setProp)(std::string), const Properties& props, std::string propertyName, bool required) {
-  if (auto prop = props.getProperty(propertyName)) {
-    (this->*setProp)(*prop);
-  } else if (required) {
-    throw std::invalid_argument("Required property " + propertyName + " missing in .ism file.");
-  } 
-}
-
-void UserModel::northToSouth(Vector& vec) {
-  // .ism file is N, NE, E, SE, S, SW, W, NW, Roof
-  // Structure is S, SE, E, NE, N, NW, W, SW, Roof
-  double temp;
-
-  // Swap 0 and 4 (N and S).
-  temp = vec[0];
-  vec[0] = vec[4];
-  vec[4] = temp;
-
-  // Swap 1 and 3 (NE and SE).
-  temp = vec[1];
-  vec[1] = vec[3];
-  vec[3] = temp;
-  
-  // Swap 5 and 7 (SW and NW).
-  temp = vec[5];
-  vec[5] = vec[7];
-  vec[7] = temp;
-};
-
 void UserModel::loadBuilding(std::string buildingFile)
 {
   Properties buildingParams(buildingFile);
   initializeParameters(buildingParams);
-  initializeStructure(buildingParams);
 }
 
 void UserModel::loadBuilding(std::string buildingFile, std::string defaultsFile)
 {
   Properties buildingParams(buildingFile, defaultsFile);
   initializeParameters(buildingParams);
-  initializeStructure(buildingParams);
 }
 
-int UserModel::weatherState(std::string header)
-{
-  if (!header.compare("solar"))
-    return 1;
-  else if (!header.compare("hdbt"))
-    return 2;
-  else if (!header.compare("hEgh"))
-    return 3;
-  else if (!header.compare("mEgh"))
-    return 4;
-  else if (!header.compare("mdbt"))
-    return 5;
-  else if (!header.compare("mwind"))
-    return 6;
-  else
-    return -1;
-}
 std::string UserModel::resolveFilename(std::string baseFile, std::string relativeFile)
 {
   unsigned int lastSeparator = 0;
@@ -391,9 +188,18 @@ void UserModel::loadWeather()
     }
   }
 
-  _edata->loadData(weatherFilename);
-  initializeSolar();
-  location.setWeatherData(_weather);
+  // The weather objects are replaced rather than reloaded, since plans and variants of
+  // this model may share them.
+  _edata = newWeather(*_edata);
+  _weather = make_shared<WeatherData>();
+
+  // Only the monthly averages are computed now. The hourly data is parsed the first
+  // time an hourly simulation (or anything else) asks the EpwData for it.
+  if (!MonthlyWeatherReducer::reduceFile(weatherFilename, *_edata, *_weather)) {
+    _edata->loadData(weatherFilename);
+    initializeSolar();
+  }
+  location.write().setWeatherData(_weather);
 }
 
 void UserModel::loadAndSetWeather()
@@ -402,6 +208,114 @@ void UserModel::loadAndSetWeather()
   _valid = true;
 }
 
+void UserModel::setCompactWeather(bool compact)
+{
+  if (compact != _edata->compactStorage()) {
+    _edata = copyWeather(*_edata, compact);
+  }
+}
+
+void UserModel::setWeather(std::shared_ptr<WeatherData> weather, std::shared_ptr<EpwData> epwData)
+{
+  _weather = weather;
+  _edata = epwData;
+  location.write().setWeatherData(_weather);
+}
+
+UserModel UserModel::withOverrides(const Properties& overrides) const
+{
+  UserModel variant(*this);
+  std::string unknown, invalid;
+  for (auto key = overrides.keys_begin(); key != overrides.keys_end(); ++key) {
+    const IsmProperty* property = findIsmProperty(*key);
+    if (property == nullptr) {
+      unknown += (unknown.empty() ? "" : ", ") + *key;
+    } else if (property->bind(variant, overrides, *key) != ISM_BOUND) {
+      invalid += (invalid.empty() ? "" : ", ") + *key;
+    }
+  }
+  if (!unknown.empty() || !invalid.empty()) {
+    std::string message;
+    if (!unknown.empty()) {
+      message = "Unknown override properties: " + unknown + ".";
+    }
+    if (!invalid.empty()) {
+      message += (message.empty() ? "" : " ") + std::string("Invalid override values: ") + invalid + ".";
+    }
+    throw std::invalid_argument(message);
+  }
+  return variant;
+}
+
+UserModel UserModel::withOverrides(std::initializer_list<std::pair<std::string, std::string> > overrides) const
+{
+  Properties props;
+  for (auto& override : overrides) {
+    props.putProperty(override.first, override.second);
+  }
+  return withOverrides(props);
+}
+
+template<class Archive>
+void UserModel::serialize(Archive& ar)
+{
+  ar & _valid & _weatherFilePath & _scheduleFilePath & dataFile;
+  serializeComponent(ar, pop);
+  serializeComponent(ar, location);
+  serializeComponent(ar, lights);
+  serializeComponent(ar, building);
+  serializeComponent(ar, structure);
+  serializeComponent(ar, heating);
+  serializeComponent(ar, cooling);
+  serializeComponent(ar, ventilation);
+  serializeComponent(ar, phys);
+  serializeComponent(ar, simSettings);
+  _weather->serialize(ar);
+}
+
+void UserModel::saveSnapshot(const std::string& snapshotFile) const
+{
+  BinaryWriter out;
+  out.bytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  out.u32(SNAPSHOT_VERSION);
+  // Writing does not modify the model.
+  const_cast<UserModel*>(this)->serialize(out);
+
+  // Weather loaded from a file is referenced by its absolute path.
+  std::string weatherFile = _edata->sourceFile();
+  if (!weatherFile.empty()) {
+    weatherFile = boost::filesystem::absolute(weatherFile).string();
+  }
+  out.text(weatherFile);
+  _edata->serialize(out, weatherFile.empty());
+  out.save(snapshotFile, "snapshot");
+}
+
+void UserModel::loadSnapshot(const std::string& snapshotFile)
+{
+  std::string data = BinaryReader::load(snapshotFile, "snapshot");
+  BinaryReader in(data, "Snapshot file '" + snapshotFile + "'");
+  if (std::memcmp(in.take(sizeof(SNAPSHOT_MAGIC)), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+    throw std::invalid_argument("'" + snapshotFile + "' is not a UserModel snapshot.");
+  }
+  uint32_t version = in.u32();
+  if (version != SNAPSHOT_VERSION) {
+    throw std::invalid_argument("Unsupported snapshot version " + std::to_string(version) + " in '" + snapshotFile + "'.");
+  }
+
+  UserModel loaded;
+  loaded.serialize(in);
+  std::string weatherFile = in.text();
+  loaded._edata->serialize(in, weatherFile.empty());
+  if (!weatherFile.empty()) {
+    loaded._edata->setDeferredFile(weatherFile);
+  }
+  loaded.location.write().setWeatherData(loaded._weather);
+  loaded._weather_cache.swap(_weather_cache);
+  loaded._resultCache = _resultCache;
+  *this = loaded;
+}
+
 bool LatLon::operator <(const LatLon& rhs) const {
   if (lat < rhs.lat) return true;
   if (lat > rhs.lat) return false;
@@ -422,6 +336,7 @@ void UserModel::loadWeather(int block_size, double* weather_data)
     //std::cout << "not in cache" << std::endl;
     _weather = make_shared<WeatherData>();
     _weather_cache.insert(make_pair(latlon, _weather));
+    _edata = newWeather(*_edata);
     _edata->loadData(block_size, weather_data);
     initializeSolar();
   } else {
@@ -429,15 +344,17 @@ void UserModel::loadWeather(int block_size, double* weather_data)
     _weather = iter->second;
   }
 
-  location.setWeatherData(_weather);
+  location.write().setWeatherData(_weather);
 
   _valid = true;
 }
 
 void UserModel::initializeSolar()
 {
+  TimeFrame frame;
+  SolarRadiation pos(&frame, _edata.get());
+  pos.Calculate();
 
-  int state = 0, row = 0;
   Matrix _msolar(12, 8);
   Matrix _mhdbt(12, 24);
   Matrix _mhEgh(12, 24);
@@ -445,51 +362,22 @@ void UserModel::initializeSolar()
   Vector _mdbt(12);
   Vector _mwind(12);
 
-  string line;
-  std::vector<std::string> linesplit;
-
-  std::stringstream inputFile(_edata->toISOData());
-
-  while (inputFile.good()) {
-    getline(inputFile, line);
-    if (line.size() > 0 && line[0] == '#')
-      continue;
-    linesplit = stringSplit(line, ',', true);
-    if (linesplit.size() == 0) {
-      continue;
-    } else if (linesplit.size() == 1) {
-      state = weatherState(linesplit[0]);
-      row = 0;
-    } else if (row < 12) {
-      switch (state) {
-      case 1: //solar = [12 x 8] mean monthly total solar radiation (W/m2) on a vertical surface for each of the 8 cardinal directions
-        for (unsigned int c = 1; c < linesplit.size() && c < 9; c++) {
-          _msolar(row, c - 1) = atof(linesplit[c].c_str());
-        }
-        break;
-      case 2: //hdbt = [12 x 24] mean monthly dry bulb temp for each of the 24 hours of the day (C)
-        for (unsigned int c = 1; c < linesplit.size() && c < 25; c++) {
-          _mhdbt(row, c - 1) = atof(linesplit[c].c_str());
-        }
-        break;
-      case 3: //hEgh =[12 x 24] mean monthly Global Horizontal Radiation for each of the 24 hours of the day (W/m2)
-        for (unsigned int c = 1; c < linesplit.size() && c < 25; c++) {
-          _mhEgh(row, c - 1) = atof(linesplit[c].c_str());
-        }
-        break;
-      case 4:  //megh = [12 x 1] mean monthly Global Horizontal Radiation (W/m2)
-        _mEgh[row] = atof(linesplit[1].c_str());
-        break;
-      case 5:    //mdbt = [12 x 1] mean monthly dry bulb temp (C)
-        _mdbt[row] = atof(linesplit[1].c_str());
-        break;
-      case 6:    //mwind = [12 x 1] mean monthly wind speed; (m/s) 
-        _mwind[row] = atof(linesplit[1].c_str());
-        break;
-      default:
-        break;
-      }
-      row++;
+  std::vector<double> monthlyDryBulbTemp = pos.monthlyDryBulbTemp();
+  std::vector<double> monthlyWindspeed = pos.monthlyWindspeed();
+  std::vector<double> monthlyGlobalHorizontalRadiation = pos.monthlyGlobalHorizontalRadiation();
+  std::vector<std::vector<double> > monthlySolarRadiation = pos.monthlySolarRadiation();
+  std::vector<std::vector<double> > hourlyDryBulbTemp = pos.hourlyDryBulbTemp();
+  std::vector<std::vector<double> > hourlyGlobalHorizontalRadiation = pos.hourlyGlobalHorizontalRadiation();
+  for (int m = 0; m < 12; m++) {
+    _mdbt[m] = monthlyDryBulbTemp[m];
+    _mwind[m] = monthlyWindspeed[m];
+    _mEgh[m] = monthlyGlobalHorizontalRadiation[m];
+    for (int s = 0; s < NUM_SURFACES; s++) {
+      _msolar(m, s) = monthlySolarRadiation[m][s];
+    }
+    for (int h = 0; h < 24; h++) {
+      _mhdbt(m, h) = hourlyDryBulbTemp[m][h];
+      _mhEgh(m, h) = hourlyGlobalHorizontalRadiation[m][h];
     }
   }
   _weather->setMdbt(_mdbt);
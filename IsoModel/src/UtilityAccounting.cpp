@@ -0,0 +1,581 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#include "UtilityAccounting.hpp"
+#include "CsvWriter.hpp"
+#include "ResultFile.hpp"
+#include "ThreadPool.hpp"
+#include "TimeFrame.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace openstudio {
+namespace isomodel {
+
+namespace {
+
+// End uses 0 to 8 are electricity, the others gas.
+const int FIRST_GAS_END_USE = 9;
+
+const int MONTH_START[] = { 0, 744, 1416, 2160, 2880, 3624, 4344, 5088, 5832, 6552, 7296, 8016, 8760 };
+
+const char* const FUEL_NAMES[] = { "electricity", "gas" };
+
+const TimeFrame& calendar()
+{
+  static const TimeFrame frame;
+  return frame;
+}
+
+TouPeriod allHours()
+{
+  TouPeriod period = { "all", 1, 12, 0, 6, 0, 23 };
+  return period;
+}
+
+bool inRange(int value, int first, int last)
+{
+  return first <= last ? value >= first && value <= last : value >= first || value <= last;
+}
+
+double parseNumber(const std::string& text)
+{
+  char* end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || !std::isfinite(value)) {
+    throw std::invalid_argument("\"" + text + "\" is not a number.");
+  }
+  return value;
+}
+
+// A range "first-last" or a single value, each from min to max.
+void parseRange(const std::string& text, int min, int max, int& first, int& last)
+{
+  size_t dash = text.find('-');
+  std::string firstText = boost::trim_copy(text.substr(0, dash));
+  std::string lastText = dash == std::string::npos ? firstText : boost::trim_copy(text.substr(dash + 1));
+  char* firstEnd = nullptr;
+  char* lastEnd = nullptr;
+  long f = std::strtol(firstText.c_str(), &firstEnd, 10);
+  long l = std::strtol(lastText.c_str(), &lastEnd, 10);
+  if (firstText.empty() || lastText.empty() || *firstEnd != '\0' || *lastEnd != '\0' || f < min || f > max || l < min || l > max) {
+    throw std::invalid_argument("\"" + text + "\" is not a range of " + std::to_string(min) + " to " + std::to_string(max) + ".");
+  }
+  first = (int) f;
+  last = (int) l;
+}
+
+std::vector<std::string> fields(const std::string& value, size_t minimum, size_t maximum)
+{
+  std::vector<std::string> result;
+  boost::split(result, value, boost::is_any_of(","));
+  for (auto& field : result) {
+    boost::trim(field);
+  }
+  if (result.size() < minimum || result.size() > maximum) {
+    throw std::invalid_argument("\"" + value + "\" does not have " + std::to_string(minimum)
+                                + (minimum == maximum ? "" : " to " + std::to_string(maximum)) + " fields.");
+  }
+  return result;
+}
+
+// Sum of a[i] * b[i]. The four independent sums let the compiler keep the loop in vector
+// registers, which it cannot do with a single sum without reassociating additions.
+double dot(const double* a, const double* b, size_t n)
+{
+  double s0 = 0;
+  double s1 = 0;
+  double s2 = 0;
+  double s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < n; i++) {
+    s0 += a[i] * b[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+}
+
+bool TouPeriod::contains(int month, int dayOfWeek, int hour) const
+{
+  return inRange(month, firstMonth, lastMonth) && inRange(dayOfWeek, firstDay, lastDay) && inRange(hour, firstHour, lastHour);
+}
+
+Tariff::Tariff() : fixedCharge(0), periods(1, allHours()), tiers(1)
+{
+}
+
+int Tariff::periodOf(int month, int dayOfWeek, int hour) const
+{
+  for (size_t period = 0; period < periods.size(); period++) {
+    if (periods[period].contains(month, dayOfWeek, hour)) {
+      return (int) period;
+    }
+  }
+  return -1;
+}
+
+double Tariff::energyCharge(int period, double use) const
+{
+  double charge = 0;
+  double start = 0;
+  for (const auto& tier : tiers[period]) {
+    if (use <= start) {
+      break;
+    }
+    charge += tier.rate * (std::min(use, tier.limit) - start);
+    start = tier.limit;
+  }
+  return charge;
+}
+
+Tariff Tariff::load(const std::string& file)
+{
+  std::ifstream in(file.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open tariff " + file + ".");
+  }
+  return parse(in);
+}
+
+Tariff Tariff::parse(std::istream& in)
+{
+  Tariff tariff;
+  tariff.periods.clear();
+  tariff.tiers.clear();
+  // Charges by period name, resolved once every period is known.
+  struct PendingCharge
+  {
+    int lineNumber;
+    std::string period;
+    TariffTier tier;
+    bool demand;
+  };
+  std::vector<PendingCharge> charges;
+  int lineNumber = 0;
+  for (std::string line; std::getline(in, line);) {
+    lineNumber++;
+    line = line.substr(0, line.find('#'));
+    boost::trim(line);
+    if (line.empty()) {
+      continue;
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the tariff is not a \"key = value\" setting.");
+    }
+    std::string key = boost::to_lower_copy(boost::trim_copy(line.substr(0, equals)));
+    std::string value = boost::trim_copy(line.substr(equals + 1));
+    try {
+      if (key == "name") {
+        tariff.name = value;
+      } else if (key == "fixed") {
+        tariff.fixedCharge = parseNumber(value);
+      } else if (key == "period") {
+        std::vector<std::string> f = fields(value, 4, 4);
+        TouPeriod period;
+        period.name = f[0];
+        for (const auto& other : tariff.periods) {
+          if (boost::iequals(other.name, period.name)) {
+            throw std::invalid_argument("Period \"" + period.name + "\" is already defined.");
+          }
+        }
+        parseRange(f[1], 1, 12, period.firstMonth, period.lastMonth);
+        parseRange(f[2], 0, 6, period.firstDay, period.lastDay);
+        parseRange(f[3], 0, 23, period.firstHour, period.lastHour);
+        tariff.periods.push_back(period);
+      } else if (key == "energy") {
+        std::vector<std::string> f = fields(value, 2, 3);
+        PendingCharge charge = { lineNumber, f[0], { std::numeric_limits<double>::infinity(), parseNumber(f[1]) }, false };
+        if (f.size() == 3) {
+          charge.tier.limit = parseNumber(f[2]);
+        }
+        charges.push_back(charge);
+      } else if (key == "demand") {
+        std::vector<std::string> f = fields(value, 1, 2);
+        PendingCharge charge = { lineNumber, f.size() == 2 ? f[1] : std::string(), { 0, parseNumber(f[0]) }, true };
+        charges.push_back(charge);
+      } else {
+        throw std::invalid_argument("Unknown setting \"" + key + "\".");
+      }
+    } catch (std::invalid_argument& e) {
+      throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the tariff: " + e.what());
+    }
+  }
+
+  if (tariff.periods.empty()) {
+    tariff.periods.push_back(allHours());
+  }
+  tariff.tiers.resize(tariff.periods.size());
+  for (const auto& charge : charges) {
+    int period = -1;
+    for (size_t p = 0; p < tariff.periods.size(); p++) {
+      if (boost::iequals(tariff.periods[p].name, charge.period)) {
+        period = (int) p;
+      }
+    }
+    if (period < 0 && !(charge.demand && charge.period.empty())) {
+      throw std::invalid_argument("Line " + std::to_string(charge.lineNumber) + " of the tariff: there is no period \"" + charge.period + "\".");
+    }
+    if (charge.demand) {
+      DemandCharge demand = { charge.tier.rate, period };
+      tariff.demandCharges.push_back(demand);
+    } else {
+      tariff.tiers[period].push_back(charge.tier);
+    }
+  }
+
+  for (size_t p = 0; p < tariff.periods.size(); p++) {
+    const auto& tiers = tariff.tiers[p];
+    const std::string& name = tariff.periods[p].name;
+    for (size_t t = 0; t + 1 < tiers.size(); t++) {
+      if (std::isinf(tiers[t].limit)) {
+        throw std::invalid_argument("The tariff has a tier of period \"" + name + "\" after its unlimited tier.");
+      }
+      if (tiers[t].limit <= (t > 0 ? tiers[t - 1].limit : 0)) {
+        throw std::invalid_argument("The tier limits of period \"" + name + "\" do not increase.");
+      }
+    }
+    if (!tiers.empty() && !std::isinf(tiers.back().limit)) {
+      throw std::invalid_argument("The last tier of period \"" + name + "\" has a limit.");
+    }
+  }
+  for (int month = 1; month <= 12; month++) {
+    for (int day = 0; day < 7; day++) {
+      for (int hour = 0; hour < 24; hour++) {
+        if (tariff.periodOf(month, day, hour) < 0) {
+          throw std::invalid_argument("Hour " + std::to_string(hour) + " of day " + std::to_string(day) + " in month "
+                                      + std::to_string(month) + " is in no period of the tariff.");
+        }
+      }
+    }
+  }
+  return tariff;
+}
+
+EmissionFactors::EmissionFactors()
+{
+}
+
+EmissionFactors::EmissionFactors(double electricityFactor, double gasFactor)
+  : electricity(TIMESLICES, electricityFactor), gas(TIMESLICES, gasFactor)
+{
+}
+
+EmissionFactors EmissionFactors::load(const std::string& file)
+{
+  std::ifstream in(file.c_str());
+  if (!in) {
+    throw std::invalid_argument("Cannot open emission factors " + file + ".");
+  }
+  return parse(in);
+}
+
+EmissionFactors EmissionFactors::parse(std::istream& in)
+{
+  std::string line;
+  if (!std::getline(in, line)) {
+    throw std::invalid_argument("The emission factors are empty.");
+  }
+  std::vector<std::string> header;
+  boost::split(header, line, boost::is_any_of(","));
+  int columns[] = { -1, -1 };
+  for (size_t c = 0; c < header.size(); c++) {
+    std::string name = boost::to_lower_copy(boost::trim_copy(header[c]));
+    for (int fuel = 0; fuel < 2; fuel++) {
+      if (name == FUEL_NAMES[fuel]) {
+        columns[fuel] = (int) c;
+      }
+    }
+  }
+  if (columns[ELECTRICITY_FUEL] < 0 && columns[GAS_FUEL] < 0) {
+    throw std::invalid_argument("The emission factors have neither an electricity nor a gas column.");
+  }
+
+  EmissionFactors factors;
+  std::vector<double>* series[] = { &factors.electricity, &factors.gas };
+  int lineNumber = 1;
+  size_t rows = 0;
+  std::vector<std::string> cells;
+  while (std::getline(in, line)) {
+    lineNumber++;
+    if (boost::trim_copy(line).empty()) {
+      continue;
+    }
+    rows++;
+    boost::split(cells, line, boost::is_any_of(","));
+    for (int fuel = 0; fuel < 2; fuel++) {
+      if (columns[fuel] < 0) {
+        continue;
+      }
+      std::string cell = (size_t) columns[fuel] < cells.size() ? boost::trim_copy(cells[columns[fuel]]) : std::string();
+      try {
+        series[fuel]->push_back(parseNumber(cell));
+      } catch (std::invalid_argument& e) {
+        throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of the emission factors: " + e.what());
+      }
+    }
+  }
+  if (rows != TIMESLICES) {
+    throw std::invalid_argument("The emission factors have " + std::to_string(rows) + " rows, expected 8760 hours.");
+  }
+  return factors;
+}
+
+UtilityBill::UtilityBill()
+{
+  std::fill(&cost[0][0], &cost[0][0] + 12 * END_USE_COUNT, 0.0);
+  std::fill(&demandCost[0][0], &demandCost[0][0] + 12 * END_USE_COUNT, 0.0);
+  std::fill(&fixedCost[0][0], &fixedCost[0][0] + 12 * 2, 0.0);
+  std::fill(&emissions[0][0], &emissions[0][0] + 12 * END_USE_COUNT, 0.0);
+}
+
+double UtilityBill::monthlyCost(int month) const
+{
+  double total = fixedCost[month][ELECTRICITY_FUEL] + fixedCost[month][GAS_FUEL];
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    total += cost[month][endUse];
+  }
+  return total;
+}
+
+double UtilityBill::monthlyEmissions(int month) const
+{
+  double total = 0;
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    total += emissions[month][endUse];
+  }
+  return total;
+}
+
+double UtilityBill::annualCost() const
+{
+  double total = 0;
+  for (int month = 0; month < 12; month++) {
+    total += monthlyCost(month);
+  }
+  return total;
+}
+
+double UtilityBill::annualEmissions() const
+{
+  double total = 0;
+  for (int month = 0; month < 12; month++) {
+    total += monthlyEmissions(month);
+  }
+  return total;
+}
+
+UtilityAccounting::UtilityAccounting(const Tariff& electricity, const Tariff& gas, const EmissionFactors& factors)
+{
+  m_tariffs[ELECTRICITY_FUEL] = electricity;
+  m_tariffs[GAS_FUEL] = gas;
+  m_factors[ELECTRICITY_FUEL] = factors.electricity;
+  m_factors[GAS_FUEL] = factors.gas;
+  const TimeFrame& frame = calendar();
+  for (int fuel = 0; fuel < 2; fuel++) {
+    const Tariff& tariff = m_tariffs[fuel];
+    std::string name = std::string("The ") + FUEL_NAMES[fuel];
+    if (tariff.tiers.size() != tariff.periods.size()) {
+      throw std::invalid_argument(name + " tariff does not have the tiers of every period.");
+    }
+    for (const auto& demand : tariff.demandCharges) {
+      if (demand.period < -1 || demand.period >= (int) tariff.periods.size()) {
+        throw std::invalid_argument(name + " tariff has a demand charge of period " + std::to_string(demand.period) + ".");
+      }
+    }
+    if (!m_factors[fuel].empty() && m_factors[fuel].size() != TIMESLICES) {
+      throw std::invalid_argument(name + " emission factors have " + std::to_string(m_factors[fuel].size()) + " values, expected 8760.");
+    }
+    m_periodWeights[fuel].assign(tariff.periods.size(), std::vector<double>(TIMESLICES, 0.0));
+    for (int hour = 0; hour < TIMESLICES; hour++) {
+      int period = tariff.periodOf(frame.Month[hour], frame.DayOfWeek[hour], frame.Hour[hour]);
+      if (period < 0) {
+        throw std::invalid_argument(name + " tariff has no period for hour " + std::to_string(hour) + " of the year.");
+      }
+      m_periodWeights[fuel][period][hour] = 1;
+    }
+  }
+}
+
+UtilityBill UtilityAccounting::evaluate(const std::vector<EndUses>& hourly, double floorArea) const
+{
+  if (hourly.size() != TIMESLICES) {
+    throw std::invalid_argument("Utility bills need 8760 hourly results, not " + std::to_string(hourly.size()) + ".");
+  }
+  std::vector<double> values((size_t) END_USE_COUNT * TIMESLICES);
+  const double* columns[END_USE_COUNT];
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    double* column = &values[(size_t) endUse * TIMESLICES];
+    for (int hour = 0; hour < TIMESLICES; hour++) {
+      column[hour] = endUseValue(hourly[hour], endUse);
+    }
+    columns[endUse] = column;
+  }
+  return evaluate(columns, floorArea);
+}
+
+UtilityBill UtilityAccounting::evaluate(const double* const* columns, double floorArea) const
+{
+  if (!(floorArea > 0) || std::isinf(floorArea)) {
+    throw std::invalid_argument("The floor area of a utility bill must be a positive number.");
+  }
+  UtilityBill bill;
+  std::vector<double> total(TIMESLICES);
+  for (int fuel = 0; fuel < 2; fuel++) {
+    int firstEndUse = fuel == ELECTRICITY_FUEL ? 0 : FIRST_GAS_END_USE;
+    int lastEndUse = fuel == ELECTRICITY_FUEL ? FIRST_GAS_END_USE : END_USE_COUNT;
+    const Tariff& tariff = m_tariffs[fuel];
+    const auto& weights = m_periodWeights[fuel];
+    const double* factors = m_factors[fuel].empty() ? nullptr : m_factors[fuel].data();
+
+    // The hourly demand of the fuel, kWh/m2.
+    std::fill(total.begin(), total.end(), 0.0);
+    for (int endUse = firstEndUse; endUse < lastEndUse; endUse++) {
+      const double* column = columns[endUse];
+      for (int hour = 0; hour < TIMESLICES; hour++) {
+        total[hour] += column[hour];
+      }
+    }
+
+    for (int month = 0; month < 12; month++) {
+      int start = MONTH_START[month];
+      size_t hours = (size_t) (MONTH_START[month + 1] - start);
+      bill.fixedCost[month][fuel] = tariff.fixedCharge;
+
+      if (factors) {
+        for (int endUse = firstEndUse; endUse < lastEndUse; endUse++) {
+          bill.emissions[month][endUse] = floorArea * dot(columns[endUse] + start, factors + start, hours);
+        }
+      }
+
+      for (size_t period = 0; period < weights.size(); period++) {
+        if (tariff.tiers[period].empty()) {
+          continue;
+        }
+        double use[END_USE_COUNT];
+        double periodUse = 0;
+        for (int endUse = firstEndUse; endUse < lastEndUse; endUse++) {
+          use[endUse] = dot(columns[endUse] + start, weights[period].data() + start, hours);
+          periodUse += use[endUse];
+        }
+        if (periodUse <= 0) {
+          continue;
+        }
+        double charge = tariff.energyCharge((int) period, periodUse * floorArea);
+        for (int endUse = firstEndUse; endUse < lastEndUse; endUse++) {
+          bill.cost[month][endUse] += charge * (use[endUse] / periodUse);
+        }
+      }
+
+      for (const auto& demand : tariff.demandCharges) {
+        // The kWh of an hour are its average kW. Ties go to the earliest hour.
+        const double* weight = demand.period < 0 ? nullptr : weights[demand.period].data();
+        int peakHour = -1;
+        for (int hour = start; hour < MONTH_START[month + 1]; hour++) {
+          if ((!weight || weight[hour] != 0) && (peakHour < 0 || total[hour] > total[peakHour])) {
+            peakHour = hour;
+          }
+        }
+        if (peakHour < 0 || total[peakHour] <= 0) {
+          continue;
+        }
+        double charge = demand.rate * total[peakHour] * floorArea;
+        for (int endUse = firstEndUse; endUse < lastEndUse; endUse++) {
+          double share = charge * (columns[endUse][peakHour] / total[peakHour]);
+          bill.cost[month][endUse] += share;
+          bill.demandCost[month][endUse] += share;
+        }
+      }
+    }
+  }
+  return bill;
+}
+
+std::vector<UtilityBill> UtilityAccounting::evaluate(const ResultFileReader& results, ThreadPool& pool) const
+{
+  if (results.periods() != TIMESLICES || results.columns().size() != (size_t) END_USE_COUNT) {
+    throw std::invalid_argument("Utility bills need hourly results of every end use, the result file has "
+                                + std::to_string(results.periods()) + " periods.");
+  }
+  std::vector<UtilityBill> bills(results.size());
+  pool.parallelFor(results.size(), [&](size_t building) {
+    const auto& metadata = results.building(building).metadata;
+    auto floorArea = metadata.find("floorArea");
+    if (floorArea == metadata.end()) {
+      throw std::invalid_argument("Building " + results.building(building).id + " of the result file has no floor area.");
+    }
+    // Raw columns are read in place, the others decoded.
+    std::vector<double> values;
+    const double* columns[END_USE_COUNT];
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      columns[endUse] = results.mappedDoubles(building, endUse);
+      if (!columns[endUse]) {
+        values.resize((size_t) END_USE_COUNT * TIMESLICES);
+        double* column = &values[(size_t) endUse * TIMESLICES];
+        results.column(building, endUse, column);
+        columns[endUse] = column;
+      }
+    }
+    bills[building] = evaluate(columns, parseNumber(floorArea->second));
+  });
+  return bills;
+}
+
+void writeBills(CsvWriter& out, const std::vector<std::string>& ids, const std::vector<UtilityBill>& bills)
+{
+  out.field(std::string("id")).field(std::string("month")).field(std::string("cost")).field(std::string("emissions"));
+  out.field(std::string("ElecFixedCost")).field(std::string("GasFixedCost"));
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    out.field(std::string(endUseName(endUse)) + "Cost");
+  }
+  for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+    out.field(std::string(endUseName(endUse)) + "Emissions");
+  }
+  out.endRow();
+  for (size_t building = 0; building < bills.size(); building++) {
+    const UtilityBill& bill = bills[building];
+    for (int month = 0; month < 12; month++) {
+      out.field(ids[building]).field(month + 1).field(bill.monthlyCost(month)).field(bill.monthlyEmissions(month));
+      out.field(bill.fixedCost[month][ELECTRICITY_FUEL]).field(bill.fixedCost[month][GAS_FUEL]);
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        out.field(bill.cost[month][endUse]);
+      }
+      for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+        out.field(bill.emissions[month][endUse]);
+      }
+      out.endRow();
+    }
+  }
+}
+
+}
+}
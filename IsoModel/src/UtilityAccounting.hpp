@@ -0,0 +1,237 @@
+/**********************************************************************
+ *  Copyright (c) 2008-2013, Alliance for Sustainable Energy.
+ *  All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ **********************************************************************/
+#ifndef ISOMODEL_UTILITY_ACCOUNTING_HPP
+#define ISOMODEL_UTILITY_ACCOUNTING_HPP
+
+#include "ISOModelAPI.hpp"
+#include "ModelParameters.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace openstudio {
+namespace isomodel {
+
+class CsvWriter;
+class ResultFileReader;
+class ThreadPool;
+
+enum UtilityFuel
+{
+  ELECTRICITY_FUEL,
+  GAS_FUEL
+};
+
+/**
+ * A time of use period of a tariff. Months (1-12), days of the week (0-6, numbered as the
+ * occupancy days of an .ism file) and hours (0-23) are inclusive ranges; a range whose
+ * first value is greater than its last wraps around, so hours 22 to 5 are the night.
+ */
+struct ISOMODEL_API TouPeriod
+{
+  std::string name;
+  int firstMonth;
+  int lastMonth;
+  int firstDay;
+  int lastDay;
+  int firstHour;
+  int lastHour;
+
+  bool contains(int month, int dayOfWeek, int hour) const;
+};
+
+/**
+ * An energy rate that applies to the use of a period in a month up to limit kWh (the
+ * limit of the previous tier is where it starts). The last tier of a period has no
+ * limit.
+ */
+struct ISOMODEL_API TariffTier
+{
+  double limit;
+  double rate; // Per kWh.
+};
+
+/**
+ * A monthly charge per kW of the highest hourly demand of the month, either over every
+ * hour or over the hours of one period.
+ */
+struct ISOMODEL_API DemandCharge
+{
+  double rate; // Per kW.
+  int period; // Index in Tariff::periods, or -1 for every hour.
+};
+
+/**
+ * The rates of one fuel. A tariff file holds one "key = value" setting per line; #
+ * starts a comment. For example
+ *
+ * name = Small commercial<br>
+ * fixed = 25<br>
+ * period = peak, 6-9, 1-5, 12-17<br>
+ * period = off-peak, 1-12, 0-6, 0-23<br>
+ * energy = peak, 0.22, 1000<br>
+ * energy = peak, 0.25<br>
+ * energy = off-peak, 0.08<br>
+ * demand = 12.5<br>
+ * demand = 8, peak
+ *
+ * fixed is charged every month. A period line gives the name, months, days and hours of
+ * a period; each hour is in the first period that contains it, and every hour must be
+ * in one. Without period lines the tariff has a single period named "all". The energy
+ * lines of a period are its tiers in order, with the rate per kWh and, for all but the
+ * last, the monthly kWh up to which the rate applies. A demand line adds a charge per kW
+ * of the monthly peak, optionally of one period only. A default constructed tariff
+ * charges nothing.
+ */
+struct ISOMODEL_API Tariff
+{
+  std::string name;
+  double fixedCharge; // Per month.
+  std::vector<TouPeriod> periods;
+  std::vector<std::vector<TariffTier> > tiers; // By period.
+  std::vector<DemandCharge> demandCharges;
+
+  Tariff();
+
+  /**
+   * The index of the first period containing the hour, or -1 if there is none.
+   */
+  int periodOf(int month, int dayOfWeek, int hour) const;
+
+  /**
+   * The energy charge of use kWh of a period in a month.
+   */
+  double energyCharge(int period, double use) const;
+
+  /**
+   * Reads a tariff file. Throws std::invalid_argument naming the line of a bad setting,
+   * or if an hour is in no period or the tiers of a period are not in increasing order
+   * ending with an unlimited one.
+   */
+  static Tariff load(const std::string& file);
+  static Tariff parse(std::istream& in);
+};
+
+/**
+ * Emissions per kWh of each fuel for each hour of the year, e.g. the marginal kg CO2e
+ * of the grid. A fuel without factors is empty and has no emissions.
+ */
+struct ISOMODEL_API EmissionFactors
+{
+  std::vector<double> electricity;
+  std::vector<double> gas;
+
+  EmissionFactors();
+
+  /**
+   * The same factors every hour.
+   */
+  EmissionFactors(double electricityFactor, double gasFactor);
+
+  /**
+   * Reads a CSV file with a header row and 8760 rows. The columns named electricity and
+   * gas (case insensitive) are read and any others, such as an hour column, are
+   * ignored. Throws std::invalid_argument if the file cannot be read, has neither
+   * column, a value is not a number or there are not 8760 rows.
+   */
+  static EmissionFactors load(const std::string& file);
+  static EmissionFactors parse(std::istream& in);
+};
+
+/**
+ * The monthly cost and emissions of a building by end use. The energy and demand charges
+ * of a fuel are shared out among its end uses: the energy charge of a period in a month
+ * in proportion to their use in the period, and a demand charge in proportion to their
+ * demand at the peak hour. The fixed charges belong to no end use.
+ */
+struct ISOMODEL_API UtilityBill
+{
+  // Energy and demand charges by month and end use, in the currency of the tariffs.
+  double cost[12][END_USE_COUNT];
+  // The part of cost due to demand charges.
+  double demandCost[12][END_USE_COUNT];
+  // Fixed charges by month and UtilityFuel.
+  double fixedCost[12][2];
+  // Emissions by month and end use, in the unit of the emission factors.
+  double emissions[12][END_USE_COUNT];
+
+  UtilityBill();
+
+  double monthlyCost(int month) const;
+  double monthlyEmissions(int month) const;
+  double annualCost() const;
+  double annualEmissions() const;
+};
+
+/**
+ * Evaluates tariffs and emission factors against hourly results. The tariffs are
+ * resolved into hourly period weights once, so each building takes a few passes of
+ * multiply and add over its end use columns.
+ */
+class ISOMODEL_API UtilityAccounting
+{
+public:
+  /**
+   * Throws std::invalid_argument if an hour is in no period of a tariff, a charge refers
+   * to a period the tariff does not have or the factors of a fuel do not have 8760
+   * values.
+   */
+  UtilityAccounting(const Tariff& electricity, const Tariff& gas = Tariff(), const EmissionFactors& factors = EmissionFactors());
+
+  const Tariff& tariff(UtilityFuel fuel) const {
+    return m_tariffs[fuel];
+  }
+
+  /**
+   * The bill of a building from its hourly results (EUI in kWh/m2, as returned by
+   * HourlyModel::simulate) and its floor area in m2. Throws std::invalid_argument if
+   * there are not 8760 results.
+   */
+  UtilityBill evaluate(const std::vector<EndUses>& hourly, double floorArea) const;
+
+  /**
+   * As above, from END_USE_COUNT columns of 8760 hourly values in EndUses order.
+   */
+  UtilityBill evaluate(const double* const* columns, double floorArea) const;
+
+  /**
+   * The bills of every building of an hourly result file, evaluated on pool. The floor
+   * area is read from the floorArea metadata of each building. Throws
+   * std::invalid_argument if the file is not hourly or a building has no floor area.
+   */
+  std::vector<UtilityBill> evaluate(const ResultFileReader& results, ThreadPool& pool) const;
+
+private:
+  Tariff m_tariffs[2];
+  // Hourly weights (1 or 0) of every period of each fuel's tariff.
+  std::vector<std::vector<double> > m_periodWeights[2];
+  std::vector<double> m_factors[2];
+};
+
+/**
+ * Writes bills as CSV: a header row, then a row per building and month with the id,
+ * the month from 1, the total cost and emissions, the fixed electricity and gas
+ * charges, then the cost and the emissions of each end use.
+ */
+ISOMODEL_API void writeBills(CsvWriter& out, const std::vector<std::string>& ids, const std::vector<UtilityBill>& bills);
+
+}
+}
+#endif
@@ -4,6 +4,9 @@ namespace openstudio {
 namespace isomodel {
 
 Ventilation::Ventilation(void)
+    : m_supplyRate(0), m_supplyDifference(0), m_heatRecoveryEfficiency(0), m_exhaustAirRecirculated(0), m_ventType(0),
+      m_fanPower(0), m_fanControlFactor(0), m_infiltrationRateUnoccupied(0), m_ventilationExhaustRateUnoccupied(0),
+      m_ventilationIntakeRateUnoccupied(0)
 {
 }
 
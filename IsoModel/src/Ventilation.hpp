@@ -303,6 +303,16 @@ public:
     m_ventilationIntakeRateUnoccupied = ventilationIntakeRateUnoccupied;
   }
 
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_supplyRate & m_supplyDifference & m_heatRecoveryEfficiency & m_exhaustAirRecirculated
+        & m_ventType & m_fanPower & m_fanControlFactor & m_ventPreheatDegC & m_n50 & m_hzone
+        & m_p_exp & m_zone_frac & m_stack_exp & m_stack_coeff & m_wind_exp & m_wind_coeff & m_dCp
+        & m_vent_rate_flag & m_H_ve & m_infiltrationRateUnoccupied
+        & m_ventilationExhaustRateUnoccupied & m_ventilationIntakeRateUnoccupied;
+  }
+
 private:
   double m_supplyRate;
   double m_supplyDifference;
@@ -3,7 +3,7 @@
 namespace openstudio {
 namespace isomodel {
 
-WeatherData::WeatherData(void)
+WeatherData::WeatherData(void) : m_fingerprint(std::make_shared<Fingerprint>())
 {
 }
 
@@ -11,5 +11,18 @@ WeatherData::~WeatherData(void)
 {
 }
 
+ContentHash WeatherData::fingerprint() const
+{
+  std::lock_guard<std::mutex> lock(m_fingerprint->mutex);
+  if (!m_fingerprint->valid) {
+    BinaryWriter out;
+    // Writing does not modify the data.
+    const_cast<WeatherData*>(this)->serialize(out);
+    m_fingerprint->hash = out.hash();
+    m_fingerprint->valid = true;
+  }
+  return m_fingerprint->hash;
+}
+
 }
 }
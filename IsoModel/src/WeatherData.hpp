@@ -20,6 +20,7 @@
 #define ISOMODEL_WEATHER_DATA_HPP
 
 #include "ISOModelAPI.hpp"
+#include "BinaryArchive.hpp"
 
 #ifdef ISOMODEL_STANDALONE
 #include "Vector.hpp"
@@ -30,6 +31,7 @@
 #endif
 
 #include <memory>
+#include <mutex>
 
 namespace openstudio {
 namespace isomodel {
@@ -49,6 +51,7 @@ public:
 
   void setMEgh(Vector val) {
     m_mEgh = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
   }
 
   /**
@@ -60,6 +63,7 @@ public:
 
   void setMdbt(Vector val) {
     m_mdbt = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
   }
 
   /**
@@ -71,6 +75,7 @@ public:
 
   void setMwind(Vector val) {
     m_mwind = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
   }
 
 
@@ -83,6 +88,7 @@ public:
 
   void setMsolar(Matrix val) {
     m_msolar = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
   }
 
   /**
@@ -94,6 +100,7 @@ public:
 
   void setMhdbt(Matrix val) {
     m_mhdbt = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
   }
 
   /**
@@ -105,15 +112,37 @@ public:
 
   void setMhEgh(Matrix val) {
     m_mhEgh = val;
+    m_fingerprint = std::make_shared<Fingerprint>();
+  }
+
+  /**
+   * A hash of the averages, identifying the weather in result cache keys. Computed on
+   * first use and kept until a setter is called. Thread safe, except with the setters.
+   */
+  ContentHash fingerprint() const;
+
+  // Snapshot serialization, see BinaryArchive.hpp.
+  template<class Archive>
+  void serialize(Archive& ar) {
+    ar & m_msolar & m_mhdbt & m_mhEgh & m_mEgh & m_mdbt & m_mwind;
   }
 
 private:
+  struct Fingerprint
+  {
+    std::mutex mutex;
+    bool valid = false;
+    ContentHash hash;
+  };
+
   Matrix m_msolar;
   Matrix m_mhdbt;
   Matrix m_mhEgh;
   Vector m_mEgh;
   Vector m_mdbt;
   Vector m_mwind;
+  // Shared with copies until a setter gives this object a fresh one.
+  std::shared_ptr<Fingerprint> m_fingerprint;
 };
 }
 }
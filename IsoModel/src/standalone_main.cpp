@@ -6,52 +6,74 @@
  */
 
 #include "UserModel.hpp"
+#include "Batch.hpp"
+#include "Calibration.hpp"
+#include "CsvWriter.hpp"
+#include "MonteCarlo.hpp"
 #include "MonthlyModel.hpp"
+#include "Optimizer.hpp"
+#include "Pipeline.hpp"
+#include "ResultCache.hpp"
+#include "ResultFile.hpp"
+#include "Sensitivity.hpp"
+#include "SimulationServer.hpp"
+#include "Surrogate.hpp"
+#include "Sweep.hpp"
+#include "ThreadPool.hpp"
+#include "UtilityAccounting.hpp"
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
 using namespace openstudio::isomodel;
 using namespace openstudio;
 
-void runMonthlySimulation(const UserModel& umodel) {
+const char* END_USE_HEADER = "ElecHeat,ElecCool,ElecIntLights,ElecExtLights,ElecFans,ElecPump,ElecEquipInt,ElecEquipExt,ElectDHW,GasHeat,GasCool,GasEquip,GasDHW";
+
+void writeEndUses(CsvWriter& out, openstudio::EndUses& endUses) {
+#ifdef _OPENSTUDIOS
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Heating));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Cooling));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Fans));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Pumps));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment));
+  out.field(endUses.getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems));
+
+  out.field(endUses.getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Heating));
+  out.field(endUses.getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Cooling));
+  out.field(endUses.getEndUse(EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment));
+  out.field(endUses.getEndUse(EndUseFuelType::Gas, EndUseCategoryType::WaterSystems));
+#else
+  for (int j = 0; j < 13; j++) {
+    out.field(endUses.getEndUse(j));
+  }
+#endif
+}
+
+void runMonthlySimulation(const UserModel& umodel, CsvWriter& out) {
   // Run the monthly simulation.
   openstudio::isomodel::MonthlyModel monthlyModel = umodel.toMonthlyModel();
   auto monthlyResults = monthlyModel.simulate();
 
-  std::cout << "Monthly Results:" << std::endl;
-  std::cout
-    << "Month,ElecHeat,ElecCool,ElecIntLights,ElecExtLights,ElecFans,ElecPump,ElecEquipInt,ElecEquipExt,ElectDHW,GasHeat,GasCool,GasEquip,GasDHW"
-    << std::endl;
-
+  out.write("Monthly Results:\n");
+  out.write(std::string("Month,") + END_USE_HEADER + "\n");
+  out.setSeparator(", ");
   for (int i = 0; i < 12; i++) {
-    std::cout << i + 1;
-#ifdef _OPENSTUDIOS
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Heating);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Cooling);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Fans);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Pumps);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems);
-
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Heating);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Cooling);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment);
-    std::cout << ", " << monthlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::WaterSystems);
-#else
-    for (int j = 0; j < 13; j++) {
-      std::cout << ", " <<  std::setprecision(10) << monthlyResults[i].getEndUse(j);
-    }
-#endif
-    std::cout << std::endl;
+    out.field(i + 1);
+    writeEndUses(out, monthlyResults[i]);
+    out.endRow();
   }
 }
 
-void runHourlySimulation(const UserModel& umodel, bool aggregateByMonth) {
+void runHourlySimulation(const UserModel& umodel, bool aggregateByMonth, CsvWriter& out) {
   // Run the hourly simulation (with results aggregated by month).
   openstudio::isomodel::HourlyModel hourly = umodel.toHourlyModel();
   auto hourlyResults = hourly.simulate(aggregateByMonth);
@@ -60,37 +82,17 @@ void runHourlySimulation(const UserModel& umodel, bool aggregateByMonth) {
   int numberOfResults = aggregateByMonth ? 12 : 8760;
 
   // Output the results.
-  std::cout << "Hourly results by " << monthOrHour << ":" << std::endl;
-  std::cout
-    << monthOrHour << ",ElecHeat,ElecCool,ElecIntLights,ElecExtLights,ElecFans,ElecPump,ElecEquipInt,ElecEquipExt,ElectDHW,GasHeat,GasCool,GasEquip,GasDHW"
-    << std::endl;
+  out.write("Hourly results by " + monthOrHour + ":\n");
+  out.write(monthOrHour + "," + END_USE_HEADER + "\n");
+  out.setSeparator(", ");
   for (int i = 0; i < numberOfResults; i++) {
-    std::cout << i + 1;
-#ifdef _OPENSTUDIOS
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Heating);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Cooling);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorLights);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorLights);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Fans);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::Pumps);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::InteriorEquipment);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::ExteriorEquipment);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Electricity, EndUseCategoryType::WaterSystems);
-
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Heating);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::Cooling);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::InteriorEquipment);
-    std::cout << ", " << hourlyResults[i].getEndUse(EndUseFuelType::Gas, EndUseCategoryType::WaterSystems);
-#else
-    for (int j = 0; j < 13; j++) {
-      std::cout << ", " << hourlyResults[i].getEndUse(j);
-    }
-#endif
-    std::cout << std::endl;
+    out.field(i + 1);
+    writeEndUses(out, hourlyResults[i]);
+    out.endRow();
   }
 }
 
-void compare(const UserModel& umodel, bool markdown = false) {
+void compare(const UserModel& umodel, CsvWriter& out, bool markdown = false) {
   openstudio::isomodel::HourlyModel hourly = umodel.toHourlyModel();
   auto hourlyResults = hourly.simulate(true);
   
@@ -100,29 +102,253 @@ void compare(const UserModel& umodel, bool markdown = false) {
   auto endUseNames = std::vector<std::string> { "ElecHeat", "ElecCool", "ElecIntLights", "ElecExtLights", "ElecFans", "ElecPump",
                                                 "ElecEquipInt", "ElecEquipExt", "ElectDHW", "GasHeat", "GasCool", "GasEquip", "GasDHW" };
 
-  auto delim = markdown ? " | " : ", ";
+  out.setSeparator(markdown ? " | " : ", ");
 
   for (auto endUse = 0; endUse != 13; ++endUse) {
-    if (markdown) std::cout << "| ";
-    std::cout << "Month" << delim << "Monthly " << endUseNames[endUse] << delim << "Hourly " << endUseNames[endUse] << delim << "Difference";
-    if (markdown) std::cout << " |";
-    std::cout << "\n";
+    if (markdown) out.write("| ");
+    out.field(std::string("Month")).field("Monthly " + endUseNames[endUse]).field("Hourly " + endUseNames[endUse]).field(std::string("Difference"));
+    if (markdown) out.write(" |");
+    out.endRow();
 
     if (markdown) {
-      std::cout << "|---|---|---|---|\n";
+      out.write("|---|---|---|---|\n");
     }
 
     for (auto month = 0; month != 12; ++month) {
       auto monthlyResult = monthlyResults[month].getEndUse(endUse);
       auto hourlyResult = hourlyResults[month].getEndUse(endUse);
-      if (markdown) std::cout << "| ";
-      std::cout << month << delim << monthlyResult << delim << hourlyResult << delim << monthlyResult - hourlyResult;
-      if (markdown) std::cout << " |";
-      std::cout << "\n";
+      if (markdown) out.write("| ");
+      out.field(month).field(monthlyResult).field(hourlyResult).field(monthlyResult - hourlyResult);
+      if (markdown) out.write(" |");
+      out.endRow();
     }
 
-  std::cout << "\n";
+  out.endRow();
+  }
+}
+
+// Loads the model of a sweep spec. The spec's model file takes precedence over the ism
+// file given on the command line.
+bool loadSpecModel(const SweepSpec& spec, const std::string& ismFile, const std::string& defaultsFile, UserModel& umodel) {
+  std::string modelFile = spec.modelFile.empty() ? ismFile : spec.modelFile;
+  std::string defaults = spec.modelFile.empty() ? defaultsFile : spec.defaultsFile;
+  if (modelFile.empty()) {
+    std::cerr << "ERROR: The sweep spec names no model and no ism file was given." << std::endl;
+    return false;
+  }
+  if (defaults.empty()) {
+    umodel.load(modelFile);
+  } else {
+    umodel.load(modelFile, defaults);
+  }
+  return true;
+}
+
+enum SpecAnalysis
+{
+  SWEEP,
+  MONTE_CARLO,
+  SENSITIVITY,
+  OPTIMIZATION,
+  CALIBRATION,
+  SURROGATE
+};
+
+// Runs the parametric sweep, Monte Carlo or sensitivity analysis, optimization, calibration or surrogate training
+// described by specFile and writes its results to the spec's output file or standard output.
+int runSpec(const std::string& specFile, SpecAnalysis analysis, const std::string& ismFile, const std::string& defaultsFile,
+            const std::string& cacheDirectory, const std::string& columnarFile) {
+  try {
+    SweepSpec spec = SweepSpec::load(specFile);
+    UserModel umodel;
+    if (!loadSpecModel(spec, ismFile, defaultsFile, umodel)) {
+      return 1;
+    }
+    std::shared_ptr<ResultCache> cache;
+    if (!cacheDirectory.empty()) {
+      cache = std::make_shared<ResultCache>(ResultCache::DEFAULT_CAPACITY, cacheDirectory);
+      umodel.setResultCache(cache);
+    }
+
+    std::ofstream file;
+    if (!spec.outputFile.empty()) {
+      file.open(spec.outputFile.c_str());
+      if (!file) {
+        std::cerr << "ERROR: Cannot write " << spec.outputFile << std::endl;
+        return 1;
+      }
+    }
+    std::ostream& out = spec.outputFile.empty() ? std::cout : file;
+
+    ThreadPool pool(spec.threads);
+    if (analysis == MONTE_CARLO) {
+      MonteCarlo monteCarlo(umodel, spec);
+      bool converged = monteCarlo.run(pool);
+      std::cerr << monteCarlo.samples() << " samples, " << (converged ? "converged" : "not converged") << std::endl;
+      monteCarlo.writeCsv(out);
+    } else if (analysis == OPTIMIZATION) {
+      Optimizer optimizer(umodel, spec);
+      auto front = optimizer.run(pool);
+      const OptimizationStatistics& statistics = optimizer.statistics();
+      std::cerr << statistics.evaluations << " evaluations in " << statistics.seconds << " s (" << statistics.evaluationsPerSecond()
+                << " per second), cache hit rate " << statistics.cacheHitRate() << std::endl;
+      optimizer.writeCsv(front, out);
+    } else if (analysis == CALIBRATION) {
+      if (spec.meteredFile.empty()) {
+        std::cerr << "ERROR: The calibration spec names no metered data." << std::endl;
+        return 1;
+      }
+      Calibration calibration(umodel, spec, MeteredData::load(spec.meteredFile));
+      CalibrationResult result = calibration.run(pool);
+      std::cerr << result.evaluations << " evaluations in " << result.seconds << " s, Guideline 14 "
+                << (result.compliant ? "compliant" : "not compliant") << std::endl;
+      calibration.writeReport(result, out);
+    } else if (analysis == SURROGATE) {
+      Surrogate surrogate = Surrogate::train(umodel, spec, pool);
+      if (!spec.surrogateFile.empty()) {
+        surrogate.save(spec.surrogateFile);
+      }
+      std::cerr << surrogate.termCount() << " terms fitted to " << surrogate.trainingRuns() << " runs";
+      if (!surrogate.validation().empty()) {
+        const SurrogateError& eui = surrogate.validation().back();
+        std::cerr << ", EUI error on " << surrogate.validationRuns() << " held-out runs: RMSE " << eui.rmse << " kWh/m2, R2 " << eui.r2;
+      }
+      std::cerr << std::endl;
+      surrogate.writeReport(out);
+    } else if (analysis == SENSITIVITY) {
+      SensitivityStudy study(umodel, spec);
+      study.run(pool);
+      study.writeCsv(out);
+    } else {
+      Sweep sweep(umodel, spec);
+      if (columnarFile.empty()) {
+        sweep.writeCsv(pool, out);
+      } else {
+        ResultFileWriter writer(columnarFile, 12);
+        sweep.writeResults(pool, writer);
+        writer.close();
+      }
+    }
+    if (cache) {
+      ResultCacheStatistics statistics = cache->statistics();
+      std::cerr << "Result cache: " << statistics.hits << " hits, " << statistics.diskHits << " disk hits, " << statistics.misses
+                << " misses" << std::endl;
+    }
+  } catch (std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Evaluates a surrogate for every CSV row of parameter values read from in and writes the predictions as CSV.
+int runPredict(const std::string& surrogateFile, std::istream& in, std::ostream& out)
+{
+  try {
+    Surrogate surrogate = Surrogate::load(surrogateFile);
+    std::string line;
+    if (!std::getline(in, line)) {
+      throw std::invalid_argument("The parameter values have no header row.");
+    }
+    std::vector<std::string> header;
+    boost::split(header, line, boost::is_any_of(","));
+    // The input column of each surrogate parameter.
+    std::vector<size_t> columns;
+    for (const auto& name : surrogate.parameterNames()) {
+      size_t column = 0;
+      while (column < header.size() && !boost::iequals(boost::trim_copy(header[column]), name)) {
+        column++;
+      }
+      if (column == header.size()) {
+        throw std::invalid_argument("The parameter values have no " + name + " column.");
+      }
+      columns.push_back(column);
+    }
+
+    out << line;
+    for (int endUse = 0; endUse < END_USE_COUNT; endUse++) {
+      out << "," << endUseName(endUse);
+    }
+    out << ",eui,euiRmse\n" << std::setprecision(10);
+    double euiRmse = surrogate.validation().empty() ? std::nan("") : surrogate.validation().back().rmse;
+    std::vector<double> parameters(columns.size());
+    double endUses[END_USE_COUNT];
+    for (int row = 2; std::getline(in, line); row++) {
+      if (boost::trim_copy(line).empty()) {
+        continue;
+      }
+      std::vector<std::string> cells;
+      boost::split(cells, line, boost::is_any_of(","));
+      for (size_t p = 0; p < columns.size(); p++) {
+        try {
+          parameters[p] = std::stod(columns[p] < cells.size() ? cells[columns[p]] : std::string());
+        } catch (std::exception&) {
+          throw std::invalid_argument("Row " + std::to_string(row) + " has no value of " + surrogate.parameterNames()[p] + ".");
+        }
+      }
+      surrogate.evaluate(parameters.data(), endUses);
+      double eui = 0;
+      out << line;
+      for (double value : endUses) {
+        out << "," << value;
+        eui += value;
+      }
+      out << "," << eui << "," << euiRmse << "\n";
+    }
+  } catch (std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
   }
+  return 0;
+}
+
+int runBatch(const std::string& manifestFile, const std::string& shardText, const std::vector<std::string>& partialFiles,
+             const std::string& columnarFile, unsigned threadCount)
+{
+  try {
+    if (!partialFiles.empty()) {
+      BatchSummary summary = mergeBatchPartials(partialFiles, std::cout);
+      std::cerr << "Merged " << summary.shards << " shards of " << summary.buildings << " buildings, longest shard "
+                << summary.maxShardSeconds << " s of " << summary.totalSeconds << " s." << std::endl;
+      return 0;
+    }
+
+    BatchManifest manifest = BatchManifest::load(manifestFile);
+    ShardId shard = shardText.empty() ? ShardId() : ShardId::parse(shardText);
+    Batch batch(manifest, threadCount);
+    ThreadPool pool(threadCount);
+    if (!columnarFile.empty()) {
+      ResultFileOptions options;
+      options.metadata["fingerprint"] = manifest.fingerprint();
+      options.metadata["shard"] = shard.toString();
+      std::string outputFile = columnarFile;
+      if (shard.count > 1) {
+        outputFile += ".shard-" + std::to_string(shard.index) + "-of-" + std::to_string(shard.count);
+      }
+      ResultFileWriter writer(outputFile, 8760, options);
+      size_t buildings = batch.run(pool, shard, writer);
+      writer.close();
+      std::cerr << "Shard " << shard.toString() << ": " << buildings << " of " << batch.size() << " buildings." << std::endl;
+      return 0;
+    }
+    std::ofstream file;
+    if (!manifest.outputFile.empty()) {
+      std::string outputFile = manifest.outputFile;
+      if (shard.count > 1) {
+        outputFile += ".shard-" + std::to_string(shard.index) + "-of-" + std::to_string(shard.count);
+      }
+      file.open(outputFile.c_str());
+      if (!file) {
+        throw std::invalid_argument("Cannot write " + outputFile + ".");
+      }
+    }
+    size_t buildings = batch.run(pool, shard, file.is_open() ? file : std::cout);
+    std::cerr << "Shard " << shard.toString() << ": " << buildings << " of " << batch.size() << " buildings." << std::endl;
+  } catch (std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
 }
 
 int main(int argc, char* argv[])
@@ -130,12 +356,35 @@ int main(int argc, char* argv[])
   namespace po = boost::program_options; 
   po::options_description desc("Options"); 
   desc.add_options()
-    ("ismfilepath,i", po::value<std::string>()->required(), "Path to ism file.")
+    ("ismfilepath,i", po::value<std::string>(), "Path to ism file.")
     ("defaultsfilepath,d", "Path to defaults ism file.")
     ("monthly,m", "Run the monthly simulation (default).")
     ("hourlyByMonth,h", "Run the hourly simulation (results aggregated by month.")
     ("hourlyByHour,H", "Run the hourly simulation (results for each hour).")
-    ("compare,c", po::value<std::string>(), "Run the monthly and hourly simulations and compare the results. Use 'md' for markdown and 'csv' for csv.");
+    ("output,o", po::value<std::string>(), "With --monthly, --hourlyByMonth, --hourlyByHour, --compare or --convert, write the results to the given file instead of stdout.")
+    ("precision,p", po::value<int>(), "With --monthly, --hourlyByMonth, --hourlyByHour, --compare or --convert, write the results with the given number of significant digits (1 to 17) instead of the shortest digits that read back exactly.")
+    ("compare,c", po::value<std::string>(), "Run the monthly and hourly simulations and compare the results. Use 'md' for markdown and 'csv' for csv.")
+    ("sweep,s", po::value<std::string>(), "Run the parametric sweep described by the given spec file and write its results as CSV.")
+    ("montecarlo,u", po::value<std::string>(), "Run a Monte Carlo analysis of the parameters of the given sweep spec file and write the statistics of the results as CSV.")
+    ("sensitivity,a", po::value<std::string>(), "Run a Morris or Saltelli sensitivity analysis of the parameters of the given sweep spec file and write the indices as CSV.")
+    ("optimize", po::value<std::string>(), "Optimize the parameters of the given sweep spec file with NSGA-II or CMA-ES and write the Pareto front as CSV.")
+    ("calibrate", po::value<std::string>(), "Calibrate the parameters of the given sweep spec file to its metered data and report the ASHRAE Guideline 14 fit.")
+    ("surrogate", po::value<std::string>(), "Train a polynomial chaos surrogate of the annual end uses on the runs of the given sweep spec file, save it to the spec's surrogate file and report its held-out validation errors.")
+    ("predict", po::value<std::string>(), "Evaluate the given surrogate file for the parameter values in the CSV rows read from stdin (a header row names the parameters) and write the predicted annual end uses and EUI as CSV.")
+    ("batch", po::value<std::string>(), "Simulate the portfolios of the given batch manifest and write the results as CSV.")
+    ("shard", po::value<std::string>(), "With --batch, simulate only shard i/N of the buildings and write a partial result file for --merge.")
+    ("merge", po::value<std::vector<std::string> >()->multitoken(), "Merge the partial result files of every shard of a batch into one result file.")
+    ("columnar", po::value<std::string>(), "With --batch, simulate every building with the hourly method and write its hour by hour results to the given compressed binary result file instead of the monthly CSV results. With --sweep, write the monthly results of every run, with its parameter values, to the given binary result file instead of the CSV.")
+    ("convert", po::value<std::string>(), "Write the results of the given binary result file as CSV, to stdout or --output, with --precision.")
+    ("bill", po::value<std::string>(), "Write the monthly utility cost and emissions of every building of the given hourly binary result file (see --columnar) by end use as CSV, to stdout or --output, with --precision.")
+    ("tariff", po::value<std::string>(), "With --bill, the electricity tariff file: time of use periods, tiered energy rates, demand and fixed charges.")
+    ("gasTariff", po::value<std::string>(), "With --bill, the gas tariff file.")
+    ("emissions", po::value<std::string>(), "With --bill, a CSV file of 8760 hourly emission factors per kWh in columns named electricity and gas.")
+    ("pipeline", po::value<std::string>(), "Simulate the buildings of the given list (one .ism file and optional defaults file per line) through a staged pipeline, write the monthly results as CSV and report the utilization of each stage. Uses the hourly method with --hourlyByMonth.")
+    ("daemon", "Answer JSON lines simulation requests from stdin on stdout, keeping models and weather in memory, until the end of input or a shutdown command.")
+    ("socket", po::value<std::string>(), "With --daemon, answer requests on the Unix domain socket at the given path instead of stdin.")
+    ("cache", po::value<std::string>(), "With --daemon or a spec analysis, keep simulation results in the given directory and reuse those of identical inputs, also across runs.")
+    ("threads", po::value<unsigned>(), "With --daemon, --batch, --bill or --pipeline, the number of simulation threads (default: one per hardware thread).");
 
   po::positional_options_description positionalOptions; 
   positionalOptions.add("ismfilepath", 1); 
@@ -160,6 +409,111 @@ int main(int argc, char* argv[])
     return 1; 
   } 
 
+  const char* specOptions[] = { "sweep", "montecarlo", "sensitivity", "optimize", "calibrate", "surrogate" };
+  for (int analysis = SWEEP; analysis <= SURROGATE; analysis++) {
+    if (!vm.count(specOptions[analysis])) {
+      continue;
+    }
+    return runSpec(vm[specOptions[analysis]].as<std::string>(), (SpecAnalysis) analysis,
+                   vm.count("ismfilepath") ? vm["ismfilepath"].as<std::string>() : std::string(),
+                   vm.count("defaultsfilepath") ? vm["defaultsfilepath"].as<std::string>() : std::string(),
+                   vm.count("cache") ? vm["cache"].as<std::string>() : std::string(),
+                   vm.count("columnar") ? vm["columnar"].as<std::string>() : std::string());
+  }
+
+  if (vm.count("predict")) {
+    return runPredict(vm["predict"].as<std::string>(), std::cin, std::cout);
+  }
+
+  if (vm.count("batch") || vm.count("merge")) {
+    return runBatch(vm.count("batch") ? vm["batch"].as<std::string>() : std::string(),
+                    vm.count("shard") ? vm["shard"].as<std::string>() : std::string(),
+                    vm.count("merge") ? vm["merge"].as<std::vector<std::string> >() : std::vector<std::string>(),
+                    vm.count("columnar") ? vm["columnar"].as<std::string>() : std::string(),
+                    vm.count("threads") ? vm["threads"].as<unsigned>() : 0);
+  }
+
+  if (vm.count("convert")) {
+    try {
+      ResultFileReader reader(vm["convert"].as<std::string>());
+      int precision = vm.count("precision") ? vm["precision"].as<int>() : CsvWriter::SHORTEST;
+      std::unique_ptr<CsvWriter> writer(vm.count("output") ? new CsvWriter(vm["output"].as<std::string>(), precision)
+                                                           : new CsvWriter(std::cout, precision));
+      reader.writeCsv(*writer);
+      writer->flush();
+    } catch (std::invalid_argument& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (vm.count("bill")) {
+    try {
+      UtilityAccounting accounting(vm.count("tariff") ? Tariff::load(vm["tariff"].as<std::string>()) : Tariff(),
+                                   vm.count("gasTariff") ? Tariff::load(vm["gasTariff"].as<std::string>()) : Tariff(),
+                                   vm.count("emissions") ? EmissionFactors::load(vm["emissions"].as<std::string>()) : EmissionFactors());
+      ResultFileReader reader(vm["bill"].as<std::string>());
+      ThreadPool pool(vm.count("threads") ? vm["threads"].as<unsigned>() : 0);
+      std::vector<UtilityBill> bills = accounting.evaluate(reader, pool);
+      std::vector<std::string> ids;
+      for (size_t i = 0; i < reader.size(); i++) {
+        ids.push_back(reader.building(i).id);
+      }
+      int precision = vm.count("precision") ? vm["precision"].as<int>() : CsvWriter::SHORTEST;
+      std::unique_ptr<CsvWriter> writer(vm.count("output") ? new CsvWriter(vm["output"].as<std::string>(), precision)
+                                                           : new CsvWriter(std::cout, precision));
+      writeBills(*writer, ids, bills);
+      writer->flush();
+    } catch (std::invalid_argument& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (vm.count("pipeline")) {
+    try {
+      PipelineOptions options;
+      options.simulators = vm.count("threads") ? vm["threads"].as<unsigned>() : 0;
+      options.engine = vm.count("hourlyByMonth") ? HOURLY_ENGINE : MONTHLY_ENGINE;
+      PipelineReport report = BuildingPipeline(options).run(PipelineJob::loadList(vm["pipeline"].as<std::string>()), std::cout);
+      for (const auto& error : report.errors) {
+        std::cerr << "ERROR: " << error << std::endl;
+      }
+      report.write(std::cerr);
+      return report.errors.empty() ? 0 : 1;
+    } catch (std::invalid_argument& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  if (vm.count("daemon")) {
+    SimulationServer server(vm.count("threads") ? vm["threads"].as<unsigned>() : 0);
+    try {
+      // Duplicate requests are answered from memory, and from the store if one is given.
+      server.setResultCache(std::make_shared<ResultCache>(ResultCache::DEFAULT_CAPACITY,
+                                                          vm.count("cache") ? vm["cache"].as<std::string>() : std::string()));
+      if (vm.count("socket")) {
+        server.serveSocket(vm["socket"].as<std::string>());
+      } else {
+        server.serve(std::cin, std::cout);
+      }
+    } catch (std::invalid_argument& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+    }
+    std::cerr << server.statistics() << std::endl;
+    return 0;
+  }
+
+  if (!vm.count("ismfilepath")) {
+    std::cerr << "ERROR: the option '--ismfilepath' is required but missing" << std::endl << std::endl;
+    std::cerr << desc << std::endl;
+    return 1;
+  }
+
   if (DEBUG_ISO_MODEL_SIMULATION) {
     std::cout << "Loading User Model..." << std::endl;
   }
@@ -196,38 +550,46 @@ int main(int argc, char* argv[])
     std::cout << std::endl;
   }
 
-  bool simulationRan = false;
-
-  if (vm.count("compare")) {
-    if (vm["compare"].as<std::string>() == "md") {
-      compare(umodel, true);
-    } else if (vm["compare"].as<std::string>() == "csv") {
-      compare(umodel, false);
-    } else {
-      std::cout << "No output type given for compare. Please use 'md' or 'csv'.\n";
+  try {
+    int precision = vm.count("precision") ? vm["precision"].as<int>() : CsvWriter::SHORTEST;
+    std::unique_ptr<CsvWriter> writer(vm.count("output") ? new CsvWriter(vm["output"].as<std::string>(), precision)
+                                                         : new CsvWriter(std::cout, precision));
+    CsvWriter& out = *writer;
+    bool simulationRan = false;
+
+    if (vm.count("compare")) {
+      if (vm["compare"].as<std::string>() == "md") {
+        compare(umodel, out, true);
+      } else if (vm["compare"].as<std::string>() == "csv") {
+        compare(umodel, out, false);
+      } else {
+        out.write("No output type given for compare. Please use 'md' or 'csv'.\n");
+      }
+      simulationRan = true;
+    }
+    if (vm.count("monthly")) {
+      runMonthlySimulation(umodel, out);
+      simulationRan = true;
     }
-    simulationRan = true;
-  }
-  if (vm.count("monthly")) {
-    runMonthlySimulation(umodel);
-    simulationRan = true;
-  }
 
-  if (vm.count("hourlyByMonth")) {
-    runHourlySimulation(umodel, true);
-    simulationRan = true;
-  }
+    if (vm.count("hourlyByMonth")) {
+      runHourlySimulation(umodel, true, out);
+      simulationRan = true;
+    }
 
-  if (vm.count("hourlyByHour")) {
-    runHourlySimulation(umodel, false);
-    simulationRan = true;
-  }
+    if (vm.count("hourlyByHour")) {
+      runHourlySimulation(umodel, false, out);
+      simulationRan = true;
+    }
 
-  if (!simulationRan) {
-    // Monthly simulation is default and will run if no other simulations did.
-    runMonthlySimulation(umodel);
+    if (!simulationRan) {
+      // Monthly simulation is default and will run if no other simulations did.
+      runMonthlySimulation(umodel, out);
+    }
+    out.flush();
+  } catch (std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
   }
 
 }
-
-